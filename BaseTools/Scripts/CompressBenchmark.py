@@ -0,0 +1,99 @@
+## @file
+#  Time the LZMA compression of a firmware volume with different thread counts.
+#
+#  The input should be a representative uncompressed FV, for example the
+#  DXE FV from Build/<Platform>/<Target>_<Tool>/FV/DXEFV.Fv. Every encoder
+#  configuration is checked to produce the same bytes as the single threaded
+#  encoder and to decode back to the input.
+#
+#  Copyright (c) Microsoft Corporation.
+#
+#  SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+VersionNumber = '0.1'
+import os
+import sys
+import time
+import shutil
+import filecmp
+import argparse
+import tempfile
+import subprocess
+
+def FindTool(Name, Path):
+    if Path:
+        return Path
+    Tool = shutil.which(Name)
+    if Tool is None:
+        print('ERROR: %s not found in PATH, use --tool to specify it' % Name)
+        sys.exit(1)
+    return Tool
+
+def RunTool(Tool, Arguments):
+    Start = time.perf_counter()
+    subprocess.run([Tool, '-q'] + Arguments, check=True, stdout=subprocess.DEVNULL)
+    return time.perf_counter() - Start
+
+def Main():
+    PARSER = argparse.ArgumentParser(
+        description='Benchmarks LzmaCompress on a firmware volume - Version ' + VersionNumber)
+    PARSER.add_argument('InputFile',
+                        help='Uncompressed firmware volume to compress')
+    PARSER.add_argument('--tool',
+                        default=None,
+                        help='Path of the LzmaCompress executable. [Default: search PATH]')
+    PARSER.add_argument('--threads',
+                        type=int,
+                        nargs='+',
+                        default=[1, 2],
+                        help='Thread counts to benchmark. [Default: 1 2]')
+    PARSER.add_argument('--iterations',
+                        type=int,
+                        default=3,
+                        help='Runs per configuration, the fastest is reported. [Default: 3]')
+    PARSER.add_argument('--f86',
+                        action='store_true',
+                        help='Enable the x86 converter, as for LzmaF86Compress sections')
+
+    ARGS = PARSER.parse_args()
+    Tool = FindTool('LzmaCompress', ARGS.tool)
+    InputSize = os.path.getsize(ARGS.InputFile)
+    Options = ['--f86'] if ARGS.f86 else []
+
+    print('Input: %s (%d bytes)' % (ARGS.InputFile, InputSize))
+    print('%8s %10s %12s %8s %8s' % ('Threads', 'Seconds', 'Output', 'Ratio', 'Speedup'))
+
+    TempDir = tempfile.mkdtemp()
+    try:
+        Reference = None
+        Baseline = None
+        for Threads in ARGS.threads:
+            Output = os.path.join(TempDir, 'threads%d.lzma' % Threads)
+            Best = None
+            for Iteration in range(ARGS.iterations):
+                Elapsed = RunTool(Tool, ['-e', '--threads', str(Threads), '-o', Output, ARGS.InputFile] + Options)
+                if Best is None or Elapsed < Best:
+                    Best = Elapsed
+
+            if Reference is None:
+                Reference = Output
+                Baseline = Best
+            elif not filecmp.cmp(Reference, Output, shallow=False):
+                print('ERROR: output with %d threads differs from %d thread(s)' % (Threads, ARGS.threads[0]))
+                sys.exit(1)
+
+            Decoded = os.path.join(TempDir, 'decoded.bin')
+            RunTool(Tool, ['-d', '-o', Decoded, Output] + Options)
+            if not filecmp.cmp(ARGS.InputFile, Decoded, shallow=False):
+                print('ERROR: output with %d threads does not decode to the input' % Threads)
+                sys.exit(1)
+
+            OutputSize = os.path.getsize(Output)
+            print('%8d %10.2f %12d %7.1f%% %7.2fx' % (Threads, Best, OutputSize,
+                  100.0 * OutputSize / InputSize, Baseline / Best))
+    finally:
+        shutil.rmtree(TempDir)
+
+if __name__ == '__main__':
+    Main()
@@ -65,6 +65,11 @@ void PrintHelp(char *buffer)
              "  --debug [0-9]: set debug level\n"
              "  -a: set compression mode 0 = fast, 1 = normal, default: 1 (normal)\n"
              "  d: sets Dictionary size - [0, 27], default: 24 (16MB)\n"
+             // MU_CHANGE [BEGIN] - Multithreaded LZMA compression
+             "  --threads N: number of encoder threads, default: 1\n"
+             "               N > 1 runs the match finder on its own threads;\n"
+             "               the output is identical to the single threaded one\n"
+             // MU_CHANGE [END] - Multithreaded LZMA compression
              "  --version: display the program version and exit\n"
              "  -h, --help: display this help text\n"
              );
@@ -250,9 +255,18 @@ int main2(int numArgs, const char *args[], char *rs)
   int param;
   UInt64 fileSize;
   CLzmaEncProps props;
+  UINT64 numThreads; // MU_CHANGE - Multithreaded LZMA compression
 
   LzmaEncProps_Init(&props);
   LzmaEncProps_Normalize(&props);
+  // MU_CHANGE [BEGIN] - Multithreaded LZMA compression
+  //
+  // LzmaEncProps_Normalize () picks two threads when the SDK is built with
+  // multithreading. Keep the single threaded encoder unless --threads asks
+  // for more.
+  //
+  props.numThreads = 1;
+  // MU_CHANGE [END] - Multithreaded LZMA compression
 
   FileSeqInStream_CreateVTable(&inStream);
   File_Construct(&inStream.file);
@@ -309,6 +323,23 @@ int main2(int numArgs, const char *args[], char *rs)
       } else {
         return PrintError(rs, kInvalidParamValMessage);
       }
+    // MU_CHANGE [BEGIN] - Multithreaded LZMA compression
+    } else if (strcmp(args[param], "--threads") == 0) {
+      if (numArgs < (param + 2)) {
+        return PrintUserError(rs);
+      }
+      if ((AsciiStringToUint64(args[param + 1], FALSE, &numThreads) != EFI_SUCCESS) ||
+          (numThreads == 0)) {
+        return PrintError(rs, kInvalidParamValMessage);
+      }
+      //
+      // The LZMA encoder splits its work across at most two threads: the
+      // binary tree match finder and the hash precomputation. Extra threads
+      // are accepted and clamped so build scripts can pass the host CPU count.
+      //
+      props.numThreads = (numThreads > 1) ? 2 : 1;
+      param++;
+    // MU_CHANGE [END] - Multithreaded LZMA compression
     } else if (
                 strcmp(args[param], "-h") == 0 ||
                 strcmp(args[param], "--help") == 0
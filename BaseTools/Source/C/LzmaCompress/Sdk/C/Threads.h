@@ -12,6 +12,10 @@
 
 EXTERN_C_BEGIN
 
+// MU_CHANGE [BEGIN] - Multithreaded LZMA compression on POSIX hosts
+#ifdef _WIN32
+
+// MU_CHANGE [END] - Multithreaded LZMA compression on POSIX hosts
 WRes HandlePtr_Close(HANDLE *h);
 WRes Handle_WaitObject(HANDLE h);
 
@@ -63,6 +67,79 @@ WRes CriticalSection_Init(CCriticalSection *p);
 #define CriticalSection_Enter(p) EnterCriticalSection(p)
 #define CriticalSection_Leave(p) LeaveCriticalSection(p)
 
+// MU_CHANGE [BEGIN] - Multithreaded LZMA compression on POSIX hosts
+#else
+
+/* POSIX threads version of the same interface */
+
+#include <pthread.h>
+
+typedef struct _CThread
+{
+  int _created;
+  pthread_t _tid;
+} CThread;
+
+#define Thread_Construct(p) (p)->_created = 0
+#define Thread_WasCreated(p) ((p)->_created != 0)
+WRes Thread_Close(CThread *p);
+WRes Thread_Wait(CThread *p);
+
+typedef void * THREAD_FUNC_RET_TYPE;
+
+#define THREAD_FUNC_CALL_TYPE
+#define THREAD_FUNC_DECL THREAD_FUNC_RET_TYPE THREAD_FUNC_CALL_TYPE
+typedef THREAD_FUNC_RET_TYPE (THREAD_FUNC_CALL_TYPE * THREAD_FUNC_TYPE)(void *);
+WRes Thread_Create(CThread *p, THREAD_FUNC_TYPE func, void *param);
+
+typedef struct _CEvent
+{
+  int _created;
+  int _manual_reset;
+  int _state;
+  pthread_mutex_t _mutex;
+  pthread_cond_t _cond;
+} CEvent;
+
+typedef CEvent CAutoResetEvent;
+typedef CEvent CManualResetEvent;
+#define Event_Construct(p) (p)->_created = 0
+#define Event_IsCreated(p) ((p)->_created != 0)
+WRes Event_Close(CEvent *p);
+WRes Event_Wait(CEvent *p);
+WRes Event_Set(CEvent *p);
+WRes Event_Reset(CEvent *p);
+WRes ManualResetEvent_Create(CManualResetEvent *p, int signaled);
+WRes ManualResetEvent_CreateNotSignaled(CManualResetEvent *p);
+WRes AutoResetEvent_Create(CAutoResetEvent *p, int signaled);
+WRes AutoResetEvent_CreateNotSignaled(CAutoResetEvent *p);
+
+typedef struct _CSemaphore
+{
+  int _created;
+  UInt32 _count;
+  UInt32 _maxCount;
+  pthread_mutex_t _mutex;
+  pthread_cond_t _cond;
+} CSemaphore;
+
+#define Semaphore_Construct(p) (p)->_created = 0
+#define Semaphore_IsCreated(p) ((p)->_created != 0)
+WRes Semaphore_Close(CSemaphore *p);
+WRes Semaphore_Wait(CSemaphore *p);
+WRes Semaphore_Create(CSemaphore *p, UInt32 initCount, UInt32 maxCount);
+WRes Semaphore_ReleaseN(CSemaphore *p, UInt32 num);
+WRes Semaphore_Release1(CSemaphore *p);
+
+typedef pthread_mutex_t CCriticalSection;
+WRes CriticalSection_Init(CCriticalSection *p);
+#define CriticalSection_Delete(p) pthread_mutex_destroy(p)
+#define CriticalSection_Enter(p) pthread_mutex_lock(p)
+#define CriticalSection_Leave(p) pthread_mutex_unlock(p)
+
+#endif
+// MU_CHANGE [END] - Multithreaded LZMA compression on POSIX hosts
+
 EXTERN_C_END
 
 #endif
@@ -20,7 +20,8 @@ from Common import GlobalData
 from Common import EdkLogger
 import Common.LongFilePathOs as os
 
-DATABASE_VERSION = 7
+# MU_CHANGE - Version 8 sorts the ExMapTable by ExGuidIndex then ExTokenNumber.
+DATABASE_VERSION = 8
 
 gPcdDatabaseAutoGenC = TemplateString("""
 //
@@ -1504,6 +1505,20 @@ def CreatePcdDatabasePhaseSpecificAutoGen (Platform, DynamicPcdList, Phase):
             Dict['EXMAPPING_TABLE_LOCAL_TOKEN'].append(str(GeneratedTokenNumber + 1) + 'U')
             Dict['EXMAPPING_TABLE_GUID_INDEX'].append(str(GuidList.index(TokenSpaceGuid)) + 'U')
 
+    # MU_CHANGE [BEGIN] - Sorted ExMap lookup
+    #
+    # The PCD drivers look DynamicEx tokens up with a binary search, so the
+    # ExMapTable is sorted by ExGuidIndex, then by ExTokenNumber.
+    #
+    ExMapping = sorted(
+                  zip(Dict['EXMAPPING_TABLE_EXTOKEN'], Dict['EXMAPPING_TABLE_LOCAL_TOKEN'], Dict['EXMAPPING_TABLE_GUID_INDEX']),
+                  key=lambda Item: (GetIntegerValue(Item[2]), GetIntegerValue(Item[0]))
+                  )
+    Dict['EXMAPPING_TABLE_EXTOKEN'] = [Item[0] for Item in ExMapping]
+    Dict['EXMAPPING_TABLE_LOCAL_TOKEN'] = [Item[1] for Item in ExMapping]
+    Dict['EXMAPPING_TABLE_GUID_INDEX'] = [Item[2] for Item in ExMapping]
+    # MU_CHANGE [END] - Sorted ExMap lookup
+
     if Platform.Platform.PcdInfoFlag:
         for index in range(len(Dict['PCD_TOKENSPACE_MAP'])):
             TokenSpaceIndex = StringTableSize
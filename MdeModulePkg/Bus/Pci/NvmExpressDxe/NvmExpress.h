@@ -801,4 +801,65 @@ NvmeUnregisterShutdownNotification (
   VOID
   );
 
+// MU_CHANGE [BEGIN] - Pipelined NVMe I/O
+
+/**
+  Call back function when the timer event is signaled.
+
+  @param[in]  Event     The Event this notify function registered to.
+  @param[in]  Context   Pointer to the context data registered to the
+                        Event.
+
+**/
+VOID
+EFIAPI
+ProcessAsyncTaskList (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  );
+
+/**
+  Aborts the asynchronous PassThru requests.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+
+  @retval EFI_SUCCESS       The asynchronous PassThru requests have been aborted.
+  @return EFI_DEVICE_ERROR  Fail to abort all the asynchronous PassThru requests.
+
+**/
+EFI_STATUS
+AbortAsyncPassThruTasks (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  );
+
+/**
+  Read or write some blocks from the device, with all the chunks of the
+  transfer in flight at once.
+
+  @param  Device                 The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+  @param  Buffer                 The buffer used to store the data read from the device,
+                                 or to be written into the device.
+  @param  Lba                    The start block number.
+  @param  Blocks                 Total block number to be transferred.
+  @param  MaxTransferBlocks      The maximum block number of one command.
+  @param  IsWrite                TRUE to write to the device, FALSE to read from it.
+
+  @retval EFI_SUCCESS            Datum are transferred.
+  @retval EFI_OUT_OF_RESOURCES   The transfer could not be started.
+  @retval Others                 Fail to transfer all the datum.
+
+**/
+EFI_STATUS
+NvmePipelinedReadWrite (
+  IN NVME_DEVICE_PRIVATE_DATA  *Device,
+  IN VOID                      *Buffer,
+  IN UINT64                    Lba,
+  IN UINTN                     Blocks,
+  IN UINT32                    MaxTransferBlocks,
+  IN BOOLEAN                   IsWrite
+  );
+
+// MU_CHANGE [END]
+
 #endif
@@ -195,6 +195,20 @@ NvmeRead (
     MaxTransferBlocks = 1024;
   }
 
+  // MU_CHANGE [BEGIN] - Pipelined NVMe I/O
+  //
+  // Submit all the chunks of a large read at once, and fall back to reading
+  // one chunk after the other if the pipelined read cannot be started.
+  //
+  if (PcdGetBool (PcdNvmePipelinedIo) && (Blocks > MaxTransferBlocks)) {
+    Status = NvmePipelinedReadWrite (Device, Buffer, Lba, Blocks, MaxTransferBlocks, FALSE);
+    if (Status != EFI_OUT_OF_RESOURCES) {
+      Blocks = 0;
+    }
+  }
+
+  // MU_CHANGE [END]
+
   while (Blocks > 0) {
     if (Blocks > MaxTransferBlocks) {
       Status = ReadSectors (Device, (UINT64)(UINTN)Buffer, Lba, MaxTransferBlocks);
@@ -281,6 +295,20 @@ NvmeWrite (
     MaxTransferBlocks = 1024;
   }
 
+  // MU_CHANGE [BEGIN] - Pipelined NVMe I/O
+  //
+  // Submit all the chunks of a large write at once, and fall back to writing
+  // one chunk after the other if the pipelined write cannot be started.
+  //
+  if (PcdGetBool (PcdNvmePipelinedIo) && (Blocks > MaxTransferBlocks)) {
+    Status = NvmePipelinedReadWrite (Device, Buffer, Lba, Blocks, MaxTransferBlocks, TRUE);
+    if (Status != EFI_OUT_OF_RESOURCES) {
+      Blocks = 0;
+    }
+  }
+
+  // MU_CHANGE [END]
+
   while (Blocks > 0) {
     if (Blocks > MaxTransferBlocks) {
       Status = WriteSectors (Device, (UINT64)(UINTN)Buffer, Lba, MaxTransferBlocks);
@@ -956,6 +984,154 @@ NvmeAsyncWrite (
   return Status;
 }
 
+// MU_CHANGE [BEGIN] - Pipelined NVMe I/O
+
+/**
+  Read or write some blocks from the device, with all the chunks of the
+  transfer in flight at once.
+
+  The transfer is split in chunks of MaxTransferBlocks blocks which are queued
+  as the subtasks of an internal BlockIo2 request on the asynchronous I/O
+  queue, so up to the depth of that queue commands are outstanding on the
+  controller instead of the single command of the synchronous I/O queue. The
+  completion queue is then polled until the completion queue entry of the last
+  outstanding chunk arrives.
+
+  @param  Device                 The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+  @param  Buffer                 The buffer used to store the data read from the device,
+                                 or to be written into the device.
+  @param  Lba                    The start block number.
+  @param  Blocks                 Total block number to be transferred.
+  @param  MaxTransferBlocks      The maximum block number of one command.
+  @param  IsWrite                TRUE to write to the device, FALSE to read from it.
+
+  @retval EFI_SUCCESS            Datum are transferred.
+  @retval EFI_OUT_OF_RESOURCES   The transfer could not be started.
+  @retval EFI_TIMEOUT            The transfer did not complete in time and the
+                                 controller was reset.
+  @retval Others                 Fail to transfer all the datum.
+
+**/
+EFI_STATUS
+NvmePipelinedReadWrite (
+  IN NVME_DEVICE_PRIVATE_DATA  *Device,
+  IN VOID                      *Buffer,
+  IN UINT64                    Lba,
+  IN UINTN                     Blocks,
+  IN UINT32                    MaxTransferBlocks,
+  IN BOOLEAN                   IsWrite
+  )
+{
+  NVME_CONTROLLER_PRIVATE_DATA  *Private;
+  EFI_BLOCK_IO2_TOKEN           *Token;
+  EFI_EVENT                     TimerEvent;
+  UINTN                         Chunks;
+  EFI_TPL                       OldTpl;
+  EFI_STATUS                    Status;
+
+  Private    = Device->Controller;
+  TimerEvent = NULL;
+  Chunks     = (Blocks + MaxTransferBlocks - 1) / MaxTransferBlocks;
+
+  //
+  // The token is referenced by the request until its last subtask completes,
+  // so it is not allocated on the stack.
+  //
+  Token = AllocateZeroPool (sizeof (EFI_BLOCK_IO2_TOKEN));
+  if (Token == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = gBS->CreateEvent (0, TPL_CALLBACK, NULL, NULL, &Token->Event);
+  if (EFI_ERROR (Status)) {
+    FreePool (Token);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = gBS->CreateEvent (EVT_TIMER, TPL_CALLBACK, NULL, NULL, &TimerEvent);
+  if (!EFI_ERROR (Status)) {
+    Status = gBS->SetTimer (TimerEvent, TimerRelative, MultU64x64 (NVME_GENERIC_TIMEOUT, Chunks));
+  }
+
+  if (EFI_ERROR (Status)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+
+  Token->TransactionStatus = EFI_SUCCESS;
+  if (IsWrite) {
+    Status = NvmeAsyncWrite (Device, Buffer, Lba, Blocks, Token);
+  } else {
+    Status = NvmeAsyncRead (Device, Buffer, Lba, Blocks, Token);
+  }
+
+  if (EFI_ERROR (Status)) {
+    //
+    // Nothing was queued, let the caller transfer the chunks one by one.
+    //
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+
+  //
+  // Poll the completion queue rather than waiting for the asynchronous timer,
+  // this also submits the remaining chunks as soon as there is room in the
+  // submission queue.
+  //
+  while (EFI_ERROR (gBS->CheckEvent (Token->Event))) {
+    if (!EFI_ERROR (gBS->CheckEvent (TimerEvent))) {
+      DEBUG ((DEBUG_ERROR, "%a: Timeout occurs for a pipelined transfer.\n", __func__));
+      ReportStatusCode ((EFI_ERROR_MAJOR | EFI_ERROR_CODE), (EFI_IO_BUS_SCSI | EFI_IOB_EC_INTERFACE_ERROR));
+
+      OldTpl                   = gBS->RaiseTPL (TPL_NOTIFY);
+      Token->TransactionStatus = EFI_TIMEOUT;
+      gBS->RestoreTPL (OldTpl);
+
+      //
+      // Reset the controller and abort the outstanding commands, as done on a
+      // timeout of a blocking PassThru command. Aborting the subtasks signals
+      // the token once the last of them is released.
+      //
+      gBS->SetTimer (Private->TimerEvent, TimerCancel, 0);
+      Status = NvmeControllerInit (Private);
+      if (!EFI_ERROR (Status)) {
+        Status = AbortAsyncPassThruTasks (Private);
+      }
+
+      gBS->SetTimer (Private->TimerEvent, TimerPeriodic, NVME_HC_ASYNC_TIMER);
+      if (EFI_ERROR (Status) || EFI_ERROR (gBS->CheckEvent (Token->Event))) {
+        //
+        // The request may still reference the token, leak it rather than
+        // freeing memory in use.
+        //
+        gBS->CloseEvent (TimerEvent);
+        return EFI_DEVICE_ERROR;
+      }
+
+      Status = EFI_TIMEOUT;
+      goto Exit;
+    }
+
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    ProcessAsyncTaskList (NULL, Private);
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  Status = Token->TransactionStatus;
+
+Exit:
+  if (TimerEvent != NULL) {
+    gBS->CloseEvent (TimerEvent);
+  }
+
+  gBS->CloseEvent (Token->Event);
+  FreePool (Token);
+
+  return Status;
+}
+
+// MU_CHANGE [END]
+
 /**
   Reset the Block Device.
 
@@ -0,0 +1,1138 @@
+/** @file -- NvmePipelinedIoUnitTest.c
+  Host based unit tests for the pipelined BlockIo transfers of the NVMe driver.
+
+  The driver runs against a mock controller which fetches commands when the
+  submission queue tail doorbell is rung, serves up to MOCK_NVME_CHANNELS of
+  them at once and posts each completion queue entry MOCK_NVME_LATENCY polls
+  later. A poll is one check of a timer event, which is how the driver waits
+  for the controller. The mock records the number of commands in flight and the
+  bytes transferred per poll.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UnitTestLib.h>
+#include <Protocol/BlockIo.h>
+#include <Protocol/NvmExpressPassthru.h>
+
+#include "../NvmExpress.h"
+
+#define UNIT_TEST_APP_NAME     "NVMe Pipelined I/O Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+//
+// Mock controller parameters. With a block size of 512 bytes and a memory page
+// size of 4kB, a maximum data transfer size of 2^3 pages is 64 blocks.
+//
+#define MOCK_NVME_BLOCK_SIZE     512
+#define MOCK_NVME_DISK_BLOCKS    0x4000
+#define MOCK_NVME_MDTS           3
+#define MOCK_NVME_CHUNK_BLOCKS   64
+#define MOCK_NVME_LATENCY        8
+#define MOCK_NVME_CHANNELS       16
+#define MOCK_NVME_MAX_IN_FLIGHT  128
+
+//
+// Transfer used by the tests, 64 chunks so one more than the depth of the
+// asynchronous submission queue.
+//
+#define TEST_TRANSFER_BLOCKS  (64 * MOCK_NVME_CHUNK_BLOCKS)
+#define TEST_TRANSFER_LBA     0x100
+
+//
+// Functions of NvmExpressBlockIo.c under test.
+//
+EFI_STATUS
+NvmeRead (
+  IN     NVME_DEVICE_PRIVATE_DATA  *Device,
+  OUT VOID                         *Buffer,
+  IN     UINT64                    Lba,
+  IN     UINTN                     Blocks
+  );
+
+EFI_STATUS
+NvmeWrite (
+  IN NVME_DEVICE_PRIVATE_DATA  *Device,
+  IN VOID                      *Buffer,
+  IN UINT64                    Lba,
+  IN UINTN                     Blocks
+  );
+
+EFI_STATUS
+NvmeAsyncRead (
+  IN     NVME_DEVICE_PRIVATE_DATA  *Device,
+  OUT VOID                         *Buffer,
+  IN     UINT64                    Lba,
+  IN     UINTN                     Blocks,
+  IN     EFI_BLOCK_IO2_TOKEN       *Token
+  );
+
+typedef struct {
+  NVME_SQ    Sq;
+  UINT16     QueueId;
+  UINTN      Remaining;
+} MOCK_NVME_COMMAND;
+
+typedef struct {
+  NVME_CONTROLLER_PRIVATE_DATA    *Private;
+  UINT8                           *Disk;
+  UINT16                          SqHead[NVME_MAX_QUEUES];
+  UINT16                          CqTail[NVME_MAX_QUEUES];
+  UINT8                           Phase[NVME_MAX_QUEUES];
+  MOCK_NVME_COMMAND               InFlight[MOCK_NVME_MAX_IN_FLIGHT];
+  UINTN                           InFlightCount;
+  //
+  // Statistics.
+  //
+  UINTN                           MaxInFlight;
+  UINT64                          Polls;
+  UINT64                          Bytes;
+  UINT64                          Completed;
+  //
+  // Commands touching [BadLba, BadLba + BadBlocks) fail with a media error.
+  //
+  UINT64                          BadLba;
+  UINT64                          BadBlocks;
+} MOCK_NVME_CONTROLLER;
+
+typedef struct {
+  UINT32              Type;
+  EFI_TPL             NotifyTpl;
+  EFI_EVENT_NOTIFY    NotifyFunction;
+  VOID                *NotifyContext;
+  BOOLEAN             Signaled;
+  BOOLEAN             Pending;
+  LIST_ENTRY          Link;
+} MOCK_EVENT;
+
+//
+// Submission and completion queue sizes of the admin, synchronous and
+// asynchronous queues, as set up by NvmeControllerInit () for a controller
+// reporting a maximum queue size of 256 entries.
+//
+STATIC CONST UINT16  mMockSqSize[NVME_MAX_QUEUES] = { NVME_ASQ_SIZE + 1, NVME_CSQ_SIZE + 1, NVME_ASYNC_CSQ_SIZE + 1 };
+STATIC CONST UINT16  mMockCqSize[NVME_MAX_QUEUES] = { NVME_ACQ_SIZE + 1, NVME_CCQ_SIZE + 1, NVME_ASYNC_CCQ_SIZE + 1 };
+
+STATIC MOCK_NVME_CONTROLLER      mMockNvme;
+STATIC NVME_DEVICE_PRIVATE_DATA  *mDevice;
+STATIC EFI_PCI_IO_PROTOCOL       mMockPciIo;
+STATIC EFI_BOOT_SERVICES         mMockBootServices;
+STATIC EFI_BOOT_SERVICES         *mSavedBootServices;
+STATIC LIST_ENTRY                mPendingEvents = INITIALIZE_LIST_HEAD_VARIABLE (mPendingEvents);
+STATIC EFI_TPL                   mCurrentTpl    = TPL_APPLICATION;
+
+/**
+  Copy data between the disk of the mock controller and the memory described
+  by the PRP entries of a command.
+
+  @param[in]  Sq          The submission queue entry of the command.
+  @param[in]  DiskOffset  The byte offset of the transfer on the disk.
+  @param[in]  Length      The length of the transfer in bytes.
+  @param[in]  ToMemory    TRUE to copy from the disk to memory.
+
+**/
+STATIC
+VOID
+MockNvmeTransfer (
+  IN NVME_SQ  *Sq,
+  IN UINT64   DiskOffset,
+  IN UINTN    Length,
+  IN BOOLEAN  ToMemory
+  )
+{
+  UINT64  *PrpList;
+  UINTN   Index;
+  UINT64  Address;
+  UINTN   Size;
+
+  PrpList = NULL;
+  Index   = 0;
+  Address = Sq->Prp[0];
+  Size    = MIN (Length, EFI_PAGE_SIZE - (UINTN)(Address & (EFI_PAGE_SIZE - 1)));
+
+  while (TRUE) {
+    if (ToMemory) {
+      CopyMem ((VOID *)(UINTN)Address, mMockNvme.Disk + DiskOffset, Size);
+    } else {
+      CopyMem (mMockNvme.Disk + DiskOffset, (VOID *)(UINTN)Address, Size);
+    }
+
+    DiskOffset += Size;
+    Length     -= Size;
+    if (Length == 0) {
+      break;
+    }
+
+    if (PrpList == NULL) {
+      if (Length <= EFI_PAGE_SIZE) {
+        //
+        // The second PRP entry addresses the last page of the transfer.
+        //
+        Address = Sq->Prp[1];
+        Size    = Length;
+        continue;
+      }
+
+      PrpList = (UINT64 *)(UINTN)Sq->Prp[1];
+    } else if ((Index == (EFI_PAGE_SIZE / sizeof (UINT64)) - 1) && (Length > EFI_PAGE_SIZE)) {
+      //
+      // The last entry of a full PRP list points to the next list.
+      //
+      PrpList = (UINT64 *)(UINTN)PrpList[Index];
+      Index   = 0;
+    }
+
+    Address = PrpList[Index++];
+    Size    = MIN (Length, EFI_PAGE_SIZE);
+  }
+}
+
+/**
+  Execute a command of the mock controller and post its completion queue
+  entry.
+
+  @param[in]  Command  The command to complete.
+
+**/
+STATIC
+VOID
+MockNvmeComplete (
+  IN MOCK_NVME_COMMAND  *Command
+  )
+{
+  NVME_SQ  *Sq;
+  NVME_CQ  Cqe;
+  UINT16   QueueId;
+  UINT64   Lba;
+  UINTN    Blocks;
+
+  Sq      = &Command->Sq;
+  QueueId = Command->QueueId;
+  ZeroMem (&Cqe, sizeof (Cqe));
+
+  if ((Sq->Opc == NVME_IO_READ_OPC) || (Sq->Opc == NVME_IO_WRITE_OPC)) {
+    Lba    = Sq->Payload.Raw.Cdw10 | LShiftU64 (Sq->Payload.Raw.Cdw11, 32);
+    Blocks = (Sq->Payload.Raw.Cdw12 & 0xFFFF) + 1;
+
+    if ((Sq->Nsid != 1) || (Lba + Blocks > MOCK_NVME_DISK_BLOCKS)) {
+      Cqe.Sct = NVME_CQE_SCT_GENERIC_CMD_STATUS;
+      Cqe.Sc  = NVME_CQE_SC_INVALID_FIELD_IN_CMD;
+    } else if ((Lba < mMockNvme.BadLba + mMockNvme.BadBlocks) && (Lba + Blocks > mMockNvme.BadLba)) {
+      //
+      // Unrecovered read error.
+      //
+      Cqe.Sct = NVME_CQE_SCT_MEDIA_DATA_INTEGRITY_ERRORS_STATUS;
+      Cqe.Sc  = 0x81;
+    } else {
+      MockNvmeTransfer (Sq, Lba * MOCK_NVME_BLOCK_SIZE, Blocks * MOCK_NVME_BLOCK_SIZE, Sq->Opc == NVME_IO_READ_OPC);
+      mMockNvme.Bytes += Blocks * MOCK_NVME_BLOCK_SIZE;
+    }
+  }
+
+  Cqe.Sqhd = mMockNvme.SqHead[QueueId];
+  Cqe.Sqid = QueueId;
+  Cqe.Cid  = Sq->Cid;
+  Cqe.Pt   = mMockNvme.Phase[QueueId];
+  CopyMem (mMockNvme.Private->CqBuffer[QueueId] + mMockNvme.CqTail[QueueId], &Cqe, sizeof (Cqe));
+
+  mMockNvme.CqTail[QueueId]++;
+  if (mMockNvme.CqTail[QueueId] == mMockCqSize[QueueId]) {
+    mMockNvme.CqTail[QueueId] = 0;
+    mMockNvme.Phase[QueueId] ^= 1;
+  }
+
+  mMockNvme.Completed++;
+}
+
+/**
+  Advance the mock controller by one poll: the first MOCK_NVME_CHANNELS
+  commands in flight make progress, and the commands done are completed.
+
+**/
+STATIC
+VOID
+MockNvmePoll (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  mMockNvme.Polls++;
+
+  for (Index = 0; Index < MIN (mMockNvme.InFlightCount, MOCK_NVME_CHANNELS); Index++) {
+    mMockNvme.InFlight[Index].Remaining--;
+  }
+
+  Index = 0;
+  while (Index < MIN (mMockNvme.InFlightCount, MOCK_NVME_CHANNELS)) {
+    if (mMockNvme.InFlight[Index].Remaining != 0) {
+      Index++;
+      continue;
+    }
+
+    MockNvmeComplete (&mMockNvme.InFlight[Index]);
+    mMockNvme.InFlightCount--;
+    CopyMem (
+      &mMockNvme.InFlight[Index],
+      &mMockNvme.InFlight[Index + 1],
+      (mMockNvme.InFlightCount - Index) * sizeof (MOCK_NVME_COMMAND)
+      );
+  }
+}
+
+/**
+  Mock of EFI_PCI_IO_PROTOCOL.Mem.Write (), decoding the doorbell registers.
+
+  @param  This     A pointer to the EFI_PCI_IO_PROTOCOL instance.
+  @param  Width    Signifies the width of the memory or I/O operations.
+  @param  BarIndex The BAR index of the standard PCI Configuration header.
+  @param  Offset   The offset within the selected BAR to start the memory operation.
+  @param  Count    The number of memory operations to perform.
+  @param  Buffer   The source buffer to write data from.
+
+  @retval EFI_SUCCESS  The data was written.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockPciIoMemWrite (
+  IN     EFI_PCI_IO_PROTOCOL        *This,
+  IN     EFI_PCI_IO_PROTOCOL_WIDTH  Width,
+  IN     UINT8                      BarIndex,
+  IN     UINT64                     Offset,
+  IN     UINTN                      Count,
+  IN OUT VOID                       *Buffer
+  )
+{
+  UINT16  QueueId;
+  UINT16  Tail;
+
+  if ((Offset < NVME_SQTDBL_OFFSET (0, 0)) || (((Offset - NVME_SQTDBL_OFFSET (0, 0)) & BIT2) != 0)) {
+    //
+    // Only the submission queue tail doorbells trigger work.
+    //
+    return EFI_SUCCESS;
+  }
+
+  QueueId = (UINT16)((Offset - NVME_SQTDBL_OFFSET (0, 0)) / 8);
+  Tail    = (UINT16)ReadUnaligned32 (Buffer);
+
+  while (mMockNvme.SqHead[QueueId] != Tail) {
+    ASSERT (mMockNvme.InFlightCount < MOCK_NVME_MAX_IN_FLIGHT);
+    CopyMem (
+      &mMockNvme.InFlight[mMockNvme.InFlightCount].Sq,
+      mMockNvme.Private->SqBuffer[QueueId] + mMockNvme.SqHead[QueueId],
+      sizeof (NVME_SQ)
+      );
+    mMockNvme.InFlight[mMockNvme.InFlightCount].QueueId   = QueueId;
+    mMockNvme.InFlight[mMockNvme.InFlightCount].Remaining = MOCK_NVME_LATENCY;
+    mMockNvme.InFlightCount++;
+    mMockNvme.SqHead[QueueId] = (mMockNvme.SqHead[QueueId] + 1) % mMockSqSize[QueueId];
+  }
+
+  mMockNvme.MaxInFlight = MAX (mMockNvme.MaxInFlight, mMockNvme.InFlightCount);
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock of EFI_PCI_IO_PROTOCOL.Map (), with identity mapping.
+
+  @param  This           A pointer to the EFI_PCI_IO_PROTOCOL instance.
+  @param  Operation      Indicates if the bus master is going to read or write to system memory.
+  @param  HostAddress    The system memory address to map to the PCI controller.
+  @param  NumberOfBytes  On input the number of bytes to map.
+  @param  DeviceAddress  The resulting map address for the bus master PCI controller.
+  @param  Mapping        A resulting value to pass to Unmap().
+
+  @retval EFI_SUCCESS    The range was mapped.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockPciIoMap (
+  IN     EFI_PCI_IO_PROTOCOL            *This,
+  IN     EFI_PCI_IO_PROTOCOL_OPERATION  Operation,
+  IN     VOID                           *HostAddress,
+  IN OUT UINTN                          *NumberOfBytes,
+  OUT    EFI_PHYSICAL_ADDRESS           *DeviceAddress,
+  OUT    VOID                           **Mapping
+  )
+{
+  *DeviceAddress = (EFI_PHYSICAL_ADDRESS)(UINTN)HostAddress;
+  *Mapping       = HostAddress;
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock of EFI_PCI_IO_PROTOCOL.Unmap ().
+
+  @param  This     A pointer to the EFI_PCI_IO_PROTOCOL instance.
+  @param  Mapping  The mapping value returned from Map().
+
+  @retval EFI_SUCCESS  The range was unmapped.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockPciIoUnmap (
+  IN EFI_PCI_IO_PROTOCOL  *This,
+  IN VOID                 *Mapping
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock of EFI_PCI_IO_PROTOCOL.AllocateBuffer ().
+
+  @param  This         A pointer to the EFI_PCI_IO_PROTOCOL instance.
+  @param  Type         This parameter is not used and must be ignored.
+  @param  MemoryType   The type of memory to allocate.
+  @param  Pages        The number of pages to allocate.
+  @param  HostAddress  A pointer to store the base system memory address of the allocated range.
+  @param  Attributes   The requested bit mask of attributes for the allocated range.
+
+  @retval EFI_SUCCESS           The requested memory pages were allocated.
+  @retval EFI_OUT_OF_RESOURCES  The memory pages could not be allocated.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockPciIoAllocateBuffer (
+  IN  EFI_PCI_IO_PROTOCOL  *This,
+  IN  EFI_ALLOCATE_TYPE    Type,
+  IN  EFI_MEMORY_TYPE      MemoryType,
+  IN  UINTN                Pages,
+  OUT VOID                 **HostAddress,
+  IN  UINT64               Attributes
+  )
+{
+  *HostAddress = AllocatePages (Pages);
+  return (*HostAddress == NULL) ? EFI_OUT_OF_RESOURCES : EFI_SUCCESS;
+}
+
+/**
+  Mock of EFI_PCI_IO_PROTOCOL.FreeBuffer ().
+
+  @param  This         A pointer to the EFI_PCI_IO_PROTOCOL instance.
+  @param  Pages        The number of pages to free.
+  @param  HostAddress  The base system memory address of the allocated range.
+
+  @retval EFI_SUCCESS  The requested memory pages were freed.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockPciIoFreeBuffer (
+  IN EFI_PCI_IO_PROTOCOL  *This,
+  IN UINTN                Pages,
+  IN VOID                 *HostAddress
+  )
+{
+  FreePages (HostAddress, Pages);
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock of gBS->RestoreTPL (), dispatching the pending notification functions
+  of a higher TPL than the restored one.
+
+  @param[in]  OldTpl  The previous task priority level to restore.
+
+**/
+STATIC
+VOID
+EFIAPI
+MockRestoreTpl (
+  IN EFI_TPL  OldTpl
+  )
+{
+  LIST_ENTRY  *Link;
+  MOCK_EVENT  *Event;
+  MOCK_EVENT  *Next;
+
+  while (TRUE) {
+    Next = NULL;
+    for (Link = GetFirstNode (&mPendingEvents); !IsNull (&mPendingEvents, Link); Link = GetNextNode (&mPendingEvents, Link)) {
+      Event = BASE_CR (Link, MOCK_EVENT, Link);
+      if ((Event->NotifyTpl > OldTpl) && ((Next == NULL) || (Event->NotifyTpl > Next->NotifyTpl))) {
+        Next = Event;
+      }
+    }
+
+    if (Next == NULL) {
+      break;
+    }
+
+    RemoveEntryList (&Next->Link);
+    Next->Pending = FALSE;
+    mCurrentTpl   = Next->NotifyTpl;
+    Next->NotifyFunction ((EFI_EVENT)Next, Next->NotifyContext);
+  }
+
+  mCurrentTpl = OldTpl;
+}
+
+/**
+  Mock of gBS->RaiseTPL ().
+
+  @param[in]  NewTpl  The new task priority level.
+
+  @return Previous task priority level
+
+**/
+STATIC
+EFI_TPL
+EFIAPI
+MockRaiseTpl (
+  IN EFI_TPL  NewTpl
+  )
+{
+  EFI_TPL  OldTpl;
+
+  OldTpl      = mCurrentTpl;
+  mCurrentTpl = MAX (OldTpl, NewTpl);
+  return OldTpl;
+}
+
+/**
+  Mock of gBS->CreateEvent ().
+
+  @param[in]   Type            The type of event to create and its mode and attributes.
+  @param[in]   NotifyTpl       The task priority level of event notifications, if needed.
+  @param[in]   NotifyFunction  The pointer to the event's notification function, if any.
+  @param[in]   NotifyContext   The pointer to the notification function's context.
+  @param[out]  Event           The pointer to the newly created event.
+
+  @retval EFI_SUCCESS           The event structure was created.
+  @retval EFI_OUT_OF_RESOURCES  The event could not be allocated.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockCreateEvent (
+  IN  UINT32            Type,
+  IN  EFI_TPL           NotifyTpl,
+  IN  EFI_EVENT_NOTIFY  NotifyFunction OPTIONAL,
+  IN  VOID              *NotifyContext OPTIONAL,
+  OUT EFI_EVENT         *Event
+  )
+{
+  MOCK_EVENT  *MockEvent;
+
+  MockEvent = AllocateZeroPool (sizeof (MOCK_EVENT));
+  if (MockEvent == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  MockEvent->Type           = Type;
+  MockEvent->NotifyTpl      = NotifyTpl;
+  MockEvent->NotifyFunction = NotifyFunction;
+  MockEvent->NotifyContext  = NotifyContext;
+  *Event                    = (EFI_EVENT)MockEvent;
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock of gBS->CloseEvent ().
+
+  @param[in]  Event  The event to close.
+
+  @retval EFI_SUCCESS  The event has been closed.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockCloseEvent (
+  IN EFI_EVENT  Event
+  )
+{
+  MOCK_EVENT  *MockEvent;
+
+  MockEvent = (MOCK_EVENT *)Event;
+  if (MockEvent->Pending) {
+    RemoveEntryList (&MockEvent->Link);
+  }
+
+  FreePool (MockEvent);
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock of gBS->SignalEvent ().
+
+  @param[in]  Event  The event to signal.
+
+  @retval EFI_SUCCESS  The event has been signaled.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockSignalEvent (
+  IN EFI_EVENT  Event
+  )
+{
+  MOCK_EVENT  *MockEvent;
+
+  MockEvent = (MOCK_EVENT *)Event;
+  if (((MockEvent->Type & EVT_NOTIFY_SIGNAL) == 0) || (MockEvent->NotifyFunction == NULL)) {
+    MockEvent->Signaled = TRUE;
+    return EFI_SUCCESS;
+  }
+
+  if (!MockEvent->Pending) {
+    MockEvent->Pending = TRUE;
+    InsertTailList (&mPendingEvents, &MockEvent->Link);
+  }
+
+  MockRestoreTpl (mCurrentTpl);
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock of gBS->CheckEvent (). Timers never expire, checking one polls the
+  mock controller instead.
+
+  @param[in]  Event  The event to check.
+
+  @retval EFI_SUCCESS            The event is in the signaled state.
+  @retval EFI_NOT_READY          The event is not in the signaled state.
+  @retval EFI_INVALID_PARAMETER  Event is of type EVT_NOTIFY_SIGNAL.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockCheckEvent (
+  IN EFI_EVENT  Event
+  )
+{
+  MOCK_EVENT  *MockEvent;
+
+  MockEvent = (MOCK_EVENT *)Event;
+  if ((MockEvent->Type & EVT_NOTIFY_SIGNAL) != 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((MockEvent->Type & EVT_TIMER) != 0) {
+    MockNvmePoll ();
+  }
+
+  if (MockEvent->Signaled) {
+    MockEvent->Signaled = FALSE;
+    return EFI_SUCCESS;
+  }
+
+  return EFI_NOT_READY;
+}
+
+/**
+  Mock of gBS->SetTimer ().
+
+  @param[in]  Event        The timer event that is to be signaled at the specified time.
+  @param[in]  Type         The type of time that is specified in TriggerTime.
+  @param[in]  TriggerTime  The number of 100ns units until the timer expires.
+
+  @retval EFI_SUCCESS  The event has been set to be signaled at the requested time.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockSetTimer (
+  IN EFI_EVENT        Event,
+  IN EFI_TIMER_DELAY  Type,
+  IN UINT64           TriggerTime
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock of gBS->Stall ().
+
+  @param[in]  Microseconds  The number of microseconds to stall execution.
+
+  @retval EFI_SUCCESS  Execution was stalled.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockStall (
+  IN UINTN  Microseconds
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Reset the statistics of the mock controller.
+
+**/
+STATIC
+VOID
+MockNvmeResetStatistics (
+  VOID
+  )
+{
+  mMockNvme.MaxInFlight = 0;
+  mMockNvme.Polls       = 0;
+  mMockNvme.Bytes       = 0;
+  mMockNvme.Completed   = 0;
+}
+
+/**
+  Create the NVMe controller and namespace instances over the mock controller,
+  and install the mock boot services.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED                      The instances were created.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  Out of resources.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+NvmePipelinedIoSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  NVME_CONTROLLER_PRIVATE_DATA  *Private;
+  UINTN                         Index;
+
+  ZeroMem (&mMockNvme, sizeof (mMockNvme));
+  mMockNvme.Disk = AllocatePages (EFI_SIZE_TO_PAGES (MOCK_NVME_DISK_BLOCKS * MOCK_NVME_BLOCK_SIZE));
+  Private        = AllocateZeroPool (sizeof (NVME_CONTROLLER_PRIVATE_DATA));
+  mDevice        = AllocateZeroPool (sizeof (NVME_DEVICE_PRIVATE_DATA));
+  if ((mMockNvme.Disk == NULL) || (Private == NULL) || (mDevice == NULL)) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  for (Index = 0; Index < NVME_MAX_QUEUES; Index++) {
+    mMockNvme.Phase[Index] = 1;
+  }
+
+  mMockNvme.Private = Private;
+  mMockNvme.BadLba  = MAX_UINT64 / 2;
+
+  //
+  // Give every block of the disk a distinct content.
+  //
+  for (Index = 0; Index < MOCK_NVME_DISK_BLOCKS * MOCK_NVME_BLOCK_SIZE / sizeof (UINT32); Index++) {
+    ((UINT32 *)mMockNvme.Disk)[Index] = (UINT32)Index * 0x9E3779B1;
+  }
+
+  ZeroMem (&mMockPciIo, sizeof (mMockPciIo));
+  mMockPciIo.Mem.Write      = MockPciIoMemWrite;
+  mMockPciIo.Map            = MockPciIoMap;
+  mMockPciIo.Unmap          = MockPciIoUnmap;
+  mMockPciIo.AllocateBuffer = MockPciIoAllocateBuffer;
+  mMockPciIo.FreeBuffer     = MockPciIoFreeBuffer;
+
+  //
+  // Lay out the queues as NvmeControllerInit () does.
+  //
+  Private->Signature      = NVME_CONTROLLER_PRIVATE_DATA_SIGNATURE;
+  Private->PciIo          = &mMockPciIo;
+  Private->Buffer         = AllocatePages (6);
+  Private->ControllerData = AllocateZeroPool (sizeof (NVME_ADMIN_CONTROLLER_DATA));
+  if ((Private->Buffer == NULL) || (Private->ControllerData == NULL)) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  ZeroMem (Private->Buffer, EFI_PAGES_TO_SIZE (6));
+  Private->BufferPciAddr = Private->Buffer;
+  for (Index = 0; Index < NVME_MAX_QUEUES; Index++) {
+    Private->SqBuffer[Index]        = (NVME_SQ *)(Private->Buffer + 2 * Index * EFI_PAGE_SIZE);
+    Private->SqBufferPciAddr[Index] = Private->SqBuffer[Index];
+    Private->CqBuffer[Index]        = (NVME_CQ *)(Private->Buffer + (2 * Index + 1) * EFI_PAGE_SIZE);
+    Private->CqBufferPciAddr[Index] = Private->CqBuffer[Index];
+  }
+
+  Private->Cap.Mqes                = 255;
+  Private->Cap.Mpsmin              = 0;
+  Private->ControllerData->Nn      = 1;
+  Private->ControllerData->Mdts    = MOCK_NVME_MDTS;
+  Private->PassThruMode.Attributes = EFI_NVM_EXPRESS_PASS_THRU_ATTRIBUTES_PHYSICAL |
+                                     EFI_NVM_EXPRESS_PASS_THRU_ATTRIBUTES_LOGICAL |
+                                     EFI_NVM_EXPRESS_PASS_THRU_ATTRIBUTES_NONBLOCKIO |
+                                     EFI_NVM_EXPRESS_PASS_THRU_ATTRIBUTES_CMD_SET_NVM;
+  Private->PassThruMode.IoAlign = sizeof (UINTN);
+  Private->Passthru.Mode        = &Private->PassThruMode;
+  Private->Passthru.PassThru    = NvmExpressPassThru;
+  InitializeListHead (&Private->AsyncPassThruQueue);
+  InitializeListHead (&Private->UnsubmittedSubtasks);
+
+  mDevice->Signature          = NVME_DEVICE_PRIVATE_DATA_SIGNATURE;
+  mDevice->NamespaceId        = 1;
+  mDevice->Controller         = Private;
+  mDevice->Media.MediaPresent = TRUE;
+  mDevice->Media.BlockSize    = MOCK_NVME_BLOCK_SIZE;
+  mDevice->Media.LastBlock    = MOCK_NVME_DISK_BLOCKS - 1;
+  InitializeListHead (&mDevice->AsyncQueue);
+
+  //
+  // The boot services of the host library do not implement events.
+  //
+  mSavedBootServices = gBS;
+  CopyMem (&mMockBootServices, gBS, sizeof (EFI_BOOT_SERVICES));
+  mMockBootServices.RaiseTPL    = MockRaiseTpl;
+  mMockBootServices.RestoreTPL  = MockRestoreTpl;
+  mMockBootServices.CreateEvent = MockCreateEvent;
+  mMockBootServices.CloseEvent  = MockCloseEvent;
+  mMockBootServices.SignalEvent = MockSignalEvent;
+  mMockBootServices.CheckEvent  = MockCheckEvent;
+  mMockBootServices.SetTimer    = MockSetTimer;
+  mMockBootServices.Stall       = MockStall;
+  gBS                           = &mMockBootServices;
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Free the instances created by NvmePipelinedIoSetup () and restore the boot
+  services.
+
+  @param[in]  Context  Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+NvmePipelinedIoCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  gBS = mSavedBootServices;
+
+  if (mDevice != NULL) {
+    if (mDevice->Controller != NULL) {
+      if (mDevice->Controller->Buffer != NULL) {
+        FreePages (mDevice->Controller->Buffer, 6);
+      }
+
+      if (mDevice->Controller->ControllerData != NULL) {
+        FreePool (mDevice->Controller->ControllerData);
+      }
+
+      FreePool (mDevice->Controller);
+    }
+
+    FreePool (mDevice);
+    mDevice = NULL;
+  }
+
+  if (mMockNvme.Disk != NULL) {
+    FreePages (mMockNvme.Disk, EFI_SIZE_TO_PAGES (MOCK_NVME_DISK_BLOCKS * MOCK_NVME_BLOCK_SIZE));
+    mMockNvme.Disk = NULL;
+  }
+}
+
+/**
+  A read larger than the maximum data transfer size has all its chunks in
+  flight at once, and moves more bytes per poll than reading the chunks one
+  after the other.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+PipelinedReadTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8       *Buffer;
+  UINTN       Size;
+  UINTN       Offset;
+  EFI_STATUS  Status;
+  UINT64      SerialBytesPerPoll;
+  UINT64      PipelinedBytesPerPoll;
+
+  Size   = TEST_TRANSFER_BLOCKS * MOCK_NVME_BLOCK_SIZE;
+  Buffer = AllocatePages (EFI_SIZE_TO_PAGES (Size));
+  UT_ASSERT_NOT_NULL (Buffer);
+
+  //
+  // Baseline: one command of the maximum data transfer size at a time.
+  //
+  MockNvmeResetStatistics ();
+  for (Offset = 0; Offset < Size; Offset += MOCK_NVME_CHUNK_BLOCKS * MOCK_NVME_BLOCK_SIZE) {
+    Status = NvmeRead (mDevice, Buffer + Offset, TEST_TRANSFER_LBA + Offset / MOCK_NVME_BLOCK_SIZE, MOCK_NVME_CHUNK_BLOCKS);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+  }
+
+  UT_ASSERT_MEM_EQUAL (Buffer, mMockNvme.Disk + TEST_TRANSFER_LBA * MOCK_NVME_BLOCK_SIZE, Size);
+  UT_ASSERT_EQUAL (mMockNvme.MaxInFlight, 1);
+  UT_ASSERT_NOT_EQUAL (mMockNvme.Polls, 0);
+  SerialBytesPerPoll = DivU64x64Remainder (mMockNvme.Bytes, mMockNvme.Polls, NULL);
+  UT_LOG_INFO ("Serial: %lu polls, %lu bytes per poll, %u commands in flight\n", mMockNvme.Polls, SerialBytesPerPoll, (UINT32)mMockNvme.MaxInFlight);
+
+  //
+  // Pipelined: the whole transfer in one call.
+  //
+  ZeroMem (Buffer, Size);
+  MockNvmeResetStatistics ();
+  Status = NvmeRead (mDevice, Buffer, TEST_TRANSFER_LBA, TEST_TRANSFER_BLOCKS);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  UT_ASSERT_MEM_EQUAL (Buffer, mMockNvme.Disk + TEST_TRANSFER_LBA * MOCK_NVME_BLOCK_SIZE, Size);
+  UT_ASSERT_EQUAL (mMockNvme.Completed, TEST_TRANSFER_BLOCKS / MOCK_NVME_CHUNK_BLOCKS);
+  UT_ASSERT_TRUE (mMockNvme.MaxInFlight >= MOCK_NVME_CHANNELS);
+  UT_ASSERT_TRUE (mMockNvme.MaxInFlight <= NVME_ASYNC_CSQ_SIZE);
+  UT_ASSERT_NOT_EQUAL (mMockNvme.Polls, 0);
+  PipelinedBytesPerPoll = DivU64x64Remainder (mMockNvme.Bytes, mMockNvme.Polls, NULL);
+  UT_LOG_INFO ("Pipelined: %lu polls, %lu bytes per poll, %u commands in flight\n", mMockNvme.Polls, PipelinedBytesPerPoll, (UINT32)mMockNvme.MaxInFlight);
+  UT_ASSERT_TRUE (PipelinedBytesPerPoll >= 4 * SerialBytesPerPoll);
+
+  UT_ASSERT_TRUE (IsListEmpty (&mDevice->AsyncQueue));
+  UT_ASSERT_TRUE (IsListEmpty (&mDevice->Controller->AsyncPassThruQueue));
+  UT_ASSERT_TRUE (IsListEmpty (&mDevice->Controller->UnsubmittedSubtasks));
+
+  FreePages (Buffer, EFI_SIZE_TO_PAGES (Size));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A write larger than the maximum data transfer size has all its chunks in
+  flight at once and lands on the disk.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+PipelinedWriteTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8       *Buffer;
+  UINTN       Size;
+  UINTN       Index;
+  EFI_STATUS  Status;
+
+  Size   = TEST_TRANSFER_BLOCKS * MOCK_NVME_BLOCK_SIZE;
+  Buffer = AllocatePages (EFI_SIZE_TO_PAGES (Size));
+  UT_ASSERT_NOT_NULL (Buffer);
+  for (Index = 0; Index < Size; Index++) {
+    Buffer[Index] = (UINT8)(Index / MOCK_NVME_BLOCK_SIZE + Index);
+  }
+
+  MockNvmeResetStatistics ();
+  Status = NvmeWrite (mDevice, Buffer, TEST_TRANSFER_LBA, TEST_TRANSFER_BLOCKS);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  UT_ASSERT_MEM_EQUAL (mMockNvme.Disk + TEST_TRANSFER_LBA * MOCK_NVME_BLOCK_SIZE, Buffer, Size);
+  UT_ASSERT_EQUAL (mMockNvme.Completed, TEST_TRANSFER_BLOCKS / MOCK_NVME_CHUNK_BLOCKS);
+  UT_ASSERT_TRUE (mMockNvme.MaxInFlight >= MOCK_NVME_CHANNELS);
+  UT_LOG_INFO (
+    "Pipelined write: %lu polls, %lu bytes per poll, %u commands in flight\n",
+    mMockNvme.Polls,
+    DivU64x64Remainder (mMockNvme.Bytes, mMockNvme.Polls, NULL),
+    (UINT32)mMockNvme.MaxInFlight
+    );
+
+  FreePages (Buffer, EFI_SIZE_TO_PAGES (Size));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A BlockIo2 read is split in chunks which are all in flight at once, and its
+  token is signaled when the completion of the last chunk arrives.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BlockIo2CompletionTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8                *Buffer;
+  UINTN                Size;
+  EFI_BLOCK_IO2_TOKEN  Token;
+  EFI_STATUS           Status;
+  EFI_TPL              OldTpl;
+
+  Size   = TEST_TRANSFER_BLOCKS * MOCK_NVME_BLOCK_SIZE;
+  Buffer = AllocatePages (EFI_SIZE_TO_PAGES (Size));
+  UT_ASSERT_NOT_NULL (Buffer);
+
+  Status = gBS->CreateEvent (0, TPL_CALLBACK, NULL, NULL, &Token.Event);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  Token.TransactionStatus = EFI_SUCCESS;
+
+  MockNvmeResetStatistics ();
+  Status = NvmeAsyncRead (mDevice, Buffer, TEST_TRANSFER_LBA, TEST_TRANSFER_BLOCKS, &Token);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  //
+  // Drive the periodic processing of the asynchronous queue by hand.
+  //
+  while (TRUE) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    ProcessAsyncTaskList (NULL, mDevice->Controller);
+    gBS->RestoreTPL (OldTpl);
+
+    if (!EFI_ERROR (gBS->CheckEvent (Token.Event))) {
+      break;
+    }
+
+    UT_ASSERT_TRUE (mMockNvme.Completed < TEST_TRANSFER_BLOCKS / MOCK_NVME_CHUNK_BLOCKS);
+    MockNvmePoll ();
+  }
+
+  UT_ASSERT_EQUAL (mMockNvme.Completed, TEST_TRANSFER_BLOCKS / MOCK_NVME_CHUNK_BLOCKS);
+  UT_ASSERT_EQUAL (mMockNvme.InFlightCount, 0);
+  UT_ASSERT_TRUE (mMockNvme.MaxInFlight >= MOCK_NVME_CHANNELS);
+  UT_ASSERT_NOT_EFI_ERROR (Token.TransactionStatus);
+  UT_ASSERT_MEM_EQUAL (Buffer, mMockNvme.Disk + TEST_TRANSFER_LBA * MOCK_NVME_BLOCK_SIZE, Size);
+  UT_ASSERT_TRUE (IsListEmpty (&mDevice->AsyncQueue));
+
+  gBS->CloseEvent (Token.Event);
+  FreePages (Buffer, EFI_SIZE_TO_PAGES (Size));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A failing chunk fails the whole pipelined read, once all the chunks in
+  flight are released.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+PipelinedReadErrorTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8       *Buffer;
+  UINTN       Size;
+  EFI_STATUS  Status;
+
+  Size   = TEST_TRANSFER_BLOCKS * MOCK_NVME_BLOCK_SIZE;
+  Buffer = AllocatePages (EFI_SIZE_TO_PAGES (Size));
+  UT_ASSERT_NOT_NULL (Buffer);
+
+  mMockNvme.BadLba    = TEST_TRANSFER_LBA + TEST_TRANSFER_BLOCKS / 2;
+  mMockNvme.BadBlocks = 1;
+
+  Status = NvmeRead (mDevice, Buffer, TEST_TRANSFER_LBA, TEST_TRANSFER_BLOCKS);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_DEVICE_ERROR);
+
+  UT_ASSERT_EQUAL (mMockNvme.InFlightCount, 0);
+  UT_ASSERT_TRUE (IsListEmpty (&mDevice->AsyncQueue));
+  UT_ASSERT_TRUE (IsListEmpty (&mDevice->Controller->AsyncPassThruQueue));
+  UT_ASSERT_TRUE (IsListEmpty (&mDevice->Controller->UnsubmittedSubtasks));
+
+  //
+  // The queues are still usable afterwards.
+  //
+  mMockNvme.BadBlocks = 0;
+  Status              = NvmeRead (mDevice, Buffer, TEST_TRANSFER_LBA, TEST_TRANSFER_BLOCKS);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_MEM_EQUAL (Buffer, mMockNvme.Disk + TEST_TRANSFER_LBA * MOCK_NVME_BLOCK_SIZE, Size);
+
+  FreePages (Buffer, EFI_SIZE_TO_PAGES (Size));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the pipelined
+  NVMe I/O and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      PipelinedIoTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&PipelinedIoTests, Framework, "NVMe Pipelined I/O Tests", "NvmExpress.PipelinedIo", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for PipelinedIoTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (PipelinedIoTests, "Large reads keep the queue full", "PipelinedRead", PipelinedReadTest, NvmePipelinedIoSetup, NvmePipelinedIoCleanup, NULL);
+  AddTestCase (PipelinedIoTests, "Large writes keep the queue full", "PipelinedWrite", PipelinedWriteTest, NvmePipelinedIoSetup, NvmePipelinedIoCleanup, NULL);
+  AddTestCase (PipelinedIoTests, "BlockIo2 token signaled on the last completion", "BlockIo2Completion", BlockIo2CompletionTest, NvmePipelinedIoSetup, NvmePipelinedIoCleanup, NULL);
+  AddTestCase (PipelinedIoTests, "A failing chunk fails the transfer", "PipelinedReadError", PipelinedReadErrorTest, NvmePipelinedIoSetup, NvmePipelinedIoCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -1340,6 +1340,241 @@ ON_EXIT:
   return Status;
 }
 
+// MU_CHANGE [BEGIN] - Batched bulk transfers
+
+/**
+  Queue a list of bulk transfers to a USB device and wait for them to complete.
+
+  @param  This                  This EDKII_USB2_HC_BULK_BATCH_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  DeviceSpeed           Device speed, Low speed device doesn't support bulk
+                                transfer.
+  @param  RequestCount          Number of entries in Requests.
+  @param  Requests              The transfers to execute.
+  @param  Timeout               Indicates the maximum time, in millisecond, which
+                                the whole batch is allowed to complete.
+  @param  Translator            A pointr to the transaction translator data.
+
+  @retval EFI_SUCCESS           All the transfers completed successfully.
+  @retval EFI_OUT_OF_RESOURCES  Some transfers could not be queued.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+  @retval EFI_TIMEOUT           The batch failed due to timeout.
+  @retval EFI_DEVICE_ERROR      A transfer failed due to host controller or device error.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcBulkBatchTransfer (
+  IN     EDKII_USB2_HC_BULK_BATCH_PROTOCOL   *This,
+  IN     UINT8                               DeviceAddress,
+  IN     UINT8                               DeviceSpeed,
+  IN     UINTN                               RequestCount,
+  IN OUT EDKII_USB_BULK_BATCH_REQUEST        *Requests,
+  IN     UINTN                               Timeout,
+  IN     EFI_USB2_HC_TRANSACTION_TRANSLATOR  *Translator
+  )
+{
+  USB_XHCI_INSTANCE  *Xhc;
+  UINT8              SlotId;
+  UINTN              Index;
+  UINTN              MaximumPacketLength;
+  EFI_STATUS         Status;
+  EFI_TPL            OldTpl;
+
+  //
+  // Validate the parameters
+  //
+  if ((Requests == NULL) || (RequestCount == 0) || (DeviceSpeed == EFI_USB_SPEED_LOW)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  for (Index = 0; Index < RequestCount; Index++) {
+    MaximumPacketLength = Requests[Index].MaximumPacketLength;
+    if ((Requests[Index].Data == NULL) || (Requests[Index].DataLength == 0) ||
+        ((DeviceSpeed == EFI_USB_SPEED_FULL) && (MaximumPacketLength > 64)) ||
+        ((EFI_USB_SPEED_HIGH == DeviceSpeed) && (MaximumPacketLength > 512)) ||
+        ((EFI_USB_SPEED_SUPER == DeviceSpeed) && (MaximumPacketLength > 1024)))
+    {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    Requests[Index].TransferResult = EFI_USB_ERR_SYSTEM;
+    Requests[Index].Status         = EFI_DEVICE_ERROR;
+  }
+
+  // MU_CHANGE [BEGIN] - Bulk streams
+  //
+  // The batch waits for the transfers which are not optional.
+  //
+  for (Index = 0; Index < RequestCount; Index++) {
+    if (!Requests[Index].Optional) {
+      break;
+    }
+  }
+
+  if (Index == RequestCount) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  // MU_CHANGE [END] - Bulk streams
+
+  OldTpl = gBS->RaiseTPL (XHC_TPL);
+
+  Xhc    = XHC_FROM_BULK_BATCH_THIS (This);
+  Status = EFI_DEVICE_ERROR;
+
+  if (XhcIsHalt (Xhc) || XhcIsSysError (Xhc)) {
+    DEBUG ((DEBUG_ERROR, "XhcBulkBatchTransfer: HC is halted\n"));
+    goto ON_EXIT;
+  }
+
+  //
+  // Check if the device is still enabled before every batch.
+  //
+  SlotId = XhcBusDevAddrToSlotId (Xhc, DeviceAddress);
+  if (SlotId == 0) {
+    goto ON_EXIT;
+  }
+
+  Status = XhcExecBulkBatch (Xhc, DeviceAddress, DeviceSpeed, RequestCount, Requests, Timeout);
+
+ON_EXIT:
+  if (EFI_ERROR (Status) && (Status != EFI_TIMEOUT)) {
+    DEBUG ((DEBUG_ERROR, "XhcBulkBatchTransfer: error - %r\n", Status));
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  return Status;
+}
+
+// MU_CHANGE [END] - Batched bulk transfers
+
+// MU_CHANGE [BEGIN] - Bulk streams
+
+/**
+  Allocate streams on bulk endpoints of a SuperSpeed USB device.
+
+  @param  This                  This EDKII_USB2_HC_BULK_BATCH_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  EndpointCount         Number of entries in EndPointAddresses.
+  @param  EndPointAddresses     The bulk endpoints.
+  @param  StreamCount           Number of streams wanted on input, number of
+                                streams allocated on output.
+
+  @retval EFI_SUCCESS           The streams are allocated.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+  @retval EFI_UNSUPPORTED       The XHC or an endpoint has no streams.
+  @retval EFI_OUT_OF_RESOURCES  The streams could not be allocated.
+  @retval EFI_DEVICE_ERROR      The XHC failed to enable the streams.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcAllocateStreams (
+  IN     EDKII_USB2_HC_BULK_BATCH_PROTOCOL  *This,
+  IN     UINT8                              DeviceAddress,
+  IN     UINTN                              EndpointCount,
+  IN     UINT8                              *EndPointAddresses,
+  IN OUT UINT16                             *StreamCount
+  )
+{
+  USB_XHCI_INSTANCE  *Xhc;
+  UINT8              SlotId;
+  EFI_STATUS         Status;
+  EFI_TPL            OldTpl;
+
+  if ((EndPointAddresses == NULL) || (EndpointCount == 0) || (StreamCount == NULL) || (*StreamCount == 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl = gBS->RaiseTPL (XHC_TPL);
+
+  Xhc    = XHC_FROM_BULK_BATCH_THIS (This);
+  Status = EFI_DEVICE_ERROR;
+
+  if (XhcIsHalt (Xhc) || XhcIsSysError (Xhc)) {
+    DEBUG ((DEBUG_ERROR, "XhcAllocateStreams: HC is halted\n"));
+    goto ON_EXIT;
+  }
+
+  SlotId = XhcBusDevAddrToSlotId (Xhc, DeviceAddress);
+  if (SlotId == 0) {
+    goto ON_EXIT;
+  }
+
+  Status = XhcEnableStreams (Xhc, SlotId, EndpointCount, EndPointAddresses, StreamCount);
+
+ON_EXIT:
+  if (EFI_ERROR (Status) && (Status != EFI_UNSUPPORTED)) {
+    DEBUG ((DEBUG_ERROR, "XhcAllocateStreams: error - %r\n", Status));
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  return Status;
+}
+
+/**
+  Free the streams of bulk endpoints of a USB device.
+
+  @param  This                  This EDKII_USB2_HC_BULK_BATCH_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  EndpointCount         Number of entries in EndPointAddresses.
+  @param  EndPointAddresses     The bulk endpoints.
+
+  @retval EFI_SUCCESS           The streams are freed.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+  @retval EFI_DEVICE_ERROR      The XHC failed to disable the streams.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcFreeStreams (
+  IN EDKII_USB2_HC_BULK_BATCH_PROTOCOL  *This,
+  IN UINT8                              DeviceAddress,
+  IN UINTN                              EndpointCount,
+  IN UINT8                              *EndPointAddresses
+  )
+{
+  USB_XHCI_INSTANCE  *Xhc;
+  UINT8              SlotId;
+  EFI_STATUS         Status;
+  EFI_TPL            OldTpl;
+
+  if ((EndPointAddresses == NULL) || (EndpointCount == 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl = gBS->RaiseTPL (XHC_TPL);
+
+  Xhc    = XHC_FROM_BULK_BATCH_THIS (This);
+  Status = EFI_DEVICE_ERROR;
+
+  if (XhcIsHalt (Xhc) || XhcIsSysError (Xhc)) {
+    DEBUG ((DEBUG_ERROR, "XhcFreeStreams: HC is halted\n"));
+    goto ON_EXIT;
+  }
+
+  SlotId = XhcBusDevAddrToSlotId (Xhc, DeviceAddress);
+  if (SlotId == 0) {
+    goto ON_EXIT;
+  }
+
+  Status = XhcDisableStreams (Xhc, SlotId, EndpointCount, EndPointAddresses);
+
+ON_EXIT:
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "XhcFreeStreams: error - %r\n", Status));
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  return Status;
+}
+
+// MU_CHANGE [END] - Bulk streams
+
 /**
   Submits an asynchronous interrupt transfer to an
   interrupt endpoint of a USB device.
@@ -1832,6 +2067,14 @@ XhcCreateUsbHc (
   }
 
   InitializeListHead (&Xhc->AsyncIntTransfers);
+  // MU_CHANGE [BEGIN] - Batched bulk transfers
+  InitializeListHead (&Xhc->BatchTransfers);
+  Xhc->BulkBatch.BulkTransfer = XhcBulkBatchTransfer;
+  // MU_CHANGE [END] - Batched bulk transfers
+  // MU_CHANGE [BEGIN] - Bulk streams
+  Xhc->BulkBatch.AllocateStreams = XhcAllocateStreams;
+  Xhc->BulkBatch.FreeStreams     = XhcFreeStreams;
+  // MU_CHANGE [END] - Bulk streams
 
   //
   // Be caution that the Offset passed to XhcReadCapReg() should be Dword align
@@ -2137,12 +2380,16 @@ XhcDriverBindingStart (
     FALSE
     );
 
-  Status = gBS->InstallProtocolInterface (
+  // MU_CHANGE [BEGIN] - Batched bulk transfers
+  Status = gBS->InstallMultipleProtocolInterfaces (
                   &Controller,
                   &gEfiUsb2HcProtocolGuid,
-                  EFI_NATIVE_INTERFACE,
-                  &Xhc->Usb2Hc
+                  &Xhc->Usb2Hc,
+                  &gEdkiiUsb2HcBulkBatchProtocolGuid,
+                  &Xhc->BulkBatch,
+                  NULL
                   );
+  // MU_CHANGE [END] - Batched bulk transfers
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "XhcDriverBindingStart: failed to install USB2_HC Protocol\n"));
     goto FREE_POOL;
@@ -2238,6 +2485,14 @@ XhcDriverBindingStop (
   Xhc   = XHC_FROM_THIS (Usb2Hc);
   PciIo = Xhc->PciIo;
 
+  // MU_CHANGE [BEGIN] - Batched bulk transfers
+  gBS->UninstallProtocolInterface (
+         Controller,
+         &gEdkiiUsb2HcBulkBatchProtocolGuid,
+         &Xhc->BulkBatch
+         );
+  // MU_CHANGE [END] - Batched bulk transfers
+
   //
   // Stop AsyncRequest Polling timer then stop the XHCI driver
   // and uninstall the XHCI protocl.
@@ -16,6 +16,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include <Protocol/Usb2HostController.h>
 #include <Protocol/PciIo.h>
+#include <Protocol/UsbBulkBatch.h> // MU_CHANGE - Batched bulk transfers
 
 #include <Guid/EventGroup.h>
 
@@ -103,6 +104,7 @@ typedef struct _USB_DEV_CONTEXT    USB_DEV_CONTEXT;
 
 #define XHCI_INSTANCE_SIG  SIGNATURE_32 ('x', 'h', 'c', 'i')
 #define XHC_FROM_THIS(a)  CR(a, USB_XHCI_INSTANCE, Usb2Hc, XHCI_INSTANCE_SIG)
+#define XHC_FROM_BULK_BATCH_THIS(a)  CR(a, USB_XHCI_INSTANCE, BulkBatch, XHCI_INSTANCE_SIG) // MU_CHANGE - Batched bulk transfers
 
 #define USB_DESC_TYPE_HUB              0x29
 #define USB_DESC_TYPE_HUB_SUPER_SPEED  0x2a
@@ -178,6 +180,13 @@ struct _USB_DEV_CONTEXT {
   // The transfer queue for every endpoint.
   //
   VOID                         *EndpointTransferRing[31];
+  // MU_CHANGE [BEGIN] - Bulk streams
+  //
+  // The ENDPOINT_STREAMS of every bulk endpoint with streams allocated, their
+  // transfers use the ring of their stream instead of EndpointTransferRing.
+  //
+  VOID                         *EndpointStreams[31];
+  // MU_CHANGE [END] - Bulk streams
   //
   // The device descriptor which is stored to support XHCI's Evaluate_Context cmd.
   //
@@ -207,6 +216,9 @@ struct _USB_XHCI_INSTANCE {
   USBHC_MEM_POOL              *MemPool;
 
   EFI_USB2_HC_PROTOCOL        Usb2Hc;
+  // MU_CHANGE [BEGIN] - Batched bulk transfers
+  EDKII_USB2_HC_BULK_BATCH_PROTOCOL    BulkBatch;
+  // MU_CHANGE [END] - Batched bulk transfers
 
   EFI_DEVICE_PATH_PROTOCOL    *DevicePath;
 
@@ -217,6 +229,13 @@ struct _USB_XHCI_INSTANCE {
   EFI_EVENT                   ExitBootServiceEvent;
   EFI_EVENT                   PollTimer;
   LIST_ENTRY                  AsyncIntTransfers;
+  // MU_CHANGE [BEGIN] - Batched bulk transfers
+  //
+  // URBs of the bulk batch in progress, their events are harvested by
+  // XhcCheckUrbResult () whichever URB it is called for.
+  //
+  LIST_ENTRY                  BatchTransfers;
+  // MU_CHANGE [END] - Batched bulk transfers
 
   UINT8                       CapLength;  ///< Capability Register Length
   XHC_HCSPARAMS1              HcSParams1; ///< Structural Parameters 1
@@ -563,6 +582,95 @@ XhcBulkTransfer (
   OUT    UINT32                              *TransferResult
   );
 
+// MU_CHANGE [BEGIN] - Batched bulk transfers
+
+/**
+  Queue a list of bulk transfers to a USB device and wait for them to complete.
+
+  @param  This                  This EDKII_USB2_HC_BULK_BATCH_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  DeviceSpeed           Device speed, Low speed device doesn't support bulk
+                                transfer.
+  @param  RequestCount          Number of entries in Requests.
+  @param  Requests              The transfers to execute.
+  @param  Timeout               Indicates the maximum time, in millisecond, which
+                                the whole batch is allowed to complete.
+  @param  Translator            A pointr to the transaction translator data.
+
+  @retval EFI_SUCCESS           All the transfers completed successfully.
+  @retval EFI_OUT_OF_RESOURCES  Some transfers could not be queued.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+  @retval EFI_TIMEOUT           The batch failed due to timeout.
+  @retval EFI_DEVICE_ERROR      A transfer failed due to host controller or device error.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcBulkBatchTransfer (
+  IN     EDKII_USB2_HC_BULK_BATCH_PROTOCOL   *This,
+  IN     UINT8                               DeviceAddress,
+  IN     UINT8                               DeviceSpeed,
+  IN     UINTN                               RequestCount,
+  IN OUT EDKII_USB_BULK_BATCH_REQUEST        *Requests,
+  IN     UINTN                               Timeout,
+  IN     EFI_USB2_HC_TRANSACTION_TRANSLATOR  *Translator
+  );
+
+// MU_CHANGE [END] - Batched bulk transfers
+
+// MU_CHANGE [BEGIN] - Bulk streams
+
+/**
+  Allocate streams on bulk endpoints of a SuperSpeed USB device.
+
+  @param  This                  This EDKII_USB2_HC_BULK_BATCH_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  EndpointCount         Number of entries in EndPointAddresses.
+  @param  EndPointAddresses     The bulk endpoints.
+  @param  StreamCount           Number of streams wanted on input, number of
+                                streams allocated on output.
+
+  @retval EFI_SUCCESS           The streams are allocated.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+  @retval EFI_UNSUPPORTED       The XHC or an endpoint has no streams.
+  @retval EFI_OUT_OF_RESOURCES  The streams could not be allocated.
+  @retval EFI_DEVICE_ERROR      The XHC failed to enable the streams.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcAllocateStreams (
+  IN     EDKII_USB2_HC_BULK_BATCH_PROTOCOL  *This,
+  IN     UINT8                              DeviceAddress,
+  IN     UINTN                              EndpointCount,
+  IN     UINT8                              *EndPointAddresses,
+  IN OUT UINT16                             *StreamCount
+  );
+
+/**
+  Free the streams of bulk endpoints of a USB device.
+
+  @param  This                  This EDKII_USB2_HC_BULK_BATCH_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  EndpointCount         Number of entries in EndPointAddresses.
+  @param  EndPointAddresses     The bulk endpoints.
+
+  @retval EFI_SUCCESS           The streams are freed.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+  @retval EFI_DEVICE_ERROR      The XHC failed to disable the streams.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcFreeStreams (
+  IN EDKII_USB2_HC_BULK_BATCH_PROTOCOL  *This,
+  IN UINT8                              DeviceAddress,
+  IN UINTN                              EndpointCount,
+  IN UINT8                              *EndPointAddresses
+  );
+
+// MU_CHANGE [END] - Bulk streams
+
 /**
   Submits an asynchronous interrupt transfer to an
   interrupt endpoint of a USB device.
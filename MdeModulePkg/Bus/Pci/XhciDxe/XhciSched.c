@@ -181,6 +181,71 @@ XhcCreateUrb (
   return Urb;
 }
 
+// MU_CHANGE [BEGIN] - Bulk streams
+
+/**
+  Create a new URB for a bulk transfer on a stream of an endpoint.
+
+  @param  Xhc       The XHCI Instance
+  @param  BusAddr   The logical device address assigned by UsbBus driver
+  @param  EpAddr    Endpoint addrress
+  @param  DevSpeed  The device speed
+  @param  MaxPacket The max packet length of the endpoint
+  @param  StreamId  The stream of the transfer, 0 if the endpoint has no streams
+  @param  Data      The user data to transfer
+  @param  DataLen   The length of data buffer
+
+  @return Created URB or NULL
+
+**/
+URB *
+XhcCreateStreamUrb (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN UINT8              BusAddr,
+  IN UINT8              EpAddr,
+  IN UINT8              DevSpeed,
+  IN UINTN              MaxPacket,
+  IN UINT16             StreamId,
+  IN VOID               *Data,
+  IN UINTN              DataLen
+  )
+{
+  USB_ENDPOINT  *Ep;
+  EFI_STATUS    Status;
+  URB           *Urb;
+
+  Urb = AllocateZeroPool (sizeof (URB));
+  if (Urb == NULL) {
+    return NULL;
+  }
+
+  Urb->Signature = XHC_URB_SIG;
+  InitializeListHead (&Urb->UrbList);
+
+  Ep            = &Urb->Ep;
+  Ep->BusAddr   = BusAddr;
+  Ep->EpAddr    = (UINT8)(EpAddr & 0x0F);
+  Ep->Direction = ((EpAddr & 0x80) != 0) ? EfiUsbDataIn : EfiUsbDataOut;
+  Ep->DevSpeed  = DevSpeed;
+  Ep->MaxPacket = MaxPacket;
+  Ep->Type      = XHC_BULK_TRANSFER;
+
+  Urb->Data     = Data;
+  Urb->DataLen  = DataLen;
+  Urb->StreamId = StreamId;
+
+  Status = XhcCreateTransferTrb (Xhc, Urb);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "XhcCreateStreamUrb: XhcCreateTransferTrb Failed, Status = %r\n", Status));
+    FreePool (Urb);
+    Urb = NULL;
+  }
+
+  return Urb;
+}
+
+// MU_CHANGE [END] - Bulk streams
+
 /**
   Free an allocated URB.
 
@@ -233,6 +298,7 @@ XhcCreateTransferTrb (
   EFI_PHYSICAL_ADDRESS           PhyAddr;
   VOID                           *Map;
   EFI_STATUS                     Status;
+  ENDPOINT_STREAMS               *Streams; // MU_CHANGE - Bulk streams
 
   SlotId = XhcBusDevAddrToSlotId (Xhc, Urb->Ep.BusAddr);
   if (SlotId == 0) {
@@ -247,7 +313,24 @@ XhcCreateTransferTrb (
 
   Dci = XhcEndpointToDci (Urb->Ep.EpAddr, (UINT8)(Urb->Ep.Direction));
   ASSERT (Dci < 32);
-  EPRing = (TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci-1];
+  // MU_CHANGE [BEGIN] - Bulk streams
+  //
+  // The transfers to an endpoint with streams go on the ring of their stream.
+  //
+  Streams = (ENDPOINT_STREAMS *)Xhc->UsbDevContext[SlotId].EndpointStreams[Dci-1];
+  if (Streams != NULL) {
+    if ((Urb->StreamId == 0) || (Urb->StreamId > Streams->StreamCount)) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    EPRing = &Streams->Rings[Urb->StreamId];
+  } else if (Urb->StreamId != 0) {
+    return EFI_INVALID_PARAMETER;
+  } else {
+    EPRing = (TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci-1];
+  }
+
+  // MU_CHANGE [END] - Bulk streams
   if (EPRing == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
@@ -703,7 +786,7 @@ XhcRecoverHaltedEndpoint (
   //
   // 3)Ring the doorbell to transit from stop to active
   //
-  XhcRingDoorBell (Xhc, SlotId, Dci);
+  XhcRingStreamDoorBell (Xhc, SlotId, Dci, Urb->StreamId); // MU_CHANGE - Bulk streams
 
 Done:
   return Status;
@@ -776,7 +859,7 @@ XhcDequeueTrbFromEndpoint (
   //
   // 3)Ring the doorbell to transit from stop to active
   //
-  XhcRingDoorBell (Xhc, SlotId, Dci);
+  XhcRingStreamDoorBell (Xhc, SlotId, Dci, Urb->StreamId); // MU_CHANGE - Bulk streams
 
 Done:
   return Status;
@@ -1103,6 +1186,42 @@ IsAsyncIntTrb (
   return FALSE;
 }
 
+// MU_CHANGE [BEGIN] - Batched bulk transfers
+
+/**
+  Check if the Trb is a transaction of the URBs in XHCI's bulk batch list.
+
+  @param Xhc    The XHCI Instance.
+  @param Trb    The TRB to be checked.
+  @param Urb    The pointer to the matched Urb.
+
+  @retval TRUE  The Trb is matched with a transaction of the URBs in the batch list.
+  @retval FALSE The Trb is not matched with any URBs in the batch list.
+
+**/
+BOOLEAN
+IsBatchTrb (
+  IN  USB_XHCI_INSTANCE  *Xhc,
+  IN  TRB_TEMPLATE       *Trb,
+  OUT URB                **Urb
+  )
+{
+  LIST_ENTRY  *Entry;
+  URB         *CheckedUrb;
+
+  BASE_LIST_FOR_EACH (Entry, &Xhc->BatchTransfers) {
+    CheckedUrb = EFI_LIST_CONTAINER (Entry, URB, UrbList);
+    if (IsTransferRingTrb (Xhc, Trb, CheckedUrb)) {
+      *Urb = CheckedUrb;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+// MU_CHANGE [END] - Batched bulk transfers
+
 /**
   Check the URB's execution result and update the URB's
   result accordingly.
@@ -1185,6 +1304,9 @@ XhcCheckUrbResult (
       CheckedUrb = Urb;
     } else if (IsAsyncIntTrb (Xhc, TRBPtr, &AsyncUrb)) {
       CheckedUrb = AsyncUrb;
+    } else if (IsBatchTrb (Xhc, TRBPtr, &AsyncUrb)) {
+      // MU_CHANGE - Batched bulk transfers
+      CheckedUrb = AsyncUrb;
     } else {
       continue;
     }
@@ -1204,150 +1326,954 @@ XhcCheckUrbResult (
         DEBUG ((DEBUG_ERROR, "XhcCheckUrbResult: BABBLE_ERROR! Completecode = %x\n", EvtTrb->Completecode));
         goto EXIT;
 
-      case TRB_COMPLETION_DATA_BUFFER_ERROR:
-        CheckedUrb->Result  |= EFI_USB_ERR_BUFFER;
-        CheckedUrb->Finished = TRUE;
-        DEBUG ((DEBUG_ERROR, "XhcCheckUrbResult: ERR_BUFFER! Completecode = %x\n", EvtTrb->Completecode));
-        goto EXIT;
+      case TRB_COMPLETION_DATA_BUFFER_ERROR:
+        CheckedUrb->Result  |= EFI_USB_ERR_BUFFER;
+        CheckedUrb->Finished = TRUE;
+        DEBUG ((DEBUG_ERROR, "XhcCheckUrbResult: ERR_BUFFER! Completecode = %x\n", EvtTrb->Completecode));
+        goto EXIT;
+
+      case TRB_COMPLETION_USB_TRANSACTION_ERROR:
+        CheckedUrb->Result  |= EFI_USB_ERR_TIMEOUT;
+        CheckedUrb->Finished = TRUE;
+        DEBUG ((DEBUG_ERROR, "XhcCheckUrbResult: TRANSACTION_ERROR! Completecode = %x\n", EvtTrb->Completecode));
+        goto EXIT;
+
+      case TRB_COMPLETION_STOPPED:
+      case TRB_COMPLETION_STOPPED_LENGTH_INVALID:
+        CheckedUrb->Result  |= EFI_USB_ERR_TIMEOUT;
+        CheckedUrb->Finished = TRUE;
+        //
+        // The pending URB is timeout and force stopped when stopping endpoint.
+        // Continue the loop to receive the Command Complete Event for stopping endpoint.
+        //
+        continue;
+
+      case TRB_COMPLETION_SHORT_PACKET:
+      case TRB_COMPLETION_SUCCESS:
+        // MS_CHANGE_161866
+        // if (EvtTrb->Completecode == TRB_COMPLETION_SHORT_PACKET) {
+        // DEBUG ((DEBUG_VERBOSE, "XhcCheckUrbResult: short packet happens!\n"));
+        // }
+        // END
+
+        TRBType = (UINT8)(TRBPtr->Type);
+        if ((TRBType == TRB_TYPE_DATA_STAGE) ||
+            (TRBType == TRB_TYPE_NORMAL) ||
+            (TRBType == TRB_TYPE_ISOCH))
+        {
+          CheckedUrb->Completed += (((TRANSFER_TRB_NORMAL *)TRBPtr)->Length - EvtTrb->Length);
+        }
+
+        break;
+
+      default:
+        DEBUG ((DEBUG_ERROR, "Transfer Default Error Occur! Completecode = 0x%x!\n", EvtTrb->Completecode));
+        CheckedUrb->Result  |= EFI_USB_ERR_TIMEOUT;
+        CheckedUrb->Finished = TRUE;
+        goto EXIT;
+    }
+
+    //
+    // Only check first and end Trb event address
+    //
+    if (TRBPtr == CheckedUrb->TrbStart) {
+      CheckedUrb->StartDone = TRUE;
+    }
+
+    if (TRBPtr == CheckedUrb->TrbEnd) {
+      CheckedUrb->EndDone = TRUE;
+    }
+
+    if (CheckedUrb->StartDone && CheckedUrb->EndDone) {
+      CheckedUrb->Finished = TRUE;
+      CheckedUrb->EvtTrb   = (TRB_TEMPLATE *)EvtTrb;
+    }
+  }
+
+EXIT:
+
+  //
+  // Advance event ring to last available entry
+  //
+  // Some 3rd party XHCI external cards don't support single 64-bytes width register access,
+  // So divide it to two 32-bytes width register access.
+  //
+  Low        = XhcReadRuntimeReg (Xhc, XHC_ERDP_OFFSET);
+  High       = XhcReadRuntimeReg (Xhc, XHC_ERDP_OFFSET + 4);
+  XhcDequeue = (UINT64)(LShiftU64 ((UINT64)High, 32) | Low);
+
+  PhyAddr = UsbHcGetPciAddrForHostAddr (Xhc->MemPool, Xhc->EventRing.EventRingDequeue, sizeof (TRB_TEMPLATE), FALSE);
+
+  if ((XhcDequeue & (~0x0F)) != (PhyAddr & (~0x0F))) {
+    //
+    // Some 3rd party XHCI external cards don't support single 64-bytes width register access,
+    // So divide it to two 32-bytes width register access.
+    //
+    XhcWriteRuntimeReg (Xhc, XHC_ERDP_OFFSET, XHC_LOW_32BIT (PhyAddr) | BIT3);
+    XhcWriteRuntimeReg (Xhc, XHC_ERDP_OFFSET + 4, XHC_HIGH_32BIT (PhyAddr));
+  }
+
+  return Urb->Finished;
+}
+
+/**
+  Execute the transfer by polling the URB. This is a synchronous operation.
+
+  @param  Xhc               The XHCI Instance.
+  @param  CmdTransfer       The executed URB is for cmd transfer or not.
+  @param  Urb               The URB to execute.
+  @param  Timeout           The time to wait before abort, in millisecond.
+
+  @return EFI_DEVICE_ERROR  The transfer failed due to transfer error.
+  @return EFI_TIMEOUT       The transfer failed due to time out.
+  @return EFI_SUCCESS       The transfer finished OK.
+
+**/
+EFI_STATUS
+XhcExecTransfer (
+  IN  USB_XHCI_INSTANCE  *Xhc,
+  IN  BOOLEAN            CmdTransfer,
+  IN  URB                *Urb,
+  IN  UINTN              Timeout
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       SlotId;
+  UINT8       Dci;
+  BOOLEAN     Finished;
+  UINT64      TimeoutTicks;
+  UINT64      ElapsedTicks;
+  UINT64      TicksDelta;
+  UINT64      CurrentTick;
+  BOOLEAN     IndefiniteTimeout;
+
+  Status            = EFI_SUCCESS;
+  Finished          = FALSE;
+  IndefiniteTimeout = FALSE;
+
+  if (CmdTransfer) {
+    SlotId = 0;
+    Dci    = 0;
+  } else {
+    SlotId = XhcBusDevAddrToSlotId (Xhc, Urb->Ep.BusAddr);
+    if (SlotId == 0) {
+      return EFI_DEVICE_ERROR;
+    }
+
+    Dci = XhcEndpointToDci (Urb->Ep.EpAddr, (UINT8)(Urb->Ep.Direction));
+    ASSERT (Dci < 32);
+  }
+
+  if (Timeout == 0) {
+    IndefiniteTimeout = TRUE;
+  }
+
+  XhcRingDoorBell (Xhc, SlotId, Dci);
+
+  TimeoutTicks = XhcConvertTimeToTicks (
+                   XHC_MICROSECOND_TO_NANOSECOND (
+                     Timeout * XHC_1_MILLISECOND
+                     )
+                   );
+  ElapsedTicks = 0;
+  CurrentTick  = GetPerformanceCounter ();
+
+  do {
+    Finished = XhcCheckUrbResult (Xhc, Urb);
+    if (Finished) {
+      break;
+    }
+
+    gBS->Stall (XHC_1_MICROSECOND);
+    TicksDelta = XhcGetElapsedTicks (&CurrentTick);
+    // Ensure that ElapsedTicks is always incremented to avoid indefinite hangs
+    if (TicksDelta == 0) {
+      TicksDelta = XhcConvertTimeToTicks (XHC_MICROSECOND_TO_NANOSECOND (XHC_1_MICROSECOND));
+    }
+
+    ElapsedTicks += TicksDelta;
+  } while (IndefiniteTimeout || ElapsedTicks < TimeoutTicks);
+
+  if (!Finished) {
+    Urb->Result = EFI_USB_ERR_TIMEOUT;
+    Status      = EFI_TIMEOUT;
+  } else if (Urb->Result != EFI_USB_NOERROR) {
+    Status = EFI_DEVICE_ERROR;
+  }
+
+  return Status;
+}
+
+// MU_CHANGE [BEGIN] - Bulk streams
+
+/**
+  Free the rings and the stream context array of the streams of an endpoint.
+
+  @param  Xhc               The XHCI Instance.
+  @param  Streams           The streams to free, may be NULL.
+
+**/
+VOID
+XhcDestroyEndpointStreams (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN ENDPOINT_STREAMS   *Streams
+  )
+{
+  UINTN  StreamId;
+
+  if (Streams == NULL) {
+    return;
+  }
+
+  if (Streams->Rings != NULL) {
+    for (StreamId = 1; StreamId <= Streams->StreamCount; StreamId++) {
+      if (Streams->Rings[StreamId].RingSeg0 != NULL) {
+        UsbHcFreeMem (Xhc->MemPool, Streams->Rings[StreamId].RingSeg0, sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER);
+      }
+    }
+
+    FreePool (Streams->Rings);
+  }
+
+  if (Streams->StreamContextArray != NULL) {
+    UsbHcFreeMem (Xhc->MemPool, Streams->StreamContextArray, Streams->ContextCount * sizeof (STREAM_CONTEXT));
+  }
+
+  FreePool (Streams);
+}
+
+/**
+  Create the streams of an endpoint: a transfer ring for each stream and the
+  stream context array pointing to them.
+
+  @param  Xhc               The XHCI Instance.
+  @param  StreamCount       Number of streams, without the reserved stream 0.
+  @param  ContextCount      Number of entries of the stream context array, a
+                            power of 2 larger than StreamCount.
+
+  @return The created streams or NULL.
+
+**/
+ENDPOINT_STREAMS *
+XhcCreateEndpointStreams (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN UINT16             StreamCount,
+  IN UINTN              ContextCount
+  )
+{
+  ENDPOINT_STREAMS      *Streams;
+  TRANSFER_RING         *Ring;
+  EFI_PHYSICAL_ADDRESS  PhyAddr;
+  UINTN                 StreamId;
+
+  ASSERT (ContextCount > StreamCount);
+
+  Streams = AllocateZeroPool (sizeof (ENDPOINT_STREAMS));
+  if (Streams == NULL) {
+    return NULL;
+  }
+
+  Streams->StreamCount        = StreamCount;
+  Streams->ContextCount       = ContextCount;
+  Streams->Rings              = AllocateZeroPool (ContextCount * sizeof (TRANSFER_RING));
+  Streams->StreamContextArray = UsbHcAllocateMem (Xhc->MemPool, ContextCount * sizeof (STREAM_CONTEXT), FALSE);
+  if ((Streams->Rings == NULL) || (Streams->StreamContextArray == NULL)) {
+    goto ON_ERROR;
+  }
+
+  ZeroMem (Streams->StreamContextArray, ContextCount * sizeof (STREAM_CONTEXT));
+  for (StreamId = 1; StreamId <= StreamCount; StreamId++) {
+    Ring = &Streams->Rings[StreamId];
+    CreateTransferRing (Xhc, TR_RING_TRB_NUMBER, Ring);
+    if (Ring->RingSeg0 == NULL) {
+      goto ON_ERROR;
+    }
+
+    PhyAddr = UsbHcGetPciAddrForHostAddr (
+                Xhc->MemPool,
+                Ring->RingSeg0,
+                sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER,
+                TRUE
+                );
+    Streams->StreamContextArray[StreamId].PtrLo = XHC_LOW_32BIT (PhyAddr) | STREAM_CONTEXT_SCT_PRIMARY_TR | Ring->RingPCS;
+    Streams->StreamContextArray[StreamId].PtrHi = XHC_HIGH_32BIT (PhyAddr);
+  }
+
+  return Streams;
+
+ON_ERROR:
+  XhcDestroyEndpointStreams (Xhc, Streams);
+  return NULL;
+}
+
+/**
+  Free the streams of an endpoint without telling the XHC, when the endpoint
+  context is dropped or initialized again.
+
+  @param  Xhc               The XHCI Instance.
+  @param  SlotId            The slot id of the device.
+  @param  Dci               The device context index of the endpoint.
+
+**/
+VOID
+XhcFreeEndpointStreams (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN UINT8              SlotId,
+  IN UINT8              Dci
+  )
+{
+  XhcDestroyEndpointStreams (Xhc, Xhc->UsbDevContext[SlotId].EndpointStreams[Dci - 1]);
+  Xhc->UsbDevContext[SlotId].EndpointStreams[Dci - 1] = NULL;
+}
+
+/**
+  Get the number of streams of a bulk endpoint in the active setting of a
+  device, from its SuperSpeed Endpoint Companion descriptor.
+
+  @param  Xhc               The XHCI Instance.
+  @param  SlotId            The slot id of the device.
+  @param  EndPointAddress   The endpoint address.
+
+  @return The number of streams, 0 if the endpoint has none.
+
+**/
+UINT32
+XhcGetEndpointMaxStreams (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN UINT8              SlotId,
+  IN UINT8              EndPointAddress
+  )
+{
+  USB_DEV_CONTEXT           *DevContext;
+  USB_CONFIG_DESCRIPTOR     *ConfigDesc;
+  USB_INTERFACE_DESCRIPTOR  *IfDesc;
+  UINT8                     *Desc;
+  UINT8                     *End;
+  BOOLEAN                   Active;
+  UINT8                     MaxStreams;
+
+  DevContext = &Xhc->UsbDevContext[SlotId];
+  if ((DevContext->ConfDesc == NULL) || (DevContext->ActiveConfiguration == 0) ||
+      (DevContext->ActiveConfiguration > DevContext->DevDesc.NumConfigurations))
+  {
+    return 0;
+  }
+
+  ConfigDesc = DevContext->ConfDesc[DevContext->ActiveConfiguration - 1];
+  if (ConfigDesc == NULL) {
+    return 0;
+  }
+
+  Active = FALSE;
+  Desc   = (UINT8 *)ConfigDesc + ConfigDesc->Length;
+  End    = (UINT8 *)ConfigDesc + ConfigDesc->TotalLength;
+  while ((Desc + 2 <= End) && (Desc[0] >= 2) && (Desc + Desc[0] <= End)) {
+    if ((Desc[1] == USB_DESC_TYPE_INTERFACE) && (Desc[0] >= sizeof (USB_INTERFACE_DESCRIPTOR))) {
+      IfDesc = (USB_INTERFACE_DESCRIPTOR *)Desc;
+      Active = (BOOLEAN)(IfDesc->AlternateSetting == DevContext->ActiveAlternateSetting[IfDesc->InterfaceNumber]);
+    } else if (Active && (Desc[1] == USB_DESC_TYPE_ENDPOINT) && (Desc[0] >= sizeof (USB_ENDPOINT_DESCRIPTOR)) &&
+               (((USB_ENDPOINT_DESCRIPTOR *)Desc)->EndpointAddress == EndPointAddress))
+    {
+      //
+      // The companion descriptor follows the endpoint descriptor, its
+      // bmAttributes is the fourth byte.
+      //
+      Desc += Desc[0];
+      if ((Desc + 4 > End) || (Desc[0] < 4) || (Desc[1] != USB_DESC_TYPE_SS_ENDPOINT_COMPANION)) {
+        return 0;
+      }
+
+      MaxStreams = (UINT8)(Desc[3] & USB_SS_COMPANION_MAX_STREAMS_MASK);
+      return (MaxStreams == 0) ? 0 : ((UINT32)1 << MaxStreams);
+    }
+
+    Desc += Desc[0];
+  }
+
+  return 0;
+}
+
+/**
+  Get the device context indexes of enabled bulk endpoints.
+
+  @param  Xhc               The XHCI Instance.
+  @param  SlotId            The slot id of the device.
+  @param  EndpointCount     Number of entries in EndPointAddresses.
+  @param  EndPointAddresses The endpoints.
+  @param  DciMask           Bit n is set for device context index n.
+
+  @retval EFI_SUCCESS           DciMask is returned.
+  @retval EFI_INVALID_PARAMETER An endpoint is not an enabled bulk endpoint.
+
+**/
+EFI_STATUS
+XhcGetBulkDciMask (
+  IN  USB_XHCI_INSTANCE  *Xhc,
+  IN  UINT8              SlotId,
+  IN  UINTN              EndpointCount,
+  IN  UINT8              *EndPointAddresses,
+  OUT UINT32             *DciMask
+  )
+{
+  VOID   *OutputContext;
+  UINTN  Index;
+  UINT8  Dci;
+  UINT8  EPType;
+
+  *DciMask      = 0;
+  OutputContext = Xhc->UsbDevContext[SlotId].OutputContext;
+  for (Index = 0; Index < EndpointCount; Index++) {
+    Dci = XhcEndpointToDci (
+            (UINT8)(EndPointAddresses[Index] & 0x0F),
+            (UINT8)(((EndPointAddresses[Index] & 0x80) != 0) ? EfiUsbDataIn : EfiUsbDataOut)
+            );
+    ASSERT (Dci < 32);
+    if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1] == NULL) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    if (Xhc->HcCParams.Data.Csz == 0) {
+      EPType = (UINT8)((DEVICE_CONTEXT *)OutputContext)->EP[Dci - 1].EPType;
+    } else {
+      EPType = (UINT8)((DEVICE_CONTEXT_64 *)OutputContext)->EP[Dci - 1].EPType;
+    }
+
+    if ((EPType != ED_BULK_IN) && (EPType != ED_BULK_OUT)) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    *DciMask |= (UINT32)1 << Dci;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Give bulk endpoints the same number of streams, or take their streams away,
+  through XHCI's Configure_Endpoint cmd.
+
+  @param  Xhc               The XHCI Instance.
+  @param  SlotId            The slot id of the device.
+  @param  DciMask           The device context indexes of the endpoints.
+  @param  StreamCount       Number of streams of each endpoint, 0 to use the
+                            transfer ring of the endpoint again.
+
+  @retval EFI_SUCCESS           The endpoints are configured.
+  @retval EFI_OUT_OF_RESOURCES  The streams could not be allocated.
+  @retval Others                The Configure_Endpoint cmd failed.
+
+**/
+EFI_STATUS
+XhcConfigEndpointStreams (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN UINT8              SlotId,
+  IN UINT32             DciMask,
+  IN UINT16             StreamCount
+  )
+{
+  ENDPOINT_STREAMS            *Streams[31];
+  VOID                        *InputContext;
+  VOID                        *OutputContext;
+  INPUT_CONTRL_CONTEXT        *InputControl;
+  ENDPOINT_CONTEXT            *InputEp;
+  UINT8                       *InputEps;
+  UINT8                       *OutputEps;
+  UINTN                       InputContextSize;
+  UINTN                       EpContextSize;
+  UINTN                       ContextCount;
+  TRANSFER_RING               *Ring;
+  UINT8                       Dci;
+  EFI_PHYSICAL_ADDRESS        PhyAddr;
+  EFI_STATUS                  Status;
+  CMD_TRB_CONFIG_ENDPOINT     CmdTrbCfgEP;
+  EVT_TRB_COMMAND_COMPLETION  *EvtTrb;
+
+  ZeroMem (Streams, sizeof (Streams));
+
+  //
+  // The Primary Stream Array holds the reserved stream 0 and has at least 4
+  // entries, MaxPStreams 0 meaning no streams.
+  //
+  ContextCount = 0;
+  if (StreamCount != 0) {
+    ContextCount = MAX (4, (UINTN)GetPowerOfTwo32 (StreamCount) << 1);
+  }
+
+  InputContext  = Xhc->UsbDevContext[SlotId].InputContext;
+  OutputContext = Xhc->UsbDevContext[SlotId].OutputContext;
+  if (Xhc->HcCParams.Data.Csz == 0) {
+    InputContextSize = sizeof (INPUT_CONTEXT);
+    EpContextSize    = sizeof (ENDPOINT_CONTEXT);
+    ZeroMem (InputContext, InputContextSize);
+    CopyMem (&((INPUT_CONTEXT *)InputContext)->Slot, &((DEVICE_CONTEXT *)OutputContext)->Slot, sizeof (SLOT_CONTEXT));
+    InputEps  = (UINT8 *)((INPUT_CONTEXT *)InputContext)->EP;
+    OutputEps = (UINT8 *)((DEVICE_CONTEXT *)OutputContext)->EP;
+  } else {
+    InputContextSize = sizeof (INPUT_CONTEXT_64);
+    EpContextSize    = sizeof (ENDPOINT_CONTEXT_64);
+    ZeroMem (InputContext, InputContextSize);
+    CopyMem (&((INPUT_CONTEXT_64 *)InputContext)->Slot, &((DEVICE_CONTEXT_64 *)OutputContext)->Slot, sizeof (SLOT_CONTEXT_64));
+    InputEps  = (UINT8 *)((INPUT_CONTEXT_64 *)InputContext)->EP;
+    OutputEps = (UINT8 *)((DEVICE_CONTEXT_64 *)OutputContext)->EP;
+  }
+
+  //
+  // The 64 byte contexts start with the fields of the 32 byte ones.
+  //
+  InputControl = (INPUT_CONTRL_CONTEXT *)InputContext;
+
+  Status = EFI_SUCCESS;
+  for (Dci = 1; Dci < 32; Dci++) {
+    if ((DciMask & ((UINT32)1 << Dci)) == 0) {
+      continue;
+    }
+
+    //
+    // XHCI 4.3.6, stop the rings affected by the new endpoint context. The
+    // endpoint may be stopped already.
+    //
+    XhcStopEndpoint (Xhc, SlotId, Dci, NULL);
+
+    InputEp = (ENDPOINT_CONTEXT *)(InputEps + (Dci - 1) * EpContextSize);
+    CopyMem (InputEp, OutputEps + (Dci - 1) * EpContextSize, EpContextSize);
+    InputEp->EPState = 0;
+    InputEp->HID     = 0;
+    if (StreamCount != 0) {
+      Streams[Dci - 1] = XhcCreateEndpointStreams (Xhc, StreamCount, ContextCount);
+      if (Streams[Dci - 1] == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        goto ON_EXIT;
+      }
+
+      //
+      // 6.2.3, the TR Dequeue Pointer of an endpoint with streams points to
+      // its linear Primary Stream Array of 2^(MaxPStreams + 1) entries.
+      //
+      PhyAddr = UsbHcGetPciAddrForHostAddr (
+                  Xhc->MemPool,
+                  Streams[Dci - 1]->StreamContextArray,
+                  ContextCount * sizeof (STREAM_CONTEXT),
+                  TRUE
+                  );
+      InputEp->MaxPStreams = (UINT32)HighBitSet32 ((UINT32)ContextCount) - 1;
+      InputEp->LSA         = 1;
+    } else {
+      Ring = (TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1];
+      XhcSyncTrsRing (Xhc, Ring);
+      PhyAddr              = UsbHcGetPciAddrForHostAddr (Xhc->MemPool, Ring->RingEnqueue, sizeof (TRB_TEMPLATE), TRUE);
+      PhyAddr             |= (EFI_PHYSICAL_ADDRESS)Ring->RingPCS;
+      InputEp->MaxPStreams = 0;
+      InputEp->LSA         = 0;
+    }
+
+    InputEp->PtrLo = XHC_LOW_32BIT (PhyAddr);
+    InputEp->PtrHi = XHC_HIGH_32BIT (PhyAddr);
+
+    //
+    // XHCI 4.6.6, a parameter of an enabled endpoint is modified so both the
+    // Drop Context and the Add Context flags are set.
+    //
+    InputControl->Dword1 |= (BIT0 << Dci);
+    InputControl->Dword2 |= (BIT0 << Dci);
+  }
+
+  InputControl->Dword2 |= BIT0;
+
+  ZeroMem (&CmdTrbCfgEP, sizeof (CmdTrbCfgEP));
+  PhyAddr              = UsbHcGetPciAddrForHostAddr (Xhc->MemPool, InputContext, InputContextSize, TRUE);
+  CmdTrbCfgEP.PtrLo    = XHC_LOW_32BIT (PhyAddr);
+  CmdTrbCfgEP.PtrHi    = XHC_HIGH_32BIT (PhyAddr);
+  CmdTrbCfgEP.CycleBit = 1;
+  CmdTrbCfgEP.Type     = TRB_TYPE_CON_ENDPOINT;
+  CmdTrbCfgEP.SlotId   = Xhc->UsbDevContext[SlotId].SlotId;
+  DEBUG ((DEBUG_INFO, "XhcConfigEndpointStreams: Configure Endpoint with %d streams\n", StreamCount));
+  Status = XhcCmdTransfer (
+             Xhc,
+             (TRB_TEMPLATE *)(UINTN)&CmdTrbCfgEP,
+             XHC_GENERIC_TIMEOUT,
+             (TRB_TEMPLATE **)(UINTN)&EvtTrb
+             );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "XhcConfigEndpointStreams: Config Endpoint Failed, Status = %r\n", Status));
+    goto ON_EXIT;
+  }
+
+  //
+  // The XHC uses the new endpoint contexts, the streams they replace can go.
+  //
+  for (Dci = 1; Dci < 32; Dci++) {
+    if ((DciMask & ((UINT32)1 << Dci)) != 0) {
+      XhcFreeEndpointStreams (Xhc, SlotId, Dci);
+      Xhc->UsbDevContext[SlotId].EndpointStreams[Dci - 1] = Streams[Dci - 1];
+      Streams[Dci - 1]                                    = NULL;
+    }
+  }
+
+ON_EXIT:
+  for (Dci = 1; Dci < 32; Dci++) {
+    XhcDestroyEndpointStreams (Xhc, Streams[Dci - 1]);
+  }
+
+  return Status;
+}
+
+/**
+  Allocate the same number of streams on bulk endpoints of a device, through
+  XHCI's Configure_Endpoint cmd.
+
+  @param  Xhc               The XHCI Instance.
+  @param  SlotId            The slot id of the device.
+  @param  EndpointCount     Number of entries in EndPointAddresses.
+  @param  EndPointAddresses The bulk endpoints.
+  @param  StreamCount       Number of streams wanted on input, number of streams
+                            allocated on output.
+
+  @retval EFI_SUCCESS           The streams are allocated.
+  @retval EFI_INVALID_PARAMETER An endpoint is not an enabled bulk endpoint.
+  @retval EFI_UNSUPPORTED       The XHC or an endpoint has no streams.
+  @retval EFI_OUT_OF_RESOURCES  The streams could not be allocated.
+  @retval Others                The Configure_Endpoint cmd failed.
+
+**/
+EFI_STATUS
+XhcEnableStreams (
+  IN     USB_XHCI_INSTANCE  *Xhc,
+  IN     UINT8              SlotId,
+  IN     UINTN              EndpointCount,
+  IN     UINT8              *EndPointAddresses,
+  IN OUT UINT16             *StreamCount
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      DciMask;
+  UINT32      Count;
+  UINT32      MaxStreams;
+  UINTN       Index;
+
+  //
+  // The XHC supports Primary Stream Arrays of 2^(MaxPSASize + 1) entries,
+  // stream 0 being reserved.
+  //
+  if (Xhc->HcCParams.Data.MaxPsaSize == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = XhcGetBulkDciMask (Xhc, SlotId, EndpointCount, EndPointAddresses, &DciMask);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Count = MIN (*StreamCount, ((UINT32)1 << (Xhc->HcCParams.Data.MaxPsaSize + 1)) - 1);
+  for (Index = 0; Index < EndpointCount; Index++) {
+    MaxStreams = XhcGetEndpointMaxStreams (Xhc, SlotId, EndPointAddresses[Index]);
+    if (MaxStreams == 0) {
+      DEBUG ((DEBUG_INFO, "XhcEnableStreams: endpoint %x has no streams\n", EndPointAddresses[Index]));
+      return EFI_UNSUPPORTED;
+    }
+
+    Count = MIN (Count, MaxStreams);
+  }
+
+  Status = XhcConfigEndpointStreams (Xhc, SlotId, DciMask, (UINT16)Count);
+  if (!EFI_ERROR (Status)) {
+    *StreamCount = (UINT16)Count;
+  }
+
+  return Status;
+}
+
+/**
+  Free the streams of bulk endpoints of a device, through XHCI's
+  Configure_Endpoint cmd. The endpoints get their transfer ring back.
+
+  @param  Xhc               The XHCI Instance.
+  @param  SlotId            The slot id of the device.
+  @param  EndpointCount     Number of entries in EndPointAddresses.
+  @param  EndPointAddresses The bulk endpoints.
+
+  @retval EFI_SUCCESS           The streams are freed.
+  @retval EFI_INVALID_PARAMETER An endpoint has no streams.
+  @retval Others                The Configure_Endpoint cmd failed.
+
+**/
+EFI_STATUS
+XhcDisableStreams (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN UINT8              SlotId,
+  IN UINTN              EndpointCount,
+  IN UINT8              *EndPointAddresses
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      DciMask;
+  UINT8       Dci;
+
+  Status = XhcGetBulkDciMask (Xhc, SlotId, EndpointCount, EndPointAddresses, &DciMask);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  for (Dci = 1; Dci < 32; Dci++) {
+    if (((DciMask & ((UINT32)1 << Dci)) != 0) && (Xhc->UsbDevContext[SlotId].EndpointStreams[Dci - 1] == NULL)) {
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  return XhcConfigEndpointStreams (Xhc, SlotId, DciMask, 0);
+}
 
-      case TRB_COMPLETION_USB_TRANSACTION_ERROR:
-        CheckedUrb->Result  |= EFI_USB_ERR_TIMEOUT;
-        CheckedUrb->Finished = TRUE;
-        DEBUG ((DEBUG_ERROR, "XhcCheckUrbResult: TRANSACTION_ERROR! Completecode = %x\n", EvtTrb->Completecode));
-        goto EXIT;
+/**
+  Remove the TDs of a batch left on the stream rings of an endpoint.
 
-      case TRB_COMPLETION_STOPPED:
-      case TRB_COMPLETION_STOPPED_LENGTH_INVALID:
-        CheckedUrb->Result  |= EFI_USB_ERR_TIMEOUT;
-        CheckedUrb->Finished = TRUE;
-        //
-        // The pending URB is timeout and force stopped when stopping endpoint.
-        // Continue the loop to receive the Command Complete Event for stopping endpoint.
-        //
-        continue;
+  A halted endpoint is reset and a running one is stopped, then the dequeue
+  pointer of each stream ring with a transfer of the batch which did not
+  finish OK is moved past the TDs of the batch. The doorbell is rung once all
+  the rings are set, as the endpoint must stay stopped until then.
 
-      case TRB_COMPLETION_SHORT_PACKET:
-      case TRB_COMPLETION_SUCCESS:
-        // MS_CHANGE_161866
-        // if (EvtTrb->Completecode == TRB_COMPLETION_SHORT_PACKET) {
-        // DEBUG ((DEBUG_VERBOSE, "XhcCheckUrbResult: short packet happens!\n"));
-        // }
-        // END
+  @param  Xhc               The XHCI Instance.
+  @param  SlotId            The slot id of the device.
+  @param  Dci               The device context index of the endpoint.
+  @param  Urbs              The URBs of the batch.
+  @param  UrbCount          Number of entries in Urbs.
 
-        TRBType = (UINT8)(TRBPtr->Type);
-        if ((TRBType == TRB_TYPE_DATA_STAGE) ||
-            (TRBType == TRB_TYPE_NORMAL) ||
-            (TRBType == TRB_TYPE_ISOCH))
-        {
-          CheckedUrb->Completed += (((TRANSFER_TRB_NORMAL *)TRBPtr)->Length - EvtTrb->Length);
-        }
+**/
+VOID
+XhcDequeueStreamTrbs (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN UINT8              SlotId,
+  IN UINT8              Dci,
+  IN URB                **Urbs,
+  IN UINTN              UrbCount
+  )
+{
+  URB         *Urb;
+  UINTN       Index;
+  UINTN       Other;
+  UINT16      StreamId;
+  BOOLEAN     Halted;
+  EFI_STATUS  Status;
 
-        break;
+  Halted = FALSE;
+  for (Index = 0; Index < UrbCount; Index++) {
+    Urb = Urbs[Index];
+    if ((XhcEndpointToDci (Urb->Ep.EpAddr, (UINT8)(Urb->Ep.Direction)) == Dci) &&
+        ((Urb->Result == EFI_USB_ERR_STALL) || (Urb->Result == EFI_USB_ERR_BABBLE)))
+    {
+      Halted = TRUE;
+    }
+  }
 
-      default:
-        DEBUG ((DEBUG_ERROR, "Transfer Default Error Occur! Completecode = 0x%x!\n", EvtTrb->Completecode));
-        CheckedUrb->Result  |= EFI_USB_ERR_TIMEOUT;
-        CheckedUrb->Finished = TRUE;
-        goto EXIT;
+  if (Halted) {
+    Status = XhcResetEndpoint (Xhc, SlotId, Dci);
+  } else {
+    Status = XhcStopEndpoint (Xhc, SlotId, Dci, NULL);
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "XhcDequeueStreamTrbs: failed to stop Dci %d, Status = %r\n", Dci, Status));
+    return;
+  }
+
+  StreamId = 0;
+  for (Index = 0; Index < UrbCount; Index++) {
+    Urb = Urbs[Index];
+    if ((XhcEndpointToDci (Urb->Ep.EpAddr, (UINT8)(Urb->Ep.Direction)) != Dci) ||
+        (Urb->Finished && (Urb->Result == EFI_USB_NOERROR)))
+    {
+      continue;
     }
 
     //
-    // Only check first and end Trb event address
+    // Only the first such URB of a ring moves its dequeue pointer.
     //
-    if (TRBPtr == CheckedUrb->TrbStart) {
-      CheckedUrb->StartDone = TRUE;
+    for (Other = 0; Other < Index; Other++) {
+      if ((Urbs[Other]->Ring == Urb->Ring) &&
+          !(Urbs[Other]->Finished && (Urbs[Other]->Result == EFI_USB_NOERROR)))
+      {
+        break;
+      }
     }
 
-    if (TRBPtr == CheckedUrb->TrbEnd) {
-      CheckedUrb->EndDone = TRUE;
+    if (Other < Index) {
+      continue;
     }
 
-    if (CheckedUrb->StartDone && CheckedUrb->EndDone) {
-      CheckedUrb->Finished = TRUE;
-      CheckedUrb->EvtTrb   = (TRB_TEMPLATE *)EvtTrb;
+    Status = XhcSetTrDequeuePointer (Xhc, SlotId, Dci, Urb);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "XhcDequeueStreamTrbs: Set Transfer Ring Dequeue Pointer Failed, Status = %r\n", Status));
     }
-  }
-
-EXIT:
 
-  //
-  // Advance event ring to last available entry
-  //
-  // Some 3rd party XHCI external cards don't support single 64-bytes width register access,
-  // So divide it to two 32-bytes width register access.
-  //
-  Low        = XhcReadRuntimeReg (Xhc, XHC_ERDP_OFFSET);
-  High       = XhcReadRuntimeReg (Xhc, XHC_ERDP_OFFSET + 4);
-  XhcDequeue = (UINT64)(LShiftU64 ((UINT64)High, 32) | Low);
-
-  PhyAddr = UsbHcGetPciAddrForHostAddr (Xhc->MemPool, Xhc->EventRing.EventRingDequeue, sizeof (TRB_TEMPLATE), FALSE);
-
-  if ((XhcDequeue & (~0x0F)) != (PhyAddr & (~0x0F))) {
-    //
-    // Some 3rd party XHCI external cards don't support single 64-bytes width register access,
-    // So divide it to two 32-bytes width register access.
-    //
-    XhcWriteRuntimeReg (Xhc, XHC_ERDP_OFFSET, XHC_LOW_32BIT (PhyAddr) | BIT3);
-    XhcWriteRuntimeReg (Xhc, XHC_ERDP_OFFSET + 4, XHC_HIGH_32BIT (PhyAddr));
+    StreamId = Urb->StreamId;
   }
 
-  return Urb->Finished;
+  if (StreamId != 0) {
+    XhcRingStreamDoorBell (Xhc, SlotId, Dci, StreamId);
+  }
 }
 
+// MU_CHANGE [END] - Bulk streams
+
+// MU_CHANGE [BEGIN] - Batched bulk transfers
+
 /**
-  Execute the transfer by polling the URB. This is a synchronous operation.
+  Execute a batch of bulk transfers by polling the URBs. This is a synchronous
+  operation.
+
+  The TDs of all the transfers are put on the transfer rings before the
+  doorbell of each endpoint, or of each stream of an endpoint, is rung once,
+  the completion events are then harvested from the event ring for all the
+  URBs of the batch. When a transfer fails, the batch times out or optional
+  transfers are left once the others are done, the TDs left on the rings are
+  removed.
 
   @param  Xhc               The XHCI Instance.
-  @param  CmdTransfer       The executed URB is for cmd transfer or not.
-  @param  Urb               The URB to execute.
+  @param  BusAddr           The logical device address assigned by UsbBus driver.
+  @param  DevSpeed          The device speed.
+  @param  RequestCount      Number of entries in Requests.
+  @param  Requests          The transfers to execute.
   @param  Timeout           The time to wait before abort, in millisecond.
 
-  @return EFI_DEVICE_ERROR  The transfer failed due to transfer error.
-  @return EFI_TIMEOUT       The transfer failed due to time out.
-  @return EFI_SUCCESS       The transfer finished OK.
+  @return EFI_INVALID_PARAMETER The batch does not fit on the transfer rings,
+                                or names streams the endpoints do not have.
+  @return EFI_OUT_OF_RESOURCES  Some transfers could not be queued.
+  @return EFI_DEVICE_ERROR      A transfer failed due to transfer error.
+  @return EFI_TIMEOUT           The batch failed due to time out.
+  @return EFI_SUCCESS           All the transfers finished OK.
 
 **/
 EFI_STATUS
-XhcExecTransfer (
-  IN  USB_XHCI_INSTANCE  *Xhc,
-  IN  BOOLEAN            CmdTransfer,
-  IN  URB                *Urb,
-  IN  UINTN              Timeout
+XhcExecBulkBatch (
+  IN     USB_XHCI_INSTANCE             *Xhc,
+  IN     UINT8                         BusAddr,
+  IN     UINT8                         DevSpeed,
+  IN     UINTN                         RequestCount,
+  IN OUT EDKII_USB_BULK_BATCH_REQUEST  *Requests,
+  IN     UINTN                         Timeout
   )
 {
-  EFI_STATUS  Status;
-  UINT8       SlotId;
-  UINT8       Dci;
-  BOOLEAN     Finished;
-  UINT64      TimeoutTicks;
-  UINT64      ElapsedTicks;
-  UINT64      TicksDelta;
-  UINT64      CurrentTick;
-  BOOLEAN     IndefiniteTimeout;
+  EDKII_USB_BULK_BATCH_REQUEST  *Request;
+  URB                           **Urbs;
+  URB                           *Urb;
+  ENDPOINT_STREAMS              *Streams;
+  BOOLEAN                       *Pending;
+  UINTN                         TrbCount;
+  UINT32                        DciMask;
+  UINTN                         Queued;
+  UINTN                         Index;
+  UINTN                         Other;
+  UINT8                         SlotId;
+  UINT8                         Dci;
+  BOOLEAN                       Failed;
+  BOOLEAN                       TimedOut;
+  BOOLEAN                       Cancel;
+  EFI_STATUS                    Status;
+  EFI_STATUS                    RecoveryStatus;
+  UINT64                        TimeoutTicks;
+  UINT64                        ElapsedTicks;
+  UINT64                        TicksDelta;
+  UINT64                        CurrentTick;
+
+  SlotId = XhcBusDevAddrToSlotId (Xhc, BusAddr);
+  if (SlotId == 0) {
+    return EFI_DEVICE_ERROR;
+  }
 
-  Status            = EFI_SUCCESS;
-  Finished          = FALSE;
-  IndefiniteTimeout = FALSE;
+  //
+  // All the TDs of a transfer ring must fit on it at once, a bulk TD takes
+  // one TRB per 64KB of data and the ring ends with a link TRB. An endpoint
+  // with streams has a ring per stream.
+  //
+  for (Index = 0; Index < RequestCount; Index++) {
+    Request = &Requests[Index];
+    Dci     = XhcEndpointToDci (
+                (UINT8)(Request->EndPointAddress & 0x0F),
+                (UINT8)(((Request->EndPointAddress & 0x80) != 0) ? EfiUsbDataIn : EfiUsbDataOut)
+                );
+    ASSERT (Dci < 32);
+    Streams = (ENDPOINT_STREAMS *)Xhc->UsbDevContext[SlotId].EndpointStreams[Dci - 1];
+    if (((Streams == NULL) && (Request->StreamId != 0)) ||
+        ((Streams != NULL) && ((Request->StreamId == 0) || (Request->StreamId > Streams->StreamCount))))
+    {
+      DEBUG ((DEBUG_ERROR, "XhcExecBulkBatch: Dci %d has no stream %d\n", Dci, Request->StreamId));
+      return EFI_INVALID_PARAMETER;
+    }
 
-  if (CmdTransfer) {
-    SlotId = 0;
-    Dci    = 0;
-  } else {
-    SlotId = XhcBusDevAddrToSlotId (Xhc, Urb->Ep.BusAddr);
-    if (SlotId == 0) {
-      return EFI_DEVICE_ERROR;
+    TrbCount = 0;
+    for (Other = 0; Other <= Index; Other++) {
+      if ((Requests[Other].EndPointAddress == Request->EndPointAddress) &&
+          (Requests[Other].StreamId == Request->StreamId))
+      {
+        TrbCount += (Requests[Other].DataLength - 1) / 0x10000 + 1;
+      }
     }
 
-    Dci = XhcEndpointToDci (Urb->Ep.EpAddr, (UINT8)(Urb->Ep.Direction));
-    ASSERT (Dci < 32);
+    if (TrbCount >= TR_RING_TRB_NUMBER - 1) {
+      DEBUG ((DEBUG_ERROR, "XhcExecBulkBatch: batch does not fit on the ring of Dci %d\n", Dci));
+      return EFI_INVALID_PARAMETER;
+    }
   }
 
-  if (Timeout == 0) {
-    IndefiniteTimeout = TRUE;
+  Urbs    = AllocateZeroPool (RequestCount * sizeof (URB *));
+  Pending = AllocateZeroPool (RequestCount * sizeof (BOOLEAN));
+  if ((Urbs == NULL) || (Pending == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto FREE_POOLS;
   }
 
-  XhcRingDoorBell (Xhc, SlotId, Dci);
+  //
+  // Put the TDs of all the transfers on the rings.
+  //
+  DciMask = 0;
+  for (Queued = 0; Queued < RequestCount; Queued++) {
+    Request = &Requests[Queued];
+    Urb     = XhcCreateStreamUrb (
+                Xhc,
+                BusAddr,
+                Request->EndPointAddress,
+                DevSpeed,
+                Request->MaximumPacketLength,
+                Request->StreamId,
+                Request->Data,
+                Request->DataLength
+                );
+    if (Urb == NULL) {
+      DEBUG ((DEBUG_ERROR, "XhcExecBulkBatch: failed to create URB %d of %d!\n", Queued, RequestCount));
+      break;
+    }
+
+    Urbs[Queued] = Urb;
+    InsertTailList (&Xhc->BatchTransfers, &Urb->UrbList);
+    DciMask |= (UINT32)1 << XhcEndpointToDci (Urb->Ep.EpAddr, (UINT8)(Urb->Ep.Direction));
+  }
+
+  //
+  // Ring the doorbell of each ring once.
+  //
+  for (Index = 0; Index < Queued; Index++) {
+    for (Other = 0; Other < Index; Other++) {
+      if (Urbs[Other]->Ring == Urbs[Index]->Ring) {
+        break;
+      }
+    }
+
+    if (Other == Index) {
+      Urb = Urbs[Index];
+      XhcRingStreamDoorBell (
+        Xhc,
+        SlotId,
+        XhcEndpointToDci (Urb->Ep.EpAddr, (UINT8)(Urb->Ep.Direction)),
+        Urb->StreamId
+        );
+    }
+  }
 
+  //
+  // Poll until all the URBs which are not optional are finished or one of
+  // the URBs failed.
+  //
+  Failed       = FALSE;
+  TimedOut     = FALSE;
+  Cancel       = FALSE;
   TimeoutTicks = XhcConvertTimeToTicks (
                    XHC_MICROSECOND_TO_NANOSECOND (
                      Timeout * XHC_1_MILLISECOND
@@ -1357,11 +2283,27 @@ XhcExecTransfer (
   CurrentTick  = GetPerformanceCounter ();
 
   do {
-    Finished = XhcCheckUrbResult (Xhc, Urb);
-    if (Finished) {
+    Urb = NULL;
+    for (Index = 0; Index < Queued; Index++) {
+      if (Urbs[Index]->Result != EFI_USB_NOERROR) {
+        Failed = TRUE;
+        break;
+      }
+
+      if (!Urbs[Index]->Finished && !Requests[Index].Optional && (Urb == NULL)) {
+        Urb = Urbs[Index];
+      }
+    }
+
+    if (Failed || (Urb == NULL)) {
       break;
     }
 
+    //
+    // The events of the other URBs of the batch are handled as well.
+    //
+    XhcCheckUrbResult (Xhc, Urb);
+
     gBS->Stall (XHC_1_MICROSECOND);
     TicksDelta = XhcGetElapsedTicks (&CurrentTick);
     // Ensure that ElapsedTicks is always incremented to avoid indefinite hangs
@@ -1370,18 +2312,131 @@ XhcExecTransfer (
     }
 
     ElapsedTicks += TicksDelta;
-  } while (IndefiniteTimeout || ElapsedTicks < TimeoutTicks);
+  } while ((Timeout == 0) || (ElapsedTicks < TimeoutTicks));
+
+  for (Index = 0; Index < Queued; Index++) {
+    if (Urbs[Index]->Result != EFI_USB_NOERROR) {
+      Failed = TRUE;
+    } else if (!Urbs[Index]->Finished) {
+      Pending[Index] = TRUE;
+      Cancel         = TRUE;
+      if (!Requests[Index].Optional) {
+        TimedOut = TRUE;
+      }
+    }
+  }
 
-  if (!Finished) {
-    Urb->Result = EFI_USB_ERR_TIMEOUT;
-    Status      = EFI_TIMEOUT;
-  } else if (Urb->Result != EFI_USB_NOERROR) {
+  TimedOut = (BOOLEAN)(TimedOut && !Failed);
+
+  //
+  // Remove the TDs left on the rings. A halted endpoint is recovered, which
+  // also drops its TDs. On a running endpoint the TDs are dequeued from the
+  // first unfinished one, retrying with the next one if it completed just
+  // before the endpoint was stopped. The rings of an endpoint with streams
+  // are handled together.
+  //
+  if (Failed || Cancel) {
+    for (Dci = 1; Dci < 32; Dci++) {
+      if ((DciMask & ((UINT32)1 << Dci)) == 0) {
+        continue;
+      }
+
+      if (Xhc->UsbDevContext[SlotId].EndpointStreams[Dci - 1] != NULL) {
+        XhcDequeueStreamTrbs (Xhc, SlotId, Dci, Urbs, Queued);
+        continue;
+      }
+
+      for (Index = 0; Index < Queued; Index++) {
+        Urb = Urbs[Index];
+        if (XhcEndpointToDci (Urb->Ep.EpAddr, (UINT8)(Urb->Ep.Direction)) != Dci) {
+          continue;
+        }
+
+        if ((Urb->Result == EFI_USB_ERR_STALL) || (Urb->Result == EFI_USB_ERR_BABBLE)) {
+          RecoveryStatus = XhcRecoverHaltedEndpoint (Xhc, Urb);
+          if (EFI_ERROR (RecoveryStatus)) {
+            DEBUG ((DEBUG_ERROR, "XhcExecBulkBatch: XhcRecoverHaltedEndpoint failed!\n"));
+          }
+
+          break;
+        }
+
+        if (!Urb->Finished) {
+          RecoveryStatus = XhcDequeueTrbFromEndpoint (Xhc, Urb);
+          if (RecoveryStatus == EFI_ALREADY_STARTED) {
+            continue;
+          }
+
+          if (EFI_ERROR (RecoveryStatus)) {
+            DEBUG ((DEBUG_ERROR, "XhcExecBulkBatch: XhcDequeueTrbFromEndpoint failed!\n"));
+          }
+
+          break;
+        }
+      }
+    }
+  }
+
+  //
+  // Report the result of each transfer. A transfer still pending above was
+  // cancelled, unless it completed while its endpoint was stopped.
+  //
+  for (Index = 0; Index < RequestCount; Index++) {
+    Request = &Requests[Index];
+    if (Index >= Queued) {
+      Request->DataLength     = 0;
+      Request->TransferResult = EFI_USB_ERR_NOTEXECUTE;
+      Request->Status         = EFI_OUT_OF_RESOURCES;
+      continue;
+    }
+
+    Urb                     = Urbs[Index];
+    Request->DataLength     = Urb->Completed;
+    Request->TransferResult = Urb->Result;
+    if (Urb->Finished && (Urb->Result == EFI_USB_NOERROR)) {
+      Request->Status = EFI_SUCCESS;
+    } else if (Pending[Index] && TimedOut) {
+      Request->TransferResult = EFI_USB_ERR_TIMEOUT;
+      Request->Status         = EFI_TIMEOUT;
+    } else if (Pending[Index]) {
+      Request->TransferResult = EFI_USB_ERR_NOTEXECUTE;
+      Request->Status         = EFI_ABORTED;
+    } else {
+      Request->Status = EFI_DEVICE_ERROR;
+    }
+
+    RemoveEntryList (&Urb->UrbList);
+  }
+
+  Xhc->PciIo->Flush (Xhc->PciIo);
+  for (Index = 0; Index < Queued; Index++) {
+    XhcFreeUrb (Xhc, Urbs[Index]);
+  }
+
+  if (Failed) {
     Status = EFI_DEVICE_ERROR;
+  } else if (TimedOut) {
+    Status = EFI_TIMEOUT;
+  } else if (Queued < RequestCount) {
+    Status = EFI_OUT_OF_RESOURCES;
+  } else {
+    Status = EFI_SUCCESS;
+  }
+
+FREE_POOLS:
+  if (Urbs != NULL) {
+    FreePool (Urbs);
+  }
+
+  if (Pending != NULL) {
+    FreePool (Pending);
   }
 
   return Status;
 }
 
+// MU_CHANGE [END] - Batched bulk transfers
+
 /**
   Delete a single asynchronous interrupt transfer for
   the device and endpoint.
@@ -2128,6 +3183,33 @@ RingIntTransferDoorBell (
   return EFI_SUCCESS;
 }
 
+// MU_CHANGE [BEGIN] - Bulk streams
+
+/**
+  Ring the door bell of a stream of an endpoint.
+
+  @param  Xhc           The XHCI Instance.
+  @param  SlotId        The slot id of the target device.
+  @param  Dci           The device context index of the target endpoint.
+  @param  StreamId      The stream to ring, 0 if the endpoint has no streams.
+
+  @retval EFI_SUCCESS   Successfully ring the door bell.
+
+**/
+EFI_STATUS
+XhcRingStreamDoorBell (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN UINT8              SlotId,
+  IN UINT8              Dci,
+  IN UINT16             StreamId
+  )
+{
+  XhcWriteDoorBellReg (Xhc, SlotId * sizeof (UINT32), Dci | ((UINT32)StreamId << 16));
+  return EFI_SUCCESS;
+}
+
+// MU_CHANGE [END] - Bulk streams
+
 /**
   Set Command abort
 
@@ -2685,6 +3767,7 @@ XhcDisableSlotCmd (
   // Free the slot related data structure
   //
   for (Index = 0; Index < 31; Index++) {
+    XhcFreeEndpointStreams (Xhc, SlotId, (UINT8)(Index + 1)); // MU_CHANGE - Bulk streams
     if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index] != NULL) {
       RingSeg = ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index])->RingSeg0;
       if (RingSeg != NULL) {
@@ -2796,6 +3879,7 @@ XhcDisableSlotCmd64 (
   // Free the slot related data structure
   //
   for (Index = 0; Index < 31; Index++) {
+    XhcFreeEndpointStreams (Xhc, SlotId, (UINT8)(Index + 1)); // MU_CHANGE - Bulk streams
     if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index] != NULL) {
       RingSeg = ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index])->RingSeg0;
       if (RingSeg != NULL) {
@@ -2919,6 +4003,10 @@ XhcInitializeEndpointContext (
         }
 
         InputContext->EP[Dci-1].AverageTRBLength = 0x1000;
+        //
+        // The endpoint context is initialized without streams.
+        //
+        XhcFreeEndpointStreams (Xhc, SlotId, Dci); // MU_CHANGE - Bulk streams
         if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci-1] == NULL) {
           EndpointTransferRing                                   = AllocateZeroPool (sizeof (TRANSFER_RING));
           Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci-1] = (VOID *)EndpointTransferRing;
@@ -3122,6 +4210,10 @@ XhcInitializeEndpointContext64 (
         }
 
         InputContext->EP[Dci-1].AverageTRBLength = 0x1000;
+        //
+        // The endpoint context is initialized without streams.
+        //
+        XhcFreeEndpointStreams (Xhc, SlotId, Dci); // MU_CHANGE - Bulk streams
         if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci-1] == NULL) {
           EndpointTransferRing                                   = AllocateZeroPool (sizeof (TRANSFER_RING));
           Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci-1] = (VOID *)EndpointTransferRing;
@@ -3583,6 +4675,13 @@ XhcSetTrDequeuePointer (
   CmdSetTRDeq.Type     = TRB_TYPE_SET_TR_DEQUE;
   CmdSetTRDeq.Endpoint = Dci;
   CmdSetTRDeq.SlotId   = SlotId;
+  // MU_CHANGE [BEGIN] - Bulk streams
+  if (Urb->StreamId != 0) {
+    CmdSetTRDeq.PtrLo   |= STREAM_CONTEXT_SCT_PRIMARY_TR;
+    CmdSetTRDeq.StreamID = Urb->StreamId;
+  }
+
+  // MU_CHANGE [END] - Bulk streams
   Status               = XhcCmdTransfer (
                            Xhc,
                            (TRB_TEMPLATE *)(UINTN)&CmdSetTRDeq,
@@ -3737,6 +4836,7 @@ XhcSetInterface (
       // XHCI 4.3.6 - Setting Alternate Interfaces
       // 2) Free Transfer Rings of all endpoints that will be affected by the Alternate Interface setting.
       //
+      XhcFreeEndpointStreams (Xhc, SlotId, Dci); // MU_CHANGE - Bulk streams
       if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1] != NULL) {
         RingSeg = ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1])->RingSeg0;
         if (RingSeg != NULL) {
@@ -3943,6 +5043,7 @@ XhcSetInterface64 (
       // XHCI 4.3.6 - Setting Alternate Interfaces
       // 2) Free Transfer Rings of all endpoints that will be affected by the Alternate Interface setting.
       //
+      XhcFreeEndpointStreams (Xhc, SlotId, Dci); // MU_CHANGE - Bulk streams
       if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1] != NULL) {
         RingSeg = ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1])->RingSeg0;
         if (RingSeg != NULL) {
@@ -193,6 +193,12 @@ typedef struct _URB {
   BOOLEAN                            Finished;
 
   TRB_TEMPLATE                       *EvtTrb;
+  // MU_CHANGE [BEGIN] - Bulk streams
+  //
+  // Stream of a bulk transfer, 0 if the endpoint has no streams.
+  //
+  UINT16                             StreamId;
+  // MU_CHANGE [END] - Bulk streams
 } URB;
 
 //
@@ -754,6 +760,50 @@ typedef struct _INPUT_CONTEXT_64 {
   ENDPOINT_CONTEXT_64        EP[31];
 } INPUT_CONTEXT_64;
 
+// MU_CHANGE [BEGIN] - Bulk streams
+
+//
+// 6.2.4.1 Stream Context
+// The TR Dequeue Pointer field is combined with the DCS bit and the Stream
+// Context Type (SCT) in PtrLo.
+//
+typedef struct _STREAM_CONTEXT {
+  UINT32    PtrLo;
+
+  UINT32    PtrHi;
+
+  UINT32    StoppedEDTLA : 24;
+  UINT32    RsvdZ1       : 8;
+
+  UINT32    RsvdZ2;
+} STREAM_CONTEXT;
+
+//
+// Table 6-9, SCT of a stream context pointing to a transfer ring.
+//
+#define STREAM_CONTEXT_SCT_PRIMARY_TR  (1 << 1)
+
+//
+// The streams of a bulk endpoint, referenced by the endpoint context through
+// a linear Primary Stream Array. Stream 0 is reserved, so a ring is allocated
+// for streams 1 to StreamCount.
+//
+typedef struct _ENDPOINT_STREAMS {
+  UINT16            StreamCount;
+  UINTN             ContextCount;
+  STREAM_CONTEXT    *StreamContextArray;
+  TRANSFER_RING     *Rings;
+} ENDPOINT_STREAMS;
+
+//
+// SuperSpeed Endpoint Companion descriptor, its bmAttributes gives the
+// number of streams of a bulk endpoint as a power of 2.
+//
+#define USB_DESC_TYPE_SS_ENDPOINT_COMPANION  0x30
+#define USB_SS_COMPANION_MAX_STREAMS_MASK    0x1F
+
+// MU_CHANGE [END] - Bulk streams
+
 /**
   Initialize the XHCI host controller for schedule.
 
@@ -812,6 +862,107 @@ XhcExecTransfer (
   IN  UINTN              Timeout
   );
 
+// MU_CHANGE [BEGIN] - Batched bulk transfers
+
+/**
+  Execute a batch of bulk transfers by polling the URBs. This is a synchronous
+  operation.
+
+  @param  Xhc               The XHCI Instance.
+  @param  BusAddr           The logical device address assigned by UsbBus driver.
+  @param  DevSpeed          The device speed.
+  @param  RequestCount      Number of entries in Requests.
+  @param  Requests          The transfers to execute.
+  @param  Timeout           The time to wait before abort, in millisecond.
+
+  @return EFI_INVALID_PARAMETER The batch does not fit on the transfer rings.
+  @return EFI_OUT_OF_RESOURCES  Some transfers could not be queued.
+  @return EFI_DEVICE_ERROR      A transfer failed due to transfer error.
+  @return EFI_TIMEOUT           The batch failed due to time out.
+  @return EFI_SUCCESS           All the transfers finished OK.
+
+**/
+EFI_STATUS
+XhcExecBulkBatch (
+  IN     USB_XHCI_INSTANCE             *Xhc,
+  IN     UINT8                         BusAddr,
+  IN     UINT8                         DevSpeed,
+  IN     UINTN                         RequestCount,
+  IN OUT EDKII_USB_BULK_BATCH_REQUEST  *Requests,
+  IN     UINTN                         Timeout
+  );
+
+// MU_CHANGE [END] - Batched bulk transfers
+
+// MU_CHANGE [BEGIN] - Bulk streams
+
+/**
+  Allocate the same number of streams on bulk endpoints of a device, through
+  XHCI's Configure_Endpoint cmd.
+
+  @param  Xhc               The XHCI Instance.
+  @param  SlotId            The slot id of the device.
+  @param  EndpointCount     Number of entries in EndPointAddresses.
+  @param  EndPointAddresses The bulk endpoints.
+  @param  StreamCount       Number of streams wanted on input, number of streams
+                            allocated on output.
+
+  @retval EFI_SUCCESS           The streams are allocated.
+  @retval EFI_INVALID_PARAMETER An endpoint is not an enabled bulk endpoint.
+  @retval EFI_UNSUPPORTED       The XHC or an endpoint has no streams.
+  @retval EFI_OUT_OF_RESOURCES  The streams could not be allocated.
+  @retval Others                The Configure_Endpoint cmd failed.
+
+**/
+EFI_STATUS
+XhcEnableStreams (
+  IN     USB_XHCI_INSTANCE  *Xhc,
+  IN     UINT8              SlotId,
+  IN     UINTN              EndpointCount,
+  IN     UINT8              *EndPointAddresses,
+  IN OUT UINT16             *StreamCount
+  );
+
+/**
+  Free the streams of bulk endpoints of a device, through XHCI's
+  Configure_Endpoint cmd. The endpoints get their transfer ring back.
+
+  @param  Xhc               The XHCI Instance.
+  @param  SlotId            The slot id of the device.
+  @param  EndpointCount     Number of entries in EndPointAddresses.
+  @param  EndPointAddresses The bulk endpoints.
+
+  @retval EFI_SUCCESS           The streams are freed.
+  @retval EFI_INVALID_PARAMETER An endpoint has no streams.
+  @retval Others                The Configure_Endpoint cmd failed.
+
+**/
+EFI_STATUS
+XhcDisableStreams (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN UINT8              SlotId,
+  IN UINTN              EndpointCount,
+  IN UINT8              *EndPointAddresses
+  );
+
+/**
+  Free the streams of an endpoint without telling the XHC, when the endpoint
+  context is dropped or initialized again.
+
+  @param  Xhc               The XHCI Instance.
+  @param  SlotId            The slot id of the device.
+  @param  Dci               The device context index of the endpoint.
+
+**/
+VOID
+XhcFreeEndpointStreams (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN UINT8              SlotId,
+  IN UINT8              Dci
+  );
+
+// MU_CHANGE [END] - Bulk streams
+
 /**
   Delete a single asynchronous interrupt transfer for
   the device and endpoint.
@@ -941,6 +1092,29 @@ XhcRingDoorBell (
   IN UINT8              Dci
   );
 
+// MU_CHANGE [BEGIN] - Bulk streams
+
+/**
+  Ring the door bell of a stream of an endpoint.
+
+  @param  Xhc           The XHCI Instance.
+  @param  SlotId        The slot id of the target device.
+  @param  Dci           The device context index of the target endpoint.
+  @param  StreamId      The stream to ring, 0 if the endpoint has no streams.
+
+  @retval EFI_SUCCESS   Successfully ring the door bell.
+
+**/
+EFI_STATUS
+XhcRingStreamDoorBell (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN UINT8              SlotId,
+  IN UINT8              Dci,
+  IN UINT16             StreamId
+  );
+
+// MU_CHANGE [END] - Bulk streams
+
 /**
   Interrupt transfer periodic check handler.
 
@@ -1445,6 +1619,37 @@ XhcCreateUrb (
   IN VOID                             *Context
   );
 
+// MU_CHANGE [BEGIN] - Bulk streams
+
+/**
+  Create a new URB for a bulk transfer on a stream of an endpoint.
+
+  @param  Xhc       The XHCI Instance
+  @param  BusAddr   The logical device address assigned by UsbBus driver
+  @param  EpAddr    Endpoint addrress
+  @param  DevSpeed  The device speed
+  @param  MaxPacket The max packet length of the endpoint
+  @param  StreamId  The stream of the transfer, 0 if the endpoint has no streams
+  @param  Data      The user data to transfer
+  @param  DataLen   The length of data buffer
+
+  @return Created URB or NULL
+
+**/
+URB *
+XhcCreateStreamUrb (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN UINT8              BusAddr,
+  IN UINT8              EpAddr,
+  IN UINT8              DevSpeed,
+  IN UINTN              MaxPacket,
+  IN UINT16             StreamId,
+  IN VOID               *Data,
+  IN UINTN              DataLen
+  );
+
+// MU_CHANGE [END] - Bulk streams
+
 /**
   Free an allocated URB.
 
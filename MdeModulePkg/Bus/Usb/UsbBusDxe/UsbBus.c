@@ -328,6 +328,270 @@ ON_EXIT:
   return Status;
 }
 
+// MU_CHANGE [BEGIN] - Batched bulk transfers
+
+/**
+  Execute a batch of bulk transfers to the device endpoints.
+
+  @param  This                   The USB bulk batch instance.
+  @param  RequestCount           Number of entries in Requests.
+  @param  Requests               The transfers to execute.
+  @param  Timeout                Time to wait before timeout.
+
+  @retval EFI_SUCCESS            All the bulk transfers are OK.
+  @retval EFI_INVALID_PARAMETER  Some parameters are invalid.
+  @retval Others                 Failed to execute the batch, the result of each
+                                 transfer is returned in its request.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbIoBulkBatchTransfer (
+  IN     EDKII_USB_IO_BULK_BATCH_PROTOCOL  *This,
+  IN     UINTN                             RequestCount,
+  IN OUT EDKII_USB_BULK_BATCH_REQUEST      *Requests,
+  IN     UINTN                             Timeout
+  )
+{
+  USB_DEVICE         *Dev;
+  USB_INTERFACE      *UsbIf;
+  USB_ENDPOINT_DESC  *EpDesc;
+  UINTN              Index;
+  UINT8              Endpoint;
+  EFI_TPL            OldTpl;
+  EFI_STATUS         Status;
+
+  if ((Requests == NULL) || (RequestCount == 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  for (Index = 0; Index < RequestCount; Index++) {
+    Endpoint = Requests[Index].EndPointAddress;
+    if ((USB_ENDPOINT_ADDR (Endpoint) == 0) || (USB_ENDPOINT_ADDR (Endpoint) > 15)) {
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  OldTpl = gBS->RaiseTPL (USB_BUS_TPL);
+
+  UsbIf = USB_INTERFACE_FROM_BULK_BATCH (This);
+  Dev   = UsbIf->Device;
+
+  if (Dev->Connected == FALSE) {
+    Status = EFI_DEVICE_ERROR;
+    DEBUG ((DEBUG_ERROR, "UsbIoBulkBatchTransfer No media\n"));
+    goto ON_EXIT;
+  }
+
+  for (Index = 0; Index < RequestCount; Index++) {
+    EpDesc = UsbGetEndpointDesc (UsbIf, Requests[Index].EndPointAddress);
+
+    if ((EpDesc == NULL) || (USB_ENDPOINT_TYPE (&EpDesc->Desc) != USB_ENDPOINT_BULK)) {
+      Status = EFI_INVALID_PARAMETER;
+      goto ON_EXIT;
+    }
+
+    Requests[Index].MaximumPacketLength = EpDesc->Desc.MaxPacketSize;
+  }
+
+  //
+  // The batch is only supported by XHCI, which manages the data toggles itself.
+  //
+  Status = Dev->Bus->Usb2HcBulkBatch->BulkTransfer (
+                                        Dev->Bus->Usb2HcBulkBatch,
+                                        Dev->Address,
+                                        Dev->Speed,
+                                        RequestCount,
+                                        Requests,
+                                        Timeout,
+                                        &Dev->Translator
+                                        );
+
+  if (EFI_ERROR (Status)) {
+    //
+    // Clear TT buffer when CTRL/BULK split transaction failes.
+    // Clear the TRANSLATOR TT buffer, not parent's buffer
+    //
+    ASSERT (Dev->Translator.TranslatorHubAddress < Dev->Bus->MaxDevices);
+    if (Dev->Translator.TranslatorHubAddress != 0) {
+      UsbHubCtrlClearTTBuffer (
+        Dev->Bus->Devices[Dev->Translator.TranslatorHubAddress],
+        Dev->Translator.TranslatorPortNumber,
+        Dev->Address,
+        0,
+        USB_ENDPOINT_BULK
+        );
+    }
+  }
+
+ON_EXIT:
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+// MU_CHANGE [END] - Batched bulk transfers
+
+// MU_CHANGE [BEGIN] - Bulk streams
+
+/**
+  Check that endpoints are bulk endpoints of the USB interface.
+
+  @param  UsbIf                  The USB interface.
+  @param  EndpointCount          Number of entries in EndPointAddresses.
+  @param  EndPointAddresses      The endpoints.
+
+  @retval EFI_SUCCESS            The endpoints are bulk endpoints of UsbIf.
+  @retval EFI_INVALID_PARAMETER  Some endpoints are not.
+
+**/
+EFI_STATUS
+UsbCheckBulkEndpoints (
+  IN USB_INTERFACE  *UsbIf,
+  IN UINTN          EndpointCount,
+  IN UINT8          *EndPointAddresses
+  )
+{
+  USB_ENDPOINT_DESC  *EpDesc;
+  UINTN              Index;
+
+  for (Index = 0; Index < EndpointCount; Index++) {
+    EpDesc = UsbGetEndpointDesc (UsbIf, EndPointAddresses[Index]);
+    if ((EpDesc == NULL) || (USB_ENDPOINT_TYPE (&EpDesc->Desc) != USB_ENDPOINT_BULK)) {
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Allocate streams on bulk endpoints of the USB interface.
+
+  @param  This                   The USB bulk batch instance.
+  @param  EndpointCount          Number of entries in EndPointAddresses.
+  @param  EndPointAddresses      The bulk endpoints.
+  @param  StreamCount            Number of streams wanted on input, number of
+                                 streams allocated on output.
+
+  @retval EFI_SUCCESS            The streams are allocated.
+  @retval EFI_INVALID_PARAMETER  Some parameters are invalid.
+  @retval Others                 Failed to allocate the streams.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbIoAllocateStreams (
+  IN     EDKII_USB_IO_BULK_BATCH_PROTOCOL  *This,
+  IN     UINTN                             EndpointCount,
+  IN     UINT8                             *EndPointAddresses,
+  IN OUT UINT16                            *StreamCount
+  )
+{
+  USB_DEVICE     *Dev;
+  USB_INTERFACE  *UsbIf;
+  EFI_TPL        OldTpl;
+  EFI_STATUS     Status;
+
+  if ((EndPointAddresses == NULL) || (EndpointCount == 0) || (StreamCount == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl = gBS->RaiseTPL (USB_BUS_TPL);
+
+  UsbIf = USB_INTERFACE_FROM_BULK_BATCH (This);
+  Dev   = UsbIf->Device;
+
+  if (Dev->Connected == FALSE) {
+    Status = EFI_DEVICE_ERROR;
+    DEBUG ((DEBUG_ERROR, "UsbIoAllocateStreams No media\n"));
+    goto ON_EXIT;
+  }
+
+  //
+  // Only SuperSpeed bulk endpoints have streams.
+  //
+  if (Dev->Speed != EFI_USB_SPEED_SUPER) {
+    Status = EFI_UNSUPPORTED;
+    goto ON_EXIT;
+  }
+
+  Status = UsbCheckBulkEndpoints (UsbIf, EndpointCount, EndPointAddresses);
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  Status = Dev->Bus->Usb2HcBulkBatch->AllocateStreams (
+                                        Dev->Bus->Usb2HcBulkBatch,
+                                        Dev->Address,
+                                        EndpointCount,
+                                        EndPointAddresses,
+                                        StreamCount
+                                        );
+
+ON_EXIT:
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+/**
+  Free the streams of bulk endpoints of the USB interface.
+
+  @param  This                   The USB bulk batch instance.
+  @param  EndpointCount          Number of entries in EndPointAddresses.
+  @param  EndPointAddresses      The bulk endpoints.
+
+  @retval EFI_SUCCESS            The streams are freed.
+  @retval EFI_INVALID_PARAMETER  Some parameters are invalid.
+  @retval Others                 Failed to free the streams.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbIoFreeStreams (
+  IN EDKII_USB_IO_BULK_BATCH_PROTOCOL  *This,
+  IN UINTN                             EndpointCount,
+  IN UINT8                             *EndPointAddresses
+  )
+{
+  USB_DEVICE     *Dev;
+  USB_INTERFACE  *UsbIf;
+  EFI_TPL        OldTpl;
+  EFI_STATUS     Status;
+
+  if ((EndPointAddresses == NULL) || (EndpointCount == 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl = gBS->RaiseTPL (USB_BUS_TPL);
+
+  UsbIf = USB_INTERFACE_FROM_BULK_BATCH (This);
+  Dev   = UsbIf->Device;
+
+  if (Dev->Connected == FALSE) {
+    Status = EFI_DEVICE_ERROR;
+    DEBUG ((DEBUG_ERROR, "UsbIoFreeStreams No media\n"));
+    goto ON_EXIT;
+  }
+
+  Status = UsbCheckBulkEndpoints (UsbIf, EndpointCount, EndPointAddresses);
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  Status = Dev->Bus->Usb2HcBulkBatch->FreeStreams (
+                                        Dev->Bus->Usb2HcBulkBatch,
+                                        Dev->Address,
+                                        EndpointCount,
+                                        EndPointAddresses
+                                        );
+
+ON_EXIT:
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+// MU_CHANGE [END] - Bulk streams
+
 /**
   Execute a synchronous interrupt transfer.
 
@@ -1102,6 +1366,25 @@ UsbBusBuildProtocol (
     if (UsbBus->Usb2Hc->MajorRevision == 0x3) {
       UsbBus->MaxDevices = 256;
     }
+
+    // MU_CHANGE [BEGIN] - Batched bulk transfers
+    //
+    // The batch protocol is optional, it is installed and uninstalled with
+    // the USB2_HC protocol, which is opened by driver.
+    //
+    Status = gBS->OpenProtocol (
+                    Controller,
+                    &gEdkiiUsb2HcBulkBatchProtocolGuid,
+                    (VOID **)&(UsbBus->Usb2HcBulkBatch),
+                    This->DriverBindingHandle,
+                    Controller,
+                    EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                    );
+    if (EFI_ERROR (Status)) {
+      UsbBus->Usb2HcBulkBatch = NULL;
+    }
+
+    // MU_CHANGE [END] - Batched bulk transfers
   }
 
   //
@@ -15,6 +15,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/Usb2HostController.h>
 #include <Protocol/UsbHostController.h>
 #include <Protocol/UsbIo.h>
+#include <Protocol/UsbBulkBatch.h> // MU_CHANGE - Batched bulk transfers
 #include <Protocol/DevicePath.h>
 
 #include <Library/BaseLib.h>
@@ -141,6 +142,11 @@ typedef struct _USB_HUB_API    USB_HUB_API;
 #define USB_INTERFACE_FROM_USBIO(a) \
           CR(a, USB_INTERFACE, UsbIo, USB_INTERFACE_SIGNATURE)
 
+// MU_CHANGE [BEGIN] - Batched bulk transfers
+#define USB_INTERFACE_FROM_BULK_BATCH(a) \
+          CR(a, USB_INTERFACE, BulkBatch, USB_INTERFACE_SIGNATURE)
+// MU_CHANGE [END] - Batched bulk transfers
+
 #define USB_BUS_FROM_THIS(a) \
           CR(a, USB_BUS, BusId, USB_BUS_SIGNATURE)
 
@@ -208,6 +214,12 @@ struct _USB_INTERFACE {
   EFI_USB_IO_PROTOCOL         UsbIo;
   EFI_DEVICE_PATH_PROTOCOL    *DevicePath;
   BOOLEAN                     IsManaged;
+  // MU_CHANGE [BEGIN] - Batched bulk transfers
+  //
+  // Installed only when the host controller supports batched bulk transfers.
+  //
+  EDKII_USB_IO_BULK_BATCH_PROTOCOL    BulkBatch;
+  // MU_CHANGE [END] - Batched bulk transfers
 
   //
   // Hub device special data
@@ -246,6 +258,9 @@ struct _USB_BUS {
   EFI_DEVICE_PATH_PROTOCOL    *DevicePath;
   EFI_USB2_HC_PROTOCOL        *Usb2Hc;
   EFI_USB_HC_PROTOCOL         *UsbHc;
+  // MU_CHANGE [BEGIN] - Batched bulk transfers
+  EDKII_USB2_HC_BULK_BATCH_PROTOCOL    *Usb2HcBulkBatch;
+  // MU_CHANGE [END] - Batched bulk transfers
 
   //
   // Recorded the max supported usb devices.
@@ -421,6 +436,80 @@ UsbIoBulkTransfer (
   OUT UINT32               *UsbStatus
   );
 
+// MU_CHANGE [BEGIN] - Batched bulk transfers
+
+/**
+  Execute a batch of bulk transfers to the device endpoints.
+
+  @param  This                   The USB bulk batch instance.
+  @param  RequestCount           Number of entries in Requests.
+  @param  Requests               The transfers to execute.
+  @param  Timeout                Time to wait before timeout.
+
+  @retval EFI_SUCCESS            All the bulk transfers are OK.
+  @retval EFI_INVALID_PARAMETER  Some parameters are invalid.
+  @retval Others                 Failed to execute the batch, the result of each
+                                 transfer is returned in its request.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbIoBulkBatchTransfer (
+  IN     EDKII_USB_IO_BULK_BATCH_PROTOCOL  *This,
+  IN     UINTN                             RequestCount,
+  IN OUT EDKII_USB_BULK_BATCH_REQUEST      *Requests,
+  IN     UINTN                             Timeout
+  );
+
+// MU_CHANGE [END] - Batched bulk transfers
+
+// MU_CHANGE [BEGIN] - Bulk streams
+
+/**
+  Allocate streams on bulk endpoints of the USB interface.
+
+  @param  This                   The USB bulk batch instance.
+  @param  EndpointCount          Number of entries in EndPointAddresses.
+  @param  EndPointAddresses      The bulk endpoints.
+  @param  StreamCount            Number of streams wanted on input, number of
+                                 streams allocated on output.
+
+  @retval EFI_SUCCESS            The streams are allocated.
+  @retval EFI_INVALID_PARAMETER  Some parameters are invalid.
+  @retval Others                 Failed to allocate the streams.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbIoAllocateStreams (
+  IN     EDKII_USB_IO_BULK_BATCH_PROTOCOL  *This,
+  IN     UINTN                             EndpointCount,
+  IN     UINT8                             *EndPointAddresses,
+  IN OUT UINT16                            *StreamCount
+  );
+
+/**
+  Free the streams of bulk endpoints of the USB interface.
+
+  @param  This                   The USB bulk batch instance.
+  @param  EndpointCount          Number of entries in EndPointAddresses.
+  @param  EndPointAddresses      The bulk endpoints.
+
+  @retval EFI_SUCCESS            The streams are freed.
+  @retval EFI_INVALID_PARAMETER  Some parameters are invalid.
+  @retval Others                 Failed to free the streams.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbIoFreeStreams (
+  IN EDKII_USB_IO_BULK_BATCH_PROTOCOL  *This,
+  IN UINTN                             EndpointCount,
+  IN UINT8                             *EndPointAddresses
+  );
+
+// MU_CHANGE [END] - Bulk streams
+
 /**
   Execute a synchronous interrupt transfer.
 
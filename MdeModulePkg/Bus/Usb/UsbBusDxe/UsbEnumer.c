@@ -58,6 +58,17 @@ UsbFreeInterface (
 
   UsbCloseHostProtoByChild (UsbIf->Device->Bus, UsbIf->Handle);
 
+  // MU_CHANGE [BEGIN] - Batched bulk transfers
+  if (UsbIf->BulkBatch.BulkTransfer != NULL) {
+    gBS->UninstallProtocolInterface (
+           UsbIf->Handle,
+           &gEdkiiUsbIoBulkBatchProtocolGuid,
+           &UsbIf->BulkBatch
+           );
+  }
+
+  // MU_CHANGE [END] - Batched bulk transfers
+
   Status = gBS->UninstallMultipleProtocolInterfaces (
                   UsbIf->Handle,
                   &gEfiDevicePathProtocolGuid,
@@ -74,6 +85,17 @@ UsbFreeInterface (
     FreePool (UsbIf);
   } else {
     UsbOpenHostProtoByChild (UsbIf->Device->Bus, UsbIf->Handle);
+    // MU_CHANGE [BEGIN] - Batched bulk transfers
+    if (UsbIf->BulkBatch.BulkTransfer != NULL) {
+      gBS->InstallProtocolInterface (
+             &UsbIf->Handle,
+             &gEdkiiUsbIoBulkBatchProtocolGuid,
+             EFI_NATIVE_INTERFACE,
+             &UsbIf->BulkBatch
+             );
+    }
+
+    // MU_CHANGE [END] - Batched bulk transfers
   }
 
   return Status;
@@ -173,6 +195,28 @@ UsbCreateInterface (
     goto ON_ERROR;
   }
 
+  // MU_CHANGE [BEGIN] - Batched bulk transfers
+  //
+  // Let the class drivers batch their bulk transfers when the host controller
+  // supports it. This is optional, the interface works without it.
+  //
+  if (Device->Bus->Usb2HcBulkBatch != NULL) {
+    UsbIf->BulkBatch.BulkTransfer    = UsbIoBulkBatchTransfer;
+    UsbIf->BulkBatch.AllocateStreams = UsbIoAllocateStreams; // MU_CHANGE - Bulk streams
+    UsbIf->BulkBatch.FreeStreams     = UsbIoFreeStreams;     // MU_CHANGE - Bulk streams
+    Status                           = gBS->InstallProtocolInterface (
+                                              &UsbIf->Handle,
+                                              &gEdkiiUsbIoBulkBatchProtocolGuid,
+                                              EFI_NATIVE_INTERFACE,
+                                              &UsbIf->BulkBatch
+                                              );
+    if (EFI_ERROR (Status)) {
+      UsbIf->BulkBatch.BulkTransfer = NULL;
+    }
+  }
+
+  // MU_CHANGE [END] - Batched bulk transfers
+
   return UsbIf;
 
 ON_ERROR:
@@ -0,0 +1,1447 @@
+/** @file -- UsbMassUasUnitTest.c
+  Host based unit tests for the USB Attached SCSI transport of the USB mass
+  storage driver.
+
+  The transport runs on top of a mock USB I/O protocol which emulates a UAS
+  device, and of a mock bulk batch protocol for the SuperSpeed flavour of the
+  device, whose status and data pipes have streams. The device completes the
+  queued commands in the reverse order they were sent, so the tests can check
+  the tagging of the commands and their out-of-order completion.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../UsbMass.h"
+
+#define UNIT_TEST_APP_NAME     "USB Mass Storage UAS Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define MOCK_BLOCK_SIZE  512
+
+#define MOCK_EP_DATA_IN   0x81
+#define MOCK_EP_DATA_OUT  0x02
+#define MOCK_EP_STATUS    0x83
+#define MOCK_EP_COMMAND   0x04
+
+#define MOCK_UAS_SETTING  1
+
+//
+// Streams of the SuperSpeed pipes, as a power of two in the companion
+// descriptors.
+//
+#define MOCK_MAX_STREAMS_EXPONENT  5
+#define MOCK_MAX_STREAMS           (1 << MOCK_MAX_STREAMS_EXPONENT)
+
+//
+// SCSI status and sense key reported for the failing LBA.
+//
+#define MOCK_CHECK_CONDITION  0x02
+#define MOCK_SENSE_KEY        0x03
+
+typedef struct {
+  UINT16    Tag;
+  UINT8     Cdb[USB_UAS_MAX_CDBLEN];
+  BOOLEAN   DataDone;
+} MOCK_UAS_COMMAND;
+
+typedef struct {
+  EFI_USB_IO_PROTOCOL    UsbIo;
+  UINT8                  *Config;
+  UINTN                  ConfigLength;
+  UINT8                  AlternateSetting;
+  //
+  // Commands queued on the device, in the order they were received.
+  //
+  MOCK_UAS_COMMAND       Queue[USB_UAS_MAX_COMMANDS];
+  UINTN                  QueueCount;
+  //
+  // Index in Queue of the command the device is ready to transfer data for.
+  //
+  UINTN                  ReadyIndex;
+  //
+  // Tags of all the command IUs and of the SENSE IUs, in order.
+  //
+  UINT16                 SentTags[32];
+  UINTN                  SentCount;
+  UINT16                 CompletedTags[32];
+  UINTN                  CompletedCount;
+  //
+  // Faults to inject.
+  //
+  UINT32                 FailLba;
+  BOOLEAN                BadTag;
+  //
+  // Device accesses.
+  //
+  UINTN                  ControlTransfers;
+  UINTN                  BulkCalls;
+  UINTN                  PortResets;
+  UINT8                  Disk[16 * MOCK_BLOCK_SIZE];
+  //
+  // Bulk batch protocol of the host controller, and the streams it allocated
+  // on the pipes, up to MaxStreams.
+  //
+  EDKII_USB_IO_BULK_BATCH_PROTOCOL    BulkBatch;
+  BOOLEAN                             HasBulkBatch;
+  UINT16                              MaxStreams;
+  UINT16                              StreamCount;
+  UINTN                               StreamAllocations;
+  UINTN                               BatchCalls;
+} MOCK_USB_IO;
+
+STATIC MOCK_USB_IO       mMockUsbIo;
+STATIC USB_UAS_PROTOCOL  *mUsbUas;
+
+//
+// Default setting with the Bulk-Only Transport, then the UAS setting with its
+// four pipes.
+//
+STATIC UINT8  mMockConfig[] = {
+  0x09, USB_DESC_TYPE_CONFIG,    0x00,               0x00, 0x01, 0x01, 0x00, 0x80, 0x32,
+  0x09, USB_DESC_TYPE_INTERFACE, 0x00,               0x00, 0x02, 0x08, 0x06, 0x50, 0x00,
+  0x07, USB_DESC_TYPE_ENDPOINT,  MOCK_EP_DATA_IN,    0x02, 0x00, 0x02, 0x00,
+  0x07, USB_DESC_TYPE_ENDPOINT,  MOCK_EP_DATA_OUT,   0x02, 0x00, 0x02, 0x00,
+  0x09, USB_DESC_TYPE_INTERFACE, 0x00,               MOCK_UAS_SETTING, 0x04, 0x08, 0x06, 0x62, 0x00,
+  0x07, USB_DESC_TYPE_ENDPOINT,  MOCK_EP_COMMAND,    0x02, 0x00, 0x02, 0x00,
+  0x04, USB_UAS_DESC_TYPE_PIPE_USAGE, USB_UAS_PIPE_COMMAND, 0x00,
+  0x07, USB_DESC_TYPE_ENDPOINT,  MOCK_EP_STATUS,     0x02, 0x00, 0x02, 0x00,
+  0x04, USB_UAS_DESC_TYPE_PIPE_USAGE, USB_UAS_PIPE_STATUS, 0x00,
+  0x07, USB_DESC_TYPE_ENDPOINT,  MOCK_EP_DATA_IN,    0x02, 0x00, 0x02, 0x00,
+  0x04, USB_UAS_DESC_TYPE_PIPE_USAGE, USB_UAS_PIPE_DATA_IN, 0x00,
+  0x07, USB_DESC_TYPE_ENDPOINT,  MOCK_EP_DATA_OUT,   0x02, 0x00, 0x02, 0x00,
+  0x04, USB_UAS_DESC_TYPE_PIPE_USAGE, USB_UAS_PIPE_DATA_OUT, 0x00
+};
+
+//
+// The same interface on SuperSpeed, each endpoint followed by its companion
+// descriptor. The status and data pipes of the UAS setting have streams.
+//
+STATIC UINT8  mMockStreamsConfig[] = {
+  0x09, USB_DESC_TYPE_CONFIG,    0x00,               0x00, 0x01, 0x01, 0x00, 0x80, 0x32,
+  0x09, USB_DESC_TYPE_INTERFACE, 0x00,               0x00, 0x02, 0x08, 0x06, 0x50, 0x00,
+  0x07, USB_DESC_TYPE_ENDPOINT,  MOCK_EP_DATA_IN,    0x02, 0x00, 0x04, 0x00,
+  0x06, USB_UAS_DESC_TYPE_SS_COMPANION, 0x00, 0x00, 0x00, 0x00,
+  0x07, USB_DESC_TYPE_ENDPOINT,  MOCK_EP_DATA_OUT,   0x02, 0x00, 0x04, 0x00,
+  0x06, USB_UAS_DESC_TYPE_SS_COMPANION, 0x00, 0x00, 0x00, 0x00,
+  0x09, USB_DESC_TYPE_INTERFACE, 0x00,               MOCK_UAS_SETTING, 0x04, 0x08, 0x06, 0x62, 0x00,
+  0x07, USB_DESC_TYPE_ENDPOINT,  MOCK_EP_COMMAND,    0x02, 0x00, 0x04, 0x00,
+  0x06, USB_UAS_DESC_TYPE_SS_COMPANION, 0x00, 0x00, 0x00, 0x00,
+  0x04, USB_UAS_DESC_TYPE_PIPE_USAGE, USB_UAS_PIPE_COMMAND, 0x00,
+  0x07, USB_DESC_TYPE_ENDPOINT,  MOCK_EP_STATUS,     0x02, 0x00, 0x04, 0x00,
+  0x06, USB_UAS_DESC_TYPE_SS_COMPANION, 0x00, MOCK_MAX_STREAMS_EXPONENT, 0x00, 0x00,
+  0x04, USB_UAS_DESC_TYPE_PIPE_USAGE, USB_UAS_PIPE_STATUS, 0x00,
+  0x07, USB_DESC_TYPE_ENDPOINT,  MOCK_EP_DATA_IN,    0x02, 0x00, 0x04, 0x00,
+  0x06, USB_UAS_DESC_TYPE_SS_COMPANION, 0x00, MOCK_MAX_STREAMS_EXPONENT, 0x00, 0x00,
+  0x04, USB_UAS_DESC_TYPE_PIPE_USAGE, USB_UAS_PIPE_DATA_IN, 0x00,
+  0x07, USB_DESC_TYPE_ENDPOINT,  MOCK_EP_DATA_OUT,   0x02, 0x00, 0x04, 0x00,
+  0x06, USB_UAS_DESC_TYPE_SS_COMPANION, 0x00, MOCK_MAX_STREAMS_EXPONENT, 0x00, 0x00,
+  0x04, USB_UAS_DESC_TYPE_PIPE_USAGE, USB_UAS_PIPE_DATA_OUT, 0x00
+};
+
+/**
+  Stub of the stall clearing of UsbMassBoot.c, which isn't part of the test.
+
+  @param  UsbIo                  The USB I/O Protocol instance
+  @param  EndpointAddr           The endpoint to clear stall for
+
+  @retval EFI_SUCCESS            The endpoint stall condition is cleared.
+**/
+EFI_STATUS
+UsbClearEndpointStall (
+  IN EFI_USB_IO_PROTOCOL  *UsbIo,
+  IN UINT8                EndpointAddr
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the lookup of the bulk batch protocol of UsbMassBot.c, which isn't
+  part of the test.
+
+  @param  UsbIo                 The USB I/O Protocol instance
+
+  @return The mock bulk batch protocol, or NULL if the host controller doesn't
+          have one.
+**/
+EDKII_USB_IO_BULK_BATCH_PROTOCOL *
+UsbBotGetBulkBatch (
+  IN  EFI_USB_IO_PROTOCOL  *UsbIo
+  )
+{
+  if (!mMockUsbIo.HasBulkBatch) {
+    return NULL;
+  }
+
+  return &mMockUsbIo.BulkBatch;
+}
+
+/**
+  Return the LBA and the number of blocks of a READ(10) or WRITE(10) CDB.
+
+  @param[in]   Cdb     The CDB.
+  @param[out]  Count   The number of blocks.
+
+  @return The first block.
+**/
+STATIC
+UINT32
+MockCdbLba (
+  IN  UINT8   *Cdb,
+  OUT UINT32  *Count
+  )
+{
+  *Count = SwapBytes16 (ReadUnaligned16 ((UINT16 *)&Cdb[7]));
+  return SwapBytes32 (ReadUnaligned32 ((UINT32 *)&Cdb[2]));
+}
+
+/**
+  Mock of the control transfers, handling the GET_DESCRIPTOR requests of the
+  configuration descriptor and SET_INTERFACE.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockUsbControlTransfer (
+  IN     EFI_USB_IO_PROTOCOL     *This,
+  IN     EFI_USB_DEVICE_REQUEST  *Request,
+  IN     EFI_USB_DATA_DIRECTION  Direction,
+  IN     UINT32                  Timeout,
+  IN OUT VOID                    *Data OPTIONAL,
+  IN     UINTN                   DataLength OPTIONAL,
+  OUT    UINT32                  *Status
+  )
+{
+  mMockUsbIo.ControlTransfers++;
+  *Status = EFI_USB_NOERROR;
+
+  if ((Request->Request == USB_REQ_GET_DESCRIPTOR) && (Request->Value == (USB_DESC_TYPE_CONFIG << 8))) {
+    CopyMem (Data, mMockUsbIo.Config, MIN (DataLength, mMockUsbIo.ConfigLength));
+    return EFI_SUCCESS;
+  }
+
+  if ((Request->Request == USB_REQ_SET_INTERFACE) && (Request->Index == 0) && (Request->Value <= MOCK_UAS_SETTING)) {
+    //
+    // The host controller configures the endpoints of the setting without
+    // streams.
+    //
+    mMockUsbIo.AlternateSetting = (UINT8)Request->Value;
+    mMockUsbIo.StreamCount      = 0;
+    return EFI_SUCCESS;
+  }
+
+  *Status = EFI_USB_ERR_STALL;
+  return EFI_DEVICE_ERROR;
+}
+
+/**
+  Build the next IU of the status pipe. The most recent command goes first,
+  with a READ READY or WRITE READY IU if it has data left to transfer,
+  otherwise with its SENSE IU.
+
+  @param[out]  Iu      The buffer of the IU.
+  @param[out]  Length  The length of the IU.
+
+  @retval EFI_SUCCESS  The IU is built.
+  @retval EFI_TIMEOUT  No command is queued on the device.
+**/
+STATIC
+EFI_STATUS
+MockUasStatusIu (
+  OUT UINT8  *Iu,
+  OUT UINTN  *Length
+  )
+{
+  MOCK_UAS_COMMAND  *Command;
+  USB_UAS_SENSE_IU  *SenseIu;
+  UINT32            Lba;
+  UINT32            Count;
+
+  if (mMockUsbIo.QueueCount == 0) {
+    return EFI_TIMEOUT;
+  }
+
+  mMockUsbIo.ReadyIndex = mMockUsbIo.QueueCount - 1;
+  Command               = &mMockUsbIo.Queue[mMockUsbIo.ReadyIndex];
+  SenseIu               = (USB_UAS_SENSE_IU *)Iu;
+  ZeroMem (SenseIu, sizeof (USB_UAS_SENSE_IU));
+  SenseIu->Header.Tag = SwapBytes16 (Command->Tag);
+  if (mMockUsbIo.BadTag) {
+    SenseIu->Header.Tag = SwapBytes16 ((UINT16)(Command->Tag + 0x100));
+  }
+
+  Lba = MockCdbLba (Command->Cdb, &Count);
+  if (!Command->DataDone && (Lba != mMockUsbIo.FailLba)) {
+    SenseIu->Header.IuId = (Command->Cdb[0] == USB_BOOT_READ10_OPCODE) ? USB_UAS_IU_READ_READY : USB_UAS_IU_WRITE_READY;
+    *Length              = sizeof (USB_UAS_IU_HEADER);
+    return EFI_SUCCESS;
+  }
+
+  SenseIu->Header.IuId = USB_UAS_IU_SENSE;
+  *Length              = OFFSET_OF (USB_UAS_SENSE_IU, SenseData);
+  if (Lba == mMockUsbIo.FailLba) {
+    SenseIu->Status       = MOCK_CHECK_CONDITION;
+    SenseIu->Length       = SwapBytes16 (18);
+    SenseIu->SenseData[0] = 0x70;
+    SenseIu->SenseData[2] = MOCK_SENSE_KEY;
+    SenseIu->SenseData[7] = 10;
+    *Length              += 18;
+  }
+
+  mMockUsbIo.CompletedTags[mMockUsbIo.CompletedCount++] = Command->Tag;
+  mMockUsbIo.QueueCount--;
+  return EFI_SUCCESS;
+}
+
+/**
+  Queue a command IU received on the command pipe.
+
+  @param[in]  CommandIu  The command IU.
+  @param[in]  Length     The length of the IU.
+
+  @retval EFI_SUCCESS       The command is queued.
+  @retval EFI_DEVICE_ERROR  The IU is invalid or the queue is full.
+**/
+STATIC
+EFI_STATUS
+MockUasQueueCommand (
+  IN USB_UAS_COMMAND_IU  *CommandIu,
+  IN UINTN               Length
+  )
+{
+  MOCK_UAS_COMMAND  *Command;
+
+  if ((Length != sizeof (USB_UAS_COMMAND_IU)) || (CommandIu->Header.IuId != USB_UAS_IU_COMMAND) ||
+      (mMockUsbIo.QueueCount == USB_UAS_MAX_COMMANDS))
+  {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Command      = &mMockUsbIo.Queue[mMockUsbIo.QueueCount++];
+  Command->Tag = SwapBytes16 (CommandIu->Header.Tag);
+  CopyMem (Command->Cdb, CommandIu->Cdb, sizeof (Command->Cdb));
+  Command->DataDone = FALSE;
+  if (mMockUsbIo.SentCount < ARRAY_SIZE (mMockUsbIo.SentTags)) {
+    mMockUsbIo.SentTags[mMockUsbIo.SentCount++] = Command->Tag;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Move the data of the command the device is ready for.
+
+  @param[in]      Endpoint  The data in or data out pipe.
+  @param[in, out] Data      The data buffer.
+  @param[in]      Length    The length of the data.
+
+  @retval EFI_SUCCESS       The data is moved.
+  @retval EFI_DEVICE_ERROR  The transfer doesn't match the command.
+**/
+STATIC
+EFI_STATUS
+MockUasDataTransfer (
+  IN     UINT8  Endpoint,
+  IN OUT VOID   *Data,
+  IN     UINTN  Length
+  )
+{
+  MOCK_UAS_COMMAND  *Command;
+  UINT32            Lba;
+  UINT32            Count;
+
+  Command = &mMockUsbIo.Queue[mMockUsbIo.ReadyIndex];
+  Lba     = MockCdbLba (Command->Cdb, &Count);
+  if ((mMockUsbIo.QueueCount == 0) || Command->DataDone || (Length != Count * MOCK_BLOCK_SIZE) ||
+      ((Lba + Count) * MOCK_BLOCK_SIZE > sizeof (mMockUsbIo.Disk)))
+  {
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (Endpoint == MOCK_EP_DATA_IN) {
+    CopyMem (Data, &mMockUsbIo.Disk[Lba * MOCK_BLOCK_SIZE], Length);
+  } else {
+    CopyMem (&mMockUsbIo.Disk[Lba * MOCK_BLOCK_SIZE], Data, Length);
+  }
+
+  Command->DataDone = TRUE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock of the bulk transfers on the four pipes of the UAS setting.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockUsbBulkTransfer (
+  IN     EFI_USB_IO_PROTOCOL  *This,
+  IN     UINT8                DeviceEndpoint,
+  IN OUT VOID                 *Data,
+  IN OUT UINTN                *DataLength,
+  IN     UINTN                Timeout,
+  OUT    UINT32               *Status
+  )
+{
+  EFI_STATUS  Result;
+
+  mMockUsbIo.BulkCalls++;
+  *Status = EFI_USB_NOERROR;
+
+  if (mMockUsbIo.AlternateSetting != MOCK_UAS_SETTING) {
+    *Status = EFI_USB_ERR_STALL;
+    return EFI_DEVICE_ERROR;
+  }
+
+  switch (DeviceEndpoint) {
+    case MOCK_EP_COMMAND:
+      Result = MockUasQueueCommand (Data, *DataLength);
+      break;
+
+    case MOCK_EP_STATUS:
+      return MockUasStatusIu (Data, DataLength);
+
+    case MOCK_EP_DATA_IN:
+    case MOCK_EP_DATA_OUT:
+      Result = MockUasDataTransfer (DeviceEndpoint, Data, *DataLength);
+      break;
+
+    default:
+      Result = EFI_DEVICE_ERROR;
+      break;
+  }
+
+  if (EFI_ERROR (Result)) {
+    *Status = EFI_USB_ERR_STALL;
+  }
+
+  return Result;
+}
+
+/**
+  Find the pending transfer of a batch on a stream of a pipe.
+
+  @param[in]  Requests      The transfers of the batch.
+  @param[in]  RequestCount  The number of transfers.
+  @param[in]  Endpoint      The pipe.
+  @param[in]  StreamId      The stream.
+
+  @return The first pending transfer, or NULL if there is none.
+**/
+STATIC
+EDKII_USB_BULK_BATCH_REQUEST *
+MockFindRequest (
+  IN EDKII_USB_BULK_BATCH_REQUEST  *Requests,
+  IN UINTN                         RequestCount,
+  IN UINT8                         Endpoint,
+  IN UINT16                        StreamId
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < RequestCount; Index++) {
+    if ((Requests[Index].EndPointAddress == Endpoint) && (Requests[Index].StreamId == StreamId) &&
+        (Requests[Index].Status == EFI_NOT_READY))
+    {
+      return &Requests[Index];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Mock of the batched bulk transfers, on the SuperSpeed pipes with streams.
+
+  The command IUs are queued first, then the device serves its commands from
+  the last one, moving its data and its SENSE IU on the streams of its tag.
+  A command whose transfers are missing is left queued, the batch then times
+  out.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockBulkBatchTransfer (
+  IN     EDKII_USB_IO_BULK_BATCH_PROTOCOL  *This,
+  IN     UINTN                             RequestCount,
+  IN OUT EDKII_USB_BULK_BATCH_REQUEST      *Requests,
+  IN     UINTN                             Timeout
+  )
+{
+  EDKII_USB_BULK_BATCH_REQUEST  *Request;
+  EDKII_USB_BULK_BATCH_REQUEST  *DataRequest;
+  MOCK_UAS_COMMAND              *Command;
+  EFI_STATUS                    Result;
+  UINTN                         Index;
+  UINT32                        Lba;
+  UINT32                        Count;
+  UINT8                         Endpoint;
+
+  mMockUsbIo.BatchCalls++;
+
+  //
+  // Only the command pipe has no streams, as the host controller checks.
+  //
+  for (Index = 0; Index < RequestCount; Index++) {
+    Request = &Requests[Index];
+    if ((Request->EndPointAddress == MOCK_EP_COMMAND) ?
+        (Request->StreamId != 0) :
+        ((Request->StreamId == 0) || (Request->StreamId > mMockUsbIo.StreamCount)))
+    {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    Request->Status         = EFI_NOT_READY;
+    Request->TransferResult = EFI_USB_NOERROR;
+  }
+
+  Result = EFI_SUCCESS;
+  for (Index = 0; Index < RequestCount; Index++) {
+    Request = &Requests[Index];
+    if (Request->EndPointAddress != MOCK_EP_COMMAND) {
+      continue;
+    }
+
+    Request->Status = MockUasQueueCommand (Request->Data, Request->DataLength);
+    if (EFI_ERROR (Request->Status)) {
+      Request->TransferResult = EFI_USB_ERR_STALL;
+      Result                  = EFI_DEVICE_ERROR;
+      break;
+    }
+  }
+
+  while (!EFI_ERROR (Result) && (mMockUsbIo.QueueCount != 0)) {
+    Command = &mMockUsbIo.Queue[mMockUsbIo.QueueCount - 1];
+    Request = MockFindRequest (Requests, RequestCount, MOCK_EP_STATUS, Command->Tag);
+    if (Request == NULL) {
+      break;
+    }
+
+    mMockUsbIo.ReadyIndex = mMockUsbIo.QueueCount - 1;
+    Lba                   = MockCdbLba (Command->Cdb, &Count);
+    if (Lba != mMockUsbIo.FailLba) {
+      Endpoint    = (Command->Cdb[0] == USB_BOOT_READ10_OPCODE) ? MOCK_EP_DATA_IN : MOCK_EP_DATA_OUT;
+      DataRequest = MockFindRequest (Requests, RequestCount, Endpoint, Command->Tag);
+      if (DataRequest == NULL) {
+        break;
+      }
+
+      DataRequest->Status = MockUasDataTransfer (Endpoint, DataRequest->Data, DataRequest->DataLength);
+      if (EFI_ERROR (DataRequest->Status)) {
+        DataRequest->TransferResult = EFI_USB_ERR_STALL;
+        Result                      = EFI_DEVICE_ERROR;
+        break;
+      }
+    }
+
+    Request->Status = MockUasStatusIu (Request->Data, &Request->DataLength);
+  }
+
+  //
+  // The transfers left are cancelled, the batch only waits for the ones that
+  // are not optional.
+  //
+  for (Index = 0; Index < RequestCount; Index++) {
+    Request = &Requests[Index];
+    if (Request->Status != EFI_NOT_READY) {
+      continue;
+    }
+
+    if (Request->Optional || EFI_ERROR (Result)) {
+      Request->TransferResult = EFI_USB_ERR_NOTEXECUTE;
+      Request->Status         = EFI_ABORTED;
+    } else {
+      Request->TransferResult = EFI_USB_ERR_TIMEOUT;
+      Request->Status         = EFI_TIMEOUT;
+      Result                  = EFI_TIMEOUT;
+    }
+  }
+
+  return Result;
+}
+
+/**
+  Mock of the allocation of streams on the status and data pipes of the UAS
+  setting.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockAllocateStreams (
+  IN     EDKII_USB_IO_BULK_BATCH_PROTOCOL  *This,
+  IN     UINTN                             EndpointCount,
+  IN     UINT8                             *EndPointAddresses,
+  IN OUT UINT16                            *StreamCount
+  )
+{
+  UINTN  Index;
+
+  if ((mMockUsbIo.AlternateSetting != MOCK_UAS_SETTING) || (EndpointCount == 0) || (*StreamCount == 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  for (Index = 0; Index < EndpointCount; Index++) {
+    if ((EndPointAddresses[Index] != MOCK_EP_STATUS) && (EndPointAddresses[Index] != MOCK_EP_DATA_IN) &&
+        (EndPointAddresses[Index] != MOCK_EP_DATA_OUT))
+    {
+      return EFI_UNSUPPORTED;
+    }
+  }
+
+  if (mMockUsbIo.MaxStreams == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  *StreamCount           = MIN (*StreamCount, mMockUsbIo.MaxStreams);
+  mMockUsbIo.StreamCount = *StreamCount;
+  mMockUsbIo.StreamAllocations++;
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock of the release of the streams.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockFreeStreams (
+  IN EDKII_USB_IO_BULK_BATCH_PROTOCOL  *This,
+  IN UINTN                             EndpointCount,
+  IN UINT8                             *EndPointAddresses
+  )
+{
+  if (mMockUsbIo.StreamCount == 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  mMockUsbIo.StreamCount = 0;
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock of the device descriptor, with a single configuration.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockUsbGetDeviceDescriptor (
+  IN  EFI_USB_IO_PROTOCOL        *This,
+  OUT EFI_USB_DEVICE_DESCRIPTOR  *DeviceDescriptor
+  )
+{
+  ZeroMem (DeviceDescriptor, sizeof (EFI_USB_DEVICE_DESCRIPTOR));
+  DeviceDescriptor->Length            = sizeof (EFI_USB_DEVICE_DESCRIPTOR);
+  DeviceDescriptor->DescriptorType    = USB_DESC_TYPE_DEVICE;
+  DeviceDescriptor->NumConfigurations = 1;
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock of the descriptor of the active configuration.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockUsbGetConfigDescriptor (
+  IN  EFI_USB_IO_PROTOCOL        *This,
+  OUT EFI_USB_CONFIG_DESCRIPTOR  *ConfigurationDescriptor
+  )
+{
+  CopyMem (ConfigurationDescriptor, mMockUsbIo.Config, sizeof (EFI_USB_CONFIG_DESCRIPTOR));
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock of the descriptor of the active setting of the interface.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockUsbGetInterfaceDescriptor (
+  IN  EFI_USB_IO_PROTOCOL           *This,
+  OUT EFI_USB_INTERFACE_DESCRIPTOR  *InterfaceDescriptor
+  )
+{
+  UINTN  Offset;
+
+  for (Offset = sizeof (EFI_USB_CONFIG_DESCRIPTOR); Offset < mMockUsbIo.ConfigLength; Offset += mMockUsbIo.Config[Offset]) {
+    if ((mMockUsbIo.Config[Offset + 1] == USB_DESC_TYPE_INTERFACE) &&
+        (mMockUsbIo.Config[Offset + 3] == mMockUsbIo.AlternateSetting))
+    {
+      CopyMem (InterfaceDescriptor, &mMockUsbIo.Config[Offset], sizeof (EFI_USB_INTERFACE_DESCRIPTOR));
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Mock of the port reset, which drops the queued commands and restores the
+  default setting, without streams.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockUsbPortReset (
+  IN EFI_USB_IO_PROTOCOL  *This
+  )
+{
+  mMockUsbIo.PortResets++;
+  mMockUsbIo.QueueCount       = 0;
+  mMockUsbIo.AlternateSetting = 0;
+  mMockUsbIo.StreamCount      = 0;
+  return EFI_SUCCESS;
+}
+
+/**
+  Reset the mock device.
+
+  @param[in]  Streams  TRUE for the SuperSpeed device, on a host controller
+                       with the bulk batch protocol.
+**/
+STATIC
+VOID
+MockUsbIoReset (
+  IN BOOLEAN  Streams
+  )
+{
+  UINTN  Index;
+
+  ZeroMem (&mMockUsbIo, sizeof (mMockUsbIo));
+  mMockUsbIo.UsbIo.UsbControlTransfer        = MockUsbControlTransfer;
+  mMockUsbIo.UsbIo.UsbBulkTransfer           = MockUsbBulkTransfer;
+  mMockUsbIo.UsbIo.UsbGetDeviceDescriptor    = MockUsbGetDeviceDescriptor;
+  mMockUsbIo.UsbIo.UsbGetConfigDescriptor    = MockUsbGetConfigDescriptor;
+  mMockUsbIo.UsbIo.UsbGetInterfaceDescriptor = MockUsbGetInterfaceDescriptor;
+  mMockUsbIo.UsbIo.UsbPortReset              = MockUsbPortReset;
+  mMockUsbIo.BulkBatch.BulkTransfer          = MockBulkBatchTransfer;
+  mMockUsbIo.BulkBatch.AllocateStreams       = MockAllocateStreams;
+  mMockUsbIo.BulkBatch.FreeStreams           = MockFreeStreams;
+  mMockUsbIo.Config                          = mMockConfig;
+  mMockUsbIo.ConfigLength                    = sizeof (mMockConfig);
+  mMockConfig[2]                             = (UINT8)sizeof (mMockConfig);
+  mMockStreamsConfig[2]                      = (UINT8)sizeof (mMockStreamsConfig);
+  mMockUsbIo.FailLba                         = MAX_UINT32;
+
+  if (Streams) {
+    mMockUsbIo.Config       = mMockStreamsConfig;
+    mMockUsbIo.ConfigLength = sizeof (mMockStreamsConfig);
+    mMockUsbIo.HasBulkBatch = TRUE;
+    mMockUsbIo.MaxStreams   = MOCK_MAX_STREAMS;
+  }
+
+  for (Index = 0; Index < sizeof (mMockUsbIo.Disk); Index++) {
+    mMockUsbIo.Disk[Index] = (UINT8)(Index / MOCK_BLOCK_SIZE + Index);
+  }
+}
+
+/**
+  Reset the mock device and initialize the UAS transport on it.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The transport is initialized.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+UsbUasSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+
+  MockUsbIoReset (FALSE);
+
+  mUsbUas = NULL;
+  Status  = UsbUasInit (&mMockUsbIo.UsbIo, (VOID **)&mUsbUas);
+  if (EFI_ERROR (Status)) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Reset the mock SuperSpeed device and initialize the UAS transport on it,
+  with streams on its pipes.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The transport is initialized.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+UsbUasStreamsSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+
+  MockUsbIoReset (TRUE);
+
+  mUsbUas = NULL;
+  Status  = UsbUasInit (&mMockUsbIo.UsbIo, (VOID **)&mUsbUas);
+  if (EFI_ERROR (Status)) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Clean up the UAS transport.
+
+  @param[in]  Context  Unused.
+**/
+STATIC
+VOID
+EFIAPI
+UsbUasCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  if (mUsbUas != NULL) {
+    UsbUasCleanUp (mUsbUas);
+    mUsbUas = NULL;
+  }
+}
+
+/**
+  Fill in a READ(10) or WRITE(10) command of a list.
+
+  @param[out]  Command  The command.
+  @param[out]  Cdb      The buffer of the CDB.
+  @param[in]   Write    TRUE for a WRITE(10) command.
+  @param[in]   Lba      The first block.
+  @param[in]   Count    The number of blocks.
+  @param[in]   Data     The data buffer.
+**/
+STATIC
+VOID
+FillReadWrite10 (
+  OUT USB_MASS_COMMAND  *Command,
+  OUT UINT8             *Cdb,
+  IN  BOOLEAN           Write,
+  IN  UINT32            Lba,
+  IN  UINT16            Count,
+  IN  UINT8             *Data
+  )
+{
+  ZeroMem (Cdb, 10);
+  Cdb[0] = Write ? USB_BOOT_WRITE10_OPCODE : USB_BOOT_READ10_OPCODE;
+  WriteUnaligned32 ((UINT32 *)&Cdb[2], SwapBytes32 (Lba));
+  WriteUnaligned16 ((UINT16 *)&Cdb[7], SwapBytes16 (Count));
+
+  Command->Cmd     = Cdb;
+  Command->CmdLen  = 10;
+  Command->DataDir = Write ? EfiUsbDataOut : EfiUsbDataIn;
+  Command->Data    = Data;
+  Command->DataLen = Count * MOCK_BLOCK_SIZE;
+}
+
+/**
+  The transport selects the UAS setting and maps the pipes from the pipe
+  usage descriptors.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+InitSelectsUasSettingTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8  MaxLun;
+  UINTN  ControlTransfers;
+
+  UT_ASSERT_EQUAL (mMockUsbIo.AlternateSetting, MOCK_UAS_SETTING);
+  UT_ASSERT_EQUAL (mUsbUas->Interface.InterfaceProtocol, USB_MASS_STORE_UAS);
+  UT_ASSERT_EQUAL (mUsbUas->CommandEndpoint, MOCK_EP_COMMAND);
+  UT_ASSERT_EQUAL (mUsbUas->StatusEndpoint, MOCK_EP_STATUS);
+  UT_ASSERT_EQUAL (mUsbUas->DataInEndpoint, MOCK_EP_DATA_IN);
+  UT_ASSERT_EQUAL (mUsbUas->DataOutEndpoint, MOCK_EP_DATA_OUT);
+
+  UT_ASSERT_NOT_EFI_ERROR (UsbUasGetMaxLun (mUsbUas, &MaxLun));
+  UT_ASSERT_EQUAL (MaxLun, 0);
+
+  //
+  // Probing the interface only checks its active setting, without accessing
+  // the device, cleaning up restores the default setting.
+  //
+  ControlTransfers = mMockUsbIo.ControlTransfers;
+  UT_ASSERT_NOT_EFI_ERROR (UsbUasInit (&mMockUsbIo.UsbIo, NULL));
+  mMockUsbIo.AlternateSetting = 0;
+  UT_ASSERT_STATUS_EQUAL (UsbUasInit (&mMockUsbIo.UsbIo, NULL), EFI_UNSUPPORTED);
+  UT_ASSERT_EQUAL (mMockUsbIo.AlternateSetting, 0);
+  UT_ASSERT_EQUAL (mMockUsbIo.ControlTransfers, ControlTransfers);
+
+  mMockUsbIo.AlternateSetting = MOCK_UAS_SETTING;
+  UsbUasCleanUp (mUsbUas);
+  mUsbUas = NULL;
+  UT_ASSERT_EQUAL (mMockUsbIo.AlternateSetting, 0);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Devices whose UAS pipes need bulk streams are left to the Bulk-Only
+  Transport when the host controller can't allocate the streams.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+StreamsUnsupportedTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UsbUasCleanUp (mUsbUas);
+  mUsbUas                 = NULL;
+  mMockUsbIo.Config       = mMockStreamsConfig;
+  mMockUsbIo.ConfigLength = sizeof (mMockStreamsConfig);
+
+  //
+  // No bulk batch protocol.
+  //
+  UT_ASSERT_STATUS_EQUAL (UsbUasInit (&mMockUsbIo.UsbIo, (VOID **)&mUsbUas), EFI_UNSUPPORTED);
+  UT_ASSERT_EQUAL (mMockUsbIo.AlternateSetting, 0);
+
+  //
+  // A host controller without streams.
+  //
+  mMockUsbIo.HasBulkBatch = TRUE;
+  UT_ASSERT_STATUS_EQUAL (UsbUasInit (&mMockUsbIo.UsbIo, (VOID **)&mUsbUas), EFI_UNSUPPORTED);
+  UT_ASSERT_EQUAL (mMockUsbIo.AlternateSetting, 0);
+  UT_ASSERT_EQUAL (mMockUsbIo.StreamAllocations, 0);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The streams of the status and data pipes are allocated once the UAS setting
+  is selected, and freed on clean up.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+StreamsAllocatedTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UT_ASSERT_EQUAL (mMockUsbIo.AlternateSetting, MOCK_UAS_SETTING);
+  UT_ASSERT_EQUAL (mMockUsbIo.StreamAllocations, 1);
+  UT_ASSERT_EQUAL (mMockUsbIo.StreamCount, USB_UAS_MAX_COMMANDS);
+  UT_ASSERT_EQUAL (mUsbUas->StreamCount, USB_UAS_MAX_COMMANDS);
+  UT_ASSERT_EQUAL (mUsbUas->StatusEndpoint, MOCK_EP_STATUS);
+  UT_ASSERT_EQUAL (mUsbUas->DataInEndpoint, MOCK_EP_DATA_IN);
+  UT_ASSERT_EQUAL (mUsbUas->DataOutEndpoint, MOCK_EP_DATA_OUT);
+
+  UsbUasCleanUp (mUsbUas);
+  mUsbUas = NULL;
+  UT_ASSERT_EQUAL (mMockUsbIo.StreamCount, 0);
+  UT_ASSERT_EQUAL (mMockUsbIo.AlternateSetting, 0);
+
+  //
+  // The device gets no more streams than the host controller has.
+  //
+  mMockUsbIo.MaxStreams = 2;
+  UT_ASSERT_NOT_EFI_ERROR (UsbUasInit (&mMockUsbIo.UsbIo, (VOID **)&mUsbUas));
+  UT_ASSERT_EQUAL (mUsbUas->StreamCount, 2);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  All the commands of a list are sent before the first status, with distinct
+  tags, and the data of each one lands in its own buffer although the device
+  completes them in the reverse order.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+TaggedReadsTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  USB_MASS_COMMAND  Commands[USB_UAS_MAX_COMMANDS];
+  UINT8             Cdbs[USB_UAS_MAX_COMMANDS][16];
+  UINT8             *Buffer;
+  EFI_STATUS        Status;
+  UINTN             Index;
+  UINTN             Other;
+
+  Buffer = AllocateZeroPool (USB_UAS_MAX_COMMANDS * 2 * MOCK_BLOCK_SIZE);
+  UT_ASSERT_NOT_NULL (Buffer);
+
+  for (Index = 0; Index < USB_UAS_MAX_COMMANDS; Index++) {
+    FillReadWrite10 (&Commands[Index], Cdbs[Index], FALSE, (UINT32)(Index * 2), 2, Buffer + Index * 2 * MOCK_BLOCK_SIZE);
+  }
+
+  Status = UsbUasExecCommands (mUsbUas, Commands, USB_UAS_MAX_COMMANDS, 0, USB_BOOT_GENERAL_CMD_TIMEOUT);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  for (Index = 0; Index < USB_UAS_MAX_COMMANDS; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (Commands[Index].Status);
+    UT_ASSERT_EQUAL (Commands[Index].CmdStatus, USB_MASS_CMD_SUCCESS);
+  }
+
+  UT_ASSERT_MEM_EQUAL (Buffer, mMockUsbIo.Disk, USB_UAS_MAX_COMMANDS * 2 * MOCK_BLOCK_SIZE);
+
+  //
+  // Each tag is non zero and used once, the device completed the commands
+  // from the last one sent.
+  //
+  UT_ASSERT_EQUAL (mMockUsbIo.SentCount, USB_UAS_MAX_COMMANDS);
+  UT_ASSERT_EQUAL (mMockUsbIo.CompletedCount, USB_UAS_MAX_COMMANDS);
+  for (Index = 0; Index < USB_UAS_MAX_COMMANDS; Index++) {
+    UT_ASSERT_NOT_EQUAL (mMockUsbIo.SentTags[Index], 0);
+    for (Other = Index + 1; Other < USB_UAS_MAX_COMMANDS; Other++) {
+      UT_ASSERT_NOT_EQUAL (mMockUsbIo.SentTags[Index], mMockUsbIo.SentTags[Other]);
+    }
+
+    UT_ASSERT_EQUAL (mMockUsbIo.CompletedTags[Index], mMockUsbIo.SentTags[USB_UAS_MAX_COMMANDS - 1 - Index]);
+  }
+
+  //
+  // The tags of the next list don't reuse the ones of this one.
+  //
+  Status = UsbUasExecCommands (mUsbUas, Commands, 1, 0, USB_BOOT_GENERAL_CMD_TIMEOUT);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  for (Index = 0; Index < USB_UAS_MAX_COMMANDS; Index++) {
+    UT_ASSERT_NOT_EQUAL (mMockUsbIo.SentTags[USB_UAS_MAX_COMMANDS], mMockUsbIo.SentTags[Index]);
+  }
+
+  FreePool (Buffer);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Writes are tagged and transferred on the data out pipe.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+TaggedWritesTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  USB_MASS_COMMAND  Commands[2];
+  UINT8             Cdbs[2][16];
+  UINT8             Buffer[2][MOCK_BLOCK_SIZE];
+  EFI_STATUS        Status;
+
+  SetMem (Buffer[0], MOCK_BLOCK_SIZE, 0xA5);
+  SetMem (Buffer[1], MOCK_BLOCK_SIZE, 0x5A);
+  FillReadWrite10 (&Commands[0], Cdbs[0], TRUE, 3, 1, Buffer[0]);
+  FillReadWrite10 (&Commands[1], Cdbs[1], TRUE, 9, 1, Buffer[1]);
+
+  Status = UsbUasExecCommands (mUsbUas, Commands, 2, 0, USB_BOOT_GENERAL_CMD_TIMEOUT);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (Commands[0].CmdStatus, USB_MASS_CMD_SUCCESS);
+  UT_ASSERT_EQUAL (Commands[1].CmdStatus, USB_MASS_CMD_SUCCESS);
+  UT_ASSERT_MEM_EQUAL (&mMockUsbIo.Disk[3 * MOCK_BLOCK_SIZE], Buffer[0], MOCK_BLOCK_SIZE);
+  UT_ASSERT_MEM_EQUAL (&mMockUsbIo.Disk[9 * MOCK_BLOCK_SIZE], Buffer[1], MOCK_BLOCK_SIZE);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A command failing with CHECK CONDITION doesn't fail the other commands of
+  the list, and the REQUEST SENSE command that follows is answered with the
+  sense data of its SENSE IU without reaching the device.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+CheckConditionTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  USB_MASS_COMMAND             Commands[3];
+  UINT8                        Cdbs[3][16];
+  UINT8                        Buffer[3][MOCK_BLOCK_SIZE];
+  USB_BOOT_REQUEST_SENSE_CMD   SenseCmd;
+  USB_BOOT_REQUEST_SENSE_DATA  SenseData;
+  EFI_STATUS                   Status;
+  UINT32                       CmdStatus;
+  UINTN                        BulkCalls;
+
+  mMockUsbIo.FailLba = 5;
+  FillReadWrite10 (&Commands[0], Cdbs[0], FALSE, 4, 1, Buffer[0]);
+  FillReadWrite10 (&Commands[1], Cdbs[1], FALSE, 5, 1, Buffer[1]);
+  FillReadWrite10 (&Commands[2], Cdbs[2], FALSE, 6, 1, Buffer[2]);
+
+  Status = UsbUasExecCommands (mUsbUas, Commands, 3, 0, USB_BOOT_GENERAL_CMD_TIMEOUT);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (Commands[0].CmdStatus, USB_MASS_CMD_SUCCESS);
+  UT_ASSERT_EQUAL (Commands[1].CmdStatus, USB_MASS_CMD_FAIL);
+  UT_ASSERT_EQUAL (Commands[2].CmdStatus, USB_MASS_CMD_SUCCESS);
+  UT_ASSERT_MEM_EQUAL (Buffer[0], &mMockUsbIo.Disk[4 * MOCK_BLOCK_SIZE], MOCK_BLOCK_SIZE);
+  UT_ASSERT_MEM_EQUAL (Buffer[2], &mMockUsbIo.Disk[6 * MOCK_BLOCK_SIZE], MOCK_BLOCK_SIZE);
+
+  ZeroMem (&SenseCmd, sizeof (SenseCmd));
+  SenseCmd.OpCode   = USB_BOOT_REQUEST_SENSE_OPCODE;
+  SenseCmd.AllocLen = (UINT8)sizeof (SenseData);
+  BulkCalls         = mMockUsbIo.BulkCalls;
+  Status            = UsbUasExecCommand (
+                        mUsbUas,
+                        &SenseCmd,
+                        (UINT8)sizeof (SenseCmd),
+                        EfiUsbDataIn,
+                        &SenseData,
+                        (UINT32)sizeof (SenseData),
+                        0,
+                        USB_BOOT_GENERAL_CMD_TIMEOUT,
+                        &CmdStatus
+                        );
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (CmdStatus, USB_MASS_CMD_SUCCESS);
+  UT_ASSERT_EQUAL (USB_BOOT_SENSE_KEY (SenseData.SenseKey), MOCK_SENSE_KEY);
+  UT_ASSERT_EQUAL (mMockUsbIo.BulkCalls, BulkCalls);
+
+  //
+  // The sense data is returned once.
+  //
+  UT_ASSERT_FALSE (mUsbUas->SenseValid);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A status IU of an unknown tag fails the pending commands and resets the
+  device, which is then put back in the UAS setting.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+UnknownTagRecoveryTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  USB_MASS_COMMAND  Commands[2];
+  UINT8             Cdbs[2][16];
+  UINT8             Buffer[2][MOCK_BLOCK_SIZE];
+  EFI_STATUS        Status;
+
+  FillReadWrite10 (&Commands[0], Cdbs[0], FALSE, 0, 1, Buffer[0]);
+  FillReadWrite10 (&Commands[1], Cdbs[1], FALSE, 1, 1, Buffer[1]);
+
+  mMockUsbIo.BadTag = TRUE;
+  Status            = UsbUasExecCommands (mUsbUas, Commands, 2, 0, USB_BOOT_GENERAL_CMD_TIMEOUT);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_DEVICE_ERROR);
+  UT_ASSERT_STATUS_EQUAL (Commands[0].Status, EFI_DEVICE_ERROR);
+  UT_ASSERT_STATUS_EQUAL (Commands[1].Status, EFI_DEVICE_ERROR);
+  UT_ASSERT_EQUAL (mMockUsbIo.PortResets, 1);
+  UT_ASSERT_EQUAL (mMockUsbIo.AlternateSetting, MOCK_UAS_SETTING);
+
+  mMockUsbIo.BadTag = FALSE;
+  Status            = UsbUasExecCommands (mUsbUas, Commands, 2, 0, USB_BOOT_GENERAL_CMD_TIMEOUT);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_MEM_EQUAL (Buffer, mMockUsbIo.Disk, sizeof (Buffer));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  On pipes with streams, the commands of a list go in one batch, without
+  transfers of the USB I/O protocol, and the data of each one lands in its own
+  buffer although the device completes them in the reverse order. The lists
+  longer than the stream count take several batches.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+StreamReadsWritesTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  USB_MASS_COMMAND  Commands[USB_UAS_MAX_COMMANDS];
+  UINT8             Cdbs[USB_UAS_MAX_COMMANDS][16];
+  UINT8             *Buffer;
+  EFI_STATUS        Status;
+  UINTN             Index;
+
+  Buffer = AllocateZeroPool (USB_UAS_MAX_COMMANDS * 2 * MOCK_BLOCK_SIZE);
+  UT_ASSERT_NOT_NULL (Buffer);
+
+  for (Index = 0; Index < USB_UAS_MAX_COMMANDS; Index++) {
+    FillReadWrite10 (&Commands[Index], Cdbs[Index], FALSE, (UINT32)(Index * 2), 2, Buffer + Index * 2 * MOCK_BLOCK_SIZE);
+  }
+
+  Status = UsbUasExecCommands (mUsbUas, Commands, USB_UAS_MAX_COMMANDS, 0, USB_BOOT_GENERAL_CMD_TIMEOUT);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  for (Index = 0; Index < USB_UAS_MAX_COMMANDS; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (Commands[Index].Status);
+    UT_ASSERT_EQUAL (Commands[Index].CmdStatus, USB_MASS_CMD_SUCCESS);
+  }
+
+  UT_ASSERT_MEM_EQUAL (Buffer, mMockUsbIo.Disk, USB_UAS_MAX_COMMANDS * 2 * MOCK_BLOCK_SIZE);
+  UT_ASSERT_EQUAL (mMockUsbIo.BatchCalls, 1);
+  UT_ASSERT_EQUAL (mMockUsbIo.BulkCalls, 0);
+
+  //
+  // The tag of each command is the stream of its status and data.
+  //
+  UT_ASSERT_EQUAL (mMockUsbIo.CompletedCount, USB_UAS_MAX_COMMANDS);
+  for (Index = 0; Index < USB_UAS_MAX_COMMANDS; Index++) {
+    UT_ASSERT_EQUAL (mMockUsbIo.SentTags[Index], Index + 1);
+    UT_ASSERT_EQUAL (mMockUsbIo.CompletedTags[Index], USB_UAS_MAX_COMMANDS - Index);
+  }
+
+  SetMem (Buffer, MOCK_BLOCK_SIZE, 0xA5);
+  FillReadWrite10 (&Commands[0], Cdbs[0], TRUE, 12, 1, Buffer);
+  Status = UsbUasExecCommands (mUsbUas, Commands, 1, 0, USB_BOOT_GENERAL_CMD_TIMEOUT);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (Commands[0].CmdStatus, USB_MASS_CMD_SUCCESS);
+  UT_ASSERT_MEM_EQUAL (&mMockUsbIo.Disk[12 * MOCK_BLOCK_SIZE], Buffer, MOCK_BLOCK_SIZE);
+
+  //
+  // With two streams, the list takes two batches.
+  //
+  UsbUasCleanUp (mUsbUas);
+  mUsbUas               = NULL;
+  mMockUsbIo.MaxStreams = 2;
+  UT_ASSERT_NOT_EFI_ERROR (UsbUasInit (&mMockUsbIo.UsbIo, (VOID **)&mUsbUas));
+
+  ZeroMem (Buffer, USB_UAS_MAX_COMMANDS * 2 * MOCK_BLOCK_SIZE);
+  for (Index = 0; Index < USB_UAS_MAX_COMMANDS; Index++) {
+    FillReadWrite10 (&Commands[Index], Cdbs[Index], FALSE, (UINT32)(Index * 2), 2, Buffer + Index * 2 * MOCK_BLOCK_SIZE);
+  }
+
+  mMockUsbIo.BatchCalls = 0;
+  Status                = UsbUasExecCommands (mUsbUas, Commands, USB_UAS_MAX_COMMANDS, 0, USB_BOOT_GENERAL_CMD_TIMEOUT);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (mMockUsbIo.BatchCalls, 2);
+  UT_ASSERT_MEM_EQUAL (Buffer, mMockUsbIo.Disk, USB_UAS_MAX_COMMANDS * 2 * MOCK_BLOCK_SIZE);
+
+  FreePool (Buffer);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  On pipes with streams, a command failing with CHECK CONDITION has its data
+  transfer cancelled, its sense data is kept for the REQUEST SENSE command
+  that follows, and the other commands of the batch succeed.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+StreamCheckConditionTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  USB_MASS_COMMAND             Commands[3];
+  UINT8                        Cdbs[3][16];
+  UINT8                        Buffer[3][MOCK_BLOCK_SIZE];
+  USB_BOOT_REQUEST_SENSE_CMD   SenseCmd;
+  USB_BOOT_REQUEST_SENSE_DATA  SenseData;
+  EFI_STATUS                   Status;
+  UINT32                       CmdStatus;
+
+  mMockUsbIo.FailLba = 5;
+  FillReadWrite10 (&Commands[0], Cdbs[0], FALSE, 4, 1, Buffer[0]);
+  FillReadWrite10 (&Commands[1], Cdbs[1], FALSE, 5, 1, Buffer[1]);
+  FillReadWrite10 (&Commands[2], Cdbs[2], FALSE, 6, 1, Buffer[2]);
+
+  Status = UsbUasExecCommands (mUsbUas, Commands, 3, 0, USB_BOOT_GENERAL_CMD_TIMEOUT);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (Commands[0].CmdStatus, USB_MASS_CMD_SUCCESS);
+  UT_ASSERT_EQUAL (Commands[1].CmdStatus, USB_MASS_CMD_FAIL);
+  UT_ASSERT_EQUAL (Commands[2].CmdStatus, USB_MASS_CMD_SUCCESS);
+  UT_ASSERT_MEM_EQUAL (Buffer[0], &mMockUsbIo.Disk[4 * MOCK_BLOCK_SIZE], MOCK_BLOCK_SIZE);
+  UT_ASSERT_MEM_EQUAL (Buffer[2], &mMockUsbIo.Disk[6 * MOCK_BLOCK_SIZE], MOCK_BLOCK_SIZE);
+  UT_ASSERT_EQUAL (mMockUsbIo.PortResets, 0);
+
+  ZeroMem (&SenseCmd, sizeof (SenseCmd));
+  SenseCmd.OpCode   = USB_BOOT_REQUEST_SENSE_OPCODE;
+  SenseCmd.AllocLen = (UINT8)sizeof (SenseData);
+  Status            = UsbUasExecCommand (
+                        mUsbUas,
+                        &SenseCmd,
+                        (UINT8)sizeof (SenseCmd),
+                        EfiUsbDataIn,
+                        &SenseData,
+                        (UINT32)sizeof (SenseData),
+                        0,
+                        USB_BOOT_GENERAL_CMD_TIMEOUT,
+                        &CmdStatus
+                        );
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (CmdStatus, USB_MASS_CMD_SUCCESS);
+  UT_ASSERT_EQUAL (USB_BOOT_SENSE_KEY (SenseData.SenseKey), MOCK_SENSE_KEY);
+  UT_ASSERT_EQUAL (mMockUsbIo.BatchCalls, 1);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  On pipes with streams, a status IU of an unknown tag fails the batch and
+  resets the device, which gets the UAS setting and its streams back.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+StreamRecoveryTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  USB_MASS_COMMAND  Commands[2];
+  UINT8             Cdbs[2][16];
+  UINT8             Buffer[2][MOCK_BLOCK_SIZE];
+  EFI_STATUS        Status;
+
+  FillReadWrite10 (&Commands[0], Cdbs[0], FALSE, 0, 1, Buffer[0]);
+  FillReadWrite10 (&Commands[1], Cdbs[1], FALSE, 1, 1, Buffer[1]);
+
+  mMockUsbIo.BadTag = TRUE;
+  Status            = UsbUasExecCommands (mUsbUas, Commands, 2, 0, USB_BOOT_GENERAL_CMD_TIMEOUT);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_DEVICE_ERROR);
+  UT_ASSERT_STATUS_EQUAL (Commands[0].Status, EFI_DEVICE_ERROR);
+  UT_ASSERT_STATUS_EQUAL (Commands[1].Status, EFI_DEVICE_ERROR);
+  UT_ASSERT_EQUAL (mMockUsbIo.PortResets, 1);
+  UT_ASSERT_EQUAL (mMockUsbIo.AlternateSetting, MOCK_UAS_SETTING);
+  UT_ASSERT_EQUAL (mMockUsbIo.StreamAllocations, 2);
+  UT_ASSERT_EQUAL (mMockUsbIo.StreamCount, USB_UAS_MAX_COMMANDS);
+
+  //
+  // A device that never completes a command times out.
+  //
+  mMockUsbIo.BadTag   = FALSE;
+  Commands[1].Data    = NULL;
+  Commands[1].DataLen = 0;
+  Status              = UsbUasExecCommands (mUsbUas, Commands, 2, 0, USB_BOOT_GENERAL_CMD_TIMEOUT);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_TIMEOUT);
+  UT_ASSERT_EQUAL (mMockUsbIo.PortResets, 2);
+  UT_ASSERT_EQUAL (mMockUsbIo.StreamCount, USB_UAS_MAX_COMMANDS);
+
+  FillReadWrite10 (&Commands[1], Cdbs[1], FALSE, 1, 1, Buffer[1]);
+  Status = UsbUasExecCommands (mUsbUas, Commands, 2, 0, USB_BOOT_GENERAL_CMD_TIMEOUT);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_MEM_EQUAL (Buffer, mMockUsbIo.Disk, sizeof (Buffer));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the UAS
+  transport and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      UasTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&UasTests, Framework, "USB Attached SCSI Transport Tests", "UsbMass.Uas", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for UasTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (UasTests, "The UAS setting and pipes are selected", "InitSelectsUasSetting", InitSelectsUasSettingTest, UsbUasSetup, UsbUasCleanup, NULL);
+  AddTestCase (UasTests, "Devices needing bulk streams the host can't allocate are not supported", "StreamsUnsupported", StreamsUnsupportedTest, UsbUasSetup, UsbUasCleanup, NULL);
+  AddTestCase (UasTests, "Tagged reads complete out of order", "TaggedReads", TaggedReadsTest, UsbUasSetup, UsbUasCleanup, NULL);
+  AddTestCase (UasTests, "Tagged writes use the data out pipe", "TaggedWrites", TaggedWritesTest, UsbUasSetup, UsbUasCleanup, NULL);
+  AddTestCase (UasTests, "Sense data of a failed command is cached", "CheckCondition", CheckConditionTest, UsbUasSetup, UsbUasCleanup, NULL);
+  AddTestCase (UasTests, "An unknown tag resets the device", "UnknownTagRecovery", UnknownTagRecoveryTest, UsbUasSetup, UsbUasCleanup, NULL);
+  AddTestCase (UasTests, "The streams of the SuperSpeed pipes are allocated", "StreamsAllocated", StreamsAllocatedTest, UsbUasStreamsSetup, UsbUasCleanup, NULL);
+  AddTestCase (UasTests, "Commands on streams go in a batch", "StreamReadsWrites", StreamReadsWritesTest, UsbUasStreamsSetup, UsbUasCleanup, NULL);
+  AddTestCase (UasTests, "A failed command on streams cancels its data", "StreamCheckCondition", StreamCheckConditionTest, UsbUasStreamsSetup, UsbUasCleanup, NULL);
+  AddTestCase (UasTests, "A failed batch resets the device and its streams", "StreamRecovery", StreamRecoveryTest, UsbUasStreamsSetup, UsbUasCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -14,6 +14,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <IndustryStandard/Scsi.h>
 #include <Protocol/BlockIo.h>
 #include <Protocol/UsbIo.h>
+#include <Protocol/UsbBulkBatch.h> // MU_CHANGE - Batched bulk transfers
 #include <Protocol/DevicePath.h>
 #include <Protocol/DiskInfo.h>
 #include <Library/BaseLib.h>
@@ -28,8 +29,26 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 typedef struct _USB_MASS_TRANSPORT  USB_MASS_TRANSPORT;
 typedef struct _USB_MASS_DEVICE     USB_MASS_DEVICE;
 
+// MU_CHANGE [BEGIN] - USB Attached SCSI transport
+
+///
+/// A command of a list executed by USB_MASS_EXEC_COMMANDS.
+///
+typedef struct {
+  VOID                      *Cmd;       ///< The command to transfer to device
+  UINT8                     CmdLen;     ///< The length of the command
+  EFI_USB_DATA_DIRECTION    DataDir;    ///< The direction of data transfer
+  VOID                      *Data;      ///< The buffer to hold the data
+  UINT32                    DataLen;    ///< The length of the buffer
+  UINT32                    CmdStatus;  ///< The result of the command execution
+  EFI_STATUS                Status;     ///< The transfer status of the command
+} USB_MASS_COMMAND;
+
+// MU_CHANGE [END] - USB Attached SCSI transport
+
 #include "UsbMassBot.h"
 #include "UsbMassCbi.h"
+#include "UsbMassUas.h" // MU_CHANGE - USB Attached SCSI transport
 #include "UsbMassBoot.h"
 #include "UsbMassDiskInfo.h"
 #include "UsbMassImpl.h"
@@ -99,6 +118,36 @@ EFI_STATUS
   OUT UINT32                  *CmdStatus
   );
 
+// MU_CHANGE [BEGIN] - USB Attached SCSI transport
+
+/**
+  Execute a list of USB mass storage commands through the transport protocol,
+  with all the commands in flight at once.
+
+  @param  Context               The USB Transport Protocol.
+  @param  Commands              The commands to execute
+  @param  CommandCount          The number of commands
+  @param  Lun                   The number of logic unit
+  @param  Timeout               The time to wait each command
+
+  @retval EFI_SUCCESS           The commands are executed, the result of each
+                                command is in its CmdStatus field.
+  @retval Other                 Failed to execute some commands, see the
+                                Status field of each command.
+
+**/
+typedef
+EFI_STATUS
+(*USB_MASS_EXEC_COMMANDS) (
+  IN     VOID              *Context,
+  IN OUT USB_MASS_COMMAND  *Commands,
+  IN     UINTN             CommandCount,
+  IN     UINT8             Lun,
+  IN     UINT32            Timeout
+  );
+
+// MU_CHANGE [END] - USB Attached SCSI transport
+
 /**
   Reset the USB mass storage device by Transport protocol.
 
@@ -164,6 +213,7 @@ struct _USB_MASS_TRANSPORT {
   USB_MASS_RESET             Reset;       ///< Reset the device
   USB_MASS_GET_MAX_LUN       GetMaxLun;   ///< Get max lun, only for bot
   USB_MASS_CLEAN_UP          CleanUp;     ///< Clean up the resources.
+  USB_MASS_EXEC_COMMANDS     ExecCommands; ///< Execute tagged commands, NULL if not supported // MU_CHANGE - USB Attached SCSI transport
 };
 
 struct _USB_MASS_DEVICE {
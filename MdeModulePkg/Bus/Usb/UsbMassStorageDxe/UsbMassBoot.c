@@ -793,6 +793,128 @@ UsbBootDetectMedia (
   return Status;
 }
 
+// MU_CHANGE [BEGIN] - USB Attached SCSI transport
+
+/**
+  Read or write some blocks from the device with several commands in flight,
+  through a transport protocol that supports tagged commands.
+
+  @param  UsbMass                The USB mass storage device to access
+  @param  Write                  TRUE for write operation.
+  @param  Lba                    The start block number
+  @param  TotalBlock             Total block number to read or write
+  @param  Buffer                 The buffer to read to or write from
+  @param  Cdb16Byte              TRUE to use the SCSI 16 byte commands.
+
+  @retval EFI_SUCCESS            Data are read into the buffer or writen into the device.
+  @retval Others                 Failed to read or write all the data
+
+**/
+EFI_STATUS
+UsbBootReadWriteBlocksQueued (
+  IN  USB_MASS_DEVICE  *UsbMass,
+  IN  BOOLEAN          Write,
+  IN  UINT64           Lba,
+  IN  UINTN            TotalBlock,
+  IN OUT UINT8         *Buffer,
+  IN  BOOLEAN          Cdb16Byte
+  )
+{
+  UINT8             Cmds[USB_UAS_MAX_COMMANDS][16];
+  USB_MASS_COMMAND  Commands[USB_UAS_MAX_COMMANDS];
+  EFI_STATUS        Status;
+  UINTN             CommandCount;
+  UINTN             Index;
+  UINT32            Count;
+  UINT32            CountMax;
+  UINT32            BlockSize;
+  UINT8             CmdLen;
+
+  BlockSize = UsbMass->BlockIoMedia.BlockSize;
+  CountMax  = USB_BOOT_MAX_CARRY_SIZE / BlockSize;
+  if (!Cdb16Byte) {
+    CountMax = MIN (MAX_UINT16, CountMax);
+  }
+
+  CmdLen = Cdb16Byte ? 16 : (UINT8)sizeof (USB_BOOT_READ_WRITE_10_CMD);
+
+  while (TotalBlock > 0) {
+    //
+    // Split the blocks into the same pieces as one command at a time, and
+    // queue as many of them as the transport can keep in flight.
+    //
+    for (CommandCount = 0; (CommandCount < USB_UAS_MAX_COMMANDS) && (TotalBlock > 0); CommandCount++) {
+      Count = (UINT32)MIN (TotalBlock, CountMax);
+
+      ZeroMem (Cmds[CommandCount], sizeof (Cmds[CommandCount]));
+      if (Cdb16Byte) {
+        Cmds[CommandCount][0] = Write ? EFI_SCSI_OP_WRITE16 : EFI_SCSI_OP_READ16;
+        Cmds[CommandCount][1] = (UINT8)((USB_BOOT_LUN (UsbMass->Lun) & 0xE0));
+        WriteUnaligned64 ((UINT64 *)&Cmds[CommandCount][2], SwapBytes64 (Lba));
+        WriteUnaligned32 ((UINT32 *)&Cmds[CommandCount][10], SwapBytes32 (Count));
+      } else {
+        Cmds[CommandCount][0] = Write ? USB_BOOT_WRITE10_OPCODE : USB_BOOT_READ10_OPCODE;
+        Cmds[CommandCount][1] = (UINT8)(USB_BOOT_LUN (UsbMass->Lun));
+        WriteUnaligned32 ((UINT32 *)&Cmds[CommandCount][2], SwapBytes32 ((UINT32)Lba));
+        WriteUnaligned16 ((UINT16 *)&Cmds[CommandCount][7], SwapBytes16 ((UINT16)Count));
+      }
+
+      Commands[CommandCount].Cmd     = Cmds[CommandCount];
+      Commands[CommandCount].CmdLen  = CmdLen;
+      Commands[CommandCount].DataDir = Write ? EfiUsbDataOut : EfiUsbDataIn;
+      Commands[CommandCount].Data    = Buffer;
+      Commands[CommandCount].DataLen = Count * BlockSize;
+
+      Lba        += Count;
+      Buffer     += Count * BlockSize;
+      TotalBlock -= Count;
+    }
+
+    UsbMass->Transport->ExecCommands (
+                          UsbMass->Context,
+                          Commands,
+                          CommandCount,
+                          UsbMass->Lun,
+                          (UINT32)USB_BOOT_GENERAL_CMD_TIMEOUT
+                          );
+
+    //
+    // Execute the failed commands again one at a time, that also gets their
+    // sense data and handles the media changes.
+    //
+    for (Index = 0; Index < CommandCount; Index++) {
+      if (!EFI_ERROR (Commands[Index].Status) && (Commands[Index].CmdStatus == USB_MASS_CMD_SUCCESS)) {
+        continue;
+      }
+
+      Status = UsbBootExecCmdWithRetry (
+                 UsbMass,
+                 Commands[Index].Cmd,
+                 Commands[Index].CmdLen,
+                 Commands[Index].DataDir,
+                 Commands[Index].Data,
+                 Commands[Index].DataLen,
+                 (UINT32)USB_BOOT_GENERAL_CMD_TIMEOUT
+                 );
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+
+    DEBUG ((
+      DEBUG_BLKIO,
+      "UsbBoot%sBlocksQueued: LBA (0x%lx), Cmd (0x%x)\n",
+      Write ? L"Write" : L"Read",
+      Lba,
+      CommandCount
+      ));
+  }
+
+  return EFI_SUCCESS;
+}
+
+// MU_CHANGE [END] - USB Attached SCSI transport
+
 /**
   Read or write some blocks from the device.
 
@@ -823,6 +945,13 @@ UsbBootReadWriteBlocks (
   UINT32                      ByteSize;
   UINT32                      Timeout;
 
+  // MU_CHANGE [BEGIN] - USB Attached SCSI transport
+  if (UsbMass->Transport->ExecCommands != NULL) {
+    return UsbBootReadWriteBlocksQueued (UsbMass, Write, Lba, TotalBlock, Buffer, FALSE);
+  }
+
+  // MU_CHANGE [END] - USB Attached SCSI transport
+
   BlockSize = UsbMass->BlockIoMedia.BlockSize;
   CountMax  = USB_BOOT_MAX_CARRY_SIZE / BlockSize;
   Status    = EFI_SUCCESS;
@@ -909,6 +1038,13 @@ UsbBootReadWriteBlocks16 (
   UINT32      ByteSize;
   UINT32      Timeout;
 
+  // MU_CHANGE [BEGIN] - USB Attached SCSI transport
+  if (UsbMass->Transport->ExecCommands != NULL) {
+    return UsbBootReadWriteBlocksQueued (UsbMass, Write, Lba, TotalBlock, Buffer, TRUE);
+  }
+
+  // MU_CHANGE [END] - USB Attached SCSI transport
+
   BlockSize = UsbMass->BlockIoMedia.BlockSize;
   CountMax  = USB_BOOT_MAX_CARRY_SIZE / BlockSize;
   Status    = EFI_SUCCESS;
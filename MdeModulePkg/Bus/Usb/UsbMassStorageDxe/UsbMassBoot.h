@@ -297,6 +297,35 @@ UsbBootReadWriteBlocks (
   IN OUT UINT8         *Buffer
   );
 
+// MU_CHANGE [BEGIN] - USB Attached SCSI transport
+
+/**
+  Read or write some blocks from the device with several commands in flight,
+  through a transport protocol that supports tagged commands.
+
+  @param  UsbMass                The USB mass storage device to access
+  @param  Write                  TRUE for write operation.
+  @param  Lba                    The start block number
+  @param  TotalBlock             Total block number to read or write
+  @param  Buffer                 The buffer to read to or write from
+  @param  Cdb16Byte              TRUE to use the SCSI 16 byte commands.
+
+  @retval EFI_SUCCESS            Data are read into the buffer or writen into the device.
+  @retval Others                 Failed to read or write all the data
+
+**/
+EFI_STATUS
+UsbBootReadWriteBlocksQueued (
+  IN  USB_MASS_DEVICE  *UsbMass,
+  IN  BOOLEAN          Write,
+  IN  UINT64           Lba,
+  IN  UINTN            TotalBlock,
+  IN OUT UINT8         *Buffer,
+  IN  BOOLEAN          Cdb16Byte
+  );
+
+// MU_CHANGE [END] - USB Attached SCSI transport
+
 /**
   Read or write some blocks from the device by SCSI 16 byte cmd.
 
@@ -21,6 +21,61 @@ USB_MASS_TRANSPORT  mUsbBotTransport = {
   UsbBotCleanUp
 };
 
+// MU_CHANGE [BEGIN] - Batched bulk transfers
+
+/**
+  Find the bulk batch protocol installed with a USB I/O protocol.
+
+  @param  UsbIo                 The USB I/O Protocol instance
+
+  @return The bulk batch protocol of the interface, or NULL if the host
+          controller doesn't support batched bulk transfers.
+
+**/
+EDKII_USB_IO_BULK_BATCH_PROTOCOL *
+UsbBotGetBulkBatch (
+  IN  EFI_USB_IO_PROTOCOL  *UsbIo
+  )
+{
+  EDKII_USB_IO_BULK_BATCH_PROTOCOL  *BulkBatch;
+  EFI_USB_IO_PROTOCOL               *HandleUsbIo;
+  EFI_HANDLE                        *Handles;
+  UINTN                             HandleCount;
+  UINTN                             Index;
+  EFI_STATUS                        Status;
+
+  BulkBatch = NULL;
+  Status    = gBS->LocateHandleBuffer (
+                     ByProtocol,
+                     &gEdkiiUsbIoBulkBatchProtocolGuid,
+                     NULL,
+                     &HandleCount,
+                     &Handles
+                     );
+  if (EFI_ERROR (Status)) {
+    return NULL;
+  }
+
+  for (Index = 0; Index < HandleCount; Index++) {
+    Status = gBS->HandleProtocol (Handles[Index], &gEfiUsbIoProtocolGuid, (VOID **)&HandleUsbIo);
+    if (EFI_ERROR (Status) || (HandleUsbIo != UsbIo)) {
+      continue;
+    }
+
+    Status = gBS->HandleProtocol (Handles[Index], &gEdkiiUsbIoBulkBatchProtocolGuid, (VOID **)&BulkBatch);
+    if (EFI_ERROR (Status)) {
+      BulkBatch = NULL;
+    }
+
+    break;
+  }
+
+  FreePool (Handles);
+  return BulkBatch;
+}
+
+// MU_CHANGE [END] - Batched bulk transfers
+
 /**
   Initializes USB BOT protocol.
 
@@ -111,6 +166,8 @@ UsbBotInit (
   //
   UsbBot->CbwTag = 0x01;
 
+  UsbBot->BulkBatch = UsbBotGetBulkBatch (UsbIo); // MU_CHANGE - Batched bulk transfers
+
   if (Context != NULL) {
     *Context = UsbBot;
   } else {
@@ -124,6 +181,46 @@ ON_ERROR:
   return Status;
 }
 
+// MU_CHANGE [BEGIN] - Batched bulk transfers
+
+/**
+  Fill in the Command Block Wrapper of a command.
+
+  @param  UsbBot                The USB BOT device
+  @param  Cbw                   The Command Block Wrapper to fill in
+  @param  Cmd                   The command to transfer to device
+  @param  CmdLen                The length of the command
+  @param  DataDir               The direction of the data
+  @param  TransLen              The expected length of the data
+  @param  Lun                   The number of logic unit
+
+**/
+VOID
+UsbBotFillCbw (
+  IN  USB_BOT_PROTOCOL        *UsbBot,
+  OUT USB_BOT_CBW             *Cbw,
+  IN  UINT8                   *Cmd,
+  IN  UINT8                   CmdLen,
+  IN  EFI_USB_DATA_DIRECTION  DataDir,
+  IN  UINT32                  TransLen,
+  IN  UINT8                   Lun
+  )
+{
+  ASSERT ((CmdLen > 0) && (CmdLen <= USB_BOT_MAX_CMDLEN));
+
+  Cbw->Signature = USB_BOT_CBW_SIGNATURE;
+  Cbw->Tag       = UsbBot->CbwTag;
+  Cbw->DataLen   = TransLen;
+  Cbw->Flag      = (UINT8)((DataDir == EfiUsbDataIn) ? BIT7 : 0);
+  Cbw->Lun       = Lun;
+  Cbw->CmdLen    = CmdLen;
+
+  ZeroMem (Cbw->CmdBlock, USB_BOT_MAX_CMDLEN);
+  CopyMem (Cbw->CmdBlock, Cmd, CmdLen);
+}
+
+// MU_CHANGE [END] - Batched bulk transfers
+
 /**
   Send the command to the device using Bulk-Out endpoint.
 
@@ -159,20 +256,10 @@ UsbBotSendCommand (
   UINTN        DataLen;
   UINTN        Timeout;
 
-  ASSERT ((CmdLen > 0) && (CmdLen <= USB_BOT_MAX_CMDLEN));
-
   //
   // Fill in the Command Block Wrapper.
   //
-  Cbw.Signature = USB_BOT_CBW_SIGNATURE;
-  Cbw.Tag       = UsbBot->CbwTag;
-  Cbw.DataLen   = TransLen;
-  Cbw.Flag      = (UINT8)((DataDir == EfiUsbDataIn) ? BIT7 : 0);
-  Cbw.Lun       = Lun;
-  Cbw.CmdLen    = CmdLen;
-
-  ZeroMem (Cbw.CmdBlock, USB_BOT_MAX_CMDLEN);
-  CopyMem (Cbw.CmdBlock, Cmd, CmdLen);
+  UsbBotFillCbw (UsbBot, &Cbw, Cmd, CmdLen, DataDir, TransLen, Lun); // MU_CHANGE - Batched bulk transfers
 
   Result  = 0;
   DataLen = sizeof (USB_BOT_CBW);
@@ -370,6 +457,147 @@ UsbBotGetStatus (
   return Status;
 }
 
+// MU_CHANGE [BEGIN] - Batched bulk transfers
+
+/**
+  Issue the command/data/status circle of a command as one batch of bulk
+  transfers, so the three phases are queued on the host controller together.
+
+  The error handling of each phase is the same as when the phases are executed
+  one after the other.
+
+  @param  UsbBot                The USB BOT device
+  @param  Cmd                   The high level command
+  @param  CmdLen                The command length
+  @param  DataDir               The direction of the data transfer
+  @param  Data                  The buffer to hold data
+  @param  DataLen               The length of the data
+  @param  Lun                   The number of logic unit
+  @param  Timeout               The time to wait command
+  @param  Result                The CSW status of the command
+
+  @retval EFI_SUCCESS           The command is executed, its status is in Result.
+  @retval Other                 Failed to execute command
+
+**/
+EFI_STATUS
+UsbBotExecBatch (
+  IN  USB_BOT_PROTOCOL        *UsbBot,
+  IN  VOID                    *Cmd,
+  IN  UINT8                   CmdLen,
+  IN  EFI_USB_DATA_DIRECTION  DataDir,
+  IN  VOID                    *Data,
+  IN  UINT32                  DataLen,
+  IN  UINT8                   Lun,
+  IN  UINT32                  Timeout,
+  OUT UINT8                   *Result
+  )
+{
+  EDKII_USB_BULK_BATCH_REQUEST  Requests[3];
+  EDKII_USB_BULK_BATCH_REQUEST  *CbwRequest;
+  EDKII_USB_BULK_BATCH_REQUEST  *DataRequest;
+  EDKII_USB_BULK_BATCH_REQUEST  *CswRequest;
+  EFI_USB_ENDPOINT_DESCRIPTOR   *Endpoint;
+  USB_BOT_CBW                   Cbw;
+  USB_BOT_CSW                   Csw;
+  UINTN                         RequestCount;
+  UINTN                         BatchTimeout;
+  EFI_STATUS                    Status;
+
+  *Result = USB_BOT_COMMAND_ERROR;
+
+  UsbBotFillCbw (UsbBot, &Cbw, Cmd, CmdLen, DataDir, DataLen, Lun);
+  ZeroMem (&Csw, sizeof (USB_BOT_CSW));
+  ZeroMem (Requests, sizeof (Requests));
+
+  RequestCount                = 0;
+  CbwRequest                  = &Requests[RequestCount++];
+  CbwRequest->EndPointAddress = UsbBot->BulkOutEndpoint->EndpointAddress;
+  CbwRequest->Data            = &Cbw;
+  CbwRequest->DataLength      = sizeof (USB_BOT_CBW);
+
+  DataRequest = NULL;
+  Endpoint    = NULL;
+  if ((DataDir != EfiUsbNoData) && (DataLen != 0)) {
+    Endpoint                     = (DataDir == EfiUsbDataIn) ? UsbBot->BulkInEndpoint : UsbBot->BulkOutEndpoint;
+    DataRequest                  = &Requests[RequestCount++];
+    DataRequest->EndPointAddress = Endpoint->EndpointAddress;
+    DataRequest->Data            = Data;
+    DataRequest->DataLength      = DataLen;
+  }
+
+  CswRequest                  = &Requests[RequestCount++];
+  CswRequest->EndPointAddress = UsbBot->BulkInEndpoint->EndpointAddress;
+  CswRequest->Data            = &Csw;
+  CswRequest->DataLength      = sizeof (USB_BOT_CSW);
+
+  //
+  // The batch gets the time of the three phases.
+  //
+  BatchTimeout = 0;
+  if (Timeout != 0) {
+    BatchTimeout = (USB_BOT_SEND_CBW_TIMEOUT + Timeout + USB_BOT_RECV_CSW_TIMEOUT) / USB_MASS_1_MILLISECOND;
+  }
+
+  UsbBot->BulkBatch->BulkTransfer (UsbBot->BulkBatch, RequestCount, Requests, BatchTimeout);
+
+  //
+  // Command phase, return immediately if device rejects the command.
+  //
+  Status = CbwRequest->Status;
+  if (EFI_ERROR (Status)) {
+    if (USB_IS_ERROR (CbwRequest->TransferResult, EFI_USB_ERR_STALL) && (DataDir == EfiUsbDataOut)) {
+      UsbBotResetDevice (UsbBot, FALSE);
+    } else if (USB_IS_ERROR (CbwRequest->TransferResult, EFI_USB_ERR_NAK)) {
+      Status = EFI_NOT_READY;
+    }
+
+    return Status;
+  }
+
+  //
+  // Data phase, the host should attempt to receive the CSW no matter
+  // whether it succeeds or fails.
+  //
+  if ((DataRequest != NULL) && EFI_ERROR (DataRequest->Status)) {
+    if (USB_IS_ERROR (DataRequest->TransferResult, EFI_USB_ERR_STALL)) {
+      DEBUG ((DEBUG_INFO, "UsbBotExecBatch: Data Stall\n"));
+      UsbClearEndpointStall (UsbBot->UsbIo, Endpoint->EndpointAddress);
+    } else if (DataRequest->Status == EFI_TIMEOUT) {
+      UsbBotResetDevice (UsbBot, FALSE);
+    }
+  }
+
+  //
+  // Status phase, read the CSW again if the batched read failed.
+  //
+  if (EFI_ERROR (CswRequest->Status)) {
+    if (USB_IS_ERROR (CswRequest->TransferResult, EFI_USB_ERR_STALL)) {
+      UsbClearEndpointStall (UsbBot->UsbIo, CswRequest->EndPointAddress);
+    }
+
+    return UsbBotGetStatus (UsbBot, DataLen, Result);
+  }
+
+  if ((Csw.Signature != USB_BOT_CSW_SIGNATURE) || (Csw.CmdStatus == USB_BOT_COMMAND_ERROR)) {
+    //
+    // CSW is invalid or reports a phase error, perform reset recovery.
+    //
+    Status = UsbBotResetDevice (UsbBot, FALSE);
+  } else {
+    *Result = Csw.CmdStatus;
+  }
+
+  //
+  // The tag is increased even if there is an error.
+  //
+  UsbBot->CbwTag++;
+
+  return Status;
+}
+
+// MU_CHANGE [END] - Batched bulk transfers
+
 /**
   Call the USB Mass Storage Class BOT protocol to issue
   the command/data/status circle to execute the commands.
@@ -410,6 +638,23 @@ UsbBotExecCommand (
   *CmdStatus = USB_MASS_CMD_FAIL;
   UsbBot     = (USB_BOT_PROTOCOL *)Context;
 
+  // MU_CHANGE [BEGIN] - Batched bulk transfers
+  if (UsbBot->BulkBatch != NULL) {
+    Status = UsbBotExecBatch (UsbBot, Cmd, CmdLen, DataDir, Data, DataLen, Lun, Timeout, &Result);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "UsbBotExecCommand: UsbBotExecBatch (%r)\n", Status));
+      return Status;
+    }
+
+    if (Result == 0) {
+      *CmdStatus = USB_MASS_CMD_SUCCESS;
+    }
+
+    return EFI_SUCCESS;
+  }
+
+  // MU_CHANGE [END] - Batched bulk transfers
+
   //
   // Send the command to the device. Return immediately if device
   // rejects the command.
@@ -81,6 +81,12 @@ typedef struct {
   EFI_USB_ENDPOINT_DESCRIPTOR     *BulkOutEndpoint;
   UINT32                          CbwTag;
   EFI_USB_IO_PROTOCOL             *UsbIo;
+  // MU_CHANGE [BEGIN] - Batched bulk transfers
+  //
+  // Batched bulk transfers of the interface, NULL if not supported.
+  //
+  EDKII_USB_IO_BULK_BATCH_PROTOCOL    *BulkBatch;
+  // MU_CHANGE [END] - Batched bulk transfers
 } USB_BOT_PROTOCOL;
 
 /**
@@ -184,4 +190,22 @@ UsbBotCleanUp (
   IN  VOID  *Context
   );
 
+// MU_CHANGE [BEGIN] - Bulk streams
+
+/**
+  Find the bulk batch protocol installed with a USB I/O protocol.
+
+  @param  UsbIo                 The USB I/O Protocol instance
+
+  @return The bulk batch protocol of the interface, or NULL if the host
+          controller doesn't support batched bulk transfers.
+
+**/
+EDKII_USB_IO_BULK_BATCH_PROTOCOL *
+UsbBotGetBulkBatch (
+  IN  EFI_USB_IO_PROTOCOL  *UsbIo
+  );
+
+// MU_CHANGE [END] - Bulk streams
+
 #endif
@@ -8,11 +8,12 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "UsbMass.h"
 
-#define USB_MASS_TRANSPORT_COUNT  3
+#define USB_MASS_TRANSPORT_COUNT  4 // MU_CHANGE - USB Attached SCSI transport
 //
 // Array of USB transport interfaces.
 //
 USB_MASS_TRANSPORT  *mUsbMassTransport[USB_MASS_TRANSPORT_COUNT] = {
+  &mUsbUasTransport, // MU_CHANGE - USB Attached SCSI transport, preferred to BOT
   &mUsbCbi0Transport,
   &mUsbCbi1Transport,
   &mUsbBotTransport,
@@ -366,6 +367,39 @@ UsbMassInitMedia (
   return Status;
 }
 
+// MU_CHANGE [BEGIN] - USB Attached SCSI transport
+
+/**
+  Check whether a transport protocol may drive an interface.
+
+  UAS devices also report the Bulk-Only Transport in their default setting,
+  with UAS in an alternate setting, so the UAS transport is tried on BOT
+  interfaces too. Without a context, its Init() only accepts an active UAS
+  setting, the alternate settings are only looked up when the driver starts.
+
+  @param  Interface       The interface descriptor of the active setting.
+  @param  Transport       The transport protocol.
+
+  @retval TRUE            The transport protocol may drive the interface.
+  @retval FALSE           The transport protocol doesn't match the interface.
+
+**/
+BOOLEAN
+UsbMassTransportMatch (
+  IN EFI_USB_INTERFACE_DESCRIPTOR  *Interface,
+  IN USB_MASS_TRANSPORT            *Transport
+  )
+{
+  if (Interface->InterfaceProtocol == Transport->Protocol) {
+    return TRUE;
+  }
+
+  return (BOOLEAN)((Transport->Protocol == USB_MASS_STORE_UAS) &&
+                   (Interface->InterfaceProtocol == USB_MASS_STORE_BOT));
+}
+
+// MU_CHANGE [END] - USB Attached SCSI transport
+
 /**
   Initialize the USB Mass Storage transport.
 
@@ -426,10 +460,20 @@ UsbMassInitTransport (
   for (Index = 0; Index < USB_MASS_TRANSPORT_COUNT; Index++) {
     *Transport = mUsbMassTransport[Index];
 
-    if (Interface.InterfaceProtocol == (*Transport)->Protocol) {
+    // MU_CHANGE [BEGIN] - USB Attached SCSI transport
+    if (UsbMassTransportMatch (&Interface, *Transport)) {
       Status = (*Transport)->Init (UsbIo, Context);
+      if (EFI_ERROR (Status) && ((*Transport)->Protocol == USB_MASS_STORE_UAS)) {
+        //
+        // Fall back to the Bulk-Only Transport of the default setting.
+        //
+        continue;
+      }
+
       break;
     }
+
+    // MU_CHANGE [END] - USB Attached SCSI transport
   }
 
   if (EFI_ERROR (Status)) {
@@ -751,10 +795,17 @@ USBMassDriverBindingSupported (
   //
   for (Index = 0; Index < USB_MASS_TRANSPORT_COUNT; Index++) {
     Transport = mUsbMassTransport[Index];
-    if (Interface.InterfaceProtocol == Transport->Protocol) {
+    // MU_CHANGE [BEGIN] - USB Attached SCSI transport
+    if (UsbMassTransportMatch (&Interface, Transport)) {
       Status = Transport->Init (UsbIo, NULL);
+      if (EFI_ERROR (Status) && (Transport->Protocol == USB_MASS_STORE_UAS)) {
+        continue;
+      }
+
       break;
     }
+
+    // MU_CHANGE [END] - USB Attached SCSI transport
   }
 
 ON_EXIT:
@@ -0,0 +1,1100 @@
+/** @file
+  Implementation of the USB Attached SCSI protocol, according to "Universal
+  Serial Bus Mass Storage Class - USB Attached SCSI Protocol (UASP)",
+  Revision 1.0.
+
+  The commands are tagged and several of them can be in flight at once. The
+  device tells on the status pipe which command it is ready to transfer the
+  data of, with a READ READY or WRITE READY IU, then completes the command
+  with a SENSE IU.
+
+  The status and data pipes of SuperSpeed devices have a stream per tag
+  instead, the device moves the data and the SENSE IU of a command on the
+  streams of its tag, without READ READY or WRITE READY IUs. EFI_USB_IO_PROTOCOL
+  can't transfer on a stream, these devices are driven through
+  EDKII_USB_IO_BULK_BATCH_PROTOCOL, and keep using their Bulk-Only Transport
+  setting when the host controller doesn't produce it.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "UsbMass.h"
+
+//
+// Definition of USB UAS Transport Protocol
+//
+USB_MASS_TRANSPORT  mUsbUasTransport = {
+  USB_MASS_STORE_UAS,
+  UsbUasInit,
+  UsbUasExecCommand,
+  UsbUasResetDevice,
+  UsbUasGetMaxLun,
+  UsbUasCleanUp,
+  UsbUasExecCommands
+};
+
+/**
+  Read the whole configuration descriptor of the active configuration.
+
+  The USB bus driver doesn't keep the class specific descriptors of the
+  interfaces, so they are read again from the device.
+
+  @param  UsbIo                 The USB I/O Protocol instance
+  @param  Config                Return the configuration descriptor, to be
+                                freed by the caller
+
+  @retval EFI_SUCCESS           The configuration descriptor is read.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate the buffer.
+  @retval Others                Failed to read the descriptor.
+
+**/
+EFI_STATUS
+UsbUasGetConfigDescriptor (
+  IN  EFI_USB_IO_PROTOCOL        *UsbIo,
+  OUT EFI_USB_CONFIG_DESCRIPTOR  **Config
+  )
+{
+  EFI_USB_DEVICE_DESCRIPTOR  DevDesc;
+  EFI_USB_CONFIG_DESCRIPTOR  ActiveDesc;
+  EFI_USB_CONFIG_DESCRIPTOR  Desc;
+  EFI_USB_DEVICE_REQUEST     Request;
+  EFI_STATUS                 Status;
+  UINT32                     Result;
+  UINT32                     Timeout;
+  UINT8                      Index;
+
+  Status = UsbIo->UsbGetDeviceDescriptor (UsbIo, &DevDesc);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = UsbIo->UsbGetConfigDescriptor (UsbIo, &ActiveDesc);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Request.RequestType = USB_DEV_GET_DESCRIPTOR_REQ_TYPE;
+  Request.Request     = USB_REQ_GET_DESCRIPTOR;
+  Request.Index       = 0;
+  Timeout             = USB_UAS_SEND_IU_TIMEOUT / USB_MASS_1_MILLISECOND;
+
+  //
+  // The descriptor index isn't the configuration value, look for the
+  // configuration whose value is the active one.
+  //
+  for (Index = 0; Index < DevDesc.NumConfigurations; Index++) {
+    Request.Value  = (UINT16)((USB_DESC_TYPE_CONFIG << 8) | Index);
+    Request.Length = sizeof (EFI_USB_CONFIG_DESCRIPTOR);
+    Status         = UsbIo->UsbControlTransfer (
+                              UsbIo,
+                              &Request,
+                              EfiUsbDataIn,
+                              Timeout,
+                              &Desc,
+                              sizeof (EFI_USB_CONFIG_DESCRIPTOR),
+                              &Result
+                              );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    if ((Desc.ConfigurationValue != ActiveDesc.ConfigurationValue) ||
+        (Desc.TotalLength < sizeof (EFI_USB_CONFIG_DESCRIPTOR)))
+    {
+      continue;
+    }
+
+    *Config = AllocateZeroPool (Desc.TotalLength);
+    if (*Config == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Request.Length = Desc.TotalLength;
+    Status         = UsbIo->UsbControlTransfer (
+                              UsbIo,
+                              &Request,
+                              EfiUsbDataIn,
+                              Timeout,
+                              *Config,
+                              Desc.TotalLength,
+                              &Result
+                              );
+    if (EFI_ERROR (Status) || ((*Config)->TotalLength != Desc.TotalLength)) {
+      FreePool (*Config);
+      *Config = NULL;
+      return EFI_DEVICE_ERROR;
+    }
+
+    return EFI_SUCCESS;
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Find the UAS alternate setting of the interface and its four pipes in the
+  configuration descriptor.
+
+  @param  UsbUas                The USB UAS device, its Interface field is
+                                updated to the UAS setting.
+  @param  Config                The configuration descriptor
+
+  @retval EFI_SUCCESS           The UAS setting is found.
+  @retval EFI_UNSUPPORTED       The interface has no UAS setting.
+
+**/
+EFI_STATUS
+UsbUasParseConfig (
+  IN OUT USB_UAS_PROTOCOL           *UsbUas,
+  IN     EFI_USB_CONFIG_DESCRIPTOR  *Config
+  )
+{
+  EFI_USB_INTERFACE_DESCRIPTOR  *Interface;
+  EFI_USB_ENDPOINT_DESCRIPTOR   *Endpoint;
+  UINT8                         *Desc;
+  UINTN                         Offset;
+  UINT8                         EndpointAddress;
+  BOOLEAN                       Found;
+  BOOLEAN                       Streams;
+
+  EndpointAddress = 0;
+  Found           = FALSE;
+  Streams         = FALSE;
+
+  for (Offset = Config->Length; Offset + 2 <= Config->TotalLength; Offset += Desc[0]) {
+    Desc = (UINT8 *)Config + Offset;
+    if ((Desc[0] < 2) || (Offset + Desc[0] > Config->TotalLength)) {
+      break;
+    }
+
+    if (Desc[1] == USB_DESC_TYPE_INTERFACE) {
+      if (Found) {
+        //
+        // The descriptors of the UAS setting end with the next interface.
+        //
+        break;
+      }
+
+      Interface = (EFI_USB_INTERFACE_DESCRIPTOR *)Desc;
+      if ((Desc[0] >= sizeof (EFI_USB_INTERFACE_DESCRIPTOR)) &&
+          (Interface->InterfaceNumber == UsbUas->Interface.InterfaceNumber) &&
+          (Interface->InterfaceClass == USB_MASS_STORE_CLASS) &&
+          (Interface->InterfaceProtocol == USB_MASS_STORE_UAS))
+      {
+        CopyMem (&UsbUas->Interface, Interface, sizeof (EFI_USB_INTERFACE_DESCRIPTOR));
+        Found = TRUE;
+      }
+
+      continue;
+    }
+
+    if (!Found) {
+      continue;
+    }
+
+    if ((Desc[1] == USB_DESC_TYPE_ENDPOINT) && (Desc[0] >= sizeof (EFI_USB_ENDPOINT_DESCRIPTOR))) {
+      Endpoint        = (EFI_USB_ENDPOINT_DESCRIPTOR *)Desc;
+      EndpointAddress = 0;
+      if (USB_IS_BULK_ENDPOINT (Endpoint->Attributes)) {
+        EndpointAddress = Endpoint->EndpointAddress;
+      }
+    } else if ((Desc[1] == USB_UAS_DESC_TYPE_SS_COMPANION) && (Desc[0] >= 4)) {
+      //
+      // Bits 0~4 of bmAttributes are the MaxStreams of a bulk endpoint.
+      //
+      if ((Desc[3] & 0x1F) != 0) {
+        Streams = TRUE;
+      }
+    } else if ((Desc[1] == USB_UAS_DESC_TYPE_PIPE_USAGE) && (Desc[0] >= 3) && (EndpointAddress != 0)) {
+      switch (Desc[2]) {
+        case USB_UAS_PIPE_COMMAND:
+          UsbUas->CommandEndpoint = EndpointAddress;
+          break;
+        case USB_UAS_PIPE_STATUS:
+          UsbUas->StatusEndpoint = EndpointAddress;
+          break;
+        case USB_UAS_PIPE_DATA_IN:
+          UsbUas->DataInEndpoint = EndpointAddress;
+          break;
+        case USB_UAS_PIPE_DATA_OUT:
+          UsbUas->DataOutEndpoint = EndpointAddress;
+          break;
+        default:
+          break;
+      }
+
+      EndpointAddress = 0;
+    }
+  }
+
+  if (!Found) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Ask for a stream per command in flight.
+  //
+  if (Streams) {
+    UsbUas->StreamCount = USB_UAS_MAX_COMMANDS;
+  }
+
+  if ((UsbUas->CommandEndpoint == 0) || !USB_IS_OUT_ENDPOINT (UsbUas->CommandEndpoint) ||
+      (UsbUas->StatusEndpoint == 0) || !USB_IS_IN_ENDPOINT (UsbUas->StatusEndpoint) ||
+      (UsbUas->DataInEndpoint == 0) || !USB_IS_IN_ENDPOINT (UsbUas->DataInEndpoint) ||
+      (UsbUas->DataOutEndpoint == 0) || !USB_IS_OUT_ENDPOINT (UsbUas->DataOutEndpoint))
+  {
+    return EFI_UNSUPPORTED;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Select an alternate setting of the UAS interface.
+
+  @param  UsbUas                The USB UAS device
+  @param  AlternateSetting      The alternate setting to select
+
+  @retval EFI_SUCCESS           The setting is selected.
+  @retval Others                Failed to select the setting.
+
+**/
+EFI_STATUS
+UsbUasSelectSetting (
+  IN USB_UAS_PROTOCOL  *UsbUas,
+  IN UINT8             AlternateSetting
+  )
+{
+  EFI_USB_DEVICE_REQUEST  Request;
+  UINT32                  Result;
+
+  Request.RequestType = USB_DEV_SET_INTERFACE_REQ_TYPE;
+  Request.Request     = USB_REQ_SET_INTERFACE;
+  Request.Value       = AlternateSetting;
+  Request.Index       = UsbUas->Interface.InterfaceNumber;
+  Request.Length      = 0;
+
+  return UsbUas->UsbIo->UsbControlTransfer (
+                          UsbUas->UsbIo,
+                          &Request,
+                          EfiUsbNoData,
+                          USB_UAS_SEND_IU_TIMEOUT / USB_MASS_1_MILLISECOND,
+                          NULL,
+                          0,
+                          &Result
+                          );
+}
+
+/**
+  Allocate the streams of the status and data pipes, once the UAS setting is
+  selected.
+
+  @param  UsbUas                The USB UAS device, its StreamCount field is
+                                updated to the number of streams allocated.
+
+  @retval EFI_SUCCESS           The streams are allocated, or the pipes have
+                                no streams.
+  @retval Others                Failed to allocate the streams.
+
+**/
+EFI_STATUS
+UsbUasAllocateStreams (
+  IN OUT USB_UAS_PROTOCOL  *UsbUas
+  )
+{
+  UINT8       Endpoints[3];
+  UINT16      StreamCount;
+  EFI_STATUS  Status;
+
+  if (UsbUas->BulkBatch == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  Endpoints[0] = UsbUas->StatusEndpoint;
+  Endpoints[1] = UsbUas->DataInEndpoint;
+  Endpoints[2] = UsbUas->DataOutEndpoint;
+  StreamCount  = USB_UAS_MAX_COMMANDS;
+
+  Status = UsbUas->BulkBatch->AllocateStreams (UsbUas->BulkBatch, ARRAY_SIZE (Endpoints), Endpoints, &StreamCount);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (StreamCount == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  UsbUas->StreamCount = StreamCount;
+  return EFI_SUCCESS;
+}
+
+/**
+  Free the streams of the status and data pipes.
+
+  @param  UsbUas                The USB UAS device
+
+**/
+VOID
+UsbUasFreeStreams (
+  IN USB_UAS_PROTOCOL  *UsbUas
+  )
+{
+  UINT8  Endpoints[3];
+
+  if (UsbUas->BulkBatch == NULL) {
+    return;
+  }
+
+  Endpoints[0] = UsbUas->StatusEndpoint;
+  Endpoints[1] = UsbUas->DataInEndpoint;
+  Endpoints[2] = UsbUas->DataOutEndpoint;
+  UsbUas->BulkBatch->FreeStreams (UsbUas->BulkBatch, ARRAY_SIZE (Endpoints), Endpoints);
+}
+
+/**
+  Initializes USB UAS protocol.
+
+  If Context is NULL, this function only checks that the active setting of the
+  interface is a USB Attached SCSI interface, without accessing the device.
+  Otherwise it reads the configuration from the device to find the UAS
+  alternate setting of the interface, selects that setting and saves its
+  context, which is a USB_UAS_PROTOCOL structure, in the Context.
+
+  @param  UsbIo                 The USB I/O Protocol instance
+  @param  Context               The buffer to save the context to
+
+  @retval EFI_SUCCESS           The device is successfully initialized.
+  @retval EFI_UNSUPPORTED       The transport protocol doesn't support the device.
+  @retval Other                 The USB UAS initialization fails.
+
+**/
+EFI_STATUS
+UsbUasInit (
+  IN  EFI_USB_IO_PROTOCOL  *UsbIo,
+  OUT VOID                 **Context OPTIONAL
+  )
+{
+  USB_UAS_PROTOCOL              *UsbUas;
+  EFI_USB_CONFIG_DESCRIPTOR     *Config;
+  EFI_USB_INTERFACE_DESCRIPTOR  Interface;
+  EFI_STATUS                    Status;
+
+  if (Context == NULL) {
+    //
+    // The driver binding Supported() must not access the device, so the
+    // alternate settings can't be read there.
+    //
+    Status = UsbIo->UsbGetInterfaceDescriptor (UsbIo, &Interface);
+    if (!EFI_ERROR (Status) && (Interface.InterfaceProtocol != USB_MASS_STORE_UAS)) {
+      Status = EFI_UNSUPPORTED;
+    }
+
+    return Status;
+  }
+
+  UsbUas = AllocateZeroPool (sizeof (USB_UAS_PROTOCOL));
+  if (UsbUas == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  UsbUas->UsbIo = UsbIo;
+
+  Status = UsbIo->UsbGetInterfaceDescriptor (UsbIo, &UsbUas->Interface);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  if ((UsbUas->Interface.InterfaceProtocol != USB_MASS_STORE_BOT) &&
+      (UsbUas->Interface.InterfaceProtocol != USB_MASS_STORE_UAS))
+  {
+    Status = EFI_UNSUPPORTED;
+    goto ON_ERROR;
+  }
+
+  Config = NULL;
+  Status = UsbUasGetConfigDescriptor (UsbIo, &Config);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  Status = UsbUasParseConfig (UsbUas, Config);
+  FreePool (Config);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  if (UsbUas->StreamCount != 0) {
+    UsbUas->BulkBatch = UsbBotGetBulkBatch (UsbIo);
+    if (UsbUas->BulkBatch == NULL) {
+      DEBUG ((DEBUG_INFO, "UsbUasInit: The UAS pipes need bulk streams, which are not supported\n"));
+      Status = EFI_UNSUPPORTED;
+      goto ON_ERROR;
+    }
+  }
+
+  UsbUas->NextTag = 1;
+
+  //
+  // Switch the interface to the UAS setting, the USB bus driver then reports
+  // the endpoints of that setting.
+  //
+  Status = UsbUasSelectSetting (UsbUas, UsbUas->Interface.AlternateSetting);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "UsbUasInit: Failed to select the UAS setting - %r\n", Status));
+    goto ON_ERROR;
+  }
+
+  //
+  // Selecting the setting drops the streams of the pipes, they are allocated
+  // afterwards. The device is left to the Bulk-Only Transport if that fails.
+  //
+  Status = UsbUasAllocateStreams (UsbUas);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "UsbUasInit: Failed to allocate the bulk streams - %r\n", Status));
+    UsbUasSelectSetting (UsbUas, 0);
+    Status = EFI_UNSUPPORTED;
+    goto ON_ERROR;
+  }
+
+  DEBUG ((DEBUG_INFO, "UsbUasInit: Interface %d uses UAS, %d streams\n", UsbUas->Interface.InterfaceNumber, UsbUas->StreamCount));
+  *Context = UsbUas;
+  return EFI_SUCCESS;
+
+ON_ERROR:
+  FreePool (UsbUas);
+  return Status;
+}
+
+/**
+  Transfer the data of a command once the device is ready for it.
+
+  @param  UsbUas                The USB UAS device
+  @param  Command               The command
+  @param  Timeout               The time to wait the data, in milliseconds
+
+  @retval EFI_SUCCESS           The data is transferred.
+  @retval Others                Failed to transfer the data.
+
+**/
+EFI_STATUS
+UsbUasDataTransfer (
+  IN USB_UAS_PROTOCOL  *UsbUas,
+  IN USB_MASS_COMMAND  *Command,
+  IN UINT32            Timeout
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       Endpoint;
+  UINTN       TransLen;
+  UINT32      Result;
+
+  if (Command->DataDir == EfiUsbDataIn) {
+    Endpoint = UsbUas->DataInEndpoint;
+  } else {
+    Endpoint = UsbUas->DataOutEndpoint;
+  }
+
+  TransLen = Command->DataLen;
+  Result   = 0;
+  Status   = UsbUas->UsbIo->UsbBulkTransfer (
+                              UsbUas->UsbIo,
+                              Endpoint,
+                              Command->Data,
+                              &TransLen,
+                              Timeout,
+                              &Result
+                              );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "UsbUasDataTransfer: (%r) Result = %x\n", Status, Result));
+    if (USB_IS_ERROR (Result, EFI_USB_ERR_STALL)) {
+      UsbClearEndpointStall (UsbUas->UsbIo, Endpoint);
+    }
+  }
+
+  return Status;
+}
+
+/**
+  Keep the sense data of a SENSE IU reporting a failed command, for the
+  REQUEST SENSE command that follows.
+
+  @param  UsbUas                The USB UAS device
+  @param  SenseIu               The SENSE IU
+  @param  Length                The length of the SENSE IU received
+
+**/
+VOID
+UsbUasSaveSense (
+  IN USB_UAS_PROTOCOL  *UsbUas,
+  IN USB_UAS_SENSE_IU  *SenseIu,
+  IN UINTN             Length
+  )
+{
+  UsbUas->SenseLength = (UINT8)MIN (
+                                 SwapBytes16 (SenseIu->Length),
+                                 Length - OFFSET_OF (USB_UAS_SENSE_IU, SenseData)
+                                 );
+  CopyMem (UsbUas->SenseData, SenseIu->SenseData, UsbUas->SenseLength);
+  UsbUas->SenseValid = (BOOLEAN)(UsbUas->SenseLength != 0);
+}
+
+/**
+  Execute several tagged commands on pipes with a stream per tag.
+
+  The command IUs, and the status and data transfers of each command on the
+  streams of its tag, are queued in a single batch. The device moves the data
+  of a command before its SENSE IU, so the batch only waits for the status of
+  the commands, the data transfer of a command failing without data is
+  cancelled.
+
+  @param  UsbUas                The USB UAS device
+  @param  Commands              The commands to execute
+  @param  CommandCount          The number of commands, up to the stream count
+  @param  Lun                   The number of logic unit
+  @param  Timeout               The time to wait the commands, in milliseconds
+
+  @retval EFI_SUCCESS           The commands are executed, see the CmdStatus
+                                field of each command for its result.
+  @retval Other                 Failed to execute some commands, see the Status
+                                field of each command.
+
+**/
+EFI_STATUS
+UsbUasExecStreamCommands (
+  IN     USB_UAS_PROTOCOL  *UsbUas,
+  IN OUT USB_MASS_COMMAND  *Commands,
+  IN     UINTN             CommandCount,
+  IN     UINT8             Lun,
+  IN     UINT32            Timeout
+  )
+{
+  EDKII_USB_BULK_BATCH_REQUEST  Requests[3 * USB_UAS_MAX_COMMANDS];
+  EDKII_USB_BULK_BATCH_REQUEST  *Request;
+  USB_UAS_COMMAND_IU            CommandIus[USB_UAS_MAX_COMMANDS];
+  USB_UAS_SENSE_IU              StatusIus[USB_UAS_MAX_COMMANDS];
+  UINTN                         DataRequests[USB_UAS_MAX_COMMANDS];
+  EFI_STATUS                    Status;
+  UINTN                         RequestCount;
+  UINTN                         Index;
+  UINTN                         Len;
+  UINT16                        Tag;
+
+  ZeroMem (Requests, sizeof (Requests));
+  RequestCount = 0;
+
+  //
+  // The tag of a command is the stream of its status and data, the tags are
+  // free again once the batch is over.
+  //
+  for (Index = 0; Index < CommandCount; Index++) {
+    ZeroMem (&CommandIus[Index], sizeof (USB_UAS_COMMAND_IU));
+    CommandIus[Index].Header.IuId   = USB_UAS_IU_COMMAND;
+    CommandIus[Index].Header.Tag    = SwapBytes16 ((UINT16)(Index + 1));
+    CommandIus[Index].TaskAttribute = USB_UAS_TASK_SIMPLE;
+    CommandIus[Index].Lun[1]        = Lun;
+    CopyMem (CommandIus[Index].Cdb, Commands[Index].Cmd, Commands[Index].CmdLen);
+
+    Request                  = &Requests[RequestCount++];
+    Request->EndPointAddress = UsbUas->CommandEndpoint;
+    Request->Data            = &CommandIus[Index];
+    Request->DataLength      = sizeof (USB_UAS_COMMAND_IU);
+  }
+
+  for (Index = 0; Index < CommandCount; Index++) {
+    Request                  = &Requests[RequestCount++];
+    Request->EndPointAddress = UsbUas->StatusEndpoint;
+    Request->Data            = &StatusIus[Index];
+    Request->DataLength      = sizeof (USB_UAS_SENSE_IU);
+    Request->StreamId        = (UINT16)(Index + 1);
+  }
+
+  for (Index = 0; Index < CommandCount; Index++) {
+    DataRequests[Index] = 0;
+    if ((Commands[Index].DataDir == EfiUsbNoData) || (Commands[Index].DataLen == 0)) {
+      continue;
+    }
+
+    DataRequests[Index]      = RequestCount;
+    Request                  = &Requests[RequestCount++];
+    Request->EndPointAddress = UsbUas->DataOutEndpoint;
+    if (Commands[Index].DataDir == EfiUsbDataIn) {
+      Request->EndPointAddress = UsbUas->DataInEndpoint;
+    }
+
+    Request->Data       = Commands[Index].Data;
+    Request->DataLength = Commands[Index].DataLen;
+    Request->StreamId   = (UINT16)(Index + 1);
+    Request->Optional   = TRUE;
+  }
+
+  Status = UsbUas->BulkBatch->BulkTransfer (UsbUas->BulkBatch, RequestCount, Requests, Timeout);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "UsbUasExecStreamCommands: (%r)\n", Status));
+  }
+
+  for (Index = 0; Index < CommandCount; Index++) {
+    Request = &Requests[CommandCount + Index];
+    if (EFI_ERROR (Request->Status)) {
+      Commands[Index].Status = Request->Status;
+      continue;
+    }
+
+    Tag = Request->StreamId;
+    Len = Request->DataLength;
+    if ((Len < sizeof (USB_UAS_IU_HEADER)) || (SwapBytes16 (StatusIus[Index].Header.Tag) != Tag)) {
+      DEBUG ((DEBUG_ERROR, "UsbUasExecStreamCommands: Unexpected status IU, tag %d\n", Tag));
+      Commands[Index].Status = EFI_DEVICE_ERROR;
+      Status                 = EFI_DEVICE_ERROR;
+      continue;
+    }
+
+    switch (StatusIus[Index].Header.IuId) {
+      case USB_UAS_IU_SENSE:
+        if (Len < OFFSET_OF (USB_UAS_SENSE_IU, SenseData)) {
+          Commands[Index].Status = EFI_DEVICE_ERROR;
+          Status                 = EFI_DEVICE_ERROR;
+          break;
+        }
+
+        Commands[Index].Status = EFI_SUCCESS;
+        if (StatusIus[Index].Status != USB_UAS_STATUS_GOOD) {
+          UsbUasSaveSense (UsbUas, &StatusIus[Index], Len);
+          break;
+        }
+
+        //
+        // The data of a successful command is moved before its status.
+        //
+        if ((DataRequests[Index] != 0) && EFI_ERROR (Requests[DataRequests[Index]].Status)) {
+          Commands[Index].Status = EFI_DEVICE_ERROR;
+          break;
+        }
+
+        Commands[Index].CmdStatus = USB_MASS_CMD_SUCCESS;
+        break;
+
+      case USB_UAS_IU_RESPONSE:
+        DEBUG ((DEBUG_ERROR, "UsbUasExecStreamCommands: Command rejected, tag %d\n", Tag));
+        Commands[Index].Status = EFI_DEVICE_ERROR;
+        break;
+
+      default:
+        Commands[Index].Status = EFI_DEVICE_ERROR;
+        Status                 = EFI_DEVICE_ERROR;
+        break;
+    }
+  }
+
+  //
+  // The device may still have some commands queued.
+  //
+  if (EFI_ERROR (Status)) {
+    UsbUasResetDevice (UsbUas, FALSE);
+    return Status;
+  }
+
+  for (Index = 0; Index < CommandCount; Index++) {
+    if (EFI_ERROR (Commands[Index].Status)) {
+      return Commands[Index].Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Execute several tagged commands through the USB UAS protocol.
+
+  All the commands are sent to the device before the status of the first one
+  is read, the device may then complete them in any order. On pipes with
+  streams, the commands are executed by batches of up to a command per stream.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL
+  @param  Commands              The commands to execute
+  @param  CommandCount          The number of commands, up to USB_UAS_MAX_COMMANDS
+  @param  Lun                   The number of logic unit
+  @param  Timeout               The time to wait each command
+
+  @retval EFI_SUCCESS           The commands are executed, see the CmdStatus
+                                field of each command for its result.
+  @retval Other                 Failed to execute some commands, see the Status
+                                field of each command.
+
+**/
+EFI_STATUS
+UsbUasExecCommands (
+  IN     VOID              *Context,
+  IN OUT USB_MASS_COMMAND  *Commands,
+  IN     UINTN             CommandCount,
+  IN     UINT8             Lun,
+  IN     UINT32            Timeout
+  )
+{
+  USB_UAS_PROTOCOL    *UsbUas;
+  USB_UAS_COMMAND_IU  CommandIu;
+  USB_UAS_SENSE_IU    *StatusIu;
+  UINT16              Tags[USB_UAS_MAX_COMMANDS];
+  EFI_STATUS          Status;
+  UINTN               Index;
+  UINTN               Pending;
+  UINTN               Len;
+  UINT32              Result;
+  UINT16              Tag;
+
+  if ((CommandCount == 0) || (CommandCount > USB_UAS_MAX_COMMANDS)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UsbUas             = (USB_UAS_PROTOCOL *)Context;
+  StatusIu           = &UsbUas->StatusIu;
+  UsbUas->SenseValid = FALSE;
+  Timeout            = Timeout / USB_MASS_1_MILLISECOND;
+  Status             = EFI_SUCCESS;
+
+  for (Index = 0; Index < CommandCount; Index++) {
+    Commands[Index].CmdStatus = USB_MASS_CMD_FAIL;
+    Commands[Index].Status    = EFI_NOT_READY;
+    if (Commands[Index].CmdLen > USB_UAS_MAX_CDBLEN) {
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  if (UsbUas->StreamCount != 0) {
+    for (Index = 0; Index < CommandCount; Index += Len) {
+      Len    = MIN (CommandCount - Index, UsbUas->StreamCount);
+      Status = UsbUasExecStreamCommands (UsbUas, &Commands[Index], Len, Lun, Timeout);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    }
+
+    for ( ; Index < CommandCount; Index++) {
+      if (Commands[Index].Status == EFI_NOT_READY) {
+        Commands[Index].Status = Status;
+      }
+    }
+
+    return Status;
+  }
+
+  //
+  // Send all the command IUs, each with its own tag.
+  //
+  for (Pending = 0; Pending < CommandCount; Pending++) {
+    if (UsbUas->NextTag == 0) {
+      UsbUas->NextTag = 1;
+    }
+
+    Tags[Pending] = UsbUas->NextTag++;
+
+    ZeroMem (&CommandIu, sizeof (CommandIu));
+    CommandIu.Header.IuId    = USB_UAS_IU_COMMAND;
+    CommandIu.Header.Tag     = SwapBytes16 (Tags[Pending]);
+    CommandIu.TaskAttribute  = USB_UAS_TASK_SIMPLE;
+    CommandIu.Lun[1]         = Lun;
+    CopyMem (CommandIu.Cdb, Commands[Pending].Cmd, Commands[Pending].CmdLen);
+
+    Len    = sizeof (CommandIu);
+    Result = 0;
+    Status = UsbUas->UsbIo->UsbBulkTransfer (
+                              UsbUas->UsbIo,
+                              UsbUas->CommandEndpoint,
+                              &CommandIu,
+                              &Len,
+                              USB_UAS_SEND_IU_TIMEOUT / USB_MASS_1_MILLISECOND,
+                              &Result
+                              );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "UsbUasExecCommands: Send command IU (%r) Result = %x\n", Status, Result));
+      if (USB_IS_ERROR (Result, EFI_USB_ERR_STALL)) {
+        UsbClearEndpointStall (UsbUas->UsbIo, UsbUas->CommandEndpoint);
+      }
+
+      break;
+    }
+  }
+
+  //
+  // Serve the IUs of the status pipe until the commands sent are completed.
+  //
+  while (!EFI_ERROR (Status)) {
+    for (Index = 0; Index < Pending; Index++) {
+      if (Commands[Index].Status == EFI_NOT_READY) {
+        break;
+      }
+    }
+
+    if (Index == Pending) {
+      break;
+    }
+
+    Len    = sizeof (USB_UAS_SENSE_IU);
+    Result = 0;
+    Status = UsbUas->UsbIo->UsbBulkTransfer (
+                              UsbUas->UsbIo,
+                              UsbUas->StatusEndpoint,
+                              StatusIu,
+                              &Len,
+                              Timeout,
+                              &Result
+                              );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "UsbUasExecCommands: Receive status IU (%r) Result = %x\n", Status, Result));
+      if (USB_IS_ERROR (Result, EFI_USB_ERR_STALL)) {
+        UsbClearEndpointStall (UsbUas->UsbIo, UsbUas->StatusEndpoint);
+      }
+
+      break;
+    }
+
+    //
+    // Find the pending command of the tag.
+    //
+    Tag = SwapBytes16 (StatusIu->Header.Tag);
+    for (Index = 0; Index < Pending; Index++) {
+      if ((Tags[Index] == Tag) && (Commands[Index].Status == EFI_NOT_READY)) {
+        break;
+      }
+    }
+
+    if ((Len < sizeof (USB_UAS_IU_HEADER)) || (Index == Pending)) {
+      DEBUG ((DEBUG_ERROR, "UsbUasExecCommands: Unexpected status IU, tag %d\n", Tag));
+      Status = EFI_DEVICE_ERROR;
+      break;
+    }
+
+    switch (StatusIu->Header.IuId) {
+      case USB_UAS_IU_READ_READY:
+      case USB_UAS_IU_WRITE_READY:
+        if (((StatusIu->Header.IuId == USB_UAS_IU_READ_READY) && (Commands[Index].DataDir != EfiUsbDataIn)) ||
+            ((StatusIu->Header.IuId == USB_UAS_IU_WRITE_READY) && (Commands[Index].DataDir != EfiUsbDataOut)))
+        {
+          Status = EFI_DEVICE_ERROR;
+          break;
+        }
+
+        Status = UsbUasDataTransfer (UsbUas, &Commands[Index], Timeout);
+        break;
+
+      case USB_UAS_IU_SENSE:
+        if (Len < OFFSET_OF (USB_UAS_SENSE_IU, SenseData)) {
+          Status = EFI_DEVICE_ERROR;
+          break;
+        }
+
+        Commands[Index].Status = EFI_SUCCESS;
+        if (StatusIu->Status == USB_UAS_STATUS_GOOD) {
+          Commands[Index].CmdStatus = USB_MASS_CMD_SUCCESS;
+          break;
+        }
+
+        UsbUasSaveSense (UsbUas, StatusIu, Len);
+        break;
+
+      case USB_UAS_IU_RESPONSE:
+        DEBUG ((DEBUG_ERROR, "UsbUasExecCommands: Command rejected, tag %d\n", Tag));
+        Commands[Index].Status = EFI_DEVICE_ERROR;
+        break;
+
+      default:
+        Status = EFI_DEVICE_ERROR;
+        break;
+    }
+  }
+
+  //
+  // Fail the commands the device didn't complete, and bring the device back
+  // to a known state as it may still have some of them queued.
+  //
+  if (EFI_ERROR (Status)) {
+    for (Index = 0; Index < CommandCount; Index++) {
+      if (Commands[Index].Status == EFI_NOT_READY) {
+        Commands[Index].Status = Status;
+      }
+    }
+
+    if (Pending != 0) {
+      UsbUasResetDevice (UsbUas, FALSE);
+    }
+
+    return Status;
+  }
+
+  for (Index = 0; Index < CommandCount; Index++) {
+    if (EFI_ERROR (Commands[Index].Status)) {
+      return Commands[Index].Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Execute a command through the USB UAS protocol.
+
+  The device reports the sense data of a failed command with its status, so
+  the REQUEST SENSE command that follows is answered from that.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL
+  @param  Cmd                   The high level command
+  @param  CmdLen                The command length
+  @param  DataDir               The direction of the data transfer
+  @param  Data                  The buffer to hold data
+  @param  DataLen               The length of the data
+  @param  Lun                   The number of logic unit
+  @param  Timeout               The time to wait command
+  @param  CmdStatus             The result of high level command execution
+
+  @retval EFI_SUCCESS           The command is executed successfully.
+  @retval Other                 Failed to execute command
+
+**/
+EFI_STATUS
+UsbUasExecCommand (
+  IN  VOID                    *Context,
+  IN  VOID                    *Cmd,
+  IN  UINT8                   CmdLen,
+  IN  EFI_USB_DATA_DIRECTION  DataDir,
+  IN  VOID                    *Data,
+  IN  UINT32                  DataLen,
+  IN  UINT8                   Lun,
+  IN  UINT32                  Timeout,
+  OUT UINT32                  *CmdStatus
+  )
+{
+  USB_UAS_PROTOCOL  *UsbUas;
+  USB_MASS_COMMAND  Command;
+  EFI_STATUS        Status;
+
+  UsbUas = (USB_UAS_PROTOCOL *)Context;
+
+  if ((*(UINT8 *)Cmd == USB_BOOT_REQUEST_SENSE_OPCODE) && UsbUas->SenseValid && (DataDir == EfiUsbDataIn)) {
+    ZeroMem (Data, DataLen);
+    CopyMem (Data, UsbUas->SenseData, MIN (DataLen, UsbUas->SenseLength));
+    UsbUas->SenseValid = FALSE;
+    *CmdStatus         = USB_MASS_CMD_SUCCESS;
+    return EFI_SUCCESS;
+  }
+
+  Command.Cmd     = Cmd;
+  Command.CmdLen  = CmdLen;
+  Command.DataDir = DataDir;
+  Command.Data    = Data;
+  Command.DataLen = DataLen;
+
+  Status     = UsbUasExecCommands (UsbUas, &Command, 1, Lun, Timeout);
+  *CmdStatus = Command.CmdStatus;
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "UsbUasExecCommand: (%r)\n", Status));
+  }
+
+  return Status;
+}
+
+/**
+  Reset the USB mass storage device by UAS protocol.
+
+  The device is reset through its port, then the UAS alternate setting is
+  selected again, with the streams of its pipes.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL.
+  @param  ExtendedVerification  The flag controlling the rule of reset.
+                                Not used here.
+
+  @retval EFI_SUCCESS           The device is reset.
+  @retval Others                Failed to reset the device.
+
+**/
+EFI_STATUS
+UsbUasResetDevice (
+  IN  VOID     *Context,
+  IN  BOOLEAN  ExtendedVerification
+  )
+{
+  USB_UAS_PROTOCOL  *UsbUas;
+  EFI_STATUS        Status;
+
+  UsbUas             = (USB_UAS_PROTOCOL *)Context;
+  UsbUas->SenseValid = FALSE;
+
+  //
+  // UAS has no class specific reset request, the port reset also drops
+  // the queued commands. It restores the configuration but not the setting
+  // of the interface.
+  //
+  Status = UsbUas->UsbIo->UsbPortReset (UsbUas->UsbIo);
+  if (EFI_ERROR (Status)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Status = UsbUasSelectSetting (UsbUas, UsbUas->Interface.AlternateSetting);
+  if (EFI_ERROR (Status)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Status = UsbUasAllocateStreams (UsbUas);
+  if (EFI_ERROR (Status)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Get the max LUN (Logical Unit Number) of USB mass storage device.
+
+  Only the first logical unit is supported over UAS.
+
+  @param  Context          The context of the UAS protocol, that is, USB_UAS_PROTOCOL
+  @param  MaxLun           Return pointer to the max number of LUN.
+
+  @retval EFI_SUCCESS      Max LUN is got successfully.
+
+**/
+EFI_STATUS
+UsbUasGetMaxLun (
+  IN  VOID   *Context,
+  OUT UINT8  *MaxLun
+  )
+{
+  if ((Context == NULL) || (MaxLun == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *MaxLun = 0;
+  return EFI_SUCCESS;
+}
+
+/**
+  Clean up the resource used by this UAS protocol layer.
+
+  The streams are freed and the interface is switched back to its default
+  setting.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL.
+
+  @retval EFI_SUCCESS           The resource is cleaned up.
+
+**/
+EFI_STATUS
+UsbUasCleanUp (
+  IN  VOID  *Context
+  )
+{
+  USB_UAS_PROTOCOL  *UsbUas;
+
+  UsbUas = (USB_UAS_PROTOCOL *)Context;
+  UsbUasFreeStreams (UsbUas);
+  if (UsbUas->Interface.AlternateSetting != 0) {
+    UsbUasSelectSetting (UsbUas, 0);
+  }
+
+  FreePool (UsbUas);
+  return EFI_SUCCESS;
+}
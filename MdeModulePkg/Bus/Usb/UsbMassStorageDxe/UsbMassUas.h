@@ -0,0 +1,266 @@
+/** @file
+  Definition for the USB Attached SCSI protocol, based on "Universal Serial
+  Bus Mass Storage Class - USB Attached SCSI Protocol (UASP)", Revision 1.0.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _EFI_USBMASS_UAS_H_
+#define _EFI_USBMASS_UAS_H_
+
+extern USB_MASS_TRANSPORT  mUsbUasTransport;
+
+#define USB_MASS_STORE_UAS  0x62            ///< USB Attached SCSI
+
+//
+// Descriptors of the UAS interface. Each bulk endpoint is followed by a pipe
+// usage descriptor giving its role [UAS-5.3.3].
+//
+#define USB_UAS_DESC_TYPE_PIPE_USAGE    0x24
+#define USB_UAS_DESC_TYPE_SS_COMPANION  0x30  ///< SuperSpeed endpoint companion
+
+#define USB_UAS_PIPE_COMMAND   0x01
+#define USB_UAS_PIPE_STATUS    0x02
+#define USB_UAS_PIPE_DATA_IN   0x03
+#define USB_UAS_PIPE_DATA_OUT  0x04
+
+//
+// Information unit IDs [UAS-6.2]
+//
+#define USB_UAS_IU_COMMAND      0x01
+#define USB_UAS_IU_SENSE        0x03
+#define USB_UAS_IU_RESPONSE     0x04
+#define USB_UAS_IU_READ_READY   0x06
+#define USB_UAS_IU_WRITE_READY  0x07
+
+#define USB_UAS_TASK_SIMPLE  0x00           ///< Simple task attribute
+#define USB_UAS_STATUS_GOOD  0x00           ///< SCSI status of a successful command
+
+#define USB_UAS_MAX_CDBLEN    16
+#define USB_UAS_MAX_SENSELEN  252
+
+//
+// Number of tagged commands in flight, set by experience
+//
+#define USB_UAS_MAX_COMMANDS  4
+
+//
+// Usb UAS transport timeout, set by experience
+//
+#define USB_UAS_SEND_IU_TIMEOUT  (3 * USB_MASS_1_SECOND)
+
+#pragma pack(1)
+///
+/// The header shared by all the information units, and the whole of the
+/// READ READY and WRITE READY IUs.
+///
+typedef struct {
+  UINT8     IuId;
+  UINT8     Reserved;
+  UINT16    Tag;                        ///< Big endian
+} USB_UAS_IU_HEADER;
+
+///
+/// The COMMAND IU, sent on the command pipe.
+///
+typedef struct {
+  USB_UAS_IU_HEADER    Header;
+  UINT8                TaskAttribute;   ///< Bits 0~2 are the task attribute
+  UINT8                Reserved0;
+  UINT8                AddCdbLen;       ///< Additional CDB length in dwords, bits 2~7
+  UINT8                Reserved1;
+  UINT8                Lun[8];
+  UINT8                Cdb[USB_UAS_MAX_CDBLEN];
+} USB_UAS_COMMAND_IU;
+
+///
+/// The SENSE IU, received on the status pipe when a command completes.
+///
+typedef struct {
+  USB_UAS_IU_HEADER    Header;
+  UINT16               StatusQualifier;
+  UINT8                Status;          ///< SCSI status of the command
+  UINT8                Reserved[7];
+  UINT16               Length;          ///< Big endian length of SenseData
+  UINT8                SenseData[USB_UAS_MAX_SENSELEN];
+} USB_UAS_SENSE_IU;
+
+///
+/// The RESPONSE IU, received on the status pipe when a command is rejected.
+///
+typedef struct {
+  USB_UAS_IU_HEADER    Header;
+  UINT8                AdditionalInfo[3];
+  UINT8                ResponseCode;
+} USB_UAS_RESPONSE_IU;
+#pragma pack()
+
+typedef struct {
+  //
+  // Put Interface at the first field to make it easy to distinguish BOT/CBI/UAS Protocol instance
+  //
+  EFI_USB_INTERFACE_DESCRIPTOR    Interface;
+  UINT8                           CommandEndpoint;
+  UINT8                           StatusEndpoint;
+  UINT8                           DataInEndpoint;
+  UINT8                           DataOutEndpoint;
+  UINT16                          NextTag;
+  EFI_USB_IO_PROTOCOL             *UsbIo;
+  //
+  // The SuperSpeed pipes of the status and data phases have a stream per
+  // tag, StreamCount is non zero then, and the commands go through BulkBatch.
+  //
+  EDKII_USB_IO_BULK_BATCH_PROTOCOL    *BulkBatch;
+  UINT16                              StreamCount;
+  //
+  // Buffer of the status pipe.
+  //
+  USB_UAS_SENSE_IU                StatusIu;
+  //
+  // Sense data of the last command that failed, returned to the next
+  // REQUEST SENSE command as the device has already reported it.
+  //
+  BOOLEAN                         SenseValid;
+  UINT8                           SenseLength;
+  UINT8                           SenseData[USB_UAS_MAX_SENSELEN];
+} USB_UAS_PROTOCOL;
+
+/**
+  Initializes USB UAS protocol.
+
+  If Context is NULL, this function only checks that the active setting of the
+  interface is a USB Attached SCSI interface, without accessing the device.
+  Otherwise it reads the configuration from the device to find the UAS
+  alternate setting of the interface, selects that setting and saves its
+  context, which is a USB_UAS_PROTOCOL structure, in the Context.
+
+  @param  UsbIo                 The USB I/O Protocol instance
+  @param  Context               The buffer to save the context to
+
+  @retval EFI_SUCCESS           The device is successfully initialized.
+  @retval EFI_UNSUPPORTED       The transport protocol doesn't support the device.
+  @retval Other                 The USB UAS initialization fails.
+
+**/
+EFI_STATUS
+UsbUasInit (
+  IN  EFI_USB_IO_PROTOCOL  *UsbIo,
+  OUT VOID                 **Context OPTIONAL
+  );
+
+/**
+  Execute a command through the USB UAS protocol.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL
+  @param  Cmd                   The high level command
+  @param  CmdLen                The command length
+  @param  DataDir               The direction of the data transfer
+  @param  Data                  The buffer to hold data
+  @param  DataLen               The length of the data
+  @param  Lun                   The number of logic unit
+  @param  Timeout               The time to wait command
+  @param  CmdStatus             The result of high level command execution
+
+  @retval EFI_SUCCESS           The command is executed successfully.
+  @retval Other                 Failed to execute command
+
+**/
+EFI_STATUS
+UsbUasExecCommand (
+  IN  VOID                    *Context,
+  IN  VOID                    *Cmd,
+  IN  UINT8                   CmdLen,
+  IN  EFI_USB_DATA_DIRECTION  DataDir,
+  IN  VOID                    *Data,
+  IN  UINT32                  DataLen,
+  IN  UINT8                   Lun,
+  IN  UINT32                  Timeout,
+  OUT UINT32                  *CmdStatus
+  );
+
+/**
+  Execute several tagged commands through the USB UAS protocol.
+
+  All the commands are sent to the device before the status of the first one
+  is read, the device may then complete them in any order.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL
+  @param  Commands              The commands to execute
+  @param  CommandCount          The number of commands, up to USB_UAS_MAX_COMMANDS
+  @param  Lun                   The number of logic unit
+  @param  Timeout               The time to wait each command
+
+  @retval EFI_SUCCESS           The commands are executed, see the CmdStatus
+                                field of each command for its result.
+  @retval Other                 Failed to execute some commands, see the Status
+                                field of each command.
+
+**/
+EFI_STATUS
+UsbUasExecCommands (
+  IN     VOID              *Context,
+  IN OUT USB_MASS_COMMAND  *Commands,
+  IN     UINTN             CommandCount,
+  IN     UINT8             Lun,
+  IN     UINT32            Timeout
+  );
+
+/**
+  Reset the USB mass storage device by UAS protocol.
+
+  The device is reset through its port, then the UAS alternate setting is
+  selected again.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL.
+  @param  ExtendedVerification  The flag controlling the rule of reset.
+                                Not used here.
+
+  @retval EFI_SUCCESS           The device is reset.
+  @retval Others                Failed to reset the device.
+
+**/
+EFI_STATUS
+UsbUasResetDevice (
+  IN  VOID     *Context,
+  IN  BOOLEAN  ExtendedVerification
+  );
+
+/**
+  Get the max LUN (Logical Unit Number) of USB mass storage device.
+
+  Only the first logical unit is supported over UAS.
+
+  @param  Context          The context of the UAS protocol, that is, USB_UAS_PROTOCOL
+  @param  MaxLun           Return pointer to the max number of LUN.
+
+  @retval EFI_SUCCESS      Max LUN is got successfully.
+
+**/
+EFI_STATUS
+UsbUasGetMaxLun (
+  IN  VOID   *Context,
+  OUT UINT8  *MaxLun
+  );
+
+/**
+  Clean up the resource used by this UAS protocol layer.
+
+  The interface is switched back to its default setting.
+
+  @param  Context               The context of the UAS protocol, that is,
+                                USB_UAS_PROTOCOL.
+
+  @retval EFI_SUCCESS           The resource is cleaned up.
+
+**/
+EFI_STATUS
+UsbUasCleanUp (
+  IN  VOID  *Context
+  );
+
+#endif
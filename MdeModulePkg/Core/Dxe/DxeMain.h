@@ -65,6 +65,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/VectorHandoffTable.h>
 #include <Ppi/VectorHandoffInfo.h>
 #include <Guid/MemoryProfile.h>
+#include <Guid/GuidHobIndex.h>   // MU_CHANGE
 
 #include <Library/DxeCoreEntryPoint.h>
 #include <Library/DebugLib.h>
@@ -2321,6 +2322,41 @@ OpenSectionStream (
   OUT UINTN     *SectionStreamHandle
   );
 
+// MU_CHANGE [BEGIN] - Cache decoded section streams
+
+/**
+  Creates and returns a new section stream handle for the sections of a file
+  in a firmware volume.
+
+  This function behaves as OpenSectionStream (), except that the encapsulation
+  sections decoded from the stream are kept in the decoded section cache under
+  FvHandle and FileName, so that a later stream over the same file does not
+  run the decompression or the GUIDed section extraction again.
+
+  @param  SectionStreamLength    Size in bytes of the section stream.
+  @param  SectionStream          Buffer containing the new section stream.
+  @param  FvHandle               Handle of the firmware volume holding the file.
+  @param  FileName               Name of the file.
+  @param  SectionStreamHandle    A pointer to a caller allocated UINTN that on
+                                 output contains the new section stream handle.
+
+  @retval EFI_SUCCESS            The section stream is created successfully.
+  @retval EFI_OUT_OF_RESOURCES   memory allocation failed.
+  @retval EFI_INVALID_PARAMETER  Section stream does not end concident with end
+                                 of last section.
+
+**/
+EFI_STATUS
+OpenFileSectionStream (
+  IN     UINTN       SectionStreamLength,
+  IN     VOID        *SectionStream,
+  IN     EFI_HANDLE  FvHandle,
+  IN     EFI_GUID    *FileName,
+  OUT UINTN          *SectionStreamHandle
+  );
+
+// MU_CHANGE [END]
+
 /**
   SEP member function.  Retrieves requested section from section stream.
 
@@ -2428,6 +2464,25 @@ CoreInitializeDebugImageInfoTable (
   VOID
   );
 
+// MU_CHANGE [BEGIN] - GUID HOB index
+
+/**
+  Build the GUID HOB index of a HOB list and install it into the EFI System
+  Table's Configuration Table.
+
+  The index is an optimization only. If it cannot be built, the DXE HobLib
+  walks the HOB list.
+
+  @param  HobStart      The HOB list.
+
+**/
+VOID
+CoreInstallGuidHobIndex (
+  IN VOID  *HobStart
+  );
+
+// MU_CHANGE [END]
+
 /**
   Update the CRC32 in the Debug Table.
   Since the CRC32 service is made available by the Runtime driver, we have to
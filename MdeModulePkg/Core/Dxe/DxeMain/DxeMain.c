@@ -372,6 +372,13 @@ DxeMain (
   Status = CoreInstallConfigurationTable (&gEfiHobListGuid, HobStart);
   ASSERT_EFI_ERROR (Status);
 
+  // MU_CHANGE [BEGIN] - GUID HOB index
+  //
+  // Index the GUID HOBs of the final HOB list for the DXE HobLib
+  //
+  CoreInstallGuidHobIndex (HobStart);
+  // MU_CHANGE [END]
+
   //
   // Install Memory Type Information Table into the EFI System Tables's Configuration Table
   //
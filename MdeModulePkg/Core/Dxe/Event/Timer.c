@@ -13,9 +13,38 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 // Internal data
 //
 
-LIST_ENTRY  mEfiTimerList       = INITIALIZE_LIST_HEAD_VARIABLE (mEfiTimerList);
-EFI_LOCK    mEfiTimerLock       = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL - 1);
-EFI_EVENT   mEfiCheckTimerEvent = NULL;
+// MU_CHANGE [BEGIN] - Queue timers on a hierarchical timer wheel instead of a sorted list
+//
+// Timers are kept on a hierarchical timer wheel so that setting a timer does
+// not have to walk every queued timer. Time is counted in wheel ticks of
+// 2^TIMER_WHEEL_TICK_SHIFT 100ns units. Level N has TIMER_WHEEL_SLOTS slots of
+// TIMER_WHEEL_SLOTS^N ticks each, and holds the timers due less than
+// TIMER_WHEEL_SLOTS^(N+1) ticks after mEfiTimerWheelTick. Timers due further
+// away are kept on mEfiTimerOverflowList. Whenever the ticks of a level wrap,
+// the next slot of the level above is cascaded down, so the timers due in the
+// current tick are always on level 0.
+//
+// The slots of level 0 are sorted by trigger time, the other slots are not.
+// Timers with the same trigger time are kept in the order they were set, so
+// timers are signaled in the same order as with a single sorted list.
+//
+#define TIMER_WHEEL_TICK_SHIFT  16
+#define TIMER_WHEEL_SLOT_BITS   6
+#define TIMER_WHEEL_SLOTS       (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_LEVELS      4
+
+LIST_ENTRY  mEfiTimerWheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+LIST_ENTRY  mEfiTimerOverflowList = INITIALIZE_LIST_HEAD_VARIABLE (mEfiTimerOverflowList);
+UINT64      mEfiTimerWheelTick    = 0;
+UINTN       mEfiTimerCount        = 0;
+//
+// Lower bound of the trigger time of the queued timers, CoreTimerTick ()
+// signals mEfiCheckTimerEvent once the system time reaches it.
+//
+UINT64     mEfiTimerNextTrigger = MAX_UINT64;
+EFI_LOCK   mEfiTimerLock        = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL - 1);
+EFI_EVENT  mEfiCheckTimerEvent  = NULL;
+// MU_CHANGE [END]
 
 EFI_LOCK  mEfiSystemTimeLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL);
 UINT64    mEfiSystemTime     = 0;
@@ -24,41 +53,261 @@ UINT64    mEfiSystemTime     = 0;
 // Timer functions
 //
 
+// MU_CHANGE [BEGIN] - Queue timers on a hierarchical timer wheel instead of a sorted list
+
+UINT64
+CoreCurrentSystemTime (
+  VOID
+  );
+
 /**
-  Inserts the timer event.
+  Returns the timer wheel slot a timer is queued to.
+
+  @param  TriggerTime            The trigger time of the timer
+  @param  Level                  The level of the slot, TIMER_WHEEL_LEVELS for
+                                 the overflow list
+
+  @return The slot of the timer wheel, or the overflow list
+
+**/
+STATIC
+LIST_ENTRY *
+CoreTimerWheelSlot (
+  IN  UINT64  TriggerTime,
+  OUT UINTN   *Level
+  )
+{
+  UINT64  Tick;
+  UINT64  Delta;
+
+  //
+  // Timers that are already due go to the current tick
+  //
+  Tick = RShiftU64 (TriggerTime, TIMER_WHEEL_TICK_SHIFT);
+  if (Tick < mEfiTimerWheelTick) {
+    Tick = mEfiTimerWheelTick;
+  }
+
+  Delta = Tick - mEfiTimerWheelTick;
+  for (*Level = 0; *Level < TIMER_WHEEL_LEVELS; (*Level)++) {
+    if (RShiftU64 (Delta, TIMER_WHEEL_SLOT_BITS * (*Level + 1)) == 0) {
+      return &mEfiTimerWheel[*Level][(UINTN)RShiftU64 (Tick, TIMER_WHEEL_SLOT_BITS * *Level) & (TIMER_WHEEL_SLOTS - 1)];
+    }
+  }
+
+  return &mEfiTimerOverflowList;
+}
+
+/**
+  Queues a timer event to its timer wheel slot.
+
+  Timers are cascaded from the last one of a slot to the first one. A cascaded
+  timer was set before any timer with the same trigger time that is already in
+  the slot it is moved to, as it was set further ahead.
 
   @param  Event                  Points to the internal structure of timer event
-                                 to be installed
+                                 to be queued
+  @param  Cascaded               TRUE if the timer is moved down from a higher
+                                 level.
 
 **/
+STATIC
 VOID
-CoreInsertEventTimer (
-  IN IEVENT  *Event
+CoreQueueEventTimer (
+  IN IEVENT   *Event,
+  IN BOOLEAN  Cascaded
   )
 {
-  UINT64      TriggerTime;
+  LIST_ENTRY  *Slot;
   LIST_ENTRY  *Link;
   IEVENT      *Event2;
+  UINTN       Level;
+
+  Slot = CoreTimerWheelSlot (Event->Timer.TriggerTime, &Level);
+  if (Level != 0) {
+    if (Cascaded) {
+      InsertHeadList (Slot, &Event->Timer.Link);
+    } else {
+      InsertTailList (Slot, &Event->Timer.Link);
+    }
 
-  ASSERT_LOCKED (&mEfiTimerLock);
+    return;
+  }
 
-  //
-  // Get the timer's trigger time
-  //
-  TriggerTime = Event->Timer.TriggerTime;
+  if (Cascaded) {
+    //
+    // Insert before the first timer that does not trigger earlier
+    //
+    for (Link = Slot->ForwardLink; Link != Slot; Link = Link->ForwardLink) {
+      Event2 = CR (Link, IEVENT, Timer.Link, EVENT_SIGNATURE);
+      if (Event2->Timer.TriggerTime >= Event->Timer.TriggerTime) {
+        break;
+      }
+    }
+
+    InsertTailList (Link, &Event->Timer.Link);
+  } else {
+    //
+    // Insert after the last timer that does not trigger later. Timers are
+    // mostly set in increasing trigger time, so search from the tail.
+    //
+    for (Link = Slot->BackLink; Link != Slot; Link = Link->BackLink) {
+      Event2 = CR (Link, IEVENT, Timer.Link, EVENT_SIGNATURE);
+      if (Event2->Timer.TriggerTime <= Event->Timer.TriggerTime) {
+        break;
+      }
+    }
+
+    InsertHeadList (Link, &Event->Timer.Link);
+  }
+}
+
+/**
+  Moves the timers of a slot down to the slots of the lower levels, once the
+  current tick has reached the ticks covered by the slot.
+
+  @param  Slot                   The slot to cascade
+
+**/
+STATIC
+VOID
+CoreCascadeTimerSlot (
+  IN LIST_ENTRY  *Slot
+  )
+{
+  LIST_ENTRY  Timers;
+  IEVENT      *Event;
+
+  if (IsListEmpty (Slot)) {
+    return;
+  }
 
   //
-  // Insert the timer into the timer database in assending sorted order
+  // Detach the timers first, as some of them may be queued back to the same
+  // list.
   //
-  for (Link = mEfiTimerList.ForwardLink; Link != &mEfiTimerList; Link = Link->ForwardLink) {
-    Event2 = CR (Link, IEVENT, Timer.Link, EVENT_SIGNATURE);
+  InsertHeadList (Slot, &Timers);
+  RemoveEntryList (Slot);
+  InitializeListHead (Slot);
 
-    if (Event2->Timer.TriggerTime > TriggerTime) {
-      break;
+  while (!IsListEmpty (&Timers)) {
+    Event = CR (Timers.BackLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+    RemoveEntryList (&Event->Timer.Link);
+    CoreQueueEventTimer (Event, TRUE);
+  }
+}
+
+/**
+  Advances the timer wheel by one tick, cascading the levels that wrap.
+
+**/
+STATIC
+VOID
+CoreAdvanceTimerWheel (
+  VOID
+  )
+{
+  UINTN   Level;
+  UINT64  Tick;
+
+  mEfiTimerWheelTick++;
+
+  Tick = mEfiTimerWheelTick;
+  for (Level = 1; Level < TIMER_WHEEL_LEVELS; Level++) {
+    if (((UINTN)Tick & (TIMER_WHEEL_SLOTS - 1)) != 0) {
+      return;
     }
+
+    Tick = RShiftU64 (Tick, TIMER_WHEEL_SLOT_BITS);
+    CoreCascadeTimerSlot (&mEfiTimerWheel[Level][(UINTN)Tick & (TIMER_WHEEL_SLOTS - 1)]);
   }
 
-  InsertTailList (Link, &Event->Timer.Link);
+  if (((UINTN)Tick & (TIMER_WHEEL_SLOTS - 1)) == 0) {
+    CoreCascadeTimerSlot (&mEfiTimerOverflowList);
+  }
+}
+
+/**
+  Updates the time at which CoreTimerTick () is to check the timers next.
+
+  The timers due in the next TIMER_WHEEL_SLOTS ticks are on level 0. Timers on
+  the higher levels are only due after the end of level 0, where they have to
+  be cascaded down anyway.
+
+**/
+STATIC
+VOID
+CoreUpdateNextTimerTrigger (
+  VOID
+  )
+{
+  UINTN       Index;
+  LIST_ENTRY  *Slot;
+  IEVENT      *Event;
+
+  if (mEfiTimerCount == 0) {
+    mEfiTimerNextTrigger = MAX_UINT64;
+    return;
+  }
+
+  mEfiTimerNextTrigger = LShiftU64 ((mEfiTimerWheelTick | (TIMER_WHEEL_SLOTS - 1)) + 1, TIMER_WHEEL_TICK_SHIFT);
+  for (Index = 0; Index < TIMER_WHEEL_SLOTS; Index++) {
+    Slot = &mEfiTimerWheel[0][((UINTN)mEfiTimerWheelTick + Index) & (TIMER_WHEEL_SLOTS - 1)];
+    if (!IsListEmpty (Slot)) {
+      Event                = CR (Slot->ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+      mEfiTimerNextTrigger = MIN (mEfiTimerNextTrigger, Event->Timer.TriggerTime);
+      return;
+    }
+  }
+}
+
+/**
+  Removes a timer event from the timer wheel.
+
+  @param  Event                  Points to the internal structure of the queued
+                                 timer event
+
+**/
+STATIC
+VOID
+CoreRemoveEventTimer (
+  IN IEVENT  *Event
+  )
+{
+  RemoveEntryList (&Event->Timer.Link);
+  Event->Timer.Link.ForwardLink = NULL;
+  mEfiTimerCount--;
+}
+
+// MU_CHANGE [END]
+
+/**
+  Inserts the timer event.
+
+  @param  Event                  Points to the internal structure of timer event
+                                 to be installed
+
+**/
+VOID
+CoreInsertEventTimer (
+  IN IEVENT  *Event
+  )
+{
+  // MU_CHANGE [BEGIN] - Queue timers on a hierarchical timer wheel instead of a sorted list
+  ASSERT_LOCKED (&mEfiTimerLock);
+
+  //
+  // With no timer queued there is nothing to cascade, so the wheel can skip
+  // the ticks that went by since it was last advanced.
+  //
+  if (mEfiTimerCount == 0) {
+    mEfiTimerWheelTick = MAX (mEfiTimerWheelTick, RShiftU64 (CoreCurrentSystemTime (), TIMER_WHEEL_TICK_SHIFT));
+  }
+
+  CoreQueueEventTimer (Event, FALSE);
+  mEfiTimerCount++;
+  mEfiTimerNextTrigger = MIN (mEfiTimerNextTrigger, Event->Timer.TriggerTime);
+  // MU_CHANGE [END]
 }
 
 /**
@@ -96,8 +345,9 @@ CoreCheckTimers (
   IN VOID       *Context
   )
 {
-  UINT64  SystemTime;
-  IEVENT  *Event;
+  UINT64      SystemTime;
+  IEVENT      *Event;
+  LIST_ENTRY  *Slot;                                 // MU_CHANGE
 
   //
   // Check the timer database for expired timers
@@ -105,52 +355,68 @@ CoreCheckTimers (
   CoreAcquireLock (&mEfiTimerLock);
   SystemTime = CoreCurrentSystemTime ();
 
-  while (!IsListEmpty (&mEfiTimerList)) {
-    Event = CR (mEfiTimerList.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
-
-    //
-    // If this timer is not expired, then we're done
-    //
-    if (Event->Timer.TriggerTime > SystemTime) {
-      break;
-    }
+  // MU_CHANGE [BEGIN] - Queue timers on a hierarchical timer wheel instead of a sorted list
+  //
+  // Walk the ticks up to the current one. All the timers of a past tick are
+  // expired, the timers of the current tick are expired up to SystemTime.
+  //
+  while (TRUE) {
+    Slot = &mEfiTimerWheel[0][(UINTN)mEfiTimerWheelTick & (TIMER_WHEEL_SLOTS - 1)];
+    while (!IsListEmpty (Slot)) {
+      Event = CR (Slot->ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
 
-    //
-    // Remove this timer from the timer queue
-    //
+      //
+      // If this timer is not expired, then we're done
+      //
+      if (Event->Timer.TriggerTime > SystemTime) {
+        break;
+      }
 
-    RemoveEntryList (&Event->Timer.Link);
-    Event->Timer.Link.ForwardLink = NULL;
+      //
+      // Remove this timer from the timer queue
+      //
 
-    //
-    // Signal it
-    //
-    CoreSignalEvent (Event);
+      CoreRemoveEventTimer (Event);
 
-    //
-    // If this is a periodic timer, set it
-    //
-    if (Event->Timer.Period != 0) {
       //
-      // Compute the timers new trigger time
+      // Signal it
       //
-      Event->Timer.TriggerTime = Event->Timer.TriggerTime + Event->Timer.Period;
+      CoreSignalEvent (Event);
 
       //
-      // If that's before now, then reset the timer to start from now
+      // If this is a periodic timer, set it
       //
-      if (Event->Timer.TriggerTime <= SystemTime) {
-        Event->Timer.TriggerTime = SystemTime;
-        CoreSignalEvent (mEfiCheckTimerEvent);
+      if (Event->Timer.Period != 0) {
+        //
+        // Compute the timers new trigger time
+        //
+        Event->Timer.TriggerTime = Event->Timer.TriggerTime + Event->Timer.Period;
+
+        //
+        // If that's before now, then reset the timer to start from now
+        //
+        if (Event->Timer.TriggerTime <= SystemTime) {
+          Event->Timer.TriggerTime = SystemTime;
+          CoreSignalEvent (mEfiCheckTimerEvent);
+        }
+
+        //
+        // Add the timer
+        //
+        CoreInsertEventTimer (Event);
       }
+    }
 
-      //
-      // Add the timer
-      //
-      CoreInsertEventTimer (Event);
+    if ((mEfiTimerWheelTick >= RShiftU64 (SystemTime, TIMER_WHEEL_TICK_SHIFT)) || (mEfiTimerCount == 0)) {
+      break;
     }
+
+    CoreAdvanceTimerWheel ();
   }
 
+  CoreUpdateNextTimerTrigger ();
+  // MU_CHANGE [END]
+
   CoreReleaseLock (&mEfiTimerLock);
 }
 
@@ -164,6 +430,17 @@ CoreInitializeTimer (
   )
 {
   EFI_STATUS  Status;
+  UINTN       Level;                                 // MU_CHANGE
+  UINTN       Index;                                 // MU_CHANGE
+
+  // MU_CHANGE [BEGIN] - Queue timers on a hierarchical timer wheel instead of a sorted list
+  for (Level = 0; Level < TIMER_WHEEL_LEVELS; Level++) {
+    for (Index = 0; Index < TIMER_WHEEL_SLOTS; Index++) {
+      InitializeListHead (&mEfiTimerWheel[Level][Index]);
+    }
+  }
+
+  // MU_CHANGE [END]
 
   Status = CoreCreateEventInternal (
              EVT_NOTIFY_SIGNAL,
@@ -189,8 +466,6 @@ CoreTimerTick (
   IN UINT64  Duration
   )
 {
-  IEVENT  *Event;
-
   //
   // Check runtiem flag in case there are ticks while exiting boot services
   //
@@ -201,18 +476,17 @@ CoreTimerTick (
   //
   mEfiSystemTime += Duration;
 
+  // MU_CHANGE [BEGIN] - Queue timers on a hierarchical timer wheel instead of a sorted list
   //
-  // If the head of the list is expired, fire the timer event
+  // If the next timer may be expired, fire the timer event
   // to process it
   //
-  if (!IsListEmpty (&mEfiTimerList)) {
-    Event = CR (mEfiTimerList.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
-
-    if (Event->Timer.TriggerTime <= mEfiSystemTime) {
-      CoreSignalEvent (mEfiCheckTimerEvent);
-    }
+  if (mEfiTimerNextTrigger <= mEfiSystemTime) {
+    CoreSignalEvent (mEfiCheckTimerEvent);
   }
 
+  // MU_CHANGE [END]
+
   CoreReleaseLock (&mEfiSystemTimeLock);
 }
 
@@ -261,8 +535,7 @@ CoreSetTimer (
   // If the timer is queued to the timer database, remove it
   //
   if (Event->Timer.Link.ForwardLink != NULL) {
-    RemoveEntryList (&Event->Timer.Link);
-    Event->Timer.Link.ForwardLink = NULL;
+    CoreRemoveEventTimer (Event);                    // MU_CHANGE
   }
 
   Event->Timer.TriggerTime = 0;
@@ -492,11 +492,20 @@ FvReadFileSection (
   // Use FfsEntry to cache Section Extraction Protocol Information
   //
   if (FfsEntry->StreamHandle == 0) {
-    Status = OpenSectionStream (
+    // MU_CHANGE [BEGIN] - Cache decoded section streams
+    //
+    // Open the stream under the FV handle and file name so that sections
+    // decoded for it are found in the decoded section cache by any later
+    // stream over the same file.
+    //
+    Status = OpenFileSectionStream (
                FileSize,
                FileBuffer,
+               FvDevice->Handle,
+               (EFI_GUID *)NameGuid,
                &FfsEntry->StreamHandle
                );
+    // MU_CHANGE [END]
     if (EFI_ERROR (Status)) {
       goto Done;
     }
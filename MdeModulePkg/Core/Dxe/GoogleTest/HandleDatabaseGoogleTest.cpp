@@ -0,0 +1,191 @@
+/** @file
+  Host based throughput tests of the DXE Core handle and protocol database.
+
+  Copyright (C) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <Library/GoogleTestLib.h>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+extern "C" {
+  #include <Uefi.h>
+  #include <Library/BaseLib.h>
+  #include <Library/BaseMemoryLib.h>
+
+  VOID  *gHobList = NULL;
+
+  //
+  // The DXE Core services under test. DxeMain.h is not included here as it
+  // is not C++ clean, so only the needed prototypes are declared.
+  //
+  EFI_STATUS
+  EFIAPI
+  CoreInstallProtocolInterface (
+    IN OUT EFI_HANDLE      *UserHandle,
+    IN EFI_GUID            *Protocol,
+    IN EFI_INTERFACE_TYPE  InterfaceType,
+    IN VOID                *Interface
+    );
+
+  EFI_STATUS
+  EFIAPI
+  CoreHandleProtocol (
+    IN EFI_HANDLE  UserHandle,
+    IN EFI_GUID    *Protocol,
+    OUT VOID       **Interface
+    );
+
+  EFI_STATUS
+  EFIAPI
+  CoreLocateProtocol (
+    IN  EFI_GUID  *Protocol,
+    IN  VOID      *Registration OPTIONAL,
+    OUT VOID      **Interface
+    );
+}
+
+using namespace testing;
+
+//
+// Every parameterized instance installs a distinct set of protocol GUIDs so
+// the instances are independent even though the protocol database is global.
+//
+STATIC UINT32  mGuidSeed = 0x48444230;
+
+/**
+  Builds a protocol GUID that is unique within this test application.
+
+  @param[out] Guid  The GUID to fill.
+**/
+STATIC
+VOID
+BuildTestGuid (
+  OUT EFI_GUID  *Guid
+  )
+{
+  mGuidSeed++;
+  Guid->Data1 = mGuidSeed;
+  Guid->Data2 = (UINT16)(mGuidSeed * 7);
+  Guid->Data3 = 0x4d42;
+  SetMem (Guid->Data4, sizeof (Guid->Data4), 0xA5);
+  WriteUnaligned32 ((UINT32 *)&Guid->Data4[4], mGuidSeed ^ 0x5A5A5A5A);
+}
+
+class HandleDatabaseThroughputTest : public TestWithParam<UINTN> {
+protected:
+  std::vector<EFI_GUID> Guids;
+  std::vector<EFI_HANDLE> Handles;
+  std::vector<UINTN> Interfaces;
+
+  void
+  SetUp (
+    ) override
+  {
+    UINTN  Count;
+
+    Count = GetParam ();
+    Guids.resize (Count);
+    Handles.assign (Count, (EFI_HANDLE)NULL);
+    Interfaces.resize (Count);
+    for (UINTN Index = 0; Index < Count; Index++) {
+      BuildTestGuid (&Guids[Index]);
+      Interfaces[Index] = Index;
+    }
+  }
+};
+
+// Install one protocol per new handle, then locate every protocol both by
+// GUID and by handle, reporting the achieved operations per second.
+TEST_P (HandleDatabaseThroughputTest, InstallAndLocate) {
+  EFI_STATUS  Status;
+  VOID        *Interface;
+  UINTN       Count;
+  double      InstallSeconds;
+  double      LocateSeconds;
+  double      HandleSeconds;
+
+  Count = GetParam ();
+
+  auto  Start = std::chrono::steady_clock::now ();
+
+  for (UINTN Index = 0; Index < Count; Index++) {
+    Status = CoreInstallProtocolInterface (
+               &Handles[Index],
+               &Guids[Index],
+               EFI_NATIVE_INTERFACE,
+               &Interfaces[Index]
+               );
+    ASSERT_EQ (Status, EFI_SUCCESS);
+  }
+
+  auto  Installed = std::chrono::steady_clock::now ();
+
+  for (UINTN Index = 0; Index < Count; Index++) {
+    Status = CoreLocateProtocol (&Guids[Index], NULL, &Interface);
+    ASSERT_EQ (Status, EFI_SUCCESS);
+    ASSERT_EQ (Interface, (VOID *)&Interfaces[Index]);
+  }
+
+  auto  Located = std::chrono::steady_clock::now ();
+
+  for (UINTN Index = 0; Index < Count; Index++) {
+    Status = CoreHandleProtocol (Handles[Index], &Guids[Index], &Interface);
+    ASSERT_EQ (Status, EFI_SUCCESS);
+    ASSERT_EQ (Interface, (VOID *)&Interfaces[Index]);
+  }
+
+  auto  Handled = std::chrono::steady_clock::now ();
+
+  InstallSeconds = std::chrono::duration<double>(Installed - Start).count ();
+  LocateSeconds  = std::chrono::duration<double>(Located - Installed).count ();
+  HandleSeconds  = std::chrono::duration<double>(Handled - Located).count ();
+
+  printf (
+    "[ PERF     ] %6u protocols: install %.0f ops/s, locate %.0f ops/s, handle %.0f ops/s\n",
+    (UINT32)Count,
+    Count / (InstallSeconds > 0 ? InstallSeconds : 1e-9),
+    Count / (LocateSeconds > 0 ? LocateSeconds : 1e-9),
+    Count / (HandleSeconds > 0 ? HandleSeconds : 1e-9)
+    );
+}
+
+// A protocol that was never installed must not be found, whatever the size
+// of the database.
+TEST_P (HandleDatabaseThroughputTest, LocateMissingProtocol) {
+  EFI_GUID  Missing;
+  VOID      *Interface;
+
+  BuildTestGuid (&Missing);
+  EXPECT_EQ (CoreLocateProtocol (&Missing, NULL, &Interface), EFI_NOT_FOUND);
+}
+
+// A pointer that was never returned as a handle must be rejected without
+// being dereferenced, whatever the size of the database.
+TEST_P (HandleDatabaseThroughputTest, RejectUnknownHandle) {
+  UINT64  NotAHandle[8];
+  VOID    *Interface;
+
+  ZeroMem (NotAHandle, sizeof (NotAHandle));
+  EXPECT_EQ (
+    CoreHandleProtocol ((EFI_HANDLE)NotAHandle, &Guids[0], &Interface),
+    EFI_INVALID_PARAMETER
+    );
+}
+
+INSTANTIATE_TEST_SUITE_P (
+  ProtocolCounts,
+  HandleDatabaseThroughputTest,
+  Values ((UINTN)100, (UINTN)1000, (UINTN)5000)
+  );
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  testing::InitGoogleTest (&argc, argv);
+  return RUN_ALL_TESTS ();
+}
@@ -0,0 +1,366 @@
+/** @file
+  Host based tests and benchmark of the DXE Core pool allocator.
+
+  The allocator is linked against PoolGoogleTestSupport.c, which backs pool
+  pages with host memory and counts them, so both the allocation rate and the
+  number of pages held for a given live set can be measured.
+
+  PoolGoogleTestLegacy.c builds the allocator a second time without size
+  classes and small-object slabs. The benchmark runs each workload on both
+  and reports the measured figures side by side.
+
+  Copyright (C) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <Library/GoogleTestLib.h>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+extern "C" {
+  #include <Uefi.h>
+  #include <Library/BaseLib.h>
+  #include <Library/BaseMemoryLib.h>
+  #include "PoolGoogleTestSupport.h"
+
+  //
+  // The DXE Core services under test. DxeMain.h is not included here as it
+  // is not C++ clean, so only the needed prototypes are declared.
+  //
+  VOID
+  CoreInitializePool (
+    VOID
+    );
+
+  EFI_STATUS
+  EFIAPI
+  CoreInternalAllocatePool (
+    IN EFI_MEMORY_TYPE  PoolType,
+    IN UINTN            Size,
+    OUT VOID            **Buffer
+    );
+
+  EFI_STATUS
+  EFIAPI
+  CoreInternalFreePool (
+    IN VOID              *Buffer,
+    OUT EFI_MEMORY_TYPE  *PoolType OPTIONAL
+    );
+
+  //
+  // The same services of the allocator without size classes and slabs.
+  //
+  VOID
+  LegacyCoreInitializePool (
+    VOID
+    );
+
+  EFI_STATUS
+  EFIAPI
+  LegacyCoreInternalAllocatePool (
+    IN EFI_MEMORY_TYPE  PoolType,
+    IN UINTN            Size,
+    OUT VOID            **Buffer
+    );
+
+  EFI_STATUS
+  EFIAPI
+  LegacyCoreInternalFreePool (
+    IN VOID              *Buffer,
+    OUT EFI_MEMORY_TYPE  *PoolType OPTIONAL
+    );
+}
+
+using namespace testing;
+
+#define POOL_TEST_ALLOCATIONS  20000
+
+///
+/// One of the two allocators under test.
+///
+typedef struct {
+  const char *Name;
+  EFI_STATUS (EFIAPI *Allocate)(
+    IN EFI_MEMORY_TYPE  PoolType,
+    IN UINTN            Size,
+    OUT VOID            **Buffer
+    );
+  EFI_STATUS (EFIAPI *Free)(
+    IN VOID              *Buffer,
+    OUT EFI_MEMORY_TYPE  *PoolType OPTIONAL
+    );
+} POOL_TEST_ALLOCATOR;
+
+STATIC CONST POOL_TEST_ALLOCATOR  mCurrentAllocator = {
+  "current",
+  CoreInternalAllocatePool,
+  CoreInternalFreePool
+};
+
+STATIC CONST POOL_TEST_ALLOCATOR  mLegacyAllocator = {
+  "previous",
+  LegacyCoreInternalAllocatePool,
+  LegacyCoreInternalFreePool
+};
+
+///
+/// What one workload measured on one allocator.
+///
+typedef struct {
+  double    AllocsPerSecond;
+  UINTN     PeakBytes;
+  UINTN     HalfFreedBytes;
+} POOL_TEST_RESULT;
+
+/**
+  Simple deterministic generator so runs are repeatable.
+
+  @param[in, out] Seed  The generator state.
+
+  @return The next pseudo random value.
+**/
+STATIC
+UINT32
+NextRandom (
+  IN OUT UINT32  *Seed
+  )
+{
+  *Seed = *Seed * 1103515245 + 12345;
+  return *Seed >> 8;
+}
+
+class PoolAllocatorTest : public Test {
+protected:
+  void
+  SetUp (
+    ) override
+  {
+    CoreInitializePool ();
+    LegacyCoreInitializePool ();
+    mPoolTestPagesInUse = 0;
+    mPoolTestPagesPeak  = 0;
+  }
+
+  /**
+    Allocates one buffer per entry of Sizes and fills it with a pattern.
+
+    @param[in]  Allocator  The allocator to use.
+    @param[in]  Sizes      The sizes to allocate.
+    @param[out] Buffers    The allocated buffers.
+
+    @return Seconds spent in the allocator.
+  **/
+  double
+  AllocateAll (
+    const POOL_TEST_ALLOCATOR  &Allocator,
+    const std::vector<UINTN>   &Sizes,
+    std::vector<VOID *>        &Buffers
+    )
+  {
+    double  Seconds;
+
+    Buffers.assign (Sizes.size (), (VOID *)NULL);
+    Seconds = 0;
+    for (size_t Index = 0; Index < Sizes.size (); Index++) {
+      auto  Start = std::chrono::steady_clock::now ();
+
+      EXPECT_EQ (Allocator.Allocate (EfiBootServicesData, Sizes[Index], &Buffers[Index]), EFI_SUCCESS);
+      Seconds += std::chrono::duration<double>(std::chrono::steady_clock::now () - Start).count ();
+      if (Buffers[Index] != NULL) {
+        EXPECT_EQ ((UINTN)Buffers[Index] & (sizeof (UINT64) - 1), (UINTN)0);
+        SetMem (Buffers[Index], Sizes[Index], (UINT8)Index);
+      }
+    }
+
+    return Seconds;
+  }
+
+  /**
+    Checks the pattern of every live buffer and frees it.
+
+    @param[in]      Allocator  The allocator the buffers came from.
+    @param[in]      Sizes      The sizes that were allocated.
+    @param[in, out] Buffers    The buffers to free. Freed entries are set to NULL.
+    @param[in]      Stride     Only every Stride'th buffer is freed.
+  **/
+  void
+  FreeAll (
+    const POOL_TEST_ALLOCATOR  &Allocator,
+    const std::vector<UINTN>   &Sizes,
+    std::vector<VOID *>        &Buffers,
+    UINTN                      Stride
+    )
+  {
+    EFI_MEMORY_TYPE  Type;
+
+    for (size_t Index = 0; Index < Buffers.size (); Index += Stride) {
+      if (Buffers[Index] == NULL) {
+        continue;
+      }
+
+      for (UINTN Byte = 0; Byte < Sizes[Index]; Byte++) {
+        ASSERT_EQ (((UINT8 *)Buffers[Index])[Byte], (UINT8)Index);
+      }
+
+      EXPECT_EQ (Allocator.Free (Buffers[Index], &Type), EFI_SUCCESS);
+      EXPECT_EQ (Type, EfiBootServicesData);
+      Buffers[Index] = NULL;
+    }
+  }
+
+  /**
+    Runs a workload on one allocator and measures the allocation rate and the
+    bytes of pool pages held.
+
+    @param[in]  Allocator  The allocator to run.
+    @param[in]  Sizes      The sizes to allocate.
+    @param[out] Result     The measured figures.
+  **/
+  void
+  MeasureWorkload (
+    const POOL_TEST_ALLOCATOR  &Allocator,
+    const std::vector<UINTN>   &Sizes,
+    POOL_TEST_RESULT           &Result
+    )
+  {
+    std::vector<VOID *>  Buffers;
+    double               Seconds;
+
+    mPoolTestPagesInUse = 0;
+    mPoolTestPagesPeak  = 0;
+
+    Seconds = AllocateAll (Allocator, Sizes, Buffers);
+
+    //
+    // Free every other allocation to see how much of the freed memory the
+    // allocator can give back or reuse.
+    //
+    FreeAll (Allocator, Sizes, Buffers, 2);
+    Result.HalfFreedBytes = EFI_PAGES_TO_SIZE (mPoolTestPagesInUse);
+
+    FreeAll (Allocator, Sizes, Buffers, 1);
+    EXPECT_EQ (mPoolTestPagesInUse, (UINTN)0);
+
+    Result.AllocsPerSecond = Sizes.size () / (Seconds > 0 ? Seconds : 1e-9);
+    Result.PeakBytes       = EFI_PAGES_TO_SIZE (mPoolTestPagesPeak);
+
+    printf (
+      "[ PERF     ] %-10s %-8s %6u allocs: %.0f allocs/s, peak %u bytes held, after freeing half %u bytes held\n",
+      mWorkloadName,
+      Allocator.Name,
+      (UINT32)Sizes.size (),
+      Result.AllocsPerSecond,
+      (UINT32)Result.PeakBytes,
+      (UINT32)Result.HalfFreedBytes
+      );
+  }
+
+  /**
+    Runs a workload on the current and the previous allocator.
+
+    @param[in] Name   Name of the workload.
+    @param[in] Sizes  The sizes to allocate.
+  **/
+  void
+  RunWorkload (
+    const char                *Name,
+    const std::vector<UINTN>  &Sizes
+    )
+  {
+    UINTN  Requested;
+
+    Requested = 0;
+    for (UINTN Size : Sizes) {
+      Requested += Size;
+    }
+
+    mWorkloadName = Name;
+    printf ("[ PERF     ] %-10s %u bytes requested\n", Name, (UINT32)Requested);
+    MeasureWorkload (mCurrentAllocator, Sizes, mCurrent);
+    MeasureWorkload (mLegacyAllocator, Sizes, mLegacy);
+  }
+
+  const char          *mWorkloadName;
+  POOL_TEST_RESULT    mCurrent;
+  POOL_TEST_RESULT    mLegacy;
+};
+
+// Allocations of up to 128 bytes come from slabs, which must hold fewer bytes
+// than the 128 byte minimum bin of the previous allocator.
+TEST_F (PoolAllocatorTest, SmallObjectFootprint) {
+  std::vector<UINTN>  Sizes;
+  UINT32              Seed;
+
+  Seed = 1;
+  for (UINTN Index = 0; Index < POOL_TEST_ALLOCATIONS; Index++) {
+    Sizes.push_back (1 + NextRandom (&Seed) % 128);
+  }
+
+  RunWorkload ("small", Sizes);
+  EXPECT_LT (mCurrent.PeakBytes, mLegacy.PeakBytes);
+}
+
+// Typical DXE mix: mostly list nodes and short strings, some device paths and
+// a few large buffers that still use the binned and page based paths.
+TEST_F (PoolAllocatorTest, MixedWorkload) {
+  std::vector<UINTN>  Sizes;
+  UINT32              Seed;
+  UINT32              Pick;
+
+  Seed = 2;
+  for (UINTN Index = 0; Index < POOL_TEST_ALLOCATIONS; Index++) {
+    Pick = NextRandom (&Seed) % 100;
+    if (Pick < 60) {
+      Sizes.push_back (sizeof (LIST_ENTRY) + NextRandom (&Seed) % 48);
+    } else if (Pick < 90) {
+      Sizes.push_back (64 + NextRandom (&Seed) % 448);
+    } else if (Pick < 99) {
+      Sizes.push_back (512 + NextRandom (&Seed) % 4096);
+    } else {
+      Sizes.push_back (SIZE_64KB + NextRandom (&Seed) % SIZE_64KB);
+    }
+  }
+
+  RunWorkload ("mixed", Sizes);
+  EXPECT_LE (mCurrent.PeakBytes, mLegacy.PeakBytes);
+}
+
+// Allocations above the slab limit keep using the binned allocator, so both
+// allocators hold the same pages.
+TEST_F (PoolAllocatorTest, BinnedWorkload) {
+  std::vector<UINTN>  Sizes;
+  UINT32              Seed;
+
+  Seed = 3;
+  for (UINTN Index = 0; Index < POOL_TEST_ALLOCATIONS; Index++) {
+    Sizes.push_back (129 + NextRandom (&Seed) % 2048);
+  }
+
+  RunWorkload ("binned", Sizes);
+  EXPECT_EQ (mCurrent.PeakBytes, mLegacy.PeakBytes);
+  EXPECT_EQ (mCurrent.HalfFreedBytes, mLegacy.HalfFreedBytes);
+}
+
+// Zero sized and boundary sized requests must round trip on both allocators.
+TEST_F (PoolAllocatorTest, BoundarySizes) {
+  std::vector<UINTN>  Sizes = { 0, 1, 8, 15, 16, 17, 96, 127, 128, 129, 4096, SIZE_64KB };
+  std::vector<VOID *> Buffers;
+
+  AllocateAll (mCurrentAllocator, Sizes, Buffers);
+  FreeAll (mCurrentAllocator, Sizes, Buffers, 1);
+  EXPECT_EQ (mPoolTestPagesInUse, (UINTN)0);
+
+  AllocateAll (mLegacyAllocator, Sizes, Buffers);
+  FreeAll (mLegacyAllocator, Sizes, Buffers, 1);
+  EXPECT_EQ (mPoolTestPagesInUse, (UINTN)0);
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  testing::InitGoogleTest (&argc, argv);
+  return RUN_ALL_TESTS ();
+}
@@ -0,0 +1,26 @@
+/** @file
+  The DXE Core pool allocator without size classes and small-object slabs.
+
+  Pool.c is built a second time with POOL_LEGACY_BINS defined, so the pool
+  benchmark can run the allocator before size classes and slabs were added
+  next to the current one. Every external symbol of Pool.c is renamed with a
+  Legacy prefix.
+
+  Copyright (C) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#define POOL_LEGACY_BINS
+
+#define mPoolHead                 mLegacyPoolHead
+#define mPoolHeadList             mLegacyPoolHeadList
+#define CoreInitializePool        LegacyCoreInitializePool
+#define LookupPoolHead            LegacyLookupPoolHead
+#define CoreInternalAllocatePool  LegacyCoreInternalAllocatePool
+#define CoreAllocatePool          LegacyCoreAllocatePool
+#define CoreAllocatePoolI         LegacyCoreAllocatePoolI
+#define CoreInternalFreePool      LegacyCoreInternalFreePool
+#define CoreFreePool              LegacyCoreFreePool
+#define CoreFreePoolI             LegacyCoreFreePoolI
+
+#include "Mem/Pool.c"
@@ -0,0 +1,208 @@
+/** @file
+  Page allocator, lock, heap guard and profiling stand-ins that let the DXE
+  Core pool allocator run in a host based test.
+
+  Copyright (C) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "DxeMain.h"
+#include "Mem/Imem.h"
+#include "Mem/HeapGuard.h"
+#include <Library/MemoryAllocationLib.h>
+#include "PoolGoogleTestSupport.h"
+
+EFI_LOCK                        gMemoryLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
+BOOLEAN                         mOnGuarding = FALSE;
+DXE_MEMORY_PROTECTION_SETTINGS  gDxeMps;
+
+UINTN  mPoolTestPagesInUse = 0;
+UINTN  mPoolTestPagesPeak  = 0;
+
+VOID
+CoreAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockReleased);
+  Lock->Lock = EfiLockAcquired;
+}
+
+EFI_STATUS
+CoreAcquireLockOrFail (
+  IN EFI_LOCK  *Lock
+  )
+{
+  if (Lock->Lock == EfiLockAcquired) {
+    return EFI_ACCESS_DENIED;
+  }
+
+  Lock->Lock = EfiLockAcquired;
+  return EFI_SUCCESS;
+}
+
+VOID
+CoreReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockAcquired);
+  Lock->Lock = EfiLockReleased;
+}
+
+VOID
+CoreAcquireMemoryLock (
+  VOID
+  )
+{
+  CoreAcquireLock (&gMemoryLock);
+}
+
+VOID
+CoreReleaseMemoryLock (
+  VOID
+  )
+{
+  CoreReleaseLock (&gMemoryLock);
+}
+
+VOID *
+CoreAllocatePoolPages (
+  IN EFI_MEMORY_TYPE  PoolType,
+  IN UINTN            NumberOfPages,
+  IN UINTN            Alignment,
+  IN BOOLEAN          NeedGuard
+  )
+{
+  VOID  *Buffer;
+
+  Buffer = AllocateAlignedPages (NumberOfPages, Alignment);
+  if (Buffer != NULL) {
+    mPoolTestPagesInUse += NumberOfPages;
+    mPoolTestPagesPeak   = MAX (mPoolTestPagesPeak, mPoolTestPagesInUse);
+  }
+
+  return Buffer;
+}
+
+VOID
+CoreFreePoolPages (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NumberOfPages
+  )
+{
+  ASSERT (mPoolTestPagesInUse >= NumberOfPages);
+  mPoolTestPagesInUse -= NumberOfPages;
+  FreeAlignedPages ((VOID *)(UINTN)Memory, NumberOfPages);
+}
+
+BOOLEAN
+IsPoolTypeToGuard (
+  IN EFI_MEMORY_TYPE  MemoryType
+  )
+{
+  return FALSE;
+}
+
+BOOLEAN
+IsHeapGuardEnabled (
+  UINT8  GuardType
+  )
+{
+  return FALSE;
+}
+
+BOOLEAN
+EFIAPI
+IsMemoryGuarded (
+  IN EFI_PHYSICAL_ADDRESS  Address
+  )
+{
+  return FALSE;
+}
+
+VOID
+SetGuardForMemory (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NumberOfPages
+  )
+{
+}
+
+VOID
+UnsetGuardForMemory (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NumberOfPages
+  )
+{
+}
+
+VOID
+AdjustMemoryF (
+  IN OUT EFI_PHYSICAL_ADDRESS  *Memory,
+  IN OUT UINTN                 *NumberOfPages
+  )
+{
+}
+
+VOID *
+AdjustPoolHeadA (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NoPages,
+  IN UINTN                 Size
+  )
+{
+  return (VOID *)(UINTN)Memory;
+}
+
+VOID *
+AdjustPoolHeadF (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NoPages,
+  IN UINTN                 Size
+  )
+{
+  return (VOID *)(UINTN)Memory;
+}
+
+VOID
+EFIAPI
+GuardFreedPagesChecked (
+  IN  EFI_PHYSICAL_ADDRESS  BaseAddress,
+  IN  UINTN                 Pages
+  )
+{
+}
+
+EFI_STATUS
+EFIAPI
+ApplyMemoryProtectionPolicy (
+  IN  EFI_MEMORY_TYPE       OldType,
+  IN  EFI_MEMORY_TYPE       NewType,
+  IN  EFI_PHYSICAL_ADDRESS  Memory,
+  IN  UINT64                Length
+  )
+{
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+CoreUpdateProfile (
+  IN EFI_PHYSICAL_ADDRESS   CallerAddress,
+  IN MEMORY_PROFILE_ACTION  Action,
+  IN EFI_MEMORY_TYPE        MemoryType,
+  IN UINTN                  Size,
+  IN VOID                   *Buffer,
+  IN CHAR8                  *ActionString OPTIONAL
+  )
+{
+  return EFI_SUCCESS;
+}
+
+VOID
+InstallMemoryAttributesTableOnMemoryAllocation (
+  IN EFI_MEMORY_TYPE  MemoryType
+  )
+{
+}
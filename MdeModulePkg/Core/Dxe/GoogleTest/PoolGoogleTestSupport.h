@@ -0,0 +1,21 @@
+/** @file
+  Page level hooks that back the DXE Core pool allocator in host based tests.
+
+  Copyright (C) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef POOL_GOOGLE_TEST_SUPPORT_H_
+#define POOL_GOOGLE_TEST_SUPPORT_H_
+
+///
+/// Number of pages the pool allocator currently holds from the page allocator.
+///
+extern UINTN  mPoolTestPagesInUse;
+
+///
+/// Highest value mPoolTestPagesInUse reached since the last reset.
+///
+extern UINTN  mPoolTestPagesPeak;
+
+#endif
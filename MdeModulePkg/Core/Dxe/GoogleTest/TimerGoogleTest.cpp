@@ -0,0 +1,578 @@
+/** @file
+  Host based tests and benchmark of the DXE Core timer services.
+
+  A timer trace modeled on a network boot, with pollers, USB periodic timers
+  and TCP timers that are re-armed on every packet, is replayed against the
+  timer services and against a sorted timer list as used before the timer
+  wheel. Both must signal the same timers in the same order, and the time
+  spent setting and expiring timers is reported for each.
+
+  Copyright (C) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <Library/GoogleTestLib.h>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+extern "C" {
+  #include <Uefi.h>
+  #include <Library/BaseLib.h>
+  #include <Library/BaseMemoryLib.h>
+  #include "TimerGoogleTestSupport.h"
+
+  //
+  // The DXE Core services under test. DxeMain.h is not included here as it
+  // is not C++ clean, so only the needed prototypes are declared.
+  //
+  VOID
+  CoreInitializeTimer (
+    VOID
+    );
+
+  VOID
+  EFIAPI
+  CoreCheckTimers (
+    IN EFI_EVENT  CheckEvent,
+    IN VOID       *Context
+    );
+
+  VOID
+  EFIAPI
+  CoreTimerTick (
+    IN UINT64  Duration
+    );
+
+  EFI_STATUS
+  EFIAPI
+  CoreSetTimer (
+    IN EFI_EVENT        UserEvent,
+    IN EFI_TIMER_DELAY  Type,
+    IN UINT64           TriggerTime
+    );
+}
+
+using namespace testing;
+
+#define TIMER_TEST_POLLERS       16
+#define TIMER_TEST_USB_TIMERS    32
+#define TIMER_TEST_TCP_TIMERS    1000
+#define TIMER_TEST_DHCP_TIMERS   100
+#define TIMER_TEST_WATCHDOGS     4
+#define TIMER_TEST_TIMERS        (TIMER_TEST_POLLERS + TIMER_TEST_USB_TIMERS + TIMER_TEST_TCP_TIMERS + TIMER_TEST_DHCP_TIMERS + TIMER_TEST_WATCHDOGS)
+#define TIMER_TEST_TICKS         6000
+#define TIMER_TEST_MILLISECONDS  10000ULL
+
+//
+// One step of a timer trace: a SetTimer () call, or a timer interrupt.
+//
+typedef struct {
+  BOOLEAN            Tick;
+  UINT32             Id;
+  EFI_TIMER_DELAY    Type;
+  UINT64             Time;
+} TIMER_TRACE_STEP;
+
+//
+// Timers signaled during the replay, as the index of the trace step and the
+// identifier of the timer.
+//
+typedef std::vector<std::pair<size_t, UINT32> > TIMER_SIGNAL_LOG;
+
+STATIC TIMER_SIGNAL_LOG  *mSignalLog;
+STATIC size_t            mSignalStep;
+
+extern "C" VOID
+TimerTestEventSignaled (
+  IN UINT32  Id
+  )
+{
+  if (mSignalLog != NULL) {
+    mSignalLog->push_back (std::make_pair (mSignalStep, Id));
+  }
+}
+
+/**
+  Simple deterministic generator so runs are repeatable.
+
+  @param[in, out] Seed  The generator state.
+
+  @return The next pseudo random value.
+**/
+STATIC
+UINT32
+NextRandom (
+  IN OUT UINT32  *Seed
+  )
+{
+  *Seed = *Seed * 1103515245 + 12345;
+  return *Seed >> 8;
+}
+
+/**
+  Builds the trace of a network boot: network and USB pollers that are set
+  once, TCP timers re-armed or cancelled on every packet, DHCP and ARP
+  timeouts, and watchdogs kicked once in a while.
+
+  @return The trace.
+**/
+STATIC
+std::vector<TIMER_TRACE_STEP>
+BuildNetworkBootTrace (
+  VOID
+  )
+{
+  std::vector<TIMER_TRACE_STEP>  Trace;
+  UINT32                         Seed;
+  UINT32                         Id;
+  UINT32                         Packets;
+
+  Seed = 1;
+  for (Id = 0; Id < TIMER_TEST_POLLERS; Id++) {
+    Trace.push_back ({ FALSE, Id, TimerPeriodic, (Id == 0) ? 0 : 10 * TIMER_TEST_MILLISECONDS });
+  }
+
+  for ( ; Id < TIMER_TEST_POLLERS + TIMER_TEST_USB_TIMERS; Id++) {
+    Trace.push_back ({ FALSE, Id, TimerPeriodic, (1 + NextRandom (&Seed) % 32) * TIMER_TEST_MILLISECONDS });
+  }
+
+  for (UINTN Tick = 0; Tick < TIMER_TEST_TICKS; Tick++) {
+    Packets = NextRandom (&Seed) % 64;
+    while (Packets-- > 0) {
+      Id = TIMER_TEST_POLLERS + TIMER_TEST_USB_TIMERS + NextRandom (&Seed) % TIMER_TEST_TCP_TIMERS;
+      if (NextRandom (&Seed) % 10 == 0) {
+        Trace.push_back ({ FALSE, Id, TimerCancel, 0 });
+      } else {
+        Trace.push_back ({ FALSE, Id, TimerRelative, (200 + NextRandom (&Seed) % 2800) * TIMER_TEST_MILLISECONDS });
+      }
+    }
+
+    if (NextRandom (&Seed) % 4 == 0) {
+      Id = TIMER_TEST_TIMERS - TIMER_TEST_WATCHDOGS - TIMER_TEST_DHCP_TIMERS + NextRandom (&Seed) % TIMER_TEST_DHCP_TIMERS;
+      Trace.push_back ({ FALSE, Id, TimerRelative, (NextRandom (&Seed) % 8) * 1000 * TIMER_TEST_MILLISECONDS });
+    }
+
+    if (Tick % 1000 == 0) {
+      for (Id = TIMER_TEST_TIMERS - TIMER_TEST_WATCHDOGS; Id < TIMER_TEST_TIMERS; Id++) {
+        Trace.push_back ({ FALSE, Id, TimerRelative, 5 * 60 * 1000 * TIMER_TEST_MILLISECONDS });
+      }
+    }
+
+    Trace.push_back ({ TRUE, 0, TimerCancel, TIMER_TEST_PERIOD });
+  }
+
+  for (Id = 0; Id < TIMER_TEST_TIMERS; Id++) {
+    Trace.push_back ({ FALSE, Id, TimerCancel, 0 });
+  }
+
+  return Trace;
+}
+
+//
+// Timer services a trace can be replayed against.
+//
+class TimerQueue {
+public:
+  virtual
+  ~TimerQueue (
+    )
+  {
+  }
+
+  virtual void
+  Set (
+    UINT32           Id,
+    EFI_TIMER_DELAY  Type,
+    UINT64           Time
+    ) = 0;
+
+  virtual void
+  Tick (
+    UINT64  Duration
+    ) = 0;
+
+  virtual bool
+  CheckPending (
+    ) = 0;
+
+  virtual void
+  Check (
+    ) = 0;
+};
+
+//
+// The DXE Core timer services.
+//
+class CoreTimerQueue : public TimerQueue {
+public:
+  std::vector<EFI_EVENT> Events;
+
+  CoreTimerQueue (
+    UINT32  Count
+    )
+  {
+    for (UINT32 Id = 0; Id < Count; Id++) {
+      Events.push_back (TimerTestCreateEvent (Id));
+    }
+  }
+
+  ~CoreTimerQueue (
+    ) override
+  {
+    for (EFI_EVENT Event : Events) {
+      CoreSetTimer (Event, TimerCancel, 0);
+      TimerTestFreeEvent (Event);
+    }
+  }
+
+  void
+  Set (
+    UINT32           Id,
+    EFI_TIMER_DELAY  Type,
+    UINT64           Time
+    ) override
+  {
+    EXPECT_EQ (CoreSetTimer (Events[Id], Type, Time), EFI_SUCCESS);
+  }
+
+  void
+  Tick (
+    UINT64  Duration
+    ) override
+  {
+    CoreTimerTick (Duration);
+  }
+
+  bool
+  CheckPending (
+    ) override
+  {
+    return mTimerTestCheckPending;
+  }
+
+  void
+  Check (
+    ) override
+  {
+    mTimerTestCheckPending = FALSE;
+    CoreCheckTimers (NULL, NULL);
+  }
+};
+
+//
+// A single sorted timer list, as the DXE Core kept before the timer wheel.
+//
+class SortedListTimerQueue : public TimerQueue {
+  typedef struct {
+    LIST_ENTRY    Link;
+    UINT64        TriggerTime;
+    UINT64        Period;
+    UINT32        Id;
+  } SORTED_LIST_TIMER;
+
+  std::vector<SORTED_LIST_TIMER> Timers;
+  LIST_ENTRY List;
+  UINT64 SystemTime;
+  bool Pending;
+
+  void
+  Insert (
+    SORTED_LIST_TIMER  *Timer
+    )
+  {
+    LIST_ENTRY  *Link;
+
+    for (Link = List.ForwardLink; Link != &List; Link = Link->ForwardLink) {
+      if (BASE_CR (Link, SORTED_LIST_TIMER, Link)->TriggerTime > Timer->TriggerTime) {
+        break;
+      }
+    }
+
+    InsertTailList (Link, &Timer->Link);
+  }
+
+public:
+  SortedListTimerQueue (
+    UINT32  Count
+    ) : Timers (Count), SystemTime (0), Pending (false)
+  {
+    InitializeListHead (&List);
+    for (UINT32 Id = 0; Id < Count; Id++) {
+      ZeroMem (&Timers[Id], sizeof (Timers[Id]));
+      Timers[Id].Id = Id;
+    }
+  }
+
+  void
+  Set (
+    UINT32           Id,
+    EFI_TIMER_DELAY  Type,
+    UINT64           Time
+    ) override
+  {
+    SORTED_LIST_TIMER  *Timer;
+
+    Timer = &Timers[Id];
+    if (Timer->Link.ForwardLink != NULL) {
+      RemoveEntryList (&Timer->Link);
+      Timer->Link.ForwardLink = NULL;
+    }
+
+    Timer->TriggerTime = 0;
+    Timer->Period      = 0;
+    if (Type != TimerCancel) {
+      if (Type == TimerPeriodic) {
+        if (Time == 0) {
+          Time = TIMER_TEST_PERIOD;
+        }
+
+        Timer->Period = Time;
+      }
+
+      Timer->TriggerTime = SystemTime + Time;
+      Insert (Timer);
+      if (Time == 0) {
+        Pending = true;
+      }
+    }
+  }
+
+  void
+  Tick (
+    UINT64  Duration
+    ) override
+  {
+    SystemTime += Duration;
+    if (!IsListEmpty (&List) && (BASE_CR (List.ForwardLink, SORTED_LIST_TIMER, Link)->TriggerTime <= SystemTime)) {
+      Pending = true;
+    }
+  }
+
+  bool
+  CheckPending (
+    ) override
+  {
+    return Pending;
+  }
+
+  void
+  Check (
+    ) override
+  {
+    SORTED_LIST_TIMER  *Timer;
+
+    Pending = false;
+    while (!IsListEmpty (&List)) {
+      Timer = BASE_CR (List.ForwardLink, SORTED_LIST_TIMER, Link);
+      if (Timer->TriggerTime > SystemTime) {
+        break;
+      }
+
+      RemoveEntryList (&Timer->Link);
+      Timer->Link.ForwardLink = NULL;
+      TimerTestEventSignaled (Timer->Id);
+      if (Timer->Period != 0) {
+        Timer->TriggerTime += Timer->Period;
+        if (Timer->TriggerTime <= SystemTime) {
+          Timer->TriggerTime = SystemTime;
+          Pending            = true;
+        }
+
+        Insert (Timer);
+      }
+    }
+  }
+};
+
+//
+// Time spent in the timer services during a replay.
+//
+typedef struct {
+  double    SetSeconds;
+  double    CheckSeconds;
+  UINTN     Sets;
+  UINTN     Expired;
+} TIMER_REPLAY_COST;
+
+/**
+  Replays a trace, checking the timers whenever the timer services ask for it.
+
+  @param[in]  Trace   The trace.
+  @param[in]  Queue   The timer services to replay the trace against.
+  @param[out] Log     The timers signaled.
+  @param[out] Cost    The time spent setting and expiring timers.
+**/
+STATIC
+VOID
+Replay (
+  const std::vector<TIMER_TRACE_STEP>  &Trace,
+  TimerQueue                           &Queue,
+  TIMER_SIGNAL_LOG                     &Log,
+  TIMER_REPLAY_COST                    &Cost
+  )
+{
+  Log.clear ();
+  ZeroMem (&Cost, sizeof (Cost));
+  mSignalLog = &Log;
+  for (mSignalStep = 0; mSignalStep < Trace.size (); mSignalStep++) {
+    const TIMER_TRACE_STEP  &Step = Trace[mSignalStep];
+
+    if (Step.Tick) {
+      Queue.Tick (Step.Time);
+    } else {
+      auto  Start = std::chrono::steady_clock::now ();
+      Queue.Set (Step.Id, Step.Type, Step.Time);
+      Cost.SetSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now () - Start).count ();
+      Cost.Sets++;
+    }
+
+    while (Queue.CheckPending ()) {
+      auto  Start = std::chrono::steady_clock::now ();
+      Queue.Check ();
+      Cost.CheckSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now () - Start).count ();
+    }
+  }
+
+  Cost.Expired = Log.size ();
+  mSignalLog   = NULL;
+}
+
+class TimerTest : public Test {
+protected:
+  void
+  SetUp (
+    ) override
+  {
+    CoreInitializeTimer ();
+    mTimerTestCheckPending = FALSE;
+  }
+
+  /**
+    Advances the system time, checking the timers as the timer services ask.
+
+    @param[in] Duration  The time to advance by, in 100ns units.
+    @param[in] Step      The time of one timer interrupt, in 100ns units.
+  **/
+  void
+  Advance (
+    UINT64  Duration,
+    UINT64  Step
+    )
+  {
+    for (UINT64 Elapsed = 0; Elapsed < Duration; Elapsed += Step) {
+      CoreTimerTick (Step);
+      while (mTimerTestCheckPending) {
+        mTimerTestCheckPending = FALSE;
+        CoreCheckTimers (NULL, NULL);
+      }
+    }
+  }
+};
+
+// The timer wheel signals the same timers in the same order as a sorted list.
+TEST_F (TimerTest, ReplayNetworkBootTrace) {
+  std::vector<TIMER_TRACE_STEP>  Trace;
+  TIMER_SIGNAL_LOG               WheelLog;
+  TIMER_SIGNAL_LOG               ListLog;
+  TIMER_REPLAY_COST              WheelCost;
+  TIMER_REPLAY_COST              ListCost;
+
+  Trace = BuildNetworkBootTrace ();
+  {
+    CoreTimerQueue  Wheel (TIMER_TEST_TIMERS);
+    Replay (Trace, Wheel, WheelLog, WheelCost);
+  }
+  {
+    SortedListTimerQueue  List (TIMER_TEST_TIMERS);
+    Replay (Trace, List, ListLog, ListCost);
+  }
+
+  EXPECT_GT (WheelLog.size (), (size_t)TIMER_TEST_TICKS);
+  ASSERT_EQ (WheelLog.size (), ListLog.size ());
+  for (size_t Index = 0; Index < WheelLog.size (); Index++) {
+    ASSERT_EQ (WheelLog[Index], ListLog[Index]) << "signal " << Index;
+  }
+
+  printf (
+    "[ PERF     ] %u sets, %u expiries: timer wheel %.1f ns/set %.1f ns/expiry, sorted list %.1f ns/set %.1f ns/expiry\n",
+    (UINT32)WheelCost.Sets,
+    (UINT32)WheelCost.Expired,
+    WheelCost.SetSeconds * 1e9 / WheelCost.Sets,
+    WheelCost.CheckSeconds * 1e9 / WheelCost.Expired,
+    ListCost.SetSeconds * 1e9 / ListCost.Sets,
+    ListCost.CheckSeconds * 1e9 / ListCost.Expired
+    );
+}
+
+// Timers with the same trigger time are signaled in the order they were set,
+// also when the first one was set far enough ahead to start on a higher level
+// of the wheel. The later timers are set from 10ms to 700ms ahead, so some of
+// them are queued to level 0 before the first one is cascaded down.
+TEST_F (TimerTest, SameTriggerTimeKeepsSetOrder) {
+  CoreTimerQueue    Queue (3);
+  TIMER_SIGNAL_LOG  Log;
+  UINT64            Lead;
+
+  for (Lead = TIMER_TEST_PERIOD; Lead <= 70 * TIMER_TEST_PERIOD; Lead += TIMER_TEST_PERIOD) {
+    Log.clear ();
+    mSignalLog = &Log;
+    Queue.Set (2, TimerRelative, 10 * 1000 * TIMER_TEST_MILLISECONDS);
+    Advance (10 * 1000 * TIMER_TEST_MILLISECONDS - Lead, TIMER_TEST_PERIOD);
+    Queue.Set (0, TimerRelative, Lead);
+    Queue.Set (1, TimerRelative, Lead);
+    Advance (Lead + TIMER_TEST_PERIOD, TIMER_TEST_PERIOD);
+    mSignalLog = NULL;
+
+    ASSERT_EQ (Log.size (), (size_t)3);
+    EXPECT_EQ (Log[0].second, (UINT32)2);
+    EXPECT_EQ (Log[1].second, (UINT32)0);
+    EXPECT_EQ (Log[2].second, (UINT32)1);
+  }
+}
+
+// A timer beyond the range of the wheel waits on the overflow list, and is not
+// signaled before it is due.
+TEST_F (TimerTest, TimerBeyondWheelRange) {
+  CoreTimerQueue    Queue (1);
+  TIMER_SIGNAL_LOG  Log;
+  UINT64            Hour;
+
+  Hour       = 60ULL * 60 * 1000 * TIMER_TEST_MILLISECONDS;
+  mSignalLog = &Log;
+  Queue.Set (0, TimerRelative, 40 * Hour);
+  Advance (40 * Hour - Hour / 2, Hour / 2);
+  EXPECT_TRUE (Log.empty ());
+  Advance (Hour, Hour / 2);
+  mSignalLog = NULL;
+
+  EXPECT_EQ (Log.size (), (size_t)1);
+}
+
+// Cancelled timers are not signaled, and a periodic timer with no period
+// runs at the period of the timer interrupt.
+TEST_F (TimerTest, CancelAndDefaultPeriod) {
+  CoreTimerQueue    Queue (2);
+  TIMER_SIGNAL_LOG  Log;
+
+  mSignalLog = &Log;
+  Queue.Set (0, TimerRelative, 50 * TIMER_TEST_MILLISECONDS);
+  Queue.Set (1, TimerPeriodic, 0);
+  Advance (10 * TIMER_TEST_PERIOD, TIMER_TEST_PERIOD);
+  Queue.Set (0, TimerCancel, 0);
+  Queue.Set (1, TimerCancel, 0);
+  Advance (100 * TIMER_TEST_PERIOD, TIMER_TEST_PERIOD);
+  mSignalLog = NULL;
+
+  EXPECT_EQ (Log.size (), (size_t)(1 + 10));
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  testing::InitGoogleTest (&argc, argv);
+  return RUN_ALL_TESTS ();
+}
@@ -0,0 +1,113 @@
+/** @file
+  Event, lock and timer architectural protocol stand-ins that let the DXE Core
+  timer services run in a host based test.
+
+  Copyright (C) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "DxeMain.h"
+#include "Event/Event.h"
+#include <Library/MemoryAllocationLib.h>
+#include "TimerGoogleTestSupport.h"
+
+BOOLEAN  mTimerTestCheckPending = FALSE;
+
+EFI_STATUS
+EFIAPI
+TimerTestGetTimerPeriod (
+  IN  EFI_TIMER_ARCH_PROTOCOL  *This,
+  OUT UINT64                   *TimerPeriod
+  )
+{
+  *TimerPeriod = TIMER_TEST_PERIOD;
+  return EFI_SUCCESS;
+}
+
+EFI_TIMER_ARCH_PROTOCOL  mTimerTestTimer = {
+  NULL,
+  NULL,
+  TimerTestGetTimerPeriod,
+  NULL
+};
+
+EFI_TIMER_ARCH_PROTOCOL  *gTimer = &mTimerTestTimer;
+
+VOID
+CoreAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockReleased);
+  Lock->Lock = EfiLockAcquired;
+}
+
+VOID
+CoreReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockAcquired);
+  Lock->Lock = EfiLockReleased;
+}
+
+EFI_EVENT
+TimerTestCreateEvent (
+  IN UINT32  Id
+  )
+{
+  IEVENT  *Event;
+
+  Event = AllocateZeroPool (sizeof (IEVENT));
+  ASSERT (Event != NULL);
+  Event->Signature     = EVENT_SIGNATURE;
+  Event->Type          = EVT_TIMER | EVT_NOTIFY_SIGNAL;
+  Event->NotifyTpl     = TPL_CALLBACK;
+  Event->NotifyContext = (VOID *)(UINTN)Id;
+  return Event;
+}
+
+VOID
+TimerTestFreeEvent (
+  IN EFI_EVENT  Event
+  )
+{
+  ASSERT (((IEVENT *)Event)->Timer.Link.ForwardLink == NULL);
+  FreePool (Event);
+}
+
+EFI_STATUS
+EFIAPI
+CoreCreateEventInternal (
+  IN UINT32            Type,
+  IN EFI_TPL           NotifyTpl,
+  IN EFI_EVENT_NOTIFY  NotifyFunction  OPTIONAL,
+  IN CONST VOID        *NotifyContext  OPTIONAL,
+  IN CONST EFI_GUID    *EventGroup     OPTIONAL,
+  OUT EFI_EVENT        *Event
+  )
+{
+  //
+  // Only the event that checks the timers is created by the timer services.
+  //
+  *Event = TimerTestCreateEvent (MAX_UINT32);
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+CoreSignalEvent (
+  IN EFI_EVENT  UserEvent
+  )
+{
+  UINT32  Id;
+
+  Id = (UINT32)(UINTN)((IEVENT *)UserEvent)->NotifyContext;
+  if (Id == MAX_UINT32) {
+    mTimerTestCheckPending = TRUE;
+  } else {
+    TimerTestEventSignaled (Id);
+  }
+
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,54 @@
+/** @file
+  Event stand-ins that let the DXE Core timer services run in a host based test.
+
+  Copyright (C) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef TIMER_GOOGLE_TEST_SUPPORT_H_
+#define TIMER_GOOGLE_TEST_SUPPORT_H_
+
+///
+/// Timer period reported by the timer architectural protocol, in 100ns units.
+///
+#define TIMER_TEST_PERIOD  100000
+
+///
+/// Set when the timer services signal the event that checks the timers.
+///
+extern BOOLEAN  mTimerTestCheckPending;
+
+/**
+  Creates a timer event.
+
+  @param[in] Id  Identifier reported when the event is signaled.
+
+  @return The event.
+**/
+EFI_EVENT
+TimerTestCreateEvent (
+  IN UINT32  Id
+  );
+
+/**
+  Frees an event created by TimerTestCreateEvent ().
+
+  @param[in] Event  The event.
+**/
+VOID
+TimerTestFreeEvent (
+  IN EFI_EVENT  Event
+  );
+
+/**
+  Called when the timer services signal an event created by
+  TimerTestCreateEvent (). Implemented by the test.
+
+  @param[in] Id  Identifier of the event.
+**/
+VOID
+TimerTestEventSignaled (
+  IN UINT32  Id
+  );
+
+#endif
@@ -20,6 +20,127 @@ LIST_ENTRY  gHandleList           = INITIALIZE_LIST_HEAD_VARIABLE (gHandleList);
 EFI_LOCK    gProtocolDatabaseLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 UINT64      gHandleDatabaseKey    = 0;
 
+// MU_CHANGE [BEGIN] - Hash-indexed protocol database
+//
+// mProtocolHashTable    - Buckets of PROTOCOL_ENTRY keyed by a hash of the
+//                         protocol GUID, so lookups do not walk mProtocolDatabase.
+//                         Protocol entries are never freed, so entries are only
+//                         ever inserted into the table.
+//
+#define PROTOCOL_HASH_BUCKET_COUNT  256
+
+LIST_ENTRY  mProtocolHashTable[PROTOCOL_HASH_BUCKET_COUNT];
+BOOLEAN     mProtocolHashTableInitialized = FALSE;
+
+/**
+  Computes the bucket index in mProtocolHashTable for a protocol GUID.
+
+  @param  Protocol               The ID of the protocol
+
+  @return Index of the bucket in mProtocolHashTable.
+
+**/
+STATIC
+UINTN
+CoreProtocolHashIndex (
+  IN CONST EFI_GUID  *Protocol
+  )
+{
+  UINT32  Hash;
+
+  Hash  = ReadUnaligned32 ((CONST UINT32 *)Protocol);
+  Hash ^= ReadUnaligned32 ((CONST UINT32 *)Protocol + 1);
+  Hash ^= ReadUnaligned32 ((CONST UINT32 *)Protocol + 2);
+  Hash ^= ReadUnaligned32 ((CONST UINT32 *)Protocol + 3);
+
+  //
+  // Mix the folded value so that GUIDs differing only in a few bits land in
+  // different buckets.
+  //
+  Hash ^= Hash >> 16;
+  Hash *= 0x7FEB352D;
+  Hash ^= Hash >> 15;
+
+  return (UINTN)(Hash & (PROTOCOL_HASH_BUCKET_COUNT - 1));
+}
+
+/**
+  Initializes the buckets of mProtocolHashTable on first use.
+  The gProtocolDatabaseLock must be owned
+
+**/
+STATIC
+VOID
+CoreInitializeProtocolHashTable (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  if (mProtocolHashTableInitialized) {
+    return;
+  }
+
+  for (Index = 0; Index < PROTOCOL_HASH_BUCKET_COUNT; Index++) {
+    InitializeListHead (&mProtocolHashTable[Index]);
+  }
+
+  mProtocolHashTableInitialized = TRUE;
+}
+
+// MU_CHANGE [END]
+
+// MU_CHANGE [BEGIN] - Constant time handle validation
+//
+// mHandleHashTable      - Buckets of IHANDLE keyed by the handle address, so
+//                         CoreValidateHandle() does not walk gHandleList.
+//                         Every handle on gHandleList is also on exactly one
+//                         bucket list.
+//
+#define HANDLE_HASH_BUCKET_COUNT  512
+
+LIST_ENTRY  mHandleHashTable[HANDLE_HASH_BUCKET_COUNT];
+BOOLEAN     mHandleHashTableInitialized = FALSE;
+
+/**
+  Returns the bucket in mHandleHashTable that a handle belongs to, initializing
+  the buckets on first use.
+  The gProtocolDatabaseLock must be owned
+
+  @param  UserHandle             The handle. It is not dereferenced.
+
+  @return The bucket list head for UserHandle.
+
+**/
+STATIC
+LIST_ENTRY *
+CoreHandleHashBucket (
+  IN EFI_HANDLE  UserHandle
+  )
+{
+  UINTN  Index;
+  UINTN  Hash;
+
+  if (!mHandleHashTableInitialized) {
+    for (Index = 0; Index < HANDLE_HASH_BUCKET_COUNT; Index++) {
+      InitializeListHead (&mHandleHashTable[Index]);
+    }
+
+    mHandleHashTableInitialized = TRUE;
+  }
+
+  //
+  // Handles are pool allocations, so the low bits carry no information.
+  //
+  Hash  = (UINTN)UserHandle >> 3;
+  Hash ^= Hash >> 9;
+  Hash ^= Hash >> 18;
+
+  return &mHandleHashTable[Hash & (HANDLE_HASH_BUCKET_COUNT - 1)];
+}
+
+// MU_CHANGE [END]
+
 /**
   Acquire lock on gProtocolDatabaseLock.
 
@@ -61,6 +182,7 @@ CoreValidateHandle (
 {
   IHANDLE     *Handle;
   LIST_ENTRY  *Link;
+  LIST_ENTRY  *Bucket;                // MU_CHANGE - Constant time handle validation
 
   if (UserHandle == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -68,8 +190,11 @@ CoreValidateHandle (
 
   ASSERT_LOCKED (&gProtocolDatabaseLock);
 
-  for (Link = gHandleList.BackLink; Link != &gHandleList; Link = Link->BackLink) {
-    Handle = CR (Link, IHANDLE, AllHandles, EFI_HANDLE_SIGNATURE);
+  // MU_CHANGE [BEGIN] - Constant time handle validation
+  Bucket = CoreHandleHashBucket (UserHandle);
+  for (Link = Bucket->ForwardLink; Link != Bucket; Link = Link->ForwardLink) {
+    Handle = CR (Link, IHANDLE, HashLink, EFI_HANDLE_SIGNATURE);
+    // MU_CHANGE [END]
     if (Handle == (IHANDLE *)UserHandle) {
       return EFI_SUCCESS;
     }
@@ -97,19 +222,25 @@ CoreFindProtocolEntry (
   LIST_ENTRY      *Link;
   PROTOCOL_ENTRY  *Item;
   PROTOCOL_ENTRY  *ProtEntry;
+  LIST_ENTRY      *Bucket;            // MU_CHANGE - Hash-indexed protocol database
 
   ASSERT_LOCKED (&gProtocolDatabaseLock);
 
+  // MU_CHANGE [BEGIN] - Hash-indexed protocol database
+  CoreInitializeProtocolHashTable ();
+  Bucket = &mProtocolHashTable[CoreProtocolHashIndex (Protocol)];
+
   //
-  // Search the database for the matching GUID
+  // Search the hash bucket for the matching GUID
   //
 
   ProtEntry = NULL;
-  for (Link = mProtocolDatabase.ForwardLink;
-       Link != &mProtocolDatabase;
+  for (Link = Bucket->ForwardLink;
+       Link != Bucket;
        Link = Link->ForwardLink)
   {
-    Item = CR (Link, PROTOCOL_ENTRY, AllEntries, PROTOCOL_ENTRY_SIGNATURE);
+    Item = CR (Link, PROTOCOL_ENTRY, HashLink, PROTOCOL_ENTRY_SIGNATURE);
+    // MU_CHANGE [END]
     if (CompareGuid (&Item->ProtocolID, Protocol)) {
       //
       // This is the protocol entry
@@ -140,6 +271,7 @@ CoreFindProtocolEntry (
       // Add it to protocol database
       //
       InsertTailList (&mProtocolDatabase, &ProtEntry->AllEntries);
+      InsertTailList (Bucket, &ProtEntry->HashLink);    // MU_CHANGE - Hash-indexed protocol database
     }
   }
 
@@ -409,6 +541,7 @@ CoreInstallProtocolInterfaceNotify (
     // in the system
     //
     InsertTailList (&gHandleList, &Handle->AllHandles);
+    InsertTailList (CoreHandleHashBucket (Handle), &Handle->HashLink);   // MU_CHANGE - Constant time handle validation
   } else {
     Status = CoreValidateHandle (Handle);
     if (EFI_ERROR (Status)) {
@@ -771,6 +904,7 @@ CoreUninstallProtocolInterface (
   if (IsListEmpty (&Handle->Protocols)) {
     Handle->Signature = 0;
     RemoveEntryList (&Handle->AllHandles);
+    RemoveEntryList (&Handle->HashLink);    // MU_CHANGE - Constant time handle validation
     CoreFreePool (Handle);
   }
 
@@ -23,6 +23,11 @@ typedef struct {
   UINTN         LocateRequest;
   /// The Handle Database Key value when this handle was last created or modified
   UINT64        Key;
+  // MU_CHANGE [BEGIN] - Constant time handle validation
+  /// Link Entry inserted to the mHandleHashTable bucket for this handle.
+  /// Appended so the offsets of the fields above stay unchanged for debug tools.
+  LIST_ENTRY    HashLink;
+  // MU_CHANGE [END]
 } IHANDLE;
 
 #define ASSERT_IS_HANDLE(a)  ASSERT((a)->Signature == EFI_HANDLE_SIGNATURE)
@@ -44,6 +49,10 @@ typedef struct {
   LIST_ENTRY    Protocols;
   /// Registerd notification handlers
   LIST_ENTRY    Notify;
+  // MU_CHANGE [BEGIN] - Hash-indexed protocol database
+  /// Link Entry inserted to the mProtocolHashTable bucket for ProtocolID
+  LIST_ENTRY    HashLink;
+  // MU_CHANGE [END]
 } PROTOCOL_ENTRY;
 
 #define PROTOCOL_INTERFACE_SIGNATURE  SIGNATURE_32('p','i','f','c')
@@ -59,6 +59,78 @@ STATIC CONST UINT16  mPoolSizeTable[] = {
 
 #define MAX_POOL_SIZE  (MAX_ADDRESS - POOL_OVERHEAD)
 
+// MU_CHANGE [BEGIN] - Constant time pool size classes and small-object slabs
+//
+// The host based pool benchmark also builds this file with POOL_LEGACY_BINS
+// defined, to measure the allocator without size classes and slabs.
+//
+#ifdef POOL_LEGACY_BINS
+#define POOL_SIZE_CLASSES  FALSE
+#else
+#define POOL_SIZE_CLASSES  TRUE
+#endif
+
+//
+// Every mPoolSizeTable entry is a multiple of 128 bytes, so rounding a size up
+// to the next 128 bytes never changes the bin it falls in. mPoolIndexFromSize
+// maps the rounded size to its bin in a single lookup.
+//
+#define POOL_SIZE_CLASS_SHIFT  7
+#define POOL_SIZE_CLASS_COUNT  ((29824 >> POOL_SIZE_CLASS_SHIFT) + 1)
+
+STATIC UINT8  mPoolIndexFromSize[POOL_SIZE_CLASS_COUNT];
+
+//
+// Allocations of up to MAX_POOL_SLAB_SIZE bytes are served from slabs: blocks
+// of pool pages split into equal slots. A slot only carries a POOL_SLAB_HEAD
+// instead of a POOL_HEAD and POOL_TAIL, and is sized to the request instead of
+// the 128 byte smallest bin.
+//
+STATIC CONST UINT16  mPoolSlabSizeTable[] = {
+  16, 32, 48, 64, 96, 128
+};
+
+//
+// mPoolSlabIndexFromSize[N] is the slab list for a request of up to N * 16 bytes.
+//
+STATIC CONST UINT8  mPoolSlabIndexFromSize[] = {
+  0, 0, 1, 2, 3, 4, 4, 5, 5
+};
+
+#define MAX_POOL_SLAB_LIST  (ARRAY_SIZE (mPoolSlabSizeTable))
+#define MAX_POOL_SLAB_SIZE  128
+
+#define POOL_SLAB_HEAD_SIGNATURE  SIGNATURE_32('p','s','h','0')
+#define POOL_SLAB_FREE_SIGNATURE  SIGNATURE_32('p','s','f','0')
+typedef struct {
+  UINT32    Signature;
+  /// Offset of this slot from the start of its POOL_SLAB
+  UINT32    Offset;
+} POOL_SLAB_HEAD;
+
+#define SLAB_HEAD_TO_DATA(a)  ((VOID *)((POOL_SLAB_HEAD *)(a) + 1))
+#define DATA_TO_SLAB_HEAD(a)  ((POOL_SLAB_HEAD *)(a) - 1)
+#define SLAB_SLOT_SIZE(a)     (sizeof (POOL_SLAB_HEAD) + mPoolSlabSizeTable[a])
+
+#define POOL_SLAB_SIGNATURE  SIGNATURE_32('p','s','l','b')
+typedef struct {
+  UINT32             Signature;
+  /// Index into mPoolSlabSizeTable
+  UINT32             Index;
+  EFI_MEMORY_TYPE    Type;
+  /// Size in bytes of the pool pages holding this slab
+  UINT32             BlockSize;
+  UINT32             SlotCount;
+  UINT32             FreeCount;
+  /// Link on POOL.SlabList while the slab has a free slot
+  LIST_ENTRY         Link;
+  /// Free slots, chained through the first pointer of their data
+  POOL_SLAB_HEAD     *FreeSlots;
+} POOL_SLAB;
+
+#define SIZE_OF_POOL_SLAB  ALIGN_VALUE (sizeof (POOL_SLAB), sizeof (UINT64))
+// MU_CHANGE [END]
+
 //
 // Globals
 //
@@ -70,6 +142,7 @@ typedef struct {
   EFI_MEMORY_TYPE    MemoryType;
   LIST_ENTRY         FreeList[MAX_POOL_LIST];
   LIST_ENTRY         Link;
+  LIST_ENTRY         SlabList[MAX_POOL_SLAB_LIST];   // MU_CHANGE - Small-object slabs
 } POOL;
 
 //
@@ -96,15 +169,25 @@ GetPoolIndexFromSize (
   UINTN  Size
   )
 {
+  // MU_CHANGE [BEGIN] - Constant time pool size classes
   UINTN  Index;
 
-  for (Index = 0; Index < MAX_POOL_LIST; Index++) {
-    if (mPoolSizeTable[Index] >= Size) {
-      return Index;
+  if (!POOL_SIZE_CLASSES) {
+    for (Index = 0; Index < MAX_POOL_LIST; Index++) {
+      if (mPoolSizeTable[Index] >= Size) {
+        return Index;
+      }
     }
+
+    return MAX_POOL_LIST;
+  }
+
+  if (Size > mPoolSizeTable[MAX_POOL_LIST - 1]) {
+    return MAX_POOL_LIST;
   }
 
-  return MAX_POOL_LIST;
+  return mPoolIndexFromSize[(Size + (1 << POOL_SIZE_CLASS_SHIFT) - 1) >> POOL_SIZE_CLASS_SHIFT];
+  // MU_CHANGE [END]
 }
 
 /**
@@ -126,7 +209,27 @@ CoreInitializePool (
     for (Index = 0; Index < MAX_POOL_LIST; Index++) {
       InitializeListHead (&mPoolHead[Type].FreeList[Index]);
     }
+
+    // MU_CHANGE [BEGIN] - Small-object slabs
+    for (Index = 0; Index < MAX_POOL_SLAB_LIST; Index++) {
+      InitializeListHead (&mPoolHead[Type].SlabList[Index]);
+    }
+
+    // MU_CHANGE [END]
+  }
+
+  // MU_CHANGE [BEGIN] - Constant time pool size classes
+  ASSERT (mPoolSizeTable[MAX_POOL_LIST - 1] == ((POOL_SIZE_CLASS_COUNT - 1) << POOL_SIZE_CLASS_SHIFT));
+  Index = 0;
+  for (Type = 0; Type < POOL_SIZE_CLASS_COUNT; Type++) {
+    while (mPoolSizeTable[Index] < (Type << POOL_SIZE_CLASS_SHIFT)) {
+      Index++;
+    }
+
+    mPoolIndexFromSize[Type] = (UINT8)Index;
   }
+
+  // MU_CHANGE [END]
 }
 
 /**
@@ -175,6 +278,13 @@ LookupPoolHead (
       InitializeListHead (&Pool->FreeList[Index]);
     }
 
+    // MU_CHANGE [BEGIN] - Small-object slabs
+    for (Index = 0; Index < MAX_POOL_SLAB_LIST; Index++) {
+      InitializeListHead (&Pool->SlabList[Index]);
+    }
+
+    // MU_CHANGE [END]
+
     InsertHeadList (&mPoolHeadList, &Pool->Link);
 
     return Pool;
@@ -336,6 +446,107 @@ CoreAllocatePoolPagesI (
   return Buffer;
 }
 
+// MU_CHANGE [BEGIN] - Small-object slabs
+
+/**
+  Internal function to allocate a small pool entry from a slab.
+  Caller must have the memory lock held
+
+  @param  Pool                   The pool head of the memory type
+  @param  Size                   The amount of pool to allocate, at most
+                                 MAX_POOL_SLAB_SIZE bytes
+  @param  Granularity            Size of the pool pages backing a new slab
+
+  @return The allocated pool, or NULL
+
+**/
+STATIC
+VOID *
+CoreAllocatePoolSlabI (
+  IN POOL   *Pool,
+  IN UINTN  Size,
+  IN UINTN  Granularity
+  )
+{
+  POOL_SLAB       *Slab;
+  POOL_SLAB_HEAD  *Head;
+  UINTN           Index;
+  UINTN           SlotSize;
+  UINTN           Offset;
+
+  ASSERT_LOCKED (&mPoolMemoryLock);
+  ASSERT (Size <= MAX_POOL_SLAB_SIZE);
+
+  Index    = mPoolSlabIndexFromSize[(Size + 15) >> 4];
+  SlotSize = SLAB_SLOT_SIZE (Index);
+
+  //
+  // If no slab of this size has a free slot, carve up a new one
+  //
+  if (IsListEmpty (&Pool->SlabList[Index])) {
+    Slab = CoreAllocatePoolPagesI (
+             Pool->MemoryType,
+             EFI_SIZE_TO_PAGES (Granularity),
+             Granularity,
+             FALSE
+             );
+    if (Slab == NULL) {
+      DEBUG ((DEBUG_ERROR | DEBUG_POOL, "AllocatePool: failed to allocate %ld bytes\n", (UINT64)Size));
+      return NULL;
+    }
+
+    Slab->Signature = POOL_SLAB_SIGNATURE;
+    Slab->Index     = (UINT32)Index;
+    Slab->Type      = Pool->MemoryType;
+    Slab->BlockSize = (UINT32)Granularity;
+    Slab->SlotCount = 0;
+    Slab->FreeSlots = NULL;
+
+    for (Offset = SIZE_OF_POOL_SLAB; Offset + SlotSize <= Granularity; Offset += SlotSize) {
+      Head                                          = (POOL_SLAB_HEAD *)((UINT8 *)Slab + Offset);
+      Head->Signature                               = POOL_SLAB_FREE_SIGNATURE;
+      Head->Offset                                  = (UINT32)Offset;
+      *(POOL_SLAB_HEAD **)SLAB_HEAD_TO_DATA (Head) = Slab->FreeSlots;
+      Slab->FreeSlots                               = Head;
+      Slab->SlotCount++;
+    }
+
+    Slab->FreeCount = Slab->SlotCount;
+    InsertHeadList (&Pool->SlabList[Index], &Slab->Link);
+  }
+
+  Slab = CR (Pool->SlabList[Index].ForwardLink, POOL_SLAB, Link, POOL_SLAB_SIGNATURE);
+  Head = Slab->FreeSlots;
+  ASSERT (Head != NULL && Head->Signature == POOL_SLAB_FREE_SIGNATURE);
+
+  Slab->FreeSlots = *(POOL_SLAB_HEAD **)SLAB_HEAD_TO_DATA (Head);
+  Slab->FreeCount--;
+  if (Slab->FreeCount == 0) {
+    //
+    // The slab is full, so take it off the list of slabs with free slots
+    //
+    RemoveEntryList (&Slab->Link);
+  }
+
+  Head->Signature = POOL_SLAB_HEAD_SIGNATURE;
+  Pool->Used     += SlotSize;
+
+  DEBUG_CLEAR_MEMORY (SLAB_HEAD_TO_DATA (Head), mPoolSlabSizeTable[Index]);
+
+  DEBUG ((
+    DEBUG_POOL,
+    "AllocatePoolI: Type %x, Addr %p (len %lx) %,ld\n",
+    Pool->MemoryType,
+    SLAB_HEAD_TO_DATA (Head),
+    (UINT64)Size,
+    (UINT64)Pool->Used
+    ));
+
+  return SLAB_HEAD_TO_DATA (Head);
+}
+
+// MU_CHANGE [END]
+
 /**
   Internal function to allocate pool of a particular type.
   Caller must have the memory lock held
@@ -397,6 +608,18 @@ CoreAllocatePoolI (
   //
   Size = ALIGN_VARIABLE (Size);
 
+  // MU_CHANGE [BEGIN] - Small-object slabs
+  if (POOL_SIZE_CLASSES && (Size <= MAX_POOL_SLAB_SIZE) && !NeedGuard && !PageAsPool) {
+    Pool = LookupPoolHead (PoolType);
+    if (Pool == NULL) {
+      return NULL;
+    }
+
+    return CoreAllocatePoolSlabI (Pool, Size, Granularity);
+  }
+
+  // MU_CHANGE [END]
+
   Size += POOL_OVERHEAD;
   Index = SIZE_TO_LIST (Size);
   Pool  = LookupPoolHead (PoolType);
@@ -673,6 +896,133 @@ CoreFreePoolPagesWithGuard (
   }
 }
 
+// MU_CHANGE [BEGIN] - Small-object slabs
+
+/**
+  Returns the slab slot header of a pool entry if it was allocated from a slab.
+
+  @param  Buffer                 The allocated pool entry
+
+  @return The slab slot header, or NULL if Buffer has a POOL_HEAD.
+
+**/
+STATIC
+POOL_SLAB_HEAD *
+GetPoolSlabHead (
+  IN VOID  *Buffer
+  )
+{
+  POOL_SLAB_HEAD  *Head;
+  POOL_SLAB       *Slab;
+
+  //
+  // The bytes before a regular pool entry are the end of its POOL_HEAD, which
+  // never holds POOL_SLAB_HEAD_SIGNATURE followed by a valid slab offset.
+  //
+  Head = DATA_TO_SLAB_HEAD (Buffer);
+  if ((Head->Signature != POOL_SLAB_HEAD_SIGNATURE) ||
+      (Head->Offset < SIZE_OF_POOL_SLAB) ||
+      (Head->Offset >= RUNTIME_PAGE_ALLOCATION_GRANULARITY))
+  {
+    return NULL;
+  }
+
+  Slab = (POOL_SLAB *)((UINT8 *)Head - Head->Offset);
+  if (Slab->Signature != POOL_SLAB_SIGNATURE) {
+    return NULL;
+  }
+
+  return Head;
+}
+
+/**
+  Internal function to free a pool entry allocated from a slab.
+  Caller must have the memory lock held
+
+  @param  Head                   The slab slot header of the entry to free
+  @param  PoolType               Pointer to pool type
+
+  @retval EFI_INVALID_PARAMETER  Buffer not valid
+  @retval EFI_SUCCESS            Buffer successfully freed.
+
+**/
+STATIC
+EFI_STATUS
+CoreFreePoolSlabI (
+  IN  POOL_SLAB_HEAD   *Head,
+  OUT EFI_MEMORY_TYPE  *PoolType OPTIONAL
+  )
+{
+  POOL_SLAB  *Slab;
+  POOL       *Pool;
+  UINTN      SlotSize;
+
+  ASSERT_LOCKED (&mPoolMemoryLock);
+
+  Slab = (POOL_SLAB *)((UINT8 *)Head - Head->Offset);
+  ASSERT (Slab->Index < MAX_POOL_SLAB_LIST);
+  if (Slab->Index >= MAX_POOL_SLAB_LIST) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Pool = LookupPoolHead (Slab->Type);
+  if (Pool == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  SlotSize    = SLAB_SLOT_SIZE (Slab->Index);
+  Pool->Used -= SlotSize;
+  DEBUG ((DEBUG_POOL, "FreePool: %p (len %lx) %,ld\n", SLAB_HEAD_TO_DATA (Head), (UINT64)mPoolSlabSizeTable[Slab->Index], (UINT64)Pool->Used));
+
+  if (PoolType != NULL) {
+    *PoolType = Slab->Type;
+  }
+
+  DEBUG_CLEAR_MEMORY (SLAB_HEAD_TO_DATA (Head), mPoolSlabSizeTable[Slab->Index]);
+
+  //
+  // Put the slot back on the free list of its slab
+  //
+  Head->Signature                               = POOL_SLAB_FREE_SIGNATURE;
+  *(POOL_SLAB_HEAD **)SLAB_HEAD_TO_DATA (Head) = Slab->FreeSlots;
+  Slab->FreeSlots                               = Head;
+  Slab->FreeCount++;
+
+  if (Slab->FreeCount == 1) {
+    //
+    // The slab was full, so it is not on the list of slabs with free slots
+    //
+    InsertHeadList (&Pool->SlabList[Slab->Index], &Slab->Link);
+  }
+
+  if (Slab->FreeCount == Slab->SlotCount) {
+    //
+    // Every slot of the slab is free, so return its pages
+    //
+    RemoveEntryList (&Slab->Link);
+    Slab->Signature = 0;
+    CoreFreePoolPagesI (
+      Pool->MemoryType,
+      (EFI_PHYSICAL_ADDRESS)(UINTN)Slab,
+      EFI_SIZE_TO_PAGES (Slab->BlockSize)
+      );
+  }
+
+  //
+  // If this is an OS/OEM specific memory type, then check to see if the last
+  // portion of that memory type has been freed.  If it has, then free the
+  // list entry for that memory type
+  //
+  if (((UINT32)Pool->MemoryType >= MEMORY_TYPE_OEM_RESERVED_MIN) && (Pool->Used == 0)) {
+    RemoveEntryList (&Pool->Link);
+    CoreFreePoolI (Pool, NULL);
+  }
+
+  return EFI_SUCCESS;
+}
+
+// MU_CHANGE [END]
+
 /**
   Internal function to free a pool entry.
   Caller must have the memory lock held
@@ -690,22 +1040,32 @@ CoreFreePoolI (
   OUT EFI_MEMORY_TYPE  *PoolType OPTIONAL
   )
 {
-  POOL       *Pool;
-  POOL_HEAD  *Head;
-  POOL_TAIL  *Tail;
-  POOL_FREE  *Free;
-  UINTN      Index;
-  UINTN      NoPages;
-  UINTN      Size;
-  CHAR8      *NewPage;
-  UINTN      Offset;
-  BOOLEAN    AllFree;
-  UINTN      Granularity;
-  BOOLEAN    IsGuarded;
-  BOOLEAN    HasPoolTail;
-  BOOLEAN    PageAsPool;
+  POOL            *Pool;
+  POOL_HEAD       *Head;
+  POOL_TAIL       *Tail;
+  POOL_FREE       *Free;
+  UINTN           Index;
+  UINTN           NoPages;
+  UINTN           Size;
+  CHAR8           *NewPage;
+  UINTN           Offset;
+  BOOLEAN         AllFree;
+  UINTN           Granularity;
+  BOOLEAN         IsGuarded;
+  BOOLEAN         HasPoolTail;
+  BOOLEAN         PageAsPool;
+  POOL_SLAB_HEAD  *SlabHead;      // MU_CHANGE - Small-object slabs
 
   ASSERT (Buffer != NULL);
+
+  // MU_CHANGE [BEGIN] - Small-object slabs
+  SlabHead = POOL_SIZE_CLASSES ? GetPoolSlabHead (Buffer) : NULL;
+  if (SlabHead != NULL) {
+    return CoreFreePoolSlabI (SlabHead, PoolType);
+  }
+
+  // MU_CHANGE [END]
+
   //
   // Get the head & tail of the pool entry
   //
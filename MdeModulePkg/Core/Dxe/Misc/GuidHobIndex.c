@@ -0,0 +1,131 @@
+/** @file
+  Build the index of the GUID extension HOBs and install it as a configuration
+  table, so that the DXE HobLib can find GUID HOBs without walking the HOB list.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DxeMain.h"
+
+/**
+  Find the first entry of a GUID in the hash bucket chain of the index.
+
+  @param  Index         The GUID HOB index.
+  @param  Guid          The GUID to look for.
+  @param  Link          Returns the link that points to the entry, or the
+                        last link of the chain if the GUID is not found.
+
+  @return The 1-based entry number, or GUID_HOB_INDEX_END.
+
+**/
+STATIC
+UINT32
+FindGuidHobIndexHead (
+  IN  GUID_HOB_INDEX  *Index,
+  IN  EFI_GUID        *Guid,
+  OUT UINT32          **Link
+  )
+{
+  GUID_HOB_INDEX_ENTRY  *Entries;
+  EFI_HOB_GUID_TYPE     *GuidHob;
+
+  Entries = GUID_HOB_INDEX_ENTRIES (Index);
+  *Link   = &GUID_HOB_INDEX_BUCKETS (Index)[GUID_HOB_INDEX_BUCKET (Index, Guid)];
+  while (**Link != GUID_HOB_INDEX_END) {
+    GuidHob = (EFI_HOB_GUID_TYPE *)(UINTN)Entries[**Link - 1].Hob;
+    if (CompareGuid (Guid, &GuidHob->Name)) {
+      break;
+    }
+
+    *Link = &Entries[**Link - 1].NextInBucket;
+  }
+
+  return **Link;
+}
+
+/**
+  Build the GUID HOB index of a HOB list and install it into the EFI System
+  Table's Configuration Table.
+
+  The index is an optimization only. If it cannot be built, the DXE HobLib
+  walks the HOB list.
+
+  @param  HobStart      The HOB list.
+
+**/
+VOID
+CoreInstallGuidHobIndex (
+  IN VOID  *HobStart
+  )
+{
+  EFI_STATUS            Status;
+  EFI_PEI_HOB_POINTERS  Hob;
+  UINT32                EntryCount;
+  UINT32                BucketCount;
+  GUID_HOB_INDEX        *Index;
+  GUID_HOB_INDEX_ENTRY  *Entries;
+  UINT32                Entry;
+  UINT32                Head;
+  UINT32                *Link;
+
+  EntryCount = 0;
+  for (Hob.Raw = HobStart; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    if (GET_HOB_TYPE (Hob) == EFI_HOB_TYPE_GUID_EXTENSION) {
+      EntryCount++;
+    }
+  }
+
+  if (EntryCount == 0) {
+    return;
+  }
+
+  //
+  // Keep the buckets at most half full.
+  //
+  BucketCount = GetPowerOfTwo32 (EntryCount) << 1;
+  Index       = AllocateZeroPool (GUID_HOB_INDEX_SIZE (EntryCount, BucketCount));
+  if (Index == NULL) {
+    return;
+  }
+
+  Index->Signature   = GUID_HOB_INDEX_SIGNATURE;
+  Index->BucketCount = BucketCount;
+  Index->EntryCount  = EntryCount;
+  Index->HobList     = (EFI_PHYSICAL_ADDRESS)(UINTN)HobStart;
+
+  Entries = GUID_HOB_INDEX_ENTRIES (Index);
+  Entry   = 0;
+  for (Hob.Raw = HobStart; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    if (GET_HOB_TYPE (Hob) == EFI_HOB_TYPE_GUID_EXTENSION) {
+      Entries[Entry++].Hob = (EFI_PHYSICAL_ADDRESS)(UINTN)Hob.Raw;
+    }
+  }
+
+  Index->HobListEnd = (EFI_PHYSICAL_ADDRESS)(UINTN)Hob.Raw;
+
+  //
+  // Link the HOBs from the last to the first, so that each HOB becomes the head
+  // of its GUID chain in front of the later HOBs with the same GUID.
+  //
+  for (Entry = EntryCount; Entry > 0; Entry--) {
+    Head = FindGuidHobIndexHead (Index, &((EFI_HOB_GUID_TYPE *)(UINTN)Entries[Entry - 1].Hob)->Name, &Link);
+    if (Head != GUID_HOB_INDEX_END) {
+      Entries[Entry - 1].NextSameGuid = Head;
+      Entries[Entry - 1].NextInBucket = Entries[Head - 1].NextInBucket;
+      Entries[Head - 1].NextInBucket  = GUID_HOB_INDEX_END;
+    }
+
+    *Link = Entry;
+  }
+
+  Status = CoreInstallConfigurationTable (&gEdkiiGuidHobIndexGuid, Index);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "%a: Failed to install the GUID HOB index - %r\n", __func__, Status));
+    FreePool (Index);
+    return;
+  }
+
+  DEBUG ((DEBUG_INFO, "GUID HOB index: %d HOBs in %d buckets\n", EntryCount, BucketCount));
+}
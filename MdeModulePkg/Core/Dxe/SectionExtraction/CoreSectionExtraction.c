@@ -82,10 +82,54 @@ typedef struct {
   // Authentication status is from GUIDed encapsulations.
   //
   UINT32        AuthenticationStatus;
+  // MU_CHANGE [BEGIN] - Cache decoded section streams
+  //
+  // Handle of the firmware volume and name of the file the stream was read
+  // from, FvHandle is NULL if the stream is not part of a firmware volume
+  // file. Encapsulations decoded from the stream are cached under this key.
+  //
+  EFI_HANDLE    FvHandle;
+  EFI_GUID      FileName;
+  // MU_CHANGE [END]
 } CORE_SECTION_STREAM_NODE;
 
 #define NULL_STREAM_HANDLE  0
 
+// MU_CHANGE [BEGIN] - Cache decoded section streams
+#define SECTION_CACHE_ENTRY_SIGNATURE  SIGNATURE_32('S','X','C','E')
+#define SECTION_CACHE_ENTRY_FROM_LINK(Node) \
+  CR (Node, SECTION_CACHE_ENTRY, Link, SECTION_CACHE_ENTRY_SIGNATURE)
+
+//
+// Maximum number of entries in the decoded section cache, on top of the size
+// limit set by PcdFwVolDxeSectionCacheSize.
+//
+#define SECTION_CACHE_MAX_ENTRIES  32
+
+typedef struct {
+  UINT32        Signature;
+  LIST_ENTRY    Link;
+  //
+  // Firmware volume handle and file name of the stream the encapsulation
+  // section was decoded from.
+  //
+  EFI_HANDLE    FvHandle;
+  EFI_GUID      FileName;
+  //
+  // Copy of the encapsulation section. A lookup only hits when the section
+  // being decoded has the same content, so an FV replaced under the same
+  // handle or several encapsulations in one file never mix up.
+  //
+  UINT8         *Section;
+  UINTN         SectionSize;
+  //
+  // Decoded section stream.
+  //
+  UINT8         *Data;
+  UINTN         DataSize;
+} SECTION_CACHE_ENTRY;
+// MU_CHANGE [END]
+
 typedef struct {
   CORE_SECTION_CHILD_NODE     *ChildNode;
   CORE_SECTION_STREAM_NODE    *ParentStream;
@@ -190,6 +234,17 @@ CustomGuidedSectionExtract (
 //
 LIST_ENTRY  mStreamRoot = INITIALIZE_LIST_HEAD_VARIABLE (mStreamRoot);
 
+// MU_CHANGE [BEGIN] - Cache decoded section streams
+//
+// Decoded section cache, most recently used entry first.
+//
+LIST_ENTRY  mSectionCache = INITIALIZE_LIST_HEAD_VARIABLE (mSectionCache);
+UINTN       mSectionCacheSize;
+UINTN       mSectionCacheCount;
+UINTN       mSectionCacheHits;
+UINTN       mSectionCacheMisses;
+// MU_CHANGE [END]
+
 EFI_HANDLE  mSectionExtractionHandle = NULL;
 
 EFI_GUIDED_SECTION_EXTRACTION_PROTOCOL  mCustomGuidedSectionExtractionProtocol = {
@@ -385,6 +440,8 @@ OpenSectionStreamEx (
   NewStream->StreamLength = SectionStreamLength;
   InitializeListHead (&NewStream->Children);
   NewStream->AuthenticationStatus = AuthenticationStatus;
+  NewStream->FvHandle             = NULL;                 // MU_CHANGE
+  ZeroMem (&NewStream->FileName, sizeof (EFI_GUID));      // MU_CHANGE
 
   //
   // Add new stream to stream list
@@ -437,6 +494,219 @@ OpenSectionStream (
            );
 }
 
+// MU_CHANGE [BEGIN] - Cache decoded section streams
+
+/**
+  Creates and returns a new section stream handle for the sections of a file
+  in a firmware volume.
+
+  This function behaves as OpenSectionStream (), except that the encapsulation
+  sections decoded from the stream are kept in the decoded section cache under
+  FvHandle and FileName, so that a later stream over the same file does not
+  run the decompression or the GUIDed section extraction again.
+
+  @param  SectionStreamLength    Size in bytes of the section stream.
+  @param  SectionStream          Buffer containing the new section stream.
+  @param  FvHandle               Handle of the firmware volume holding the file.
+  @param  FileName               Name of the file.
+  @param  SectionStreamHandle    A pointer to a caller allocated UINTN that on
+                                 output contains the new section stream handle.
+
+  @retval EFI_SUCCESS            The section stream is created successfully.
+  @retval EFI_OUT_OF_RESOURCES   memory allocation failed.
+  @retval EFI_INVALID_PARAMETER  Section stream does not end concident with end
+                                 of last section.
+
+**/
+EFI_STATUS
+OpenFileSectionStream (
+  IN     UINTN       SectionStreamLength,
+  IN     VOID        *SectionStream,
+  IN     EFI_HANDLE  FvHandle,
+  IN     EFI_GUID    *FileName,
+  OUT UINTN          *SectionStreamHandle
+  )
+{
+  EFI_STATUS                Status;
+  CORE_SECTION_STREAM_NODE  *Stream;
+
+  Status = OpenSectionStream (SectionStreamLength, SectionStream, SectionStreamHandle);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Stream           = (CORE_SECTION_STREAM_NODE *)*SectionStreamHandle;
+  Stream->FvHandle = FvHandle;
+  CopyGuid (&Stream->FileName, FileName);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Worker function.  Looks up the decoded content of an encapsulation section
+  in the decoded section cache.
+
+  Hits and misses are counted, and logged as performance events, only for
+  streams read from a firmware volume file.
+
+  @param  Stream                 Section stream that holds the section.
+  @param  SectionHeader          The encapsulation section.
+  @param  SectionSize            Size in bytes of the encapsulation section.
+  @param  NewStreamBuffer        If *NewStreamBuffer is non-null on input, the
+                                 decoded stream is copied in the caller buffer
+                                 of *NewStreamBufferSize bytes. Otherwise it
+                                 points on output to a pool copy of the decoded
+                                 stream.
+  @param  NewStreamBufferSize    Size in bytes of the decoded stream.
+
+  @retval TRUE                   The decoded stream was found in the cache.
+  @retval FALSE                  The section must be decoded.
+
+**/
+BOOLEAN
+SectionCacheLookup (
+  IN     CORE_SECTION_STREAM_NODE   *Stream,
+  IN     EFI_COMMON_SECTION_HEADER  *SectionHeader,
+  IN     UINTN                      SectionSize,
+  IN OUT VOID                       **NewStreamBuffer,
+  IN OUT UINTN                      *NewStreamBufferSize
+  )
+{
+  LIST_ENTRY           *Link;
+  SECTION_CACHE_ENTRY  *Entry;
+  BOOLEAN              Hit;
+  EFI_TPL              OldTpl;
+
+  if ((Stream->FvHandle == NULL) || (PcdGet32 (PcdFwVolDxeSectionCacheSize) == 0)) {
+    return FALSE;
+  }
+
+  Hit    = FALSE;
+  OldTpl = CoreRaiseTpl (TPL_NOTIFY);
+  for (Link = GetFirstNode (&mSectionCache); !IsNull (&mSectionCache, Link); Link = GetNextNode (&mSectionCache, Link)) {
+    Entry = SECTION_CACHE_ENTRY_FROM_LINK (Link);
+    if ((Entry->FvHandle != Stream->FvHandle) ||
+        (Entry->SectionSize != SectionSize) ||
+        !CompareGuid (&Entry->FileName, &Stream->FileName) ||
+        (CompareMem (Entry->Section, SectionHeader, SectionSize) != 0))
+    {
+      continue;
+    }
+
+    if (*NewStreamBuffer != NULL) {
+      if (Entry->DataSize == *NewStreamBufferSize) {
+        CopyMem (*NewStreamBuffer, Entry->Data, Entry->DataSize);
+        Hit = TRUE;
+      }
+    } else {
+      *NewStreamBuffer = AllocateCopyPool (Entry->DataSize, Entry->Data);
+      if (*NewStreamBuffer != NULL) {
+        *NewStreamBufferSize = Entry->DataSize;
+        Hit                  = TRUE;
+      }
+    }
+
+    if (Hit) {
+      //
+      // Move the entry to the front of the list.
+      //
+      RemoveEntryList (&Entry->Link);
+      InsertHeadList (&mSectionCache, &Entry->Link);
+    }
+
+    break;
+  }
+
+  if (Hit) {
+    mSectionCacheHits++;
+  } else {
+    mSectionCacheMisses++;
+  }
+
+  CoreRestoreTpl (OldTpl);
+
+  if (Hit) {
+    PERF_EVENT ("SectionCacheHit");
+  } else {
+    PERF_EVENT ("SectionCacheMiss");
+  }
+
+  return Hit;
+}
+
+/**
+  Worker function.  Adds the decoded content of an encapsulation section to
+  the decoded section cache, evicting the least recently used entries to stay
+  within PcdFwVolDxeSectionCacheSize bytes and SECTION_CACHE_MAX_ENTRIES
+  entries.
+
+  @param  Stream                 Section stream that holds the section.
+  @param  SectionHeader          The encapsulation section.
+  @param  SectionSize            Size in bytes of the encapsulation section.
+  @param  NewStreamBuffer        The decoded stream.
+  @param  NewStreamBufferSize    Size in bytes of the decoded stream.
+
+**/
+VOID
+SectionCacheInsert (
+  IN CORE_SECTION_STREAM_NODE   *Stream,
+  IN EFI_COMMON_SECTION_HEADER  *SectionHeader,
+  IN UINTN                      SectionSize,
+  IN VOID                       *NewStreamBuffer,
+  IN UINTN                      NewStreamBufferSize
+  )
+{
+  SECTION_CACHE_ENTRY  *Entry;
+  SECTION_CACHE_ENTRY  *Victim;
+  UINTN                CacheLimit;
+  UINTN                EntrySize;
+  EFI_TPL              OldTpl;
+
+  CacheLimit = PcdGet32 (PcdFwVolDxeSectionCacheSize);
+  if ((Stream->FvHandle == NULL) || (NewStreamBufferSize == 0) ||
+      (SectionSize > CacheLimit) || (NewStreamBufferSize > CacheLimit))
+  {
+    return;
+  }
+
+  EntrySize = sizeof (SECTION_CACHE_ENTRY) + SectionSize + NewStreamBufferSize;
+  if (EntrySize > CacheLimit) {
+    return;
+  }
+
+  Entry = AllocatePool (EntrySize);
+  if (Entry == NULL) {
+    return;
+  }
+
+  Entry->Signature   = SECTION_CACHE_ENTRY_SIGNATURE;
+  Entry->FvHandle    = Stream->FvHandle;
+  Entry->Section     = (UINT8 *)(Entry + 1);
+  Entry->SectionSize = SectionSize;
+  Entry->Data        = Entry->Section + SectionSize;
+  Entry->DataSize    = NewStreamBufferSize;
+  CopyGuid (&Entry->FileName, &Stream->FileName);
+  CopyMem (Entry->Section, SectionHeader, SectionSize);
+  CopyMem (Entry->Data, NewStreamBuffer, NewStreamBufferSize);
+
+  OldTpl = CoreRaiseTpl (TPL_NOTIFY);
+  while ((mSectionCacheCount >= SECTION_CACHE_MAX_ENTRIES) || (mSectionCacheSize + EntrySize > CacheLimit)) {
+    ASSERT (!IsListEmpty (&mSectionCache));
+    Victim = SECTION_CACHE_ENTRY_FROM_LINK (GetPreviousNode (&mSectionCache, &mSectionCache));
+    RemoveEntryList (&Victim->Link);
+    mSectionCacheSize -= sizeof (SECTION_CACHE_ENTRY) + Victim->SectionSize + Victim->DataSize;
+    mSectionCacheCount--;
+    CoreFreePool (Victim);
+  }
+
+  InsertHeadList (&mSectionCache, &Entry->Link);
+  mSectionCacheSize += EntrySize;
+  mSectionCacheCount++;
+  CoreRestoreTpl (OldTpl);
+}
+
+// MU_CHANGE [END]
+
 /**
   Worker function.  Determine if the input stream:child matches the input type.
 
@@ -598,6 +868,13 @@ NotifyGuidedExtraction (
              &Context->ChildNode->EncapsulatedStreamHandle
              );
   ASSERT_EFI_ERROR (Status);
+  // MU_CHANGE [BEGIN] - Cache decoded section streams
+  if (!EFI_ERROR (Status)) {
+    ((CORE_SECTION_STREAM_NODE *)Context->ChildNode->EncapsulatedStreamHandle)->FvHandle = Context->ParentStream->FvHandle;
+    CopyGuid (&((CORE_SECTION_STREAM_NODE *)Context->ChildNode->EncapsulatedStreamHandle)->FileName, &Context->ParentStream->FileName);
+  }
+
+  // MU_CHANGE [END]
 
   //
   //  Close the event when done.
@@ -690,6 +967,7 @@ CreateChildNode (
   UINT32                                  UncompressedLength;
   UINT8                                   CompressionType;
   UINT16                                  GuidedSectionAttributes;
+  BOOLEAN                                 Cacheable; // MU_CHANGE
 
   CORE_SECTION_CHILD_NODE  *Node;
 
@@ -762,7 +1040,15 @@ CreateChildNode (
           // stream is not actually compressed, just encapsulated.  So just copy it.
           //
           CopyMem (NewStreamBuffer, CompressionSource, NewStreamBufferSize);
-        } else if (CompressionType == EFI_STANDARD_COMPRESSION) {
+          // MU_CHANGE [BEGIN] - Cache decoded section streams
+          //
+          // A stream found in the decoded section cache is copied in
+          // NewStreamBuffer by SectionCacheLookup ().
+          //
+        } else if ((CompressionType == EFI_STANDARD_COMPRESSION) &&
+                   !SectionCacheLookup (Stream, SectionHeader, Node->Size, &NewStreamBuffer, &NewStreamBufferSize))
+        {
+          // MU_CHANGE [END]
           //
           // Only support the EFI_SATNDARD_COMPRESSION algorithm.
           //
@@ -813,6 +1099,8 @@ CreateChildNode (
             CoreFreePool (NewStreamBuffer);
             return Status;
           }
+
+          SectionCacheInsert (Stream, SectionHeader, Node->Size, NewStreamBuffer, NewStreamBufferSize); // MU_CHANGE
         }
       } else {
         NewStreamBuffer     = NULL;
@@ -845,22 +1133,41 @@ CreateChildNode (
       }
 
       if (VerifyGuidedSectionGuid (Node->EncapsulationGuid, &GuidedExtraction)) {
+        // MU_CHANGE [BEGIN] - Cache decoded section streams
         //
-        // NewStreamBuffer is always allocated by ExtractSection... No caller
-        // allocation here.
+        // Sections that contribute authentication data always go through the
+        // extraction protocol, so their authentication status is never stale.
+        // The status returned by the protocol for the other sections is
+        // replaced with the one of the parent stream below.
         //
-        Status = GuidedExtraction->ExtractSection (
-                                     GuidedExtraction,
-                                     GuidedHeader,
-                                     &NewStreamBuffer,
-                                     &NewStreamBufferSize,
-                                     &AuthenticationStatus
-                                     );
-        if (EFI_ERROR (Status)) {
-          CoreFreePool (*ChildNode);
-          return EFI_PROTOCOL_ERROR;
+        NewStreamBuffer = NULL;
+        Cacheable       = (BOOLEAN)((GuidedSectionAttributes & EFI_GUIDED_SECTION_AUTH_STATUS_VALID) == 0);
+        if (Cacheable && SectionCacheLookup (Stream, SectionHeader, Node->Size, &NewStreamBuffer, &NewStreamBufferSize)) {
+          AuthenticationStatus = 0;
+        } else {
+          //
+          // NewStreamBuffer is always allocated by ExtractSection... No caller
+          // allocation here.
+          //
+          Status = GuidedExtraction->ExtractSection (
+                                       GuidedExtraction,
+                                       GuidedHeader,
+                                       &NewStreamBuffer,
+                                       &NewStreamBufferSize,
+                                       &AuthenticationStatus
+                                       );
+          if (EFI_ERROR (Status)) {
+            CoreFreePool (*ChildNode);
+            return EFI_PROTOCOL_ERROR;
+          }
+
+          if (Cacheable) {
+            SectionCacheInsert (Stream, SectionHeader, Node->Size, NewStreamBuffer, NewStreamBufferSize);
+          }
         }
 
+        // MU_CHANGE [END]
+
         //
         // Make sure we initialize the new stream with the correct
         // authentication status for both aggregate and local status fields.
@@ -945,6 +1252,17 @@ CreateChildNode (
       break;
   }
 
+  // MU_CHANGE [BEGIN] - Cache decoded section streams
+  //
+  // Encapsulated streams belong to the same file as their parent stream.
+  //
+  if (Node->EncapsulatedStreamHandle != NULL_STREAM_HANDLE) {
+    ((CORE_SECTION_STREAM_NODE *)Node->EncapsulatedStreamHandle)->FvHandle = Stream->FvHandle;
+    CopyGuid (&((CORE_SECTION_STREAM_NODE *)Node->EncapsulatedStreamHandle)->FileName, &Stream->FileName);
+  }
+
+  // MU_CHANGE [END]
+
   //
   // Last, add the new child node to the stream
   //
@@ -0,0 +1,75 @@
+/** @file
+  The ring buffer shared by the DXE modules that use DxeBufferedDebugLibSerialPort.
+
+  The first module that uses the library allocates the ring and installs it as
+  a configuration table. Every module then copies its debug messages into the
+  ring, and the ring is drained to the serial port in the background.
+
+  The ring holds records, each made of a UINT32 header followed by the message
+  and padded to a UINT32 boundary. Producers reserve a record by moving Head with
+  a compare exchange, copy the message, then set DEBUG_RING_RECORD_COMMITTED in
+  the header. The single consumer sends committed records from Tail and stops at
+  the first record that is not committed yet.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __BUFFERED_DEBUG_RING_H__
+#define __BUFFERED_DEBUG_RING_H__
+
+#define EDKII_BUFFERED_DEBUG_RING_GUID \
+  { 0x7170659d, 0xc1b4, 0x45be, { 0xae, 0xdb, 0x61, 0xa4, 0x39, 0xcd, 0x43, 0x08 } }
+
+extern EFI_GUID  gEdkiiBufferedDebugRingGuid;
+
+#define DEBUG_RING_SIGNATURE  SIGNATURE_32 ('D', 'B', 'G', 'R')
+
+#define DEBUG_RING_RECORD_COMMITTED  BIT31
+#define DEBUG_RING_RECORD_LENGTH     (BIT31 - 1)
+
+typedef struct {
+  UINT32             Signature;
+  ///
+  /// The size of Data in bytes, a power of two.
+  ///
+  UINT32             Size;
+  ///
+  /// Free running offsets in Data. Producers reserve records at Head, and the
+  /// record at Tail is the next one to be sent.
+  ///
+  volatile UINT32    Head;
+  volatile UINT32    Tail;
+  ///
+  /// The number of message bytes of the record at Tail already sent.
+  ///
+  volatile UINT32    Sent;
+  ///
+  /// Non-zero while a consumer drains the ring.
+  ///
+  volatile UINT32    Draining;
+  ///
+  /// Non-zero while a module runs the periodic drain timer, and from
+  /// ExitBootServices() on.
+  ///
+  volatile UINT32    TimerOwned;
+  ///
+  /// Non-zero once the statistics have been reported.
+  ///
+  volatile UINT32    Reported;
+  ///
+  /// Back-pressure statistics.
+  ///
+  volatile UINT32    MessageCount;    ///< Messages copied into the ring
+  volatile UINT32    FullCount;       ///< Messages that found the ring full
+  volatile UINT32    DirectCount;     ///< Messages written to the serial port around the ring
+  volatile UINT32    HighWater;       ///< Largest number of bytes used in the ring
+  //
+  // UINT8           Data[Size];
+  //
+} DEBUG_RING;
+
+#define DEBUG_RING_DATA(Ring)  ((UINT8 *)((DEBUG_RING *)(Ring) + 1))
+
+#endif
@@ -32,6 +32,9 @@ typedef struct {
   ///
   /// The length of data that have been backed up in spare block.
   /// It is also the length of target block that has been erased.
+  /// MU_CHANGE - For a last write record, it is the length from TargetAddress to the end
+  /// of the data written. The spare block holds all the target blocks it spans, which
+  /// have all been erased.
   ///
   UINT64                  Length;
 } FAULT_TOLERANT_WRITE_LAST_WRITE_DATA;
@@ -0,0 +1,89 @@
+/** @file
+  Index of the GUID extension HOBs in the HOB list, published by the DXE core
+  as a configuration table.
+
+  The index lets GetFirstGuidHob() and GetNextGuidHob() find a GUID HOB with a
+  hash lookup instead of a walk of the whole HOB list. The first HOB of each
+  GUID is chained from a hash bucket, and every HOB of a GUID is chained to the
+  next HOB of the same GUID in HOB list order.
+
+  The index only describes the HOB list that it names. A consumer that does not
+  find the index, or finds one for another HOB list, walks the HOB list.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __GUID_HOB_INDEX_H__
+#define __GUID_HOB_INDEX_H__
+
+#define EDKII_GUID_HOB_INDEX_GUID \
+  { 0x5eba3134, 0xe2d5, 0x4a64, { 0x99, 0x70, 0x82, 0x84, 0xf2, 0x0f, 0x1a, 0x40 } }
+
+extern EFI_GUID  gEdkiiGuidHobIndexGuid;
+
+#define GUID_HOB_INDEX_SIGNATURE  SIGNATURE_32 ('G', 'H', 'I', 'X')
+
+///
+/// Entry numbers in the index are 1-based, 0 ends a chain.
+///
+#define GUID_HOB_INDEX_END  0
+
+typedef struct {
+  ///
+  /// The GUID extension HOB.
+  ///
+  EFI_PHYSICAL_ADDRESS    Hob;
+  ///
+  /// The entry of the next HOB with the same GUID, in HOB list order.
+  ///
+  UINT32                  NextSameGuid;
+  ///
+  /// The entry of the first HOB of the next GUID in the same hash bucket.
+  /// Only used by the first HOB of each GUID.
+  ///
+  UINT32                  NextInBucket;
+} GUID_HOB_INDEX_ENTRY;
+
+typedef struct {
+  UINT32                  Signature;
+  ///
+  /// The number of hash buckets, a power of two.
+  ///
+  UINT32                  BucketCount;
+  ///
+  /// The number of GUID extension HOBs in the HOB list.
+  ///
+  UINT32                  EntryCount;
+  UINT32                  Reserved;
+  ///
+  /// The first HOB of the indexed HOB list.
+  ///
+  EFI_PHYSICAL_ADDRESS    HobList;
+  ///
+  /// The end of list HOB of the indexed HOB list.
+  ///
+  EFI_PHYSICAL_ADDRESS    HobListEnd;
+  //
+  // GUID_HOB_INDEX_ENTRY  Entry[EntryCount];
+  // UINT32                Bucket[BucketCount];
+  //
+} GUID_HOB_INDEX;
+
+#define GUID_HOB_INDEX_ENTRIES(Index)  ((GUID_HOB_INDEX_ENTRY *)((GUID_HOB_INDEX *)(Index) + 1))
+#define GUID_HOB_INDEX_BUCKETS(Index)  ((UINT32 *)(GUID_HOB_INDEX_ENTRIES (Index) + (Index)->EntryCount))
+
+#define GUID_HOB_INDEX_SIZE(EntryCount, BucketCount) \
+  (sizeof (GUID_HOB_INDEX) + (EntryCount) * sizeof (GUID_HOB_INDEX_ENTRY) + (BucketCount) * sizeof (UINT32))
+
+///
+/// The hash bucket of a GUID. The GUID may be unaligned, as a GUID passed by a
+/// caller or one in a packed structure can be.
+///
+#define GUID_HOB_INDEX_BUCKET(Index, Guid)                                                         \
+  ((ReadUnaligned32 ((CONST UINT32 *)(Guid)) ^ ReadUnaligned32 ((CONST UINT32 *)(Guid) + 1) ^      \
+    ReadUnaligned32 ((CONST UINT32 *)(Guid) + 2) ^ ReadUnaligned32 ((CONST UINT32 *)(Guid) + 3)) & \
+   ((Index)->BucketCount - 1))
+
+#endif
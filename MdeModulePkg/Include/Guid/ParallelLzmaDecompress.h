@@ -30,4 +30,29 @@ typedef struct {
   UINTN    DecompressedSize;
 } PARALLEL_DECOMPRESSED_BUFFER;
 
+///
+/// Signature of a chunked parallel LZMA payload. The first byte is 0xFF, which
+/// is not a valid LZMA properties byte, so a chunked payload can not be taken
+/// for a plain LZMA stream.
+///
+#define PARALLEL_LZMA_CHUNKED_SIGNATURE  SIGNATURE_32 (0xFF, 'P', 'L', 'C')
+
+///
+/// Header of a chunked parallel LZMA payload.
+///
+/// The data of the section was split into ChunkCount chunks of ChunkSize bytes,
+/// the last one holding what remains of DecompressedSize, and every chunk was
+/// compressed as an independent LZMA stream so the chunks can be decompressed
+/// concurrently. The header is followed by ChunkCount + 1 UINT32 offsets from
+/// the start of the header: the start of each compressed chunk, then the end of
+/// the last one.
+///
+typedef struct {
+  UINT32    Signature;
+  UINT32    ChunkCount;
+  UINT32    ChunkSize;
+  UINT32    DecompressedSize;
+  // UINT32    ChunkOffset[ChunkCount + 1];
+} PARALLEL_LZMA_CHUNKED_HEADER;
+
 #endif
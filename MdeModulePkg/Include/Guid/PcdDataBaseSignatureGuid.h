@@ -108,6 +108,7 @@ typedef struct {
   // UINT32                         ValueUint32[];
   // VPD_HEAD                       VpdHead[];               // VPD Offset
   // DYNAMICEX_MAPPING              ExMapTable[];            // DynamicEx PCD mapped to LocalIndex in LocalTokenNumberTable. It can be accessed by the ExMapTableOffset.
+  //                                                         // MU_CHANGE - Sorted by ExGuidIndex, then by ExTokenNumber.
   // UINT32                         LocalTokenNumberTable[]; // Offset | DataType | PCD Type. It can be accessed by LocalTokenNumberTableOffset.
   // GUID                           GuidTable[];             // GUID for DynamicEx and HII PCD variable Guid. It can be accessed by the GuidTableOffset.
   // STRING_HEAD                    StringHead[];            // String PCD
@@ -77,6 +77,12 @@ typedef struct {
 // The payload for this function is SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO
 //
 #define SMM_VARIABLE_FUNCTION_GET_RUNTIME_CACHE_INFO  14
+// MU_CHANGE [BEGIN] - Batched variable access
+//
+// The payload for this function is SMM_VARIABLE_COMMUNICATE_BATCH.
+//
+#define SMM_VARIABLE_FUNCTION_BATCH  15
+// MU_CHANGE [END]
 
 ///
 /// Size of SMM communicate header, without including the payload.
@@ -147,4 +153,35 @@ typedef struct {
   BOOLEAN    AuthenticatedVariableUsage;
 } SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO;
 
+// MU_CHANGE [BEGIN] - Batched variable access
+
+///
+/// One operation of SMM_VARIABLE_FUNCTION_BATCH. Function is
+/// SMM_VARIABLE_FUNCTION_GET_VARIABLE or SMM_VARIABLE_FUNCTION_SET_VARIABLE and
+/// Access is laid out as for that function. For a get, Access.DataSize is the
+/// size of the data buffer following the name and is updated on return. Each
+/// entry takes SMM_VARIABLE_BATCH_ENTRY_SIZE bytes, computed from the sizes
+/// sent to the handler.
+///
+typedef struct {
+  UINTN                                       Function;
+  EFI_STATUS                                  ReturnStatus;
+  SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE    Access;
+} SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY;
+
+#define SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE  (OFFSET_OF (SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY, Access.Name))
+
+#define SMM_VARIABLE_BATCH_ENTRY_SIZE(NameSize, DataSize) \
+  ALIGN_VALUE (SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE + (NameSize) + (DataSize), sizeof (UINTN))
+
+///
+/// This structure is used to communicate with SMI handler by the batch function.
+/// It is followed by EntryCount SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY entries.
+///
+typedef struct {
+  UINTN    EntryCount;
+} SMM_VARIABLE_COMMUNICATE_BATCH;
+
+// MU_CHANGE [END]
+
 #endif // _SMM_VARIABLE_COMMON_H_
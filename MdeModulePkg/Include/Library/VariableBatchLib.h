@@ -0,0 +1,75 @@
+/** @file -- VariableBatchLib.h
+This library contains helper functions for reading and writing several UEFI
+variables at once through the VariableBatch protocol, falling back to the
+runtime services when the protocol is not available.
+
+Copyright (c) Microsoft Corporation.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _EDKII_VARIABLE_BATCH_LIB_H_
+#define _EDKII_VARIABLE_BATCH_LIB_H_
+
+#include <Protocol/VariableBatch.h>
+
+/**
+  Execute a sequence of GetVariable () and SetVariable () operations.
+
+  The operations are executed in order. When the VariableBatch protocol is
+  installed they are handed to it, so that the variable driver can execute
+  them with as few transitions to MM as possible; otherwise each one is
+  executed with the matching runtime service.
+
+  This function must be called at boot time.
+
+  @param[in]      EntryCount    Number of entries in Entries.
+  @param[in, out] Entries       The operations to execute. The Status field of
+                                each entry receives the status of the operation.
+
+  @retval EFI_SUCCESS           All the operations have been executed.
+  @retval EFI_INVALID_PARAMETER Entries is NULL and EntryCount is not 0.
+
+**/
+EFI_STATUS
+EFIAPI
+ExecuteVariableBatch (
+  IN     UINTN                       EntryCount,
+  IN OUT EDKII_VARIABLE_BATCH_ENTRY  *Entries
+  );
+
+/**
+  Read several UEFI variables, allocating a buffer for the data of each one.
+
+  This is the batched counterpart of GetVariable2 () in UefiLib. The sizes of
+  all the variables are queried with one batch and the data is read with a
+  second one.
+
+  @param[in]  VariableCount     Number of variables to read.
+  @param[in]  VariableNames     Names of the variables to read.
+  @param[in]  VendorGuids       Vendor GUIDs of the variables to read.
+  @param[out] Values            For each variable, a pool buffer holding its data,
+                                or NULL if it could not be read. The caller must
+                                free the buffers with FreePool ().
+  @param[out] Sizes             Optional. For each variable, the size of its data.
+  @param[out] Statuses          Optional. For each variable, the status of the read.
+
+  @retval EFI_SUCCESS           All the variables have been read.
+  @retval EFI_INVALID_PARAMETER VariableNames, VendorGuids or Values is NULL.
+  @retval EFI_OUT_OF_RESOURCES  There are not enough resources to run the batch.
+  @retval EFI_NOT_FOUND         At least one variable could not be read, the
+                                status of each read is in Statuses.
+
+**/
+EFI_STATUS
+EFIAPI
+GetVariableBatch2 (
+  IN  UINTN       VariableCount,
+  IN  CHAR16      **VariableNames,
+  IN  EFI_GUID    **VendorGuids,
+  OUT VOID        **Values,
+  OUT UINTN       *Sizes OPTIONAL,
+  OUT EFI_STATUS  *Statuses OPTIONAL
+  );
+
+#endif
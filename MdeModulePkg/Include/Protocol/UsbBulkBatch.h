@@ -0,0 +1,264 @@
+/** @file
+  USB bulk batch protocols.
+
+  Queue several bulk transfers to a USB device in one call, so the host
+  controller can have all of them on its transfer rings at once instead of
+  waiting for each transfer to complete before the next one is started.
+
+  EDKII_USB2_HC_BULK_BATCH_PROTOCOL is produced by a host controller driver on
+  its controller handle, EDKII_USB_IO_BULK_BATCH_PROTOCOL is produced by the
+  USB bus driver on the USB interface handles of a host controller that has
+  the former.
+
+  The protocols also give access to the streams of SuperSpeed bulk endpoints:
+  once streams are allocated on an endpoint, every transfer to it names the
+  stream it belongs to, and the device decides which stream it serves next.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __EDKII_USB_BULK_BATCH_PROTOCOL_H__
+#define __EDKII_USB_BULK_BATCH_PROTOCOL_H__
+
+#include <Protocol/Usb2HostController.h>
+
+#define EDKII_USB2_HC_BULK_BATCH_PROTOCOL_GUID \
+  { \
+    0xbe9ac4ff, 0x01d4, 0x4158, { 0x90, 0x48, 0x84, 0x86, 0xf3, 0x63, 0xc8, 0x73 } \
+  }
+
+#define EDKII_USB_IO_BULK_BATCH_PROTOCOL_GUID \
+  { \
+    0xc87ee7f0, 0x3bbd, 0x4894, { 0x84, 0x57, 0xfa, 0x0b, 0xb3, 0xae, 0x96, 0x60 } \
+  }
+
+typedef struct _EDKII_USB2_HC_BULK_BATCH_PROTOCOL  EDKII_USB2_HC_BULK_BATCH_PROTOCOL;
+typedef struct _EDKII_USB_IO_BULK_BATCH_PROTOCOL   EDKII_USB_IO_BULK_BATCH_PROTOCOL;
+
+///
+/// One bulk transfer of a batch.
+///
+typedef struct {
+  ///
+  /// The endpoint address, the direction is given by bit 7.
+  ///
+  UINT8         EndPointAddress;
+  ///
+  /// The maximum packet size of the endpoint. Filled in by the USB bus driver
+  /// for EDKII_USB_IO_BULK_BATCH_PROTOCOL.
+  ///
+  UINTN         MaximumPacketLength;
+  VOID          *Data;
+  ///
+  /// Size of Data on input, number of bytes transferred on output.
+  ///
+  UINTN         DataLength;
+  ///
+  /// EFI_USB_ERR_xxx result of the transfer.
+  ///
+  UINT32        TransferResult;
+  ///
+  /// Status of the transfer. EFI_ABORTED if the transfer was cancelled
+  /// because an earlier transfer of the batch failed.
+  ///
+  EFI_STATUS    Status;
+  ///
+  /// Stream of the transfer, 0 for an endpoint without streams, or 1 to the
+  /// stream count returned by AllocateStreams () for an endpoint with them.
+  ///
+  UINT16        StreamId;
+  ///
+  /// The batch does not wait for an optional transfer. If it is not complete
+  /// when all the other transfers are, it is cancelled with EFI_ABORTED. Each
+  /// batch needs at least one transfer which is not optional.
+  ///
+  BOOLEAN       Optional;
+} EDKII_USB_BULK_BATCH_REQUEST;
+
+/**
+  Queue a list of bulk transfers to a USB device and wait for them to complete.
+
+  All the transfers are started before the first one completes. Transfers to
+  the same endpoint are executed in the order of the list. When a transfer
+  fails or the timeout expires, the transfers not completed yet are cancelled.
+
+  @param[in]      This            The EDKII_USB2_HC_BULK_BATCH_PROTOCOL instance.
+  @param[in]      DeviceAddress   Target device address.
+  @param[in]      DeviceSpeed     Device speed.
+  @param[in]      RequestCount    Number of entries in Requests.
+  @param[in, out] Requests        The transfers to execute.
+  @param[in]      Timeout         Timeout, in milliseconds, for the whole batch.
+  @param[in]      Translator      Transaction translator to use.
+
+  @retval EFI_SUCCESS             All the transfers completed successfully.
+  @retval EFI_INVALID_PARAMETER   Some parameters are invalid, or the batch
+                                  does not fit on the transfer rings.
+  @retval EFI_OUT_OF_RESOURCES    Some transfers could not be queued.
+  @retval EFI_TIMEOUT             The batch did not complete in time.
+  @retval EFI_DEVICE_ERROR        A transfer failed, see the Status and
+                                  TransferResult fields of each request.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_USB2_HC_BULK_BATCH_TRANSFER)(
+  IN     EDKII_USB2_HC_BULK_BATCH_PROTOCOL   *This,
+  IN     UINT8                               DeviceAddress,
+  IN     UINT8                               DeviceSpeed,
+  IN     UINTN                               RequestCount,
+  IN OUT EDKII_USB_BULK_BATCH_REQUEST        *Requests,
+  IN     UINTN                               Timeout,
+  IN     EFI_USB2_HC_TRANSACTION_TRANSLATOR  *Translator
+  );
+
+/**
+  Allocate streams on bulk endpoints of a SuperSpeed USB device.
+
+  Each endpoint gets the same number of streams, no more than its SuperSpeed
+  Endpoint Companion descriptor and the host controller allow. The endpoints
+  must not have transfers in progress.
+
+  @param[in]      This              The EDKII_USB2_HC_BULK_BATCH_PROTOCOL instance.
+  @param[in]      DeviceAddress     Target device address.
+  @param[in]      EndpointCount     Number of entries in EndPointAddresses.
+  @param[in]      EndPointAddresses The bulk endpoints, the direction is given by bit 7.
+  @param[in, out] StreamCount       Number of streams wanted on input, number of
+                                    streams allocated on output.
+
+  @retval EFI_SUCCESS             The streams are allocated.
+  @retval EFI_INVALID_PARAMETER   Some parameters are invalid.
+  @retval EFI_UNSUPPORTED         An endpoint or the host controller has no streams.
+  @retval EFI_OUT_OF_RESOURCES    The streams could not be allocated.
+  @retval EFI_DEVICE_ERROR        The host controller failed to enable the streams.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_USB2_HC_ALLOCATE_STREAMS)(
+  IN     EDKII_USB2_HC_BULK_BATCH_PROTOCOL  *This,
+  IN     UINT8                              DeviceAddress,
+  IN     UINTN                              EndpointCount,
+  IN     UINT8                              *EndPointAddresses,
+  IN OUT UINT16                             *StreamCount
+  );
+
+/**
+  Free the streams of bulk endpoints, which go back to a single transfer ring.
+
+  @param[in]  This              The EDKII_USB2_HC_BULK_BATCH_PROTOCOL instance.
+  @param[in]  DeviceAddress     Target device address.
+  @param[in]  EndpointCount     Number of entries in EndPointAddresses.
+  @param[in]  EndPointAddresses The bulk endpoints, the direction is given by bit 7.
+
+  @retval EFI_SUCCESS             The streams are freed.
+  @retval EFI_INVALID_PARAMETER   Some parameters are invalid, or an endpoint
+                                  has no streams.
+  @retval EFI_DEVICE_ERROR        The host controller failed to disable the streams.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_USB2_HC_FREE_STREAMS)(
+  IN EDKII_USB2_HC_BULK_BATCH_PROTOCOL  *This,
+  IN UINT8                              DeviceAddress,
+  IN UINTN                              EndpointCount,
+  IN UINT8                              *EndPointAddresses
+  );
+
+struct _EDKII_USB2_HC_BULK_BATCH_PROTOCOL {
+  EDKII_USB2_HC_BULK_BATCH_TRANSFER    BulkTransfer;
+  EDKII_USB2_HC_ALLOCATE_STREAMS       AllocateStreams;
+  EDKII_USB2_HC_FREE_STREAMS           FreeStreams;
+};
+
+/**
+  Queue a list of bulk transfers to the endpoints of a USB interface and wait
+  for them to complete.
+
+  See EDKII_USB2_HC_BULK_BATCH_TRANSFER, the MaximumPacketLength field of the
+  requests is ignored on input.
+
+  @param[in]      This            The EDKII_USB_IO_BULK_BATCH_PROTOCOL instance.
+  @param[in]      RequestCount    Number of entries in Requests.
+  @param[in, out] Requests        The transfers to execute.
+  @param[in]      Timeout         Timeout, in milliseconds, for the whole batch.
+
+  @retval EFI_SUCCESS             All the transfers completed successfully.
+  @retval EFI_INVALID_PARAMETER   Some parameters are invalid.
+  @retval EFI_OUT_OF_RESOURCES    Some transfers could not be queued.
+  @retval EFI_TIMEOUT             The batch did not complete in time.
+  @retval EFI_DEVICE_ERROR        A transfer failed, see the Status and
+                                  TransferResult fields of each request.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_USB_IO_BULK_BATCH_TRANSFER)(
+  IN     EDKII_USB_IO_BULK_BATCH_PROTOCOL  *This,
+  IN     UINTN                             RequestCount,
+  IN OUT EDKII_USB_BULK_BATCH_REQUEST      *Requests,
+  IN     UINTN                             Timeout
+  );
+
+/**
+  Allocate streams on bulk endpoints of a USB interface.
+
+  See EDKII_USB2_HC_ALLOCATE_STREAMS.
+
+  @param[in]      This              The EDKII_USB_IO_BULK_BATCH_PROTOCOL instance.
+  @param[in]      EndpointCount     Number of entries in EndPointAddresses.
+  @param[in]      EndPointAddresses The bulk endpoints, the direction is given by bit 7.
+  @param[in, out] StreamCount       Number of streams wanted on input, number of
+                                    streams allocated on output.
+
+  @retval EFI_SUCCESS             The streams are allocated.
+  @retval EFI_INVALID_PARAMETER   Some parameters are invalid.
+  @retval EFI_UNSUPPORTED         An endpoint or the host controller has no streams.
+  @retval EFI_OUT_OF_RESOURCES    The streams could not be allocated.
+  @retval EFI_DEVICE_ERROR        The host controller failed to enable the streams.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_USB_IO_ALLOCATE_STREAMS)(
+  IN     EDKII_USB_IO_BULK_BATCH_PROTOCOL  *This,
+  IN     UINTN                             EndpointCount,
+  IN     UINT8                             *EndPointAddresses,
+  IN OUT UINT16                            *StreamCount
+  );
+
+/**
+  Free the streams of bulk endpoints of a USB interface.
+
+  See EDKII_USB2_HC_FREE_STREAMS.
+
+  @param[in]  This              The EDKII_USB_IO_BULK_BATCH_PROTOCOL instance.
+  @param[in]  EndpointCount     Number of entries in EndPointAddresses.
+  @param[in]  EndPointAddresses The bulk endpoints, the direction is given by bit 7.
+
+  @retval EFI_SUCCESS             The streams are freed.
+  @retval EFI_INVALID_PARAMETER   Some parameters are invalid, or an endpoint
+                                  has no streams.
+  @retval EFI_DEVICE_ERROR        The host controller failed to disable the streams.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_USB_IO_FREE_STREAMS)(
+  IN EDKII_USB_IO_BULK_BATCH_PROTOCOL  *This,
+  IN UINTN                             EndpointCount,
+  IN UINT8                             *EndPointAddresses
+  );
+
+struct _EDKII_USB_IO_BULK_BATCH_PROTOCOL {
+  EDKII_USB_IO_BULK_BATCH_TRANSFER    BulkTransfer;
+  EDKII_USB_IO_ALLOCATE_STREAMS       AllocateStreams;
+  EDKII_USB_IO_FREE_STREAMS           FreeStreams;
+};
+
+extern EFI_GUID  gEdkiiUsb2HcBulkBatchProtocolGuid;
+extern EFI_GUID  gEdkiiUsbIoBulkBatchProtocolGuid;
+
+#endif
@@ -0,0 +1,83 @@
+/** @file
+  Variable batch protocol.
+
+  Carries a list of GetVariable () and SetVariable () operations to the variable
+  driver in one call, so a variable driver backed by MM can serve the whole list
+  with a single MM communication instead of one per variable.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __EDKII_VARIABLE_BATCH_PROTOCOL_H__
+#define __EDKII_VARIABLE_BATCH_PROTOCOL_H__
+
+#define EDKII_VARIABLE_BATCH_PROTOCOL_GUID \
+  { \
+    0x96e63c79, 0xa85d, 0x4ca9, { 0x84, 0x1f, 0x84, 0xe7, 0x95, 0x07, 0x9b, 0x97 } \
+  }
+
+typedef struct _EDKII_VARIABLE_BATCH_PROTOCOL EDKII_VARIABLE_BATCH_PROTOCOL;
+
+typedef enum {
+  EdkiiVariableBatchGetVariable,
+  EdkiiVariableBatchSetVariable
+} EDKII_VARIABLE_BATCH_OPERATION;
+
+///
+/// One operation of a batch. The fields match the parameters of the
+/// GetVariable () and SetVariable () runtime services.
+///
+typedef struct {
+  EDKII_VARIABLE_BATCH_OPERATION    Operation;
+  CHAR16                            *VariableName;
+  EFI_GUID                          *VendorGuid;
+  ///
+  /// Attributes of the variable to set. Returns the attributes of the
+  /// variable for a get.
+  ///
+  UINT32                            Attributes;
+  ///
+  /// Size of Data. For a get, the size of the buffer on input and the size
+  /// of the variable data, or the size required, on output.
+  ///
+  UINTN                             DataSize;
+  VOID                              *Data;
+  ///
+  /// Status of the operation, as returned by GetVariable () or SetVariable ().
+  ///
+  EFI_STATUS                        Status;
+} EDKII_VARIABLE_BATCH_ENTRY;
+
+/**
+  Execute a list of variable operations.
+
+  The operations are executed in order, so a get returns the data of a set
+  earlier in the same list. The outcome of each operation is returned in its
+  Status field, a failed operation does not stop the following ones.
+
+  @param[in]      This          The EDKII_VARIABLE_BATCH_PROTOCOL instance.
+  @param[in]      EntryCount    Number of entries in Entries.
+  @param[in, out] Entries       The operations to execute.
+
+  @retval EFI_SUCCESS           All the operations have been executed, see the
+                                Status field of each entry for its result.
+  @retval EFI_INVALID_PARAMETER Entries is NULL and EntryCount is not 0.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_VARIABLE_BATCH_EXECUTE)(
+  IN     EDKII_VARIABLE_BATCH_PROTOCOL  *This,
+  IN     UINTN                          EntryCount,
+  IN OUT EDKII_VARIABLE_BATCH_ENTRY     *Entries
+  );
+
+struct _EDKII_VARIABLE_BATCH_PROTOCOL {
+  EDKII_VARIABLE_BATCH_EXECUTE    Execute;
+};
+
+extern EFI_GUID  gEdkiiVariableBatchProtocolGuid;
+
+#endif
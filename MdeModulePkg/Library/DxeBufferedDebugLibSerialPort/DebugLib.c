@@ -0,0 +1,642 @@
+/** @file
+  DXE Debug library instance based on Serial Port library, which buffers the
+  debug messages of all the DXE modules in a ring and drains the ring to the
+  serial port in the background.
+
+  The ring is drained without waiting for the serial port after every message
+  and from a periodic timer event. It is flushed on ASSERT(), when it is full,
+  when a module that uses it is unloaded, and at ExitBootServices(). After
+  ExitBootServices() the messages are written to the serial port directly.
+
+  Copyright (c) 2006 - 2019, Intel Corporation. All rights reserved.<BR>
+  Copyright (c) 2018, Linaro, Ltd. All rights reserved.<BR>
+  Copyright (c) Microsoft Corporation.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Library/DebugLib.h>
+#include <Library/DebugPrintErrorLevelLib.h>
+#include <Library/BaseLib.h>
+#include <Library/PrintLib.h>
+#include <Library/PcdLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/SerialPortLib.h>
+#include <Library/SynchronizationLib.h>
+
+#include "DebugRing.h"
+
+STATIC EFI_BOOT_SERVICES  *mBootServices;
+STATIC EFI_EVENT          mExitBootServicesEvent;
+STATIC EFI_EVENT          mDrainTimerEvent;
+STATIC DEBUG_RING         *mDebugRing = NULL;
+
+//
+// Define the maximum debug and assert message length that this library supports
+//
+#define MAX_DEBUG_MESSAGE_LENGTH  0x100
+
+//
+// VA_LIST can not initialize to NULL for all compiler, so we use this to
+// indicate a null VA_LIST
+//
+VA_LIST  mVaListNull;
+
+/**
+  Drain the ring without waiting for the serial port.
+
+  @param[in]  Event   The Event that is being processed.
+  @param[in]  Context The Event Context.
+
+**/
+STATIC
+VOID
+EFIAPI
+DrainTimerEvent (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  if (mDebugRing != NULL) {
+    DebugRingDrain (mDebugRing, PcdGet32 (PcdBufferedDebugDrainChunkSize), FALSE);
+  }
+}
+
+/**
+  Flush the ring, report the back-pressure statistics once, and write the
+  messages of this module to the serial port directly from now on.
+
+  @param[in]  Event   The Event that is being processed.
+  @param[in]  Context The Event Context.
+
+**/
+STATIC
+VOID
+EFIAPI
+ExitBootServicesEvent (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  DEBUG_RING  *Ring;
+  CHAR8       Buffer[MAX_DEBUG_MESSAGE_LENGTH];
+
+  Ring       = mDebugRing;
+  mDebugRing = NULL;
+  if (Ring == NULL) {
+    return;
+  }
+
+  //
+  // Keep the modules that are not notified yet from starting the drain timer.
+  //
+  Ring->TimerOwned = 1;
+  DebugRingDrain (Ring, PcdGet32 (PcdBufferedDebugDrainChunkSize), TRUE);
+
+  if (InterlockedCompareExchange32 (&Ring->Reported, 0, 1) == 0) {
+    AsciiSPrint (
+      Buffer,
+      sizeof (Buffer),
+      "Buffered debug: %d messages, high water %d of %d bytes, ring full %d times, %d messages written directly\n",
+      Ring->MessageCount,
+      Ring->HighWater,
+      Ring->Size,
+      Ring->FullCount,
+      Ring->DirectCount
+      );
+    SerialPortWrite ((UINT8 *)Buffer, AsciiStrLen (Buffer));
+  }
+}
+
+/**
+  Find the ring installed by another module, or install a new one.
+
+  @param[in]  SystemTable   A pointer to the EFI System Table.
+
+  @return The ring, or NULL if buffering is disabled or failed.
+
+**/
+STATIC
+DEBUG_RING *
+GetDebugRing (
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  UINT32      Size;
+  DEBUG_RING  *Ring;
+
+  for (Index = 0; Index < SystemTable->NumberOfTableEntries; Index++) {
+    if (CompareGuid (&gEdkiiBufferedDebugRingGuid, &SystemTable->ConfigurationTable[Index].VendorGuid)) {
+      Ring = SystemTable->ConfigurationTable[Index].VendorTable;
+      return (Ring->Signature == DEBUG_RING_SIGNATURE) ? Ring : NULL;
+    }
+  }
+
+  Size = PcdGet32 (PcdBufferedDebugRingSize);
+  if (Size < sizeof (UINT32)) {
+    return NULL;
+  }
+
+  Size   = GetPowerOfTwo32 (Size);
+  Status = mBootServices->AllocatePool (EfiBootServicesData, sizeof (DEBUG_RING) + Size, (VOID **)&Ring);
+  if (EFI_ERROR (Status)) {
+    return NULL;
+  }
+
+  DebugRingInitialize (Ring, Size);
+  Status = mBootServices->InstallConfigurationTable (&gEdkiiBufferedDebugRingGuid, Ring);
+  if (EFI_ERROR (Status)) {
+    mBootServices->FreePool (Ring);
+    return NULL;
+  }
+
+  return Ring;
+}
+
+/**
+  Start the periodic drain timer, unless another module runs it.
+
+  This is called when the module attaches to the ring, and again from the
+  debug output after the module that ran the timer was unloaded.
+
+  @param[in]  Ring    The ring.
+
+**/
+STATIC
+VOID
+StartDrainTimer (
+  IN DEBUG_RING  *Ring
+  )
+{
+  EFI_STATUS  Status;
+  EFI_TPL     OldTpl;
+
+  //
+  // Timer events can only be created at TPL_NOTIFY or below.
+  //
+  OldTpl = mBootServices->RaiseTPL (TPL_HIGH_LEVEL);
+  mBootServices->RestoreTPL (OldTpl);
+  if (OldTpl > TPL_NOTIFY) {
+    return;
+  }
+
+  if (InterlockedCompareExchange32 (&Ring->TimerOwned, 0, 1) != 0) {
+    return;
+  }
+
+  Status = mBootServices->CreateEvent (
+                            EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                            TPL_CALLBACK,
+                            DrainTimerEvent,
+                            NULL,
+                            &mDrainTimerEvent
+                            );
+  if (!EFI_ERROR (Status)) {
+    Status = mBootServices->SetTimer (mDrainTimerEvent, TimerPeriodic, PcdGet32 (PcdBufferedDebugDrainPeriod));
+    if (EFI_ERROR (Status)) {
+      mBootServices->CloseEvent (mDrainTimerEvent);
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    mDrainTimerEvent = NULL;
+    Ring->TimerOwned = 0;
+  }
+}
+
+/**
+  The constructor function to initialize the Serial Port library, attach to
+  the debug message ring and register a callback for the ExitBootServices
+  event.
+
+  If the ring cannot be used, the debug messages are written to the serial
+  port directly.
+
+  @param[in]  ImageHandle   The firmware allocated handle for the EFI image.
+  @param[in]  SystemTable   A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS   The operation completed successfully.
+  @retval other         Either the serial port failed to initialize or the
+                        ExitBootServices event callback registration failed.
+**/
+EFI_STATUS
+EFIAPI
+DxeBufferedDebugLibSerialPortConstructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS  Status;
+  DEBUG_RING  *Ring;
+
+  Status = SerialPortInitialize ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  mBootServices = SystemTable->BootServices;
+  Ring          = GetDebugRing (SystemTable);
+  if (Ring == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  Status = mBootServices->CreateEvent (
+                            EVT_SIGNAL_EXIT_BOOT_SERVICES,
+                            TPL_NOTIFY,
+                            ExitBootServicesEvent,
+                            NULL,
+                            &mExitBootServicesEvent
+                            );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  mDebugRing = Ring;
+  StartDrainTimer (Ring);
+  return EFI_SUCCESS;
+}
+
+/**
+  Flush the ring and stop using it, and hand the drain timer over to the next
+  module if this module runs it.
+
+  @param[in]  ImageHandle   The firmware allocated handle for the EFI image.
+  @param[in]  SystemTable   A pointer to the EFI System Table.
+
+  @retval     EFI_SUCCESS       The library was shut down successfully.
+**/
+EFI_STATUS
+EFIAPI
+DxeBufferedDebugLibSerialPortDestructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  DEBUG_RING  *Ring;
+
+  Ring       = mDebugRing;
+  mDebugRing = NULL;
+  if (Ring == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  if (mDrainTimerEvent != NULL) {
+    mBootServices->CloseEvent (mDrainTimerEvent);
+    mDrainTimerEvent = NULL;
+    Ring->TimerOwned = 0;
+  }
+
+  DebugRingDrain (Ring, PcdGet32 (PcdBufferedDebugDrainChunkSize), TRUE);
+  return mBootServices->CloseEvent (mExitBootServicesEvent);
+}
+
+/**
+  Prints a debug message to the debug output device if the specified error level is enabled.
+
+  If any bit in ErrorLevel is also set in DebugPrintErrorLevelLib function
+  GetDebugPrintErrorLevel (), then print the message specified by Format and the
+  associated variable argument list to the debug output device.
+
+  If Format is NULL, then ASSERT().
+
+  @param  ErrorLevel  The error level of the debug message.
+  @param  Format      Format string for the debug message to print.
+  @param  ...         Variable argument list whose contents are accessed
+                      based on the format string specified by Format.
+
+**/
+VOID
+EFIAPI
+DebugPrint (
+  IN  UINTN        ErrorLevel,
+  IN  CONST CHAR8  *Format,
+  ...
+  )
+{
+  VA_LIST  Marker;
+
+  VA_START (Marker, Format);
+  DebugVPrint (ErrorLevel, Format, Marker);
+  VA_END (Marker);
+}
+
+/**
+  Prints a debug message to the debug output device if the specified
+  error level is enabled base on Null-terminated format string and a
+  VA_LIST argument list or a BASE_LIST argument list.
+
+  If any bit in ErrorLevel is also set in DebugPrintErrorLevelLib function
+  GetDebugPrintErrorLevel (), then print the message specified by Format and
+  the associated variable argument list to the debug output device.
+
+  If Format is NULL, then ASSERT().
+
+  @param  ErrorLevel      The error level of the debug message.
+  @param  Format          Format string for the debug message to print.
+  @param  VaListMarker    VA_LIST marker for the variable argument list.
+  @param  BaseListMarker  BASE_LIST marker for the variable argument list.
+
+**/
+VOID
+DebugPrintMarker (
+  IN  UINTN        ErrorLevel,
+  IN  CONST CHAR8  *Format,
+  IN  VA_LIST      VaListMarker,
+  IN  BASE_LIST    BaseListMarker
+  )
+{
+  CHAR8       Buffer[MAX_DEBUG_MESSAGE_LENGTH];
+  DEBUG_RING  *Ring;
+
+  //
+  // If Format is NULL, then ASSERT().
+  //
+  ASSERT (Format != NULL);
+
+  //
+  // Check driver debug mask value and global mask
+  //
+  if ((ErrorLevel & GetDebugPrintErrorLevel ()) == 0) {
+    return;
+  }
+
+  //
+  // Convert the DEBUG() message to an ASCII String
+  //
+  if (BaseListMarker == NULL) {
+    AsciiVSPrint (Buffer, sizeof (Buffer), Format, VaListMarker);
+  } else {
+    AsciiBSPrint (Buffer, sizeof (Buffer), Format, BaseListMarker);
+  }
+
+  //
+  // Send the print string through the ring, or to the Serial Port if the ring
+  // is not used
+  //
+  Ring = mDebugRing;
+  if (Ring != NULL) {
+    DebugRingOutput (Ring, PcdGet32 (PcdBufferedDebugDrainChunkSize), (UINT8 *)Buffer, AsciiStrLen (Buffer));
+
+    //
+    // Take the drain timer over if the module that ran it was unloaded.
+    //
+    if (Ring->TimerOwned == 0) {
+      StartDrainTimer (Ring);
+    }
+  } else {
+    SerialPortWrite ((UINT8 *)Buffer, AsciiStrLen (Buffer));
+  }
+}
+
+/**
+  Prints a debug message to the debug output device if the specified
+  error level is enabled.
+
+  If any bit in ErrorLevel is also set in DebugPrintErrorLevelLib function
+  GetDebugPrintErrorLevel (), then print the message specified by Format and
+  the associated variable argument list to the debug output device.
+
+  If Format is NULL, then ASSERT().
+
+  @param  ErrorLevel    The error level of the debug message.
+  @param  Format        Format string for the debug message to print.
+  @param  VaListMarker  VA_LIST marker for the variable argument list.
+
+**/
+VOID
+EFIAPI
+DebugVPrint (
+  IN  UINTN        ErrorLevel,
+  IN  CONST CHAR8  *Format,
+  IN  VA_LIST      VaListMarker
+  )
+{
+  DebugPrintMarker (ErrorLevel, Format, VaListMarker, NULL);
+}
+
+/**
+  Prints a debug message to the debug output device if the specified
+  error level is enabled.
+  This function use BASE_LIST which would provide a more compatible
+  service than VA_LIST.
+
+  If any bit in ErrorLevel is also set in DebugPrintErrorLevelLib function
+  GetDebugPrintErrorLevel (), then print the message specified by Format and
+  the associated variable argument list to the debug output device.
+
+  If Format is NULL, then ASSERT().
+
+  @param  ErrorLevel      The error level of the debug message.
+  @param  Format          Format string for the debug message to print.
+  @param  BaseListMarker  BASE_LIST marker for the variable argument list.
+
+**/
+VOID
+EFIAPI
+DebugBPrint (
+  IN  UINTN        ErrorLevel,
+  IN  CONST CHAR8  *Format,
+  IN  BASE_LIST    BaseListMarker
+  )
+{
+  DebugPrintMarker (ErrorLevel, Format, mVaListNull, BaseListMarker);
+}
+
+/**
+  Prints an assert message containing a filename, line number, and description.
+  This may be followed by a breakpoint or a dead loop.
+
+  Print a message of the form "ASSERT <FileName>(<LineNumber>): <Description>\n"
+  to the debug output device.  If DEBUG_PROPERTY_ASSERT_BREAKPOINT_ENABLED bit of
+  PcdDebugProperyMask is set then CpuBreakpoint() is called. Otherwise, if
+  DEBUG_PROPERTY_ASSERT_DEADLOOP_ENABLED bit of PcdDebugProperyMask is set then
+  CpuDeadLoop() is called.  If neither of these bits are set, then this function
+  returns immediately after the message is printed to the debug output device.
+  DebugAssert() must actively prevent recursion.  If DebugAssert() is called while
+  processing another DebugAssert(), then DebugAssert() must return immediately.
+
+  If FileName is NULL, then a <FileName> string of "(NULL) Filename" is printed.
+  If Description is NULL, then a <Description> string of "(NULL) Description" is printed.
+
+  @param  FileName     The pointer to the name of the source file that generated the assert condition.
+  @param  LineNumber   The line number in the source file that generated the assert condition
+  @param  Description  The pointer to the description of the assert condition.
+
+**/
+VOID
+EFIAPI
+DebugAssert (
+  IN CONST CHAR8  *FileName,
+  IN UINTN        LineNumber,
+  IN CONST CHAR8  *Description
+  )
+{
+  CHAR8       Buffer[MAX_DEBUG_MESSAGE_LENGTH];
+  DEBUG_RING  *Ring;
+
+  //
+  // Send the messages before the ASSERT() out first
+  //
+  Ring = mDebugRing;
+  if (Ring != NULL) {
+    DebugRingDrain (Ring, PcdGet32 (PcdBufferedDebugDrainChunkSize), TRUE);
+  }
+
+  //
+  // Generate the ASSERT() message in Ascii format
+  //
+  AsciiSPrint (
+    Buffer,
+    sizeof (Buffer),
+    "ASSERT [%a] %a(%d): %a\n",
+    gEfiCallerBaseName,
+    FileName,
+    LineNumber,
+    Description
+    );
+
+  //
+  // Send the print string to the Serial Port directly
+  //
+  SerialPortWrite ((UINT8 *)Buffer, AsciiStrLen (Buffer));
+
+  //
+  // Generate a Breakpoint, DeadLoop, or NOP based on PCD settings
+  //
+  if ((PcdGet8 (PcdDebugPropertyMask) & DEBUG_PROPERTY_ASSERT_BREAKPOINT_ENABLED) != 0) {
+    CpuBreakpoint ();
+  } else if ((PcdGet8 (PcdDebugPropertyMask) & DEBUG_PROPERTY_ASSERT_DEADLOOP_ENABLED) != 0) {
+    CpuDeadLoop ();
+  }
+}
+
+/**
+  Fills a target buffer with PcdDebugClearMemoryValue, and returns the target buffer.
+
+  This function fills Length bytes of Buffer with the value specified by
+  PcdDebugClearMemoryValue, and returns Buffer.
+
+  If Buffer is NULL, then ASSERT().
+  If Length is greater than (MAX_ADDRESS - Buffer + 1), then ASSERT().
+
+  @param   Buffer  The pointer to the target buffer to be filled with PcdDebugClearMemoryValue.
+  @param   Length  The number of bytes in Buffer to fill with zeros PcdDebugClearMemoryValue.
+
+  @return  Buffer  The pointer to the target buffer filled with PcdDebugClearMemoryValue.
+
+**/
+VOID *
+EFIAPI
+DebugClearMemory (
+  OUT VOID  *Buffer,
+  IN UINTN  Length
+  )
+{
+  //
+  // If Buffer is NULL, then ASSERT().
+  //
+  ASSERT (Buffer != NULL);
+
+  //
+  // SetMem() checks for the the ASSERT() condition on Length and returns Buffer
+  //
+  return SetMem (Buffer, Length, PcdGet8 (PcdDebugClearMemoryValue));
+}
+
+/**
+  Returns TRUE if ASSERT() macros are enabled.
+
+  This function returns TRUE if the DEBUG_PROPERTY_DEBUG_ASSERT_ENABLED bit of
+  PcdDebugProperyMask is set.  Otherwise FALSE is returned.
+
+  @retval  TRUE    The DEBUG_PROPERTY_DEBUG_ASSERT_ENABLED bit of PcdDebugProperyMask is set.
+  @retval  FALSE   The DEBUG_PROPERTY_DEBUG_ASSERT_ENABLED bit of PcdDebugProperyMask is clear.
+
+**/
+BOOLEAN
+EFIAPI
+DebugAssertEnabled (
+  VOID
+  )
+{
+  return (BOOLEAN)((PcdGet8 (PcdDebugPropertyMask) & DEBUG_PROPERTY_DEBUG_ASSERT_ENABLED) != 0);
+}
+
+/**
+  Returns TRUE if DEBUG() macros are enabled.
+
+  This function returns TRUE if the DEBUG_PROPERTY_DEBUG_PRINT_ENABLED bit of
+  PcdDebugProperyMask is set.  Otherwise FALSE is returned.
+
+  @retval  TRUE    The DEBUG_PROPERTY_DEBUG_PRINT_ENABLED bit of PcdDebugProperyMask is set.
+  @retval  FALSE   The DEBUG_PROPERTY_DEBUG_PRINT_ENABLED bit of PcdDebugProperyMask is clear.
+
+**/
+BOOLEAN
+EFIAPI
+DebugPrintEnabled (
+  VOID
+  )
+{
+  return (BOOLEAN)((PcdGet8 (PcdDebugPropertyMask) & DEBUG_PROPERTY_DEBUG_PRINT_ENABLED) != 0);
+}
+
+/**
+  Returns TRUE if DEBUG_CODE() macros are enabled.
+
+  This function returns TRUE if the DEBUG_PROPERTY_DEBUG_CODE_ENABLED bit of
+  PcdDebugProperyMask is set.  Otherwise FALSE is returned.
+
+  @retval  TRUE    The DEBUG_PROPERTY_DEBUG_CODE_ENABLED bit of PcdDebugProperyMask is set.
+  @retval  FALSE   The DEBUG_PROPERTY_DEBUG_CODE_ENABLED bit of PcdDebugProperyMask is clear.
+
+**/
+BOOLEAN
+EFIAPI
+DebugCodeEnabled (
+  VOID
+  )
+{
+  return (BOOLEAN)((PcdGet8 (PcdDebugPropertyMask) & DEBUG_PROPERTY_DEBUG_CODE_ENABLED) != 0);
+}
+
+/**
+  Returns TRUE if DEBUG_CLEAR_MEMORY() macro is enabled.
+
+  This function returns TRUE if the DEBUG_PROPERTY_CLEAR_MEMORY_ENABLED bit of
+  PcdDebugProperyMask is set.  Otherwise FALSE is returned.
+
+  @retval  TRUE    The DEBUG_PROPERTY_CLEAR_MEMORY_ENABLED bit of PcdDebugProperyMask is set.
+  @retval  FALSE   The DEBUG_PROPERTY_CLEAR_MEMORY_ENABLED bit of PcdDebugProperyMask is clear.
+
+**/
+BOOLEAN
+EFIAPI
+DebugClearMemoryEnabled (
+  VOID
+  )
+{
+  return (BOOLEAN)((PcdGet8 (PcdDebugPropertyMask) & DEBUG_PROPERTY_CLEAR_MEMORY_ENABLED) != 0);
+}
+
+/**
+  Returns TRUE if any one of the bit is set both in ErrorLevel and PcdFixedDebugPrintErrorLevel.
+
+  This function compares the bit mask of ErrorLevel and PcdFixedDebugPrintErrorLevel.
+
+  @retval  TRUE    Current ErrorLevel is supported.
+  @retval  FALSE   Current ErrorLevel is not supported.
+
+**/
+BOOLEAN
+EFIAPI
+DebugPrintLevelEnabled (
+  IN  CONST UINTN  ErrorLevel
+  )
+{
+  return (BOOLEAN)((ErrorLevel & PcdGet32 (PcdFixedDebugPrintErrorLevel)) != 0);
+}
@@ -0,0 +1,244 @@
+/** @file
+  Ring buffer of debug messages drained to the serial port.
+
+  Any number of producers, including producers interrupted by a higher TPL
+  producer, copy messages into the ring without taking a lock. One consumer at
+  a time sends them to the serial port.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DebugRing.h"
+
+#include <Protocol/SerialIo.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/SerialPortLib.h>
+#include <Library/SynchronizationLib.h>
+
+#define DEBUG_RING_RECORD_SIZE(Length)  ALIGN_VALUE (sizeof (UINT32) + (Length), sizeof (UINT32))
+
+/**
+  Initialize an empty ring.
+
+  @param[out] Ring    The ring, followed by Size bytes of data.
+  @param[in]  Size    The size of the data, a power of two.
+
+**/
+VOID
+DebugRingInitialize (
+  OUT DEBUG_RING  *Ring,
+  IN  UINT32      Size
+  )
+{
+  ZeroMem (Ring, sizeof (DEBUG_RING) + Size);
+  Ring->Signature = DEBUG_RING_SIGNATURE;
+  Ring->Size      = Size;
+}
+
+/**
+  Copy a message into the ring.
+
+  @param[in, out] Ring     The ring.
+  @param[in]      Buffer   The message.
+  @param[in]      Length   The length of the message in bytes.
+
+  @retval TRUE    The message was copied into the ring.
+  @retval FALSE   The ring does not have room for the message.
+
+**/
+BOOLEAN
+DebugRingWrite (
+  IN OUT DEBUG_RING  *Ring,
+  IN     CONST UINT8  *Buffer,
+  IN     UINTN        Length
+  )
+{
+  UINT8   *Data;
+  UINT32  Mask;
+  UINT32  RecordSize;
+  UINT32  Head;
+  UINT32  Used;
+  UINT32  HighWater;
+  UINT32  Offset;
+  UINT32  Part;
+
+  if (Length > Ring->Size / 2) {
+    return FALSE;
+  }
+
+  Data       = DEBUG_RING_DATA (Ring);
+  Mask       = Ring->Size - 1;
+  RecordSize = (UINT32)DEBUG_RING_RECORD_SIZE (Length);
+
+  //
+  // Reserve the record. Tail only moves forward, so a stale Tail can only
+  // make the ring look fuller than it is.
+  //
+  do {
+    Head = Ring->Head;
+    Used = Head - Ring->Tail;
+    if (Used + RecordSize > Ring->Size) {
+      return FALSE;
+    }
+  } while (InterlockedCompareExchange32 (&Ring->Head, Head, Head + RecordSize) != Head);
+
+  //
+  // Records start on a UINT32 boundary, so only the message can wrap.
+  //
+  Offset = (Head + sizeof (UINT32)) & Mask;
+  Part   = MIN ((UINT32)Length, Ring->Size - Offset);
+  CopyMem (&Data[Offset], Buffer, Part);
+  CopyMem (Data, Buffer + Part, Length - Part);
+
+  MemoryFence ();
+  *(volatile UINT32 *)&Data[Head & Mask] = (UINT32)Length | DEBUG_RING_RECORD_COMMITTED;
+
+  InterlockedIncrement (&Ring->MessageCount);
+  Used += RecordSize;
+  do {
+    HighWater = Ring->HighWater;
+  } while ((Used > HighWater) && (InterlockedCompareExchange32 (&Ring->HighWater, HighWater, Used) != HighWater));
+
+  return TRUE;
+}
+
+/**
+  Send the committed messages of the ring to the serial port.
+
+  Unless Flush is TRUE, a chunk is only written when the serial port reports
+  an empty transmit buffer, so the drain never waits for the serial port.
+
+  @param[in, out] Ring        The ring.
+  @param[in]      ChunkSize   The number of bytes written to an empty transmit
+                              buffer at once.
+  @param[in]      Flush       TRUE to wait for the serial port until every
+                              committed message is sent.
+
+  @return The number of bytes sent.
+
+**/
+UINTN
+DebugRingDrain (
+  IN OUT DEBUG_RING  *Ring,
+  IN     UINTN       ChunkSize,
+  IN     BOOLEAN     Flush
+  )
+{
+  UINT8       *Data;
+  UINT32      Mask;
+  UINT32      Tail;
+  UINT32      Header;
+  UINT32      Length;
+  UINT32      RecordSize;
+  UINT32      Offset;
+  UINTN       Chunk;
+  UINTN       Total;
+  UINT32      Control;
+  EFI_STATUS  Status;
+
+  //
+  // A drain interrupted by a higher TPL one keeps the ring, the interrupting
+  // drain returns at once.
+  //
+  if (InterlockedCompareExchange32 (&Ring->Draining, 0, 1) != 0) {
+    return 0;
+  }
+
+  Data  = DEBUG_RING_DATA (Ring);
+  Mask  = Ring->Size - 1;
+  Total = 0;
+  while (TRUE) {
+    Tail = Ring->Tail;
+    if (Tail == Ring->Head) {
+      break;
+    }
+
+    //
+    // Stop at a record whose producer has not finished copying it.
+    //
+    Header = *(volatile UINT32 *)&Data[Tail & Mask];
+    if ((Header & DEBUG_RING_RECORD_COMMITTED) == 0) {
+      break;
+    }
+
+    Length = Header & DEBUG_RING_RECORD_LENGTH;
+    while (Ring->Sent < Length) {
+      if (!Flush) {
+        Status = SerialPortGetControl (&Control);
+        if (!EFI_ERROR (Status) && ((Control & EFI_SERIAL_OUTPUT_BUFFER_EMPTY) == 0)) {
+          goto Done;
+        }
+      }
+
+      Offset = (Tail + sizeof (UINT32) + Ring->Sent) & Mask;
+      Chunk  = MIN (Length - Ring->Sent, Ring->Size - Offset);
+      if (!Flush) {
+        Chunk = MIN (Chunk, ChunkSize);
+      }
+
+      SerialPortWrite (&Data[Offset], Chunk);
+      Ring->Sent += (UINT32)Chunk;
+      Total      += Chunk;
+    }
+
+    //
+    // Clear the whole record before it is handed back to the producers. A
+    // later record can start anywhere in it, and its header must not look
+    // committed before its producer sets it.
+    //
+    RecordSize = (UINT32)DEBUG_RING_RECORD_SIZE (Length);
+    Offset     = Tail & Mask;
+    Chunk      = MIN (RecordSize, Ring->Size - Offset);
+    ZeroMem (&Data[Offset], Chunk);
+    ZeroMem (Data, RecordSize - Chunk);
+    Ring->Sent = 0;
+    MemoryFence ();
+    Ring->Tail = Tail + RecordSize;
+  }
+
+Done:
+  MemoryFence ();
+  Ring->Draining = 0;
+  return Total;
+}
+
+/**
+  Output a message through the ring.
+
+  The message is copied into the ring, then the ring is drained without
+  waiting. If the ring is full, it is flushed to make room. If that does not
+  make room, because a message being copied by an interrupted producer or an
+  interrupted drain holds the ring, the message is written to the serial port
+  directly.
+
+  @param[in, out] Ring        The ring.
+  @param[in]      ChunkSize   The number of bytes written to an empty transmit
+                              buffer at once.
+  @param[in]      Buffer      The message.
+  @param[in]      Length      The length of the message in bytes.
+
+**/
+VOID
+DebugRingOutput (
+  IN OUT DEBUG_RING  *Ring,
+  IN     UINTN        ChunkSize,
+  IN     CONST UINT8  *Buffer,
+  IN     UINTN        Length
+  )
+{
+  if (!DebugRingWrite (Ring, Buffer, Length)) {
+    InterlockedIncrement (&Ring->FullCount);
+    DebugRingDrain (Ring, ChunkSize, TRUE);
+    if (!DebugRingWrite (Ring, Buffer, Length)) {
+      InterlockedIncrement (&Ring->DirectCount);
+      SerialPortWrite ((UINT8 *)Buffer, Length);
+      return;
+    }
+  }
+
+  DebugRingDrain (Ring, ChunkSize, FALSE);
+}
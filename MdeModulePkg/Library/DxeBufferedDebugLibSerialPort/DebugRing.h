@@ -0,0 +1,92 @@
+/** @file
+  Ring buffer of debug messages drained to the serial port.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _DEBUG_RING_H_
+#define _DEBUG_RING_H_
+
+#include <Uefi.h>
+#include <Guid/BufferedDebugRing.h>
+
+/**
+  Initialize an empty ring.
+
+  @param[out] Ring    The ring, followed by Size bytes of data.
+  @param[in]  Size    The size of the data, a power of two.
+
+**/
+VOID
+DebugRingInitialize (
+  OUT DEBUG_RING  *Ring,
+  IN  UINT32      Size
+  );
+
+/**
+  Copy a message into the ring.
+
+  @param[in, out] Ring     The ring.
+  @param[in]      Buffer   The message.
+  @param[in]      Length   The length of the message in bytes.
+
+  @retval TRUE    The message was copied into the ring.
+  @retval FALSE   The ring does not have room for the message.
+
+**/
+BOOLEAN
+DebugRingWrite (
+  IN OUT DEBUG_RING  *Ring,
+  IN     CONST UINT8  *Buffer,
+  IN     UINTN        Length
+  );
+
+/**
+  Send the committed messages of the ring to the serial port.
+
+  Unless Flush is TRUE, a chunk is only written when the serial port reports
+  an empty transmit buffer, so the drain never waits for the serial port.
+
+  @param[in, out] Ring        The ring.
+  @param[in]      ChunkSize   The number of bytes written to an empty transmit
+                              buffer at once.
+  @param[in]      Flush       TRUE to wait for the serial port until every
+                              committed message is sent.
+
+  @return The number of bytes sent.
+
+**/
+UINTN
+DebugRingDrain (
+  IN OUT DEBUG_RING  *Ring,
+  IN     UINTN       ChunkSize,
+  IN     BOOLEAN     Flush
+  );
+
+/**
+  Output a message through the ring.
+
+  The message is copied into the ring, then the ring is drained without
+  waiting. If the ring is full, it is flushed to make room. If that does not
+  make room, because a message being copied by an interrupted producer or an
+  interrupted drain holds the ring, the message is written to the serial port
+  directly.
+
+  @param[in, out] Ring        The ring.
+  @param[in]      ChunkSize   The number of bytes written to an empty transmit
+                              buffer at once.
+  @param[in]      Buffer      The message.
+  @param[in]      Length      The length of the message in bytes.
+
+**/
+VOID
+DebugRingOutput (
+  IN OUT DEBUG_RING  *Ring,
+  IN     UINTN        ChunkSize,
+  IN     CONST UINT8  *Buffer,
+  IN     UINTN        Length
+  );
+
+#endif
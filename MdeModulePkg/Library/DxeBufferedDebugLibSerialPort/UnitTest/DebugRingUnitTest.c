@@ -0,0 +1,485 @@
+/** @file -- DebugRingUnitTest.c
+  Host based unit tests for the debug message ring of DxeBufferedDebugLibSerialPort.
+
+  The ring is drained to a mock UART, which records the bytes written and can
+  report a busy transmit buffer for a number of polls after every write.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/SerialPortLib.h>
+#include <Library/UnitTestLib.h>
+#include <Protocol/SerialIo.h>
+
+#include "../DebugRing.h"
+
+#define UNIT_TEST_APP_NAME     "Buffered Debug Ring Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define TEST_RING_SIZE   256
+#define TEST_CHUNK_SIZE  16
+#define MOCK_UART_SIZE   0x10000
+
+typedef struct {
+  UINT8    Output[MOCK_UART_SIZE];
+  UINTN    Length;
+  UINTN    WriteCalls;
+  //
+  // Polls for which the transmit buffer stays busy after a write, and the
+  // polls left before it is empty again.
+  //
+  UINTN    BusyPolls;
+  UINTN    BusyLeft;
+} MOCK_UART;
+
+STATIC MOCK_UART   mMockUart;
+STATIC DEBUG_RING  *mRing;
+
+//
+// The bytes the test expects on the UART, in order.
+//
+STATIC UINT8  mExpected[MOCK_UART_SIZE];
+STATIC UINTN  mExpectedLength;
+
+/**
+  Initialize the mock UART.
+
+  @retval RETURN_SUCCESS  The mock UART is ready.
+**/
+RETURN_STATUS
+EFIAPI
+SerialPortInitialize (
+  VOID
+  )
+{
+  return RETURN_SUCCESS;
+}
+
+/**
+  Record bytes written to the mock UART, which then reports a busy transmit
+  buffer for BusyPolls polls.
+
+  @param[in]  Buffer         The bytes to write.
+  @param[in]  NumberOfBytes  The number of bytes to write.
+
+  @return The number of bytes written.
+**/
+UINTN
+EFIAPI
+SerialPortWrite (
+  IN UINT8  *Buffer,
+  IN UINTN  NumberOfBytes
+  )
+{
+  NumberOfBytes = MIN (NumberOfBytes, sizeof (mMockUart.Output) - mMockUart.Length);
+  CopyMem (&mMockUart.Output[mMockUart.Length], Buffer, NumberOfBytes);
+  mMockUart.WriteCalls++;
+  mMockUart.Length  += NumberOfBytes;
+  mMockUart.BusyLeft = mMockUart.BusyPolls;
+  return NumberOfBytes;
+}
+
+/**
+  Report the state of the transmit buffer of the mock UART.
+
+  @param[out] Control  The control bits of the mock UART.
+
+  @retval RETURN_SUCCESS  The control bits were returned.
+**/
+RETURN_STATUS
+EFIAPI
+SerialPortGetControl (
+  OUT UINT32  *Control
+  )
+{
+  *Control = EFI_SERIAL_INPUT_BUFFER_EMPTY;
+  if (mMockUart.BusyLeft > 0) {
+    mMockUart.BusyLeft--;
+  } else {
+    *Control |= EFI_SERIAL_OUTPUT_BUFFER_EMPTY;
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Build a test message and add it to the expected UART output.
+
+  @param[in]  Number   The number of the message.
+  @param[out] Message  The message.
+  @param[in]  Length   The length of the message.
+**/
+STATIC
+VOID
+MakeMessage (
+  IN  UINTN  Number,
+  OUT UINT8  *Message,
+  IN  UINTN  Length
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Length; Index++) {
+    Message[Index] = (UINT8)('A' + (Number + Index) % 26);
+  }
+
+  Message[Length - 1] = '\n';
+  CopyMem (&mExpected[mExpectedLength], Message, Length);
+  mExpectedLength += Length;
+}
+
+/**
+  Allocate an empty ring and reset the mock UART.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The ring is ready.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+DebugRingSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ZeroMem (&mMockUart, sizeof (mMockUart));
+  mExpectedLength = 0;
+
+  mRing = AllocatePool (sizeof (DEBUG_RING) + TEST_RING_SIZE);
+  UT_ASSERT_NOT_NULL (mRing);
+  DebugRingInitialize (mRing, TEST_RING_SIZE);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Free the ring.
+
+  @param[in]  Context  Unused.
+**/
+STATIC
+VOID
+EFIAPI
+DebugRingCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FreePool (mRing);
+  mRing = NULL;
+}
+
+/**
+  Messages come out of the UART in order, including messages wrapping around
+  the end of the ring.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+InOrderTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8  Message[64];
+  UINTN  Number;
+  UINTN  Length;
+
+  for (Number = 0; Number < 200; Number++) {
+    Length = 1 + (Number * 7) % sizeof (Message);
+    MakeMessage (Number, Message, Length);
+    UT_ASSERT_TRUE (DebugRingWrite (mRing, Message, Length));
+    if (Number % 3 == 2) {
+      DebugRingDrain (mRing, TEST_CHUNK_SIZE, TRUE);
+    }
+  }
+
+  DebugRingDrain (mRing, TEST_CHUNK_SIZE, TRUE);
+
+  UT_ASSERT_EQUAL (mMockUart.Length, mExpectedLength);
+  UT_ASSERT_MEM_EQUAL (mMockUart.Output, mExpected, mExpectedLength);
+  UT_ASSERT_EQUAL (mRing->Tail, mRing->Head);
+  UT_ASSERT_EQUAL (mRing->MessageCount, 200);
+  UT_ASSERT_EQUAL (mRing->FullCount, 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A drain writes one chunk each time the UART reports an empty transmit
+  buffer, and returns instead of waiting while it is busy.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+NoWaitTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8  Message[100];
+  UINTN  Drains;
+
+  mMockUart.BusyPolls = 3;
+  MakeMessage (0, Message, sizeof (Message));
+  UT_ASSERT_TRUE (DebugRingWrite (mRing, Message, sizeof (Message)));
+
+  UT_ASSERT_EQUAL (DebugRingDrain (mRing, TEST_CHUNK_SIZE, FALSE), TEST_CHUNK_SIZE);
+  UT_ASSERT_EQUAL (mMockUart.WriteCalls, 1);
+
+  //
+  // The first drain polled the busy UART once, it stays busy for two more polls.
+  //
+  UT_ASSERT_EQUAL (DebugRingDrain (mRing, TEST_CHUNK_SIZE, FALSE), 0);
+  UT_ASSERT_EQUAL (DebugRingDrain (mRing, TEST_CHUNK_SIZE, FALSE), 0);
+
+  Drains = 0;
+  while (mRing->Tail != mRing->Head) {
+    DebugRingDrain (mRing, TEST_CHUNK_SIZE, FALSE);
+    Drains++;
+    UT_ASSERT_TRUE (Drains < 100);
+  }
+
+  UT_ASSERT_EQUAL (mMockUart.WriteCalls, (sizeof (Message) + TEST_CHUNK_SIZE - 1) / TEST_CHUNK_SIZE);
+  UT_ASSERT_EQUAL (mMockUart.Length, mExpectedLength);
+  UT_ASSERT_MEM_EQUAL (mMockUart.Output, mExpected, mExpectedLength);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A full ring is flushed to make room, and the statistics record it.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+BackPressureTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8  Message[40];
+  UINTN  Number;
+
+  //
+  // The UART stays busy, so only flushes send anything.
+  //
+  mMockUart.BusyPolls = MAX_UINTN;
+  mMockUart.BusyLeft  = MAX_UINTN;
+
+  for (Number = 0; Number < 20; Number++) {
+    MakeMessage (Number, Message, sizeof (Message));
+    DebugRingOutput (mRing, TEST_CHUNK_SIZE, Message, sizeof (Message));
+  }
+
+  UT_ASSERT_TRUE (mRing->FullCount > 0);
+  UT_ASSERT_EQUAL (mRing->DirectCount, 0);
+  UT_ASSERT_EQUAL (mRing->MessageCount, 20);
+  UT_ASSERT_TRUE (mRing->HighWater <= TEST_RING_SIZE);
+  UT_ASSERT_TRUE (mRing->HighWater > TEST_RING_SIZE - 44);
+
+  DebugRingDrain (mRing, TEST_CHUNK_SIZE, TRUE);
+  UT_ASSERT_EQUAL (mMockUart.Length, mExpectedLength);
+  UT_ASSERT_MEM_EQUAL (mMockUart.Output, mExpected, mExpectedLength);
+
+  //
+  // A message larger than half the ring is never buffered.
+  //
+  UT_ASSERT_FALSE (DebugRingWrite (mRing, mExpected, TEST_RING_SIZE));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A record reserved by an interrupted producer holds back the records after
+  it, and a message that finds the ring full behind it is written directly.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+InterruptedProducerTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8   Message[40];
+  UINT32  Reserved;
+  UINTN   Number;
+  UINTN   Before;
+
+  //
+  // Reserve an 8 byte record without committing it.
+  //
+  Reserved     = mRing->Head;
+  mRing->Head += 8;
+
+  for (Number = 0; mRing->DirectCount == 0; Number++) {
+    UT_ASSERT_TRUE (Number < 10);
+    Before = mExpectedLength;
+    MakeMessage (Number, Message, sizeof (Message));
+    DebugRingOutput (mRing, TEST_CHUNK_SIZE, Message, sizeof (Message));
+  }
+
+  //
+  // Only the direct message reached the UART.
+  //
+  UT_ASSERT_EQUAL (mMockUart.Length, sizeof (Message));
+  UT_ASSERT_MEM_EQUAL (mMockUart.Output, &mExpected[Before], sizeof (Message));
+
+  //
+  // A drain interrupted by another one keeps the ring.
+  //
+  mRing->Draining = 1;
+  UT_ASSERT_EQUAL (DebugRingDrain (mRing, TEST_CHUNK_SIZE, TRUE), 0);
+  mRing->Draining = 0;
+
+  //
+  // The producer commits its record, then everything comes out.
+  //
+  CopyMem (DEBUG_RING_DATA (mRing) + ((Reserved + sizeof (UINT32)) & (TEST_RING_SIZE - 1)), "ok!\n", 4);
+  *(UINT32 *)(DEBUG_RING_DATA (mRing) + (Reserved & (TEST_RING_SIZE - 1))) = 4 | DEBUG_RING_RECORD_COMMITTED;
+  DebugRingDrain (mRing, TEST_CHUNK_SIZE, TRUE);
+
+  UT_ASSERT_EQUAL (mMockUart.Length, mExpectedLength + 4);
+  UT_ASSERT_MEM_EQUAL (&mMockUart.Output[sizeof (Message)], "ok!\n", 4);
+  UT_ASSERT_MEM_EQUAL (&mMockUart.Output[sizeof (Message) + 4], mExpected, Before);
+  UT_ASSERT_EQUAL (mRing->Tail, mRing->Head);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Records of mixed sizes are cleared when they are sent, so that a record
+  reserved over the stale bytes of older messages holds the ring until its
+  producer commits it.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+StaleDataTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8   Message[64];
+  UINT32  Reserved;
+  UINTN   Number;
+  UINTN   Length;
+
+  for (Number = 0; Number < 100; Number++) {
+    //
+    // Messages of all bytes set look like committed headers if left behind.
+    //
+    Length = 1 + (Number * 13) % sizeof (Message);
+    SetMem (Message, Length, 0xFF);
+    CopyMem (&mExpected[mExpectedLength], Message, Length);
+    mExpectedLength += Length;
+    UT_ASSERT_TRUE (DebugRingWrite (mRing, Message, Length));
+    DebugRingDrain (mRing, TEST_CHUNK_SIZE, TRUE);
+    UT_ASSERT_TRUE (IsZeroBuffer (DEBUG_RING_DATA (mRing), TEST_RING_SIZE));
+
+    //
+    // Reserve an 8 byte record over the sent message without committing it.
+    //
+    Reserved     = mRing->Head;
+    mRing->Head += 8;
+    UT_ASSERT_EQUAL (DebugRingDrain (mRing, TEST_CHUNK_SIZE, TRUE), 0);
+    UT_ASSERT_EQUAL (mRing->Tail, Reserved);
+
+    CopyMem (DEBUG_RING_DATA (mRing) + ((Reserved + sizeof (UINT32)) & (TEST_RING_SIZE - 1)), "ok!\n", 4);
+    *(UINT32 *)(DEBUG_RING_DATA (mRing) + (Reserved & (TEST_RING_SIZE - 1))) = 4 | DEBUG_RING_RECORD_COMMITTED;
+    CopyMem (&mExpected[mExpectedLength], "ok!\n", 4);
+    mExpectedLength += 4;
+    DebugRingDrain (mRing, TEST_CHUNK_SIZE, TRUE);
+  }
+
+  UT_ASSERT_EQUAL (mMockUart.Length, mExpectedLength);
+  UT_ASSERT_MEM_EQUAL (mMockUart.Output, mExpected, mExpectedLength);
+  UT_ASSERT_EQUAL (mRing->Tail, mRing->Head);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  debug ring and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      RingTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&RingTests, Framework, "Buffered Debug Ring Tests", "BufferedDebug.Ring", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for RingTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (RingTests, "Messages come out in order", "InOrder", InOrderTest, DebugRingSetup, DebugRingCleanup, NULL);
+  AddTestCase (RingTests, "Drains do not wait for a busy UART", "NoWait", NoWaitTest, DebugRingSetup, DebugRingCleanup, NULL);
+  AddTestCase (RingTests, "A full ring is flushed", "BackPressure", BackPressureTest, DebugRingSetup, DebugRingCleanup, NULL);
+  AddTestCase (RingTests, "An interrupted producer holds the ring", "InterruptedProducer", InterruptedProducerTest, DebugRingSetup, DebugRingCleanup, NULL);
+  AddTestCase (RingTests, "Sent records are cleared", "StaleData", StaleDataTest, DebugRingSetup, DebugRingCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
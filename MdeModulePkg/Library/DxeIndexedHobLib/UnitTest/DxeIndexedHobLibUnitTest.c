@@ -0,0 +1,494 @@
+/** @file -- DxeIndexedHobLibUnitTest.c
+  Host based unit tests for the GUID HOB lookups of DxeIndexedHobLib.
+
+  The tests build a HOB list with GUID HOBs of a number of GUIDs between other
+  HOBs, index it the way the DXE core does, and check the lookups through the
+  index against a walk of the HOB list.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+#include <PiDxe.h>
+#include <Guid/HobList.h>
+#include <Guid/GuidHobIndex.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HobLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "DXE Indexed HOB Library Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define TEST_HOB_COUNT   600
+#define TEST_GUID_COUNT  24
+#define TEST_LIST_SIZE   (TEST_HOB_COUNT * 48 + sizeof (EFI_HOB_GENERIC_HEADER))
+
+//
+// The library's cached HOB list and GUID HOB index.
+//
+extern VOID            *mHobList;
+extern GUID_HOB_INDEX  *mGuidHobIndex;
+
+STATIC UINT64          mTestHobList[TEST_LIST_SIZE / sizeof (UINT64)];
+STATIC GUID_HOB_INDEX  *mTestIndex;
+STATIC EFI_GUID        mTestGuids[TEST_GUID_COUNT];
+STATIC UINT32          mRandom;
+
+STATIC CONST EFI_GUID  mAbsentGuid = {
+  0x0e7bd32f, 0x5c41, 0x4a7e, { 0x8b, 0x13, 0x6f, 0xd4, 0x2a, 0x91, 0xc0, 0x57 }
+};
+
+/**
+  Return the next number of a fixed pseudo random sequence.
+
+  @return The next number.
+**/
+STATIC
+UINT32
+NextRandom (
+  VOID
+  )
+{
+  mRandom = mRandom * 1103515245 + 12345;
+  return mRandom >> 8;
+}
+
+/**
+  Return the configuration tables the library looks up.
+
+  @param[in]  TableGuid  The GUID of the table.
+  @param[out] Table      Returns the table.
+
+  @retval EFI_SUCCESS    The table was returned.
+  @retval EFI_NOT_FOUND  The table is not installed.
+**/
+EFI_STATUS
+EFIAPI
+EfiGetSystemConfigurationTable (
+  IN  EFI_GUID  *TableGuid,
+  OUT VOID      **Table
+  )
+{
+  *Table = NULL;
+  if (CompareGuid (TableGuid, &gEfiHobListGuid)) {
+    *Table = mTestHobList;
+  } else if (CompareGuid (TableGuid, &gEdkiiGuidHobIndexGuid)) {
+    *Table = mTestIndex;
+  }
+
+  return (*Table != NULL) ? EFI_SUCCESS : EFI_NOT_FOUND;
+}
+
+/**
+  Find a GUID HOB by walking the HOB list, as the reference for the lookups.
+
+  @param[in]  Guid      The GUID to look for.
+  @param[in]  HobStart  The HOB to start at.
+
+  @return The first GUID HOB with the GUID at or after HobStart, or NULL.
+**/
+STATIC
+VOID *
+WalkGuidHob (
+  IN CONST EFI_GUID  *Guid,
+  IN CONST VOID      *HobStart
+  )
+{
+  EFI_PEI_HOB_POINTERS  Hob;
+
+  for (Hob.Raw = (UINT8 *)HobStart; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    if ((GET_HOB_TYPE (Hob) == EFI_HOB_TYPE_GUID_EXTENSION) && CompareGuid (Guid, &Hob.Guid->Name)) {
+      return Hob.Raw;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Build the GUID HOB index of the test HOB list, the way the DXE core does.
+
+  @return The index, or NULL if it could not be allocated.
+**/
+STATIC
+GUID_HOB_INDEX *
+BuildTestIndex (
+  VOID
+  )
+{
+  EFI_PEI_HOB_POINTERS  Hob;
+  GUID_HOB_INDEX        *Index;
+  GUID_HOB_INDEX_ENTRY  *Entries;
+  UINT32                EntryCount;
+  UINT32                BucketCount;
+  UINT32                Entry;
+  UINT32                *Link;
+
+  EntryCount = 0;
+  for (Hob.Raw = (UINT8 *)mTestHobList; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    if (GET_HOB_TYPE (Hob) == EFI_HOB_TYPE_GUID_EXTENSION) {
+      EntryCount++;
+    }
+  }
+
+  BucketCount = GetPowerOfTwo32 (EntryCount) << 1;
+  Index       = AllocateZeroPool (GUID_HOB_INDEX_SIZE (EntryCount, BucketCount));
+  if (Index == NULL) {
+    return NULL;
+  }
+
+  Index->Signature   = GUID_HOB_INDEX_SIGNATURE;
+  Index->BucketCount = BucketCount;
+  Index->EntryCount  = EntryCount;
+  Index->HobList     = (EFI_PHYSICAL_ADDRESS)(UINTN)mTestHobList;
+
+  Entries = GUID_HOB_INDEX_ENTRIES (Index);
+  Entry   = 0;
+  for (Hob.Raw = (UINT8 *)mTestHobList; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    if (GET_HOB_TYPE (Hob) == EFI_HOB_TYPE_GUID_EXTENSION) {
+      Entries[Entry++].Hob = (EFI_PHYSICAL_ADDRESS)(UINTN)Hob.Raw;
+    }
+  }
+
+  Index->HobListEnd = (EFI_PHYSICAL_ADDRESS)(UINTN)Hob.Raw;
+
+  //
+  // Link from the last HOB to the first, so that each HOB becomes the head of
+  // its GUID chain.
+  //
+  for (Entry = EntryCount; Entry > 0; Entry--) {
+    Hob.Raw = (UINT8 *)(UINTN)Entries[Entry - 1].Hob;
+    Link    = &GUID_HOB_INDEX_BUCKETS (Index)[GUID_HOB_INDEX_BUCKET (Index, &Hob.Guid->Name)];
+    while ((*Link != GUID_HOB_INDEX_END) &&
+           !CompareGuid (&Hob.Guid->Name, &((EFI_HOB_GUID_TYPE *)(UINTN)Entries[*Link - 1].Hob)->Name))
+    {
+      Link = &Entries[*Link - 1].NextInBucket;
+    }
+
+    if (*Link != GUID_HOB_INDEX_END) {
+      Entries[Entry - 1].NextSameGuid = *Link;
+      Entries[Entry - 1].NextInBucket = Entries[*Link - 1].NextInBucket;
+      Entries[*Link - 1].NextInBucket = GUID_HOB_INDEX_END;
+    }
+
+    *Link = Entry;
+  }
+
+  return Index;
+}
+
+/**
+  Check GetNextGuidHob() and GetFirstGuidHob() against a walk of the HOB list,
+  from every HOB of the list and for every test GUID and an absent GUID. The
+  GUID is also passed unaligned.
+
+  @retval UNIT_TEST_PASSED  The lookups match the walk.
+**/
+STATIC
+UNIT_TEST_STATUS
+CheckAgainstWalk (
+  VOID
+  )
+{
+  EFI_PEI_HOB_POINTERS  Hob;
+  UINT8                 Unaligned[sizeof (EFI_GUID) + 1];
+  CONST EFI_GUID        *Guid;
+  UINTN                 GuidIndex;
+
+  for (GuidIndex = 0; GuidIndex <= TEST_GUID_COUNT; GuidIndex++) {
+    Guid = (GuidIndex < TEST_GUID_COUNT) ? &mTestGuids[GuidIndex] : &mAbsentGuid;
+    CopyMem (&Unaligned[1], Guid, sizeof (EFI_GUID));
+
+    UT_ASSERT_EQUAL ((UINTN)GetFirstGuidHob (Guid), (UINTN)WalkGuidHob (Guid, mTestHobList));
+
+    Hob.Raw = (UINT8 *)mTestHobList;
+    while (TRUE) {
+      UT_ASSERT_EQUAL ((UINTN)GetNextGuidHob (Guid, Hob.Raw), (UINTN)WalkGuidHob (Guid, Hob.Raw));
+      UT_ASSERT_EQUAL ((UINTN)GetNextGuidHob ((EFI_GUID *)&Unaligned[1], Hob.Raw), (UINTN)WalkGuidHob (Guid, Hob.Raw));
+      if (END_OF_HOB_LIST (Hob)) {
+        break;
+      }
+
+      Hob.Raw = GET_NEXT_HOB (Hob);
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Build a HOB list of GUID HOBs between memory allocation HOBs, index it and
+  let the library pick up both.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The HOB list and the index are ready.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+IndexedHobListSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_PEI_HOB_POINTERS  Hob;
+  UINTN                 Number;
+
+  ZeroMem (mTestHobList, sizeof (mTestHobList));
+  mRandom = 1;
+  for (Number = 0; Number < TEST_GUID_COUNT; Number++) {
+    mTestGuids[Number].Data1 = NextRandom ();
+    mTestGuids[Number].Data2 = (UINT16)NextRandom ();
+    mTestGuids[Number].Data3 = (UINT16)NextRandom ();
+    WriteUnaligned64 ((UINT64 *)mTestGuids[Number].Data4, LShiftU64 (NextRandom (), 32) | NextRandom ());
+  }
+
+  //
+  // Every HOB has room for a GUID HOB header, so that any of them can be
+  // turned into a GUID HOB.
+  //
+  Hob.Raw = (UINT8 *)mTestHobList;
+  for (Number = 0; Number < TEST_HOB_COUNT; Number++) {
+    Hob.Header->HobLength = (UINT16)(sizeof (EFI_HOB_GUID_TYPE) + 8 * (NextRandom () % 4));
+    if (NextRandom () % 3 != 0) {
+      Hob.Header->HobType = EFI_HOB_TYPE_GUID_EXTENSION;
+      CopyGuid (&Hob.Guid->Name, &mTestGuids[NextRandom () % TEST_GUID_COUNT]);
+    } else {
+      Hob.Header->HobType = EFI_HOB_TYPE_MEMORY_ALLOCATION;
+    }
+
+    Hob.Raw = GET_NEXT_HOB (Hob);
+  }
+
+  Hob.Header->HobType   = EFI_HOB_TYPE_END_OF_HOB_LIST;
+  Hob.Header->HobLength = sizeof (EFI_HOB_GENERIC_HEADER);
+
+  mTestIndex = BuildTestIndex ();
+  UT_ASSERT_NOT_NULL (mTestIndex);
+
+  mHobList      = NULL;
+  mGuidHobIndex = NULL;
+  UT_ASSERT_EQUAL ((UINTN)GetHobList (), (UINTN)mTestHobList);
+  UT_ASSERT_EQUAL ((UINTN)mGuidHobIndex, (UINTN)mTestIndex);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Free the index and drop the library's cached pointers.
+
+  @param[in]  Context  Unused.
+**/
+STATIC
+VOID
+EFIAPI
+IndexedHobListCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  if (mTestIndex != NULL) {
+    FreePool (mTestIndex);
+    mTestIndex = NULL;
+  }
+
+  mHobList      = NULL;
+  mGuidHobIndex = NULL;
+}
+
+/**
+  Lookups through the index find the same HOBs as a walk of the HOB list, and
+  do not walk the HOB list.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+IndexLookupTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_PEI_HOB_POINTERS  Hob;
+  UNIT_TEST_STATUS      Status;
+
+  Status = CheckAgainstWalk ();
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  //
+  // A HOB that turned into a GUID HOB after the index was built is not in the
+  // index, so only a walk finds it.
+  //
+  Hob.Raw = GetFirstHob (EFI_HOB_TYPE_MEMORY_ALLOCATION);
+  UT_ASSERT_NOT_NULL (Hob.Raw);
+  Hob.Header->HobType = EFI_HOB_TYPE_GUID_EXTENSION;
+  CopyGuid (&Hob.Guid->Name, &mAbsentGuid);
+
+  UT_ASSERT_EQUAL ((UINTN)GetFirstGuidHob (&mAbsentGuid), 0);
+  mGuidHobIndex = NULL;
+  UT_ASSERT_EQUAL ((UINTN)GetFirstGuidHob (&mAbsentGuid), (UINTN)Hob.Raw);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  GUID HOBs marked unused after the index was built are skipped.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+UnusedHobTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_PEI_HOB_POINTERS  Hob;
+  EFI_PEI_HOB_POINTERS  Second;
+  UINTN                 Number;
+
+  //
+  // Mark the first HOB of a GUID unused, then the second one is the first.
+  //
+  Hob.Raw = GetFirstGuidHob (&mTestGuids[0]);
+  UT_ASSERT_NOT_NULL (Hob.Raw);
+  Second.Raw = GetNextGuidHob (&mTestGuids[0], GET_NEXT_HOB (Hob));
+  UT_ASSERT_NOT_NULL (Second.Raw);
+  Hob.Header->HobType = EFI_HOB_TYPE_UNUSED;
+  UT_ASSERT_EQUAL ((UINTN)GetFirstGuidHob (&mTestGuids[0]), (UINTN)Second.Raw);
+
+  //
+  // Mark every fifth GUID HOB unused, including the last HOBs of some GUIDs.
+  //
+  Number = 0;
+  for (Hob.Raw = (UINT8 *)mTestHobList; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    if ((GET_HOB_TYPE (Hob) == EFI_HOB_TYPE_GUID_EXTENSION) && (Number++ % 5 == 0)) {
+      Hob.Header->HobType = EFI_HOB_TYPE_UNUSED;
+    }
+  }
+
+  UT_ASSERT_NOT_NULL (mGuidHobIndex);
+  return CheckAgainstWalk ();
+}
+
+/**
+  An index with a bad signature or for another HOB list is ignored, and so is
+  the index for a HOB outside the indexed HOB list.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+IgnoredIndexTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT64                Copy[(sizeof (EFI_HOB_GUID_TYPE) + sizeof (EFI_HOB_GENERIC_HEADER)) / sizeof (UINT64)];
+  EFI_PEI_HOB_POINTERS  Hob;
+  UINT32                Signature;
+
+  //
+  // A GUID HOB copied out of the HOB list is found by a walk from the copy.
+  //
+  Hob.Raw = GetFirstGuidHob (&mTestGuids[1]);
+  UT_ASSERT_NOT_NULL (Hob.Raw);
+  CopyMem (Copy, Hob.Raw, sizeof (EFI_HOB_GUID_TYPE));
+  Hob.Raw               = (UINT8 *)Copy;
+  Hob.Header->HobLength = sizeof (EFI_HOB_GUID_TYPE);
+  Hob.Raw               = GET_NEXT_HOB (Hob);
+  Hob.Header->HobType   = EFI_HOB_TYPE_END_OF_HOB_LIST;
+  Hob.Header->HobLength = sizeof (EFI_HOB_GENERIC_HEADER);
+  UT_ASSERT_EQUAL ((UINTN)GetNextGuidHob (&mTestGuids[1], Copy), (UINTN)Copy);
+
+  Signature             = mTestIndex->Signature;
+  mTestIndex->Signature = SIGNATURE_32 ('B', 'A', 'D', '!');
+  mHobList              = NULL;
+  GetHobList ();
+  UT_ASSERT_EQUAL ((UINTN)mGuidHobIndex, 0);
+  mTestIndex->Signature = Signature;
+
+  mTestIndex->HobList = (EFI_PHYSICAL_ADDRESS)(UINTN)Copy;
+  mHobList            = NULL;
+  GetHobList ();
+  UT_ASSERT_EQUAL ((UINTN)mGuidHobIndex, 0);
+
+  return CheckAgainstWalk ();
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  GUID HOB lookups and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      GuidHobTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&GuidHobTests, Framework, "GUID HOB Index Tests", "DxeIndexedHobLib.GuidHob", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for GuidHobTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (GuidHobTests, "Index lookups match the HOB list walk", "IndexLookup", IndexLookupTest, IndexedHobListSetup, IndexedHobListCleanup, NULL);
+  AddTestCase (GuidHobTests, "Unused GUID HOBs are skipped", "UnusedHob", UnusedHobTest, IndexedHobListSetup, IndexedHobListCleanup, NULL);
+  AddTestCase (GuidHobTests, "A foreign or bad index is ignored", "IgnoredIndex", IgnoredIndexTest, IndexedHobListSetup, IndexedHobListCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,340 @@
+/** @file
+  Host based tests of the parallel LZMA GUIDed section extraction.
+
+  A chunked payload must decompress to the same data as a single LZMA stream
+  of the same input, both serially through the GUIDed section handlers and with
+  every chunk decompressed on its own thread, as the APs do in PEI.
+
+  Copyright (C) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <Library/GoogleTestLib.h>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+extern "C" {
+  #include <PiPei.h>
+  #include <Library/BaseLib.h>
+  #include <Library/BaseMemoryLib.h>
+  #include <Guid/ParallelLzmaDecompress.h>
+  #include "ParallelLzmaTestVectors.h"
+
+  //
+  // The routines under test, ParallelLzmaCustomDecompressLib and the NULL
+  // class LzmaCustomDecompressLib it relies on have no library class header.
+  //
+  RETURN_STATUS
+  EFIAPI
+  ParallelLzmaGuidedSectionGetInfo (
+    IN  CONST VOID  *InputSection,
+    OUT UINT32      *OutputBufferSize,
+    OUT UINT32      *ScratchBufferSize,
+    OUT UINT16      *SectionAttribute
+    );
+
+  RETURN_STATUS
+  EFIAPI
+  ParallelLzmaGuidedSectionExtraction (
+    IN CONST  VOID  *InputSection,
+    OUT       VOID  **OutputBuffer,
+    OUT       VOID  *ScratchBuffer,
+    OUT       UINT32  *AuthenticationStatus
+    );
+
+  RETURN_STATUS
+  EFIAPI
+  ParallelLzmaChunkedGetInfo (
+    IN  CONST VOID  *Source,
+    IN  UINTN       SourceSize,
+    OUT UINT32      *ChunkCount,
+    OUT UINT32      *DestinationSize,
+    OUT UINT32      *ScratchSize
+    );
+
+  RETURN_STATUS
+  EFIAPI
+  ParallelLzmaDecompressChunk (
+    IN  CONST VOID  *Source,
+    IN  UINT32      ChunkIndex,
+    OUT VOID        *Destination,
+    IN  VOID        *Scratch
+    );
+
+  RETURN_STATUS
+  EFIAPI
+  LzmaUefiDecompress (
+    IN CONST VOID  *Source,
+    IN UINTN       SourceSize,
+    IN OUT VOID    *Destination,
+    IN OUT VOID    *Scratch
+    );
+}
+
+using namespace testing;
+
+#define PARALLEL_LZMA_TEST_ITERATIONS  200
+
+/**
+  Regenerates the data both test vectors were compressed from.
+
+  @return 64KB of repeating text with a pseudo random byte every 61 bytes.
+**/
+STATIC
+std::vector<UINT8>
+ParallelLzmaTestPlaintext (
+  VOID
+  )
+{
+  STATIC CONST CHAR8  Pattern[] = "ParallelLzmaChunk";
+  std::vector<UINT8>  Data (PARALLEL_LZMA_TEST_PLAINTEXT_SIZE);
+  UINT32              Seed;
+
+  Seed = 1;
+  for (UINTN Index = 0; Index < Data.size (); Index++) {
+    if (Index % 61 == 0) {
+      Seed        = Seed * 1103515245 + 12345;
+      Data[Index] = (UINT8)(Seed >> 16);
+    } else {
+      Data[Index] = (UINT8)Pattern[(Index / 3) % (sizeof (Pattern) - 1)];
+    }
+  }
+
+  return Data;
+}
+
+/**
+  Wraps data in a parallel LZMA GUIDed section.
+
+  @param[in] Data      The data of the section.
+  @param[in] DataSize  The size, in bytes, of Data.
+
+  @return The GUIDed section.
+**/
+STATIC
+std::vector<UINT8>
+BuildGuidedSection (
+  IN CONST UINT8  *Data,
+  IN UINTN        DataSize
+  )
+{
+  std::vector<UINT8>        Section (sizeof (EFI_GUID_DEFINED_SECTION) + DataSize);
+  EFI_GUID_DEFINED_SECTION  *Header;
+
+  Header = (EFI_GUID_DEFINED_SECTION *)Section.data ();
+  Header->CommonHeader.Size[0] = (UINT8)Section.size ();
+  Header->CommonHeader.Size[1] = (UINT8)(Section.size () >> 8);
+  Header->CommonHeader.Size[2] = (UINT8)(Section.size () >> 16);
+  Header->CommonHeader.Type    = EFI_SECTION_GUID_DEFINED;
+  CopyGuid (&Header->SectionDefinitionGuid, &gParallelLzmaCustomDecompressGuid);
+  Header->DataOffset = sizeof (EFI_GUID_DEFINED_SECTION);
+  Header->Attributes = EFI_GUIDED_SECTION_PROCESSING_REQUIRED;
+  CopyMem (Header + 1, Data, DataSize);
+  return Section;
+}
+
+class ParallelLzmaDecompressTest : public Test {
+protected:
+  std::vector<UINT8> Plaintext;
+
+  void
+  SetUp (
+    ) override
+  {
+    Plaintext = ParallelLzmaTestPlaintext ();
+  }
+
+  /**
+    Extracts a GUIDed section through the section handlers.
+
+    @param[in]  Section  The GUIDed section.
+    @param[out] Output   The decompressed data.
+
+    @return The status of the extraction.
+  **/
+  RETURN_STATUS
+  Extract (
+    const std::vector<UINT8>  &Section,
+    std::vector<UINT8>        &Output
+    )
+  {
+    std::vector<UINT8>  Scratch;
+    RETURN_STATUS       Status;
+    UINT32              OutputSize;
+    UINT32              ScratchSize;
+    UINT32              AuthenticationStatus;
+    UINT16              Attributes;
+    VOID                *OutputBuffer;
+
+    Status = ParallelLzmaGuidedSectionGetInfo (Section.data (), &OutputSize, &ScratchSize, &Attributes);
+    if (RETURN_ERROR (Status)) {
+      return Status;
+    }
+
+    EXPECT_EQ (Attributes, EFI_GUIDED_SECTION_PROCESSING_REQUIRED);
+    Output.assign (OutputSize, 0);
+    Scratch.assign (ScratchSize, 0);
+    OutputBuffer = Output.data ();
+    return ParallelLzmaGuidedSectionExtraction (Section.data (), &OutputBuffer, Scratch.data (), &AuthenticationStatus);
+  }
+
+  /**
+    Decompresses every chunk of the chunked test vector on its own thread.
+
+    @param[out] Output  The decompressed data.
+  **/
+  void
+  ExtractConcurrently (
+    std::vector<UINT8>  &Output
+    )
+  {
+    std::vector<std::vector<UINT8> >  Scratch;
+    std::vector<std::thread>          Threads;
+    std::vector<RETURN_STATUS>        Status;
+    UINT32                            ChunkCount;
+    UINT32                            OutputSize;
+    UINT32                            ScratchSize;
+
+    ASSERT_EQ (
+      ParallelLzmaChunkedGetInfo (mChunkedPayload, sizeof (mChunkedPayload), &ChunkCount, &OutputSize, &ScratchSize),
+      RETURN_SUCCESS
+      );
+    Output.assign (OutputSize, 0);
+    Scratch.assign (ChunkCount, std::vector<UINT8>(ScratchSize));
+    Status.assign (ChunkCount, RETURN_NOT_STARTED);
+    for (UINT32 Index = 0; Index < ChunkCount; Index++) {
+      Threads.emplace_back (
+                [&, Index]() {
+        Status[Index] = ParallelLzmaDecompressChunk (mChunkedPayload, Index, Output.data (), Scratch[Index].data ());
+      }
+                );
+    }
+
+    for (std::thread &Thread : Threads) {
+      Thread.join ();
+    }
+
+    for (RETURN_STATUS ChunkStatus : Status) {
+      EXPECT_EQ (ChunkStatus, RETURN_SUCCESS);
+    }
+  }
+};
+
+// A plain LZMA stream keeps being handled as before.
+TEST_F (ParallelLzmaDecompressTest, SerialStream) {
+  std::vector<UINT8>  Output;
+
+  ASSERT_EQ (Extract (BuildGuidedSection (mSerialStream, sizeof (mSerialStream)), Output), RETURN_SUCCESS);
+  EXPECT_EQ (Output, Plaintext);
+}
+
+// With no decompressed buffer handed over in a HOB, a chunked payload is
+// decompressed one chunk after the other, to the same data as the serial stream.
+TEST_F (ParallelLzmaDecompressTest, ChunkedPayloadMatchesSerialStream) {
+  std::vector<UINT8>  Serial;
+  std::vector<UINT8>  Chunked;
+
+  ASSERT_EQ (Extract (BuildGuidedSection (mSerialStream, sizeof (mSerialStream)), Serial), RETURN_SUCCESS);
+  ASSERT_EQ (Extract (BuildGuidedSection (mChunkedPayload, sizeof (mChunkedPayload)), Chunked), RETURN_SUCCESS);
+  EXPECT_EQ (Chunked, Serial);
+}
+
+// Chunks decompressed concurrently into the shared output buffer.
+TEST_F (ParallelLzmaDecompressTest, ConcurrentChunks) {
+  std::vector<UINT8>  Output;
+
+  ExtractConcurrently (Output);
+  EXPECT_EQ (Output, Plaintext);
+}
+
+// A plain stream is not taken for a chunked payload, and a corrupted chunk
+// table is rejected before anything is decompressed.
+TEST_F (ParallelLzmaDecompressTest, ChunkTableValidation) {
+  std::vector<UINT8>            Payload;
+  PARALLEL_LZMA_CHUNKED_HEADER  *Header;
+  UINT32                        *Offsets;
+  UINT32                        ChunkCount;
+  UINT32                        OutputSize;
+  UINT32                        ScratchSize;
+
+  EXPECT_EQ (
+    ParallelLzmaChunkedGetInfo (mSerialStream, sizeof (mSerialStream), &ChunkCount, &OutputSize, &ScratchSize),
+    RETURN_UNSUPPORTED
+    );
+
+  ASSERT_EQ (
+    ParallelLzmaChunkedGetInfo (mChunkedPayload, sizeof (mChunkedPayload), &ChunkCount, &OutputSize, &ScratchSize),
+    RETURN_SUCCESS
+    );
+  EXPECT_EQ (ChunkCount, (UINT32)PARALLEL_LZMA_TEST_CHUNK_COUNT);
+  EXPECT_EQ (OutputSize, (UINT32)PARALLEL_LZMA_TEST_PLAINTEXT_SIZE);
+
+  // Truncated payload.
+  EXPECT_EQ (
+    ParallelLzmaChunkedGetInfo (mChunkedPayload, sizeof (mChunkedPayload) - 1, &ChunkCount, &OutputSize, &ScratchSize),
+    RETURN_INVALID_PARAMETER
+    );
+
+  Payload.assign (mChunkedPayload, mChunkedPayload + sizeof (mChunkedPayload));
+  Header  = (PARALLEL_LZMA_CHUNKED_HEADER *)Payload.data ();
+  Offsets = (UINT32 *)(Header + 1);
+
+  // Chunk size that does not account for the decompressed size.
+  Header->ChunkSize /= 2;
+  EXPECT_EQ (ParallelLzmaChunkedGetInfo (Payload.data (), Payload.size (), &ChunkCount, &OutputSize, &ScratchSize), RETURN_INVALID_PARAMETER);
+  Header->ChunkSize *= 2;
+
+  // More chunks than the payload can hold a table for.
+  Header->ChunkCount = MAX_UINT32;
+  EXPECT_EQ (ParallelLzmaChunkedGetInfo (Payload.data (), Payload.size (), &ChunkCount, &OutputSize, &ScratchSize), RETURN_INVALID_PARAMETER);
+  Header->ChunkCount = PARALLEL_LZMA_TEST_CHUNK_COUNT;
+
+  // Overlapping chunks.
+  Offsets[2] = Offsets[1];
+  EXPECT_EQ (ParallelLzmaChunkedGetInfo (Payload.data (), Payload.size (), &ChunkCount, &OutputSize, &ScratchSize), RETURN_INVALID_PARAMETER);
+}
+
+// Reports how long the payload takes to decompress serially and concurrently.
+TEST_F (ParallelLzmaDecompressTest, Throughput) {
+  std::vector<UINT8>  Section;
+  std::vector<UINT8>  Output;
+  double              SerialSeconds;
+  double              ConcurrentSeconds;
+
+  Section = BuildGuidedSection (mChunkedPayload, sizeof (mChunkedPayload));
+  auto  Start = std::chrono::steady_clock::now ();
+
+  for (UINTN Index = 0; Index < PARALLEL_LZMA_TEST_ITERATIONS; Index++) {
+    ASSERT_EQ (Extract (Section, Output), RETURN_SUCCESS);
+  }
+
+  SerialSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now () - Start).count ();
+
+  Start = std::chrono::steady_clock::now ();
+  for (UINTN Index = 0; Index < PARALLEL_LZMA_TEST_ITERATIONS; Index++) {
+    ExtractConcurrently (Output);
+  }
+
+  ConcurrentSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now () - Start).count ();
+  EXPECT_EQ (Output, Plaintext);
+
+  printf (
+    "[ PERF     ] %u x %u bytes: serial %.3f ms, %u chunks concurrently %.3f ms\n",
+    (UINT32)PARALLEL_LZMA_TEST_ITERATIONS,
+    (UINT32)PARALLEL_LZMA_TEST_PLAINTEXT_SIZE,
+    SerialSeconds * 1000,
+    (UINT32)PARALLEL_LZMA_TEST_CHUNK_COUNT,
+    ConcurrentSeconds * 1000
+    );
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  testing::InitGoogleTest (&argc, argv);
+  return RUN_ALL_TESTS ();
+}
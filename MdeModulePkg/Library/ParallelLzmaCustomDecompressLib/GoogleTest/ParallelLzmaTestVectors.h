@@ -0,0 +1,285 @@
+/** @file
+  LZMA test vectors for the parallel LZMA decompression tests.
+
+  Both vectors hold the output of ParallelLzmaTestPlaintext (), 64KB of
+  repeating text with a pseudo random byte every 61 bytes. mSerialStream was
+  compressed as a single stream with "LzmaCompress -e", mChunkedPayload as four
+  16KB chunks compressed the same way, behind a PARALLEL_LZMA_CHUNKED_HEADER.
+
+  Copyright (C) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef PARALLEL_LZMA_TEST_VECTORS_H_
+#define PARALLEL_LZMA_TEST_VECTORS_H_
+
+#define PARALLEL_LZMA_TEST_PLAINTEXT_SIZE  SIZE_64KB
+#define PARALLEL_LZMA_TEST_CHUNK_COUNT     4
+
+STATIC CONST UINT8  mSerialStream[] = {
+  0x5d, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x63, 0x14,
+  0x2c, 0xc3, 0xa0, 0x72, 0xd0, 0x88, 0x6c, 0x0a, 0x09, 0xaa, 0xdb, 0x5b, 0xd0, 0xdd, 0xf7, 0x47,
+  0x27, 0x0a, 0x9c, 0x61, 0xc8, 0xa8, 0xf1, 0x27, 0x63, 0xdc, 0xf6, 0xed, 0x5e, 0x86, 0xf5, 0x6f,
+  0x81, 0x21, 0xc2, 0xee, 0x80, 0x89, 0x1f, 0xad, 0x6a, 0xa2, 0x15, 0x9e, 0x7b, 0xad, 0xb6, 0x7e,
+  0x2b, 0x59, 0x88, 0xf4, 0x73, 0xe7, 0xb4, 0x6f, 0x5b, 0xc9, 0x2e, 0x1b, 0x00, 0xde, 0xd8, 0x60,
+  0x9f, 0x9d, 0xf2, 0x3d, 0x0b, 0x34, 0x1f, 0x17, 0xc6, 0xb9, 0xb1, 0x21, 0x72, 0xf8, 0x17, 0x2c,
+  0x91, 0x7b, 0xdf, 0xcd, 0x29, 0x69, 0xc6, 0xe8, 0xe8, 0x7a, 0xda, 0x0c, 0x94, 0x84, 0xfb, 0x55,
+  0x96, 0x29, 0x3e, 0xa8, 0xba, 0x2d, 0xb4, 0x22, 0x6e, 0x47, 0x10, 0x0c, 0x50, 0x7f, 0x13, 0x81,
+  0xfd, 0xb7, 0xaa, 0xa3, 0xb3, 0xa1, 0xb1, 0x8e, 0x34, 0x10, 0x5f, 0x77, 0x7f, 0x14, 0x84, 0xb3,
+  0x82, 0xca, 0x72, 0x92, 0x00, 0x49, 0x7d, 0x6d, 0x40, 0xc7, 0xa5, 0xae, 0x19, 0xd1, 0x6d, 0x0a,
+  0x76, 0x96, 0xa0, 0x87, 0x3c, 0xd7, 0xed, 0x50, 0x0a, 0x32, 0x9d, 0xf3, 0x72, 0x1d, 0x73, 0xd8,
+  0xf0, 0x1c, 0x92, 0x7e, 0x92, 0x07, 0xd3, 0x44, 0x1e, 0xa7, 0xbd, 0xe0, 0xce, 0x10, 0x6e, 0xc5,
+  0xd5, 0x66, 0xba, 0x77, 0x7f, 0xea, 0xff, 0x8b, 0xd3, 0x56, 0xac, 0xaf, 0xe6, 0x61, 0x19, 0x30,
+  0xbd, 0xe5, 0xb3, 0x58, 0x55, 0x84, 0xdd, 0x2c, 0x4d, 0x1b, 0x13, 0xe5, 0xda, 0xc6, 0x2a, 0xa2,
+  0x89, 0x44, 0xbf, 0xef, 0x9b, 0xee, 0x1f, 0x0d, 0x8c, 0x09, 0x6f, 0x3a, 0x15, 0x8f, 0x7a, 0xa6,
+  0xa2, 0x1b, 0x48, 0x86, 0xd1, 0x0d, 0x27, 0xdd, 0x2c, 0xea, 0x24, 0xfe, 0x4e, 0xbb, 0x0c, 0xe4,
+  0xcf, 0xf1, 0x45, 0xf1, 0x1c, 0x1a, 0x67, 0x56, 0xd0, 0xd7, 0x52, 0xa9, 0xd2, 0x64, 0x40, 0x46,
+  0x1b, 0xfb, 0x4e, 0x82, 0xb3, 0xfa, 0x76, 0x1e, 0x2c, 0xe9, 0xad, 0xbf, 0xb2, 0xe2, 0x14, 0xb0,
+  0x99, 0xc7, 0xf8, 0x56, 0x19, 0xd8, 0x13, 0xc7, 0x82, 0x01, 0xc9, 0xf2, 0x3d, 0x60, 0xeb, 0xa0,
+  0x87, 0x4b, 0xbe, 0x18, 0x75, 0x6a, 0xd9, 0x54, 0x10, 0x86, 0xc4, 0xe4, 0x64, 0xda, 0xc2, 0x57,
+  0x06, 0x4a, 0xfd, 0x46, 0x52, 0xcb, 0x8d, 0x08, 0x47, 0x63, 0x00, 0x61, 0x46, 0xc8, 0x2b, 0xad,
+  0x8b, 0xf6, 0x1e, 0xe3, 0xfe, 0x92, 0x14, 0x78, 0x2f, 0x83, 0xf6, 0xd0, 0x26, 0x50, 0xf4, 0x1b,
+  0xd7, 0x98, 0x15, 0x32, 0x50, 0x92, 0xa4, 0x91, 0x9b, 0x10, 0x45, 0xb4, 0xd4, 0x3c, 0x97, 0x0c,
+  0x60, 0xf4, 0x51, 0xde, 0xf7, 0x33, 0x28, 0x7d, 0xf5, 0x3c, 0x31, 0xaa, 0xc9, 0x59, 0x45, 0xa3,
+  0x04, 0x11, 0xb1, 0xe6, 0xe4, 0xe9, 0x6c, 0xf3, 0xfb, 0x73, 0x5f, 0xbb, 0xfc, 0x02, 0x43, 0x94,
+  0x82, 0x41, 0xc9, 0x01, 0x27, 0xa1, 0x44, 0xee, 0xc8, 0x22, 0x62, 0x69, 0xd4, 0x7c, 0xd2, 0x55,
+  0xdc, 0xee, 0x89, 0xca, 0xd0, 0x2e, 0x13, 0x42, 0x2b, 0x4d, 0x29, 0x6d, 0x9a, 0x00, 0xcb, 0xea,
+  0x86, 0x9d, 0xc4, 0x5e, 0x89, 0xc8, 0xb6, 0x29, 0x3d, 0xf5, 0x71, 0xe8, 0xcb, 0xf2, 0xe1, 0x64,
+  0x69, 0xf4, 0x32, 0x6f, 0x26, 0xfb, 0x89, 0x4d, 0x63, 0x73, 0x40, 0x52, 0xaa, 0xae, 0x71, 0x80,
+  0xd2, 0xf5, 0x7d, 0xc4, 0x60, 0x23, 0xb7, 0x18, 0xd5, 0xb6, 0xcf, 0x95, 0xde, 0x0d, 0x8a, 0xdd,
+  0xae, 0x45, 0x3e, 0x85, 0x62, 0xeb, 0xbf, 0x95, 0xc3, 0xc2, 0x36, 0xe8, 0xbd, 0x88, 0x5e, 0x3e,
+  0x7b, 0xda, 0x7f, 0x10, 0x53, 0x72, 0x42, 0x79, 0x51, 0x97, 0xda, 0x4d, 0x8c, 0x20, 0x70, 0x30,
+  0xac, 0x3e, 0xf8, 0x3d, 0x32, 0x7b, 0x25, 0x94, 0xa4, 0x13, 0x62, 0x0e, 0x59, 0x99, 0xc7, 0xe1,
+  0x01, 0x92, 0x91, 0xbf, 0xec, 0xd1, 0x93, 0xa5, 0x8f, 0xb5, 0x14, 0x09, 0xe6, 0x9b, 0x61, 0xfe,
+  0xc5, 0x3c, 0x15, 0x83, 0x3b, 0xb6, 0xc8, 0xf1, 0xd0, 0x36, 0x23, 0x5d, 0xb7, 0xd4, 0xfb, 0xb6,
+  0x06, 0x83, 0xda, 0xef, 0xaa, 0x92, 0x99, 0x18, 0xba, 0x71, 0x93, 0x15, 0x3c, 0xa9, 0x9e, 0x2c,
+  0x29, 0xc7, 0x3d, 0xa3, 0xcc, 0x08, 0x29, 0x06, 0x6e, 0x45, 0x66, 0xe3, 0x08, 0xce, 0x17, 0xf6,
+  0x37, 0xff, 0x9b, 0xec, 0x2d, 0x4d, 0x72, 0xdf, 0xa9, 0xc2, 0x74, 0x30, 0x7d, 0x17, 0xd3, 0xc3,
+  0xd9, 0x3b, 0x15, 0xd3, 0xf7, 0x33, 0xca, 0x14, 0xc7, 0xfa, 0x4c, 0xf8, 0x81, 0xd3, 0x2f, 0x98,
+  0xda, 0xd2, 0x36, 0xd0, 0x43, 0xc5, 0xff, 0x82, 0xc8, 0xd4, 0x26, 0x47, 0x69, 0x6b, 0x92, 0x89,
+  0x23, 0x10, 0x07, 0x56, 0x33, 0x84, 0x27, 0x6c, 0x14, 0x37, 0xf3, 0x4c, 0x59, 0x78, 0xd5, 0x6b,
+  0x84, 0x71, 0x77, 0x99, 0xaf, 0x89, 0x04, 0xfc, 0x52, 0xe0, 0xa3, 0x95, 0x0b, 0x66, 0x81, 0x58,
+  0xfe, 0x2f, 0xf0, 0x04, 0xfb, 0xb6, 0x43, 0x96, 0x0d, 0x6f, 0x3d, 0x2b, 0x22, 0xee, 0xaf, 0xf8,
+  0x6f, 0x5c, 0x32, 0x8c, 0x28, 0xad, 0x43, 0xa5, 0x26, 0xf6, 0x42, 0xea, 0x8b, 0x6f, 0xe7, 0xb3,
+  0x5f, 0x82, 0x1b, 0xe1, 0x93, 0xe0, 0x17, 0x71, 0x53, 0x22, 0x6f, 0xf9, 0xe0, 0x31, 0x64, 0x47,
+  0x71, 0x9c, 0xe4, 0x11, 0x5e, 0x74, 0xe3, 0x16, 0x86, 0xd0, 0x99, 0x20, 0xf2, 0x2e, 0x59, 0xd6,
+  0x7c, 0xa7, 0xbd, 0x50, 0x38, 0x45, 0xf0, 0x34, 0x5c, 0x01, 0xad, 0xb0, 0xd1, 0xd1, 0x95, 0xe1,
+  0x53, 0x36, 0x13, 0xce, 0x81, 0x2a, 0xb3, 0x33, 0xbc, 0x32, 0x89, 0xbc, 0x72, 0x71, 0xb4, 0x91,
+  0x5a, 0x61, 0x36, 0xd3, 0xec, 0xe4, 0xbd, 0xab, 0x15, 0x2c, 0x24, 0x12, 0x7a, 0xc4, 0x64, 0x79,
+  0x6f, 0x4a, 0xe6, 0x26, 0xe5, 0x3e, 0xf9, 0x63, 0xab, 0x41, 0x22, 0x49, 0x0a, 0xc6, 0xff, 0x9b,
+  0x9c, 0xfd, 0x06, 0xfb, 0x64, 0x94, 0x54, 0xc2, 0x84, 0xad, 0x75, 0xc8, 0x50, 0xd1, 0x32, 0xce,
+  0x10, 0x54, 0x1c, 0x15, 0x8f, 0x66, 0x26, 0x65, 0x9c, 0xe7, 0x13, 0x9c, 0x6e, 0xd8, 0x75, 0xe1,
+  0xa5, 0xdf, 0xf7, 0x20, 0x1e, 0xfe, 0x11, 0x4f, 0x56, 0xe8, 0x48, 0x5d, 0xb0, 0xad, 0x41, 0x89,
+  0xd8, 0x68, 0xd4, 0x0b, 0xca, 0x09, 0xd7, 0x0d, 0x1e, 0x29, 0xb4, 0x33, 0x9a, 0x74, 0x2d, 0x00,
+  0x6c, 0xa7, 0x99, 0x33, 0x34, 0xd9, 0x4e, 0x51, 0x7c, 0xac, 0xd6, 0x42, 0xe3, 0x2a, 0xd5, 0x76,
+  0x61, 0x77, 0x93, 0x5e, 0xb7, 0x40, 0xb5, 0x77, 0x4c, 0xda, 0x56, 0x38, 0xf2, 0x4c, 0xda, 0xe6,
+  0x8e, 0x5c, 0x7b, 0xd4, 0x37, 0x8a, 0xb2, 0x56, 0x06, 0x0c, 0x28, 0x77, 0xc6, 0xce, 0xa8, 0xd1,
+  0xb5, 0xf8, 0x78, 0x53, 0x22, 0xbe, 0xba, 0xdd, 0x6e, 0xc7, 0xcb, 0x90, 0x41, 0x93, 0xaf, 0xd3,
+  0xd8, 0x8b, 0x0c, 0x48, 0xa1, 0x6d, 0xab, 0xf2, 0xed, 0x39, 0x9a, 0x04, 0xb0, 0xda, 0x8d, 0x35,
+  0x3a, 0x2f, 0x09, 0x13, 0xf3, 0xcc, 0x67, 0x86, 0x1a, 0xb1, 0x5e, 0x76, 0xf1, 0xe0, 0x47, 0x99,
+  0x41, 0xb9, 0x67, 0x79, 0xe4, 0x94, 0x91, 0xb0, 0x3c, 0x79, 0x67, 0x31, 0x64, 0xcb, 0xb0, 0x78,
+  0x7e, 0x96, 0xbd, 0xa0, 0xa8, 0x70, 0xe0, 0x1c, 0x88, 0x51, 0x10, 0xba, 0x6a, 0xb2, 0xe1, 0x26,
+  0x8f, 0x8d, 0x64, 0xbc, 0x1f, 0x1e, 0x17, 0xe6, 0xf5, 0x2c, 0xae, 0x95, 0x3f, 0xe9, 0x19, 0x4a,
+  0x1a, 0x5b, 0x1a, 0x9a, 0xe3, 0x73, 0xe3, 0xb6, 0xc0, 0x0b, 0x91, 0x96, 0x60, 0x0e, 0x63, 0x0b,
+  0x4a, 0x4b, 0x2d, 0x4d, 0x31, 0x01, 0x7b, 0x35, 0x16, 0xfe, 0x20, 0x3c, 0x28, 0x95, 0x13, 0x78,
+  0x9a, 0x50, 0x62, 0x85, 0x70, 0xc0, 0xa4, 0x36, 0x86, 0xf8, 0xd2, 0x5d, 0x5e, 0x6d, 0x86, 0x9d,
+  0xc9, 0x01, 0xb9, 0xaf, 0xf7, 0x23, 0x35, 0x8f, 0xd4, 0x83, 0x7e, 0xf2, 0x62, 0x12, 0xfe, 0x0d,
+  0x92, 0xe7, 0xdf, 0xa5, 0x02, 0x35, 0xf1, 0x9d, 0x12, 0xd4, 0x2d, 0x0d, 0x40, 0xbc, 0xb9, 0x62,
+  0x94, 0xe6, 0xcb, 0xaa, 0x65, 0x14, 0x0f, 0xff, 0xbb, 0x7f, 0x24, 0x67, 0xd1, 0xa7, 0x8b, 0x12,
+  0x85, 0xb8, 0xb6, 0xbe, 0xf1, 0xd2, 0xf6, 0xc4, 0x63, 0x31, 0xb9, 0x5d, 0x78, 0xd0, 0x5d, 0xa7,
+  0xd0, 0x83, 0xcd, 0x17, 0xb3, 0x54, 0xc8, 0xab, 0x77, 0x3d, 0x60, 0xee, 0x1f, 0x19, 0x4d, 0x1f,
+  0xea, 0x6d, 0x88, 0x3a, 0x0e, 0x90, 0x1d, 0x2e, 0x52, 0x5f, 0xd7, 0x7a, 0xd2, 0x86, 0xd0, 0x12,
+  0x20, 0xc4, 0xc6, 0xdb, 0x34, 0x50, 0x99, 0x91, 0xde, 0xec, 0x0b, 0x1b, 0xf6, 0x72, 0x53, 0xa7,
+  0xfb, 0x76, 0x63, 0x31, 0x8c, 0x56, 0x5a, 0x13, 0x10, 0x84, 0xe1, 0xa7, 0x2d, 0x23, 0xf8, 0x61,
+  0xcf, 0x63, 0x8a, 0xcd, 0xdd, 0x3e, 0xda, 0x22, 0x4d, 0x3e, 0x38, 0xd9, 0x91, 0xfe, 0x98, 0x2f,
+  0x9f, 0x69, 0xd9, 0x66, 0x14, 0x04, 0x29, 0x1b, 0x1a, 0x77, 0xe4, 0x11, 0xb6, 0xad, 0xce, 0xa9,
+  0xb8, 0x5a, 0xf7, 0x39, 0x71, 0x22, 0x25, 0x55, 0xed, 0x76, 0x07, 0x25, 0x76, 0x6b, 0xe7, 0x65,
+  0x0d, 0xee, 0x4e, 0x60, 0x89, 0x82, 0xbe, 0x09, 0xf3, 0x1f, 0x69, 0xb0, 0xc3, 0xeb, 0x3e, 0xe9,
+  0x44, 0x55, 0xf4, 0xba, 0x3c, 0xd3, 0x83, 0x12, 0x8e, 0x2d, 0x22, 0x0f, 0x32, 0x33, 0xa0, 0x9c,
+  0x62, 0x31, 0xe1, 0x2d, 0x34, 0x23, 0x04, 0x9b, 0x79, 0xa7, 0xff, 0x07, 0xf8, 0x06, 0x40, 0x4b,
+  0x66, 0x81, 0xbb, 0xee, 0xfb, 0xf2, 0x11, 0xa0, 0x21, 0x7f, 0xe8, 0xaa, 0x4e, 0xc5, 0xf2, 0xe2,
+  0xc7, 0x17, 0x4c, 0xa5, 0xd5, 0xa5, 0x54, 0xda, 0x5b, 0x54, 0xfc, 0x00, 0xda, 0x80, 0x5f, 0x7a,
+  0x9e, 0x6d, 0xbb, 0xb1, 0xeb, 0x7f, 0x2b, 0xfd, 0x12, 0xb9, 0x00, 0x7e, 0x6b, 0x2a, 0x06, 0x7c,
+  0xa9, 0xbe, 0x42, 0x55, 0x8a, 0x27, 0x99, 0xf8, 0xdd, 0x78, 0xc8, 0x43, 0xac, 0x5f, 0x6b, 0x72,
+  0x14, 0xc8, 0xcf, 0x5b, 0xdf, 0x99, 0x8f, 0xa3, 0x61, 0xb2, 0xcd, 0xb4, 0x0b, 0x32, 0x60, 0xdc,
+  0x30, 0x29, 0x71, 0x27, 0x6a, 0x2d, 0x91, 0xea, 0xf3, 0xe0, 0xa6, 0xb8, 0x57, 0xda, 0x4e, 0xdd,
+  0x3e, 0x86, 0xbc, 0x25, 0x63, 0xf3, 0x5f, 0x29, 0x85, 0x92, 0x1e, 0x3b, 0x75, 0xac, 0x5d, 0x20,
+  0x55, 0xfa, 0x45, 0x9d, 0xf4, 0xdf, 0xb6, 0x90, 0xf2, 0x77, 0x40, 0x49, 0x33, 0xdf, 0x75, 0xfb,
+  0x78, 0x5b, 0x15, 0x8a, 0x79, 0x1e, 0x0e, 0x2a, 0xa1, 0x33, 0x4b, 0x4c, 0x3e, 0x49, 0x52, 0x76,
+  0xc6, 0x39, 0xee, 0xbb, 0x59, 0x4a, 0xd2, 0x33, 0x3b, 0xfa, 0x4e, 0x60, 0x4a, 0xa7, 0x4e, 0xa7,
+  0xe4, 0x98, 0xf3, 0xd0, 0x0e, 0x59, 0xed, 0x4c, 0x69, 0xb3, 0x0d, 0x07, 0xcd, 0x89, 0x7f, 0x75,
+  0xf0, 0x02, 0x43, 0x42, 0x9f, 0x6c, 0x03, 0x8f, 0xe6, 0xfa, 0x9f, 0xf0, 0x68, 0xa8, 0xa5, 0xb7,
+  0xc6, 0x1b, 0x0c, 0xff, 0x45, 0x5c, 0xc7, 0xbc, 0xca, 0x7e, 0xed, 0x64, 0x40, 0x08, 0xa3, 0xd9,
+  0x42, 0x33, 0x89, 0xb5, 0xc9, 0x74, 0xab, 0xf7, 0xeb, 0xb4, 0xea, 0x05, 0xe1, 0xe5, 0x5e, 0x53,
+  0x7b, 0x91, 0x5b, 0x68, 0x33, 0xb3, 0xfd, 0xc9, 0xc1, 0x5e, 0xcc, 0xa9, 0x75, 0x99, 0xbd, 0x27,
+  0xfc, 0x95, 0x30, 0x8f, 0x9b, 0x8d, 0xcd, 0x4e, 0xd4, 0x20, 0x31, 0xa5, 0x50, 0x2f, 0xfe, 0x7e,
+  0xb0, 0x48, 0xd6, 0x0e, 0xa0, 0xb3, 0x5f, 0x54, 0x2e, 0x70, 0xa1, 0xc9, 0xdc, 0xad, 0xf9, 0x75,
+  0x81, 0xb2, 0x42, 0x90, 0xfd, 0xac, 0xc7, 0x69, 0xf5, 0x7e, 0xcd, 0x52, 0x84, 0x32, 0xd7,
+};
+
+STATIC CONST UINT8  mChunkedPayload[] = {
+  0xff, 0x50, 0x4c, 0x43, 0x04, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+  0x24, 0x00, 0x00, 0x00, 0x76, 0x02, 0x00, 0x00, 0x27, 0x05, 0x00, 0x00, 0x7f, 0x07, 0x00, 0x00,
+  0x20, 0x0a, 0x00, 0x00, 0x5d, 0x00, 0x00, 0x00, 0x01, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x63, 0x14, 0x2c, 0xc3, 0xa0, 0x72, 0xd0, 0x88, 0x6c, 0x0a, 0x09, 0xaa, 0xdb, 0x5b,
+  0xd0, 0xdd, 0xf7, 0x47, 0x27, 0x0a, 0x9c, 0x61, 0xc8, 0xa8, 0xf1, 0x27, 0x63, 0xdc, 0xf6, 0xed,
+  0x5e, 0x86, 0xf5, 0x6f, 0x81, 0x21, 0xc2, 0xee, 0x80, 0x89, 0x1f, 0xad, 0x6a, 0xa2, 0x15, 0x9e,
+  0x7b, 0xad, 0xb6, 0x7e, 0x2b, 0x59, 0x88, 0xf4, 0x73, 0xe7, 0xb4, 0x6f, 0x5b, 0xc9, 0x2e, 0x1b,
+  0x00, 0xde, 0xd8, 0x60, 0x9f, 0x9d, 0xf2, 0x3d, 0x0b, 0x34, 0x1f, 0x17, 0xc6, 0xb9, 0xb1, 0x21,
+  0x72, 0xf8, 0x17, 0x2c, 0x91, 0x7b, 0xdf, 0xcd, 0x29, 0x69, 0xc6, 0xe8, 0xe8, 0x7a, 0xda, 0x0c,
+  0x94, 0x84, 0xfb, 0x55, 0x96, 0x29, 0x3e, 0xa8, 0xba, 0x2d, 0xb4, 0x22, 0x6e, 0x47, 0x10, 0x0c,
+  0x50, 0x7f, 0x13, 0x81, 0xfd, 0xb7, 0xaa, 0xa3, 0xb3, 0xa1, 0xb1, 0x8e, 0x34, 0x10, 0x5f, 0x77,
+  0x7f, 0x14, 0x84, 0xb3, 0x82, 0xca, 0x72, 0x92, 0x00, 0x49, 0x7d, 0x6d, 0x40, 0xc7, 0xa5, 0xae,
+  0x19, 0xd1, 0x6d, 0x0a, 0x76, 0x96, 0xa0, 0x87, 0x3c, 0xd7, 0xed, 0x50, 0x0a, 0x32, 0x9d, 0xf3,
+  0x72, 0x1d, 0x73, 0xd8, 0xf0, 0x1c, 0x92, 0x7e, 0x92, 0x07, 0xd3, 0x44, 0x1e, 0xa7, 0xbd, 0xe0,
+  0xce, 0x10, 0x6e, 0xc5, 0xd5, 0x66, 0xba, 0x77, 0x7f, 0xea, 0xff, 0x8b, 0xd3, 0x56, 0xac, 0xaf,
+  0xe6, 0x61, 0x19, 0x30, 0xbd, 0xe5, 0xb3, 0x58, 0x55, 0x84, 0xdd, 0x2c, 0x4d, 0x1b, 0x13, 0xe5,
+  0xda, 0xc6, 0x2a, 0xa2, 0x89, 0x44, 0xbf, 0xef, 0x9b, 0xee, 0x1f, 0x0d, 0x8c, 0x09, 0x6f, 0x3a,
+  0x15, 0x8f, 0x7a, 0xa6, 0xa2, 0x1b, 0x48, 0x86, 0xd1, 0x0d, 0x27, 0xdd, 0x2c, 0xea, 0x24, 0xfe,
+  0x4e, 0xbb, 0x0c, 0xe4, 0xcf, 0xf1, 0x45, 0xf1, 0x1c, 0x1a, 0x67, 0x56, 0xd0, 0xd7, 0x52, 0xa9,
+  0xd2, 0x64, 0x40, 0x46, 0x1b, 0xfb, 0x4e, 0x82, 0xb3, 0xfa, 0x76, 0x1e, 0x2c, 0xe9, 0xad, 0xbf,
+  0xb2, 0xe2, 0x14, 0xb0, 0x99, 0xc7, 0xf8, 0x56, 0x19, 0xd8, 0x13, 0xc7, 0x82, 0x01, 0xc9, 0xf2,
+  0x3d, 0x60, 0xeb, 0xa0, 0x87, 0x4b, 0xbe, 0x18, 0x75, 0x6a, 0xd9, 0x54, 0x10, 0x86, 0xc4, 0xe4,
+  0x64, 0xda, 0xc2, 0x57, 0x06, 0x4a, 0xfd, 0x46, 0x52, 0xcb, 0x8d, 0x08, 0x47, 0x63, 0x00, 0x61,
+  0x46, 0xc8, 0x2b, 0xad, 0x8b, 0xf6, 0x1e, 0xe3, 0xfe, 0x92, 0x14, 0x78, 0x2f, 0x83, 0xf6, 0xd0,
+  0x26, 0x50, 0xf4, 0x1b, 0xd7, 0x98, 0x15, 0x32, 0x50, 0x92, 0xa4, 0x91, 0x9b, 0x10, 0x45, 0xb4,
+  0xd4, 0x3c, 0x97, 0x0c, 0x60, 0xf4, 0x51, 0xde, 0xf7, 0x33, 0x28, 0x7d, 0xf5, 0x3c, 0x31, 0xaa,
+  0xc9, 0x59, 0x45, 0xa3, 0x04, 0x11, 0xb1, 0xe6, 0xe4, 0xe9, 0x6c, 0xf3, 0xfb, 0x73, 0x5f, 0xbb,
+  0xfc, 0x02, 0x43, 0x94, 0x82, 0x41, 0xc9, 0x01, 0x27, 0xa1, 0x44, 0xee, 0xc8, 0x22, 0x62, 0x69,
+  0xd4, 0x7c, 0xd2, 0x55, 0xdc, 0xee, 0x89, 0xca, 0xd0, 0x2e, 0x13, 0x42, 0x2b, 0x4d, 0x29, 0x6d,
+  0x9a, 0x00, 0xcb, 0xea, 0x86, 0x9d, 0xc4, 0x5e, 0x89, 0xc8, 0xb6, 0x29, 0x3d, 0xf5, 0x71, 0xe8,
+  0xcb, 0xf2, 0xe1, 0x64, 0x69, 0xf4, 0x32, 0x6f, 0x26, 0xfb, 0x89, 0x4d, 0x63, 0x73, 0x40, 0x52,
+  0xaa, 0xae, 0x71, 0x80, 0xd2, 0xf5, 0x7d, 0xc4, 0x60, 0x23, 0xb7, 0x18, 0xd5, 0xb6, 0xcf, 0x95,
+  0xde, 0x0d, 0x8a, 0xdd, 0xae, 0x45, 0x3e, 0x85, 0x62, 0xeb, 0xbf, 0x95, 0xc3, 0xc2, 0x36, 0xe8,
+  0xbd, 0x88, 0x5e, 0x3e, 0x7b, 0xda, 0x7f, 0x10, 0x53, 0x72, 0x42, 0x79, 0x51, 0x97, 0xda, 0x4d,
+  0x8c, 0x20, 0x70, 0x30, 0xac, 0x3e, 0xf8, 0x3d, 0x32, 0x7b, 0x25, 0x94, 0xa4, 0x13, 0x62, 0x0e,
+  0x59, 0x99, 0xc7, 0xe1, 0x01, 0x92, 0x91, 0xbf, 0xec, 0xd1, 0x93, 0xa5, 0x8f, 0xb5, 0x14, 0x09,
+  0xe6, 0x9b, 0x61, 0xfe, 0xc5, 0x3c, 0x15, 0x83, 0x3b, 0xb6, 0xc8, 0xf1, 0xd0, 0x36, 0x23, 0x5d,
+  0xb7, 0xd4, 0xfb, 0xb6, 0x06, 0x83, 0xda, 0xef, 0xaa, 0x92, 0x99, 0x18, 0xba, 0x71, 0x93, 0x15,
+  0x3c, 0xa9, 0x9e, 0x2c, 0x29, 0xc7, 0x3d, 0xa3, 0xcc, 0x08, 0x29, 0x06, 0x6e, 0x45, 0x66, 0xe3,
+  0x08, 0x54, 0x75, 0xaa, 0xe0, 0x00, 0x5d, 0x00, 0x00, 0x00, 0x01, 0x00, 0x40, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x36, 0x69, 0x15, 0x74, 0x22, 0x1a, 0xdf, 0x9d, 0x8d, 0x40, 0xbb, 0x8e,
+  0x9a, 0xee, 0x48, 0xc2, 0xe3, 0x1f, 0x1b, 0x16, 0x04, 0xdf, 0x2f, 0xac, 0x6d, 0x61, 0xc5, 0xb6,
+  0x80, 0x9e, 0xcc, 0x5b, 0x7a, 0x7c, 0x5b, 0x4a, 0x84, 0xb9, 0x02, 0x96, 0xd6, 0xe9, 0xb0, 0xd8,
+  0xbc, 0xac, 0x6b, 0x3d, 0x97, 0xd9, 0x7f, 0x1d, 0x0d, 0xb0, 0x93, 0x87, 0x85, 0x02, 0x5e, 0x3e,
+  0x06, 0xbc, 0xe9, 0xf9, 0xcd, 0xe3, 0xfc, 0xba, 0xeb, 0xcf, 0x3e, 0x5d, 0xd9, 0x6b, 0x58, 0x02,
+  0xa0, 0x1d, 0x46, 0xa0, 0xaa, 0x08, 0x9c, 0x20, 0x9b, 0x48, 0x7d, 0x9d, 0xb9, 0x1b, 0x74, 0xbe,
+  0x77, 0x80, 0xd7, 0xef, 0x73, 0xde, 0xc6, 0xd2, 0x70, 0xea, 0x66, 0x44, 0xbf, 0x39, 0x1d, 0xdb,
+  0xed, 0xb0, 0xec, 0x5a, 0x31, 0x9f, 0x12, 0x38, 0x7b, 0xb6, 0x67, 0xae, 0x2a, 0x2f, 0x2c, 0x98,
+  0x18, 0x52, 0x12, 0x3d, 0x07, 0x68, 0xbf, 0xad, 0x7a, 0x6e, 0x76, 0x1d, 0xc3, 0x66, 0xe9, 0x81,
+  0x5a, 0x6f, 0x19, 0xb9, 0xfc, 0xfb, 0x84, 0xe8, 0xc6, 0xa7, 0xf1, 0x1f, 0xec, 0xe0, 0x00, 0xcf,
+  0xab, 0x0e, 0xac, 0x47, 0xc6, 0x99, 0xed, 0xd9, 0x0a, 0x75, 0x90, 0x76, 0x88, 0x28, 0xfa, 0x40,
+  0x88, 0xc3, 0xab, 0x67, 0x8c, 0x88, 0x15, 0x70, 0x92, 0x53, 0xfd, 0x6e, 0x0a, 0x46, 0xbc, 0xa2,
+  0x8a, 0x8f, 0x23, 0xdc, 0x5f, 0x7a, 0x40, 0xc9, 0x3e, 0xfb, 0xa2, 0x31, 0x9c, 0x91, 0x3b, 0x0b,
+  0x4f, 0xc7, 0x77, 0xde, 0x81, 0xcf, 0x60, 0x2a, 0xf0, 0xb3, 0x61, 0x20, 0x68, 0x51, 0xb0, 0x65,
+  0x7a, 0x56, 0x1e, 0xf9, 0x76, 0xef, 0xf9, 0x44, 0x7f, 0x09, 0xe5, 0x1b, 0xfb, 0x17, 0x57, 0x75,
+  0xa5, 0x75, 0xae, 0x8d, 0xa4, 0xd5, 0xae, 0x34, 0x23, 0xae, 0x34, 0xed, 0x26, 0xf4, 0xbf, 0x35,
+  0x3d, 0x5b, 0x56, 0xb6, 0x9a, 0x4a, 0xe3, 0xd7, 0xb1, 0x64, 0x83, 0x76, 0x6d, 0xf2, 0x8c, 0xa8,
+  0x61, 0x3c, 0x81, 0x6f, 0x52, 0x44, 0x85, 0x72, 0xad, 0x7e, 0xa0, 0xa4, 0x50, 0x53, 0xd2, 0x51,
+  0x84, 0x2a, 0x50, 0x66, 0x0e, 0xfa, 0x22, 0x4b, 0x9b, 0xb6, 0x3f, 0x78, 0xb3, 0xb5, 0xaf, 0x71,
+  0x8d, 0xe9, 0x61, 0x3b, 0x86, 0x47, 0xcc, 0xcd, 0x39, 0x99, 0xd4, 0x6a, 0xc7, 0x78, 0x1a, 0x23,
+  0x50, 0x04, 0xbd, 0xb5, 0x1f, 0xe0, 0x01, 0x47, 0xd7, 0x54, 0xf3, 0x53, 0x70, 0x38, 0x99, 0xaa,
+  0x2b, 0x57, 0xbf, 0x4b, 0x68, 0xa0, 0x2a, 0xbc, 0x28, 0x1c, 0x5c, 0x1e, 0x95, 0xf6, 0x91, 0x33,
+  0x1c, 0x71, 0xa9, 0x49, 0x8c, 0x32, 0xfe, 0x9e, 0x2f, 0x4b, 0xb1, 0x34, 0x3e, 0x94, 0x2d, 0xa1,
+  0x80, 0xca, 0x5a, 0x13, 0x8c, 0x05, 0x06, 0xed, 0x80, 0x4d, 0x35, 0x9a, 0xeb, 0x50, 0xf4, 0xe8,
+  0x04, 0x86, 0x8e, 0x81, 0x0c, 0xa3, 0xd7, 0x86, 0xd8, 0x77, 0xf6, 0xb3, 0x90, 0x09, 0x60, 0x6f,
+  0xd3, 0xc8, 0x2a, 0xc9, 0x10, 0xb5, 0x58, 0x5e, 0xed, 0xb0, 0x50, 0xef, 0xa0, 0xa8, 0x73, 0xa1,
+  0xda, 0xbb, 0x65, 0xe6, 0x9b, 0xd0, 0x36, 0xee, 0x94, 0x11, 0xbd, 0x27, 0x32, 0x1f, 0x20, 0xc6,
+  0xf7, 0xb7, 0x7e, 0xd9, 0x02, 0x51, 0xe1, 0x66, 0x0e, 0x30, 0x1e, 0x38, 0xb3, 0xd1, 0x8d, 0x99,
+  0xb1, 0x0f, 0xd4, 0x5b, 0x2d, 0x64, 0x43, 0xef, 0x03, 0x06, 0x7a, 0x74, 0xb3, 0xd0, 0x7d, 0xdc,
+  0xd0, 0x23, 0x2a, 0x8e, 0x99, 0xa2, 0x57, 0x81, 0x6d, 0xe7, 0x20, 0x2a, 0x67, 0xfd, 0x59, 0x71,
+  0x9e, 0xde, 0xae, 0x02, 0x8a, 0x91, 0x1d, 0x67, 0x14, 0xf0, 0x31, 0xea, 0x0f, 0x0c, 0x81, 0x9c,
+  0x57, 0x19, 0x66, 0x5d, 0x78, 0xd2, 0xa1, 0xe6, 0xe7, 0xf6, 0x43, 0xb9, 0x2f, 0x19, 0x87, 0x5f,
+  0x1c, 0xa0, 0xe4, 0xc3, 0xd5, 0x16, 0xa3, 0xd4, 0xae, 0xf5, 0xbd, 0x30, 0x69, 0x5f, 0x43, 0x00,
+  0xb5, 0x1c, 0x59, 0xcd, 0xb6, 0xb1, 0x29, 0x01, 0xef, 0xe3, 0xf3, 0x10, 0xfc, 0x67, 0xe9, 0x3c,
+  0xbe, 0xd5, 0x23, 0x8a, 0x2b, 0x41, 0x63, 0xd6, 0x66, 0x6c, 0x31, 0x3c, 0x54, 0x91, 0xd3, 0xfc,
+  0xe3, 0x9c, 0x56, 0x5c, 0x50, 0xf8, 0xe9, 0x47, 0x21, 0xa4, 0x82, 0xe2, 0xec, 0xc7, 0x5b, 0x27,
+  0xb2, 0xe6, 0xa4, 0xb3, 0xf2, 0x4a, 0x54, 0x23, 0x2b, 0xa4, 0x78, 0x1c, 0x19, 0xdb, 0xa2, 0x3f,
+  0x93, 0x7d, 0x0c, 0xb3, 0x6d, 0x9a, 0xa3, 0xff, 0xa8, 0xc8, 0xcb, 0xbd, 0x8a, 0x5e, 0x16, 0x2b,
+  0xee, 0x91, 0xb4, 0x27, 0x19, 0x97, 0x4b, 0x26, 0xa9, 0xe1, 0x6d, 0x20, 0x6d, 0x85, 0xb4, 0xcc,
+  0x70, 0x1a, 0x96, 0x5c, 0x8e, 0xef, 0x01, 0x79, 0xea, 0x41, 0x90, 0x9c, 0x47, 0x4d, 0xb7, 0xb6,
+  0x47, 0x4b, 0xd7, 0x4b, 0x33, 0x4c, 0xb2, 0x1e, 0xef, 0x1d, 0xe5, 0xeb, 0x05, 0xda, 0x6b, 0x64,
+  0x69, 0xd3, 0x8c, 0xd7, 0xac, 0xb5, 0x20, 0x17, 0x1c, 0x22, 0x2e, 0x43, 0xb6, 0x00, 0xb9, 0xbf,
+  0x83, 0x68, 0x18, 0x4d, 0xa5, 0x24, 0x00, 0x5d, 0x00, 0x00, 0x00, 0x01, 0x00, 0x40, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x26, 0x1e, 0xb0, 0x0d, 0xba, 0x06, 0x5f, 0xad, 0x2b, 0x52, 0xa0,
+  0xa4, 0x4e, 0x12, 0x40, 0xf5, 0x46, 0xbe, 0x5a, 0x0a, 0x2c, 0x03, 0xf4, 0xe1, 0x7c, 0x48, 0xc9,
+  0x45, 0x72, 0x59, 0xea, 0xd9, 0x7c, 0x36, 0x5c, 0x48, 0x02, 0x45, 0x4f, 0x10, 0x50, 0x27, 0xd8,
+  0x21, 0x6b, 0x3a, 0x50, 0xce, 0x94, 0xc1, 0xbc, 0x7f, 0xd8, 0xb4, 0xf5, 0xaf, 0x9e, 0xac, 0xb2,
+  0xd0, 0x77, 0xf1, 0x5b, 0xcf, 0x67, 0xd3, 0x32, 0xd0, 0x0a, 0x2b, 0x36, 0xc0, 0x92, 0xf2, 0x04,
+  0xad, 0x27, 0x46, 0x65, 0xb8, 0x0e, 0xb2, 0x86, 0x24, 0x08, 0x94, 0xf0, 0xfa, 0x9d, 0x73, 0x2d,
+  0x0c, 0x69, 0x31, 0xcc, 0x57, 0xc8, 0x7c, 0xe3, 0x2d, 0x95, 0xfc, 0xa5, 0xde, 0xe8, 0x64, 0x15,
+  0x18, 0xb5, 0xc2, 0x84, 0x9c, 0x09, 0x1f, 0x65, 0x2f, 0x69, 0xb7, 0x74, 0x7a, 0x88, 0xce, 0xc0,
+  0x7e, 0x57, 0x04, 0xa0, 0x79, 0xdc, 0x37, 0x66, 0x18, 0xd5, 0x14, 0xb2, 0x5e, 0x55, 0x2a, 0x2c,
+  0x73, 0x15, 0x8d, 0xf6, 0x82, 0x60, 0x74, 0xf1, 0x10, 0x27, 0xb5, 0x3a, 0x0c, 0xd2, 0x1c, 0x4e,
+  0xbe, 0xc2, 0xe0, 0xa8, 0x75, 0xfe, 0x2f, 0xa0, 0xc0, 0x49, 0xce, 0x57, 0xa3, 0xa6, 0xfd, 0xcc,
+  0xbd, 0xbd, 0x80, 0xca, 0xb6, 0x5e, 0x71, 0x3d, 0x72, 0xc9, 0x03, 0x20, 0xcf, 0x2e, 0xfc, 0x17,
+  0xdd, 0xee, 0x75, 0x5d, 0x15, 0xf0, 0x3e, 0x6f, 0x4f, 0x19, 0xea, 0x74, 0x83, 0x77, 0xda, 0x65,
+  0xed, 0x03, 0xec, 0x60, 0x22, 0xc1, 0x05, 0x8b, 0x42, 0x4e, 0x7a, 0x91, 0x17, 0x75, 0x8e, 0x16,
+  0x50, 0xb2, 0xdd, 0x9d, 0x5a, 0xb5, 0xb4, 0x34, 0x6d, 0x7b, 0x5b, 0xcf, 0xac, 0x6b, 0xdf, 0x8c,
+  0x55, 0xda, 0x5c, 0x14, 0xe3, 0x5c, 0x68, 0x65, 0x13, 0x2d, 0xdb, 0xa1, 0x52, 0xd6, 0x85, 0x3b,
+  0x19, 0xed, 0xa8, 0x6e, 0x1a, 0x99, 0x84, 0xeb, 0xd2, 0x69, 0x43, 0xdc, 0x17, 0xac, 0x59, 0xd7,
+  0x2c, 0x0f, 0x07, 0xd0, 0x8c, 0x34, 0x04, 0x7a, 0x71, 0xd3, 0x64, 0xe2, 0x79, 0x39, 0x63, 0x35,
+  0xfa, 0xb9, 0xf7, 0x43, 0xe8, 0x9d, 0xe0, 0xe8, 0xdc, 0xb4, 0x9f, 0x4e, 0xdd, 0x49, 0xc7, 0xa0,
+  0x90, 0x8c, 0x82, 0x80, 0x87, 0x7b, 0xe3, 0x48, 0x48, 0x8d, 0x81, 0xb8, 0xf8, 0x79, 0x90, 0x3f,
+  0xca, 0x3f, 0xd2, 0x8f, 0x77, 0xf1, 0x1f, 0xfc, 0x48, 0x9c, 0x89, 0x47, 0x32, 0x58, 0x27, 0xee,
+  0xda, 0x2c, 0xff, 0x51, 0x94, 0xa2, 0xb7, 0x3e, 0xaf, 0x3a, 0x80, 0x48, 0xfc, 0xaa, 0x05, 0x37,
+  0xd7, 0xec, 0xcc, 0x5e, 0x11, 0x4e, 0x57, 0x72, 0xec, 0x97, 0xc8, 0xe1, 0x4b, 0x74, 0x25, 0x42,
+  0x83, 0x1c, 0xaa, 0xa7, 0xc1, 0x45, 0x7d, 0xe2, 0xba, 0x4a, 0x88, 0xd8, 0x24, 0x0f, 0x0a, 0xb6,
+  0x92, 0xb7, 0x2f, 0x92, 0x6e, 0x2d, 0x33, 0x9d, 0x30, 0x5f, 0xbf, 0x5a, 0x99, 0xff, 0xc9, 0xb2,
+  0x52, 0xa1, 0x52, 0x3c, 0xf8, 0x38, 0x9a, 0x24, 0xd8, 0x31, 0xfa, 0xbf, 0xb5, 0x53, 0xea, 0xc4,
+  0x04, 0x55, 0xd4, 0x21, 0xc8, 0xbf, 0x45, 0x5c, 0xca, 0xcd, 0xea, 0xc0, 0xc0, 0x7e, 0x96, 0x13,
+  0xfb, 0x89, 0x8e, 0xec, 0x0c, 0x5a, 0x3c, 0xf1, 0x73, 0x6b, 0xef, 0xfc, 0x82, 0x96, 0xf0, 0x16,
+  0x5c, 0x57, 0x69, 0x13, 0xd6, 0x57, 0x80, 0xfa, 0x3c, 0xc8, 0x61, 0x0a, 0xf5, 0x3c, 0xd6, 0x66,
+  0x35, 0x4c, 0x34, 0xb8, 0x51, 0xdc, 0x06, 0xd7, 0x02, 0x18, 0xcf, 0x11, 0x7f, 0x0c, 0x2a, 0xfd,
+  0x76, 0x4d, 0x29, 0x1c, 0x1d, 0x18, 0x75, 0x2d, 0x4a, 0xcd, 0x6f, 0x3d, 0xbb, 0x93, 0xb4, 0x1b,
+  0x44, 0xc0, 0x86, 0x63, 0xd9, 0xb6, 0x54, 0x69, 0x67, 0x54, 0x6b, 0x70, 0x80, 0xdd, 0x9d, 0x62,
+  0x15, 0x30, 0x77, 0x59, 0xaa, 0x4c, 0xea, 0x80, 0x17, 0x3a, 0x07, 0xbb, 0xcf, 0x47, 0x22, 0x29,
+  0x9b, 0x85, 0x3b, 0xbc, 0x49, 0x7b, 0x28, 0xdd, 0x90, 0x08, 0x9c, 0x5f, 0x39, 0xcf, 0x8d, 0xd6,
+  0x32, 0x5b, 0x18, 0x59, 0xd3, 0x12, 0x3e, 0x09, 0x3b, 0x89, 0xff, 0x0e, 0x73, 0x01, 0xbc, 0xc8,
+  0x81, 0x01, 0xba, 0xb8, 0xe0, 0x4f, 0x21, 0x4c, 0x1a, 0x8f, 0x6f, 0xf6, 0xe2, 0x44, 0x6d, 0xb5,
+  0x95, 0xd8, 0x31, 0x13, 0x18, 0x70, 0x55, 0xe6, 0xcb, 0x6d, 0x0f, 0x84, 0x91, 0x50, 0x00, 0x5d,
+  0x00, 0x00, 0x00, 0x01, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x34, 0x68, 0x19,
+  0x74, 0x0e, 0x95, 0xda, 0xcf, 0x24, 0x3a, 0x31, 0x40, 0x72, 0xa2, 0xe3, 0x42, 0x2f, 0xef, 0x5d,
+  0x80, 0xb6, 0xa3, 0x85, 0x9a, 0xda, 0x29, 0x52, 0xca, 0xb0, 0x33, 0x71, 0x14, 0x93, 0xa3, 0x0d,
+  0x7c, 0x10, 0x80, 0xa4, 0x26, 0x5b, 0x0f, 0x8e, 0x63, 0x57, 0xc4, 0xc8, 0x4c, 0xd1, 0xd6, 0x78,
+  0xd4, 0x29, 0x40, 0x4a, 0x0f, 0xec, 0x47, 0x3e, 0xf6, 0x23, 0x0f, 0x48, 0xee, 0xd4, 0x19, 0x55,
+  0xe9, 0xf6, 0x7b, 0xc0, 0x57, 0xd3, 0x43, 0x9d, 0x1f, 0x9f, 0xf9, 0x3f, 0x13, 0xf0, 0x07, 0x81,
+  0x58, 0xd6, 0x3f, 0xed, 0xa9, 0x44, 0x69, 0xcb, 0x2c, 0xe4, 0x70, 0xbb, 0xff, 0xce, 0x58, 0xbf,
+  0x2a, 0xdf, 0xfc, 0x02, 0x19, 0x7f, 0x0a, 0x4a, 0x54, 0x02, 0x3f, 0xe5, 0x44, 0x4e, 0x1d, 0x34,
+  0xe9, 0xc6, 0x80, 0xd0, 0xcb, 0x08, 0xbb, 0x8b, 0x0b, 0x4d, 0x52, 0x3f, 0xd0, 0xab, 0x9e, 0x29,
+  0xf2, 0xf5, 0xd4, 0x0a, 0x3a, 0xc3, 0x3a, 0xbe, 0x71, 0x28, 0x7f, 0x48, 0x65, 0x22, 0xe2, 0x57,
+  0x14, 0x3d, 0x1f, 0x51, 0x41, 0xe1, 0xd2, 0x5f, 0x2c, 0x3a, 0xe5, 0xb8, 0x2c, 0x0d, 0x69, 0x2b,
+  0xb0, 0x32, 0x8b, 0x79, 0x06, 0x1e, 0xb6, 0xb3, 0xfb, 0x03, 0xe5, 0x06, 0x68, 0x33, 0x70, 0xd4,
+  0xe4, 0xef, 0x4c, 0x13, 0x01, 0x3a, 0x60, 0x14, 0xe3, 0xdf, 0xb0, 0x23, 0xbb, 0xd2, 0xe1, 0x44,
+  0x1c, 0x86, 0x75, 0xde, 0x3b, 0x62, 0xec, 0xac, 0xec, 0x28, 0x96, 0xc0, 0x67, 0x50, 0x69, 0x81,
+  0x00, 0x9c, 0x88, 0x4c, 0xd5, 0x0e, 0x35, 0x7b, 0xb5, 0x75, 0x79, 0xb8, 0x2f, 0xf1, 0x89, 0xf9,
+  0xf9, 0xf3, 0x1f, 0x0e, 0xe3, 0x38, 0xc1, 0xd2, 0xa5, 0x06, 0xe1, 0x26, 0xcf, 0xb9, 0xd0, 0x72,
+  0x16, 0x5e, 0xe6, 0xfd, 0x84, 0x86, 0x3f, 0x3f, 0xe2, 0xc3, 0x85, 0xd9, 0x56, 0x50, 0x15, 0x7a,
+  0x40, 0x72, 0x6f, 0x77, 0x72, 0x15, 0xa8, 0x12, 0x67, 0x64, 0x49, 0x14, 0x60, 0x87, 0x0e, 0xce,
+  0x2d, 0xaa, 0xe9, 0x57, 0x7f, 0xdb, 0x87, 0x83, 0x74, 0x64, 0xae, 0x54, 0x6d, 0x6a, 0xe8, 0xbf,
+  0xbb, 0xbd, 0x3f, 0x8c, 0xf2, 0xe2, 0x19, 0xda, 0x8c, 0x21, 0x93, 0xe7, 0xf0, 0x3d, 0x6b, 0x94,
+  0x61, 0xc4, 0xf2, 0xb5, 0x34, 0xb2, 0x5b, 0xbf, 0xdf, 0x53, 0xa7, 0x6c, 0x96, 0x80, 0xcd, 0xfa,
+  0xe6, 0x13, 0x78, 0x85, 0xa5, 0xe7, 0xf1, 0x26, 0xa2, 0x88, 0xa0, 0x43, 0x4e, 0x18, 0x83, 0x83,
+  0x08, 0xfe, 0x86, 0xb7, 0xa6, 0x97, 0x6e, 0x79, 0xe5, 0x85, 0xcc, 0x29, 0xa1, 0x93, 0xd9, 0x0b,
+  0x38, 0xc0, 0xfd, 0xbb, 0xa8, 0x8a, 0xc4, 0x7b, 0xc3, 0x7c, 0xa1, 0xb7, 0xca, 0xbe, 0x9a, 0x44,
+  0xd1, 0xf7, 0x84, 0xfe, 0x36, 0xe7, 0x04, 0x09, 0xbc, 0x82, 0xf3, 0x40, 0xb4, 0x45, 0xbc, 0x5a,
+  0x45, 0xf8, 0x4d, 0x26, 0xad, 0x62, 0x57, 0xb9, 0xcb, 0xd1, 0x17, 0x1c, 0x0f, 0xcd, 0x82, 0x07,
+  0xbe, 0xfd, 0xf5, 0x74, 0x2a, 0xc3, 0x0c, 0xe8, 0x7a, 0x78, 0x44, 0x7f, 0xf9, 0x69, 0x0a, 0xa2,
+  0x8d, 0x52, 0xb3, 0x0b, 0x28, 0x5e, 0x86, 0x0d, 0xf1, 0x29, 0xc7, 0xc4, 0xde, 0xd5, 0x47, 0x4c,
+  0xf0, 0x9e, 0x26, 0x96, 0x82, 0x9e, 0x72, 0x5a, 0xcb, 0x1e, 0x38, 0x72, 0xef, 0xd7, 0x5e, 0xe6,
+  0x91, 0x05, 0x11, 0xe6, 0xef, 0x44, 0x99, 0x82, 0x5d, 0x92, 0xbb, 0x60, 0x35, 0xf1, 0x19, 0xed,
+  0x83, 0xca, 0x1e, 0x89, 0xa3, 0xba, 0x3b, 0xfc, 0x64, 0x45, 0x9f, 0x03, 0x38, 0x9d, 0x6a, 0x6f,
+  0x4b, 0x94, 0x2d, 0x89, 0x26, 0x1b, 0x5d, 0x1a, 0x12, 0xef, 0xf2, 0x93, 0x48, 0xaf, 0x41, 0xd8,
+  0x43, 0xa9, 0xbe, 0x96, 0x6d, 0x90, 0x48, 0x4d, 0x40, 0xc9, 0x4d, 0x8d, 0x67, 0x07, 0x01, 0xfe,
+  0x15, 0x60, 0x4d, 0xee, 0xfd, 0x84, 0xd0, 0xe8, 0x04, 0x1f, 0x89, 0x2d, 0x84, 0x7d, 0x6d, 0x26,
+  0x1d, 0x10, 0x5e, 0x1e, 0xc9, 0xae, 0x64, 0x2a, 0xd4, 0x7e, 0xf1, 0x16, 0x9e, 0xd7, 0xc5, 0x97,
+  0x6a, 0x57, 0x27, 0xe2, 0x6d, 0xa1, 0x20, 0xee, 0x86, 0xd5, 0x71, 0xf4, 0x17, 0x0e, 0x6a, 0xbe,
+  0xd3, 0x78, 0xf4, 0x13, 0x2f, 0xb0, 0x7d, 0x9f, 0xc1, 0x91, 0x2a, 0xa6, 0x0d, 0x1c, 0x0c, 0x1a,
+  0xb2, 0xdc, 0x59, 0x79, 0xda, 0xe4, 0x29, 0xb7, 0xeb, 0xc3, 0xc6, 0xcc, 0x57, 0x5d, 0x4b, 0x3e,
+  0x5f, 0x05, 0x2e, 0xec, 0xdb, 0x3c, 0xf3, 0xf3, 0x24, 0x04, 0xd8, 0xaa, 0x2c, 0x69, 0xa3, 0xf7,
+  0x6b, 0x55, 0x2b, 0x12, 0x5a, 0x2f, 0x08, 0xe7, 0xbe, 0x29, 0x58, 0xf3, 0xe0, 0x9c, 0xb0, 0xcc,
+  0x11, 0xed, 0x61, 0xcd, 0x7a, 0x31, 0x54, 0x27, 0x99, 0x82, 0xbf, 0xa8, 0xd7, 0x1a, 0xdc, 0x56,
+  0xb7, 0xd7, 0xaa, 0x48, 0x3a, 0x6b, 0x0e, 0x52, 0x41, 0x32, 0x69, 0x3c, 0xe4, 0xe6, 0x00, 0x00,
+};
+
+#endif
@@ -4,6 +4,7 @@
 **/
 
 #include <PiPei.h>
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/ExtractGuidedSectionLib.h>
@@ -32,6 +33,179 @@ LzmaUefiDecompress (
   IN OUT VOID    *Scratch
   );
 
+/**
+  Returns the compressed chunk table that follows a chunked payload header.
+
+  @param[in] Header  The header of the chunked payload.
+
+  @return The ChunkCount + 1 offsets of the compressed chunks.
+**/
+STATIC
+CONST UINT32 *
+ParallelLzmaChunkOffsets (
+  IN CONST PARALLEL_LZMA_CHUNKED_HEADER  *Header
+  )
+{
+  return (CONST UINT32 *)(Header + 1);
+}
+
+/**
+  Retrieves the layout of a chunked parallel LZMA payload and validates it.
+
+  @param[in]  Source           The data of the GUIDed section.
+  @param[in]  SourceSize       The size, in bytes, of Source.
+  @param[out] ChunkCount       The number of chunks in the payload.
+  @param[out] DestinationSize  The size, in bytes, of the decompressed payload.
+  @param[out] ScratchSize      The size, in bytes, of the scratch buffer needed
+                               to decompress any one chunk.
+
+  @retval RETURN_SUCCESS            The payload is chunked and its layout was returned.
+  @retval RETURN_UNSUPPORTED        Source is not a chunked payload.
+  @retval RETURN_INVALID_PARAMETER  The chunk table or a chunk is corrupted.
+**/
+RETURN_STATUS
+EFIAPI
+ParallelLzmaChunkedGetInfo (
+  IN  CONST VOID  *Source,
+  IN  UINTN       SourceSize,
+  OUT UINT32      *ChunkCount,
+  OUT UINT32      *DestinationSize,
+  OUT UINT32      *ScratchSize
+  )
+{
+  CONST PARALLEL_LZMA_CHUNKED_HEADER  *Header;
+  CONST UINT32                        *Offsets;
+  UINT32                              Index;
+  UINT32                              ChunkDestinationSize;
+  UINT32                              ChunkScratchSize;
+  UINT32                              ExpectedSize;
+  RETURN_STATUS                       Status;
+
+  Header = (CONST PARALLEL_LZMA_CHUNKED_HEADER *)Source;
+  if ((SourceSize < sizeof (*Header)) || (ReadUnaligned32 (&Header->Signature) != PARALLEL_LZMA_CHUNKED_SIGNATURE)) {
+    return RETURN_UNSUPPORTED;
+  }
+
+  //
+  // The chunk table must fit in the section, and the chunk size must account
+  // for exactly ChunkCount chunks of output.
+  //
+  if ((Header->ChunkCount == 0) || (Header->ChunkSize == 0) ||
+      (Header->ChunkCount >= (SourceSize - sizeof (*Header)) / sizeof (UINT32)) ||
+      (MultU64x32 (Header->ChunkCount - 1, Header->ChunkSize) >= Header->DecompressedSize) ||
+      (MultU64x32 (Header->ChunkCount, Header->ChunkSize) < Header->DecompressedSize))
+  {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Offsets = ParallelLzmaChunkOffsets (Header);
+  if ((Offsets[0] < sizeof (*Header) + (Header->ChunkCount + 1) * sizeof (UINT32)) ||
+      (Offsets[Header->ChunkCount] > SourceSize))
+  {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  *ScratchSize = 0;
+  for (Index = 0; Index < Header->ChunkCount; Index++) {
+    if (Offsets[Index] >= Offsets[Index + 1]) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    Status = LzmaUefiDecompressGetInfo (
+               (CONST UINT8 *)Source + Offsets[Index],
+               Offsets[Index + 1] - Offsets[Index],
+               &ChunkDestinationSize,
+               &ChunkScratchSize
+               );
+    if (RETURN_ERROR (Status)) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    ExpectedSize = MIN (Header->ChunkSize, Header->DecompressedSize - Index * Header->ChunkSize);
+    if (ChunkDestinationSize != ExpectedSize) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    *ScratchSize = MAX (*ScratchSize, ChunkScratchSize);
+  }
+
+  *ChunkCount      = Header->ChunkCount;
+  *DestinationSize = Header->DecompressedSize;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Decompresses one chunk of a chunked parallel LZMA payload.
+
+  Source must have been validated with ParallelLzmaChunkedGetInfo (). Chunks
+  write disjoint parts of Destination and may be decompressed concurrently,
+  each with its own scratch buffer.
+
+  @param[in]  Source       The data of the GUIDed section.
+  @param[in]  ChunkIndex   The index of the chunk to decompress.
+  @param[out] Destination  The buffer receiving the whole decompressed payload.
+  @param[in]  Scratch      A scratch buffer of the size returned by
+                           ParallelLzmaChunkedGetInfo ().
+
+  @retval RETURN_SUCCESS            The chunk was decompressed.
+  @retval RETURN_INVALID_PARAMETER  The chunk is corrupted.
+**/
+RETURN_STATUS
+EFIAPI
+ParallelLzmaDecompressChunk (
+  IN  CONST VOID  *Source,
+  IN  UINT32      ChunkIndex,
+  OUT VOID        *Destination,
+  IN  VOID        *Scratch
+  )
+{
+  CONST PARALLEL_LZMA_CHUNKED_HEADER  *Header;
+  CONST UINT32                        *Offsets;
+
+  Header  = (CONST PARALLEL_LZMA_CHUNKED_HEADER *)Source;
+  Offsets = ParallelLzmaChunkOffsets (Header);
+  ASSERT (ChunkIndex < Header->ChunkCount);
+
+  return LzmaUefiDecompress (
+           (CONST UINT8 *)Source + Offsets[ChunkIndex],
+           Offsets[ChunkIndex + 1] - Offsets[ChunkIndex],
+           (UINT8 *)Destination + ChunkIndex * Header->ChunkSize,
+           Scratch
+           );
+}
+
+/**
+  Returns the decompressed and scratch sizes of the data of a GUIDed section,
+  which is either a chunked payload or a single LZMA stream.
+
+  @param[in]  Source           The data of the GUIDed section.
+  @param[in]  SourceSize       The size, in bytes, of Source.
+  @param[out] DestinationSize  The size, in bytes, of the decompressed data.
+  @param[out] ScratchSize      The size, in bytes, of the scratch buffer needed.
+
+  @retval RETURN_SUCCESS            The sizes were returned.
+  @retval RETURN_INVALID_PARAMETER  The data is corrupted.
+**/
+STATIC
+RETURN_STATUS
+ParallelLzmaGetInfo (
+  IN  CONST VOID  *Source,
+  IN  UINTN       SourceSize,
+  OUT UINT32      *DestinationSize,
+  OUT UINT32      *ScratchSize
+  )
+{
+  RETURN_STATUS  Status;
+  UINT32         ChunkCount;
+
+  Status = ParallelLzmaChunkedGetInfo (Source, SourceSize, &ChunkCount, DestinationSize, ScratchSize);
+  if (Status != RETURN_UNSUPPORTED) {
+    return Status;
+  }
+
+  return LzmaUefiDecompressGetInfo (Source, (UINT32)SourceSize, DestinationSize, ScratchSize);
+}
+
 /**
   Examines a GUIDed section and returns the size of the decoded buffer and the
   size of an optional scratch buffer required to actually decode the data in a GUIDed section.
@@ -89,7 +263,7 @@ ParallelLzmaGuidedSectionGetInfo (
     }
 
     *SectionAttribute = ((EFI_GUID_DEFINED_SECTION2 *)InputSection)->Attributes;
-    return LzmaUefiDecompressGetInfo (
+    return ParallelLzmaGetInfo (
              (UINT8 *)InputSection + ((EFI_GUID_DEFINED_SECTION2 *)InputSection)->DataOffset,
              SECTION2_SIZE (InputSection) - ((EFI_GUID_DEFINED_SECTION2 *)InputSection)->DataOffset,
              OutputBufferSize,
@@ -105,7 +279,7 @@ ParallelLzmaGuidedSectionGetInfo (
     }
 
     *SectionAttribute = ((EFI_GUID_DEFINED_SECTION *)InputSection)->Attributes;
-    return LzmaUefiDecompressGetInfo (
+    return ParallelLzmaGetInfo (
              (UINT8 *)InputSection + ((EFI_GUID_DEFINED_SECTION *)InputSection)->DataOffset,
              SECTION_SIZE (InputSection) - ((EFI_GUID_DEFINED_SECTION *)InputSection)->DataOffset,
              OutputBufferSize,
@@ -160,6 +334,11 @@ ParallelLzmaGuidedSectionExtraction (
   EFI_HOB_GUID_TYPE             *GuidHob;
   VOID                          *DataOffset;
   UINTN                         DataSize;
+  RETURN_STATUS                 Status;
+  UINT32                        ChunkCount;
+  UINT32                        DestinationSize;
+  UINT32                        ScratchSize;
+  UINT32                        Index;
 
   ASSERT (OutputBuffer != NULL);
   ASSERT (InputSection != NULL);
@@ -223,8 +402,25 @@ ParallelLzmaGuidedSectionExtraction (
 
   //
   // if we get here, no previously decompressed buffer was found, so passthru to LZMA decompress.
+  // A chunked payload is decompressed one chunk after the other.
   //
-  return LzmaUefiDecompress (DataOffset, DataSize, *OutputBuffer, ScratchBuffer);
+  Status = ParallelLzmaChunkedGetInfo (DataOffset, DataSize, &ChunkCount, &DestinationSize, &ScratchSize);
+  if (Status == RETURN_UNSUPPORTED) {
+    return LzmaUefiDecompress (DataOffset, DataSize, *OutputBuffer, ScratchBuffer);
+  }
+
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  for (Index = 0; Index < ChunkCount; Index++) {
+    Status = ParallelLzmaDecompressChunk (DataOffset, Index, *OutputBuffer, ScratchBuffer);
+    if (RETURN_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return RETURN_SUCCESS;
 }
 
 /**
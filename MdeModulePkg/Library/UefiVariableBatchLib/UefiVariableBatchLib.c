@@ -0,0 +1,224 @@
+/** @file -- UefiVariableBatchLib.c
+This library contains helper functions for reading and writing several UEFI
+variables at once through the VariableBatch protocol.
+
+Copyright (c) Microsoft Corporation.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+#include <Library/VariableBatchLib.h>
+
+/**
+  Execute a sequence of GetVariable () and SetVariable () operations.
+
+  The operations are executed in order. When the VariableBatch protocol is
+  installed they are handed to it, so that the variable driver can execute
+  them with as few transitions to MM as possible; otherwise each one is
+  executed with the matching runtime service.
+
+  This function must be called at boot time.
+
+  @param[in]      EntryCount    Number of entries in Entries.
+  @param[in, out] Entries       The operations to execute. The Status field of
+                                each entry receives the status of the operation.
+
+  @retval EFI_SUCCESS           All the operations have been executed.
+  @retval EFI_INVALID_PARAMETER Entries is NULL and EntryCount is not 0.
+
+**/
+EFI_STATUS
+EFIAPI
+ExecuteVariableBatch (
+  IN     UINTN                       EntryCount,
+  IN OUT EDKII_VARIABLE_BATCH_ENTRY  *Entries
+  )
+{
+  EFI_STATUS                     Status;
+  EDKII_VARIABLE_BATCH_PROTOCOL  *VariableBatch;
+  UINTN                          Index;
+
+  if ((Entries == NULL) && (EntryCount != 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = gBS->LocateProtocol (&gEdkiiVariableBatchProtocolGuid, NULL, (VOID **)&VariableBatch);
+  if (!EFI_ERROR (Status)) {
+    return VariableBatch->Execute (VariableBatch, EntryCount, Entries);
+  }
+
+  for (Index = 0; Index < EntryCount; Index++) {
+    switch (Entries[Index].Operation) {
+      case EdkiiVariableBatchGetVariable:
+        Entries[Index].Status = gRT->GetVariable (
+                                       Entries[Index].VariableName,
+                                       Entries[Index].VendorGuid,
+                                       &Entries[Index].Attributes,
+                                       &Entries[Index].DataSize,
+                                       Entries[Index].Data
+                                       );
+        break;
+
+      case EdkiiVariableBatchSetVariable:
+        Entries[Index].Status = gRT->SetVariable (
+                                       Entries[Index].VariableName,
+                                       Entries[Index].VendorGuid,
+                                       Entries[Index].Attributes,
+                                       Entries[Index].DataSize,
+                                       Entries[Index].Data
+                                       );
+        break;
+
+      default:
+        Entries[Index].Status = EFI_INVALID_PARAMETER;
+        break;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Read several UEFI variables, allocating a buffer for the data of each one.
+
+  This is the batched counterpart of GetVariable2 () in UefiLib. The sizes of
+  all the variables are queried with one batch and the data is read with a
+  second one.
+
+  @param[in]  VariableCount     Number of variables to read.
+  @param[in]  VariableNames     Names of the variables to read.
+  @param[in]  VendorGuids       Vendor GUIDs of the variables to read.
+  @param[out] Values            For each variable, a pool buffer holding its data,
+                                or NULL if it could not be read. The caller must
+                                free the buffers with FreePool ().
+  @param[out] Sizes             Optional. For each variable, the size of its data.
+  @param[out] Statuses          Optional. For each variable, the status of the read.
+
+  @retval EFI_SUCCESS           All the variables have been read.
+  @retval EFI_INVALID_PARAMETER VariableNames, VendorGuids or Values is NULL.
+  @retval EFI_OUT_OF_RESOURCES  There are not enough resources to run the batch.
+  @retval EFI_NOT_FOUND         At least one variable could not be read, the
+                                status of each read is in Statuses.
+
+**/
+EFI_STATUS
+EFIAPI
+GetVariableBatch2 (
+  IN  UINTN       VariableCount,
+  IN  CHAR16      **VariableNames,
+  IN  EFI_GUID    **VendorGuids,
+  OUT VOID        **Values,
+  OUT UINTN       *Sizes OPTIONAL,
+  OUT EFI_STATUS  *Statuses OPTIONAL
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_STATUS                  ReadStatus;
+  EDKII_VARIABLE_BATCH_ENTRY  *Entries;
+  UINTN                       *Map;
+  UINTN                       Index;
+  UINTN                       Pending;
+
+  if ((VariableNames == NULL) || (VendorGuids == NULL) || (Values == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (VariableCount == 0) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // The entries are followed by the index of the variable read by each entry
+  // of the second batch.
+  //
+  Entries = AllocateZeroPool (VariableCount * (sizeof (EDKII_VARIABLE_BATCH_ENTRY) + sizeof (UINTN)));
+  if (Entries == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Map = (UINTN *)(Entries + VariableCount);
+
+  //
+  // Query the size of every variable.
+  //
+  for (Index = 0; Index < VariableCount; Index++) {
+    Values[Index]               = NULL;
+    Entries[Index].Operation    = EdkiiVariableBatchGetVariable;
+    Entries[Index].VariableName = VariableNames[Index];
+    Entries[Index].VendorGuid   = VendorGuids[Index];
+  }
+
+  Status = ExecuteVariableBatch (VariableCount, Entries);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  //
+  // Allocate a buffer for each variable that exists and move its entry to
+  // the front, so that the second batch only reads those.
+  //
+  Pending = 0;
+  for (Index = 0; Index < VariableCount; Index++) {
+    ReadStatus = Entries[Index].Status;
+    if (ReadStatus == EFI_BUFFER_TOO_SMALL) {
+      Values[Index] = AllocatePool (Entries[Index].DataSize);
+      if (Values[Index] == NULL) {
+        ReadStatus = EFI_OUT_OF_RESOURCES;
+      } else {
+        CopyMem (&Entries[Pending], &Entries[Index], sizeof (EDKII_VARIABLE_BATCH_ENTRY));
+        Entries[Pending].Data = Values[Index];
+        Map[Pending]          = Index;
+        Pending++;
+      }
+    } else if (ReadStatus == EFI_SUCCESS) {
+      //
+      // A variable cannot hold zero bytes of data, treat it as not found.
+      //
+      ReadStatus = EFI_NOT_FOUND;
+    }
+
+    if (Sizes != NULL) {
+      Sizes[Index] = 0;
+    }
+
+    if (Statuses != NULL) {
+      Statuses[Index] = ReadStatus;
+    }
+
+    if (EFI_ERROR (ReadStatus) && (ReadStatus != EFI_BUFFER_TOO_SMALL)) {
+      Status = EFI_NOT_FOUND;
+    }
+  }
+
+  //
+  // Read the data of the variables that exist.
+  //
+  ReadStatus = ExecuteVariableBatch (Pending, Entries);
+  ASSERT_EFI_ERROR (ReadStatus);
+
+  for (Index = 0; Index < Pending; Index++) {
+    ReadStatus = Entries[Index].Status;
+    if (EFI_ERROR (ReadStatus)) {
+      FreePool (Values[Map[Index]]);
+      Values[Map[Index]] = NULL;
+      Status             = EFI_NOT_FOUND;
+    } else if (Sizes != NULL) {
+      Sizes[Map[Index]] = Entries[Index].DataSize;
+    }
+
+    if (Statuses != NULL) {
+      Statuses[Map[Index]] = ReadStatus;
+    }
+  }
+
+Done:
+  FreePool (Entries);
+  return Status;
+}
@@ -361,6 +361,18 @@ StopTerminalStateMachine (
   gBS->CloseEvent (TerminalDevice->TimerEvent);
   gBS->CloseEvent (TerminalDevice->TwoSecondTimeOut);
 
+  // MU_CHANGE [BEGIN] - Damage-tracked screen rendering
+  if (TerminalDevice->ShadowFlushEvent != NULL) {
+    gBS->CloseEvent (TerminalDevice->ShadowFlushEvent);
+    gBS->CloseEvent (TerminalDevice->ShadowExitBootServicesEvent);
+    TerminalDevice->ShadowFlushEvent            = NULL;
+    TerminalDevice->ShadowExitBootServicesEvent = NULL;
+  }
+
+  TerminalShadowFlush (TerminalDevice);
+  TerminalShadowReport (TerminalDevice);
+  // MU_CHANGE [END]
+
   gBS->RestoreTPL (OriginalTpl);
 }
 
@@ -412,6 +424,37 @@ StartTerminalStateMachine (
                   &TerminalDevice->TwoSecondTimeOut
                   );
   ASSERT_EFI_ERROR (Status);
+
+  // MU_CHANGE [BEGIN] - Damage-tracked screen rendering
+  if (PcdGet32 (PcdTerminalShadowFlushInterval) != 0) {
+    Status = gBS->CreateEvent (
+                    EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    TerminalShadowFlushNotify,
+                    TerminalDevice,
+                    &TerminalDevice->ShadowFlushEvent
+                    );
+    ASSERT_EFI_ERROR (Status);
+
+    Status = gBS->SetTimer (
+                    TerminalDevice->ShadowFlushEvent,
+                    TimerPeriodic,
+                    PcdGet32 (PcdTerminalShadowFlushInterval)
+                    );
+    ASSERT_EFI_ERROR (Status);
+
+    Status = gBS->CreateEventEx (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    TerminalShadowExitBootServicesNotify,
+                    TerminalDevice,
+                    &gEfiEventExitBootServicesGuid,
+                    &TerminalDevice->ShadowExitBootServicesEvent
+                    );
+    ASSERT_EFI_ERROR (Status);
+  }
+
+  // MU_CHANGE [END]
 }
 
 /**
@@ -870,6 +913,8 @@ FreeResources:
     FreePool (TerminalDevice->TerminalConsoleModeData);
   }
 
+  TerminalShadowFree (TerminalDevice); // MU_CHANGE
+
   FreePool (TerminalDevice);
 
 CloseProtocols:
@@ -1030,6 +1075,7 @@ TerminalDriverBindingStop (
         TerminalFreeNotifyList (&TerminalDevice->NotifyList);
         FreePool (TerminalDevice->DevicePath);
         FreePool (TerminalDevice->TerminalConsoleModeData);
+        TerminalShadowFree (TerminalDevice); // MU_CHANGE
         FreePool (TerminalDevice);
       }
     }
@@ -13,6 +13,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Uefi.h>
 
 #include <Guid/GlobalVariable.h>
+#include <Guid/EventGroup.h>
 #include <Guid/PcAnsi.h>
 #include <Guid/TtyTerm.h>
 #include <Guid/StatusCodeDataTypeVariable.h>
@@ -65,6 +66,17 @@ typedef struct {
 
 #define KEYBOARD_TIMER_INTERVAL  200000         // 0.02s
 
+// MU_CHANGE [BEGIN] - Damage-tracked screen rendering
+//
+// A character cell of the screen shadow. A cell whose Char is CHAR_NULL is
+// not known to be on the terminal and is always sent.
+//
+typedef struct {
+  CHAR16    Char;
+  UINT8     Attribute;
+} TERMINAL_SHADOW_CELL;
+// MU_CHANGE [END]
+
 #define TERMINAL_DEV_SIGNATURE  SIGNATURE_32 ('t', 'm', 'n', 'l')
 
 #define TERMINAL_CONSOLE_IN_EX_NOTIFY_SIGNATURE  SIGNATURE_32 ('t', 'm', 'e', 'n')
@@ -122,6 +134,49 @@ typedef struct {
   EFI_SIMPLE_TEXT_INPUT_EX_PROTOCOL    SimpleInputEx;
   LIST_ENTRY                           NotifyList;
   EFI_EVENT                            KeyNotifyProcessEvent;
+
+  // MU_CHANGE [BEGIN] - Damage-tracked screen rendering
+  //
+  // Bytes written to the serial port by OutputString() and TerminalShadowFlush().
+  //
+  UINTN    OutputBytes;
+
+  //
+  // When ShadowCells is not NULL, the ConOut functions only update the shadow
+  // of the screen, and TerminalShadowFlush() sends the cells that differ from
+  // the ones last sent to the terminal, kept in ShownCells.
+  //
+  TERMINAL_SHADOW_CELL    *ShadowCells;
+  TERMINAL_SHADOW_CELL    *ShownCells;
+  UINTN                   ShadowColumns;
+  UINTN                   ShadowRows;
+  BOOLEAN                 ShadowDirty;
+  BOOLEAN                 ShadowClearPending;
+  UINT8                   ShadowClearAttribute;
+  UINT8                   ShadowScrollAttribute;
+  UINTN                   ShadowScrollPending;
+  //
+  // TRUE while TerminalShadowFlush() sends an update, which it writes to the
+  // serial port below TPL_NOTIFY.
+  //
+  BOOLEAN                 ShadowFlushing;
+  //
+  // Cursor position and attribute of the terminal, -1 when not known.
+  //
+  INT32        ShownCursorColumn;
+  INT32        ShownCursorRow;
+  INT32        ShownAttribute;
+  EFI_EVENT    ShadowFlushEvent;
+  EFI_EVENT    ShadowExitBootServicesEvent;
+  //
+  // Bytes the ConOut calls since the last flush would have written without
+  // the shadow, and the totals of all the flushes.
+  //
+  UINTN     ShadowUnbufferedBytes;
+  UINT64    ShadowUnbufferedTotal;
+  UINT64    ShadowSentTotal;
+  UINTN     ShadowRedrawCount;
+  // MU_CHANGE [END]
 } TERMINAL_DEV;
 
 #define INPUT_STATE_DEFAULT              0x00
@@ -178,6 +233,13 @@ extern EFI_DRIVER_BINDING_PROTOCOL   gTerminalDriverBinding;
 extern EFI_COMPONENT_NAME_PROTOCOL   gTerminalComponentName;
 extern EFI_COMPONENT_NAME2_PROTOCOL  gTerminalComponentName2;
 
+// MU_CHANGE [BEGIN] - Damage-tracked screen rendering
+extern CHAR16  mSetAttributeString[];
+extern CHAR16  mClearScreenString[];
+extern CHAR16  mSetCursorPositionString[];
+extern CHAR16  mCursorForwardString[];
+// MU_CHANGE [END]
+
 /**
   The user Entry Point for module Terminal. The user code starts with this function.
 
@@ -1407,6 +1469,186 @@ TerminalIsValidEfiCntlChar (
   IN  CHAR16  CharC
   );
 
+// MU_CHANGE [BEGIN] - Damage-tracked screen rendering
+
+/**
+  Build the control sequence that sets an attribute on the terminal.
+
+  @param  Attribute    The attribute.
+
+  @return The control sequence, valid until the next call.
+
+**/
+CHAR16 *
+TerminalAttributeString (
+  IN  UINTN  Attribute
+  );
+
+/**
+  Build the control sequence that moves the terminal cursor.
+
+  @param  Column       The column to move the cursor to.
+  @param  Row          The row to move the cursor to.
+
+  @return The control sequence, valid until the next call.
+
+**/
+CHAR16 *
+TerminalCursorPositionString (
+  IN  UINTN  Column,
+  IN  UINTN  Row
+  );
+
+/**
+  Allocate the screen shadow for the current mode, if
+  PcdTerminalShadowFlushInterval enables it.
+
+  The terminal must show a blank screen in the current attribute, and its
+  cursor must be at the current cursor position.
+
+  @param  TerminalDevice       The terminal device.
+
+**/
+VOID
+TerminalShadowInitialize (
+  IN  TERMINAL_DEV  *TerminalDevice
+  );
+
+/**
+  Free the screen shadow. The ConOut functions write to the terminal again.
+
+  @param  TerminalDevice       The terminal device.
+
+**/
+VOID
+TerminalShadowFree (
+  IN  TERMINAL_DEV  *TerminalDevice
+  );
+
+/**
+  Send the damaged cells of the screen shadow to the terminal.
+
+  The update is collected at TPL_NOTIFY and written at the TPL of the caller.
+  If another flush is interrupted, this one returns at once and the interrupted
+  flush sends the update.
+
+  @param  TerminalDevice       The terminal device.
+
+  @retval EFI_SUCCESS          The terminal shows the screen shadow.
+  @retval others               The serial port failed to send the update.
+
+**/
+EFI_STATUS
+TerminalShadowFlush (
+  IN  TERMINAL_DEV  *TerminalDevice
+  );
+
+/**
+  Report the bytes the screen shadow saved since the terminal started.
+
+  @param  TerminalDevice       The terminal device.
+
+**/
+VOID
+TerminalShadowReport (
+  IN  TERMINAL_DEV  *TerminalDevice
+  );
+
+/**
+  Update the screen shadow with a string, the way OutputString() updates the
+  terminal.
+
+  @param  TerminalDevice       The terminal device.
+  @param  WString              The Null-terminated string to display.
+
+  @retval EFI_SUCCESS             The string is in the screen shadow.
+  @retval EFI_WARN_UNKNOWN_GLYPH  Some characters cannot be rendered and are
+                                  shown as '?'.
+  @retval EFI_DEVICE_ERROR        The serial port failed to send the update.
+
+**/
+EFI_STATUS
+TerminalShadowOutputString (
+  IN  TERMINAL_DEV  *TerminalDevice,
+  IN  CHAR16        *WString
+  );
+
+/**
+  Set the attribute used by the following updates of the screen shadow.
+
+  @param  TerminalDevice       The terminal device.
+  @param  Attribute            The attribute.
+
+  @retval EFI_SUCCESS          The attribute is set.
+  @retval EFI_DEVICE_ERROR     The serial port failed to send the update.
+
+**/
+EFI_STATUS
+TerminalShadowSetAttribute (
+  IN  TERMINAL_DEV  *TerminalDevice,
+  IN  UINTN         Attribute
+  );
+
+/**
+  Clear the screen shadow to the current background color.
+
+  @param  TerminalDevice       The terminal device.
+
+  @retval EFI_SUCCESS          The screen shadow is cleared.
+  @retval EFI_DEVICE_ERROR     The serial port failed to send the update.
+
+**/
+EFI_STATUS
+TerminalShadowClearScreen (
+  IN  TERMINAL_DEV  *TerminalDevice
+  );
+
+/**
+  Move the cursor of the screen shadow.
+
+  @param  TerminalDevice       The terminal device.
+  @param  Column               The column to move the cursor to.
+  @param  Row                  The row to move the cursor to.
+
+  @retval EFI_SUCCESS          The cursor is moved.
+  @retval EFI_DEVICE_ERROR     The serial port failed to send the update.
+
+**/
+EFI_STATUS
+TerminalShadowSetCursorPosition (
+  IN  TERMINAL_DEV  *TerminalDevice,
+  IN  UINTN         Column,
+  IN  UINTN         Row
+  );
+
+/**
+  Timer handler to send the damaged cells of the screen shadow.
+
+  @param  Event                    Indicates the event that invoke this function.
+  @param  Context                  Indicates the calling context.
+**/
+VOID
+EFIAPI
+TerminalShadowFlushNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  );
+
+/**
+  Send the damaged cells of the screen shadow before the OS takes over.
+
+  @param  Event                    Indicates the event that invoke this function.
+  @param  Context                  Indicates the calling context.
+**/
+VOID
+EFIAPI
+TerminalShadowExitBootServicesNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  );
+
+// MU_CHANGE [END]
+
 /**
   Check if the device supports hot-plug through its device path.
 
@@ -206,6 +206,13 @@ TerminalConOutOutputString (
     return EFI_UNSUPPORTED;
   }
 
+  // MU_CHANGE [BEGIN] - Damage-tracked screen rendering
+  if ((TerminalDevice->ShadowCells != NULL) && !TerminalDevice->OutputEscChar) {
+    return TerminalShadowOutputString (TerminalDevice, WString);
+  }
+
+  // MU_CHANGE [END]
+
   This->QueryMode (
           This,
           Mode->Mode,
@@ -263,6 +270,7 @@ TerminalConOutOutputString (
           goto OutputError;
         }
 
+        TerminalDevice->OutputBytes += Length; // MU_CHANGE
         break;
 
       case TerminalTypeVtUtf8:
@@ -277,6 +285,7 @@ TerminalConOutOutputString (
           goto OutputError;
         }
 
+        TerminalDevice->OutputBytes += Length; // MU_CHANGE
         break;
     }
 
@@ -336,6 +345,8 @@ TerminalConOutOutputString (
             if (EFI_ERROR (Status)) {
               goto OutputError;
             }
+
+            TerminalDevice->OutputBytes += Length; // MU_CHANGE
           }
         }
 
@@ -483,6 +494,15 @@ TerminalConOutSetMode (
     return EFI_UNSUPPORTED;
   }
 
+  // MU_CHANGE [BEGIN] - Damage-tracked screen rendering
+  //
+  // Set the mode on the terminal directly, then start a new screen shadow
+  // of the blank screen.
+  //
+  TerminalShadowFlush (TerminalDevice);
+  TerminalShadowFree (TerminalDevice);
+  // MU_CHANGE [END]
+
   //
   // Set the current mode
   //
@@ -505,6 +525,8 @@ TerminalConOutSetMode (
     return EFI_DEVICE_ERROR;
   }
 
+  TerminalShadowInitialize (TerminalDevice); // MU_CHANGE
+
   return EFI_SUCCESS;
 }
 
@@ -527,9 +549,6 @@ TerminalConOutSetAttribute (
   IN  UINTN                            Attribute
   )
 {
-  UINT8         ForegroundControl;
-  UINT8         BackgroundControl;
-  UINT8         BrightControl;
   INT32         SavedColumn;
   INT32         SavedRow;
   EFI_STATUS    Status;
@@ -558,100 +577,13 @@ TerminalConOutSetAttribute (
     return EFI_SUCCESS;
   }
 
-  //
-  //  convert Attribute value to terminal emulator
-  //  understandable foreground color
-  //
-  switch (Attribute & 0x07) {
-    case EFI_BLACK:
-      ForegroundControl = 30;
-      break;
-
-    case EFI_BLUE:
-      ForegroundControl = 34;
-      break;
-
-    case EFI_GREEN:
-      ForegroundControl = 32;
-      break;
-
-    case EFI_CYAN:
-      ForegroundControl = 36;
-      break;
-
-    case EFI_RED:
-      ForegroundControl = 31;
-      break;
-
-    case EFI_MAGENTA:
-      ForegroundControl = 35;
-      break;
-
-    case EFI_BROWN:
-      ForegroundControl = 33;
-      break;
-
-    default:
-
-    case EFI_LIGHTGRAY:
-      ForegroundControl = 37;
-      break;
-  }
-
-  //
-  //  bit4 of the Attribute indicates bright control
-  //  of terminal emulator.
-  //
-  BrightControl = (UINT8)((Attribute >> 3) & 1);
-
-  //
-  //  convert Attribute value to terminal emulator
-  //  understandable background color.
-  //
-  switch ((Attribute >> 4) & 0x07) {
-    case EFI_BLACK:
-      BackgroundControl = 40;
-      break;
-
-    case EFI_BLUE:
-      BackgroundControl = 44;
-      break;
-
-    case EFI_GREEN:
-      BackgroundControl = 42;
-      break;
-
-    case EFI_CYAN:
-      BackgroundControl = 46;
-      break;
-
-    case EFI_RED:
-      BackgroundControl = 41;
-      break;
-
-    case EFI_MAGENTA:
-      BackgroundControl = 45;
-      break;
-
-    case EFI_BROWN:
-      BackgroundControl = 43;
-      break;
-
-    default:
-
-    case EFI_LIGHTGRAY:
-      BackgroundControl = 47;
-      break;
+  // MU_CHANGE [BEGIN] - Damage-tracked screen rendering
+  if (TerminalDevice->ShadowCells != NULL) {
+    return TerminalShadowSetAttribute (TerminalDevice, Attribute);
   }
 
-  //
-  // terminal emulator's control sequence to set attributes
-  //
-  mSetAttributeString[BRIGHT_CONTROL_OFFSET]         = (CHAR16)('0' + BrightControl);
-  mSetAttributeString[FOREGROUND_CONTROL_OFFSET + 0] = (CHAR16)('0' + (ForegroundControl / 10));
-  mSetAttributeString[FOREGROUND_CONTROL_OFFSET + 1] = (CHAR16)('0' + (ForegroundControl % 10));
-  mSetAttributeString[BACKGROUND_CONTROL_OFFSET + 0] = (CHAR16)('0' + (BackgroundControl / 10));
-  mSetAttributeString[BACKGROUND_CONTROL_OFFSET + 1] = (CHAR16)('0' + (BackgroundControl % 10));
+  TerminalAttributeString (Attribute);
+  // MU_CHANGE [END]
 
   //
   // save current column and row
@@ -702,6 +634,13 @@ TerminalConOutClearScreen (
 
   TerminalDevice = TERMINAL_CON_OUT_DEV_FROM_THIS (This);
 
+  // MU_CHANGE [BEGIN] - Damage-tracked screen rendering
+  if (TerminalDevice->ShadowCells != NULL) {
+    return TerminalShadowClearScreen (TerminalDevice);
+  }
+
+  // MU_CHANGE [END]
+
   //
   //  control sequence for clear screen request
   //
@@ -770,6 +709,13 @@ TerminalConOutSetCursorPosition (
     return EFI_UNSUPPORTED;
   }
 
+  // MU_CHANGE [BEGIN] - Damage-tracked screen rendering
+  if (TerminalDevice->ShadowCells != NULL) {
+    return TerminalShadowSetCursorPosition (TerminalDevice, Column, Row);
+  }
+
+  // MU_CHANGE [END]
+
   //
   // control sequence to move the cursor
   //
@@ -792,11 +738,7 @@ TerminalConOutSetCursorPosition (
       String = L"";  // No cursor motion necessary
     }
   } else {
-    mSetCursorPositionString[ROW_OFFSET + 0]    = (CHAR16)('0' + ((Row + 1) / 10));
-    mSetCursorPositionString[ROW_OFFSET + 1]    = (CHAR16)('0' + ((Row + 1) % 10));
-    mSetCursorPositionString[COLUMN_OFFSET + 0] = (CHAR16)('0' + ((Column + 1) / 10));
-    mSetCursorPositionString[COLUMN_OFFSET + 1] = (CHAR16)('0' + ((Column + 1) % 10));
-    String                                      = mSetCursorPositionString;
+    String = TerminalCursorPositionString (Column, Row); // MU_CHANGE
   }
 
   TerminalDevice->OutputEscChar = TRUE;
@@ -826,8 +768,10 @@ TerminalConOutSetCursorPosition (
   @param Visible   If TRUE, the cursor is set to be visible,
                    If FALSE, the cursor is set to be invisible.
 
-  @retval EFI_SUCCESS      The request is valid.
-  @retval EFI_UNSUPPORTED  The terminal does not support cursor hidden.
+  @retval EFI_SUCCESS       The request is valid.
+  @retval EFI_UNSUPPORTED   The terminal does not support cursor hidden.
+  @retval EFI_DEVICE_ERROR  The serial port failed to send the damaged cells
+                            of the screen shadow.
 
 **/
 EFI_STATUS
@@ -837,10 +781,24 @@ TerminalConOutEnableCursor (
   IN  BOOLEAN                          Visible
   )
 {
+  TERMINAL_DEV  *TerminalDevice; // MU_CHANGE
+
   if (!Visible) {
     return EFI_UNSUPPORTED;
   }
 
+  // MU_CHANGE [BEGIN] - Damage-tracked screen rendering
+  //
+  // Send the damaged cells of the screen shadow, so that the terminal cursor
+  // shows where the cursor of the mode is.
+  //
+  TerminalDevice = TERMINAL_CON_OUT_DEV_FROM_THIS (This);
+  if (EFI_ERROR (TerminalShadowFlush (TerminalDevice))) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  // MU_CHANGE [END]
+
   return EFI_SUCCESS;
 }
 
@@ -943,3 +901,145 @@ TerminalIsValidEfiCntlChar (
 
   return FALSE;
 }
+
+// MU_CHANGE [BEGIN] - Damage-tracked screen rendering
+
+/**
+  Build the control sequence that sets an attribute on the terminal.
+
+  @param  Attribute    The attribute.
+
+  @return The control sequence, valid until the next call.
+
+**/
+CHAR16 *
+TerminalAttributeString (
+  IN  UINTN  Attribute
+  )
+{
+  UINT8  ForegroundControl;
+  UINT8  BackgroundControl;
+  UINT8  BrightControl;
+
+  //
+  //  convert Attribute value to terminal emulator
+  //  understandable foreground color
+  //
+  switch (Attribute & 0x07) {
+    case EFI_BLACK:
+      ForegroundControl = 30;
+      break;
+
+    case EFI_BLUE:
+      ForegroundControl = 34;
+      break;
+
+    case EFI_GREEN:
+      ForegroundControl = 32;
+      break;
+
+    case EFI_CYAN:
+      ForegroundControl = 36;
+      break;
+
+    case EFI_RED:
+      ForegroundControl = 31;
+      break;
+
+    case EFI_MAGENTA:
+      ForegroundControl = 35;
+      break;
+
+    case EFI_BROWN:
+      ForegroundControl = 33;
+      break;
+
+    default:
+
+    case EFI_LIGHTGRAY:
+      ForegroundControl = 37;
+      break;
+  }
+
+  //
+  //  bit4 of the Attribute indicates bright control
+  //  of terminal emulator.
+  //
+  BrightControl = (UINT8)((Attribute >> 3) & 1);
+
+  //
+  //  convert Attribute value to terminal emulator
+  //  understandable background color.
+  //
+  switch ((Attribute >> 4) & 0x07) {
+    case EFI_BLACK:
+      BackgroundControl = 40;
+      break;
+
+    case EFI_BLUE:
+      BackgroundControl = 44;
+      break;
+
+    case EFI_GREEN:
+      BackgroundControl = 42;
+      break;
+
+    case EFI_CYAN:
+      BackgroundControl = 46;
+      break;
+
+    case EFI_RED:
+      BackgroundControl = 41;
+      break;
+
+    case EFI_MAGENTA:
+      BackgroundControl = 45;
+      break;
+
+    case EFI_BROWN:
+      BackgroundControl = 43;
+      break;
+
+    default:
+
+    case EFI_LIGHTGRAY:
+      BackgroundControl = 47;
+      break;
+  }
+
+  //
+  // terminal emulator's control sequence to set attributes
+  //
+  mSetAttributeString[BRIGHT_CONTROL_OFFSET]         = (CHAR16)('0' + BrightControl);
+  mSetAttributeString[FOREGROUND_CONTROL_OFFSET + 0] = (CHAR16)('0' + (ForegroundControl / 10));
+  mSetAttributeString[FOREGROUND_CONTROL_OFFSET + 1] = (CHAR16)('0' + (ForegroundControl % 10));
+  mSetAttributeString[BACKGROUND_CONTROL_OFFSET + 0] = (CHAR16)('0' + (BackgroundControl / 10));
+  mSetAttributeString[BACKGROUND_CONTROL_OFFSET + 1] = (CHAR16)('0' + (BackgroundControl % 10));
+
+  return mSetAttributeString;
+}
+
+/**
+  Build the control sequence that moves the terminal cursor.
+
+  @param  Column       The column to move the cursor to.
+  @param  Row          The row to move the cursor to.
+
+  @return The control sequence, valid until the next call.
+
+**/
+CHAR16 *
+TerminalCursorPositionString (
+  IN  UINTN  Column,
+  IN  UINTN  Row
+  )
+{
+  mSetCursorPositionString[ROW_OFFSET + 0]    = (CHAR16)('0' + ((Row + 1) / 10));
+  mSetCursorPositionString[ROW_OFFSET + 1]    = (CHAR16)('0' + ((Row + 1) % 10));
+  mSetCursorPositionString[COLUMN_OFFSET + 0] = (CHAR16)('0' + ((Column + 1) / 10));
+  mSetCursorPositionString[COLUMN_OFFSET + 1] = (CHAR16)('0' + ((Column + 1) % 10));
+
+  return mSetCursorPositionString;
+}
+
+// MU_CHANGE [END]
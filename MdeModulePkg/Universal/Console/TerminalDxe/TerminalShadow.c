@@ -0,0 +1,1082 @@
+/** @file
+  Damage-tracked rendering of the terminal screen.
+
+  When PcdTerminalShadowFlushInterval is not zero, OutputString(), SetAttribute(),
+  SetCursorPosition() and ClearScreen() only update a shadow of the screen. A
+  periodic timer compares the shadow with the cells last sent to the terminal,
+  and sends the cells that differ as runs behind a single cursor move. The blank
+  end of a row is erased with one control sequence, and the screen is only
+  cleared when that is cheaper than updating it. A page that is redrawn with
+  mostly the same text, like a Setup Browser form, only sends what changed.
+
+  The update is collected at TPL_NOTIFY, where the shadow cannot change, and
+  written to the serial port at the TPL of the caller, a bounded chunk at a
+  time, so that the ConOut functions are not held off while the serial port
+  sends it.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "Terminal.h"
+
+//
+// Unchanged cells are sent again to join two runs of changed cells, when there
+// are no more of them than a cursor move costs.
+//
+#define TERMINAL_SHADOW_MAX_GAP  6
+
+//
+// Bytes collected at TPL_NOTIFY before they are written to the serial port.
+//
+#define TERMINAL_SHADOW_OUTPUT_LENGTH  512
+
+//
+// Room for the bytes of one step of the update: a cursor move, an attribute,
+// and a UTF-8 character or the erase of the end of a row.
+//
+#define TERMINAL_SHADOW_STEP_LENGTH  32
+
+#define TERMINAL_SHADOW_SAME_CELL(A, B)  (((A).Char == (B).Char) && ((A).Attribute == (B).Attribute))
+
+#define TERMINAL_SHADOW_HAS_ROOM(Output)  ((Output)->Length + TERMINAL_SHADOW_STEP_LENGTH <= TERMINAL_SHADOW_OUTPUT_LENGTH)
+
+CHAR16  mEraseLineString[]      = { ESC, '[', 'K', 0 };
+CHAR16  mLineFeedString[]       = { CHAR_LINEFEED, 0 };
+CHAR16  mCarriageReturnString[] = { CHAR_CARRIAGE_RETURN, 0 };
+CHAR16  mNewLineString[]        = { CHAR_CARRIAGE_RETURN, CHAR_LINEFEED, 0 };
+
+typedef struct {
+  TERMINAL_DEV    *TerminalDevice;
+  UINTN           Length;
+  UINT8           Buffer[TERMINAL_SHADOW_OUTPUT_LENGTH];
+} TERMINAL_SHADOW_OUTPUT;
+
+/**
+  Fill cells with blanks.
+
+  @param  Cells        The cells.
+  @param  Count        The number of cells.
+  @param  Attribute    The attribute of the blanks.
+
+**/
+STATIC
+VOID
+TerminalShadowFill (
+  OUT TERMINAL_SHADOW_CELL  *Cells,
+  IN  UINTN                 Count,
+  IN  UINTN                 Attribute
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Count; Index++) {
+    Cells[Index].Char      = L' ';
+    Cells[Index].Attribute = (UINT8)Attribute;
+  }
+}
+
+/**
+  Write the collected bytes to the serial port.
+
+  @param  Output       The collected bytes.
+
+  @retval EFI_SUCCESS  The bytes were written.
+  @retval others       The serial port failed to write them.
+
+**/
+STATIC
+EFI_STATUS
+TerminalShadowWrite (
+  IN OUT TERMINAL_SHADOW_OUTPUT  *Output
+  )
+{
+  TERMINAL_DEV  *TerminalDevice;
+  EFI_STATUS    Status;
+  UINTN         Length;
+
+  TerminalDevice = Output->TerminalDevice;
+  Length         = Output->Length;
+  Output->Length = 0;
+  if (Length == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Status                       = TerminalDevice->SerialIo->Write (TerminalDevice->SerialIo, &Length, Output->Buffer);
+  TerminalDevice->OutputBytes += Length;
+  return Status;
+}
+
+/**
+  Collect a string to write to the serial port, converted for the terminal
+  type the same way as OutputString() converts it.
+
+  The caller makes sure that the output has room for the string.
+
+  @param  Output       The collected bytes.
+  @param  String       The Null-terminated string.
+
+**/
+STATIC
+VOID
+TerminalShadowAppend (
+  IN OUT TERMINAL_SHADOW_OUTPUT  *Output,
+  IN     CONST CHAR16            *String
+  )
+{
+  TERMINAL_DEV  *TerminalDevice;
+  UTF8_CHAR     Utf8Char;
+  UINT8         ValidBytes;
+  CHAR8         GraphicChar;
+  CHAR8         AsciiChar;
+
+  TerminalDevice = Output->TerminalDevice;
+  for ( ; *String != CHAR_NULL; String++) {
+    if (TerminalDevice->TerminalType == TerminalTypeVtUtf8) {
+      UnicodeToUtf8 (*String, &Utf8Char, &ValidBytes);
+      ASSERT (Output->Length + ValidBytes <= TERMINAL_SHADOW_OUTPUT_LENGTH);
+      CopyMem (&Output->Buffer[Output->Length], &Utf8Char, ValidBytes);
+      Output->Length += ValidBytes;
+      continue;
+    }
+
+    //
+    // The shadow only holds the characters TerminalShadowGlyph() returns, and
+    // the control sequences are made of ESC and ASCII characters.
+    //
+    if (!TerminalIsValidTextGraphics (*String, &GraphicChar, &AsciiChar)) {
+      GraphicChar = (CHAR8)*String;
+      AsciiChar   = GraphicChar;
+    }
+
+    ASSERT (Output->Length < TERMINAL_SHADOW_OUTPUT_LENGTH);
+    Output->Buffer[Output->Length++] = (UINT8)((TerminalDevice->TerminalType == TerminalTypePcAnsi) ? GraphicChar : AsciiChar);
+  }
+}
+
+/**
+  Move the terminal cursor, unless it is already there.
+
+  @param  Output       The collected bytes.
+  @param  Column       The column to move the cursor to.
+  @param  Row          The row to move the cursor to.
+
+**/
+STATIC
+VOID
+TerminalShadowMoveCursor (
+  IN OUT TERMINAL_SHADOW_OUTPUT  *Output,
+  IN     UINTN                   Column,
+  IN     UINTN                   Row
+  )
+{
+  TERMINAL_DEV  *TerminalDevice;
+
+  TerminalDevice = Output->TerminalDevice;
+  if ((TerminalDevice->ShownCursorColumn == (INT32)Column) && (TerminalDevice->ShownCursorRow == (INT32)Row)) {
+    return;
+  }
+
+  //
+  // Going to the start of the same or the next row is cheaper with CR and LF.
+  // The terminal cursor is not on the last row, so LF does not scroll.
+  //
+  if ((Column == 0) && (TerminalDevice->ShownCursorRow == (INT32)Row)) {
+    TerminalShadowAppend (Output, mCarriageReturnString);
+  } else if ((Column == 0) && (TerminalDevice->ShownCursorRow >= 0) && (TerminalDevice->ShownCursorRow + 1 == (INT32)Row)) {
+    TerminalShadowAppend (Output, mNewLineString);
+  } else {
+    TerminalShadowAppend (Output, TerminalCursorPositionString (Column, Row));
+  }
+
+  TerminalDevice->ShownCursorColumn = (INT32)Column;
+  TerminalDevice->ShownCursorRow    = (INT32)Row;
+}
+
+/**
+  Set the terminal attribute, unless it is already set.
+
+  @param  Output       The collected bytes.
+  @param  Attribute    The attribute.
+
+**/
+STATIC
+VOID
+TerminalShadowSelectAttribute (
+  IN OUT TERMINAL_SHADOW_OUTPUT  *Output,
+  IN     UINTN                   Attribute
+  )
+{
+  TERMINAL_DEV  *TerminalDevice;
+
+  TerminalDevice = Output->TerminalDevice;
+  if (TerminalDevice->ShownAttribute == (INT32)Attribute) {
+    return;
+  }
+
+  TerminalShadowAppend (Output, TerminalAttributeString (Attribute));
+  TerminalDevice->ShownAttribute = (INT32)Attribute;
+}
+
+/**
+  Send a cell at the terminal cursor.
+
+  @param  Output       The collected bytes.
+  @param  Cell         The cell of the screen shadow.
+  @param  Shown        The cell last sent to the terminal.
+
+**/
+STATIC
+VOID
+TerminalShadowPaintCell (
+  IN OUT TERMINAL_SHADOW_OUTPUT  *Output,
+  IN     TERMINAL_SHADOW_CELL    *Cell,
+  OUT    TERMINAL_SHADOW_CELL    *Shown
+  )
+{
+  TERMINAL_DEV  *TerminalDevice;
+  CHAR16        String[2];
+
+  TerminalDevice = Output->TerminalDevice;
+  TerminalShadowSelectAttribute (Output, Cell->Attribute);
+
+  String[0] = Cell->Char;
+  String[1] = CHAR_NULL;
+  TerminalShadowAppend (Output, String);
+  *Shown = *Cell;
+
+  //
+  // Terminals differ in where the cursor goes after the last column, so the
+  // next cell always moves it.
+  //
+  TerminalDevice->ShownCursorColumn++;
+  if (TerminalDevice->ShownCursorColumn >= (INT32)TerminalDevice->ShadowColumns) {
+    TerminalDevice->ShownCursorColumn = -1;
+    TerminalDevice->ShownCursorRow    = -1;
+  }
+}
+
+/**
+  Check whether clearing the terminal screen sends fewer cells than updating it.
+
+  @param  TerminalDevice       The terminal device.
+
+  @retval TRUE                 Clear the screen, then send the cells that are not blank.
+  @retval FALSE                Send the cells that changed.
+
+**/
+STATIC
+BOOLEAN
+TerminalShadowClearIsCheaper (
+  IN  TERMINAL_DEV  *TerminalDevice
+  )
+{
+  TERMINAL_SHADOW_CELL  Blank;
+  UINTN                 Index;
+  UINTN                 Count;
+  UINTN                 Repaint;
+  UINTN                 Update;
+
+  Blank.Char      = L' ';
+  Blank.Attribute = TerminalDevice->ShadowClearAttribute;
+  Count           = TerminalDevice->ShadowColumns * TerminalDevice->ShadowRows;
+  Repaint         = StrLen (mClearScreenString);
+  Update          = 0;
+  for (Index = 0; Index < Count; Index++) {
+    if (!TERMINAL_SHADOW_SAME_CELL (TerminalDevice->ShadowCells[Index], Blank)) {
+      Repaint++;
+    }
+
+    if (!TERMINAL_SHADOW_SAME_CELL (TerminalDevice->ShadowCells[Index], TerminalDevice->ShownCells[Index])) {
+      Update++;
+    }
+  }
+
+  return (BOOLEAN)(Repaint < Update);
+}
+
+/**
+  Clear the terminal screen.
+
+  @param  Output       The collected bytes.
+
+**/
+STATIC
+VOID
+TerminalShadowFlushClear (
+  IN OUT TERMINAL_SHADOW_OUTPUT  *Output
+  )
+{
+  TERMINAL_DEV  *TerminalDevice;
+
+  TerminalDevice = Output->TerminalDevice;
+  TerminalShadowSelectAttribute (Output, TerminalDevice->ShadowClearAttribute);
+  TerminalShadowAppend (Output, mClearScreenString);
+  TerminalShadowFill (
+    TerminalDevice->ShownCells,
+    TerminalDevice->ShadowColumns * TerminalDevice->ShadowRows,
+    TerminalDevice->ShadowClearAttribute
+    );
+
+  //
+  // Some terminals move the cursor home when they clear the screen.
+  //
+  TerminalDevice->ShownCursorColumn = -1;
+  TerminalDevice->ShownCursorRow    = -1;
+}
+
+/**
+  Scroll the terminal screen by one of the lines scrolled in the screen shadow.
+
+  The terminal is expected to fill the new line with the current background
+  color. If it does not, the new line differs from the shadow and is sent.
+
+  @param  Output       The collected bytes.
+
+**/
+STATIC
+VOID
+TerminalShadowFlushScroll (
+  IN OUT TERMINAL_SHADOW_OUTPUT  *Output
+  )
+{
+  TERMINAL_DEV  *TerminalDevice;
+  UINTN         Columns;
+  UINTN         Rows;
+
+  TerminalDevice = Output->TerminalDevice;
+  Columns        = TerminalDevice->ShadowColumns;
+  Rows           = TerminalDevice->ShadowRows;
+
+  TerminalShadowMoveCursor (Output, 0, Rows - 1);
+  TerminalShadowSelectAttribute (Output, TerminalDevice->ShadowScrollAttribute);
+  TerminalShadowAppend (Output, mLineFeedString);
+
+  CopyMem (
+    TerminalDevice->ShownCells,
+    TerminalDevice->ShownCells + Columns,
+    (Rows - 1) * Columns * sizeof (TERMINAL_SHADOW_CELL)
+    );
+  TerminalShadowFill (
+    TerminalDevice->ShownCells + (Rows - 1) * Columns,
+    Columns,
+    TerminalDevice->ShadowScrollAttribute
+    );
+  TerminalDevice->ShadowScrollPending--;
+}
+
+/**
+  Send the changed cells of a row from a column on, while the output has room
+  for them.
+
+  @param  Output       The collected bytes.
+  @param  Row          The row.
+  @param  Column       The column to start at.
+
+  @return The column to go on from, or the number of columns if the row is done.
+
+**/
+STATIC
+UINTN
+TerminalShadowFlushRow (
+  IN OUT TERMINAL_SHADOW_OUTPUT  *Output,
+  IN     UINTN                   Row,
+  IN     UINTN                   Column
+  )
+{
+  TERMINAL_DEV          *TerminalDevice;
+  TERMINAL_SHADOW_CELL  *Cells;
+  TERMINAL_SHADOW_CELL  *Shown;
+  UINTN                 Columns;
+  UINTN                 BlankStart;
+  UINTN                 End;
+  UINTN                 Next;
+
+  TerminalDevice = Output->TerminalDevice;
+  Columns        = TerminalDevice->ShadowColumns;
+  Cells          = &TerminalDevice->ShadowCells[Row * Columns];
+  Shown          = &TerminalDevice->ShownCells[Row * Columns];
+
+  //
+  // Find the blanks at the end of the row, which can be erased at once.
+  //
+  BlankStart = Columns;
+  while ((BlankStart > 0) &&
+         (Cells[BlankStart - 1].Char == L' ') &&
+         (Cells[BlankStart - 1].Attribute == Cells[Columns - 1].Attribute))
+  {
+    BlankStart--;
+  }
+
+  while (Column < Columns) {
+    if (TERMINAL_SHADOW_SAME_CELL (Cells[Column], Shown[Column])) {
+      Column++;
+      continue;
+    }
+
+    if (!TERMINAL_SHADOW_HAS_ROOM (Output)) {
+      return Column;
+    }
+
+    if (Column >= BlankStart) {
+      TerminalShadowMoveCursor (Output, Column, Row);
+      TerminalShadowSelectAttribute (Output, Cells[Column].Attribute);
+      TerminalShadowAppend (Output, mEraseLineString);
+      CopyMem (&Shown[Column], &Cells[Column], (Columns - Column) * sizeof (TERMINAL_SHADOW_CELL));
+      return Columns;
+    }
+
+    //
+    // Send the run of changed cells, with the short runs of unchanged cells
+    // between them.
+    //
+    End = Column + 1;
+    for (Next = End; (Next < BlankStart) && (Next - End < TERMINAL_SHADOW_MAX_GAP); Next++) {
+      if (!TERMINAL_SHADOW_SAME_CELL (Cells[Next], Shown[Next])) {
+        End = Next + 1;
+      }
+    }
+
+    TerminalShadowMoveCursor (Output, Column, Row);
+    for ( ; Column < End; Column++) {
+      if (!TERMINAL_SHADOW_HAS_ROOM (Output)) {
+        return Column;
+      }
+
+      TerminalShadowPaintCell (Output, &Cells[Column], &Shown[Column]);
+    }
+  }
+
+  return Columns;
+}
+
+/**
+  Collect the update of the terminal from a row and column on, until the
+  output is full.
+
+  @param  Output       The collected bytes.
+  @param  Row          The row to start at. Returns the row to go on from.
+  @param  Column       The column to start at. Returns the column to go on from.
+
+  @retval TRUE         The rest of the update is collected.
+  @retval FALSE        The output is full.
+
+**/
+STATIC
+BOOLEAN
+TerminalShadowCollect (
+  IN OUT TERMINAL_SHADOW_OUTPUT  *Output,
+  IN OUT UINTN                   *Row,
+  IN OUT UINTN                   *Column
+  )
+{
+  TERMINAL_DEV                 *TerminalDevice;
+  EFI_SIMPLE_TEXT_OUTPUT_MODE  *Mode;
+
+  TerminalDevice = Output->TerminalDevice;
+  Mode           = TerminalDevice->SimpleTextOutput.Mode;
+
+  if (TerminalDevice->ShadowClearPending) {
+    TerminalDevice->ShadowClearPending = FALSE;
+    if (TerminalShadowClearIsCheaper (TerminalDevice)) {
+      TerminalShadowFlushClear (Output);
+      TerminalDevice->ShadowScrollPending = 0;
+    }
+  }
+
+  while (TerminalDevice->ShadowScrollPending > 0) {
+    if (!TERMINAL_SHADOW_HAS_ROOM (Output)) {
+      return FALSE;
+    }
+
+    TerminalShadowFlushScroll (Output);
+  }
+
+  while (*Row < TerminalDevice->ShadowRows) {
+    *Column = TerminalShadowFlushRow (Output, *Row, *Column);
+    if (*Column < TerminalDevice->ShadowColumns) {
+      return FALSE;
+    }
+
+    (*Row)++;
+    *Column = 0;
+  }
+
+  if (!TERMINAL_SHADOW_HAS_ROOM (Output)) {
+    return FALSE;
+  }
+
+  TerminalShadowSelectAttribute (Output, Mode->Attribute);
+  TerminalShadowMoveCursor (Output, Mode->CursorColumn, Mode->CursorRow);
+  return TRUE;
+}
+
+/**
+  Allocate the screen shadow for the current mode, if
+  PcdTerminalShadowFlushInterval enables it.
+
+  The terminal must show a blank screen in the current attribute, and its
+  cursor must be at the current cursor position.
+
+  @param  TerminalDevice       The terminal device.
+
+**/
+VOID
+TerminalShadowInitialize (
+  IN  TERMINAL_DEV  *TerminalDevice
+  )
+{
+  EFI_SIMPLE_TEXT_OUTPUT_MODE  *Mode;
+  UINTN                        Columns;
+  UINTN                        Rows;
+
+  TerminalShadowFree (TerminalDevice);
+
+  if (PcdGet32 (PcdTerminalShadowFlushInterval) == 0) {
+    return;
+  }
+
+  Mode    = TerminalDevice->SimpleTextOutput.Mode;
+  Columns = TerminalDevice->TerminalConsoleModeData[Mode->Mode].Columns;
+  Rows    = TerminalDevice->TerminalConsoleModeData[Mode->Mode].Rows;
+
+  TerminalDevice->ShownCells = AllocatePool (Columns * Rows * sizeof (TERMINAL_SHADOW_CELL));
+  if (TerminalDevice->ShownCells == NULL) {
+    return;
+  }
+
+  TerminalDevice->ShadowCells = AllocatePool (Columns * Rows * sizeof (TERMINAL_SHADOW_CELL));
+  if (TerminalDevice->ShadowCells == NULL) {
+    TerminalShadowFree (TerminalDevice);
+    return;
+  }
+
+  TerminalShadowFill (TerminalDevice->ShadowCells, Columns * Rows, Mode->Attribute);
+  TerminalShadowFill (TerminalDevice->ShownCells, Columns * Rows, Mode->Attribute);
+  TerminalDevice->ShadowColumns         = Columns;
+  TerminalDevice->ShadowRows            = Rows;
+  TerminalDevice->ShadowDirty           = FALSE;
+  TerminalDevice->ShadowClearPending    = FALSE;
+  TerminalDevice->ShadowScrollPending   = 0;
+  TerminalDevice->ShownCursorColumn     = Mode->CursorColumn;
+  TerminalDevice->ShownCursorRow        = Mode->CursorRow;
+  TerminalDevice->ShownAttribute        = Mode->Attribute;
+  TerminalDevice->ShadowUnbufferedBytes = 0;
+}
+
+/**
+  Free the screen shadow. The ConOut functions write to the terminal again.
+
+  @param  TerminalDevice       The terminal device.
+
+**/
+VOID
+TerminalShadowFree (
+  IN  TERMINAL_DEV  *TerminalDevice
+  )
+{
+  if (TerminalDevice->ShadowCells != NULL) {
+    FreePool (TerminalDevice->ShadowCells);
+    TerminalDevice->ShadowCells = NULL;
+  }
+
+  if (TerminalDevice->ShownCells != NULL) {
+    FreePool (TerminalDevice->ShownCells);
+    TerminalDevice->ShownCells = NULL;
+  }
+}
+
+/**
+  Send the damaged cells of the screen shadow to the terminal.
+
+  @param  TerminalDevice       The terminal device.
+
+  @retval EFI_SUCCESS          The terminal shows the screen shadow.
+  @retval others               The serial port failed to send the update.
+
+**/
+EFI_STATUS
+TerminalShadowFlush (
+  IN  TERMINAL_DEV  *TerminalDevice
+  )
+{
+  EFI_TPL                 OldTpl;
+  TERMINAL_SHADOW_OUTPUT  Output;
+  EFI_STATUS              Status;
+  BOOLEAN                 Done;
+  UINTN                   SentBytes;
+  UINTN                   Index;
+  UINTN                   Row;
+  UINTN                   Column;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  //
+  // A flush interrupted by this call also sends this update, because the
+  // shadow is dirty again when it finishes its pass.
+  //
+  if ((TerminalDevice->ShadowCells == NULL) || !TerminalDevice->ShadowDirty || TerminalDevice->ShadowFlushing) {
+    gBS->RestoreTPL (OldTpl);
+    return EFI_SUCCESS;
+  }
+
+  TerminalDevice->ShadowFlushing = TRUE;
+  SentBytes                      = TerminalDevice->OutputBytes;
+  Output.TerminalDevice          = TerminalDevice;
+  Output.Length                  = 0;
+  Status                         = EFI_SUCCESS;
+  Done                           = TRUE;
+  Row                            = 0;
+  Column                         = 0;
+
+  //
+  // ShownCells describes the terminal once the collected bytes are written,
+  // so the shadow may change while a chunk is written. A change marks the
+  // shadow dirty again, and the screen is compared once more.
+  //
+  while (TerminalDevice->ShadowCells != NULL) {
+    if (Done) {
+      if (!TerminalDevice->ShadowDirty) {
+        break;
+      }
+
+      TerminalDevice->ShadowDirty = FALSE;
+      Row                         = 0;
+      Column                      = 0;
+    }
+
+    Done = TerminalShadowCollect (&Output, &Row, &Column);
+
+    gBS->RestoreTPL (OldTpl);
+    Status = TerminalShadowWrite (&Output);
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  if (EFI_ERROR (Status) && (TerminalDevice->ShadowCells != NULL)) {
+    //
+    // The terminal may show part of the update only. Send every cell next time.
+    //
+    for (Index = 0; Index < TerminalDevice->ShadowColumns * TerminalDevice->ShadowRows; Index++) {
+      TerminalDevice->ShownCells[Index].Char = CHAR_NULL;
+    }
+
+    TerminalDevice->ShownCursorColumn = -1;
+    TerminalDevice->ShownCursorRow    = -1;
+    TerminalDevice->ShownAttribute    = -1;
+    TerminalDevice->ShadowDirty       = TRUE;
+  }
+
+  TerminalDevice->ShadowFlushing = FALSE;
+
+  SentBytes = TerminalDevice->OutputBytes - SentBytes;
+  DEBUG ((
+    DEBUG_VERBOSE,
+    "%a: Redraw sent %d bytes instead of %d\n",
+    __func__,
+    SentBytes,
+    TerminalDevice->ShadowUnbufferedBytes
+    ));
+
+  TerminalDevice->ShadowSentTotal       += SentBytes;
+  TerminalDevice->ShadowUnbufferedTotal += TerminalDevice->ShadowUnbufferedBytes;
+  TerminalDevice->ShadowUnbufferedBytes  = 0;
+  TerminalDevice->ShadowRedrawCount++;
+
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+/**
+  Report the bytes the screen shadow saved since the terminal started.
+
+  @param  TerminalDevice       The terminal device.
+
+**/
+VOID
+TerminalShadowReport (
+  IN  TERMINAL_DEV  *TerminalDevice
+  )
+{
+  if (TerminalDevice->ShadowRedrawCount == 0) {
+    return;
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: %d redraws sent %ld bytes instead of %ld\n",
+    __func__,
+    TerminalDevice->ShadowRedrawCount,
+    TerminalDevice->ShadowSentTotal,
+    TerminalDevice->ShadowUnbufferedTotal
+    ));
+}
+
+/**
+  Finish an update of the screen shadow.
+
+  The update is sent by the flush timer, unless the caller runs at a TPL that
+  keeps the timer from running or there is no timer.
+
+  @param  TerminalDevice       The terminal device.
+  @param  OldTpl               The TPL of the caller.
+
+  @retval EFI_SUCCESS          The update is done.
+  @retval EFI_DEVICE_ERROR     The serial port failed to send the update.
+
+**/
+STATIC
+EFI_STATUS
+TerminalShadowUpdated (
+  IN  TERMINAL_DEV  *TerminalDevice,
+  IN  EFI_TPL       OldTpl
+  )
+{
+  EFI_STATUS  Status;
+
+  TerminalDevice->ShadowDirty = TRUE;
+  gBS->RestoreTPL (OldTpl);
+
+  if ((OldTpl < TPL_CALLBACK) && (TerminalDevice->ShadowFlushEvent != NULL)) {
+    return EFI_SUCCESS;
+  }
+
+  Status = TerminalShadowFlush (TerminalDevice);
+  if (EFI_ERROR (Status)) {
+    REPORT_STATUS_CODE_WITH_DEVICE_PATH (
+      EFI_ERROR_CODE | EFI_ERROR_MINOR,
+      (EFI_PERIPHERAL_REMOTE_CONSOLE | EFI_P_EC_OUTPUT_ERROR),
+      TerminalDevice->DevicePath
+      );
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Convert a character to the glyph stored in the screen shadow.
+
+  @param  TerminalDevice       The terminal device.
+  @param  Char                 The character.
+  @param  Warning              Set to TRUE if the character cannot be rendered.
+  @param  Bytes                Returns the number of bytes OutputString()
+                               sends for the character.
+
+  @return The glyph, which moves the terminal cursor by one column.
+
+**/
+STATIC
+CHAR16
+TerminalShadowGlyph (
+  IN     TERMINAL_DEV  *TerminalDevice,
+  IN     CHAR16        Char,
+  IN OUT BOOLEAN       *Warning,
+  OUT    UINTN         *Bytes
+  )
+{
+  UTF8_CHAR  Utf8Char;
+  UINT8      ValidBytes;
+  CHAR8      AsciiChar;
+
+  //
+  // Control characters would move the terminal cursor differently from the
+  // cursor of the mode, so they are shown as blanks.
+  //
+  if (TerminalDevice->TerminalType == TerminalTypeVtUtf8) {
+    UnicodeToUtf8 (Char, &Utf8Char, &ValidBytes);
+    *Bytes = ValidBytes;
+    if ((Char < L' ') || (Char == DEL)) {
+      return L' ';
+    }
+
+    return Char;
+  }
+
+  *Bytes = 1;
+  if (TerminalIsValidTextGraphics (Char, NULL, NULL)) {
+    return Char;
+  }
+
+  AsciiChar = (CHAR8)Char;
+  if (TerminalIsValidAscii (AsciiChar) && (AsciiChar != DEL)) {
+    return (CHAR16)AsciiChar;
+  }
+
+  if (!TerminalIsValidEfiCntlChar (AsciiChar) && (AsciiChar != DEL)) {
+    *Warning = TRUE;
+    return L'?';
+  }
+
+  return L' ';
+}
+
+/**
+  Scroll the screen shadow up by one line.
+
+  @param  TerminalDevice       The terminal device.
+
+**/
+STATIC
+VOID
+TerminalShadowScroll (
+  IN  TERMINAL_DEV  *TerminalDevice
+  )
+{
+  UINTN  Columns;
+  UINTN  Rows;
+
+  Columns = TerminalDevice->ShadowColumns;
+  Rows    = TerminalDevice->ShadowRows;
+
+  CopyMem (
+    TerminalDevice->ShadowCells,
+    TerminalDevice->ShadowCells + Columns,
+    (Rows - 1) * Columns * sizeof (TERMINAL_SHADOW_CELL)
+    );
+  TerminalShadowFill (
+    TerminalDevice->ShadowCells + (Rows - 1) * Columns,
+    Columns,
+    TerminalDevice->SimpleTextOutput.Mode->Attribute
+    );
+
+  if (TerminalDevice->ShadowScrollPending < Rows) {
+    TerminalDevice->ShadowScrollPending++;
+  }
+
+  TerminalDevice->ShadowScrollAttribute = (UINT8)TerminalDevice->SimpleTextOutput.Mode->Attribute;
+}
+
+/**
+  Update the screen shadow with a string, the way OutputString() updates the
+  terminal.
+
+  @param  TerminalDevice       The terminal device.
+  @param  WString              The Null-terminated string to display.
+
+  @retval EFI_SUCCESS             The string is in the screen shadow.
+  @retval EFI_WARN_UNKNOWN_GLYPH  Some characters cannot be rendered and are
+                                  shown as '?'.
+  @retval EFI_DEVICE_ERROR        The serial port failed to send the update.
+
+**/
+EFI_STATUS
+TerminalShadowOutputString (
+  IN  TERMINAL_DEV  *TerminalDevice,
+  IN  CHAR16        *WString
+  )
+{
+  EFI_SIMPLE_TEXT_OUTPUT_MODE  *Mode;
+  TERMINAL_SHADOW_CELL         *Cell;
+  UINTN                        MaxColumn;
+  UINTN                        MaxRow;
+  UINTN                        Bytes;
+  BOOLEAN                      Warning;
+  EFI_TPL                      OldTpl;
+  EFI_STATUS                   Status;
+
+  Mode      = TerminalDevice->SimpleTextOutput.Mode;
+  MaxColumn = TerminalDevice->ShadowColumns;
+  MaxRow    = TerminalDevice->ShadowRows;
+  Warning   = FALSE;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  for ( ; *WString != CHAR_NULL; WString++) {
+    switch (*WString) {
+      case CHAR_BACKSPACE:
+        TerminalDevice->ShadowUnbufferedBytes++;
+        if (Mode->CursorColumn > 0) {
+          Mode->CursorColumn--;
+        }
+
+        break;
+
+      case CHAR_LINEFEED:
+        TerminalDevice->ShadowUnbufferedBytes++;
+        if (Mode->CursorRow < (INT32)(MaxRow - 1)) {
+          Mode->CursorRow++;
+        } else {
+          TerminalShadowScroll (TerminalDevice);
+        }
+
+        break;
+
+      case CHAR_CARRIAGE_RETURN:
+        TerminalDevice->ShadowUnbufferedBytes++;
+        Mode->CursorColumn = 0;
+        break;
+
+      default:
+        Cell            = &TerminalDevice->ShadowCells[Mode->CursorRow * MaxColumn + Mode->CursorColumn];
+        Cell->Char      = TerminalShadowGlyph (TerminalDevice, *WString, &Warning, &Bytes);
+        Cell->Attribute = (UINT8)Mode->Attribute;
+        TerminalDevice->ShadowUnbufferedBytes += Bytes;
+
+        if (Mode->CursorColumn < (INT32)(MaxColumn - 1)) {
+          Mode->CursorColumn++;
+        } else {
+          Mode->CursorColumn = 0;
+          if (Mode->CursorRow < (INT32)(MaxRow - 1)) {
+            Mode->CursorRow++;
+          }
+
+          if (TerminalDevice->TerminalType == TerminalTypeTtyTerm) {
+            TerminalDevice->ShadowUnbufferedBytes += 2;
+          }
+        }
+
+        break;
+    }
+  }
+
+  Status = TerminalShadowUpdated (TerminalDevice, OldTpl);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Warning) {
+    return EFI_WARN_UNKNOWN_GLYPH;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Set the attribute used by the following updates of the screen shadow.
+
+  @param  TerminalDevice       The terminal device.
+  @param  Attribute            The attribute.
+
+  @retval EFI_SUCCESS          The attribute is set.
+  @retval EFI_DEVICE_ERROR     The serial port failed to send the update.
+
+**/
+EFI_STATUS
+TerminalShadowSetAttribute (
+  IN  TERMINAL_DEV  *TerminalDevice,
+  IN  UINTN         Attribute
+  )
+{
+  EFI_TPL  OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  TerminalDevice->SimpleTextOutput.Mode->Attribute = (INT32)Attribute;
+  TerminalDevice->ShadowUnbufferedBytes          += StrLen (mSetAttributeString);
+
+  return TerminalShadowUpdated (TerminalDevice, OldTpl);
+}
+
+/**
+  Clear the screen shadow to the current background color.
+
+  @param  TerminalDevice       The terminal device.
+
+  @retval EFI_SUCCESS          The screen shadow is cleared.
+  @retval EFI_DEVICE_ERROR     The serial port failed to send the update.
+
+**/
+EFI_STATUS
+TerminalShadowClearScreen (
+  IN  TERMINAL_DEV  *TerminalDevice
+  )
+{
+  EFI_SIMPLE_TEXT_OUTPUT_MODE  *Mode;
+  EFI_TPL                      OldTpl;
+
+  Mode   = TerminalDevice->SimpleTextOutput.Mode;
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  TerminalShadowFill (
+    TerminalDevice->ShadowCells,
+    TerminalDevice->ShadowColumns * TerminalDevice->ShadowRows,
+    Mode->Attribute
+    );
+  TerminalDevice->ShadowClearPending     = TRUE;
+  TerminalDevice->ShadowClearAttribute   = (UINT8)Mode->Attribute;
+  TerminalDevice->ShadowScrollPending    = 0;
+  TerminalDevice->ShadowUnbufferedBytes += StrLen (mClearScreenString) + StrLen (mSetCursorPositionString);
+  Mode->CursorColumn                     = 0;
+  Mode->CursorRow                        = 0;
+
+  return TerminalShadowUpdated (TerminalDevice, OldTpl);
+}
+
+/**
+  Move the cursor of the screen shadow.
+
+  @param  TerminalDevice       The terminal device.
+  @param  Column               The column to move the cursor to.
+  @param  Row                  The row to move the cursor to.
+
+  @retval EFI_SUCCESS          The cursor is moved.
+  @retval EFI_DEVICE_ERROR     The serial port failed to send the update.
+
+**/
+EFI_STATUS
+TerminalShadowSetCursorPosition (
+  IN  TERMINAL_DEV  *TerminalDevice,
+  IN  UINTN         Column,
+  IN  UINTN         Row
+  )
+{
+  EFI_SIMPLE_TEXT_OUTPUT_MODE  *Mode;
+  EFI_TPL                      OldTpl;
+
+  Mode   = TerminalDevice->SimpleTextOutput.Mode;
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  //
+  // Count the bytes TerminalConOutSetCursorPosition() would send.
+  //
+  if ((TerminalDevice->TerminalType == TerminalTypeTtyTerm) && ((UINTN)Mode->CursorRow == Row)) {
+    if ((UINTN)Mode->CursorColumn != Column) {
+      TerminalDevice->ShadowUnbufferedBytes += StrLen (mCursorForwardString);
+    }
+  } else {
+    TerminalDevice->ShadowUnbufferedBytes += StrLen (mSetCursorPositionString);
+  }
+
+  Mode->CursorColumn = (INT32)Column;
+  Mode->CursorRow    = (INT32)Row;
+
+  return TerminalShadowUpdated (TerminalDevice, OldTpl);
+}
+
+/**
+  Timer handler to send the damaged cells of the screen shadow.
+
+  @param  Event                    Indicates the event that invoke this function.
+  @param  Context                  Indicates the calling context.
+**/
+VOID
+EFIAPI
+TerminalShadowFlushNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  TerminalShadowFlush ((TERMINAL_DEV *)Context);
+}
+
+/**
+  Send the damaged cells of the screen shadow before the OS takes over.
+
+  @param  Event                    Indicates the event that invoke this function.
+  @param  Context                  Indicates the calling context.
+**/
+VOID
+EFIAPI
+TerminalShadowExitBootServicesNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  TerminalShadowFlush ((TERMINAL_DEV *)Context);
+  TerminalShadowReport ((TERMINAL_DEV *)Context);
+}
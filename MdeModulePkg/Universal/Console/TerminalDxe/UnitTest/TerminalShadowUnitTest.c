@@ -0,0 +1,1014 @@
+/** @file -- TerminalShadowUnitTest.c
+  Host based unit tests for the damage-tracked screen rendering of the terminal
+  driver.
+
+  The terminal driver writes to a mock serial port, which runs the bytes
+  through a model of a VT100 screen. After a flush, the model must show the
+  screen shadow, and the driver must know it does. The mock serial port also
+  records the TPL of the writes, and can fail a write or change the screen
+  while a flush writes a chunk.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../Terminal.h"
+
+#define UNIT_TEST_APP_NAME     "Terminal Shadow Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define TEST_COLUMNS  80
+#define TEST_ROWS     25
+
+//
+// The flush timer is never signaled. The tests flush the shadow themselves.
+//
+#define MOCK_FLUSH_EVENT  ((EFI_EVENT)(UINTN)1)
+
+#define TEST_TEXT_ATTRIBUTE   EFI_TEXT_ATTR (EFI_LIGHTGRAY, EFI_BLACK)
+#define TEST_TITLE_ATTRIBUTE  EFI_TEXT_ATTR (EFI_WHITE, EFI_BLUE)
+
+typedef struct {
+  //
+  // The screen of the terminal.
+  //
+  TERMINAL_SHADOW_CELL    Cells[TEST_ROWS][TEST_COLUMNS];
+  UINTN                   Column;
+  UINTN                   Row;
+  UINT8                   Attribute;
+  //
+  // The control sequence and the UTF-8 character being received.
+  //
+  CHAR8                   Sequence[16];
+  UINTN                   SequenceLength;
+  CHAR16                  Utf8Char;
+  UINTN                   Utf8Left;
+  //
+  // What the terminal received.
+  //
+  UINTN                   Bytes;
+  UINTN                   Writes;
+  UINTN                   LargestWrite;
+  UINTN                   Clears;
+  UINTN                   Scrolls;
+  EFI_TPL                 HighestWriteTpl;
+  //
+  // Status of the next write, which writes nothing if it is an error.
+  //
+  EFI_STATUS              WriteStatus;
+  //
+  // Called once after the next write.
+  //
+  VOID                    (*WriteHook)(
+    VOID
+    );
+} MOCK_TERMINAL;
+
+EFI_BOOT_SERVICES  MockBoot;
+
+STATIC EFI_TPL                     mMockTpl = TPL_APPLICATION;
+STATIC MOCK_TERMINAL               mMockTerminal;
+STATIC EFI_SERIAL_IO_PROTOCOL      mMockSerialIo;
+STATIC TERMINAL_DEV                *mTerminal;
+STATIC TERMINAL_CONSOLE_MODE_DATA  mModeData[] = {
+  { TEST_COLUMNS, TEST_ROWS }
+};
+
+//
+// The terminal type of each test run.
+//
+STATIC TERMINAL_TYPE  mVt100  = TerminalTypeVt100;
+STATIC TERMINAL_TYPE  mVtUtf8 = TerminalTypeVtUtf8;
+
+/**
+  Raise the TPL of the mock boot services.
+
+  @param[in]  NewTpl  The new TPL.
+
+  @return The previous TPL.
+**/
+STATIC
+EFI_TPL
+EFIAPI
+MockRaiseTpl (
+  IN EFI_TPL  NewTpl
+  )
+{
+  EFI_TPL  OldTpl;
+
+  ASSERT (NewTpl >= mMockTpl);
+  OldTpl   = mMockTpl;
+  mMockTpl = NewTpl;
+  return OldTpl;
+}
+
+/**
+  Restore the TPL of the mock boot services.
+
+  @param[in]  OldTpl  The TPL to restore.
+**/
+STATIC
+VOID
+EFIAPI
+MockRestoreTpl (
+  IN EFI_TPL  OldTpl
+  )
+{
+  ASSERT (OldTpl <= mMockTpl);
+  mMockTpl = OldTpl;
+}
+
+/**
+  The terminal only reads input from its timer, which the tests do not run.
+
+  @param  TerminalDevice       Terminal driver private structure.
+  @param  Output               The key will be removed.
+
+  @retval FALSE                The FIFO is empty.
+**/
+BOOLEAN
+RawFiFoRemoveOneKey (
+  TERMINAL_DEV  *TerminalDevice,
+  UINT8         *Output
+  )
+{
+  return FALSE;
+}
+
+/**
+  The terminal only reads input from its timer, which the tests do not run.
+
+  @param  TerminalDevice       Terminal driver private structure.
+
+  @retval TRUE                 The FIFO is empty.
+**/
+BOOLEAN
+IsRawFiFoEmpty (
+  TERMINAL_DEV  *TerminalDevice
+  )
+{
+  return TRUE;
+}
+
+/**
+  The terminal only reads input from its timer, which the tests do not run.
+
+  @param  TerminalDevice       Terminal driver private structure.
+  @param  Input                The key.
+
+  @retval FALSE                The key is lost.
+**/
+BOOLEAN
+UnicodeFiFoInsertOneKey (
+  TERMINAL_DEV  *TerminalDevice,
+  UINT16        Input
+  )
+{
+  return FALSE;
+}
+
+/**
+  The terminal only reads input from its timer, which the tests do not run.
+
+  @param  TerminalDevice       Terminal driver private structure.
+
+  @retval TRUE                 The FIFO is full.
+**/
+BOOLEAN
+IsUnicodeFiFoFull (
+  TERMINAL_DEV  *TerminalDevice
+  )
+{
+  return TRUE;
+}
+
+/**
+  Fill cells of the model screen with blanks.
+
+  @param[in]  Row     The row of the first cell.
+  @param[in]  Column  The column of the first cell.
+  @param[in]  Count   The number of cells.
+**/
+STATIC
+VOID
+ModelErase (
+  IN UINTN  Row,
+  IN UINTN  Column,
+  IN UINTN  Count
+  )
+{
+  TERMINAL_SHADOW_CELL  *Cell;
+
+  for (Cell = &mMockTerminal.Cells[Row][Column]; Count > 0; Cell++, Count--) {
+    Cell->Char      = L' ';
+    Cell->Attribute = mMockTerminal.Attribute;
+  }
+}
+
+/**
+  Move the cursor of the model screen to the next line, scrolling the screen
+  at the last line.
+**/
+STATIC
+VOID
+ModelLineFeed (
+  VOID
+  )
+{
+  if (mMockTerminal.Row < TEST_ROWS - 1) {
+    mMockTerminal.Row++;
+    return;
+  }
+
+  CopyMem (mMockTerminal.Cells[0], mMockTerminal.Cells[1], sizeof (mMockTerminal.Cells[0]) * (TEST_ROWS - 1));
+  ModelErase (TEST_ROWS - 1, 0, TEST_COLUMNS);
+  mMockTerminal.Scrolls++;
+}
+
+/**
+  Show a character at the cursor of the model screen. The cursor stays after
+  the last column until the next character wraps it.
+
+  @param[in]  Char  The character.
+**/
+STATIC
+VOID
+ModelPutChar (
+  IN CHAR16  Char
+  )
+{
+  if (mMockTerminal.Column >= TEST_COLUMNS) {
+    mMockTerminal.Column = 0;
+    ModelLineFeed ();
+  }
+
+  mMockTerminal.Cells[mMockTerminal.Row][mMockTerminal.Column].Char      = Char;
+  mMockTerminal.Cells[mMockTerminal.Row][mMockTerminal.Column].Attribute = mMockTerminal.Attribute;
+  mMockTerminal.Column++;
+}
+
+/**
+  Run a control sequence on the model screen.
+**/
+STATIC
+VOID
+ModelControlSequence (
+  VOID
+  )
+{
+  //
+  // The EFI colors of the ANSI colors.
+  //
+  STATIC CONST UINT8  Colors[] = {
+    EFI_BLACK, EFI_RED, EFI_GREEN, EFI_BROWN, EFI_BLUE, EFI_MAGENTA, EFI_CYAN, EFI_LIGHTGRAY
+  };
+  UINTN               Parameters[4];
+  UINTN               Count;
+  UINTN               Index;
+  CHAR8               Final;
+
+  ZeroMem (Parameters, sizeof (Parameters));
+  Count = 0;
+  for (Index = 2; Index < mMockTerminal.SequenceLength - 1; Index++) {
+    if (mMockTerminal.Sequence[Index] == ';') {
+      Count++;
+    } else if (Count < ARRAY_SIZE (Parameters)) {
+      Parameters[Count] = Parameters[Count] * 10 + (mMockTerminal.Sequence[Index] - '0');
+    }
+  }
+
+  Final = mMockTerminal.Sequence[mMockTerminal.SequenceLength - 1];
+  switch (Final) {
+    case 'H':
+      mMockTerminal.Row    = Parameters[0] - 1;
+      mMockTerminal.Column = Parameters[1] - 1;
+      break;
+
+    case 'K':
+      if (mMockTerminal.Column < TEST_COLUMNS) {
+        ModelErase (mMockTerminal.Row, mMockTerminal.Column, TEST_COLUMNS - mMockTerminal.Column);
+      }
+
+      break;
+
+    case 'J':
+      ModelErase (0, 0, TEST_ROWS * TEST_COLUMNS);
+      mMockTerminal.Row    = 0;
+      mMockTerminal.Column = 0;
+      mMockTerminal.Clears++;
+      break;
+
+    case 'm':
+      if (Parameters[0] <= 1) {
+        mMockTerminal.Attribute = (UINT8)((mMockTerminal.Attribute & ~EFI_BRIGHT) | (Parameters[0] * EFI_BRIGHT));
+      } else if ((Parameters[0] >= 30) && (Parameters[0] <= 37)) {
+        mMockTerminal.Attribute = (UINT8)((mMockTerminal.Attribute & ~0x07) | Colors[Parameters[0] - 30]);
+      } else if ((Parameters[0] >= 40) && (Parameters[0] <= 47)) {
+        mMockTerminal.Attribute = (UINT8)((mMockTerminal.Attribute & 0x0F) | (Colors[Parameters[0] - 40] << 4));
+      }
+
+      break;
+
+    default:
+      ASSERT (FALSE);
+  }
+}
+
+/**
+  Receive a byte on the model screen.
+
+  @param[in]  Byte  The byte.
+**/
+STATIC
+VOID
+ModelReceive (
+  IN UINT8  Byte
+  )
+{
+  if (mMockTerminal.SequenceLength > 0) {
+    ASSERT (mMockTerminal.SequenceLength < sizeof (mMockTerminal.Sequence));
+    mMockTerminal.Sequence[mMockTerminal.SequenceLength++] = (CHAR8)Byte;
+    if ((mMockTerminal.SequenceLength > 2) && (Byte >= 0x40)) {
+      ModelControlSequence ();
+      mMockTerminal.SequenceLength = 0;
+    }
+
+    return;
+  }
+
+  if (mMockTerminal.Utf8Left > 0) {
+    mMockTerminal.Utf8Char = (CHAR16)((mMockTerminal.Utf8Char << 6) | (Byte & 0x3F));
+    if (--mMockTerminal.Utf8Left == 0) {
+      ModelPutChar (mMockTerminal.Utf8Char);
+    }
+
+    return;
+  }
+
+  if (Byte == ESC) {
+    mMockTerminal.Sequence[0]    = (CHAR8)Byte;
+    mMockTerminal.SequenceLength = 1;
+  } else if (Byte == CHAR_CARRIAGE_RETURN) {
+    mMockTerminal.Column = 0;
+  } else if (Byte == CHAR_LINEFEED) {
+    ModelLineFeed ();
+  } else if (Byte >= 0xE0) {
+    mMockTerminal.Utf8Char = Byte & 0x0F;
+    mMockTerminal.Utf8Left = 2;
+  } else if (Byte >= 0xC0) {
+    mMockTerminal.Utf8Char = Byte & 0x1F;
+    mMockTerminal.Utf8Left = 1;
+  } else {
+    ModelPutChar (Byte);
+  }
+}
+
+/**
+  Write bytes to the model screen.
+
+  @param  This              Protocol instance pointer.
+  @param  BufferSize        On input, the size of the Buffer. On output, the amount of
+                            data actually written.
+  @param  Buffer            The buffer of data to write
+
+  @retval EFI_SUCCESS       The data was written.
+  @retval others            The status set by the test, nothing was written.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockSerialWrite (
+  IN EFI_SERIAL_IO_PROTOCOL  *This,
+  IN OUT UINTN               *BufferSize,
+  IN VOID                    *Buffer
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  VOID        (*Hook)(
+    VOID
+    );
+
+  mMockTerminal.HighestWriteTpl = MAX (mMockTerminal.HighestWriteTpl, mMockTpl);
+
+  Status                    = mMockTerminal.WriteStatus;
+  mMockTerminal.WriteStatus = EFI_SUCCESS;
+  if (EFI_ERROR (Status)) {
+    *BufferSize = 0;
+    return Status;
+  }
+
+  for (Index = 0; Index < *BufferSize; Index++) {
+    ModelReceive (((UINT8 *)Buffer)[Index]);
+  }
+
+  mMockTerminal.Bytes       += *BufferSize;
+  mMockTerminal.LargestWrite = MAX (mMockTerminal.LargestWrite, *BufferSize);
+  mMockTerminal.Writes++;
+
+  Hook                    = mMockTerminal.WriteHook;
+  mMockTerminal.WriteHook = NULL;
+  if (Hook != NULL) {
+    Hook ();
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Check that the model screen shows the screen shadow and the cursor of the
+  mode, and that the terminal driver knows what the screen shows.
+
+  @retval UNIT_TEST_PASSED  The screens match.
+**/
+STATIC
+UNIT_TEST_STATUS
+CheckScreen (
+  VOID
+  )
+{
+  EFI_SIMPLE_TEXT_OUTPUT_MODE  *Mode;
+  TERMINAL_SHADOW_CELL         *Shadow;
+  TERMINAL_SHADOW_CELL         *Shown;
+  UINTN                        Row;
+  UINTN                        Column;
+
+  Mode = mTerminal->SimpleTextOutput.Mode;
+  UT_ASSERT_FALSE (mTerminal->ShadowDirty);
+  UT_ASSERT_EQUAL (mMockTerminal.SequenceLength, 0);
+
+  for (Row = 0; Row < TEST_ROWS; Row++) {
+    for (Column = 0; Column < TEST_COLUMNS; Column++) {
+      Shadow = &mTerminal->ShadowCells[Row * TEST_COLUMNS + Column];
+      Shown  = &mTerminal->ShownCells[Row * TEST_COLUMNS + Column];
+      UT_ASSERT_EQUAL (mMockTerminal.Cells[Row][Column].Char, Shadow->Char);
+      UT_ASSERT_EQUAL (mMockTerminal.Cells[Row][Column].Attribute, Shadow->Attribute);
+      UT_ASSERT_EQUAL (Shown->Char, Shadow->Char);
+      UT_ASSERT_EQUAL (Shown->Attribute, Shadow->Attribute);
+    }
+  }
+
+  UT_ASSERT_EQUAL (mMockTerminal.Column, (UINTN)Mode->CursorColumn);
+  UT_ASSERT_EQUAL (mMockTerminal.Row, (UINTN)Mode->CursorRow);
+  UT_ASSERT_EQUAL (mMockTerminal.Attribute, (UINT8)Mode->Attribute);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Flush the screen shadow and check the model screen.
+
+  @param[out] Sent  Returns the number of bytes the flush sent.
+
+  @retval UNIT_TEST_PASSED  The flush succeeded and the screens match.
+**/
+STATIC
+UNIT_TEST_STATUS
+FlushAndCheck (
+  OUT UINTN  *Sent
+  )
+{
+  UINTN  Bytes;
+
+  Bytes = mMockTerminal.Bytes;
+  UT_ASSERT_NOT_EFI_ERROR (TerminalShadowFlush (mTerminal));
+  *Sent = mMockTerminal.Bytes - Bytes;
+  return CheckScreen ();
+}
+
+/**
+  Draw a page of text, the way the Setup Browser draws a form: a title bar,
+  then a line of text on each row. The page can be varied a little.
+
+  @param[in]  Variant  0 for the page, or a variant of it.
+**/
+STATIC
+VOID
+DrawPage (
+  IN UINTN  Variant
+  )
+{
+  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *ConOut;
+  CHAR16                           Line[TEST_COLUMNS + 1];
+  UINTN                            Row;
+  UINTN                            Length;
+  UINTN                            Index;
+
+  ConOut = &mTerminal->SimpleTextOutput;
+
+  ConOut->SetAttribute (ConOut, TEST_TITLE_ATTRIBUTE);
+  ConOut->SetCursorPosition (ConOut, 0, 0);
+  for (Index = 0; Index < TEST_COLUMNS; Index++) {
+    Line[Index] = (mTerminal->TerminalType == TerminalTypeVtUtf8) ? BOXDRAW_HORIZONTAL : L'=';
+  }
+
+  Line[TEST_COLUMNS] = CHAR_NULL;
+  ConOut->OutputString (ConOut, Line);
+
+  ConOut->SetAttribute (ConOut, TEST_TEXT_ATTRIBUTE);
+  for (Row = 1; Row < TEST_ROWS - 1; Row++) {
+    Length = 10 + (Row * 7) % 50;
+    for (Index = 0; Index < Length; Index++) {
+      Line[Index] = (CHAR16)(L'a' + (Row + Index) % 26);
+    }
+
+    if (Variant == 1) {
+      //
+      // One changed character, and two changed characters close together.
+      //
+      if (Row == 3) {
+        Line[5] = L'#';
+      } else if (Row == 5) {
+        Line[2] = L'#';
+        Line[6] = L'#';
+      } else if (Row == 7) {
+        Length = 4;
+      }
+    }
+
+    Line[Length] = CHAR_NULL;
+    ConOut->SetCursorPosition (ConOut, 0, Row);
+    ConOut->OutputString (ConOut, Line);
+  }
+
+  ConOut->SetCursorPosition (ConOut, 0, TEST_ROWS - 1);
+}
+
+/**
+  Start a terminal on the mock serial port, with a screen shadow and a blank
+  screen.
+
+  @param[in]  Context  The terminal type.
+
+  @retval UNIT_TEST_PASSED  The terminal is ready.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+TerminalShadowSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *ConOut;
+
+  MockBoot.RaiseTPL   = MockRaiseTpl;
+  MockBoot.RestoreTPL = MockRestoreTpl;
+  mMockTpl            = TPL_APPLICATION;
+
+  ZeroMem (&mMockSerialIo, sizeof (mMockSerialIo));
+  mMockSerialIo.Write = MockSerialWrite;
+
+  mTerminal = AllocateZeroPool (sizeof (TERMINAL_DEV));
+  UT_ASSERT_NOT_NULL (mTerminal);
+
+  mTerminal->Signature               = TERMINAL_DEV_SIGNATURE;
+  mTerminal->TerminalType            = *(TERMINAL_TYPE *)Context;
+  mTerminal->SerialIo                = &mMockSerialIo;
+  mTerminal->TerminalConsoleModeData = mModeData;
+
+  ConOut                    = &mTerminal->SimpleTextOutput;
+  ConOut->OutputString      = TerminalConOutOutputString;
+  ConOut->QueryMode         = TerminalConOutQueryMode;
+  ConOut->SetAttribute      = TerminalConOutSetAttribute;
+  ConOut->ClearScreen       = TerminalConOutClearScreen;
+  ConOut->SetCursorPosition = TerminalConOutSetCursorPosition;
+  ConOut->EnableCursor      = TerminalConOutEnableCursor;
+  ConOut->Mode              = &mTerminal->SimpleTextOutputMode;
+  ConOut->Mode->MaxMode     = ARRAY_SIZE (mModeData);
+  ConOut->Mode->Attribute   = TEST_TEXT_ATTRIBUTE;
+
+  ZeroMem (&mMockTerminal, sizeof (mMockTerminal));
+  mMockTerminal.Attribute = TEST_TEXT_ATTRIBUTE;
+  ModelErase (0, 0, TEST_ROWS * TEST_COLUMNS);
+
+  TerminalShadowInitialize (mTerminal);
+  UT_ASSERT_NOT_NULL (mTerminal->ShadowCells);
+  mTerminal->ShadowFlushEvent = MOCK_FLUSH_EVENT;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Free the terminal.
+
+  @param[in]  Context  Unused.
+**/
+STATIC
+VOID
+EFIAPI
+TerminalShadowCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  TerminalShadowFree (mTerminal);
+  FreePool (mTerminal);
+  mTerminal = NULL;
+}
+
+/**
+  A redrawn page only sends the cells that changed, with the blank end of a
+  row erased at once.
+
+  @param[in]  Context  The terminal type.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+FlushRowTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  Status;
+  UINTN             Unbuffered;
+  UINTN             Sent;
+
+  DrawPage (0);
+  Status = FlushAndCheck (&Sent);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  //
+  // The same page again sends nothing.
+  //
+  DrawPage (0);
+  Status = FlushAndCheck (&Sent);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  UT_ASSERT_EQUAL (Sent, 0);
+
+  //
+  // A few changed cells send a few bytes.
+  //
+  DrawPage (1);
+  Unbuffered = mTerminal->ShadowUnbufferedBytes;
+  Status     = FlushAndCheck (&Sent);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  UT_ASSERT_TRUE (Sent > 0);
+  UT_ASSERT_TRUE (Sent < 64);
+  UT_ASSERT_TRUE (Sent * 20 < Unbuffered);
+  UT_ASSERT_EQUAL (mMockTerminal.Clears, 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A cleared screen is cleared on the terminal only when that sends less than
+  updating it.
+
+  @param[in]  Context  The terminal type.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+ClearIsCheaperTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *ConOut;
+  UNIT_TEST_STATUS                 Status;
+  UINTN                            Sent;
+
+  ConOut = &mTerminal->SimpleTextOutput;
+
+  DrawPage (0);
+  Status = FlushAndCheck (&Sent);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  //
+  // A mostly blank screen is cheaper to clear.
+  //
+  ConOut->ClearScreen (ConOut);
+  ConOut->OutputString (ConOut, L"Press any key");
+  Status = FlushAndCheck (&Sent);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  UT_ASSERT_EQUAL (mMockTerminal.Clears, 1);
+  UT_ASSERT_TRUE (Sent < 64);
+
+  DrawPage (0);
+  Status = FlushAndCheck (&Sent);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  //
+  // The same page drawn again after a clear is cheaper to update.
+  //
+  ConOut->ClearScreen (ConOut);
+  DrawPage (1);
+  Status = FlushAndCheck (&Sent);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  UT_ASSERT_EQUAL (mMockTerminal.Clears, 1);
+  UT_ASSERT_TRUE (Sent < 64);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Write a numbered line of boot messages, and move to the next line.
+
+  @param[in]  Number  The number of the message.
+**/
+STATIC
+VOID
+BootMessage (
+  IN UINTN  Number
+  )
+{
+  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *ConOut;
+  CHAR16                           Line[] = L"Boot message 00\r\n";
+
+  ConOut   = &mTerminal->SimpleTextOutput;
+  Line[13] = (CHAR16)(L'0' + Number / 10);
+  Line[14] = (CHAR16)(L'0' + Number % 10);
+  ConOut->OutputString (ConOut, Line);
+}
+
+/**
+  Lines scrolled off the screen shadow scroll the terminal, and only the new
+  lines are sent.
+
+  @param[in]  Context  The terminal type.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+FlushScrollTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *ConOut;
+  UNIT_TEST_STATUS                 Status;
+  UINTN                            Number;
+  UINTN                            Sent;
+
+  ConOut = &mTerminal->SimpleTextOutput;
+
+  for (Number = 0; Number < TEST_ROWS - 1; Number++) {
+    BootMessage (Number);
+  }
+
+  Status = FlushAndCheck (&Sent);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  UT_ASSERT_EQUAL (mMockTerminal.Scrolls, 0);
+
+  for ( ; Number < TEST_ROWS + 2; Number++) {
+    BootMessage (Number);
+  }
+
+  Status = FlushAndCheck (&Sent);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  UT_ASSERT_EQUAL (mMockTerminal.Scrolls, 3);
+  UT_ASSERT_TRUE (Sent < 3 * 32);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Change the screen shadow at TPL_NOTIFY, as an interrupting ConOut call does.
+**/
+STATIC
+VOID
+InterruptingUpdate (
+  VOID
+  )
+{
+  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *ConOut;
+  EFI_TPL                          OldTpl;
+
+  ConOut = &mTerminal->SimpleTextOutput;
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  ConOut->SetCursorPosition (ConOut, 0, 0);
+  ConOut->OutputString (ConOut, L"Interrupting update");
+  ConOut->SetCursorPosition (ConOut, 0, TEST_ROWS - 1);
+  ConOut->OutputString (ConOut, L"Status line");
+
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  The update is written below TPL_NOTIFY in bounded chunks, and the screen
+  shadow can change between two chunks.
+
+  @param[in]  Context  The terminal type.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+ChunkedFlushTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *ConOut;
+  UNIT_TEST_STATUS                 Status;
+  UINTN                            Index;
+  UINTN                            Sent;
+
+  ConOut = &mTerminal->SimpleTextOutput;
+
+  //
+  // Every cell has its own attribute.
+  //
+  for (Index = 0; Index < TEST_COLUMNS * (TEST_ROWS - 1); Index++) {
+    ConOut->SetAttribute (ConOut, EFI_TEXT_ATTR (Index % 8, (Index / 8) % 8));
+    ConOut->OutputString (ConOut, L"x");
+  }
+
+  mMockTerminal.WriteHook = InterruptingUpdate;
+  Status                  = FlushAndCheck (&Sent);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  UT_ASSERT_TRUE (mMockTerminal.Writes > 1);
+  UT_ASSERT_TRUE (mMockTerminal.LargestWrite <= 512);
+  UT_ASSERT_EQUAL (mMockTerminal.HighestWriteTpl, TPL_APPLICATION);
+  UT_ASSERT_EQUAL (mMockTpl, TPL_APPLICATION);
+
+  //
+  // A flush interrupted by a ConOut call at TPL_CALLBACK or above sends the
+  // update of that call too.
+  //
+  UT_ASSERT_EQUAL (mMockTerminal.Cells[0][0].Char, L'I');
+  UT_ASSERT_EQUAL (mMockTerminal.Cells[TEST_ROWS - 1][0].Char, L'S');
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A failed write makes the next flush send every cell.
+
+  @param[in]  Context  The terminal type.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+WriteErrorTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  Status;
+  UINTN             PageSent;
+  UINTN             Sent;
+
+  DrawPage (0);
+  Status = FlushAndCheck (&PageSent);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  DrawPage (1);
+  mMockTerminal.WriteStatus = EFI_DEVICE_ERROR;
+  UT_ASSERT_STATUS_EQUAL (TerminalShadowFlush (mTerminal), EFI_DEVICE_ERROR);
+  UT_ASSERT_TRUE (mTerminal->ShadowDirty);
+
+  Status = FlushAndCheck (&Sent);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  UT_ASSERT_TRUE (Sent >= PageSent);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Enabling the cursor sends the damaged cells, so that the terminal cursor is
+  where the cursor of the mode is.
+
+  @param[in]  Context  The terminal type.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+EnableCursorTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *ConOut;
+
+  ConOut = &mTerminal->SimpleTextOutput;
+
+  ConOut->SetCursorPosition (ConOut, 10, 5);
+  ConOut->OutputString (ConOut, L"Password: ");
+  UT_ASSERT_EQUAL (mMockTerminal.Bytes, 0);
+
+  UT_ASSERT_STATUS_EQUAL (ConOut->EnableCursor (ConOut, FALSE), EFI_UNSUPPORTED);
+  UT_ASSERT_NOT_EFI_ERROR (ConOut->EnableCursor (ConOut, TRUE));
+  return CheckScreen ();
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  screen shadow and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      Vt100Tests;
+  UNIT_TEST_SUITE_HANDLE      VtUtf8Tests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&Vt100Tests, Framework, "Terminal Shadow VT100 Tests", "TerminalShadow.Vt100", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for Vt100Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (Vt100Tests, "Only changed cells are sent", "FlushRow", FlushRowTest, TerminalShadowSetup, TerminalShadowCleanup, &mVt100);
+  AddTestCase (Vt100Tests, "The screen is cleared when that is cheaper", "ClearIsCheaper", ClearIsCheaperTest, TerminalShadowSetup, TerminalShadowCleanup, &mVt100);
+  AddTestCase (Vt100Tests, "Scrolled lines scroll the terminal", "FlushScroll", FlushScrollTest, TerminalShadowSetup, TerminalShadowCleanup, &mVt100);
+  AddTestCase (Vt100Tests, "Updates are written in chunks below TPL_NOTIFY", "ChunkedFlush", ChunkedFlushTest, TerminalShadowSetup, TerminalShadowCleanup, &mVt100);
+  AddTestCase (Vt100Tests, "A failed write resends the screen", "WriteError", WriteErrorTest, TerminalShadowSetup, TerminalShadowCleanup, &mVt100);
+  AddTestCase (Vt100Tests, "Enabling the cursor flushes the shadow", "EnableCursor", EnableCursorTest, TerminalShadowSetup, TerminalShadowCleanup, &mVt100);
+
+  Status = CreateUnitTestSuite (&VtUtf8Tests, Framework, "Terminal Shadow VT-UTF8 Tests", "TerminalShadow.VtUtf8", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for VtUtf8Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (VtUtf8Tests, "Only changed cells are sent", "FlushRow", FlushRowTest, TerminalShadowSetup, TerminalShadowCleanup, &mVtUtf8);
+  AddTestCase (VtUtf8Tests, "The screen is cleared when that is cheaper", "ClearIsCheaper", ClearIsCheaperTest, TerminalShadowSetup, TerminalShadowCleanup, &mVtUtf8);
+  AddTestCase (VtUtf8Tests, "Updates are written in chunks below TPL_NOTIFY", "ChunkedFlush", ChunkedFlushTest, TerminalShadowSetup, TerminalShadowCleanup, &mVtUtf8);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
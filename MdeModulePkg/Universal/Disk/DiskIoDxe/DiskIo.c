@@ -186,6 +186,16 @@ DiskIoDriverBindingStart (
     goto ErrorExit;
   }
 
+  // MU_CHANGE [BEGIN] - Block cache
+  //
+  // The cache is optional, run without it if it cannot be allocated.
+  //
+  if (EFI_ERROR (DiskIoCacheInitialize (&Instance->Cache, Instance->BlockIo->Media, PcdGet32 (PcdDiskIoCacheBlockNum)))) {
+    DEBUG ((DEBUG_WARN, "DiskIo: Not enough memory for the block cache, run without it\n"));
+  }
+
+  // MU_CHANGE [END]
+
   //
   // Install protocol interfaces for the Disk IO device.
   //
@@ -217,6 +227,7 @@ ErrorExit:
     }
 
     if (Instance != NULL) {
+      DiskIoCacheFree (&Instance->Cache); // MU_CHANGE - Block cache
       FreePool (Instance);
     }
 
@@ -347,6 +358,7 @@ DiskIoDriverBindingStop (
       ASSERT_EFI_ERROR (Status);
     }
 
+    DiskIoCacheFree (&Instance->Cache); // MU_CHANGE - Block cache
     FreePool (Instance);
   }
 
@@ -866,6 +878,27 @@ DiskIo2ReadWriteDisk (
     while (!DiskIo2RemoveCompletedTask (Instance)) {
     }
 
+    // MU_CHANGE [BEGIN] - Block cache
+    if (!Write) {
+      Status = DiskIoCacheReadDisk (
+                 &Instance->Cache,
+                 BlockIo,
+                 MediaId,
+                 Offset,
+                 BufferSize,
+                 Buffer,
+                 Instance->SharedWorkingBuffer,
+                 PcdGet32 (PcdDiskIoDataBufferBlockNum)
+                 );
+      if (Status != EFI_UNSUPPORTED) {
+        return Status;
+      }
+
+      Status = EFI_SUCCESS;
+    }
+
+    // MU_CHANGE [END]
+
     SubtasksPtr = &Subtasks;
   } else {
     DiskIo2RemoveCompletedTask (Instance);
@@ -938,6 +971,29 @@ DiskIo2ReadWriteDisk (
                              (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
                              );
       }
+
+      // MU_CHANGE [BEGIN] - Block cache
+      //
+      // Write through the cache. Data written by a non-blocking write only
+      // reaches the device later, drop it from the cache.
+      //
+      if (SubtaskBlocking && !EFI_ERROR (Status)) {
+        DiskIoCacheUpdate (
+          &Instance->Cache,
+          Media,
+          Subtask->Lba,
+          (Subtask->Length % Media->BlockSize == 0) ? Subtask->Length : Media->BlockSize,
+          (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
+          );
+      } else {
+        DiskIoCacheInvalidate (
+          &Instance->Cache,
+          Subtask->Lba,
+          (Subtask->Length % Media->BlockSize == 0) ? Subtask->Length / Media->BlockSize : 1
+          );
+      }
+
+      // MU_CHANGE [END]
     } else {
       //
       // Read
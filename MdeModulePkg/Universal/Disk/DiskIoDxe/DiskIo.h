@@ -24,6 +24,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 
+#include "DiskIoCache.h" // MU_CHANGE - Block cache
+
 #define DISK_IO_PRIVATE_DATA_SIGNATURE  SIGNATURE_32 ('d', 's', 'k', 'I')
 typedef struct {
   UINT32                    Signature;
@@ -37,6 +39,8 @@ typedef struct {
 
   EFI_LOCK                  TaskQueueLock;
   LIST_ENTRY                TaskQueue;
+
+  DISK_IO_CACHE             Cache; // MU_CHANGE - Block cache
 } DISK_IO_PRIVATE_DATA;
 #define DISK_IO_PRIVATE_DATA_FROM_DISK_IO(a)   CR (a, DISK_IO_PRIVATE_DATA, DiskIo,  DISK_IO_PRIVATE_DATA_SIGNATURE)
 #define DISK_IO_PRIVATE_DATA_FROM_DISK_IO2(a)  CR (a, DISK_IO_PRIVATE_DATA, DiskIo2, DISK_IO_PRIVATE_DATA_SIGNATURE)
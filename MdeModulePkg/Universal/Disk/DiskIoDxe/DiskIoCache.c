@@ -0,0 +1,583 @@
+/** @file
+  Block cache of the DiskIo driver.
+
+  The cache holds whole blocks in a fixed array of lines. Cached lines are
+  found through a hash table keyed by LBA and are evicted in least recently
+  used order.
+
+Copyright (c) Microsoft Corporation.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DiskIo.h"
+
+/**
+  Find the line caching a block.
+
+  The cache lock must be held.
+
+  @param[in]  Cache  The block cache.
+  @param[in]  Lba    The block to find.
+
+  @return The line caching the block, or NULL if the block is not cached.
+**/
+STATIC
+DISK_IO_CACHE_LINE *
+DiskIoCacheLookup (
+  IN DISK_IO_CACHE  *Cache,
+  IN EFI_LBA        Lba
+  )
+{
+  LIST_ENTRY          *Bucket;
+  LIST_ENTRY          *Link;
+  DISK_IO_CACHE_LINE  *Line;
+
+  Bucket = &Cache->Buckets[((UINT32)Lba ^ (UINT32)RShiftU64 (Lba, 32)) & (Cache->BucketCount - 1)];
+  for (Link = GetFirstNode (Bucket); !IsNull (Bucket, Link); Link = GetNextNode (Bucket, Link)) {
+    Line = BASE_CR (Link, DISK_IO_CACHE_LINE, HashLink);
+    if (Line->Lba == Lba) {
+      return Line;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Drop a line from the cache and make it the next line to be reused.
+
+  The cache lock must be held.
+
+  @param[in]  Cache  The block cache.
+  @param[in]  Line   The valid line to drop.
+**/
+STATIC
+VOID
+DiskIoCacheDropLine (
+  IN DISK_IO_CACHE       *Cache,
+  IN DISK_IO_CACHE_LINE  *Line
+  )
+{
+  ASSERT (Line->Valid);
+
+  RemoveEntryList (&Line->HashLink);
+  Line->Valid     = FALSE;
+  Line->ReadAhead = FALSE;
+
+  RemoveEntryList (&Line->LruLink);
+  InsertTailList (&Cache->Lru, &Line->LruLink);
+}
+
+/**
+  Drop the cached blocks of a range.
+
+  The cache lock must be held.
+
+  @param[in]  Cache   The block cache.
+  @param[in]  Lba     The first block of the range.
+  @param[in]  Blocks  The number of blocks of the range.
+**/
+STATIC
+VOID
+DiskIoCacheDropRange (
+  IN DISK_IO_CACHE  *Cache,
+  IN EFI_LBA        Lba,
+  IN UINTN          Blocks
+  )
+{
+  UINTN               Index;
+  DISK_IO_CACHE_LINE  *Line;
+
+  Cache->Generation++;
+
+  if (Blocks >= Cache->LineCount) {
+    //
+    // Cheaper to check every line than to look up every block.
+    //
+    for (Index = 0; Index < Cache->LineCount; Index++) {
+      Line = &Cache->Lines[Index];
+      if (Line->Valid && (Line->Lba >= Lba) && (Line->Lba - Lba < Blocks)) {
+        DiskIoCacheDropLine (Cache, Line);
+      }
+    }
+
+    return;
+  }
+
+  for (Index = 0; Index < Blocks; Index++) {
+    Line = DiskIoCacheLookup (Cache, Lba + Index);
+    if (Line != NULL) {
+      DiskIoCacheDropLine (Cache, Line);
+    }
+  }
+}
+
+/**
+  Drop the whole content of the cache if the media was changed.
+
+  The cache lock must be held.
+
+  @param[in]  Cache  The block cache.
+  @param[in]  Media  The media of the BlockIo device.
+**/
+STATIC
+VOID
+DiskIoCacheCheckMedia (
+  IN DISK_IO_CACHE       *Cache,
+  IN EFI_BLOCK_IO_MEDIA  *Media
+  )
+{
+  UINT32  Index;
+
+  if (Cache->MediaId == Media->MediaId) {
+    return;
+  }
+
+  DEBUG ((DEBUG_BLKIO, "DiskIo: Media changed, drop the block cache\n"));
+  for (Index = 0; Index < Cache->LineCount; Index++) {
+    if (Cache->Lines[Index].Valid) {
+      DiskIoCacheDropLine (Cache, &Cache->Lines[Index]);
+    }
+  }
+
+  Cache->Generation++;
+  Cache->MediaId         = Media->MediaId;
+  Cache->NextOffset      = MAX_UINT64;
+  Cache->NextLba         = MAX_UINT64;
+  Cache->ReadAheadWindow = 0;
+}
+
+/**
+  Add a block to the cache, in place of the least recently used line.
+
+  The cache lock must be held.
+
+  @param[in]  Cache      The block cache.
+  @param[in]  Lba        The block to add.
+  @param[in]  Data       The data of the block.
+  @param[in]  ReadAhead  TRUE if the block was read ahead of the reads.
+**/
+STATIC
+VOID
+DiskIoCacheInsert (
+  IN DISK_IO_CACHE  *Cache,
+  IN EFI_LBA        Lba,
+  IN CONST UINT8    *Data,
+  IN BOOLEAN        ReadAhead
+  )
+{
+  DISK_IO_CACHE_LINE  *Line;
+
+  Line = DiskIoCacheLookup (Cache, Lba);
+  if (Line == NULL) {
+    Line = BASE_CR (GetPreviousNode (&Cache->Lru, &Cache->Lru), DISK_IO_CACHE_LINE, LruLink);
+    if (Line->Valid) {
+      RemoveEntryList (&Line->HashLink);
+    }
+
+    Line->Lba       = Lba;
+    Line->Valid     = TRUE;
+    Line->ReadAhead = ReadAhead;
+    InsertTailList (
+      &Cache->Buckets[((UINT32)Lba ^ (UINT32)RShiftU64 (Lba, 32)) & (Cache->BucketCount - 1)],
+      &Line->HashLink
+      );
+  }
+
+  CopyMem (Line->Data, Data, Cache->BlockSize);
+
+  RemoveEntryList (&Line->LruLink);
+  InsertHeadList (&Cache->Lru, &Line->LruLink);
+}
+
+/**
+  Copy the part of a block which is within the range of a read request.
+
+  @param[in]  BlockSize   The block size of the device.
+  @param[in]  Lba         The block.
+  @param[in]  Data        The data of the block.
+  @param[in]  Offset      The starting byte offset of the request.
+  @param[in]  BufferSize  The number of bytes of the request.
+  @param[out] Buffer      The destination buffer of the request.
+**/
+STATIC
+VOID
+DiskIoCacheCopyToBuffer (
+  IN  UINT32       BlockSize,
+  IN  EFI_LBA      Lba,
+  IN  CONST UINT8  *Data,
+  IN  UINT64       Offset,
+  IN  UINTN        BufferSize,
+  OUT UINT8        *Buffer
+  )
+{
+  UINT64  BlockStart;
+  UINT64  From;
+  UINT64  To;
+
+  BlockStart = MultU64x32 (Lba, BlockSize);
+  From       = MAX (BlockStart, Offset);
+  To         = MIN (BlockStart + BlockSize, Offset + BufferSize);
+  ASSERT (From < To);
+
+  CopyMem (Buffer + (UINTN)(From - Offset), Data + (UINTN)(From - BlockStart), (UINTN)(To - From));
+}
+
+/**
+  Initialize the block cache of a DiskIo instance.
+
+  @param[out] Cache       The cache to initialize.
+  @param[in]  Media       The media of the BlockIo device.
+  @param[in]  BlockCount  The number of blocks the cache may hold. 0 disables
+                          the cache.
+
+  @retval EFI_SUCCESS           The cache is initialized, or disabled.
+  @retval EFI_OUT_OF_RESOURCES  The cache could not be allocated, it is
+                                disabled.
+**/
+EFI_STATUS
+DiskIoCacheInitialize (
+  OUT DISK_IO_CACHE       *Cache,
+  IN  EFI_BLOCK_IO_MEDIA  *Media,
+  IN  UINT32              BlockCount
+  )
+{
+  UINT32  Index;
+
+  ZeroMem (Cache, sizeof (DISK_IO_CACHE));
+  InitializeListHead (&Cache->Lru);
+  EfiInitializeLock (&Cache->Lock, TPL_NOTIFY);
+
+  if ((BlockCount == 0) || (Media->BlockSize == 0)) {
+    return EFI_SUCCESS;
+  }
+
+  if ((BlockCount > MAX_UINTN / Media->BlockSize) ||
+      (BlockCount > MAX_UINTN / sizeof (DISK_IO_CACHE_LINE)))
+  {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Cache->BucketCount = GetPowerOfTwo32 (BlockCount);
+  Cache->Lines       = AllocateZeroPool (BlockCount * sizeof (DISK_IO_CACHE_LINE));
+  Cache->Data        = AllocatePool ((UINTN)BlockCount * Media->BlockSize);
+  Cache->Buckets     = AllocatePool (Cache->BucketCount * sizeof (LIST_ENTRY));
+  if ((Cache->Lines == NULL) || (Cache->Data == NULL) || (Cache->Buckets == NULL)) {
+    DiskIoCacheFree (Cache);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Index = 0; Index < Cache->BucketCount; Index++) {
+    InitializeListHead (&Cache->Buckets[Index]);
+  }
+
+  for (Index = 0; Index < BlockCount; Index++) {
+    Cache->Lines[Index].Data = Cache->Data + (UINTN)Index * Media->BlockSize;
+    InsertTailList (&Cache->Lru, &Cache->Lines[Index].LruLink);
+  }
+
+  Cache->LineCount        = BlockCount;
+  Cache->BlockSize        = Media->BlockSize;
+  Cache->MaxRequestBlocks = MAX (BlockCount / 4, 1);
+  Cache->MaxReadAhead     = BlockCount / 4;
+  Cache->MediaId          = Media->MediaId;
+  Cache->NextOffset       = MAX_UINT64;
+  Cache->NextLba          = MAX_UINT64;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Free the resources of the block cache of a DiskIo instance.
+
+  @param[in, out] Cache  The cache to free.
+**/
+VOID
+DiskIoCacheFree (
+  IN OUT DISK_IO_CACHE  *Cache
+  )
+{
+  if (Cache->LineCount != 0) {
+    DEBUG ((
+      DEBUG_INFO,
+      "DiskIo: Block cache hits/misses/bytes saved/read ahead/read ahead hits = %ld/%ld/%ld/%ld/%ld\n",
+      Cache->Statistics.Hits,
+      Cache->Statistics.Misses,
+      Cache->Statistics.BytesSaved,
+      Cache->Statistics.ReadAheadBlocks,
+      Cache->Statistics.ReadAheadHits
+      ));
+  }
+
+  if (Cache->Lines != NULL) {
+    FreePool (Cache->Lines);
+  }
+
+  if (Cache->Data != NULL) {
+    FreePool (Cache->Data);
+  }
+
+  if (Cache->Buckets != NULL) {
+    FreePool (Cache->Buckets);
+  }
+
+  Cache->Lines     = NULL;
+  Cache->Data      = NULL;
+  Cache->Buckets   = NULL;
+  Cache->LineCount = 0;
+}
+
+/**
+  Read BufferSize bytes from Offset into Buffer through the block cache.
+
+  The blocks not found in the cache are read from the device with
+  BlockIo->ReadBlocks () into WorkingBuffer, then copied to the cache and to
+  Buffer.
+
+  @param[in, out] Cache                The block cache.
+  @param[in]      BlockIo              The BlockIo protocol of the device.
+  @param[in]      MediaId              ID of the medium to be read.
+  @param[in]      Offset               The starting byte offset to read from.
+  @param[in]      BufferSize           The number of bytes to read.
+  @param[out]     Buffer               The destination buffer.
+  @param[in]      WorkingBuffer        A buffer aligned on the IoAlign of the
+                                       device, large enough for
+                                       WorkingBufferBlocks blocks.
+  @param[in]      WorkingBufferBlocks  The size in blocks of WorkingBuffer.
+
+  @retval EFI_SUCCESS      The data was read.
+  @retval EFI_UNSUPPORTED  The request cannot be served by the cache, the
+                           caller must read it from the device.
+  @retval Others           The device reported an error.
+**/
+EFI_STATUS
+DiskIoCacheReadDisk (
+  IN OUT DISK_IO_CACHE          *Cache,
+  IN     EFI_BLOCK_IO_PROTOCOL  *BlockIo,
+  IN     UINT32                 MediaId,
+  IN     UINT64                 Offset,
+  IN     UINTN                  BufferSize,
+  OUT    UINT8                  *Buffer,
+  IN     UINT8                  *WorkingBuffer,
+  IN     UINT32                 WorkingBufferBlocks
+  )
+{
+  EFI_STATUS          Status;
+  EFI_BLOCK_IO_MEDIA  *Media;
+  UINT32              BlockSize;
+  EFI_LBA             StartLba;
+  EFI_LBA             EndLba;
+  EFI_LBA             Lba;
+  DISK_IO_CACHE_LINE  *Line;
+  UINTN               Demand;
+  UINTN               Ahead;
+  UINTN               Limit;
+  UINTN               Index;
+  UINT32              Generation;
+
+  Media     = BlockIo->Media;
+  BlockSize = Cache->BlockSize;
+
+  if ((Cache->LineCount == 0) || (BufferSize == 0) || (WorkingBufferBlocks == 0)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Let the device report the requests it would reject.
+  //
+  if (!Media->MediaPresent || (MediaId != Media->MediaId) || (BlockSize != Media->BlockSize) ||
+      (Offset + BufferSize < Offset))
+  {
+    return EFI_UNSUPPORTED;
+  }
+
+  StartLba = DivU64x32 (Offset, BlockSize);
+  EndLba   = DivU64x32 (Offset + BufferSize - 1, BlockSize);
+  if ((EndLba > Media->LastBlock) || (EndLba - StartLba >= Cache->MaxRequestBlocks)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  EfiAcquireLock (&Cache->Lock);
+  DiskIoCacheCheckMedia (Cache, Media);
+
+  if ((Offset == Cache->NextOffset) || (StartLba == Cache->NextLba)) {
+    if (Cache->ReadAheadWindow == 0) {
+      Cache->ReadAheadWindow = MIN (DISK_IO_CACHE_MIN_READ_AHEAD, Cache->MaxReadAhead);
+    }
+  } else {
+    Cache->ReadAheadWindow = 0;
+  }
+
+  Cache->NextOffset = Offset + BufferSize;
+  Cache->NextLba    = EndLba + 1;
+  EfiReleaseLock (&Cache->Lock);
+
+  for (Lba = StartLba; Lba <= EndLba; Lba += Demand) {
+    EfiAcquireLock (&Cache->Lock);
+
+    Line = DiskIoCacheLookup (Cache, Lba);
+    if (Line != NULL) {
+      DiskIoCacheCopyToBuffer (BlockSize, Lba, Line->Data, Offset, BufferSize, Buffer);
+      RemoveEntryList (&Line->LruLink);
+      InsertHeadList (&Cache->Lru, &Line->LruLink);
+
+      Cache->Statistics.Hits++;
+      Cache->Statistics.BytesSaved += BlockSize;
+      if (Line->ReadAhead) {
+        Line->ReadAhead = FALSE;
+        Cache->Statistics.ReadAheadHits++;
+      }
+
+      EfiReleaseLock (&Cache->Lock);
+      Demand = 1;
+      continue;
+    }
+
+    //
+    // Read the run of missing blocks at once, and the blocks following the
+    // request when the reads are sequential.
+    //
+    Demand = 1;
+    while ((Lba + Demand <= EndLba) && (Demand < WorkingBufferBlocks) &&
+           (DiskIoCacheLookup (Cache, Lba + Demand) == NULL))
+    {
+      Demand++;
+    }
+
+    Ahead = 0;
+    if ((Lba + Demand > EndLba) && (Cache->ReadAheadWindow != 0) && (EndLba < Media->LastBlock)) {
+      Limit = MIN (Cache->ReadAheadWindow, WorkingBufferBlocks - Demand);
+      if (Limit > Media->LastBlock - EndLba) {
+        Limit = (UINTN)(Media->LastBlock - EndLba);
+      }
+
+      while ((Ahead < Limit) && (DiskIoCacheLookup (Cache, EndLba + 1 + Ahead) == NULL)) {
+        Ahead++;
+      }
+    }
+
+    Generation = Cache->Generation;
+    EfiReleaseLock (&Cache->Lock);
+
+    Status = BlockIo->ReadBlocks (BlockIo, MediaId, Lba, (Demand + Ahead) * BlockSize, WorkingBuffer);
+    if (EFI_ERROR (Status) && (Ahead != 0)) {
+      //
+      // Do not fail the request for a block it did not ask for.
+      //
+      Ahead  = 0;
+      Status = BlockIo->ReadBlocks (BlockIo, MediaId, Lba, Demand * BlockSize, WorkingBuffer);
+    }
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    EfiAcquireLock (&Cache->Lock);
+    //
+    // Blocks dropped while the device was read may have been read before
+    // they were written.
+    //
+    if ((Generation == Cache->Generation) && (Cache->MediaId == MediaId)) {
+      for (Index = 0; Index < Demand + Ahead; Index++) {
+        DiskIoCacheInsert (Cache, Lba + Index, WorkingBuffer + Index * BlockSize, (BOOLEAN)(Index >= Demand));
+      }
+    }
+
+    Cache->Statistics.Misses          += Demand;
+    Cache->Statistics.ReadAheadBlocks += Ahead;
+    if (Ahead != 0) {
+      Cache->ReadAheadWindow = MIN (Cache->ReadAheadWindow * 2, Cache->MaxReadAhead);
+    }
+
+    EfiReleaseLock (&Cache->Lock);
+
+    for (Index = 0; Index < Demand; Index++) {
+      DiskIoCacheCopyToBuffer (BlockSize, Lba + Index, WorkingBuffer + Index * BlockSize, Offset, BufferSize, Buffer);
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Update the cached blocks with the data written to the device.
+
+  Blocks which are not cached are not added.
+
+  @param[in, out] Cache   The block cache.
+  @param[in]      Media   The media of the BlockIo device.
+  @param[in]      Lba     The first block written.
+  @param[in]      Length  The number of bytes written, a multiple of the block
+                          size.
+  @param[in]      Data    The data written.
+**/
+VOID
+DiskIoCacheUpdate (
+  IN OUT DISK_IO_CACHE       *Cache,
+  IN     EFI_BLOCK_IO_MEDIA  *Media,
+  IN     EFI_LBA             Lba,
+  IN     UINTN               Length,
+  IN     CONST UINT8         *Data
+  )
+{
+  UINTN               Blocks;
+  UINTN               Index;
+  DISK_IO_CACHE_LINE  *Line;
+
+  if (Cache->LineCount == 0) {
+    return;
+  }
+
+  Blocks = Length / Cache->BlockSize;
+
+  EfiAcquireLock (&Cache->Lock);
+  DiskIoCacheCheckMedia (Cache, Media);
+
+  //
+  // A read running while the lock is released must not add the blocks it got
+  // before the write.
+  //
+  Cache->Generation++;
+
+  if (Blocks >= Cache->LineCount) {
+    for (Index = 0; Index < Cache->LineCount; Index++) {
+      Line = &Cache->Lines[Index];
+      if (Line->Valid && (Line->Lba >= Lba) && (Line->Lba - Lba < Blocks)) {
+        CopyMem (Line->Data, Data + (UINTN)(Line->Lba - Lba) * Cache->BlockSize, Cache->BlockSize);
+      }
+    }
+  } else {
+    for (Index = 0; Index < Blocks; Index++) {
+      Line = DiskIoCacheLookup (Cache, Lba + Index);
+      if (Line != NULL) {
+        CopyMem (Line->Data, Data + Index * Cache->BlockSize, Cache->BlockSize);
+      }
+    }
+  }
+
+  EfiReleaseLock (&Cache->Lock);
+}
+
+/**
+  Drop blocks from the cache.
+
+  @param[in, out] Cache   The block cache.
+  @param[in]      Lba     The first block to drop.
+  @param[in]      Blocks  The number of blocks to drop.
+**/
+VOID
+DiskIoCacheInvalidate (
+  IN OUT DISK_IO_CACHE  *Cache,
+  IN     EFI_LBA        Lba,
+  IN     UINTN          Blocks
+  )
+{
+  if (Cache->LineCount == 0) {
+    return;
+  }
+
+  EfiAcquireLock (&Cache->Lock);
+  DiskIoCacheDropRange (Cache, Lba, Blocks);
+  EfiReleaseLock (&Cache->Lock);
+}
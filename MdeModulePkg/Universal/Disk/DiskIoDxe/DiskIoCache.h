@@ -0,0 +1,209 @@
+/** @file
+  Block cache of the DiskIo driver.
+
+  Each DiskIo instance may own a size-bounded, write-through cache of the
+  blocks of its BlockIo device. Blocking reads small enough to be metadata
+  reads are served from the cache, and the blocks which are not cached are
+  read from the device and added to it. When the reads of an instance follow
+  each other, the device reads are extended by a read-ahead window which
+  doubles on every sequential miss.
+
+  Writes go to the device as before. The blocks written by blocking writes are
+  updated in the cache, the blocks of failed or non-blocking writes are
+  dropped from it. The cache only sees the accesses done through its own
+  DiskIo instance.
+
+Copyright (c) Microsoft Corporation.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _DISK_IO_CACHE_H_
+#define _DISK_IO_CACHE_H_
+
+#include <Uefi.h>
+#include <Protocol/BlockIo.h>
+#include <Library/UefiLib.h>
+
+//
+// Size of the first read-ahead window, in blocks.
+//
+#define DISK_IO_CACHE_MIN_READ_AHEAD  4
+
+typedef struct {
+  //
+  // Blocks requested by the reads and found in the cache.
+  //
+  UINT64    Hits;
+  //
+  // Blocks requested by the reads and read from the device.
+  //
+  UINT64    Misses;
+  //
+  // Bytes not transferred from the device thanks to the hits.
+  //
+  UINT64    BytesSaved;
+  //
+  // Blocks read from the device ahead of the reads.
+  //
+  UINT64    ReadAheadBlocks;
+  //
+  // Blocks read ahead which were later requested by a read.
+  //
+  UINT64    ReadAheadHits;
+} DISK_IO_CACHE_STATISTICS;
+
+typedef struct {
+  LIST_ENTRY    LruLink;           /// < link in DISK_IO_CACHE.Lru
+  LIST_ENTRY    HashLink;          /// < link in DISK_IO_CACHE.Buckets when Valid
+  EFI_LBA       Lba;
+  BOOLEAN       Valid;
+  BOOLEAN       ReadAhead;         /// < read ahead and not requested yet
+  UINT8         *Data;
+} DISK_IO_CACHE_LINE;
+
+typedef struct {
+  //
+  // Number of cache lines, each holding one block. 0 means the cache is
+  // disabled.
+  //
+  UINT32                      LineCount;
+  UINT32                      BlockSize;
+  //
+  // Requests spanning more blocks go straight to the device.
+  //
+  UINT32                      MaxRequestBlocks;
+  UINT32                      MaxReadAhead;
+  //
+  // Media the cached blocks belong to.
+  //
+  UINT32                      MediaId;
+
+  EFI_LOCK                    Lock;
+  //
+  // Incremented whenever blocks are dropped, so data read from the device
+  // while the lock was released is not added to the cache if it might be
+  // stale.
+  //
+  UINT32                      Generation;
+
+  DISK_IO_CACHE_LINE          *Lines;
+  UINT8                       *Data;
+  LIST_ENTRY                  *Buckets;
+  UINT32                      BucketCount;
+  //
+  // Least recently used list. Lines are taken from the tail, invalid lines
+  // are kept there.
+  //
+  LIST_ENTRY                  Lru;
+
+  //
+  // Sequential read detection.
+  //
+  UINT64                      NextOffset;
+  EFI_LBA                     NextLba;
+  UINT32                      ReadAheadWindow;
+
+  DISK_IO_CACHE_STATISTICS    Statistics;
+} DISK_IO_CACHE;
+
+/**
+  Initialize the block cache of a DiskIo instance.
+
+  @param[out] Cache       The cache to initialize.
+  @param[in]  Media       The media of the BlockIo device.
+  @param[in]  BlockCount  The number of blocks the cache may hold. 0 disables
+                          the cache.
+
+  @retval EFI_SUCCESS           The cache is initialized, or disabled.
+  @retval EFI_OUT_OF_RESOURCES  The cache could not be allocated, it is
+                                disabled.
+**/
+EFI_STATUS
+DiskIoCacheInitialize (
+  OUT DISK_IO_CACHE       *Cache,
+  IN  EFI_BLOCK_IO_MEDIA  *Media,
+  IN  UINT32              BlockCount
+  );
+
+/**
+  Free the resources of the block cache of a DiskIo instance.
+
+  @param[in, out] Cache  The cache to free.
+**/
+VOID
+DiskIoCacheFree (
+  IN OUT DISK_IO_CACHE  *Cache
+  );
+
+/**
+  Read BufferSize bytes from Offset into Buffer through the block cache.
+
+  The blocks not found in the cache are read from the device with
+  BlockIo->ReadBlocks () into WorkingBuffer, then copied to the cache and to
+  Buffer.
+
+  @param[in, out] Cache                The block cache.
+  @param[in]      BlockIo              The BlockIo protocol of the device.
+  @param[in]      MediaId              ID of the medium to be read.
+  @param[in]      Offset               The starting byte offset to read from.
+  @param[in]      BufferSize           The number of bytes to read.
+  @param[out]     Buffer               The destination buffer.
+  @param[in]      WorkingBuffer        A buffer aligned on the IoAlign of the
+                                       device, large enough for
+                                       WorkingBufferBlocks blocks.
+  @param[in]      WorkingBufferBlocks  The size in blocks of WorkingBuffer.
+
+  @retval EFI_SUCCESS      The data was read.
+  @retval EFI_UNSUPPORTED  The request cannot be served by the cache, the
+                           caller must read it from the device.
+  @retval Others           The device reported an error.
+**/
+EFI_STATUS
+DiskIoCacheReadDisk (
+  IN OUT DISK_IO_CACHE          *Cache,
+  IN     EFI_BLOCK_IO_PROTOCOL  *BlockIo,
+  IN     UINT32                 MediaId,
+  IN     UINT64                 Offset,
+  IN     UINTN                  BufferSize,
+  OUT    UINT8                  *Buffer,
+  IN     UINT8                  *WorkingBuffer,
+  IN     UINT32                 WorkingBufferBlocks
+  );
+
+/**
+  Update the cached blocks with the data written to the device.
+
+  Blocks which are not cached are not added.
+
+  @param[in, out] Cache   The block cache.
+  @param[in]      Media   The media of the BlockIo device.
+  @param[in]      Lba     The first block written.
+  @param[in]      Length  The number of bytes written, a multiple of the block
+                          size.
+  @param[in]      Data    The data written.
+**/
+VOID
+DiskIoCacheUpdate (
+  IN OUT DISK_IO_CACHE       *Cache,
+  IN     EFI_BLOCK_IO_MEDIA  *Media,
+  IN     EFI_LBA             Lba,
+  IN     UINTN               Length,
+  IN     CONST UINT8         *Data
+  );
+
+/**
+  Drop blocks from the cache.
+
+  @param[in, out] Cache   The block cache.
+  @param[in]      Lba     The first block to drop.
+  @param[in]      Blocks  The number of blocks to drop.
+**/
+VOID
+DiskIoCacheInvalidate (
+  IN OUT DISK_IO_CACHE  *Cache,
+  IN     EFI_LBA        Lba,
+  IN     UINTN          Blocks
+  );
+
+#endif
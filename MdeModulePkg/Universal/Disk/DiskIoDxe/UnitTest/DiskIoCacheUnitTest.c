@@ -0,0 +1,704 @@
+/** @file -- DiskIoCacheUnitTest.c
+  Host based unit tests for the block cache of the DiskIo driver.
+
+  The DiskIo protocol runs on top of a RAM backed BlockIo protocol which counts
+  the device reads, so the tests can check which requests reached the device.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiLib.h>
+#include <Library/UnitTestLib.h>
+#include <Protocol/BlockIo.h>
+
+#include "../DiskIo.h"
+
+#define UNIT_TEST_APP_NAME     "DiskIo Block Cache Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define MOCK_DISK_BLOCK_SIZE  512
+#define MOCK_DISK_BLOCKS      0x1000
+#define MOCK_DISK_MEDIA_ID    1
+
+//
+// Number of blocks of the cache under test. Requests spanning more than a
+// quarter of it go straight to the device.
+//
+#define TEST_CACHE_BLOCKS  256
+
+//
+// Number of blocks of the shared working buffer of the instance.
+//
+#define TEST_WORKING_BUFFER_BLOCKS  64
+
+typedef struct {
+  EFI_BLOCK_IO_PROTOCOL    BlockIo;
+  EFI_BLOCK_IO_MEDIA       Media;
+  UINT8                    *Disk;
+  //
+  // Blocks failing with EFI_DEVICE_ERROR.
+  //
+  EFI_LBA                  BadLba;
+  UINTN                    BadBlocks;
+  //
+  // Device accesses.
+  //
+  UINTN                    ReadCalls;
+  UINTN                    BlocksRead;
+  UINTN                    WriteCalls;
+} MOCK_BLOCK_IO;
+
+STATIC MOCK_BLOCK_IO         mMockBlockIo;
+STATIC DISK_IO_PRIVATE_DATA  *mInstance;
+
+extern DISK_IO_PRIVATE_DATA  gDiskIoPrivateDataTemplate;
+
+/**
+  Check the parameters of a BlockIo access to the mock device.
+
+  @param[in]  MediaId     The media ID of the access.
+  @param[in]  Lba         The first block of the access.
+  @param[in]  BufferSize  The size of the access.
+
+  @retval EFI_SUCCESS  The access is valid.
+  @retval Others       The status the device returns.
+**/
+STATIC
+EFI_STATUS
+MockBlockIoCheck (
+  IN UINT32   MediaId,
+  IN EFI_LBA  Lba,
+  IN UINTN    BufferSize
+  )
+{
+  if (MediaId != mMockBlockIo.Media.MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+
+  if (BufferSize % MOCK_DISK_BLOCK_SIZE != 0) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  if ((Lba > mMockBlockIo.Media.LastBlock) ||
+      (BufferSize / MOCK_DISK_BLOCK_SIZE > mMockBlockIo.Media.LastBlock - Lba + 1))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Reset the mock device.
+
+  @param[in]  This                  Indicates a pointer to the calling context.
+  @param[in]  ExtendedVerification  Driver may perform diagnostics on reset.
+
+  @retval EFI_SUCCESS  The device was reset.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockBlockIoReset (
+  IN EFI_BLOCK_IO_PROTOCOL  *This,
+  IN BOOLEAN                ExtendedVerification
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Read blocks from the mock device.
+
+  @param[in]  This        Indicates a pointer to the calling context.
+  @param[in]  MediaId     Id of the media.
+  @param[in]  Lba         The starting logical block address to read from.
+  @param[in]  BufferSize  Size of Buffer, must be a multiple of the block size.
+  @param[out] Buffer      The destination buffer for the data.
+
+  @retval EFI_SUCCESS       The data was read.
+  @retval EFI_DEVICE_ERROR  The read covers a bad block.
+  @retval Others            The request is not valid.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockBlockIoReadBlocks (
+  IN  EFI_BLOCK_IO_PROTOCOL  *This,
+  IN  UINT32                 MediaId,
+  IN  EFI_LBA                Lba,
+  IN  UINTN                  BufferSize,
+  OUT VOID                   *Buffer
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Blocks;
+
+  Status = MockBlockIoCheck (MediaId, Lba, BufferSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Blocks = BufferSize / MOCK_DISK_BLOCK_SIZE;
+  mMockBlockIo.ReadCalls++;
+  if ((mMockBlockIo.BadBlocks != 0) && (Lba < mMockBlockIo.BadLba + mMockBlockIo.BadBlocks) && (mMockBlockIo.BadLba < Lba + Blocks)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  mMockBlockIo.BlocksRead += Blocks;
+  CopyMem (Buffer, mMockBlockIo.Disk + Lba * MOCK_DISK_BLOCK_SIZE, BufferSize);
+  return EFI_SUCCESS;
+}
+
+/**
+  Write blocks to the mock device.
+
+  @param[in]  This        Indicates a pointer to the calling context.
+  @param[in]  MediaId     Id of the media.
+  @param[in]  Lba         The starting logical block address to write to.
+  @param[in]  BufferSize  Size of Buffer, must be a multiple of the block size.
+  @param[in]  Buffer      The source buffer for the data.
+
+  @retval EFI_SUCCESS  The data was written.
+  @retval Others       The request is not valid.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockBlockIoWriteBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This,
+  IN UINT32                 MediaId,
+  IN EFI_LBA                Lba,
+  IN UINTN                  BufferSize,
+  IN VOID                   *Buffer
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = MockBlockIoCheck (MediaId, Lba, BufferSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  mMockBlockIo.WriteCalls++;
+  CopyMem (mMockBlockIo.Disk + Lba * MOCK_DISK_BLOCK_SIZE, Buffer, BufferSize);
+  return EFI_SUCCESS;
+}
+
+/**
+  Flush the mock device.
+
+  @param[in]  This  Indicates a pointer to the calling context.
+
+  @retval EFI_SUCCESS  The device was flushed.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockBlockIoFlushBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Create the mock device and a DiskIo instance on it.
+
+  @param[in]  CacheBlocks  Number of blocks of the cache of the instance.
+
+  @retval UNIT_TEST_PASSED                     The instance was created.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  The instance could not be created.
+**/
+STATIC
+UNIT_TEST_STATUS
+DiskIoCacheCreateInstance (
+  IN UINT32  CacheBlocks
+  )
+{
+  UINTN       Index;
+  EFI_STATUS  Status;
+
+  ZeroMem (&mMockBlockIo, sizeof (mMockBlockIo));
+  mMockBlockIo.Media.MediaId          = MOCK_DISK_MEDIA_ID;
+  mMockBlockIo.Media.MediaPresent     = TRUE;
+  mMockBlockIo.Media.LogicalPartition = FALSE;
+  mMockBlockIo.Media.BlockSize        = MOCK_DISK_BLOCK_SIZE;
+  mMockBlockIo.Media.IoAlign          = 0;
+  mMockBlockIo.Media.LastBlock        = MOCK_DISK_BLOCKS - 1;
+
+  mMockBlockIo.BlockIo.Revision    = EFI_BLOCK_IO_PROTOCOL_REVISION;
+  mMockBlockIo.BlockIo.Media       = &mMockBlockIo.Media;
+  mMockBlockIo.BlockIo.Reset       = MockBlockIoReset;
+  mMockBlockIo.BlockIo.ReadBlocks  = MockBlockIoReadBlocks;
+  mMockBlockIo.BlockIo.WriteBlocks = MockBlockIoWriteBlocks;
+  mMockBlockIo.BlockIo.FlushBlocks = MockBlockIoFlushBlocks;
+
+  mMockBlockIo.Disk = AllocatePool (MOCK_DISK_BLOCKS * MOCK_DISK_BLOCK_SIZE);
+  if (mMockBlockIo.Disk == NULL) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  //
+  // Every byte depends on its offset, so misplaced data is caught.
+  //
+  for (Index = 0; Index < MOCK_DISK_BLOCKS * MOCK_DISK_BLOCK_SIZE; Index++) {
+    mMockBlockIo.Disk[Index] = (UINT8)(Index ^ (Index >> 9) ^ (Index >> 17));
+  }
+
+  mInstance = AllocateCopyPool (sizeof (DISK_IO_PRIVATE_DATA), &gDiskIoPrivateDataTemplate);
+  if (mInstance == NULL) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  mInstance->BlockIo  = &mMockBlockIo.BlockIo;
+  mInstance->BlockIo2 = NULL;
+  InitializeListHead (&mInstance->TaskQueue);
+  EfiInitializeLock (&mInstance->TaskQueueLock, TPL_NOTIFY);
+  mInstance->SharedWorkingBuffer = AllocatePages (EFI_SIZE_TO_PAGES (TEST_WORKING_BUFFER_BLOCKS * MOCK_DISK_BLOCK_SIZE));
+  if (mInstance->SharedWorkingBuffer == NULL) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  Status = DiskIoCacheInitialize (&mInstance->Cache, &mMockBlockIo.Media, CacheBlocks);
+  if (EFI_ERROR (Status)) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Create a DiskIo instance with a cache of TEST_CACHE_BLOCKS blocks.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED                     The instance was created.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  The instance could not be created.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+DiskIoCacheSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  return DiskIoCacheCreateInstance (TEST_CACHE_BLOCKS);
+}
+
+/**
+  Create a DiskIo instance with the cache disabled.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED                     The instance was created.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  The instance could not be created.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+DiskIoNoCacheSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  return DiskIoCacheCreateInstance (0);
+}
+
+/**
+  Free the DiskIo instance and the mock device.
+
+  @param[in]  Context  Unused.
+**/
+VOID
+EFIAPI
+DiskIoCacheCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  if (mInstance != NULL) {
+    DiskIoCacheFree (&mInstance->Cache);
+    if (mInstance->SharedWorkingBuffer != NULL) {
+      FreePages (mInstance->SharedWorkingBuffer, EFI_SIZE_TO_PAGES (TEST_WORKING_BUFFER_BLOCKS * MOCK_DISK_BLOCK_SIZE));
+    }
+
+    FreePool (mInstance);
+    mInstance = NULL;
+  }
+
+  if (mMockBlockIo.Disk != NULL) {
+    FreePool (mMockBlockIo.Disk);
+    mMockBlockIo.Disk = NULL;
+  }
+}
+
+//
+// Scattered unaligned reads, as done by a file system looking up its
+// metadata. No read follows the previous one.
+//
+STATIC CONST struct {
+  UINT64    Offset;
+  UINTN     Size;
+} mMetadataReads[] = {
+  { 0x00000, 512  },
+  { 0x1c010, 64   },
+  { 0x04100, 700  },
+  { 0x30000, 32   },
+  { 0x0a1f0, 32   },
+  { 0x00200, 1024 },
+  { 0x1c0f8, 300  },
+  { 0x08000, 100  },
+};
+
+/**
+  Metadata read again is served from the cache.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+MetadataRereadTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8       Buffer[1024];
+  UINTN       Pass;
+  UINTN       Index;
+  UINTN       Blocks;
+  UINTN       ReadCalls;
+  EFI_STATUS  Status;
+
+  Blocks = 0;
+  for (Index = 0; Index < ARRAY_SIZE (mMetadataReads); Index++) {
+    Blocks += (UINTN)((mMetadataReads[Index].Offset + mMetadataReads[Index].Size - 1) / MOCK_DISK_BLOCK_SIZE -
+                      mMetadataReads[Index].Offset / MOCK_DISK_BLOCK_SIZE + 1);
+  }
+
+  for (Pass = 0; Pass < 3; Pass++) {
+    ReadCalls = mMockBlockIo.ReadCalls;
+    for (Index = 0; Index < ARRAY_SIZE (mMetadataReads); Index++) {
+      SetMem (Buffer, sizeof (Buffer), 0xAA);
+      Status = mInstance->DiskIo.ReadDisk (
+                                   &mInstance->DiskIo,
+                                   MOCK_DISK_MEDIA_ID,
+                                   mMetadataReads[Index].Offset,
+                                   mMetadataReads[Index].Size,
+                                   Buffer
+                                   );
+      UT_ASSERT_NOT_EFI_ERROR (Status);
+      UT_ASSERT_MEM_EQUAL (Buffer, mMockBlockIo.Disk + mMetadataReads[Index].Offset, mMetadataReads[Index].Size);
+    }
+
+    if (Pass == 0) {
+      UT_ASSERT_NOT_EQUAL (mMockBlockIo.ReadCalls, ReadCalls);
+    } else {
+      UT_ASSERT_EQUAL (mMockBlockIo.ReadCalls, ReadCalls);
+    }
+  }
+
+  //
+  // Blocks shared by two reads hit from the first pass on.
+  //
+  UT_ASSERT_EQUAL (mInstance->Cache.Statistics.Hits + mInstance->Cache.Statistics.Misses, 3 * Blocks);
+  UT_ASSERT_EQUAL (mInstance->Cache.Statistics.Misses, mMockBlockIo.BlocksRead);
+  UT_ASSERT_TRUE (mInstance->Cache.Statistics.Hits >= 2 * Blocks);
+  UT_ASSERT_EQUAL (mInstance->Cache.Statistics.BytesSaved, mInstance->Cache.Statistics.Hits * MOCK_DISK_BLOCK_SIZE);
+  UT_ASSERT_EQUAL (mInstance->Cache.Statistics.ReadAheadBlocks, 0);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Sequential reads are read ahead with a growing window.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SequentialReadAheadTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8       Buffer[MOCK_DISK_BLOCK_SIZE];
+  UINT64      Offset;
+  UINTN       Index;
+  EFI_STATUS  Status;
+
+  //
+  // 256 reads of 200 bytes, crossing block boundaries.
+  //
+  Offset = 0x20000;
+  for (Index = 0; Index < 256; Index++) {
+    Status = mInstance->DiskIo.ReadDisk (&mInstance->DiskIo, MOCK_DISK_MEDIA_ID, Offset, 200, Buffer);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_MEM_EQUAL (Buffer, mMockBlockIo.Disk + Offset, 200);
+    Offset += 200;
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "Sequential reads: %d device reads, %d blocks read ahead, %d read ahead hits\n",
+    mMockBlockIo.ReadCalls,
+    mInstance->Cache.Statistics.ReadAheadBlocks,
+    mInstance->Cache.Statistics.ReadAheadHits
+    ));
+
+  //
+  // 100 blocks read one by one without read-ahead. The window grows to a
+  // quarter of the cache.
+  //
+  UT_ASSERT_TRUE (mMockBlockIo.ReadCalls <= 8);
+  UT_ASSERT_TRUE (mInstance->Cache.Statistics.ReadAheadHits >= 90);
+  UT_ASSERT_TRUE (mInstance->Cache.Statistics.ReadAheadBlocks >= mInstance->Cache.Statistics.ReadAheadHits);
+  UT_ASSERT_TRUE (mInstance->Cache.ReadAheadWindow <= TEST_CACHE_BLOCKS / 4);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A bad block read ahead does not fail the reads before it.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ReadAheadErrorTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8       Buffer[MOCK_DISK_BLOCK_SIZE];
+  EFI_LBA     Lba;
+  EFI_STATUS  Status;
+
+  mMockBlockIo.BadLba    = 0x110;
+  mMockBlockIo.BadBlocks = 1;
+
+  for (Lba = 0x100; Lba < mMockBlockIo.BadLba; Lba++) {
+    Status = mInstance->DiskIo.ReadDisk (&mInstance->DiskIo, MOCK_DISK_MEDIA_ID, Lba * MOCK_DISK_BLOCK_SIZE, MOCK_DISK_BLOCK_SIZE, Buffer);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_MEM_EQUAL (Buffer, mMockBlockIo.Disk + Lba * MOCK_DISK_BLOCK_SIZE, MOCK_DISK_BLOCK_SIZE);
+  }
+
+  Status = mInstance->DiskIo.ReadDisk (&mInstance->DiskIo, MOCK_DISK_MEDIA_ID, Lba * MOCK_DISK_BLOCK_SIZE, MOCK_DISK_BLOCK_SIZE, Buffer);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_DEVICE_ERROR);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Writes go to the device and update the cached blocks.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+WriteThroughTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8       Buffer[4 * MOCK_DISK_BLOCK_SIZE];
+  UINT8       Data[700];
+  UINTN       ReadCalls;
+  EFI_STATUS  Status;
+
+  Status = mInstance->DiskIo.ReadDisk (&mInstance->DiskIo, MOCK_DISK_MEDIA_ID, 0x4000, sizeof (Buffer), Buffer);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  //
+  // Unaligned write over two cached blocks.
+  //
+  SetMem (Data, sizeof (Data), 0x5A);
+  Status = mInstance->DiskIo.WriteDisk (&mInstance->DiskIo, MOCK_DISK_MEDIA_ID, 0x4100, sizeof (Data), Data);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_NOT_EQUAL (mMockBlockIo.WriteCalls, 0);
+  UT_ASSERT_MEM_EQUAL (mMockBlockIo.Disk + 0x4100, Data, sizeof (Data));
+
+  ReadCalls = mMockBlockIo.ReadCalls;
+  Status    = mInstance->DiskIo.ReadDisk (&mInstance->DiskIo, MOCK_DISK_MEDIA_ID, 0x4000, sizeof (Buffer), Buffer);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_MEM_EQUAL (Buffer, mMockBlockIo.Disk + 0x4000, sizeof (Buffer));
+  UT_ASSERT_EQUAL (mMockBlockIo.ReadCalls, ReadCalls);
+
+  //
+  // Blocks written are not added to the cache.
+  //
+  Status = mInstance->DiskIo.WriteDisk (&mInstance->DiskIo, MOCK_DISK_MEDIA_ID, 0x9000, sizeof (Data), Data);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  ReadCalls = mMockBlockIo.ReadCalls;
+  Status    = mInstance->DiskIo.ReadDisk (&mInstance->DiskIo, MOCK_DISK_MEDIA_ID, 0x9000, sizeof (Data), Buffer);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_MEM_EQUAL (Buffer, Data, sizeof (Data));
+  UT_ASSERT_NOT_EQUAL (mMockBlockIo.ReadCalls, ReadCalls);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Blocks of a previous media are never returned.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+MediaChangeTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8       Buffer[MOCK_DISK_BLOCK_SIZE];
+  EFI_STATUS  Status;
+
+  Status = mInstance->DiskIo.ReadDisk (&mInstance->DiskIo, MOCK_DISK_MEDIA_ID, 0x1000, sizeof (Buffer), Buffer);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  //
+  // Replace the media.
+  //
+  mMockBlockIo.Media.MediaId++;
+  SetMem (mMockBlockIo.Disk + 0x1000, sizeof (Buffer), 0xC3);
+
+  Status = mInstance->DiskIo.ReadDisk (&mInstance->DiskIo, MOCK_DISK_MEDIA_ID, 0x1000, sizeof (Buffer), Buffer);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_MEDIA_CHANGED);
+
+  Status = mInstance->DiskIo.ReadDisk (&mInstance->DiskIo, mMockBlockIo.Media.MediaId, 0x1000, sizeof (Buffer), Buffer);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_MEM_EQUAL (Buffer, mMockBlockIo.Disk + 0x1000, sizeof (Buffer));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Large reads and reads with the cache disabled go straight to the device.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BypassTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8       *Buffer;
+  UINTN       Size;
+  UINTN       Pass;
+  UINTN       BlocksRead;
+  EFI_STATUS  Status;
+
+  Size   = (TEST_CACHE_BLOCKS / 2) * MOCK_DISK_BLOCK_SIZE;
+  Buffer = AllocatePages (EFI_SIZE_TO_PAGES (Size));
+  UT_ASSERT_NOT_NULL (Buffer);
+
+  for (Pass = 0; Pass < 2; Pass++) {
+    BlocksRead = mMockBlockIo.BlocksRead;
+    Status     = mInstance->DiskIo.ReadDisk (&mInstance->DiskIo, MOCK_DISK_MEDIA_ID, 0x10000, Size, Buffer);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_MEM_EQUAL (Buffer, mMockBlockIo.Disk + 0x10000, Size);
+    UT_ASSERT_EQUAL (mMockBlockIo.BlocksRead - BlocksRead, TEST_CACHE_BLOCKS / 2);
+
+    BlocksRead = mMockBlockIo.BlocksRead;
+    Status     = mInstance->DiskIo.ReadDisk (&mInstance->DiskIo, MOCK_DISK_MEDIA_ID, 0x10010, 16, Buffer);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_MEM_EQUAL (Buffer, mMockBlockIo.Disk + 0x10010, 16);
+    if (mInstance->Cache.LineCount == 0) {
+      UT_ASSERT_EQUAL (mMockBlockIo.BlocksRead - BlocksRead, 1);
+    }
+  }
+
+  UT_ASSERT_EQUAL (mInstance->Cache.Statistics.Hits, (mInstance->Cache.LineCount == 0) ? 0 : 1);
+
+  FreePages (Buffer, EFI_SIZE_TO_PAGES (Size));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the DiskIo
+  block cache and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      CacheTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&CacheTests, Framework, "DiskIo Block Cache Tests", "DiskIo.Cache", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for CacheTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (CacheTests, "Metadata read again is served from the cache", "MetadataReread", MetadataRereadTest, DiskIoCacheSetup, DiskIoCacheCleanup, NULL);
+  AddTestCase (CacheTests, "Sequential reads are read ahead", "SequentialReadAhead", SequentialReadAheadTest, DiskIoCacheSetup, DiskIoCacheCleanup, NULL);
+  AddTestCase (CacheTests, "A bad block read ahead does not fail the reads", "ReadAheadError", ReadAheadErrorTest, DiskIoCacheSetup, DiskIoCacheCleanup, NULL);
+  AddTestCase (CacheTests, "Writes update the cached blocks", "WriteThrough", WriteThroughTest, DiskIoCacheSetup, DiskIoCacheCleanup, NULL);
+  AddTestCase (CacheTests, "Blocks of a previous media are dropped", "MediaChange", MediaChangeTest, DiskIoCacheSetup, DiskIoCacheCleanup, NULL);
+  AddTestCase (CacheTests, "Large reads bypass the cache", "LargeReadBypass", BypassTest, DiskIoCacheSetup, DiskIoCacheCleanup, NULL);
+  AddTestCase (CacheTests, "Reads go to the device when the cache is disabled", "CacheDisabled", BypassTest, DiskIoNoCacheSetup, DiskIoCacheCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -32,6 +32,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
   @param[in]  DiskIo      Disk Io protocol.
   @param[in]  Lba         The starting Lba of the Partition Table
   @param[out] PartHeader  Stores the partition table that is read
+  @param[in]  Probe       The probe of the disk, may be NULL.
 
   @retval TRUE      The partition table is valid
   @retval FALSE     The partition table is not valid
@@ -42,7 +43,8 @@ PartitionValidGptTable (
   IN  EFI_BLOCK_IO_PROTOCOL       *BlockIo,
   IN  EFI_DISK_IO_PROTOCOL        *DiskIo,
   IN  EFI_LBA                     Lba,
-  OUT EFI_PARTITION_TABLE_HEADER  *PartHeader
+  OUT EFI_PARTITION_TABLE_HEADER  *PartHeader,
+  IN  PARTITION_PROBE             *Probe OPTIONAL    // MU_CHANGE - Parallel media probing
   );
 
 /**
@@ -52,6 +54,7 @@ PartitionValidGptTable (
   @param[in]  BlockIo     Parent BlockIo interface
   @param[in]  DiskIo      Disk Io Protocol.
   @param[in]  PartHeader  Partition table header structure
+  @param[in]  Probe       The probe of the disk, may be NULL.
 
   @retval TRUE      the CRC is valid
   @retval FALSE     the CRC is invalid
@@ -61,7 +64,8 @@ BOOLEAN
 PartitionCheckGptEntryArrayCRC (
   IN  EFI_BLOCK_IO_PROTOCOL       *BlockIo,
   IN  EFI_DISK_IO_PROTOCOL        *DiskIo,
-  IN  EFI_PARTITION_TABLE_HEADER  *PartHeader
+  IN  EFI_PARTITION_TABLE_HEADER  *PartHeader,
+  IN  PARTITION_PROBE             *Probe OPTIONAL    // MU_CHANGE - Parallel media probing
   );
 
 /**
@@ -207,8 +211,10 @@ PartitionInstallGptChildHandles (
   HARDDRIVE_DEVICE_PATH        HdDev;
   UINT32                       MediaId;
   EFI_PARTITION_INFO_PROTOCOL  PartitionInfo;
+  PARTITION_PROBE              *Probe;         // MU_CHANGE - Parallel media probing
 
   ProtectiveMbr = NULL;
+  Probe         = NULL;  // MU_CHANGE - Parallel media probing
   PrimaryHeader = NULL;
   BackupHeader  = NULL;
   PartEntry     = NULL;
@@ -238,16 +244,24 @@ PartitionInstallGptChildHandles (
     return EFI_NOT_FOUND;
   }
 
+  // MU_CHANGE [BEGIN] - Parallel media probing
+  //
+  // Use the data read ahead by the probe of the disk, if any.
+  //
+  Probe = PartitionProbeAcquire (Handle, BlockIo);
+
   //
   // Read the Protective MBR from LBA #0
   //
-  Status = DiskIo->ReadDisk (
-                     DiskIo,
-                     MediaId,
-                     0,
-                     BlockSize,
-                     ProtectiveMbr
-                     );
+  Status = PartitionProbeReadDisk (
+             Probe,
+             DiskIo,
+             MediaId,
+             0,
+             BlockSize,
+             ProtectiveMbr
+             );
+  // MU_CHANGE [END]
   if (EFI_ERROR (Status)) {
     GptValidStatus = Status;
     goto Done;
@@ -285,31 +299,42 @@ PartitionInstallGptChildHandles (
   //
   // Check primary and backup partition tables
   //
-  if (!PartitionValidGptTable (BlockIo, DiskIo, PRIMARY_PART_HEADER_LBA, PrimaryHeader)) {
+  if (!PartitionValidGptTable (BlockIo, DiskIo, PRIMARY_PART_HEADER_LBA, PrimaryHeader, Probe)) {  // MU_CHANGE - Parallel media probing
     DEBUG ((DEBUG_INFO, " Not Valid primary partition table\n"));
 
-    if (!PartitionValidGptTable (BlockIo, DiskIo, LastBlock, BackupHeader)) {
+    if (!PartitionValidGptTable (BlockIo, DiskIo, LastBlock, BackupHeader, Probe)) {  // MU_CHANGE - Parallel media probing
       DEBUG ((DEBUG_INFO, " Not Valid backup partition table\n"));
       goto Done;
     } else {
       DEBUG ((DEBUG_INFO, " Valid backup partition table\n"));
       DEBUG ((DEBUG_INFO, " Restore primary partition table by the backup\n"));
+      // MU_CHANGE [BEGIN] - Parallel media probing
+      //
+      // The data read ahead is stale once the table is restored.
+      //
+      PartitionProbeFree (Probe);
+      Probe = NULL;
+      // MU_CHANGE [END]
       if (!PartitionRestoreGptTable (BlockIo, DiskIo, BackupHeader)) {
         DEBUG ((DEBUG_INFO, " Restore primary partition table error\n"));
       }
 
-      if (PartitionValidGptTable (BlockIo, DiskIo, BackupHeader->AlternateLBA, PrimaryHeader)) {
+      if (PartitionValidGptTable (BlockIo, DiskIo, BackupHeader->AlternateLBA, PrimaryHeader, NULL)) {  // MU_CHANGE - Parallel media probing
         DEBUG ((DEBUG_INFO, " Restore backup partition table success\n"));
       }
     }
-  } else if (!PartitionValidGptTable (BlockIo, DiskIo, PrimaryHeader->AlternateLBA, BackupHeader)) {
+  } else if (!PartitionValidGptTable (BlockIo, DiskIo, PrimaryHeader->AlternateLBA, BackupHeader, Probe)) {  // MU_CHANGE - Parallel media probing
     DEBUG ((DEBUG_INFO, " Valid primary and !Valid backup partition table\n"));
     DEBUG ((DEBUG_INFO, " Restore backup partition table by the primary\n"));
+    // MU_CHANGE [BEGIN] - Parallel media probing
+    PartitionProbeFree (Probe);
+    Probe = NULL;
+    // MU_CHANGE [END]
     if (!PartitionRestoreGptTable (BlockIo, DiskIo, PrimaryHeader)) {
       DEBUG ((DEBUG_INFO, " Restore backup partition table error\n"));
     }
 
-    if (PartitionValidGptTable (BlockIo, DiskIo, PrimaryHeader->AlternateLBA, BackupHeader)) {
+    if (PartitionValidGptTable (BlockIo, DiskIo, PrimaryHeader->AlternateLBA, BackupHeader, NULL)) {  // MU_CHANGE - Parallel media probing
       DEBUG ((DEBUG_INFO, " Restore backup partition table success\n"));
     }
   }
@@ -325,13 +350,16 @@ PartitionInstallGptChildHandles (
     goto Done;
   }
 
-  Status = DiskIo->ReadDisk (
-                     DiskIo,
-                     MediaId,
-                     MultU64x32 (PrimaryHeader->PartitionEntryLBA, BlockSize),
-                     PrimaryHeader->NumberOfPartitionEntries * (PrimaryHeader->SizeOfPartitionEntry),
-                     PartEntry
-                     );
+  // MU_CHANGE [BEGIN] - Parallel media probing
+  Status = PartitionProbeReadDisk (
+             Probe,
+             DiskIo,
+             MediaId,
+             MultU64x32 (PrimaryHeader->PartitionEntryLBA, BlockSize),
+             PrimaryHeader->NumberOfPartitionEntries * (PrimaryHeader->SizeOfPartitionEntry),
+             PartEntry
+             );
+  // MU_CHANGE [END]
   if (EFI_ERROR (Status)) {
     GptValidStatus = Status;
     DEBUG ((DEBUG_ERROR, " Partition Entry ReadDisk error\n"));
@@ -424,6 +452,8 @@ PartitionInstallGptChildHandles (
   DEBUG ((DEBUG_INFO, "Prepare to Free Pool\n"));
 
 Done:
+  PartitionProbeFree (Probe);   // MU_CHANGE - Parallel media probing
+
   if (ProtectiveMbr != NULL) {
     FreePool (ProtectiveMbr);
   }
@@ -458,6 +488,7 @@ Done:
   @param[in]  DiskIo      Disk Io protocol.
   @param[in]  Lba         The starting Lba of the Partition Table
   @param[out] PartHeader  Stores the partition table that is read
+  @param[in]  Probe       The probe of the disk, may be NULL.
 
   @retval TRUE      The partition table is valid
   @retval FALSE     The partition table is not valid
@@ -468,7 +499,8 @@ PartitionValidGptTable (
   IN  EFI_BLOCK_IO_PROTOCOL       *BlockIo,
   IN  EFI_DISK_IO_PROTOCOL        *DiskIo,
   IN  EFI_LBA                     Lba,
-  OUT EFI_PARTITION_TABLE_HEADER  *PartHeader
+  OUT EFI_PARTITION_TABLE_HEADER  *PartHeader,
+  IN  PARTITION_PROBE             *Probe OPTIONAL    // MU_CHANGE - Parallel media probing
   )
 {
   EFI_STATUS                  Status;
@@ -488,13 +520,16 @@ PartitionValidGptTable (
   //
   // Read the EFI Partition Table Header
   //
-  Status = DiskIo->ReadDisk (
-                     DiskIo,
-                     MediaId,
-                     MultU64x32 (Lba, BlockSize),
-                     BlockSize,
-                     PartHdr
-                     );
+  // MU_CHANGE [BEGIN] - Parallel media probing
+  Status = PartitionProbeReadDisk (
+             Probe,
+             DiskIo,
+             MediaId,
+             MultU64x32 (Lba, BlockSize),
+             BlockSize,
+             PartHdr
+             );
+  // MU_CHANGE [END]
   if (EFI_ERROR (Status)) {
     FreePool (PartHdr);
     return FALSE;
@@ -520,7 +555,7 @@ PartitionValidGptTable (
   }
 
   CopyMem (PartHeader, PartHdr, sizeof (EFI_PARTITION_TABLE_HEADER));
-  if (!PartitionCheckGptEntryArrayCRC (BlockIo, DiskIo, PartHeader)) {
+  if (!PartitionCheckGptEntryArrayCRC (BlockIo, DiskIo, PartHeader, Probe)) {  // MU_CHANGE - Parallel media probing
     FreePool (PartHdr);
     return FALSE;
   }
@@ -537,6 +572,7 @@ PartitionValidGptTable (
   @param[in]  BlockIo     Parent BlockIo interface
   @param[in]  DiskIo      Disk Io Protocol.
   @param[in]  PartHeader  Partition table header structure
+  @param[in]  Probe       The probe of the disk, may be NULL.
 
   @retval TRUE      the CRC is valid
   @retval FALSE     the CRC is invalid
@@ -546,7 +582,8 @@ BOOLEAN
 PartitionCheckGptEntryArrayCRC (
   IN  EFI_BLOCK_IO_PROTOCOL       *BlockIo,
   IN  EFI_DISK_IO_PROTOCOL        *DiskIo,
-  IN  EFI_PARTITION_TABLE_HEADER  *PartHeader
+  IN  EFI_PARTITION_TABLE_HEADER  *PartHeader,
+  IN  PARTITION_PROBE             *Probe OPTIONAL    // MU_CHANGE - Parallel media probing
   )
 {
   EFI_STATUS  Status;
@@ -563,13 +600,16 @@ PartitionCheckGptEntryArrayCRC (
     return FALSE;
   }
 
-  Status = DiskIo->ReadDisk (
-                     DiskIo,
-                     BlockIo->Media->MediaId,
-                     MultU64x32 (PartHeader->PartitionEntryLBA, BlockIo->Media->BlockSize),
-                     PartHeader->NumberOfPartitionEntries * PartHeader->SizeOfPartitionEntry,
-                     Ptr
-                     );
+  // MU_CHANGE [BEGIN] - Parallel media probing
+  Status = PartitionProbeReadDisk (
+             Probe,
+             DiskIo,
+             BlockIo->Media->MediaId,
+             MultU64x32 (PartHeader->PartitionEntryLBA, BlockIo->Media->BlockSize),
+             PartHeader->NumberOfPartitionEntries * PartHeader->SizeOfPartitionEntry,
+             Ptr
+             );
+  // MU_CHANGE [END]
   if (EFI_ERROR (Status)) {
     FreePool (Ptr);
     return FALSE;
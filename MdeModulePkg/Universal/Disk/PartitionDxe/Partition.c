@@ -208,6 +208,17 @@ PartitionDriverBindingStart (
   BOOLEAN                   MediaPresent;
   EFI_TPL                   OldTpl;
 
+  // MU_CHANGE [BEGIN] - Parallel media probing
+  //
+  // Give the reads of the probe of the disk time to complete, while their
+  // notification functions can still run.
+  //
+  if (PcdGetBool (PcdPartitionParallelProbe)) {
+    PartitionProbeWait (ControllerHandle);
+  }
+
+  // MU_CHANGE [END]
+
   BlockIo2 = NULL;
   OldTpl   = gBS->RaiseTPL (TPL_CALLBACK);
   //
@@ -1339,6 +1350,15 @@ InitializePartition (
              );
   ASSERT_EFI_ERROR (Status);
 
+  // MU_CHANGE [BEGIN] - Parallel media probing
+  if (!EFI_ERROR (Status) && PcdGetBool (PcdPartitionParallelProbe)) {
+    if (EFI_ERROR (PartitionProbeInitialize ())) {
+      DEBUG ((DEBUG_WARN, "%a: Parallel media probing not available\n", __func__));
+    }
+  }
+
+  // MU_CHANGE [END]
+
   return Status;
 }
 
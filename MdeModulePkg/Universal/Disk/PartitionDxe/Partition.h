@@ -480,4 +480,134 @@ EFI_STATUS
   IN  EFI_DEVICE_PATH_PROTOCOL     *DevicePath
   );
 
+// MU_CHANGE [BEGIN] - Parallel media probing
+//
+// Bytes of the GPT partition entry array read ahead behind each GPT header,
+// enough for the 128 entries of 128 bytes which partitioning tools create.
+//
+#define PARTITION_PROBE_ENTRY_ARRAY_SIZE  (128 * sizeof (EFI_PARTITION_ENTRY))
+
+//
+// Time to wait for the reads of a probe before the driver starts on its
+// disk, and the interval at which they are checked, in microseconds. The
+// driver only waits at TPL_APPLICATION, and reads the disk itself when the
+// reads did not complete.
+//
+#define PARTITION_PROBE_TIMEOUT        3000000
+#define PARTITION_PROBE_POLL_INTERVAL  100
+
+typedef struct _PARTITION_PROBE PARTITION_PROBE;
+
+typedef struct {
+  PARTITION_PROBE        *Probe;
+  EFI_LBA                Lba;
+  UINTN                  Size;
+  UINT8                  *Buffer;
+  EFI_BLOCK_IO2_TOKEN    Token;
+  //
+  // EFI_NOT_READY until the read completes.
+  //
+  EFI_STATUS             Status;
+} PARTITION_PROBE_READ;
+
+#define PARTITION_PROBE_SIGNATURE  SIGNATURE_32 ('P', 'r', 'b', 'e')
+
+//
+// Reads issued through BlockIo2 for a disk as soon as its BlockIo2 protocol
+// is installed: the protective MBR, the primary GPT header and the entry
+// array behind it in one read, the backup entry array and GPT header in
+// another one.
+//
+struct _PARTITION_PROBE {
+  UINT32                    Signature;
+  LIST_ENTRY                Link;
+  EFI_HANDLE                Handle;
+  //
+  // The protocol the reads were issued through.
+  //
+  EFI_BLOCK_IO2_PROTOCOL    *BlockIo2;
+  UINT32                    MediaId;
+  UINT32                    BlockSize;
+  volatile UINTN            Pending;
+  //
+  // Set when the probe was dropped with reads in flight, the last completing
+  // read frees the probe.
+  //
+  BOOLEAN                   Abandoned;
+  PARTITION_PROBE_READ      Reads[2];
+};
+
+/**
+  Start probing the disks whose BlockIo2 protocol is installed from now on.
+
+  @retval EFI_SUCCESS  The probing is enabled.
+  @retval Others       The probing could not be enabled.
+**/
+EFI_STATUS
+PartitionProbeInitialize (
+  VOID
+  );
+
+/**
+  Give the reads of the probe of a disk time to complete, before the driver
+  starts on the disk. Only waits at TPL_APPLICATION.
+
+  @param[in]  Handle  The handle of the disk.
+**/
+VOID
+PartitionProbeWait (
+  IN EFI_HANDLE  Handle
+  );
+
+/**
+  Take the probe of a disk, if its reads are all completed. This does not
+  wait for the reads, see PartitionProbeWait ().
+
+  @param[in]  Handle   The handle of the disk.
+  @param[in]  BlockIo  The BlockIo protocol of the disk.
+
+  @return The probe of the disk, to be freed with PartitionProbeFree (), or
+          NULL if there is no usable probe for the disk.
+**/
+PARTITION_PROBE *
+PartitionProbeAcquire (
+  IN EFI_HANDLE             Handle,
+  IN EFI_BLOCK_IO_PROTOCOL  *BlockIo
+  );
+
+/**
+  Free a probe taken with PartitionProbeAcquire ().
+
+  @param[in]  Probe  The probe to free, may be NULL.
+**/
+VOID
+PartitionProbeFree (
+  IN PARTITION_PROBE  *Probe
+  );
+
+/**
+  Read from a disk, using the data read ahead by its probe when it covers the
+  request.
+
+  @param[in]  Probe       The probe of the disk, may be NULL.
+  @param[in]  DiskIo      The DiskIo protocol of the disk.
+  @param[in]  MediaId     ID of the medium to be read.
+  @param[in]  Offset      The starting byte offset to read from.
+  @param[in]  BufferSize  The number of bytes to read.
+  @param[out] Buffer      The destination buffer.
+
+  @return The status of the read.
+**/
+EFI_STATUS
+PartitionProbeReadDisk (
+  IN  PARTITION_PROBE       *Probe OPTIONAL,
+  IN  EFI_DISK_IO_PROTOCOL  *DiskIo,
+  IN  UINT32                MediaId,
+  IN  UINT64                Offset,
+  IN  UINTN                 BufferSize,
+  OUT VOID                  *Buffer
+  );
+
+// MU_CHANGE [END]
+
 #endif
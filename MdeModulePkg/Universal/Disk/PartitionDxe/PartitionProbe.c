@@ -0,0 +1,595 @@
+/** @file
+  Parallel media probing.
+
+  The driver binding protocol starts the partition driver on one disk at a
+  time, and each start reads the partition tables of its disk with blocking
+  reads. To overlap these reads across disks, the GPT structures of a disk are
+  read through BlockIo2 as soon as its BlockIo2 protocol is installed, with
+  all the reads of all the disks in flight together. When the driver starts
+  on a disk, the GPT detection validates the data already read instead of
+  reading it again.
+
+  The driver starts at TPL_CALLBACK, where the reads cannot be waited for. It
+  gives them time to complete before it raises the TPL, and only takes a probe
+  whose reads are all completed. Otherwise it reads the disk itself.
+
+  The data read ahead must not outlive a change of the disk. A
+  reinstallation of the BlockIo or BlockIo2 protocol of the disk drops its
+  probe. When the driver takes the probe, the probe is only used if the disk
+  still has the same BlockIo2 protocol and media.
+
+  Caution: This file requires additional review when modified.
+  The data read ahead is external input, it goes through the same validation
+  as the data read by the GPT detection itself.
+
+Copyright (c) Microsoft Corporation.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "Partition.h"
+
+//
+// The probes are updated at TPL_NOTIFY, the TPL of their read completions.
+//
+STATIC LIST_ENTRY  mPartitionProbes = INITIALIZE_LIST_HEAD_VARIABLE (mPartitionProbes);
+STATIC EFI_EVENT   mPartitionProbeEvent;
+STATIC VOID        *mPartitionProbeRegistration;
+STATIC EFI_EVENT   mPartitionProbeBlockIoEvent;
+STATIC VOID        *mPartitionProbeBlockIoRegistration;
+
+/**
+  Free a probe whose reads are all completed.
+
+  @param[in]  Probe  The probe to free.
+**/
+STATIC
+VOID
+PartitionProbeRelease (
+  IN PARTITION_PROBE  *Probe
+  )
+{
+  UINTN  Index;
+
+  ASSERT (Probe->Pending == 0);
+
+  for (Index = 0; Index < ARRAY_SIZE (Probe->Reads); Index++) {
+    if (Probe->Reads[Index].Buffer != NULL) {
+      FreeAlignedPages (Probe->Reads[Index].Buffer, EFI_SIZE_TO_PAGES (Probe->Reads[Index].Size));
+    }
+  }
+
+  FreePool (Probe);
+}
+
+/**
+  Free a probe, or let its last completing read free it.
+
+  @param[in]  Probe  The probe, removed from mPartitionProbes.
+**/
+STATIC
+VOID
+PartitionProbeDiscard (
+  IN PARTITION_PROBE  *Probe
+  )
+{
+  EFI_TPL  OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  if (Probe->Pending == 0) {
+    PartitionProbeRelease (Probe);
+  } else {
+    Probe->Abandoned = TRUE;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Find the probe of a disk.
+
+  @param[in]  Handle  The handle of the disk.
+
+  @return The probe of the disk, or NULL.
+**/
+STATIC
+PARTITION_PROBE *
+PartitionProbeFind (
+  IN EFI_HANDLE  Handle
+  )
+{
+  LIST_ENTRY       *Link;
+  PARTITION_PROBE  *Probe;
+
+  for (Link = GetFirstNode (&mPartitionProbes); !IsNull (&mPartitionProbes, Link); Link = GetNextNode (&mPartitionProbes, Link)) {
+    Probe = CR (Link, PARTITION_PROBE, Link, PARTITION_PROBE_SIGNATURE);
+    if (Probe->Handle == Handle) {
+      return Probe;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Drop the probe of a disk, if any.
+
+  @param[in]  Handle  The handle of the disk.
+**/
+STATIC
+VOID
+PartitionProbeDrop (
+  IN EFI_HANDLE  Handle
+  )
+{
+  PARTITION_PROBE  *Probe;
+  EFI_TPL          OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Probe  = PartitionProbeFind (Handle);
+  if (Probe != NULL) {
+    RemoveEntryList (&Probe->Link);
+    PartitionProbeDiscard (Probe);
+  }
+
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  The callback for the BlockIo2 ReadBlocksEx of a probe.
+
+  @param[in]  Event    Event whose notification function is being invoked.
+  @param[in]  Context  The pointer to the notification function's context,
+                       which points to the PARTITION_PROBE_READ instance.
+**/
+STATIC
+VOID
+EFIAPI
+PartitionProbeOnReadComplete (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  PARTITION_PROBE_READ  *Read;
+  PARTITION_PROBE       *Probe;
+
+  Read  = (PARTITION_PROBE_READ *)Context;
+  Probe = Read->Probe;
+  ASSERT (Probe->Signature == PARTITION_PROBE_SIGNATURE);
+
+  gBS->CloseEvent (Event);
+  Read->Token.Event = NULL;
+  Read->Status      = Read->Token.TransactionStatus;
+
+  ASSERT (Probe->Pending > 0);
+  Probe->Pending--;
+  if ((Probe->Pending == 0) && Probe->Abandoned) {
+    PartitionProbeRelease (Probe);
+  }
+}
+
+/**
+  Issue the reads of the probe of a disk.
+
+  @param[in]  Handle  The handle of the disk, with a BlockIo2 protocol.
+**/
+STATIC
+VOID
+PartitionProbeStart (
+  IN EFI_HANDLE  Handle
+  )
+{
+  EFI_STATUS              Status;
+  EFI_BLOCK_IO2_PROTOCOL  *BlockIo2;
+  EFI_BLOCK_IO_MEDIA      *Media;
+  PARTITION_PROBE         *Probe;
+  PARTITION_PROBE_READ    *Read;
+  UINTN                   EntryBlocks;
+  UINTN                   Index;
+  EFI_TPL                 OldTpl;
+
+  //
+  // A new media replaces the probe of the previous one.
+  //
+  PartitionProbeDrop (Handle);
+
+  Status = gBS->HandleProtocol (Handle, &gEfiBlockIo2ProtocolGuid, (VOID **)&BlockIo2);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  //
+  // The partitions installed by this driver are not probed.
+  //
+  Media = BlockIo2->Media;
+  if (!Media->MediaPresent || Media->LogicalPartition || (Media->BlockSize < sizeof (MASTER_BOOT_RECORD))) {
+    return;
+  }
+
+  EntryBlocks = (PARTITION_PROBE_ENTRY_ARRAY_SIZE + Media->BlockSize - 1) / Media->BlockSize;
+  if (Media->LastBlock < 2 * (EntryBlocks + 2)) {
+    return;
+  }
+
+  Probe = AllocateZeroPool (sizeof (PARTITION_PROBE));
+  if (Probe == NULL) {
+    return;
+  }
+
+  Probe->Signature = PARTITION_PROBE_SIGNATURE;
+  Probe->Handle    = Handle;
+  Probe->BlockIo2  = BlockIo2;
+  Probe->MediaId   = Media->MediaId;
+  Probe->BlockSize = Media->BlockSize;
+
+  //
+  // Protective MBR, primary GPT header and primary entry array.
+  //
+  Probe->Reads[0].Lba  = 0;
+  Probe->Reads[0].Size = (PRIMARY_PART_HEADER_LBA + 1 + EntryBlocks) * Media->BlockSize;
+
+  //
+  // Backup entry array and backup GPT header.
+  //
+  Probe->Reads[1].Lba  = Media->LastBlock - EntryBlocks;
+  Probe->Reads[1].Size = (EntryBlocks + 1) * Media->BlockSize;
+
+  for (Index = 0; Index < ARRAY_SIZE (Probe->Reads); Index++) {
+    Read         = &Probe->Reads[Index];
+    Read->Probe  = Probe;
+    Read->Buffer = AllocateAlignedPages (EFI_SIZE_TO_PAGES (Read->Size), Media->IoAlign);
+    if (Read->Buffer == NULL) {
+      Read->Status = EFI_OUT_OF_RESOURCES;
+      continue;
+    }
+
+    Read->Status = gBS->CreateEvent (
+                          EVT_NOTIFY_SIGNAL,
+                          TPL_NOTIFY,
+                          PartitionProbeOnReadComplete,
+                          Read,
+                          &Read->Token.Event
+                          );
+    if (EFI_ERROR (Read->Status)) {
+      continue;
+    }
+
+    //
+    // The read may complete before ReadBlocksEx () returns.
+    //
+    Read->Status = EFI_NOT_READY;
+    Probe->Pending++;
+    Status = BlockIo2->ReadBlocksEx (BlockIo2, Probe->MediaId, Read->Lba, &Read->Token, Read->Size, Read->Buffer);
+    if (EFI_ERROR (Status)) {
+      Probe->Pending--;
+      gBS->CloseEvent (Read->Token.Event);
+      Read->Token.Event = NULL;
+      Read->Status      = Status;
+    }
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  InsertTailList (&mPartitionProbes, &Probe->Link);
+  DEBUG ((DEBUG_INFO, "PartitionProbe: Probing %p, %d reads in flight\n", Handle, Probe->Pending));
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Probe the disks whose BlockIo2 protocol was installed or reinstalled.
+
+  @param[in]  Event    Event whose notification function is being invoked.
+  @param[in]  Context  Unused.
+**/
+STATIC
+VOID
+EFIAPI
+PartitionProbeOnBlockIo2Installed (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_STATUS  Status;
+  EFI_HANDLE  Handle;
+  UINTN       BufferSize;
+
+  while (TRUE) {
+    BufferSize = sizeof (EFI_HANDLE);
+    Status     = gBS->LocateHandle (ByRegisterNotify, NULL, mPartitionProbeRegistration, &BufferSize, &Handle);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    PartitionProbeStart (Handle);
+  }
+}
+
+/**
+  Drop the probes of the disks whose BlockIo protocol was reinstalled.
+
+  @param[in]  Event    Event whose notification function is being invoked.
+  @param[in]  Context  Unused.
+**/
+STATIC
+VOID
+EFIAPI
+PartitionProbeOnBlockIoInstalled (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_STATUS  Status;
+  EFI_HANDLE  Handle;
+  UINTN       BufferSize;
+
+  while (TRUE) {
+    BufferSize = sizeof (EFI_HANDLE);
+    Status     = gBS->LocateHandle (ByRegisterNotify, NULL, mPartitionProbeBlockIoRegistration, &BufferSize, &Handle);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    PartitionProbeDrop (Handle);
+  }
+}
+
+/**
+  Stop probing and drop the probes the driver did not take.
+
+  @param[in]  Event    Event whose notification function is being invoked.
+  @param[in]  Context  Unused.
+**/
+STATIC
+VOID
+EFIAPI
+PartitionProbeOnReadyToBoot (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  PARTITION_PROBE  *Probe;
+  EFI_TPL          OldTpl;
+
+  gBS->CloseEvent (Event);
+  if (mPartitionProbeEvent != NULL) {
+    gBS->CloseEvent (mPartitionProbeEvent);
+    mPartitionProbeEvent = NULL;
+  }
+
+  if (mPartitionProbeBlockIoEvent != NULL) {
+    gBS->CloseEvent (mPartitionProbeBlockIoEvent);
+    mPartitionProbeBlockIoEvent = NULL;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  while (!IsListEmpty (&mPartitionProbes)) {
+    Probe = CR (GetFirstNode (&mPartitionProbes), PARTITION_PROBE, Link, PARTITION_PROBE_SIGNATURE);
+    RemoveEntryList (&Probe->Link);
+    PartitionProbeDiscard (Probe);
+  }
+
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Start probing the disks whose BlockIo2 protocol is installed from now on.
+
+  @retval EFI_SUCCESS  The probing is enabled.
+  @retval Others       The probing could not be enabled.
+**/
+EFI_STATUS
+PartitionProbeInitialize (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  EFI_EVENT   ReadyToBootEvent;
+
+  Status = EfiCreateEventReadyToBootEx (
+             TPL_CALLBACK,
+             PartitionProbeOnReadyToBoot,
+             NULL,
+             &ReadyToBootEvent
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // A disk whose BlockIo protocol is reinstalled may have changed. This
+  // notification is registered first, otherwise its initial pass over the
+  // installed disks would drop the probes just issued for them.
+  //
+  mPartitionProbeBlockIoEvent = EfiCreateProtocolNotifyEvent (
+                                  &gEfiBlockIoProtocolGuid,
+                                  TPL_CALLBACK,
+                                  PartitionProbeOnBlockIoInstalled,
+                                  NULL,
+                                  &mPartitionProbeBlockIoRegistration
+                                  );
+  if (mPartitionProbeBlockIoEvent == NULL) {
+    gBS->CloseEvent (ReadyToBootEvent);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Also probes the disks whose BlockIo2 protocol is already installed.
+  //
+  mPartitionProbeEvent = EfiCreateProtocolNotifyEvent (
+                           &gEfiBlockIo2ProtocolGuid,
+                           TPL_CALLBACK,
+                           PartitionProbeOnBlockIo2Installed,
+                           NULL,
+                           &mPartitionProbeRegistration
+                           );
+  if (mPartitionProbeEvent == NULL) {
+    gBS->CloseEvent (mPartitionProbeBlockIoEvent);
+    mPartitionProbeBlockIoEvent = NULL;
+    gBS->CloseEvent (ReadyToBootEvent);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Give the reads of the probe of a disk time to complete, before the driver
+  starts on the disk.
+
+  The reads complete in the notification functions of their events, which
+  the driver would hold off at TPL_CALLBACK. The wait only happens at
+  TPL_APPLICATION, where the notification functions of any TPL can run.
+
+  @param[in]  Handle  The handle of the disk.
+**/
+VOID
+PartitionProbeWait (
+  IN EFI_HANDLE  Handle
+  )
+{
+  PARTITION_PROBE  *Probe;
+  BOOLEAN          Pending;
+  UINTN            Waited;
+  EFI_TPL          OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  gBS->RestoreTPL (OldTpl);
+  if (OldTpl != TPL_APPLICATION) {
+    return;
+  }
+
+  //
+  // The probe may be dropped while waiting, so it is looked up again each
+  // time.
+  //
+  for (Waited = 0; Waited < PARTITION_PROBE_TIMEOUT; Waited += PARTITION_PROBE_POLL_INTERVAL) {
+    OldTpl  = gBS->RaiseTPL (TPL_NOTIFY);
+    Probe   = PartitionProbeFind (Handle);
+    Pending = (BOOLEAN)((Probe != NULL) && (Probe->Pending != 0));
+    gBS->RestoreTPL (OldTpl);
+    if (!Pending) {
+      return;
+    }
+
+    gBS->Stall (PARTITION_PROBE_POLL_INTERVAL);
+  }
+
+  DEBUG ((DEBUG_WARN, "PartitionProbe: Reads of %p did not complete\n", Handle));
+}
+
+/**
+  Take the probe of a disk, if its reads are all completed. This does not
+  wait for the reads, see PartitionProbeWait ().
+
+  @param[in]  Handle   The handle of the disk.
+  @param[in]  BlockIo  The BlockIo protocol of the disk.
+
+  @return The probe of the disk, to be freed with PartitionProbeFree (), or
+          NULL if there is no usable probe for the disk.
+**/
+PARTITION_PROBE *
+PartitionProbeAcquire (
+  IN EFI_HANDLE             Handle,
+  IN EFI_BLOCK_IO_PROTOCOL  *BlockIo
+  )
+{
+  EFI_STATUS              Status;
+  PARTITION_PROBE         *Probe;
+  EFI_BLOCK_IO2_PROTOCOL  *BlockIo2;
+  BOOLEAN                 Usable;
+  EFI_TPL                 OldTpl;
+
+  Status = gBS->HandleProtocol (Handle, &gEfiBlockIo2ProtocolGuid, (VOID **)&BlockIo2);
+  if (EFI_ERROR (Status)) {
+    BlockIo2 = NULL;
+  }
+
+  //
+  // Once taken, the probe belongs to the driver, which drops it before it
+  // writes to the disk. A probe is not usable if its reads are still in
+  // flight, or if it was issued through another BlockIo2 protocol or for
+  // another media.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Probe  = PartitionProbeFind (Handle);
+  Usable = FALSE;
+  if (Probe != NULL) {
+    RemoveEntryList (&Probe->Link);
+    Usable = (BOOLEAN)((Probe->Pending == 0) && (Probe->BlockIo2 == BlockIo2) &&
+                       (Probe->MediaId == BlockIo->Media->MediaId));
+  }
+
+  gBS->RestoreTPL (OldTpl);
+  if (Probe == NULL) {
+    return NULL;
+  }
+
+  if (!Usable) {
+    DEBUG ((DEBUG_WARN, "PartitionProbe: Probe of %p not usable, read the disk\n", Handle));
+    PartitionProbeDiscard (Probe);
+    return NULL;
+  }
+
+  return Probe;
+}
+
+/**
+  Free a probe taken with PartitionProbeAcquire ().
+
+  @param[in]  Probe  The probe to free, may be NULL.
+**/
+VOID
+PartitionProbeFree (
+  IN PARTITION_PROBE  *Probe
+  )
+{
+  if (Probe != NULL) {
+    PartitionProbeRelease (Probe);
+  }
+}
+
+/**
+  Read from a disk, using the data read ahead by its probe when it covers the
+  request.
+
+  @param[in]  Probe       The probe of the disk, may be NULL.
+  @param[in]  DiskIo      The DiskIo protocol of the disk.
+  @param[in]  MediaId     ID of the medium to be read.
+  @param[in]  Offset      The starting byte offset to read from.
+  @param[in]  BufferSize  The number of bytes to read.
+  @param[out] Buffer      The destination buffer.
+
+  @return The status of the read.
+**/
+EFI_STATUS
+PartitionProbeReadDisk (
+  IN  PARTITION_PROBE       *Probe OPTIONAL,
+  IN  EFI_DISK_IO_PROTOCOL  *DiskIo,
+  IN  UINT32                MediaId,
+  IN  UINT64                Offset,
+  IN  UINTN                 BufferSize,
+  OUT VOID                  *Buffer
+  )
+{
+  PARTITION_PROBE_READ  *Read;
+  UINT64                Start;
+  UINTN                 Index;
+
+  if ((Probe != NULL) && (Probe->MediaId == MediaId)) {
+    for (Index = 0; Index < ARRAY_SIZE (Probe->Reads); Index++) {
+      Read = &Probe->Reads[Index];
+      if (EFI_ERROR (Read->Status)) {
+        continue;
+      }
+
+      Start = MultU64x32 (Read->Lba, Probe->BlockSize);
+      if ((Offset >= Start) && (Offset - Start <= Read->Size) &&
+          (BufferSize <= Read->Size - (UINTN)(Offset - Start)))
+      {
+        CopyMem (Buffer, Read->Buffer + (UINTN)(Offset - Start), BufferSize);
+        return EFI_SUCCESS;
+      }
+    }
+  }
+
+  return DiskIo->ReadDisk (DiskIo, MediaId, Offset, BufferSize, Buffer);
+}
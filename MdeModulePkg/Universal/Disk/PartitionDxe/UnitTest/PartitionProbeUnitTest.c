@@ -0,0 +1,1316 @@
+/** @file -- PartitionProbeUnitTest.c
+  Host based unit tests for the parallel media probing of the partition driver.
+
+  The probes run on a RAM backed disk with BlockIo, BlockIo2 and DiskIo
+  protocols, whose BlockIo2 reads can be held back to model a slow or hung
+  device, and on mock boot services with just enough events, TPLs and stalls
+  for the probes.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../Partition.h"
+
+#define UNIT_TEST_APP_NAME     "Partition Probe Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define MOCK_DISK_BLOCK_SIZE  512
+#define MOCK_DISK_BLOCKS      0x800
+#define MOCK_DISK_MEDIA_ID    1
+#define MOCK_DISK_HANDLE      ((EFI_HANDLE)&mMockDisk)
+
+//
+// Blocks of the GPT entry array read ahead behind each GPT header.
+//
+#define TEST_ENTRY_BLOCKS  (PARTITION_PROBE_ENTRY_ARRAY_SIZE / MOCK_DISK_BLOCK_SIZE)
+
+#define MOCK_MAX_EVENTS  32
+#define MOCK_MAX_READS   4
+
+typedef struct {
+  UINT32              Type;
+  EFI_TPL             NotifyTpl;
+  EFI_EVENT_NOTIFY    Notify;
+  VOID                *Context;
+  BOOLEAN             Signaled;
+} MOCK_EVENT;
+
+typedef struct {
+  EFI_BLOCK_IO2_TOKEN    *Token;
+  EFI_LBA                Lba;
+  UINTN                  Size;
+  VOID                   *Buffer;
+} MOCK_READ;
+
+typedef struct {
+  EFI_BLOCK_IO_PROTOCOL     BlockIo;
+  EFI_BLOCK_IO2_PROTOCOL    BlockIo2;
+  EFI_DISK_IO_PROTOCOL      DiskIo;
+  EFI_BLOCK_IO_MEDIA        Media;
+  UINT8                     *Disk;
+  BOOLEAN                   Installed;
+  //
+  // BlockIo2 reads held back until MockDiskCompleteReads (), or until the
+  // driver stalls unless the device is hung.
+  //
+  BOOLEAN                   DeferReads;
+  BOOLEAN                   Hung;
+  MOCK_READ                 Reads[MOCK_MAX_READS];
+  UINTN                     ReadCount;
+  //
+  // Accesses reaching the device.
+  //
+  UINTN                     WriteCalls;
+  UINTN                     ResetCalls;
+  UINTN                     DiskIoReads;
+} MOCK_DISK;
+
+//
+// The protocol notifications registered by the probing.
+//
+typedef enum {
+  MockNotifyBlockIo,
+  MockNotifyBlockIo2,
+  MockNotifyMax
+} MOCK_NOTIFY;
+
+STATIC MOCK_DISK   mMockDisk;
+STATIC MOCK_EVENT  *mMockEvents[MOCK_MAX_EVENTS];
+STATIC UINTN       mMockEventCount;
+STATIC EFI_TPL     mMockTpl = TPL_APPLICATION;
+STATIC UINTN       mMockStalls;
+STATIC UINTN       mMockStallTime;
+
+STATIC EFI_EVENT         mMockNotifyEvent[MockNotifyMax];
+STATIC UINT8             mMockRegistration[MockNotifyMax];
+STATIC BOOLEAN           mMockNotifyPending[MockNotifyMax];
+STATIC EFI_EVENT_NOTIFY  mMockReadyToBoot;
+STATIC EFI_EVENT         mMockReadyToBootEvent;
+
+EFI_BOOT_SERVICES  MockBoot;
+
+/**
+  Run the notification functions of the signaled events above the current TPL.
+**/
+STATIC
+VOID
+MockDispatchEvents (
+  VOID
+  )
+{
+  UINTN       Index;
+  MOCK_EVENT  *Event;
+  EFI_TPL     OldTpl;
+
+  for (Index = 0; Index < MOCK_MAX_EVENTS; Index++) {
+    Event = mMockEvents[Index];
+    if ((Event != NULL) && Event->Signaled && ((Event->Type & EVT_NOTIFY_SIGNAL) != 0) && (Event->NotifyTpl > mMockTpl)) {
+      Event->Signaled = FALSE;
+      OldTpl          = mMockTpl;
+      mMockTpl        = Event->NotifyTpl;
+      Event->Notify (Event, Event->Context);
+      mMockTpl = OldTpl;
+      //
+      // The notification function may have closed or created events.
+      //
+      Index = (UINTN)-1;
+    }
+  }
+}
+
+/**
+  Raise the TPL of the mock boot services.
+
+  @param[in]  NewTpl  The new TPL.
+
+  @return The previous TPL.
+**/
+STATIC
+EFI_TPL
+EFIAPI
+MockRaiseTpl (
+  IN EFI_TPL  NewTpl
+  )
+{
+  EFI_TPL  OldTpl;
+
+  ASSERT (NewTpl >= mMockTpl);
+  OldTpl   = mMockTpl;
+  mMockTpl = NewTpl;
+  return OldTpl;
+}
+
+/**
+  Restore the TPL of the mock boot services.
+
+  @param[in]  OldTpl  The TPL to restore.
+**/
+STATIC
+VOID
+EFIAPI
+MockRestoreTpl (
+  IN EFI_TPL  OldTpl
+  )
+{
+  ASSERT (OldTpl <= mMockTpl);
+  mMockTpl = OldTpl;
+  MockDispatchEvents ();
+}
+
+/**
+  Create a mock event.
+
+  @param[in]  Type            The type of event to create.
+  @param[in]  NotifyTpl       The task priority level of event notifications.
+  @param[in]  NotifyFunction  The notification function, may be NULL.
+  @param[in]  NotifyContext   The context of the notification function.
+  @param[out] Event           The created event.
+
+  @retval EFI_SUCCESS           The event was created.
+  @retval EFI_OUT_OF_RESOURCES  There are too many events.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockCreateEvent (
+  IN  UINT32            Type,
+  IN  EFI_TPL           NotifyTpl,
+  IN  EFI_EVENT_NOTIFY  NotifyFunction OPTIONAL,
+  IN  VOID              *NotifyContext OPTIONAL,
+  OUT EFI_EVENT         *Event
+  )
+{
+  UINTN       Index;
+  MOCK_EVENT  *NewEvent;
+
+  for (Index = 0; Index < MOCK_MAX_EVENTS; Index++) {
+    if (mMockEvents[Index] == NULL) {
+      NewEvent = AllocateZeroPool (sizeof (MOCK_EVENT));
+      if (NewEvent == NULL) {
+        break;
+      }
+
+      NewEvent->Type      = Type;
+      NewEvent->NotifyTpl = NotifyTpl;
+      NewEvent->Notify    = NotifyFunction;
+      NewEvent->Context   = NotifyContext;
+      mMockEvents[Index]  = NewEvent;
+      mMockEventCount++;
+      *Event = NewEvent;
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_OUT_OF_RESOURCES;
+}
+
+/**
+  Close a mock event.
+
+  @param[in]  Event  The event to close.
+
+  @retval EFI_SUCCESS            The event was closed.
+  @retval EFI_INVALID_PARAMETER  The event is not open.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockCloseEvent (
+  IN EFI_EVENT  Event
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < MOCK_MAX_EVENTS; Index++) {
+    if (mMockEvents[Index] == Event) {
+      mMockEvents[Index] = NULL;
+      mMockEventCount--;
+      FreePool (Event);
+      return EFI_SUCCESS;
+    }
+  }
+
+  ASSERT (FALSE);
+  return EFI_INVALID_PARAMETER;
+}
+
+/**
+  Signal a mock event, running its notification function if its TPL is
+  above the current one.
+
+  @param[in]  Event  The event to signal.
+
+  @retval EFI_SUCCESS  The event was signaled.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockSignalEvent (
+  IN EFI_EVENT  Event
+  )
+{
+  ((MOCK_EVENT *)Event)->Signaled = TRUE;
+  MockDispatchEvents ();
+  return EFI_SUCCESS;
+}
+
+/**
+  Complete the BlockIo2 reads held back by the mock disk.
+**/
+STATIC
+VOID
+MockDiskCompleteReads (
+  VOID
+  )
+{
+  MOCK_READ  *Read;
+  UINTN      Count;
+  UINTN      Index;
+
+  Count               = mMockDisk.ReadCount;
+  mMockDisk.ReadCount = 0;
+  for (Index = 0; Index < Count; Index++) {
+    Read = &mMockDisk.Reads[Index];
+    CopyMem (Read->Buffer, mMockDisk.Disk + Read->Lba * MOCK_DISK_BLOCK_SIZE, Read->Size);
+    Read->Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Read->Token->Event);
+  }
+}
+
+/**
+  Stall the mock boot services. Time only passes here: the held back reads of
+  a device which is not hung complete.
+
+  @param[in]  Microseconds  The number of microseconds to stall.
+
+  @retval EFI_SUCCESS  The stall completed.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockStall (
+  IN UINTN  Microseconds
+  )
+{
+  mMockStalls++;
+  mMockStallTime += Microseconds;
+  if ((mMockDisk.ReadCount != 0) && !mMockDisk.Hung) {
+    MockDiskCompleteReads ();
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Look up a protocol of the mock disk.
+
+  @param[in]  Handle     The handle to query.
+  @param[in]  Protocol   The protocol to look up.
+  @param[out] Interface  The protocol interface.
+
+  @retval EFI_SUCCESS      The protocol is installed on the handle.
+  @retval EFI_UNSUPPORTED  The protocol is not installed on the handle.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockHandleProtocol (
+  IN  EFI_HANDLE  Handle,
+  IN  EFI_GUID    *Protocol,
+  OUT VOID        **Interface
+  )
+{
+  if ((Handle != MOCK_DISK_HANDLE) || !mMockDisk.Installed) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (CompareGuid (Protocol, &gEfiBlockIoProtocolGuid)) {
+    *Interface = &mMockDisk.BlockIo;
+  } else if (CompareGuid (Protocol, &gEfiBlockIo2ProtocolGuid)) {
+    *Interface = &mMockDisk.BlockIo2;
+  } else {
+    return EFI_UNSUPPORTED;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Return the mock disk once for each pending installation notification.
+
+  @param[in]      SearchType  Must be ByRegisterNotify.
+  @param[in]      Protocol    Unused.
+  @param[in]      SearchKey   The registration of the notification.
+  @param[in, out] BufferSize  The size of Buffer.
+  @param[out]     Buffer      The returned handle.
+
+  @retval EFI_SUCCESS    The mock disk is returned.
+  @retval EFI_NOT_FOUND  No installation is pending.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockLocateHandle (
+  IN     EFI_LOCATE_SEARCH_TYPE  SearchType,
+  IN     EFI_GUID                *Protocol OPTIONAL,
+  IN     VOID                    *SearchKey OPTIONAL,
+  IN OUT UINTN                   *BufferSize,
+  OUT    EFI_HANDLE              *Buffer
+  )
+{
+  UINTN  Index;
+
+  ASSERT (SearchType == ByRegisterNotify);
+  for (Index = 0; Index < MockNotifyMax; Index++) {
+    if ((SearchKey == &mMockRegistration[Index]) && mMockNotifyPending[Index]) {
+      mMockNotifyPending[Index] = FALSE;
+      *Buffer                   = MOCK_DISK_HANDLE;
+      *BufferSize               = sizeof (EFI_HANDLE);
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Record a protocol notification registered by the probing.
+
+  @param[in]  ProtocolGuid    The protocol to watch.
+  @param[in]  NotifyTpl       The TPL of the notification function.
+  @param[in]  NotifyFunction  The notification function.
+  @param[in]  NotifyContext   The context of the notification function.
+  @param[out] Registration    The registration of the notification.
+
+  @return The notification event.
+**/
+EFI_EVENT
+EFIAPI
+EfiCreateProtocolNotifyEvent (
+  IN  EFI_GUID          *ProtocolGuid,
+  IN  EFI_TPL           NotifyTpl,
+  IN  EFI_EVENT_NOTIFY  NotifyFunction,
+  IN  VOID              *NotifyContext   OPTIONAL,
+  OUT VOID              **Registration
+  )
+{
+  MOCK_NOTIFY  Notify;
+  EFI_EVENT    Event;
+
+  Notify = CompareGuid (ProtocolGuid, &gEfiBlockIoProtocolGuid) ? MockNotifyBlockIo : MockNotifyBlockIo2;
+  if (EFI_ERROR (MockCreateEvent (EVT_NOTIFY_SIGNAL, NotifyTpl, NotifyFunction, NotifyContext, &Event))) {
+    return NULL;
+  }
+
+  mMockNotifyEvent[Notify] = Event;
+  *Registration            = &mMockRegistration[Notify];
+  return Event;
+}
+
+/**
+  Record the ReadyToBoot notification registered by the probing.
+
+  @param[in]  NotifyTpl         The TPL of the notification function.
+  @param[in]  NotifyFunction    The notification function.
+  @param[in]  NotifyContext     The context of the notification function.
+  @param[out] ReadyToBootEvent  The ReadyToBoot event.
+
+  @return The status of the event creation.
+**/
+EFI_STATUS
+EFIAPI
+EfiCreateEventReadyToBootEx (
+  IN  EFI_TPL           NotifyTpl,
+  IN  EFI_EVENT_NOTIFY  NotifyFunction  OPTIONAL,
+  IN  VOID              *NotifyContext  OPTIONAL,
+  OUT EFI_EVENT         *ReadyToBootEvent
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = MockCreateEvent (EVT_NOTIFY_SIGNAL, NotifyTpl, NotifyFunction, NotifyContext, ReadyToBootEvent);
+  if (!EFI_ERROR (Status)) {
+    mMockReadyToBoot      = NotifyFunction;
+    mMockReadyToBootEvent = *ReadyToBootEvent;
+  }
+
+  return Status;
+}
+
+/**
+  Check the parameters of an access to the mock disk.
+
+  @param[in]  MediaId     The media ID of the access.
+  @param[in]  Lba         The first block of the access.
+  @param[in]  BufferSize  The size of the access.
+
+  @retval EFI_SUCCESS  The access is valid.
+  @retval Others       The status the device returns.
+**/
+STATIC
+EFI_STATUS
+MockDiskCheck (
+  IN UINT32   MediaId,
+  IN EFI_LBA  Lba,
+  IN UINTN    BufferSize
+  )
+{
+  if (MediaId != mMockDisk.Media.MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+
+  if (BufferSize % MOCK_DISK_BLOCK_SIZE != 0) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  if ((Lba > mMockDisk.Media.LastBlock) ||
+      (BufferSize / MOCK_DISK_BLOCK_SIZE > mMockDisk.Media.LastBlock - Lba + 1))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Reset the mock disk.
+
+  @param[in]  This                  Indicates a pointer to the calling context.
+  @param[in]  ExtendedVerification  Driver may perform diagnostics on reset.
+
+  @retval EFI_SUCCESS  The device was reset.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockBlockIoReset (
+  IN EFI_BLOCK_IO_PROTOCOL  *This,
+  IN BOOLEAN                ExtendedVerification
+  )
+{
+  mMockDisk.ResetCalls++;
+  return EFI_SUCCESS;
+}
+
+/**
+  Read blocks from the mock disk.
+
+  @param[in]  This        Indicates a pointer to the calling context.
+  @param[in]  MediaId     Id of the media.
+  @param[in]  Lba         The starting logical block address to read from.
+  @param[in]  BufferSize  Size of Buffer, must be a multiple of the block size.
+  @param[out] Buffer      The destination buffer for the data.
+
+  @return The status of the read.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockBlockIoReadBlocks (
+  IN  EFI_BLOCK_IO_PROTOCOL  *This,
+  IN  UINT32                 MediaId,
+  IN  EFI_LBA                Lba,
+  IN  UINTN                  BufferSize,
+  OUT VOID                   *Buffer
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = MockDiskCheck (MediaId, Lba, BufferSize);
+  if (!EFI_ERROR (Status)) {
+    CopyMem (Buffer, mMockDisk.Disk + Lba * MOCK_DISK_BLOCK_SIZE, BufferSize);
+  }
+
+  return Status;
+}
+
+/**
+  Write blocks to the mock disk.
+
+  @param[in]  This        Indicates a pointer to the calling context.
+  @param[in]  MediaId     Id of the media.
+  @param[in]  Lba         The starting logical block address to write to.
+  @param[in]  BufferSize  Size of Buffer, must be a multiple of the block size.
+  @param[in]  Buffer      The source buffer for the data.
+
+  @return The status of the write.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockBlockIoWriteBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This,
+  IN UINT32                 MediaId,
+  IN EFI_LBA                Lba,
+  IN UINTN                  BufferSize,
+  IN VOID                   *Buffer
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = MockDiskCheck (MediaId, Lba, BufferSize);
+  if (!EFI_ERROR (Status)) {
+    mMockDisk.WriteCalls++;
+    CopyMem (mMockDisk.Disk + Lba * MOCK_DISK_BLOCK_SIZE, Buffer, BufferSize);
+  }
+
+  return Status;
+}
+
+/**
+  Flush the mock disk.
+
+  @param[in]  This  Indicates a pointer to the calling context.
+
+  @retval EFI_SUCCESS  The device was flushed.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockBlockIoFlushBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Reset the mock disk through BlockIo2.
+
+  @param[in]  This                  Indicates a pointer to the calling context.
+  @param[in]  ExtendedVerification  Driver may perform diagnostics on reset.
+
+  @retval EFI_SUCCESS  The device was reset.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockBlockIo2Reset (
+  IN EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN BOOLEAN                 ExtendedVerification
+  )
+{
+  mMockDisk.ResetCalls++;
+  return EFI_SUCCESS;
+}
+
+/**
+  Read blocks from the mock disk through BlockIo2. Non-blocking reads are held
+  back when the disk defers its reads.
+
+  @param[in]      This        Indicates a pointer to the calling context.
+  @param[in]      MediaId     Id of the media.
+  @param[in]      Lba         The starting logical block address to read from.
+  @param[in, out] Token       The token of the read, may be NULL.
+  @param[in]      BufferSize  Size of Buffer, must be a multiple of the block size.
+  @param[out]     Buffer      The destination buffer for the data.
+
+  @return The status of the read.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockBlockIo2ReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN     UINT32                  MediaId,
+  IN     EFI_LBA                 Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token,
+  IN     UINTN                   BufferSize,
+  OUT    VOID                    *Buffer
+  )
+{
+  EFI_STATUS  Status;
+  MOCK_READ   *Read;
+
+  Status = MockDiskCheck (MediaId, Lba, BufferSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if ((Token == NULL) || (Token->Event == NULL)) {
+    CopyMem (Buffer, mMockDisk.Disk + Lba * MOCK_DISK_BLOCK_SIZE, BufferSize);
+    return EFI_SUCCESS;
+  }
+
+  if (mMockDisk.ReadCount == MOCK_MAX_READS) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Read         = &mMockDisk.Reads[mMockDisk.ReadCount++];
+  Read->Token  = Token;
+  Read->Lba    = Lba;
+  Read->Size   = BufferSize;
+  Read->Buffer = Buffer;
+  if (!mMockDisk.DeferReads) {
+    MockDiskCompleteReads ();
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Write blocks to the mock disk through BlockIo2, completing at once.
+
+  @param[in]      This        Indicates a pointer to the calling context.
+  @param[in]      MediaId     Id of the media.
+  @param[in]      Lba         The starting logical block address to write to.
+  @param[in, out] Token       The token of the write, may be NULL.
+  @param[in]      BufferSize  Size of Buffer, must be a multiple of the block size.
+  @param[in]      Buffer      The source buffer for the data.
+
+  @return The status of the write.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockBlockIo2WriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN     UINT32                  MediaId,
+  IN     EFI_LBA                 Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token,
+  IN     UINTN                   BufferSize,
+  IN     VOID                    *Buffer
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = MockBlockIoWriteBlocks (&mMockDisk.BlockIo, MediaId, Lba, BufferSize, Buffer);
+  if (!EFI_ERROR (Status) && (Token != NULL) && (Token->Event != NULL)) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+
+  return Status;
+}
+
+/**
+  Flush the mock disk through BlockIo2.
+
+  @param[in]      This   Indicates a pointer to the calling context.
+  @param[in, out] Token  The token of the flush, may be NULL.
+
+  @retval EFI_SUCCESS  The device was flushed.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockBlockIo2FlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Read bytes from the mock disk, the way the partition driver reads what its
+  probe does not cover.
+
+  @param[in]  This        Indicates a pointer to the calling context.
+  @param[in]  MediaId     Id of the media.
+  @param[in]  Offset      The starting byte offset to read from.
+  @param[in]  BufferSize  Size of Buffer.
+  @param[out] Buffer      The destination buffer for the data.
+
+  @return The status of the read.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MockDiskIoReadDisk (
+  IN  EFI_DISK_IO_PROTOCOL  *This,
+  IN  UINT32                MediaId,
+  IN  UINT64                Offset,
+  IN  UINTN                 BufferSize,
+  OUT VOID                  *Buffer
+  )
+{
+  if (MediaId != mMockDisk.Media.MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+
+  mMockDisk.DiskIoReads++;
+  CopyMem (Buffer, mMockDisk.Disk + Offset, BufferSize);
+  return EFI_SUCCESS;
+}
+
+/**
+  Install the BlockIo and BlockIo2 protocols of the mock disk again, running
+  the notification functions of the probing.
+
+  @param[in]  BlockIo   Reinstall the BlockIo protocol.
+  @param[in]  BlockIo2  Reinstall the BlockIo2 protocol.
+**/
+STATIC
+VOID
+MockDiskInstall (
+  IN BOOLEAN  BlockIo,
+  IN BOOLEAN  BlockIo2
+  )
+{
+  mMockDisk.Installed                    = TRUE;
+  mMockNotifyPending[MockNotifyBlockIo]  = BlockIo;
+  mMockNotifyPending[MockNotifyBlockIo2] = BlockIo2;
+  if (BlockIo) {
+    gBS->SignalEvent (mMockNotifyEvent[MockNotifyBlockIo]);
+  }
+
+  if (BlockIo2) {
+    gBS->SignalEvent (mMockNotifyEvent[MockNotifyBlockIo2]);
+  }
+}
+
+/**
+  Create the mock disk and start the probing.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED                     The probing was started.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  The probing could not be started.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+PartitionProbeSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+
+  ZeroMem (&mMockDisk, sizeof (mMockDisk));
+  mMockDisk.Media.MediaId          = MOCK_DISK_MEDIA_ID;
+  mMockDisk.Media.MediaPresent     = TRUE;
+  mMockDisk.Media.LogicalPartition = FALSE;
+  mMockDisk.Media.BlockSize        = MOCK_DISK_BLOCK_SIZE;
+  mMockDisk.Media.IoAlign          = 0;
+  mMockDisk.Media.LastBlock        = MOCK_DISK_BLOCKS - 1;
+
+  mMockDisk.BlockIo.Revision    = EFI_BLOCK_IO_PROTOCOL_REVISION;
+  mMockDisk.BlockIo.Media       = &mMockDisk.Media;
+  mMockDisk.BlockIo.Reset       = MockBlockIoReset;
+  mMockDisk.BlockIo.ReadBlocks  = MockBlockIoReadBlocks;
+  mMockDisk.BlockIo.WriteBlocks = MockBlockIoWriteBlocks;
+  mMockDisk.BlockIo.FlushBlocks = MockBlockIoFlushBlocks;
+
+  mMockDisk.BlockIo2.Media         = &mMockDisk.Media;
+  mMockDisk.BlockIo2.Reset         = MockBlockIo2Reset;
+  mMockDisk.BlockIo2.ReadBlocksEx  = MockBlockIo2ReadBlocksEx;
+  mMockDisk.BlockIo2.WriteBlocksEx = MockBlockIo2WriteBlocksEx;
+  mMockDisk.BlockIo2.FlushBlocksEx = MockBlockIo2FlushBlocksEx;
+
+  mMockDisk.DiskIo.Revision = EFI_DISK_IO_PROTOCOL_REVISION;
+  mMockDisk.DiskIo.ReadDisk = MockDiskIoReadDisk;
+
+  mMockDisk.Disk = AllocatePool (MOCK_DISK_BLOCKS * MOCK_DISK_BLOCK_SIZE);
+  if (mMockDisk.Disk == NULL) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  //
+  // Every byte depends on its offset, so misplaced data is caught.
+  //
+  for (Index = 0; Index < MOCK_DISK_BLOCKS * MOCK_DISK_BLOCK_SIZE; Index++) {
+    mMockDisk.Disk[Index] = (UINT8)(Index ^ (Index >> 9) ^ (Index >> 17));
+  }
+
+  MockBoot.RaiseTPL       = MockRaiseTpl;
+  MockBoot.RestoreTPL     = MockRestoreTpl;
+  MockBoot.CreateEvent    = MockCreateEvent;
+  MockBoot.CloseEvent     = MockCloseEvent;
+  MockBoot.SignalEvent    = MockSignalEvent;
+  MockBoot.Stall          = MockStall;
+  MockBoot.HandleProtocol = MockHandleProtocol;
+  MockBoot.LocateHandle   = MockLocateHandle;
+
+  mMockTpl       = TPL_APPLICATION;
+  mMockStalls    = 0;
+  mMockStallTime = 0;
+
+  if (EFI_ERROR (PartitionProbeInitialize ())) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Stop the probing, let the held back reads complete and free the mock disk.
+
+  @param[in]  Context  Unused.
+**/
+STATIC
+VOID
+EFIAPI
+PartitionProbeCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  mMockTpl = TPL_APPLICATION;
+  if (mMockReadyToBootEvent != NULL) {
+    mMockReadyToBoot (mMockReadyToBootEvent, NULL);
+    mMockReadyToBootEvent = NULL;
+  }
+
+  mMockDisk.Hung = FALSE;
+  MockDiskCompleteReads ();
+
+  if (mMockDisk.Disk != NULL) {
+    FreePool (mMockDisk.Disk);
+    mMockDisk.Disk = NULL;
+  }
+}
+
+/**
+  Check that the services of the mock disk are still its own.
+
+  @retval TRUE   The services are untouched.
+  @retval FALSE  A service was replaced.
+**/
+STATIC
+BOOLEAN
+MockDiskUntouched (
+  VOID
+  )
+{
+  return (BOOLEAN)((mMockDisk.BlockIo.Reset == MockBlockIoReset) &&
+                   (mMockDisk.BlockIo.ReadBlocks == MockBlockIoReadBlocks) &&
+                   (mMockDisk.BlockIo.WriteBlocks == MockBlockIoWriteBlocks) &&
+                   (mMockDisk.BlockIo.FlushBlocks == MockBlockIoFlushBlocks) &&
+                   (mMockDisk.BlockIo2.Reset == MockBlockIo2Reset) &&
+                   (mMockDisk.BlockIo2.ReadBlocksEx == MockBlockIo2ReadBlocksEx) &&
+                   (mMockDisk.BlockIo2.WriteBlocksEx == MockBlockIo2WriteBlocksEx) &&
+                   (mMockDisk.BlockIo2.FlushBlocksEx == MockBlockIo2FlushBlocksEx));
+}
+
+/**
+  Check that the GPT structures are read from a probe, and that the other
+  reads go to the disk.
+
+  @param[in]  Probe  The probe of the mock disk.
+
+  @retval UNIT_TEST_PASSED             The probe holds the GPT structures.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  Otherwise.
+**/
+STATIC
+UNIT_TEST_STATUS
+CheckProbeReads (
+  IN PARTITION_PROBE  *Probe
+  )
+{
+  STATIC CONST UINT64  GptOffsets[] = {
+    0,
+    PRIMARY_PART_HEADER_LBA * MOCK_DISK_BLOCK_SIZE,
+    (PRIMARY_PART_HEADER_LBA + 1) * MOCK_DISK_BLOCK_SIZE,
+    (MOCK_DISK_BLOCKS - 1 - TEST_ENTRY_BLOCKS) * MOCK_DISK_BLOCK_SIZE,
+    (MOCK_DISK_BLOCKS - 1) * MOCK_DISK_BLOCK_SIZE
+  };
+  UINT8                Buffer[MOCK_DISK_BLOCK_SIZE];
+  UINTN                Index;
+  EFI_STATUS           Status;
+
+  for (Index = 0; Index < ARRAY_SIZE (GptOffsets); Index++) {
+    Status = PartitionProbeReadDisk (Probe, &mMockDisk.DiskIo, MOCK_DISK_MEDIA_ID, GptOffsets[Index], sizeof (Buffer), Buffer);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_MEM_EQUAL (Buffer, mMockDisk.Disk + GptOffsets[Index], sizeof (Buffer));
+  }
+
+  UT_ASSERT_EQUAL (mMockDisk.DiskIoReads, 0);
+
+  Status = PartitionProbeReadDisk (Probe, &mMockDisk.DiskIo, MOCK_DISK_MEDIA_ID, 0x10000, sizeof (Buffer), Buffer);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_MEM_EQUAL (Buffer, mMockDisk.Disk + 0x10000, sizeof (Buffer));
+  UT_ASSERT_EQUAL (mMockDisk.DiskIoReads, 1);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The GPT structures of a disk are read ahead when its BlockIo2 protocol is
+  installed, and the driver reads them from the probe.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+ProbeReadAheadTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  PARTITION_PROBE   *Probe;
+  UNIT_TEST_STATUS  Result;
+
+  MockDiskInstall (TRUE, TRUE);
+
+  PartitionProbeWait (MOCK_DISK_HANDLE);
+  UT_ASSERT_EQUAL (mMockStalls, 0);
+
+  Probe = PartitionProbeAcquire (MOCK_DISK_HANDLE, &mMockDisk.BlockIo);
+  UT_ASSERT_NOT_NULL (Probe);
+
+  Result = CheckProbeReads (Probe);
+  PartitionProbeFree (Probe);
+  return Result;
+}
+
+/**
+  At TPL_APPLICATION, the driver gives the reads in flight time to complete,
+  then takes the probe at TPL_CALLBACK the way its Start () does.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+WaitForReadsTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  PARTITION_PROBE   *Probe;
+  UNIT_TEST_STATUS  Result;
+  EFI_TPL           OldTpl;
+
+  mMockDisk.DeferReads = TRUE;
+  MockDiskInstall (TRUE, TRUE);
+  UT_ASSERT_EQUAL (mMockDisk.ReadCount, 2);
+
+  PartitionProbeWait (MOCK_DISK_HANDLE);
+  UT_ASSERT_TRUE (mMockStalls > 0);
+  UT_ASSERT_EQUAL (mMockDisk.ReadCount, 0);
+
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  Probe  = PartitionProbeAcquire (MOCK_DISK_HANDLE, &mMockDisk.BlockIo);
+  gBS->RestoreTPL (OldTpl);
+  UT_ASSERT_NOT_NULL (Probe);
+
+  Result = CheckProbeReads (Probe);
+  PartitionProbeFree (Probe);
+  return Result;
+}
+
+/**
+  The driver gives up on a probe whose reads do not complete in time, and the
+  probe is freed when they complete.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+WaitTimeoutTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  EventCount;
+
+  EventCount           = mMockEventCount;
+  mMockDisk.DeferReads = TRUE;
+  mMockDisk.Hung       = TRUE;
+  MockDiskInstall (TRUE, TRUE);
+
+  PartitionProbeWait (MOCK_DISK_HANDLE);
+  UT_ASSERT_TRUE (mMockStallTime >= PARTITION_PROBE_TIMEOUT);
+  UT_ASSERT_TRUE (PartitionProbeAcquire (MOCK_DISK_HANDLE, &mMockDisk.BlockIo) == NULL);
+
+  mMockDisk.Hung = FALSE;
+  MockDiskCompleteReads ();
+  UT_ASSERT_EQUAL (mMockEventCount, EventCount);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  At TPL_CALLBACK, where the reads cannot complete, the driver neither waits
+  nor stalls. It takes a probe whose reads are completed, and drops one whose
+  reads are still in flight.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+AcquireAtCallbackTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  PARTITION_PROBE   *Probe;
+  UNIT_TEST_STATUS  Result;
+  UINTN             EventCount;
+  EFI_TPL           OldTpl;
+
+  EventCount           = mMockEventCount;
+  mMockDisk.DeferReads = TRUE;
+  MockDiskInstall (TRUE, TRUE);
+
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  PartitionProbeWait (MOCK_DISK_HANDLE);
+  Probe = PartitionProbeAcquire (MOCK_DISK_HANDLE, &mMockDisk.BlockIo);
+  gBS->RestoreTPL (OldTpl);
+  UT_ASSERT_TRUE (Probe == NULL);
+  UT_ASSERT_EQUAL (mMockStalls, 0);
+  UT_ASSERT_EQUAL (mMockDisk.ReadCount, 2);
+
+  MockDiskCompleteReads ();
+  UT_ASSERT_EQUAL (mMockEventCount, EventCount);
+
+  //
+  // The reads of the next probe complete before the driver starts.
+  //
+  MockDiskInstall (FALSE, TRUE);
+  MockDiskCompleteReads ();
+
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  Probe  = PartitionProbeAcquire (MOCK_DISK_HANDLE, &mMockDisk.BlockIo);
+  gBS->RestoreTPL (OldTpl);
+  UT_ASSERT_NOT_NULL (Probe);
+  UT_ASSERT_EQUAL (mMockStalls, 0);
+
+  Result = CheckProbeReads (Probe);
+  PartitionProbeFree (Probe);
+  return Result;
+}
+
+/**
+  The probing leaves the services of the disk alone, and the writes and
+  resets of the disk go straight to the device.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+DiskUntouchedTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8       Block[MOCK_DISK_BLOCK_SIZE];
+  EFI_STATUS  Status;
+
+  ZeroMem (Block, sizeof (Block));
+  mMockDisk.DeferReads = TRUE;
+  MockDiskInstall (TRUE, TRUE);
+  UT_ASSERT_TRUE (MockDiskUntouched ());
+
+  Status = mMockDisk.BlockIo.WriteBlocks (&mMockDisk.BlockIo, MOCK_DISK_MEDIA_ID, 1, sizeof (Block), Block);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  Status = mMockDisk.BlockIo2.Reset (&mMockDisk.BlockIo2, FALSE);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (mMockDisk.WriteCalls, 1);
+  UT_ASSERT_EQUAL (mMockDisk.ResetCalls, 1);
+
+  MockDiskCompleteReads ();
+  PartitionProbeFree (PartitionProbeAcquire (MOCK_DISK_HANDLE, &mMockDisk.BlockIo));
+  UT_ASSERT_TRUE (MockDiskUntouched ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A probe is not used once the BlockIo2 protocol it was issued through is no
+  longer installed on the disk.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+BlockIo2UninstalledTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MockDiskInstall (TRUE, TRUE);
+  mMockDisk.Installed = FALSE;
+  UT_ASSERT_TRUE (PartitionProbeAcquire (MOCK_DISK_HANDLE, &mMockDisk.BlockIo) == NULL);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A reinstallation of the BlockIo protocol drops the probe of the disk, one of
+  the BlockIo2 protocol probes the disk again.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+ReinstallDropsProbeTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  PARTITION_PROBE   *Probe;
+  UNIT_TEST_STATUS  Result;
+
+  MockDiskInstall (TRUE, TRUE);
+  MockDiskInstall (TRUE, FALSE);
+  UT_ASSERT_TRUE (PartitionProbeAcquire (MOCK_DISK_HANDLE, &mMockDisk.BlockIo) == NULL);
+
+  //
+  // A partitioning tool rewrote the primary GPT header behind the back of
+  // the protocols, then reinstalled them.
+  //
+  MockDiskInstall (TRUE, TRUE);
+  SetMem (mMockDisk.Disk + PRIMARY_PART_HEADER_LBA * MOCK_DISK_BLOCK_SIZE, MOCK_DISK_BLOCK_SIZE, 0x5A);
+  MockDiskInstall (FALSE, TRUE);
+
+  Probe = PartitionProbeAcquire (MOCK_DISK_HANDLE, &mMockDisk.BlockIo);
+  UT_ASSERT_NOT_NULL (Probe);
+  Result = CheckProbeReads (Probe);
+  PartitionProbeFree (Probe);
+  return Result;
+}
+
+/**
+  A probe of a previous media is not used.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+MediaChangeTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MockDiskInstall (TRUE, TRUE);
+  mMockDisk.Media.MediaId++;
+  UT_ASSERT_TRUE (PartitionProbeAcquire (MOCK_DISK_HANDLE, &mMockDisk.BlockIo) == NULL);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  ReadyToBoot drops the probes not taken.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+ReadyToBootTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  mMockDisk.DeferReads = TRUE;
+  MockDiskInstall (TRUE, TRUE);
+
+  mMockReadyToBoot (mMockReadyToBootEvent, NULL);
+  mMockReadyToBootEvent = NULL;
+  UT_ASSERT_TRUE (PartitionProbeAcquire (MOCK_DISK_HANDLE, &mMockDisk.BlockIo) == NULL);
+
+  MockDiskCompleteReads ();
+  UT_ASSERT_EQUAL (mMockEventCount, 0);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the parallel
+  media probing and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ProbeTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&ProbeTests, Framework, "Partition Probe Tests", "PartitionDxe.Probe", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ProbeTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (ProbeTests, "The GPT structures are read from the probe", "ProbeReadAhead", ProbeReadAheadTest, PartitionProbeSetup, PartitionProbeCleanup, NULL);
+  AddTestCase (ProbeTests, "The driver waits for the reads before raising the TPL", "WaitForReads", WaitForReadsTest, PartitionProbeSetup, PartitionProbeCleanup, NULL);
+  AddTestCase (ProbeTests, "A probe whose reads hang is dropped", "WaitTimeout", WaitTimeoutTest, PartitionProbeSetup, PartitionProbeCleanup, NULL);
+  AddTestCase (ProbeTests, "Only completed probes are taken at TPL_CALLBACK", "AcquireAtCallback", AcquireAtCallbackTest, PartitionProbeSetup, PartitionProbeCleanup, NULL);
+  AddTestCase (ProbeTests, "The services of the disk are not replaced", "DiskUntouched", DiskUntouchedTest, PartitionProbeSetup, PartitionProbeCleanup, NULL);
+  AddTestCase (ProbeTests, "A probe is not used once BlockIo2 is uninstalled", "BlockIo2Uninstalled", BlockIo2UninstalledTest, PartitionProbeSetup, PartitionProbeCleanup, NULL);
+  AddTestCase (ProbeTests, "Protocol reinstallations drop the probe", "ReinstallDropsProbe", ReinstallDropsProbeTest, PartitionProbeSetup, PartitionProbeCleanup, NULL);
+  AddTestCase (ProbeTests, "A probe of a previous media is not used", "MediaChange", MediaChangeTest, PartitionProbeSetup, PartitionProbeCleanup, NULL);
+  AddTestCase (ProbeTests, "ReadyToBoot drops the probes", "ReadyToBoot", ReadyToBootTest, PartitionProbeSetup, PartitionProbeCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -270,7 +270,13 @@ PeimFaultTolerantWriteInitialize (
         //
         FtwLastWrite.TargetAddress = (EFI_PHYSICAL_ADDRESS)(UINTN)((INT64)SpareAreaAddress + FtwLastWriteRecord->RelativeOffset);
         FtwLastWrite.SpareAddress  = SpareAreaAddress;
-        FtwLastWrite.Length        = SpareAreaLength;
+        // MU_CHANGE [BEGIN] - Report the extent of the last write, not the whole spare area
+        //
+        // The spare block only holds the target blocks spanned by the last write, the rest
+        // of it is erased. Consumers must not take data beyond them from the spare block.
+        //
+        FtwLastWrite.Length = MIN (FtwLastWriteRecord->Offset + FtwLastWriteRecord->Length, (UINT64)SpareAreaLength);
+        // MU_CHANGE [END]
         DEBUG ((
           DEBUG_INFO,
           "FtwPei last write data: TargetAddress - 0x%x SpareAddress - 0x%x Length - 0x%x\n",
@@ -186,6 +186,250 @@ FvFsGetFileSize (
   return Status;
 }
 
+// MU_CHANGE [BEGIN] - Lazy file sizing
+
+/**
+  Find a section of a type in a section stream from the section headers, without
+  decoding the encapsulation sections.
+
+  The first section of the type in the stream is searched the way ReadSection()
+  searches it, depth first. The search stops at the first encapsulation section
+  that needs processing, as the section found after it may not be the one
+  ReadSection() returns.
+
+  @param  Stream                      A pointer to the section stream.
+  @param  StreamSize                  The size of the section stream in bytes.
+  @param  SectionType                 The type of the section to find.
+  @param  Size                        Returns the size of the data of the section found.
+  @param  Encoded                     Set to TRUE if an encapsulation section that needs
+                                      processing was found before a section of the type.
+
+  @retval TRUE                        A section of the type was found.
+  @retval FALSE                       No section of the type was found outside of the
+                                      encapsulation sections that need processing.
+
+**/
+STATIC
+BOOLEAN
+FvFsFindSectionSize (
+  IN     CONST UINT8       *Stream,
+  IN     UINTN             StreamSize,
+  IN     EFI_SECTION_TYPE  SectionType,
+  OUT    UINT64            *Size,
+  IN OUT BOOLEAN           *Encoded
+  )
+{
+  EFI_COMMON_SECTION_HEADER  *Section;
+  UINTN                      Offset;
+  UINTN                      SectionSize;
+  UINTN                      HeaderSize;
+  UINTN                      DataOffset;
+  UINT16                     Attributes;
+  UINT8                      CompressionType;
+
+  Offset = 0;
+  while (StreamSize - Offset >= sizeof (EFI_COMMON_SECTION_HEADER)) {
+    Section = (EFI_COMMON_SECTION_HEADER *)(Stream + Offset);
+    if (IS_SECTION2 (Section)) {
+      if (StreamSize - Offset < sizeof (EFI_COMMON_SECTION_HEADER2)) {
+        break;
+      }
+
+      SectionSize = SECTION2_SIZE (Section);
+      HeaderSize  = sizeof (EFI_COMMON_SECTION_HEADER2);
+    } else {
+      SectionSize = SECTION_SIZE (Section);
+      HeaderSize  = sizeof (EFI_COMMON_SECTION_HEADER);
+    }
+
+    if ((SectionSize < HeaderSize) || (SectionSize > StreamSize - Offset)) {
+      break;
+    }
+
+    if (Section->Type == SectionType) {
+      *Size = SectionSize - HeaderSize;
+      return TRUE;
+    }
+
+    if (Section->Type == EFI_SECTION_COMPRESSION) {
+      if (IS_SECTION2 (Section)) {
+        DataOffset      = sizeof (EFI_COMPRESSION_SECTION2);
+        CompressionType = ((EFI_COMPRESSION_SECTION2 *)Section)->CompressionType;
+      } else {
+        DataOffset      = sizeof (EFI_COMPRESSION_SECTION);
+        CompressionType = ((EFI_COMPRESSION_SECTION *)Section)->CompressionType;
+      }
+
+      if ((CompressionType != EFI_NOT_COMPRESSED) || (DataOffset > SectionSize)) {
+        *Encoded = TRUE;
+        return FALSE;
+      }
+
+      if (FvFsFindSectionSize ((UINT8 *)Section + DataOffset, SectionSize - DataOffset, SectionType, Size, Encoded) || *Encoded) {
+        return !*Encoded;
+      }
+    } else if (Section->Type == EFI_SECTION_GUID_DEFINED) {
+      if (IS_SECTION2 (Section)) {
+        DataOffset = ((EFI_GUID_DEFINED_SECTION2 *)Section)->DataOffset;
+        Attributes = ((EFI_GUID_DEFINED_SECTION2 *)Section)->Attributes;
+      } else {
+        DataOffset = ((EFI_GUID_DEFINED_SECTION *)Section)->DataOffset;
+        Attributes = ((EFI_GUID_DEFINED_SECTION *)Section)->Attributes;
+      }
+
+      if (((Attributes & EFI_GUIDED_SECTION_PROCESSING_REQUIRED) != 0) || (DataOffset > SectionSize)) {
+        *Encoded = TRUE;
+        return FALSE;
+      }
+
+      if (FvFsFindSectionSize ((UINT8 *)Section + DataOffset, SectionSize - DataOffset, SectionType, Size, Encoded) || *Encoded) {
+        return !*Encoded;
+      }
+    }
+
+    Offset += ALIGN_VALUE (SectionSize, 4);
+    if (Offset > StreamSize) {
+      break;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Get the size of the buffer that will be returned by FvFsReadFile from the
+  headers of the sections of the file.
+
+  This only succeeds when the section returned by FvFsReadFile is found before
+  any encapsulation section that needs processing, the size is exact then.
+
+  @param  FvProtocol                  A pointer to the EFI_FIRMWARE_VOLUME2_PROTOCOL instance.
+  @param  FvFileInfo                  A pointer to the FV_FILESYSTEM_FILE_INFO instance that is a struct
+                                      representing a file's info.
+
+  @retval EFI_SUCCESS                 The file size was gotten.
+  @retval EFI_UNSUPPORTED             The file size can't be gotten from the section headers.
+  @retval Others                      The file couldn't be read.
+
+**/
+STATIC
+EFI_STATUS
+FvFsGetFileSizeFromSections (
+  IN     EFI_FIRMWARE_VOLUME2_PROTOCOL  *FvProtocol,
+  IN OUT FV_FILESYSTEM_FILE_INFO        *FvFileInfo
+  )
+{
+  UINT32                  AuthenticationStatus;
+  EFI_FV_FILETYPE         FoundType;
+  EFI_FV_FILE_ATTRIBUTES  Attributes;
+  EFI_STATUS              Status;
+  VOID                    *FileBuffer;
+  UINTN                   FileSize;
+  EFI_SECTION_TYPE        SectionType;
+  EFI_SECTION_TYPE        LastSectionType;
+  UINT64                  Size;
+  BOOLEAN                 Encoded;
+
+  if (!FV_FILETYPE_IS_EXECUTABLE (FvFileInfo->Type) && (FvFileInfo->Type != EFI_FV_FILETYPE_FREEFORM)) {
+    //
+    // The entire file is returned, its size is known from the FV.
+    //
+    FvFileInfo->FileInfo.FileSize = FvFileInfo->FvFileSize;
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Reading the raw file only copies it, the sections are not decoded.
+  //
+  FileBuffer = NULL;
+  Status     = FvProtocol->ReadFile (
+                             FvProtocol,
+                             &FvFileInfo->NameGuid,
+                             &FileBuffer,
+                             &FileSize,
+                             &FoundType,
+                             &Attributes,
+                             &AuthenticationStatus
+                             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (FV_FILETYPE_IS_EXECUTABLE (FvFileInfo->Type)) {
+    SectionType     = EFI_SECTION_PE32;
+    LastSectionType = EFI_SECTION_TE;
+  } else {
+    SectionType     = EFI_SECTION_RAW;
+    LastSectionType = EFI_SECTION_RAW;
+  }
+
+  //
+  // Search the section types in the order FvFsReadFile does.
+  //
+  Status  = EFI_UNSUPPORTED;
+  Encoded = FALSE;
+  for ( ; SectionType <= LastSectionType && !Encoded; SectionType++) {
+    if (FvFsFindSectionSize (FileBuffer, FileSize, SectionType, &Size, &Encoded)) {
+      FvFileInfo->FileInfo.FileSize = Size;
+      Status                        = EFI_SUCCESS;
+      break;
+    }
+  }
+
+  if (EFI_ERROR (Status) && !Encoded && (FvFileInfo->Type == EFI_FV_FILETYPE_FREEFORM)) {
+    //
+    // No raw section, the entire file is returned.
+    //
+    FvFileInfo->FileInfo.FileSize = FvFileInfo->FvFileSize;
+    Status                        = EFI_SUCCESS;
+  }
+
+  FreePool (FileBuffer);
+  return Status;
+}
+
+/**
+  Make sure the size of a file is known, the files are not sized when the
+  volume is opened.
+
+  The size is taken from the section headers when possible. Otherwise the
+  sections are decoded by the FV, for this file only.
+
+  @param  FvProtocol                  A pointer to the EFI_FIRMWARE_VOLUME2_PROTOCOL instance.
+  @param  FvFileInfo                  A pointer to the FV_FILESYSTEM_FILE_INFO instance that is a struct
+                                      representing a file's info.
+
+  @retval EFI_SUCCESS                 The file size is known.
+  @retval Others                      The file size wasn't gotten correctly.
+
+**/
+EFI_STATUS
+FvFsUpdateFileSize (
+  IN     EFI_FIRMWARE_VOLUME2_PROTOCOL  *FvProtocol,
+  IN OUT FV_FILESYSTEM_FILE_INFO        *FvFileInfo
+  )
+{
+  EFI_STATUS  Status;
+
+  if (FvFileInfo->SizeKnown) {
+    return EFI_SUCCESS;
+  }
+
+  Status = FvFsGetFileSizeFromSections (FvProtocol, FvFileInfo);
+  if (EFI_ERROR (Status)) {
+    Status = FvFsGetFileSize (FvProtocol, FvFileInfo);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    FvFileInfo->SizeKnown             = TRUE;
+    FvFileInfo->FileInfo.PhysicalSize = FvFileInfo->FileInfo.FileSize;
+  }
+
+  return Status;
+}
+
+// MU_CHANGE [END] - Lazy file sizing
+
 /**
   Helper function to read a file.
 
@@ -675,6 +919,8 @@ FvSimpleFileSystemRead (
       //
       // Directory read: populate Buffer with an EFI_FILE_INFO
       //
+      Status = FvFsUpdateFileSize (Instance->FvProtocol, File->DirReadNext);   // MU_CHANGE - Lazy file sizing
+      ASSERT_EFI_ERROR (Status);                                                // MU_CHANGE - Lazy file sizing
       Status = FvFsGetFileInfo (File->DirReadNext, BufferSize, Buffer);
       if (!EFI_ERROR (Status)) {
         //
@@ -702,6 +948,13 @@ FvSimpleFileSystemRead (
       return EFI_SUCCESS;
     }
   } else {
+    // MU_CHANGE [BEGIN] - Lazy file sizing
+    Status = FvFsUpdateFileSize (Instance->FvProtocol, File->FvFileInfo);
+    if (EFI_ERROR (Status)) {
+      return EFI_DEVICE_ERROR;
+    }
+
+    // MU_CHANGE [END] - Lazy file sizing
     FileSize = (UINTN)File->FvFileInfo->FileInfo.FileSize;
 
     FileBuffer = AllocateZeroPool (FileSize);
@@ -840,6 +1093,12 @@ FvSimpleFileSystemSetPosition (
       File->DirReadNext = FVFS_GET_FIRST_FILE_INFO (Instance);
     }
   } else if (Position == 0xFFFFFFFFFFFFFFFFull) {
+    // MU_CHANGE [BEGIN] - Lazy file sizing
+    if (EFI_ERROR (FvFsUpdateFileSize (Instance->FvProtocol, File->FvFileInfo))) {
+      return EFI_DEVICE_ERROR;
+    }
+
+    // MU_CHANGE [END] - Lazy file sizing
     File->Position = File->FvFileInfo->FileInfo.FileSize;
   } else {
     File->Position = Position;
@@ -966,6 +1225,15 @@ FvSimpleFileSystemGetInfo (
     //
     // Return file info
     //
+    // MU_CHANGE [BEGIN] - Lazy file sizing
+    if (File->FvFileInfo != File->Instance->Root->FvFileInfo) {
+      Status = FvFsUpdateFileSize (File->Instance->FvProtocol, File->FvFileInfo);
+      if (EFI_ERROR (Status)) {
+        return EFI_DEVICE_ERROR;
+      }
+    }
+
+    // MU_CHANGE [END] - Lazy file sizing
     return FvFsGetFileInfo (File->FvFileInfo, BufferSize, (EFI_FILE_INFO *)Buffer);
   } else if (CompareGuid (InformationType, &gEfiFileSystemVolumeLabelInfoIdGuid)) {
     //
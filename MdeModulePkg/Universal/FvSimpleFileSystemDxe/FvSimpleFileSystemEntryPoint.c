@@ -51,6 +51,131 @@ EFI_DRIVER_BINDING_PROTOCOL  mDriverBinding = {
   NULL
 };
 
+// MU_CHANGE [BEGIN] - File info index
+//
+// File info indexes kept for the FVs the driver was stopped on.
+//
+LIST_ENTRY  mFvFsIndexList = INITIALIZE_LIST_HEAD_VARIABLE (mFvFsIndexList);
+
+/**
+  Create an empty file info index for a FV.
+
+  @param  FvName      The name of the FV.
+
+  @return The index, or NULL if it could not be allocated.
+
+**/
+STATIC
+FV_FILESYSTEM_INDEX *
+FvFsCreateIndex (
+  IN CONST EFI_GUID  *FvName
+  )
+{
+  FV_FILESYSTEM_INDEX  *Index;
+  UINTN                Bucket;
+
+  Index = AllocatePool (sizeof (FV_FILESYSTEM_INDEX));
+  if (Index == NULL) {
+    return NULL;
+  }
+
+  Index->Signature = FVFS_INDEX_SIGNATURE;
+  InitializeListHead (&Index->Link);
+  CopyGuid (&Index->FvName, FvName);
+  for (Bucket = 0; Bucket < FVFS_INDEX_BUCKETS; Bucket++) {
+    InitializeListHead (&Index->Buckets[Bucket]);
+  }
+
+  return Index;
+}
+
+/**
+  Free a file info index and the file infos left in it.
+
+  @param  Index       The index, not in mFvFsIndexList.
+
+**/
+STATIC
+VOID
+FvFsFreeIndex (
+  IN FV_FILESYSTEM_INDEX  *Index
+  )
+{
+  FV_FILESYSTEM_FILE_INFO  *FvFileInfo;
+  UINTN                    Bucket;
+
+  for (Bucket = 0; Bucket < FVFS_INDEX_BUCKETS; Bucket++) {
+    while (!IsListEmpty (&Index->Buckets[Bucket])) {
+      FvFileInfo = FVFS_FILE_INFO_FROM_INDEX_LINK (GetFirstNode (&Index->Buckets[Bucket]));
+      RemoveEntryList (&FvFileInfo->IndexLink);
+      FreePool (FvFileInfo);
+    }
+  }
+
+  FreePool (Index);
+}
+
+/**
+  Take the file info index kept for a FV out of mFvFsIndexList.
+
+  @param  FvName      The name of the FV.
+
+  @return The index, or NULL if none was kept for the FV.
+
+**/
+STATIC
+FV_FILESYSTEM_INDEX *
+FvFsTakeIndex (
+  IN CONST EFI_GUID  *FvName
+  )
+{
+  LIST_ENTRY           *Link;
+  FV_FILESYSTEM_INDEX  *Index;
+
+  for (Link = GetFirstNode (&mFvFsIndexList); !IsNull (&mFvFsIndexList, Link); Link = GetNextNode (&mFvFsIndexList, Link)) {
+    Index = FVFS_INDEX_FROM_LINK (Link);
+    if (CompareGuid (&Index->FvName, FvName)) {
+      RemoveEntryList (&Index->Link);
+      return Index;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Find the file info of a file in a file info index.
+
+  @param  Index       The index.
+  @param  NameGuid    The name of the file.
+
+  @return The file info, or NULL if the file is not in the index.
+
+**/
+STATIC
+FV_FILESYSTEM_FILE_INFO *
+FvFsIndexLookup (
+  IN FV_FILESYSTEM_INDEX  *Index,
+  IN CONST EFI_GUID       *NameGuid
+  )
+{
+  LIST_ENTRY               *Bucket;
+  LIST_ENTRY               *Link;
+  FV_FILESYSTEM_FILE_INFO  *FvFileInfo;
+
+  Bucket = FVFS_INDEX_BUCKET (Index, NameGuid);
+  for (Link = GetFirstNode (Bucket); !IsNull (Bucket, Link); Link = GetNextNode (Bucket, Link)) {
+    FvFileInfo = FVFS_FILE_INFO_FROM_INDEX_LINK (Link);
+    if (CompareGuid (&FvFileInfo->NameGuid, NameGuid)) {
+      return FvFileInfo;
+    }
+  }
+
+  return NULL;
+}
+
+// MU_CHANGE [END] - File info index
+
 /**
   Open the root directory on a volume.
 
@@ -94,6 +219,11 @@ FvSimpleFileSystemOpenVolume (
   UINTN                          NameLen;
   UINTN                          NumChars;
   UINTN                          DestMax;
+  // MU_CHANGE [BEGIN] - Lazy file sizing and file info index
+  UINTN                          FvFileSize;
+  EFI_FV_ATTRIBUTES              FvAttributes;
+  FV_FILESYSTEM_INDEX            *OldIndex;
+  // MU_CHANGE [END] - Lazy file sizing and file info index
 
   Instance = FVFS_INSTANCE_FROM_SIMPLE_FS_THIS (This);
   Status   = EFI_SUCCESS;
@@ -124,6 +254,23 @@ FvSimpleFileSystemOpenVolume (
     // has a UI_SECTION, which we consider to be its filename.
     //
     FvProtocol = Instance->FvProtocol;
+    // MU_CHANGE [BEGIN] - File info index
+    //
+    // The files of a read-only FV can't change, reuse the file infos kept
+    // when the driver was last stopped on it.
+    //
+    OldIndex = NULL;
+    if (Instance->FvNameValid &&
+        !EFI_ERROR (FvProtocol->GetVolumeAttributes (FvProtocol, &FvAttributes)) &&
+        ((FvAttributes & EFI_FV2_WRITE_STATUS) == 0))
+    {
+      Instance->Index = FvFsCreateIndex (&Instance->FvName);
+      if (Instance->Index != NULL) {
+        OldIndex = FvFsTakeIndex (&Instance->FvName);
+      }
+    }
+
+    // MU_CHANGE [END] - File info index
     //
     // Allocate Key
     //
@@ -145,6 +292,20 @@ FvSimpleFileSystemOpenVolume (
         break;
       }
 
+      // MU_CHANGE [BEGIN] - File info index
+      FvFileSize = Size;
+      if (OldIndex != NULL) {
+        FvFileInfo = FvFsIndexLookup (OldIndex, &NameGuid);
+        if ((FvFileInfo != NULL) && (FvFileInfo->Type == FileType) && (FvFileInfo->FvFileSize == FvFileSize)) {
+          RemoveEntryList (&FvFileInfo->IndexLink);
+          InsertTailList (FVFS_INDEX_BUCKET (Instance->Index, &NameGuid), &FvFileInfo->IndexLink);
+          InsertHeadList (&Instance->FileInfoHead, &FvFileInfo->Link);
+          continue;
+        }
+      }
+
+      // MU_CHANGE [END] - File info index
+
       //
       // Get a file's name: If it has a UI section, use that, otherwise use
       // its NameGuid.
@@ -202,13 +363,24 @@ FvSimpleFileSystemOpenVolume (
         ASSERT_EFI_ERROR (Status);
       }
 
-      FvFileInfo->FileInfo.Size = sizeof (EFI_FILE_INFO) + NameLen - sizeof (CHAR16);
-      Status                    = FvFsGetFileSize (FvProtocol, FvFileInfo);
-      ASSERT_EFI_ERROR (Status);
-      FvFileInfo->FileInfo.PhysicalSize = FvFileInfo->FileInfo.FileSize;
-      FvFileInfo->FileInfo.Attribute    = EFI_FILE_READ_ONLY;
+      // MU_CHANGE [BEGIN] - Lazy file sizing and file info index
+      //
+      // The size is only gotten when it is needed, the executable sections
+      // may have to be decoded for it.
+      //
+      FvFileInfo->FileInfo.Size      = sizeof (EFI_FILE_INFO) + NameLen - sizeof (CHAR16);
+      FvFileInfo->FileInfo.Attribute = EFI_FILE_READ_ONLY;
+      FvFileInfo->FvFileSize         = FvFileSize;
+      FvFileInfo->SizeKnown          = FALSE;
 
       InsertHeadList (&Instance->FileInfoHead, &FvFileInfo->Link);
+      if (Instance->Index != NULL) {
+        InsertTailList (FVFS_INDEX_BUCKET (Instance->Index, &NameGuid), &FvFileInfo->IndexLink);
+      } else {
+        InitializeListHead (&FvFileInfo->IndexLink);
+      }
+
+      // MU_CHANGE [END] - Lazy file sizing and file info index
 
       FreePool (Name);
     } while (TRUE);
@@ -216,6 +388,13 @@ FvSimpleFileSystemOpenVolume (
     if (Status == EFI_NOT_FOUND) {
       Status = EFI_SUCCESS;
     }
+
+    // MU_CHANGE [BEGIN] - File info index
+    if (OldIndex != NULL) {
+      FvFsFreeIndex (OldIndex);
+    }
+
+    // MU_CHANGE [END] - File info index
   }
 
   Instance->Root->DirReadNext = NULL;
@@ -518,6 +697,11 @@ FvSimpleFileSystemDriverStart (
           ASSERT ((NumChars + 1) * sizeof (CHAR16) == FVFS_VOLUME_LABEL_SIZE);
         }
 
+        // MU_CHANGE [BEGIN] - File info index
+        CopyGuid (&Instance->FvName, &((MEDIA_FW_VOL_DEVICE_PATH *)FvDevicePath)->FvName);
+        Instance->FvNameValid = TRUE;
+        // MU_CHANGE [END] - File info index
+
         break;
       }
 
@@ -567,6 +751,7 @@ FvSimpleFileSystemDriverStop (
   LIST_ENTRY                       *Entry;
   LIST_ENTRY                       *DelEntry;
   EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *SimpleFile;
+  FV_FILESYSTEM_INDEX              *OldIndex;            // MU_CHANGE - File info index
 
   Status = gBS->OpenProtocol (
                   ControllerHandle,
@@ -623,10 +808,30 @@ FvSimpleFileSystemDriverStop (
       FvFileInfo = FVFS_FILE_INFO_FROM_LINK (DelEntry);
 
       RemoveEntryList (DelEntry);
-      FreePool (FvFileInfo);
+      // MU_CHANGE [BEGIN] - File info index
+      if (Instance->Index == NULL) {
+        FreePool (FvFileInfo);
+      }
+
+      // MU_CHANGE [END] - File info index
+    }
+  }
+
+  // MU_CHANGE [BEGIN] - File info index
+  //
+  // Keep the file infos of the FV for the next time the driver is started on it.
+  //
+  if (Instance->Index != NULL) {
+    OldIndex = FvFsTakeIndex (&Instance->FvName);
+    if (OldIndex != NULL) {
+      FvFsFreeIndex (OldIndex);
     }
+
+    InsertTailList (&mFvFsIndexList, &Instance->Index->Link);
   }
 
+  // MU_CHANGE [END] - File info index
+
   if (Instance->Root != NULL) {
     //
     // Root->Name is statically allocated, no need to free.
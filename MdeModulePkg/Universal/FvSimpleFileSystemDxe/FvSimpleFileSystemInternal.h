@@ -35,6 +35,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 typedef struct _FV_FILESYSTEM_FILE       FV_FILESYSTEM_FILE;
 typedef struct _FV_FILESYSTEM_FILE_INFO  FV_FILESYSTEM_FILE_INFO;
 typedef struct _FV_FILESYSTEM_INSTANCE   FV_FILESYSTEM_INSTANCE;
+typedef struct _FV_FILESYSTEM_INDEX      FV_FILESYSTEM_INDEX;    // MU_CHANGE - File info index
 
 //
 // Struct representing an instance of the "filesystem". There will be one of
@@ -49,6 +50,11 @@ struct _FV_FILESYSTEM_INSTANCE {
   EFI_SIMPLE_FILE_SYSTEM_PROTOCOL    SimpleFs;
   FV_FILESYSTEM_FILE                 *Root;
   CHAR16                             *VolumeLabel;
+  // MU_CHANGE [BEGIN] - File info index
+  EFI_GUID                           FvName;
+  BOOLEAN                            FvNameValid;
+  FV_FILESYSTEM_INDEX                *Index;
+  // MU_CHANGE [END] - File info index
 };
 
 //
@@ -74,12 +80,36 @@ struct _FV_FILESYSTEM_FILE_INFO {
   LIST_ENTRY         Link;
   EFI_GUID           NameGuid;
   EFI_FV_FILETYPE    Type;
+  // MU_CHANGE [BEGIN] - Lazy file sizing and file info index
+  LIST_ENTRY         IndexLink;
+  UINTN              FvFileSize;
+  BOOLEAN            SizeKnown;
+  // MU_CHANGE [END] - Lazy file sizing and file info index
   EFI_FILE_INFO      FileInfo;
 };
 
+// MU_CHANGE [BEGIN] - Lazy file sizing and file info index
+#define FVFS_INDEX_BUCKETS  32
+
+//
+// Struct indexing the file infos of a FV by their name GUID. The index of a
+// read-only FV with a name is kept when the driver is stopped, so the files
+// do not have to be parsed again when it is started on the FV again.
+//
+struct _FV_FILESYSTEM_INDEX {
+  UINT32        Signature;
+  LIST_ENTRY    Link;
+  EFI_GUID      FvName;
+  LIST_ENTRY    Buckets[FVFS_INDEX_BUCKETS];
+};
+
+#define FVFS_INDEX_BUCKET(Index, Guid)  (&(Index)->Buckets[(Guid)->Data1 % FVFS_INDEX_BUCKETS])
+// MU_CHANGE [END] - Lazy file sizing and file info index
+
 #define FVFS_FILE_SIGNATURE       SIGNATURE_32 ('f', 'v', 'f', 'i')
 #define FVFS_FILE_INFO_SIGNATURE  SIGNATURE_32 ('f', 'v', 'i', 'n')
 #define FVFS_INSTANCE_SIGNATURE   SIGNATURE_32 ('f', 'v', 'f', 's')
+#define FVFS_INDEX_SIGNATURE      SIGNATURE_32 ('f', 'v', 'i', 'x')      // MU_CHANGE - File info index
 
 #define FVFS_INSTANCE_FROM_SIMPLE_FS_THIS(This)  CR ( \
           This,                                       \
@@ -102,6 +132,17 @@ struct _FV_FILESYSTEM_FILE_INFO {
           FVFS_FILE_INFO_SIGNATURE                    \
           )
 
+// MU_CHANGE [BEGIN] - File info index
+#define FVFS_FILE_INFO_FROM_INDEX_LINK(This)  CR (    \
+          This,                                       \
+          FV_FILESYSTEM_FILE_INFO,                    \
+          IndexLink,                                  \
+          FVFS_FILE_INFO_SIGNATURE                    \
+          )
+
+#define FVFS_INDEX_FROM_LINK(This)  CR (This, FV_FILESYSTEM_INDEX, Link, FVFS_INDEX_SIGNATURE)
+// MU_CHANGE [END] - File info index
+
 #define FVFS_FILE_FROM_LINK(FileLink)  CR (FileLink, FV_FILESYSTEM_FILE, Link, FVFS_FILE_SIGNATURE)
 
 #define FVFS_GET_FIRST_FILE(Instance)  FVFS_FILE_FROM_LINK (GetFirstNode (&Instance->FileHead))
@@ -482,6 +523,30 @@ FvFsGetFileSize (
   IN OUT FV_FILESYSTEM_FILE_INFO        *FvFileInfo
   );
 
+// MU_CHANGE [BEGIN] - Lazy file sizing
+/**
+  Make sure the size of a file is known, the files are not sized when the
+  volume is opened.
+
+  The size is taken from the section headers when possible. Otherwise the
+  sections are decoded by the FV, for this file only.
+
+  @param  FvProtocol                  A pointer to the EFI_FIRMWARE_VOLUME2_PROTOCOL instance.
+  @param  FvFileInfo                  A pointer to the FV_FILESYSTEM_FILE_INFO instance that is a struct
+                                      representing a file's info.
+
+  @retval EFI_SUCCESS                 The file size is known.
+  @retval Others                      The file size wasn't gotten correctly.
+
+**/
+EFI_STATUS
+FvFsUpdateFileSize (
+  IN     EFI_FIRMWARE_VOLUME2_PROTOCOL  *FvProtocol,
+  IN OUT FV_FILESYSTEM_FILE_INFO        *FvFileInfo
+  );
+
+// MU_CHANGE [END] - Lazy file sizing
+
 /**
   Retrieves a Unicode string that is the user readable name of the driver.
 
@@ -0,0 +1,63 @@
+/** @file
+  DynamicEx token lookup shared by the PCD PEIM and the PCD DXE driver.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "PcdExMap.h"
+
+/**
+  Find a DynamicEx PCD in the sorted DynamicEx mapping table of a PCD database.
+
+  @param[in]  ExMapTable     The DynamicEx mapping table, sorted by ExGuidIndex
+                             then ExTokenNumber.
+  @param[in]  ExTokenCount   The number of entries in ExMapTable.
+  @param[in]  GuidTableIdx   The index of the token space GUID in the GUID table.
+  @param[in]  ExTokenNumber  The DynamicEx token number. If it is 0, which is
+                             PCD_INVALID_TOKEN_NUMBER, the first entry of the
+                             token space is returned.
+
+  @return The entry of the PCD, or NULL if the token space has no such PCD.
+
+**/
+DYNAMICEX_MAPPING *
+PcdFindExMapEntry (
+  IN DYNAMICEX_MAPPING  *ExMapTable,
+  IN UINTN              ExTokenCount,
+  IN UINTN              GuidTableIdx,
+  IN UINTN              ExTokenNumber
+  )
+{
+  UINTN  Low;
+  UINTN  High;
+  UINTN  Middle;
+
+  //
+  // Find the first entry not below {GuidTableIdx, ExTokenNumber}.
+  //
+  Low  = 0;
+  High = ExTokenCount;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if ((ExMapTable[Middle].ExGuidIndex < GuidTableIdx) ||
+        ((ExMapTable[Middle].ExGuidIndex == GuidTableIdx) &&
+         (ExMapTable[Middle].ExTokenNumber < ExTokenNumber)))
+    {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  if ((Low == ExTokenCount) || (ExMapTable[Low].ExGuidIndex != GuidTableIdx)) {
+    return NULL;
+  }
+
+  if ((ExTokenNumber != 0) && (ExMapTable[Low].ExTokenNumber != ExTokenNumber)) {
+    return NULL;
+  }
+
+  return &ExMapTable[Low];
+}
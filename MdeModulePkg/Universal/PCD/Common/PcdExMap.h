@@ -0,0 +1,41 @@
+/** @file
+  DynamicEx token lookup shared by the PCD PEIM and the PCD DXE driver.
+
+  The build tools emit the DynamicEx mapping table of a PCD database sorted by
+  ExGuidIndex, then by ExTokenNumber, so a token is found by binary search
+  instead of a scan of the whole table.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _PCD_EX_MAP_H_
+#define _PCD_EX_MAP_H_
+
+#include <Uefi/UefiBaseType.h>
+#include <Guid/PcdDataBaseSignatureGuid.h>
+
+/**
+  Find a DynamicEx PCD in the sorted DynamicEx mapping table of a PCD database.
+
+  @param[in]  ExMapTable     The DynamicEx mapping table, sorted by ExGuidIndex
+                             then ExTokenNumber.
+  @param[in]  ExTokenCount   The number of entries in ExMapTable.
+  @param[in]  GuidTableIdx   The index of the token space GUID in the GUID table.
+  @param[in]  ExTokenNumber  The DynamicEx token number. If it is 0, which is
+                             PCD_INVALID_TOKEN_NUMBER, the first entry of the
+                             token space is returned.
+
+  @return The entry of the PCD, or NULL if the token space has no such PCD.
+
+**/
+DYNAMICEX_MAPPING *
+PcdFindExMapEntry (
+  IN DYNAMICEX_MAPPING  *ExMapTable,
+  IN UINTN              ExTokenCount,
+  IN UINTN              GuidTableIdx,
+  IN UINTN              ExTokenNumber
+  );
+
+#endif
@@ -217,7 +217,7 @@ ExGetPcdInfo (
   EFI_GUID           *MatchGuid;
   EFI_GUID           *GuidTable;
   DYNAMICEX_MAPPING  *ExMapTable;
-  UINTN              Index;
+  DYNAMICEX_MAPPING  *ExMapEntry;         // MU_CHANGE - Sorted ExMap lookup
   UINT32             LocalTokenNumber;
 
   Database = IsPeiDb ? mPcdDatabase.PeiDb : mPcdDatabase.DxeDb;
@@ -233,35 +233,36 @@ ExGetPcdInfo (
 
   ExMapTable = (DYNAMICEX_MAPPING *)((UINT8 *)Database + Database->ExMapTableOffset);
 
+  // MU_CHANGE [BEGIN] - Sorted ExMap lookup
   //
   // Find the PCD by GuidTableIdx and ExTokenNumber in ExMapTable.
   //
-  for (Index = 0; Index < Database->ExTokenCount; Index++) {
-    if (ExMapTable[Index].ExGuidIndex == GuidTableIdx) {
-      if (TokenNumber == PCD_INVALID_TOKEN_NUMBER) {
-        //
-        // TokenNumber is 0, follow spec to set PcdType to EFI_PCD_TYPE_8,
-        // PcdSize to 0 and PcdName to the null-terminated ASCII string
-        // associated with the token's namespace Guid.
-        //
-        PcdInfo->PcdType = EFI_PCD_TYPE_8;
-        PcdInfo->PcdSize = 0;
-        //
-        // Here use one representative in the token space to get the TokenSpaceCName.
-        //
-        PcdInfo->PcdName = GetPcdName (TRUE, IsPeiDb, ExMapTable[Index].TokenNumber);
-        return EFI_SUCCESS;
-      } else if (ExMapTable[Index].ExTokenNumber == TokenNumber) {
-        PcdInfo->PcdSize = DxePcdGetSize (ExMapTable[Index].TokenNumber);
-        LocalTokenNumber = GetLocalTokenNumber (IsPeiDb, ExMapTable[Index].TokenNumber);
-        PcdInfo->PcdType = GetPcdType (LocalTokenNumber);
-        PcdInfo->PcdName = GetPcdName (FALSE, IsPeiDb, ExMapTable[Index].TokenNumber);
-        return EFI_SUCCESS;
-      }
-    }
+  ExMapEntry = PcdFindExMapEntry (ExMapTable, Database->ExTokenCount, GuidTableIdx, TokenNumber);
+  if (ExMapEntry == NULL) {
+    return EFI_NOT_FOUND;
   }
 
-  return EFI_NOT_FOUND;
+  if (TokenNumber == PCD_INVALID_TOKEN_NUMBER) {
+    //
+    // TokenNumber is 0, follow spec to set PcdType to EFI_PCD_TYPE_8,
+    // PcdSize to 0 and PcdName to the null-terminated ASCII string
+    // associated with the token's namespace Guid.
+    //
+    PcdInfo->PcdType = EFI_PCD_TYPE_8;
+    PcdInfo->PcdSize = 0;
+    //
+    // Here use one representative in the token space to get the TokenSpaceCName.
+    //
+    PcdInfo->PcdName = GetPcdName (TRUE, IsPeiDb, ExMapEntry->TokenNumber);
+    return EFI_SUCCESS;
+  }
+
+  PcdInfo->PcdSize = DxePcdGetSize (ExMapEntry->TokenNumber);
+  LocalTokenNumber = GetLocalTokenNumber (IsPeiDb, ExMapEntry->TokenNumber);
+  PcdInfo->PcdType = GetPcdType (LocalTokenNumber);
+  PcdInfo->PcdName = GetPcdName (FALSE, IsPeiDb, ExMapEntry->TokenNumber);
+  return EFI_SUCCESS;
+  // MU_CHANGE [END] - Sorted ExMap lookup
 }
 
 /**
@@ -1595,8 +1596,8 @@ GetExPcdTokenNumber (
   IN UINT32          ExTokenNumber
   )
 {
-  UINT32             Index;
   DYNAMICEX_MAPPING  *ExMap;
+  DYNAMICEX_MAPPING  *ExMapEntry;         // MU_CHANGE - Sorted ExMap lookup
   EFI_GUID           *GuidTable;
   EFI_GUID           *MatchGuid;
   UINTN              MatchGuidIdx;
@@ -1610,13 +1611,13 @@ GetExPcdTokenNumber (
     if (MatchGuid != NULL) {
       MatchGuidIdx = MatchGuid - GuidTable;
 
-      for (Index = 0; Index < mPcdDatabase.PeiDb->ExTokenCount; Index++) {
-        if ((ExTokenNumber == ExMap[Index].ExTokenNumber) &&
-            (MatchGuidIdx == ExMap[Index].ExGuidIndex))
-        {
-          return ExMap[Index].TokenNumber;
-        }
+      // MU_CHANGE [BEGIN] - Sorted ExMap lookup
+      ExMapEntry = PcdFindExMapEntry (ExMap, mPcdDatabase.PeiDb->ExTokenCount, MatchGuidIdx, ExTokenNumber);
+      if ((ExMapEntry != NULL) && (ExTokenNumber != PCD_INVALID_TOKEN_NUMBER)) {
+        return ExMapEntry->TokenNumber;
       }
+
+      // MU_CHANGE [END] - Sorted ExMap lookup
     }
   }
 
@@ -1632,14 +1633,14 @@ GetExPcdTokenNumber (
 
   MatchGuidIdx = MatchGuid - GuidTable;
 
-  for (Index = 0; Index < mPcdDatabase.DxeDb->ExTokenCount; Index++) {
-    if ((ExTokenNumber == ExMap[Index].ExTokenNumber) &&
-        (MatchGuidIdx == ExMap[Index].ExGuidIndex))
-    {
-      return ExMap[Index].TokenNumber;
-    }
+  // MU_CHANGE [BEGIN] - Sorted ExMap lookup
+  ExMapEntry = PcdFindExMapEntry (ExMap, mPcdDatabase.DxeDb->ExTokenCount, MatchGuidIdx, ExTokenNumber);
+  if ((ExMapEntry != NULL) && (ExTokenNumber != PCD_INVALID_TOKEN_NUMBER)) {
+    return ExMapEntry->TokenNumber;
   }
 
+  // MU_CHANGE [END] - Sorted ExMap lookup
+
   DEBUG ((DEBUG_ERROR, "%a: Failed to find PCD with GUID: %g and token number: %d\n", __func__, Guid, ExTokenNumber));
   ASSERT (FALSE);
 
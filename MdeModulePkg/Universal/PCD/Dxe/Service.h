@@ -30,11 +30,17 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiRuntimeServicesTableLib.h>
 #include <Library/PcdDatabaseLoaderLib.h>   // MU_CHANGE
 
+#include "../Common/PcdExMap.h"             // MU_CHANGE - Sorted ExMap lookup
+
 //
 // Please make sure the PCD Serivce DXE Version is consistent with
 // the version of the generated DXE PCD Database by build tool.
 //
-#define PCD_SERVICE_DXE_VERSION  7
+// MU_CHANGE [BEGIN] - Sorted ExMap lookup
+// Version 8 sorts the DynamicEx mapping table by ExGuidIndex then ExTokenNumber.
+//
+#define PCD_SERVICE_DXE_VERSION  8
+// MU_CHANGE [END] - Sorted ExMap lookup
 
 //
 // PCD_DXE_SERVICE_DRIVER_VERSION is defined in Autogen.h.
@@ -168,7 +168,7 @@ ExGetPcdInfo (
   EFI_GUID           *MatchGuid;
   EFI_GUID           *GuidTable;
   DYNAMICEX_MAPPING  *ExMapTable;
-  UINTN              Index;
+  DYNAMICEX_MAPPING  *ExMapEntry;         // MU_CHANGE - Sorted ExMap lookup
   UINT32             LocalTokenNumber;
 
   GuidTable = (EFI_GUID *)((UINT8 *)Database + Database->GuidTableOffset);
@@ -182,35 +182,36 @@ ExGetPcdInfo (
 
   ExMapTable = (DYNAMICEX_MAPPING *)((UINT8 *)Database + Database->ExMapTableOffset);
 
+  // MU_CHANGE [BEGIN] - Sorted ExMap lookup
   //
   // Find the PCD by GuidTableIdx and ExTokenNumber in ExMapTable.
   //
-  for (Index = 0; Index < Database->ExTokenCount; Index++) {
-    if (ExMapTable[Index].ExGuidIndex == GuidTableIdx) {
-      if (TokenNumber == PCD_INVALID_TOKEN_NUMBER) {
-        //
-        // TokenNumber is 0, follow spec to set PcdType to EFI_PCD_TYPE_8,
-        // PcdSize to 0 and PcdName to the null-terminated ASCII string
-        // associated with the token's namespace Guid.
-        //
-        PcdInfo->PcdType = EFI_PCD_TYPE_8;
-        PcdInfo->PcdSize = 0;
-        //
-        // Here use one representative in the token space to get the TokenSpaceCName.
-        //
-        PcdInfo->PcdName = GetPcdName (TRUE, Database, ExMapTable[Index].TokenNumber);
-        return EFI_SUCCESS;
-      } else if (ExMapTable[Index].ExTokenNumber == TokenNumber) {
-        PcdInfo->PcdSize = PeiPcdGetSize (ExMapTable[Index].TokenNumber);
-        LocalTokenNumber = GetLocalTokenNumber (Database, ExMapTable[Index].TokenNumber);
-        PcdInfo->PcdType = GetPcdType (LocalTokenNumber);
-        PcdInfo->PcdName = GetPcdName (FALSE, Database, ExMapTable[Index].TokenNumber);
-        return EFI_SUCCESS;
-      }
-    }
+  ExMapEntry = PcdFindExMapEntry (ExMapTable, Database->ExTokenCount, GuidTableIdx, TokenNumber);
+  if (ExMapEntry == NULL) {
+    return EFI_NOT_FOUND;
   }
 
-  return EFI_NOT_FOUND;
+  if (TokenNumber == PCD_INVALID_TOKEN_NUMBER) {
+    //
+    // TokenNumber is 0, follow spec to set PcdType to EFI_PCD_TYPE_8,
+    // PcdSize to 0 and PcdName to the null-terminated ASCII string
+    // associated with the token's namespace Guid.
+    //
+    PcdInfo->PcdType = EFI_PCD_TYPE_8;
+    PcdInfo->PcdSize = 0;
+    //
+    // Here use one representative in the token space to get the TokenSpaceCName.
+    //
+    PcdInfo->PcdName = GetPcdName (TRUE, Database, ExMapEntry->TokenNumber);
+    return EFI_SUCCESS;
+  }
+
+  PcdInfo->PcdSize = PeiPcdGetSize (ExMapEntry->TokenNumber);
+  LocalTokenNumber = GetLocalTokenNumber (Database, ExMapEntry->TokenNumber);
+  PcdInfo->PcdType = GetPcdType (LocalTokenNumber);
+  PcdInfo->PcdName = GetPcdName (FALSE, Database, ExMapEntry->TokenNumber);
+  return EFI_SUCCESS;
+  // MU_CHANGE [END] - Sorted ExMap lookup
 }
 
 /**
@@ -1014,8 +1015,8 @@ GetExPcdTokenNumber (
   IN UINTN           ExTokenNumber
   )
 {
-  UINT32             Index;
   DYNAMICEX_MAPPING  *ExMap;
+  DYNAMICEX_MAPPING  *ExMapEntry;         // MU_CHANGE - Sorted ExMap lookup
   EFI_GUID           *GuidTable;
   EFI_GUID           *MatchGuid;
   UINTN              MatchGuidIdx;
@@ -1035,14 +1036,14 @@ GetExPcdTokenNumber (
 
   MatchGuidIdx = MatchGuid - GuidTable;
 
-  for (Index = 0; Index < PeiPcdDb->ExTokenCount; Index++) {
-    if ((ExTokenNumber == ExMap[Index].ExTokenNumber) &&
-        (MatchGuidIdx == ExMap[Index].ExGuidIndex))
-    {
-      return ExMap[Index].TokenNumber;
-    }
+  // MU_CHANGE [BEGIN] - Sorted ExMap lookup
+  ExMapEntry = PcdFindExMapEntry (ExMap, PeiPcdDb->ExTokenCount, MatchGuidIdx, ExTokenNumber);
+  if ((ExMapEntry != NULL) && (ExTokenNumber != PCD_INVALID_TOKEN_NUMBER)) {
+    return ExMapEntry->TokenNumber;
   }
 
+  // MU_CHANGE [END] - Sorted ExMap lookup
+
   return PCD_INVALID_TOKEN_NUMBER;
 }
 
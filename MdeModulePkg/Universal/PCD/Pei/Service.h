@@ -28,11 +28,17 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/MemoryAllocationLib.h>
 #include <Library/PcdDatabaseLoaderLib.h>   // MU_CHANGE
 
+#include "../Common/PcdExMap.h"             // MU_CHANGE - Sorted ExMap lookup
+
 //
 // Please make sure the PCD Serivce PEIM Version is consistent with
 // the version of the generated PEIM PCD Database by build tool.
 //
-#define PCD_SERVICE_PEIM_VERSION  7
+// MU_CHANGE [BEGIN] - Sorted ExMap lookup
+// Version 8 sorts the DynamicEx mapping table by ExGuidIndex then ExTokenNumber.
+//
+#define PCD_SERVICE_PEIM_VERSION  8
+// MU_CHANGE [END] - Sorted ExMap lookup
 
 //
 // PCD_PEI_SERVICE_DRIVER_VERSION is defined in Autogen.h.
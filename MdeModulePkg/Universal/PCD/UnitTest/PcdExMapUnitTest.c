@@ -0,0 +1,399 @@
+/** @file -- PcdExMapUnitTest.c
+  Host based unit tests for the DynamicEx token lookup of the PCD drivers.
+
+  The tests generate a DynamicEx mapping table the way GenPcdDb.py emits it,
+  sorted by ExGuidIndex then ExTokenNumber, and compare PcdFindExMapEntry ()
+  with a linear scan of the table.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+#include <time.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../Common/PcdExMap.h"
+
+#define UNIT_TEST_APP_NAME     "PCD DynamicEx Lookup Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+//
+// Shape of the generated database. The token spaces use every other GUID
+// table index, as the GUID table also holds the GUIDs of HII variables.
+//
+#define TEST_EX_TOKEN_COUNT     5000
+#define TEST_TOKEN_SPACE_COUNT  64
+#define TEST_EX_TOKEN_STRIDE    3
+
+//
+// Number of lookups of the throughput measurement.
+//
+#define TEST_BENCHMARK_LOOKUPS  2000000
+
+DYNAMICEX_MAPPING  *mExMapTable;
+
+/**
+  Return the GUID table index of a token space of the generated database.
+**/
+STATIC
+UINTN
+TestGuidTableIndex (
+  IN UINTN  TokenSpace
+  )
+{
+  return TokenSpace * 2 + 1;
+}
+
+/**
+  Return the DynamicEx token number of a PCD of the generated database.
+
+  Token numbers have gaps, so lookups of absent tokens can be tested.
+**/
+STATIC
+UINT32
+TestExTokenNumber (
+  IN UINTN  TokenSpace,
+  IN UINTN  Index
+  )
+{
+  return (UINT32)(((TokenSpace + 1) << 16) | (Index * TEST_EX_TOKEN_STRIDE + 1));
+}
+
+/**
+  Find a DynamicEx PCD with a scan of the whole table, as the PCD drivers did
+  before the table was sorted.
+**/
+STATIC
+DYNAMICEX_MAPPING *
+LinearFindExMapEntry (
+  IN DYNAMICEX_MAPPING  *ExMapTable,
+  IN UINTN              ExTokenCount,
+  IN UINTN              GuidTableIdx,
+  IN UINTN              ExTokenNumber
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < ExTokenCount; Index++) {
+    if ((ExMapTable[Index].ExGuidIndex == GuidTableIdx) &&
+        ((ExTokenNumber == 0) || (ExMapTable[Index].ExTokenNumber == ExTokenNumber)))
+    {
+      return &ExMapTable[Index];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Generate a sorted DynamicEx mapping table of TEST_EX_TOKEN_COUNT PCDs spread
+  unevenly over TEST_TOKEN_SPACE_COUNT token spaces.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ExMapSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  TokenSpace;
+  UINTN  Index;
+  UINTN  Count;
+  UINTN  Entry;
+
+  mExMapTable = AllocateZeroPool (TEST_EX_TOKEN_COUNT * sizeof (DYNAMICEX_MAPPING));
+  UT_ASSERT_NOT_NULL (mExMapTable);
+
+  Entry = 0;
+  for (TokenSpace = 0; TokenSpace < TEST_TOKEN_SPACE_COUNT; TokenSpace++) {
+    //
+    // Token spaces hold between 1 and 156 PCDs; the last one takes the rest.
+    //
+    Count = (TokenSpace % 7) * 25 + 1 + TokenSpace % 5;
+    if (TokenSpace == TEST_TOKEN_SPACE_COUNT - 1) {
+      Count = TEST_EX_TOKEN_COUNT - Entry;
+    }
+
+    for (Index = 0; Index < Count; Index++, Entry++) {
+      mExMapTable[Entry].ExTokenNumber = TestExTokenNumber (TokenSpace, Index);
+      mExMapTable[Entry].ExGuidIndex   = (UINT16)TestGuidTableIndex (TokenSpace);
+      mExMapTable[Entry].TokenNumber   = (UINT16)(TEST_EX_TOKEN_COUNT - Entry);
+    }
+  }
+
+  UT_ASSERT_EQUAL (Entry, TEST_EX_TOKEN_COUNT);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Free the generated DynamicEx mapping table.
+**/
+VOID
+EFIAPI
+ExMapCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  if (mExMapTable != NULL) {
+    FreePool (mExMapTable);
+    mExMapTable = NULL;
+  }
+}
+
+/**
+  Every PCD of the database is found, at the same entry as the linear scan.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FindEveryTokenTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN              Index;
+  DYNAMICEX_MAPPING  *Entry;
+
+  for (Index = 0; Index < TEST_EX_TOKEN_COUNT; Index++) {
+    Entry = PcdFindExMapEntry (
+              mExMapTable,
+              TEST_EX_TOKEN_COUNT,
+              mExMapTable[Index].ExGuidIndex,
+              mExMapTable[Index].ExTokenNumber
+              );
+    UT_ASSERT_EQUAL ((UINTN)Entry, (UINTN)&mExMapTable[Index]);
+    UT_ASSERT_EQUAL (
+      (UINTN)Entry,
+      (UINTN)LinearFindExMapEntry (
+               mExMapTable,
+               TEST_EX_TOKEN_COUNT,
+               mExMapTable[Index].ExGuidIndex,
+               mExMapTable[Index].ExTokenNumber
+               )
+      );
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Token number 0 returns the first PCD of the token space, as GetPcdInfo ()
+  needs a representative of the token space.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FindTokenSpaceTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN              TokenSpace;
+  DYNAMICEX_MAPPING  *Entry;
+
+  for (TokenSpace = 0; TokenSpace < TEST_TOKEN_SPACE_COUNT; TokenSpace++) {
+    Entry = PcdFindExMapEntry (mExMapTable, TEST_EX_TOKEN_COUNT, TestGuidTableIndex (TokenSpace), 0);
+    UT_ASSERT_NOT_NULL (Entry);
+    UT_ASSERT_EQUAL (Entry->ExGuidIndex, TestGuidTableIndex (TokenSpace));
+    UT_ASSERT_EQUAL (Entry->ExTokenNumber, TestExTokenNumber (TokenSpace, 0));
+    UT_ASSERT_EQUAL (
+      (UINTN)Entry,
+      (UINTN)LinearFindExMapEntry (mExMapTable, TEST_EX_TOKEN_COUNT, TestGuidTableIndex (TokenSpace), 0)
+      );
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Absent token numbers, GUID table indexes without a token space and empty
+  tables are not found.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FindAbsentTokenTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < TEST_EX_TOKEN_COUNT; Index++) {
+    //
+    // Between two token numbers of the token space.
+    //
+    UT_ASSERT_EQUAL (
+      (UINTN)PcdFindExMapEntry (mExMapTable, TEST_EX_TOKEN_COUNT, mExMapTable[Index].ExGuidIndex, mExMapTable[Index].ExTokenNumber + 1),
+      (UINTN)NULL
+      );
+    //
+    // The token number of the PCD in the token space of another GUID.
+    //
+    UT_ASSERT_EQUAL (
+      (UINTN)PcdFindExMapEntry (mExMapTable, TEST_EX_TOKEN_COUNT, mExMapTable[Index].ExGuidIndex - 1, mExMapTable[Index].ExTokenNumber),
+      (UINTN)NULL
+      );
+  }
+
+  //
+  // Below the first and beyond the last token space.
+  //
+  UT_ASSERT_EQUAL ((UINTN)PcdFindExMapEntry (mExMapTable, TEST_EX_TOKEN_COUNT, 0, 0), (UINTN)NULL);
+  UT_ASSERT_EQUAL ((UINTN)PcdFindExMapEntry (mExMapTable, TEST_EX_TOKEN_COUNT, TestGuidTableIndex (TEST_TOKEN_SPACE_COUNT), 0), (UINTN)NULL);
+  UT_ASSERT_EQUAL ((UINTN)PcdFindExMapEntry (mExMapTable, TEST_EX_TOKEN_COUNT, TestGuidTableIndex (TEST_TOKEN_SPACE_COUNT - 1), MAX_UINT32), (UINTN)NULL);
+
+  //
+  // Empty table and single entry table.
+  //
+  UT_ASSERT_EQUAL ((UINTN)PcdFindExMapEntry (mExMapTable, 0, mExMapTable[0].ExGuidIndex, 0), (UINTN)NULL);
+  UT_ASSERT_EQUAL ((UINTN)PcdFindExMapEntry (mExMapTable, 1, mExMapTable[0].ExGuidIndex, mExMapTable[0].ExTokenNumber), (UINTN)&mExMapTable[0]);
+  UT_ASSERT_EQUAL ((UINTN)PcdFindExMapEntry (mExMapTable, 1, mExMapTable[1].ExGuidIndex, mExMapTable[1].ExTokenNumber), (UINTN)NULL);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Convert a number of lookups done in a number of clock ticks to lookups per
+  second.
+**/
+STATIC
+UINT64
+LookupsPerSecond (
+  IN UINT64   Lookups,
+  IN clock_t  Ticks
+  )
+{
+  if (Ticks <= 0) {
+    Ticks = 1;
+  }
+
+  return DivU64x64Remainder (MultU64x32 (Lookups, CLOCKS_PER_SEC), (UINT64)Ticks, NULL);
+}
+
+/**
+  Measure the lookup throughput of the binary search and of the linear scan
+  over the 5000 token database.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+LookupBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN              Lookup;
+  UINTN              Index;
+  UINTN              LinearLookups;
+  UINTN              Found;
+  DYNAMICEX_MAPPING  *Entry;
+  clock_t            Start;
+  clock_t            SortedTicks;
+  clock_t            LinearTicks;
+
+  //
+  // Look the PCDs up in a scattered order.
+  //
+  Found = 0;
+  Start = clock ();
+  for (Lookup = 0; Lookup < TEST_BENCHMARK_LOOKUPS; Lookup++) {
+    Index = (Lookup * 2654435761U) % TEST_EX_TOKEN_COUNT;
+    Entry = PcdFindExMapEntry (mExMapTable, TEST_EX_TOKEN_COUNT, mExMapTable[Index].ExGuidIndex, mExMapTable[Index].ExTokenNumber);
+    Found += (Entry != NULL) ? 1 : 0;
+  }
+
+  SortedTicks = clock () - Start;
+  UT_ASSERT_EQUAL (Found, TEST_BENCHMARK_LOOKUPS);
+
+  //
+  // The linear scan is much slower, so it does fewer lookups.
+  //
+  LinearLookups = TEST_BENCHMARK_LOOKUPS / 200;
+  Found         = 0;
+  Start         = clock ();
+  for (Lookup = 0; Lookup < LinearLookups; Lookup++) {
+    Index = (Lookup * 2654435761U) % TEST_EX_TOKEN_COUNT;
+    Entry = LinearFindExMapEntry (mExMapTable, TEST_EX_TOKEN_COUNT, mExMapTable[Index].ExGuidIndex, mExMapTable[Index].ExTokenNumber);
+    Found += (Entry != NULL) ? 1 : 0;
+  }
+
+  LinearTicks = clock () - Start;
+  UT_ASSERT_EQUAL (Found, LinearLookups);
+
+  UT_LOG_INFO (
+    "%d DynamicEx PCDs: binary search %ld lookups/s, linear scan %ld lookups/s\n",
+    TEST_EX_TOKEN_COUNT,
+    LookupsPerSecond (TEST_BENCHMARK_LOOKUPS, SortedTicks),
+    LookupsPerSecond (LinearLookups, LinearTicks)
+    );
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the DynamicEx
+  token lookup and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      LookupTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&LookupTests, Framework, "PCD DynamicEx Lookup Tests", "Pcd.ExMap", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for LookupTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (LookupTests, "Every PCD of a 5000 token database is found", "FindEveryToken", FindEveryTokenTest, ExMapSetup, ExMapCleanup, NULL);
+  AddTestCase (LookupTests, "Token number 0 finds the first PCD of the token space", "FindTokenSpace", FindTokenSpaceTest, ExMapSetup, ExMapCleanup, NULL);
+  AddTestCase (LookupTests, "Absent PCDs are not found", "FindAbsentToken", FindAbsentTokenTest, ExMapSetup, ExMapCleanup, NULL);
+  AddTestCase (LookupTests, "Lookup throughput of a 5000 token database", "LookupBenchmark", LookupBenchmark, ExMapSetup, ExMapCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,384 @@
+/** @file
+  Decompresses the parallel LZMA GUIDed sections of the firmware volumes on the
+  APs, and hands the results over to ParallelLzmaCustomDecompressLib in HOBs.
+
+  Every section is split into jobs: one per chunk of a chunked payload, or a
+  single one for a plain LZMA stream. The APs take jobs from a shared counter
+  until none is left, so a large section does not hold up the others. A section
+  gets a HOB only if all of its jobs succeeded; any other section is left to be
+  decompressed serially when it is extracted. Every processor has one scratch
+  buffer, which it reuses for all the jobs it takes.
+
+  Copyright (C) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <PiPei.h>
+
+#include <Guid/ParallelLzmaDecompress.h>
+#include <Ppi/MpServices.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HobLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PeiServicesLib.h>
+#include <Library/SynchronizationLib.h>
+
+//
+// Forward declaration for routines used from LzmaDecompress library and
+// ParallelLzmaCustomDecompressLib.
+//
+RETURN_STATUS
+EFIAPI
+LzmaUefiDecompressGetInfo (
+  IN  CONST VOID  *Source,
+  IN  UINT32      SourceSize,
+  OUT UINT32      *DestinationSize,
+  OUT UINT32      *ScratchSize
+  );
+
+RETURN_STATUS
+EFIAPI
+LzmaUefiDecompress (
+  IN CONST VOID  *Source,
+  IN UINTN       SourceSize,
+  IN OUT VOID    *Destination,
+  IN OUT VOID    *Scratch
+  );
+
+RETURN_STATUS
+EFIAPI
+ParallelLzmaChunkedGetInfo (
+  IN  CONST VOID  *Source,
+  IN  UINTN       SourceSize,
+  OUT UINT32      *ChunkCount,
+  OUT UINT32      *DestinationSize,
+  OUT UINT32      *ScratchSize
+  );
+
+RETURN_STATUS
+EFIAPI
+ParallelLzmaDecompressChunk (
+  IN  CONST VOID  *Source,
+  IN  UINT32      ChunkIndex,
+  OUT VOID        *Destination,
+  IN  VOID        *Scratch
+  );
+
+//
+// ChunkIndex of the job decompressing a plain LZMA stream.
+//
+#define PARALLEL_LZMA_PLAIN_STREAM  MAX_UINT32
+
+typedef struct {
+  //
+  // Data of the GUIDed section. All the jobs of a section are consecutive.
+  //
+  CONST VOID       *Source;
+  UINTN            SourceSize;
+  UINT32           ChunkIndex;
+  VOID             *Destination;
+  UINT32           DestinationSize;
+  RETURN_STATUS    Status;
+} PARALLEL_LZMA_JOB;
+
+typedef struct {
+  PARALLEL_LZMA_JOB    *Jobs;
+  UINT32               JobCount;
+  //
+  // Index of the next job to take, plus one.
+  //
+  volatile UINT32      NextJob;
+  //
+  // One scratch buffer of ScratchSize bytes for each of WorkerCount processors,
+  // large enough for any job.
+  //
+  UINT8                *Scratch;
+  UINT32               ScratchSize;
+  UINT32               WorkerCount;
+  //
+  // Index of the next scratch buffer to take, plus one.
+  //
+  volatile UINT32      NextWorker;
+} PARALLEL_LZMA_WORK;
+
+/**
+  Takes a scratch buffer, then jobs until there is none left. Runs on the APs,
+  so it must not use PEI services or print.
+
+  @param[in, out] Buffer  The PARALLEL_LZMA_WORK shared by the processors.
+**/
+VOID
+EFIAPI
+ParallelLzmaDecompressWorker (
+  IN OUT VOID  *Buffer
+  )
+{
+  PARALLEL_LZMA_WORK  *Work;
+  PARALLEL_LZMA_JOB   *Job;
+  UINT32              Index;
+  VOID                *Scratch;
+
+  Work  = (PARALLEL_LZMA_WORK *)Buffer;
+  Index = InterlockedIncrement (&Work->NextWorker) - 1;
+  if (Index >= Work->WorkerCount) {
+    //
+    // There are more processors than scratch buffers, leave the jobs to the others.
+    //
+    return;
+  }
+
+  Scratch = Work->Scratch + (UINTN)Index * Work->ScratchSize;
+  for (Index = InterlockedIncrement (&Work->NextJob) - 1;
+       Index < Work->JobCount;
+       Index = InterlockedIncrement (&Work->NextJob) - 1)
+  {
+    Job = &Work->Jobs[Index];
+    if (Job->Status != RETURN_NOT_STARTED) {
+      continue;
+    }
+
+    if (Job->ChunkIndex == PARALLEL_LZMA_PLAIN_STREAM) {
+      Job->Status = LzmaUefiDecompress (Job->Source, Job->SourceSize, Job->Destination, Scratch);
+    } else {
+      Job->Status = ParallelLzmaDecompressChunk (Job->Source, Job->ChunkIndex, Job->Destination, Scratch);
+    }
+  }
+}
+
+/**
+  Adds the jobs decompressing the data of one parallel LZMA GUIDed section.
+
+  @param[in]      Source      The data of the GUIDed section.
+  @param[in]      SourceSize  The size, in bytes, of Source.
+  @param[in, out] Work        The work to add the jobs to. If Work->Jobs is
+                              NULL, the jobs are only counted and the scratch
+                              size they need is recorded.
+**/
+STATIC
+VOID
+ParallelLzmaAddSectionJobs (
+  IN     CONST VOID          *Source,
+  IN     UINTN               SourceSize,
+  IN OUT PARALLEL_LZMA_WORK  *Work
+  )
+{
+  RETURN_STATUS      Status;
+  UINT32             ChunkCount;
+  UINT32             DestinationSize;
+  UINT32             ScratchSize;
+  UINT32             Index;
+  BOOLEAN            Chunked;
+  VOID               *Destination;
+  PARALLEL_LZMA_JOB  *Job;
+
+  Status  = ParallelLzmaChunkedGetInfo (Source, SourceSize, &ChunkCount, &DestinationSize, &ScratchSize);
+  Chunked = (BOOLEAN)(Status != RETURN_UNSUPPORTED);
+  if (!Chunked) {
+    ChunkCount = 1;
+    Status     = LzmaUefiDecompressGetInfo (Source, (UINT32)SourceSize, &DestinationSize, &ScratchSize);
+  }
+
+  if (RETURN_ERROR (Status) || (DestinationSize == 0)) {
+    return;
+  }
+
+  if (Work->Jobs == NULL) {
+    Work->JobCount   += ChunkCount;
+    Work->ScratchSize = MAX (Work->ScratchSize, ScratchSize);
+    return;
+  }
+
+  Destination = AllocatePages (EFI_SIZE_TO_PAGES (DestinationSize));
+  if (Destination == NULL) {
+    return;
+  }
+
+  for (Index = 0; Index < ChunkCount; Index++) {
+    Job                  = &Work->Jobs[Work->JobCount];
+    Job->Source          = Source;
+    Job->SourceSize      = SourceSize;
+    Job->ChunkIndex      = Chunked ? Index : PARALLEL_LZMA_PLAIN_STREAM;
+    Job->Destination     = Destination;
+    Job->DestinationSize = DestinationSize;
+    Job->Status          = (ScratchSize > Work->ScratchSize) ? RETURN_OUT_OF_RESOURCES : RETURN_NOT_STARTED;
+    Work->JobCount++;
+  }
+}
+
+/**
+  Finds the parallel LZMA GUIDed sections of the firmware volumes and adds the
+  jobs decompressing them.
+
+  @param[in, out] Work  The work to add the jobs to. If Work->Jobs is NULL, the
+                        jobs are only counted.
+**/
+STATIC
+VOID
+ParallelLzmaFindSections (
+  IN OUT PARALLEL_LZMA_WORK  *Work
+  )
+{
+  EFI_STATUS                 Status;
+  UINTN                      Instance;
+  EFI_PEI_FV_HANDLE          VolumeHandle;
+  EFI_PEI_FILE_HANDLE        FileHandle;
+  EFI_FV_FILE_INFO           FileInfo;
+  EFI_COMMON_SECTION_HEADER  *Section;
+  UINT8                      *End;
+  UINTN                      SectionSize;
+  EFI_GUID                   *SectionGuid;
+  UINT16                     DataOffset;
+
+  for (Instance = 0; !EFI_ERROR (PeiServicesFfsFindNextVolume (Instance, &VolumeHandle)); Instance++) {
+    FileHandle = NULL;
+    while (!EFI_ERROR (PeiServicesFfsFindNextFile (EFI_FV_FILETYPE_ALL, VolumeHandle, &FileHandle))) {
+      Status = PeiServicesFfsGetFileInfo (FileHandle, &FileInfo);
+      if (EFI_ERROR (Status)) {
+        continue;
+      }
+
+      Section = (EFI_COMMON_SECTION_HEADER *)FileInfo.Buffer;
+      End     = (UINT8 *)FileInfo.Buffer + FileInfo.BufferSize;
+      while ((UINT8 *)Section + sizeof (EFI_COMMON_SECTION_HEADER2) <= End) {
+        SectionSize = IS_SECTION2 (Section) ? SECTION2_SIZE (Section) : SECTION_SIZE (Section);
+        if ((SectionSize < sizeof (EFI_COMMON_SECTION_HEADER)) || (SectionSize > (UINTN)(End - (UINT8 *)Section))) {
+          break;
+        }
+
+        if ((Section->Type == EFI_SECTION_GUID_DEFINED) && (SectionSize > sizeof (EFI_GUID_DEFINED_SECTION2))) {
+          if (IS_SECTION2 (Section)) {
+            SectionGuid = &((EFI_GUID_DEFINED_SECTION2 *)Section)->SectionDefinitionGuid;
+            DataOffset  = ((EFI_GUID_DEFINED_SECTION2 *)Section)->DataOffset;
+          } else {
+            SectionGuid = &((EFI_GUID_DEFINED_SECTION *)Section)->SectionDefinitionGuid;
+            DataOffset  = ((EFI_GUID_DEFINED_SECTION *)Section)->DataOffset;
+          }
+
+          if (CompareGuid (SectionGuid, &gParallelLzmaCustomDecompressGuid) && (DataOffset < SectionSize)) {
+            ParallelLzmaAddSectionJobs ((UINT8 *)Section + DataOffset, SectionSize - DataOffset, Work);
+          }
+        }
+
+        Section = (EFI_COMMON_SECTION_HEADER *)ALIGN_POINTER ((UINT8 *)Section + SectionSize, 4);
+      }
+    }
+  }
+}
+
+/**
+  Entry point of the parallel LZMA decompression PEIM.
+
+  @param[in] FileHandle   Handle of the file being invoked.
+  @param[in] PeiServices  Describes the list of possible PEI Services.
+
+  @retval EFI_SUCCESS  The sections were decompressed, or left to be
+                       decompressed when they are extracted.
+**/
+EFI_STATUS
+EFIAPI
+ParallelLzmaDecompressPeiEntry (
+  IN       EFI_PEI_FILE_HANDLE  FileHandle,
+  IN CONST EFI_PEI_SERVICES     **PeiServices
+  )
+{
+  EFI_STATUS                    Status;
+  EFI_PEI_MP_SERVICES_PPI       *MpServices;
+  UINTN                         NumberOfProcessors;
+  UINTN                         NumberOfEnabledProcessors;
+  PARALLEL_LZMA_WORK            Work;
+  PARALLEL_LZMA_JOB             *Job;
+  PARALLEL_DECOMPRESSED_BUFFER  Buffer;
+  UINT32                        Index;
+  UINT32                        First;
+  BOOLEAN                       Success;
+  UINTN                         Decompressed;
+  UINTN                         JobPages;
+  UINTN                         ScratchPages;
+
+  Status = PeiServicesLocatePpi (&gEfiPeiMpServicesPpiGuid, 0, NULL, (VOID **)&MpServices);
+  if (EFI_ERROR (Status)) {
+    return EFI_SUCCESS;
+  }
+
+  Status = MpServices->GetNumberOfProcessors (PeiServices, MpServices, &NumberOfProcessors, &NumberOfEnabledProcessors);
+  if (EFI_ERROR (Status) || (NumberOfEnabledProcessors < 2)) {
+    return EFI_SUCCESS;
+  }
+
+  ZeroMem (&Work, sizeof (Work));
+  ParallelLzmaFindSections (&Work);
+  if (Work.JobCount == 0) {
+    return EFI_SUCCESS;
+  }
+
+  JobPages  = EFI_SIZE_TO_PAGES (Work.JobCount * sizeof (PARALLEL_LZMA_JOB));
+  Work.Jobs = AllocatePages (JobPages);
+  if (Work.Jobs == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  ZeroMem (Work.Jobs, EFI_PAGES_TO_SIZE (JobPages));
+
+  //
+  // Give every processor a scratch buffer, or as many of them as fit.
+  //
+  Work.ScratchSize = ALIGN_VALUE (MAX (Work.ScratchSize, 1), sizeof (UINT64));
+  for (Work.WorkerCount = (UINT32)NumberOfEnabledProcessors; Work.WorkerCount > 0; Work.WorkerCount /= 2) {
+    ScratchPages = EFI_SIZE_TO_PAGES ((UINTN)Work.WorkerCount * Work.ScratchSize);
+    Work.Scratch = AllocatePages (ScratchPages);
+    if (Work.Scratch != NULL) {
+      break;
+    }
+  }
+
+  if (Work.Scratch == NULL) {
+    FreePages (Work.Jobs, JobPages);
+    return EFI_SUCCESS;
+  }
+
+  //
+  // The firmware volumes do not change between the two passes, so this finds
+  // the same jobs that were counted, unless allocations failed.
+  //
+  Work.JobCount = 0;
+  ParallelLzmaFindSections (&Work);
+
+  Status = MpServices->StartupAllAPs (PeiServices, MpServices, ParallelLzmaDecompressWorker, FALSE, 0, &Work);
+  DEBUG ((DEBUG_INFO, "%a: %u jobs on %u processors - %r\n", __func__, Work.JobCount, Work.WorkerCount, Status));
+
+  //
+  // Take whatever the APs left, if they could not be started.
+  //
+  ParallelLzmaDecompressWorker (&Work);
+
+  Decompressed = 0;
+  for (First = 0; First < Work.JobCount; First = Index) {
+    Success = TRUE;
+    for (Index = First; Index < Work.JobCount && Work.Jobs[Index].Source == Work.Jobs[First].Source; Index++) {
+      Job = &Work.Jobs[Index];
+      if (RETURN_ERROR (Job->Status)) {
+        Success = FALSE;
+      }
+    }
+
+    Job = &Work.Jobs[First];
+    if (!Success) {
+      DEBUG ((DEBUG_WARN, "%a: section at %p left for serial decompression\n", __func__, Job->Source));
+      FreePages (Job->Destination, EFI_SIZE_TO_PAGES (Job->DestinationSize));
+      continue;
+    }
+
+    Buffer.SourceBuffer       = (VOID *)Job->Source;
+    Buffer.DecompressedBuffer = Job->Destination;
+    Buffer.DecompressedSize   = Job->DestinationSize;
+    BuildGuidDataHob (&gParallelLzmaCustomDecompressHobGuid, &Buffer, sizeof (Buffer));
+    Decompressed += Job->DestinationSize;
+  }
+
+  DEBUG ((DEBUG_INFO, "%a: %lu bytes decompressed\n", __func__, (UINT64)Decompressed));
+  FreePages (Work.Scratch, ScratchPages);
+  FreePages (Work.Jobs, JobPages);
+  return EFI_SUCCESS;
+}
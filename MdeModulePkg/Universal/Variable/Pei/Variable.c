@@ -286,6 +286,92 @@ GetVariableDataPtr (
   return (UINT8 *)Value;
 }
 
+// MU_CHANGE [BEGIN] - Only the target blocks of the FTW last write are backed up
+
+/**
+  Get the length of the NV storage, from the target address of the FTW last
+  write on, that is backed up in spare block.
+
+  The last write erased whole target blocks, so its length is rounded up to the
+  block size of the firmware volume.
+
+  @param  FvHeader          Firmware volume header of the NV storage.
+  @param  FtwLastWriteData  The FTW last write data.
+
+  @return The length backed up in spare block.
+
+**/
+UINTN
+GetFtwBackUpLength (
+  IN EFI_FIRMWARE_VOLUME_HEADER            *FvHeader,
+  IN FAULT_TOLERANT_WRITE_LAST_WRITE_DATA  *FtwLastWriteData
+  )
+{
+  UINTN  BlockSize;
+  UINTN  Length;
+
+  Length = (UINTN)FtwLastWriteData->Length;
+  if (FvHeader->Signature == EFI_FVH_SIGNATURE) {
+    BlockSize = FvHeader->BlockMap[0].Length;
+    if (BlockSize != 0) {
+      Length = ((Length + BlockSize - 1) / BlockSize) * BlockSize;
+    }
+  }
+
+  return Length;
+}
+
+/**
+  Check if an address is in the part of spare block that backs up the NV
+  storage.
+
+  @param  StoreInfo  Pointer to variable store info structure.
+  @param  Address    The address to check.
+
+  @retval TRUE       The address is in spare block.
+  @retval FALSE      The address is not in spare block.
+
+**/
+BOOLEAN
+IsInFtwSpare (
+  IN VARIABLE_STORE_INFO  *StoreInfo,
+  IN UINTN                Address
+  )
+{
+  UINTN  SpareAddress;
+
+  if (StoreInfo->FtwLastWriteData == NULL) {
+    return FALSE;
+  }
+
+  SpareAddress = (UINTN)StoreInfo->FtwLastWriteData->SpareAddress;
+  return (BOOLEAN)((Address >= SpareAddress) && (Address < SpareAddress + StoreInfo->FtwBackUpLength));
+}
+
+/**
+  Get the address in NV storage of a location that may be in spare block.
+
+  @param  StoreInfo  Pointer to variable store info structure.
+  @param  Address    The address in NV storage or spare block.
+
+  @return The address in NV storage.
+
+**/
+UINTN
+GetNvStorageAddress (
+  IN VARIABLE_STORE_INFO  *StoreInfo,
+  IN UINTN                Address
+  )
+{
+  if (IsInFtwSpare (StoreInfo, Address)) {
+    return (UINTN)StoreInfo->FtwLastWriteData->TargetAddress + (Address - (UINTN)StoreInfo->FtwLastWriteData->SpareAddress);
+  }
+
+  return Address;
+}
+
+// MU_CHANGE [END]
+
 /**
   This code gets the pointer to the next variable header.
 
@@ -318,7 +404,18 @@ GetNextVariablePtr (
   if (StoreInfo->FtwLastWriteData != NULL) {
     TargetAddress = StoreInfo->FtwLastWriteData->TargetAddress;
     SpareAddress  = StoreInfo->FtwLastWriteData->SpareAddress;
-    if (((UINTN)Variable < (UINTN)TargetAddress) && (Value >= (UINTN)TargetAddress)) {
+    // MU_CHANGE [BEGIN] - Only the target blocks of the FTW last write are backed up
+    if (IsInFtwSpare (StoreInfo, (UINTN)Variable)) {
+      if (Value >= (UINTN)SpareAddress + StoreInfo->FtwBackUpLength) {
+        //
+        // Next variable is in NV storage again, after the blocks backed up in spare block.
+        //
+        Value = (UINTN)TargetAddress + (Value - (UINTN)SpareAddress);
+      }
+    } else if (((UINTN)Variable < (UINTN)TargetAddress) && (Value >= (UINTN)TargetAddress) &&
+               (Value < (UINTN)TargetAddress + StoreInfo->FtwBackUpLength))
+    {
+      // MU_CHANGE [END]
       //
       // Next variable is in spare block.
       //
@@ -576,9 +673,11 @@ GetVariableStore (
   UINT64                                NvStorageSize64;
   FAULT_TOLERANT_WRITE_LAST_WRITE_DATA  *FtwLastWriteData;
   UINT32                                BackUpOffset;
+  UINTN                                 BackUpLength;     // MU_CHANGE
 
   StoreInfo->IndexTable       = NULL;
   StoreInfo->FtwLastWriteData = NULL;
+  StoreInfo->FtwBackUpLength  = 0;                        // MU_CHANGE
   StoreInfo->AuthFlag         = FALSE;
   VariableStoreHeader         = NULL;
   switch (Type) {
@@ -620,12 +719,28 @@ GetVariableStore (
             //
             FvHeader = (EFI_FIRMWARE_VOLUME_HEADER *)(UINTN)FtwLastWriteData->SpareAddress;
             DEBUG ((DEBUG_INFO, "PeiVariable: NV storage is backed up in spare block: 0x%x\n", (UINTN)FtwLastWriteData->SpareAddress));
+            // MU_CHANGE [BEGIN] - Only the target blocks of the FTW last write are backed up
+            BackUpLength = GetFtwBackUpLength (FvHeader, FtwLastWriteData);
+            if (BackUpLength < NvStorageSize) {
+              //
+              // Only the first blocks of the NV storage are backed up in spare block,
+              // the rest of it is still valid in flash.
+              //
+              StoreInfo->FtwLastWriteData = FtwLastWriteData;
+              StoreInfo->FtwBackUpLength  = BackUpLength;
+            }
+
+            // MU_CHANGE [END]
           } else if ((FtwLastWriteData->TargetAddress > NvStorageBase) && (FtwLastWriteData->TargetAddress < (NvStorageBase + NvStorageSize))) {
             StoreInfo->FtwLastWriteData = FtwLastWriteData;
             //
             // Flash NV storage from the offset is backed up in spare block.
             //
             BackUpOffset = (UINT32)(FtwLastWriteData->TargetAddress - NvStorageBase);
+            // MU_CHANGE [BEGIN] - Only the target blocks of the FTW last write are backed up
+            BackUpLength               = GetFtwBackUpLength (FvHeader, FtwLastWriteData);
+            StoreInfo->FtwBackUpLength = MIN (BackUpLength, NvStorageSize - BackUpOffset);
+            // MU_CHANGE [END]
             DEBUG ((DEBUG_INFO, "PeiVariable: High partial NV storage from offset: %x is backed up in spare block: 0x%x\n", BackUpOffset, (UINTN)FtwLastWriteData->SpareAddress));
             //
             // At least one block data in flash NV storage is still valid, so still leave FvHeader point to NV storage base.
@@ -696,6 +811,7 @@ GetVariableHeader (
   EFI_PHYSICAL_ADDRESS  SpareAddress;
   EFI_HOB_GUID_TYPE     *GuidHob;
   UINTN                 PartialHeaderSize;
+  UINTN                 EndAddress;                       // MU_CHANGE
 
   if (Variable == NULL) {
     return FALSE;
@@ -709,16 +825,27 @@ GetVariableHeader (
   if (StoreInfo->FtwLastWriteData != NULL) {
     TargetAddress = StoreInfo->FtwLastWriteData->TargetAddress;
     SpareAddress  = StoreInfo->FtwLastWriteData->SpareAddress;
-    if (((UINTN)Variable > (UINTN)SpareAddress) &&
-        (((UINTN)Variable - (UINTN)SpareAddress + (UINTN)TargetAddress) >= (UINTN)GetEndPointer (StoreInfo->VariableStoreHeader)))
-    {
+    // MU_CHANGE [BEGIN] - Only the target blocks of the FTW last write are backed up
+    //
+    // Variable may be in spare block or in NV storage, before or after the blocks
+    // backed up in spare block. So may the variable store header.
+    //
+    EndAddress = (UINTN)GetEndPointer (StoreInfo->VariableStoreHeader);
+    if (IsInFtwSpare (StoreInfo, (UINTN)StoreInfo->VariableStoreHeader)) {
+      EndAddress = (UINTN)TargetAddress + (EndAddress - (UINTN)SpareAddress);
+    }
+
+    if (GetNvStorageAddress (StoreInfo, (UINTN)Variable) >= EndAddress) {
       //
       // Reach the end of variable store.
       //
       return FALSE;
     }
 
-    if (((UINTN)Variable < (UINTN)TargetAddress) && (((UINTN)Variable + GetVariableHeaderSize (StoreInfo->AuthFlag)) > (UINTN)TargetAddress)) {
+    if (!IsInFtwSpare (StoreInfo, (UINTN)Variable) &&
+        ((UINTN)Variable < (UINTN)TargetAddress) && (((UINTN)Variable + GetVariableHeaderSize (StoreInfo->AuthFlag)) > (UINTN)TargetAddress))
+    {
+      // MU_CHANGE [END]
       //
       // Variable header pointed by Variable is inconsecutive,
       // create a guid hob to combine the two partial variable header content together.
@@ -43,6 +43,11 @@ typedef struct {
   // in spare block.
   //
   FAULT_TOLERANT_WRITE_LAST_WRITE_DATA    *FtwLastWriteData;
+  //
+  // MU_CHANGE - Length of the NV storage from FtwLastWriteData->TargetAddress on
+  // that is backed up in spare block. The NV storage after it is still in flash.
+  //
+  UINTN                                   FtwBackUpLength;
   BOOLEAN                                 AuthFlag;
 } VARIABLE_STORE_INFO;
 
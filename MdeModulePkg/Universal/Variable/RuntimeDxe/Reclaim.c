@@ -8,6 +8,46 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 **/
 
 #include "Variable.h"
+// MU_CHANGE [BEGIN] - Incremental variable store reclaim
+#include "VariableParsing.h"
+#include "VariableRuntimeCache.h"
+#include "VariableIndex.h"
+
+///
+/// State of the incremental reclaim of the non-volatile variable store.
+/// All offsets are relative to the start of the variable store.
+///
+typedef struct {
+  //
+  // Location of the variable store in its firmware volume, set on first use.
+  //
+  EFI_HANDLE    FvbHandle;
+  EFI_LBA       StoreLba;
+  UINTN         StoreOffsetInBlock;
+  UINTN         BlockSize;
+  //
+  // TRUE while a compaction pass is in progress. The live variables before
+  // PackedOffset have been compacted, the variables between PackedOffset and
+  // ScanOffset are covered by a deleted filler variable and the variables from
+  // ScanOffset on have not been looked at yet.
+  //
+  BOOLEAN       Active;
+  UINTN         PackedOffset;
+  UINTN         ScanOffset;
+  //
+  // Free space released by the last pass that has not been erased yet.
+  //
+  UINTN         DirtyOffset;
+  UINTN         DirtyEnd;
+  //
+  // End of the variables when the last pass completed. A new pass only starts
+  // once variables have been written since.
+  //
+  UINTN         PassEndOffset;
+} VARIABLE_INCREMENTAL_RECLAIM;
+
+STATIC VARIABLE_INCREMENTAL_RECLAIM  mIncrementalReclaim;
+// MU_CHANGE [END]
 
 /**
   Gets LBA of block and offset by given address.
@@ -155,3 +195,516 @@ FtwVariableSpace (
 
   return Status;
 }
+
+// MU_CHANGE [BEGIN] - Incremental variable store reclaim
+
+/**
+  Check if the incremental reclaim is enabled and find where the variable store
+  sits in its firmware volume.
+
+  @retval TRUE          The incremental reclaim can be used.
+  @retval FALSE         The incremental reclaim is disabled or not supported.
+
+**/
+STATIC
+BOOLEAN
+IncrementalReclaimEnabled (
+  VOID
+  )
+{
+  EFI_STATUS            Status;
+  EFI_PHYSICAL_ADDRESS  VariableBase;
+
+  if ((PcdGet32 (PcdVariableIncrementalReclaimSpareBlocks) == 0) ||
+      mVariableModuleGlobal->VariableGlobal.EmuNvMode ||
+      (mNvVariableCache == NULL) ||
+      (mNvFvHeaderCache == NULL))
+  {
+    return FALSE;
+  }
+
+  if (mIncrementalReclaim.BlockSize == 0) {
+    //
+    // Same assumption as GetLbaAndOffsetByAddress (), one FV has one type of BlockLength.
+    //
+    VariableBase = mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase;
+    Status       = GetFvbInfoByAddress (VariableBase, &mIncrementalReclaim.FvbHandle, NULL);
+    if (!EFI_ERROR (Status)) {
+      Status = GetLbaAndOffsetByAddress (VariableBase, &mIncrementalReclaim.StoreLba, &mIncrementalReclaim.StoreOffsetInBlock);
+    }
+
+    if (EFI_ERROR (Status) || (mNvFvHeaderCache->BlockMap[0].Length == 0)) {
+      return FALSE;
+    }
+
+    mIncrementalReclaim.BlockSize = mNvFvHeaderCache->BlockMap[0].Length;
+  }
+
+  return TRUE;
+}
+
+/**
+  Get the start of the erase block holding a location of the variable store.
+
+  @param[in] Offset     Offset in the variable store.
+
+  @return Offset of the start of the block, or 0 for the block holding the
+          variable store header.
+
+**/
+STATIC
+UINTN
+IncrementalReclaimBlockStart (
+  IN UINTN  Offset
+  )
+{
+  UINTN  OffsetInBlock;
+
+  OffsetInBlock = (mIncrementalReclaim.StoreOffsetInBlock + Offset) % mIncrementalReclaim.BlockSize;
+  return (OffsetInBlock > Offset) ? 0 : Offset - OffsetInBlock;
+}
+
+/**
+  Get the end of the erase block holding a location of the variable store.
+
+  @param[in] Offset     Offset in the variable store.
+
+  @return Offset of the end of the block, capped to the size of the store.
+
+**/
+STATIC
+UINTN
+IncrementalReclaimBlockEnd (
+  IN UINTN  Offset
+  )
+{
+  UINTN  OffsetInBlock;
+
+  OffsetInBlock = (mIncrementalReclaim.StoreOffsetInBlock + Offset) % mIncrementalReclaim.BlockSize;
+  return MIN (Offset - OffsetInBlock + mIncrementalReclaim.BlockSize, mNvVariableCache->Size);
+}
+
+/**
+  Write a range of the variable store cache to flash with one FTW write.
+
+  The runtime cache and the lookup index are brought in line with the write.
+  If the write fails, the range of the cache is reloaded from flash.
+
+  @param[in] Offset     Offset of the range in the variable store.
+  @param[in] Length     Length of the range.
+
+  @retval EFI_SUCCESS   The range has been written.
+  @retval Others        The FTW write failed.
+
+**/
+STATIC
+EFI_STATUS
+IncrementalReclaimWrite (
+  IN UINTN  Offset,
+  IN UINTN  Length
+  )
+{
+  EFI_STATUS                         Status;
+  EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *FtwProtocol;
+  UINTN                              Position;
+
+  Status = GetFtwProtocol ((VOID **)&FtwProtocol);
+  if (!EFI_ERROR (Status)) {
+    Position = mIncrementalReclaim.StoreOffsetInBlock + Offset;
+    Status   = FtwProtocol->Write (
+                              FtwProtocol,
+                              mIncrementalReclaim.StoreLba + Position / mIncrementalReclaim.BlockSize,
+                              Position % mIncrementalReclaim.BlockSize,
+                              Length,
+                              NULL,
+                              mIncrementalReclaim.FvbHandle,
+                              (UINT8 *)mNvVariableCache + Offset
+                              );
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Variable: incremental reclaim write at 0x%x failed - %r\n", Offset, Status));
+    CopyMem (
+      (UINT8 *)mNvVariableCache + Offset,
+      (UINT8 *)(UINTN)mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase + Offset,
+      Length
+      );
+  }
+
+  VariableIndexInvalidate (VariableStoreTypeNv);
+  SynchronizeRuntimeVariableCache (
+    &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeNvCache,
+    Offset,
+    Length
+    );
+
+  return Status;
+}
+
+/**
+  Erase the next block of the free space released by the last pass.
+
+  @retval EFI_SUCCESS   The block has been erased.
+  @retval Others        The FTW write failed.
+
+**/
+STATIC
+EFI_STATUS
+IncrementalReclaimErase (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Offset;
+  UINTN       Length;
+
+  Offset = mIncrementalReclaim.DirtyOffset;
+  Length = IncrementalReclaimBlockEnd (Offset) - Offset;
+  SetMem ((UINT8 *)mNvVariableCache + Offset, Length, 0xff);
+  Status = IncrementalReclaimWrite (Offset, Length);
+  if (!EFI_ERROR (Status)) {
+    mIncrementalReclaim.DirtyOffset += Length;
+  }
+
+  return Status;
+}
+
+/**
+  Recompute the size of the variables in the store after a pass completed.
+
+**/
+STATIC
+VOID
+IncrementalReclaimUpdateTotalSize (
+  VOID
+  )
+{
+  VARIABLE_HEADER  *Variable;
+  VARIABLE_HEADER  *NextVariable;
+  UINTN            VariableSize;
+
+  mVariableModuleGlobal->HwErrVariableTotalSize      = 0;
+  mVariableModuleGlobal->CommonVariableTotalSize     = 0;
+  mVariableModuleGlobal->CommonUserVariableTotalSize = 0;
+  Variable                                           = GetStartPointer (mNvVariableCache);
+  while (IsValidVariableHeader (Variable, GetEndPointer (mNvVariableCache))) {
+    NextVariable = GetNextVariablePtr (Variable, mVariableModuleGlobal->VariableGlobal.AuthFormat);
+    VariableSize = (UINTN)NextVariable - (UINTN)Variable;
+    if ((Variable->Attributes & EFI_VARIABLE_HARDWARE_ERROR_RECORD) == EFI_VARIABLE_HARDWARE_ERROR_RECORD) {
+      mVariableModuleGlobal->HwErrVariableTotalSize += VariableSize;
+    } else {
+      mVariableModuleGlobal->CommonVariableTotalSize += VariableSize;
+      if (IsUserVariable (Variable)) {
+        mVariableModuleGlobal->CommonUserVariableTotalSize += VariableSize;
+      }
+    }
+
+    Variable = NextVariable;
+  }
+}
+
+/**
+  Compact the live variables into the erase block at the start of the part of
+  the store not compacted yet.
+
+  Live variables are copied down over the deleted ones, in store order, as long
+  as they fit in the block. The first one may extend the write to the next
+  blocks, so every step makes progress whatever the size of the variables. The
+  space between the compacted variables and the first variable not moved is
+  turned into one deleted filler variable, which hides the old copies of the
+  moved variables. Once all the variables have been compacted, the rest of the
+  block is erased and the end of the variables moves down.
+
+  @retval EFI_SUCCESS   The step completed.
+  @retval Others        The FTW write failed, the pass is abandoned.
+
+**/
+STATIC
+EFI_STATUS
+IncrementalReclaimCompact (
+  VOID
+  )
+{
+  EFI_STATUS       Status;
+  UINT8            *Store;
+  BOOLEAN          AuthFormat;
+  UINTN            HeaderSize;
+  UINTN            FillerSize;
+  UINTN            LastOffset;
+  UINTN            PackedOffset;
+  UINTN            ScanOffset;
+  UINTN            WindowStart;
+  UINTN            WindowEnd;
+  UINTN            VariableSize;
+  BOOLEAN          Moved;
+  VARIABLE_HEADER  *Variable;
+  VARIABLE_HEADER  *Filler;
+
+  Store        = (UINT8 *)mNvVariableCache;
+  AuthFormat   = mVariableModuleGlobal->VariableGlobal.AuthFormat;
+  HeaderSize   = GetVariableHeaderSize (AuthFormat);
+  FillerSize   = HEADER_ALIGN (HeaderSize + sizeof (CHAR16));
+  LastOffset   = mVariableModuleGlobal->NonVolatileLastVariableOffset;
+  PackedOffset = mIncrementalReclaim.PackedOffset;
+  ScanOffset   = mIncrementalReclaim.ScanOffset;
+
+  //
+  // Skip the live variables that are already in place.
+  //
+  while ((PackedOffset == ScanOffset) && (ScanOffset < LastOffset)) {
+    Variable = (VARIABLE_HEADER *)(Store + ScanOffset);
+    if ((Variable->State != VAR_ADDED) && (Variable->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED))) {
+      break;
+    }
+
+    VariableSize  = (UINTN)GetNextVariablePtr (Variable, AuthFormat) - (UINTN)Variable;
+    PackedOffset += VariableSize;
+    ScanOffset   += VariableSize;
+  }
+
+  WindowStart = IncrementalReclaimBlockStart (PackedOffset);
+  WindowEnd   = IncrementalReclaimBlockEnd (PackedOffset);
+  Moved       = FALSE;
+  while (ScanOffset < LastOffset) {
+    Variable     = (VARIABLE_HEADER *)(Store + ScanOffset);
+    VariableSize = (UINTN)GetNextVariablePtr (Variable, AuthFormat) - (UINTN)Variable;
+    if ((Variable->State != VAR_ADDED) && (Variable->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED))) {
+      if (VariableSize < FillerSize) {
+        //
+        // Not a well formed variable, leave it to the full reclaim.
+        //
+        mIncrementalReclaim.Active = FALSE;
+        return EFI_SUCCESS;
+      }
+
+      ScanOffset += VariableSize;
+      continue;
+    }
+
+    //
+    // Keep room for the header of the filler variable behind the moved ones.
+    //
+    if (PackedOffset + VariableSize + FillerSize > WindowEnd) {
+      if (Moved) {
+        break;
+      }
+
+      WindowEnd = IncrementalReclaimBlockEnd (PackedOffset + VariableSize + FillerSize - 1);
+    }
+
+    CopyMem (Store + PackedOffset, Variable, VariableSize);
+    PackedOffset += VariableSize;
+    ScanOffset   += VariableSize;
+    Moved         = TRUE;
+  }
+
+  if (ScanOffset >= LastOffset) {
+    //
+    // All the variables have been compacted, end the variables here.
+    //
+    SetMem (Store + PackedOffset, WindowEnd - PackedOffset, 0xff);
+  } else {
+    Filler = (VARIABLE_HEADER *)(Store + PackedOffset);
+    ZeroMem (Filler, FillerSize);
+    Filler->StartId    = VARIABLE_DATA;
+    Filler->State      = VAR_ADDED & VAR_IN_DELETED_TRANSITION & VAR_DELETED;
+    Filler->Attributes = EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS;
+    SetNameSizeOfVariable (Filler, sizeof (CHAR16), AuthFormat);
+    SetDataSizeOfVariable (Filler, ScanOffset - PackedOffset - HeaderSize - sizeof (CHAR16), AuthFormat);
+    ASSERT ((UINTN)GetNextVariablePtr (Filler, AuthFormat) == (UINTN)Store + ScanOffset);
+  }
+
+  Status = IncrementalReclaimWrite (WindowStart, WindowEnd - WindowStart);
+  if (EFI_ERROR (Status)) {
+    mIncrementalReclaim.Active = FALSE;
+    return Status;
+  }
+
+  if (ScanOffset < LastOffset) {
+    mIncrementalReclaim.PackedOffset = PackedOffset;
+    mIncrementalReclaim.ScanOffset   = ScanOffset;
+    return EFI_SUCCESS;
+  }
+
+  //
+  // The space from the end of the block to the old end of the variables is
+  // erased by the next steps, or before a variable is appended to it.
+  //
+  mIncrementalReclaim.Active        = FALSE;
+  mIncrementalReclaim.DirtyOffset   = WindowEnd;
+  mIncrementalReclaim.DirtyEnd      = MAX (LastOffset, mIncrementalReclaim.DirtyEnd);
+  mIncrementalReclaim.PassEndOffset = PackedOffset;
+  if (mIncrementalReclaim.DirtyOffset >= mIncrementalReclaim.DirtyEnd) {
+    mIncrementalReclaim.DirtyOffset = 0;
+    mIncrementalReclaim.DirtyEnd    = 0;
+  }
+
+  mVariableModuleGlobal->NonVolatileLastVariableOffset = PackedOffset;
+  IncrementalReclaimUpdateTotalSize ();
+
+  DEBUG ((DEBUG_INFO, "Variable: incremental reclaim released 0x%x bytes\n", LastOffset - PackedOffset));
+  return EFI_SUCCESS;
+}
+
+/**
+  Do one step of the incremental reclaim of the non-volatile variable store.
+
+  A step erases one block of the free space left behind by the previous pass,
+  or compacts the live variables of one erase block, or starts a new pass when
+  the free space falls below twice the spare space. Each step is a single FTW
+  write, so its cost is bounded by one block erase/write.
+
+  @retval EFI_SUCCESS           The step completed or there was nothing to do.
+  @retval Others                The FTW write failed, the pass is abandoned.
+
+**/
+EFI_STATUS
+IncrementalReclaimStep (
+  VOID
+  )
+{
+  UINTN  SpareSize;
+  UINTN  VariableSpace;
+
+  if (!IncrementalReclaimEnabled ()) {
+    return EFI_SUCCESS;
+  }
+
+  if (mIncrementalReclaim.DirtyOffset < mIncrementalReclaim.DirtyEnd) {
+    return IncrementalReclaimErase ();
+  }
+
+  if (!mIncrementalReclaim.Active) {
+    if (mVariableModuleGlobal->NonVolatileLastVariableOffset <= mIncrementalReclaim.PassEndOffset) {
+      //
+      // Nothing has been written since the last pass, there is nothing to reclaim.
+      //
+      return EFI_SUCCESS;
+    }
+
+    SpareSize     = PcdGet32 (PcdVariableIncrementalReclaimSpareBlocks) * mIncrementalReclaim.BlockSize;
+    VariableSpace = AtRuntime () ? mVariableModuleGlobal->CommonRuntimeVariableSpace : mVariableModuleGlobal->CommonVariableSpace;
+    if ((mVariableModuleGlobal->CommonVariableTotalSize + 2 * SpareSize <= VariableSpace) &&
+        (mVariableModuleGlobal->NonVolatileLastVariableOffset + 2 * SpareSize <= mNvVariableCache->Size))
+    {
+      return EFI_SUCCESS;
+    }
+
+    mIncrementalReclaim.Active       = TRUE;
+    mIncrementalReclaim.PackedOffset = (UINTN)GetStartPointer (mNvVariableCache) - (UINTN)mNvVariableCache;
+    mIncrementalReclaim.ScanOffset   = mIncrementalReclaim.PackedOffset;
+  }
+
+  return IncrementalReclaimCompact ();
+}
+
+/**
+  Make sure the free space a new variable is appended to has been erased.
+
+  The free space released by an incremental reclaim pass is erased lazily, one
+  block per step. This erases the blocks the append is about to use, if any.
+
+  @param[in] VariableSize       Size of the variable to append.
+
+  @retval EFI_SUCCESS           The space is ready for the append.
+  @retval Others                The space could not be erased.
+
+**/
+EFI_STATUS
+IncrementalReclaimPrepareAppend (
+  IN UINTN  VariableSize
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       End;
+
+  if (!IncrementalReclaimEnabled ()) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // The header after the new variable must read as free space too.
+  //
+  End = mVariableModuleGlobal->NonVolatileLastVariableOffset + VariableSize +
+        GetVariableHeaderSize (mVariableModuleGlobal->VariableGlobal.AuthFormat);
+  while ((mIncrementalReclaim.DirtyOffset < mIncrementalReclaim.DirtyEnd) &&
+         (mIncrementalReclaim.DirtyOffset < End))
+  {
+    Status = IncrementalReclaimErase ();
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Take over the free space an incremental reclaim pass left unerased before the
+  last reset.
+
+  The free space released by a pass is erased lazily, so after a reset the part
+  of it not erased yet still follows the end of the variables. The rest of the
+  erase block holding the end of the variables is always erased. The blocks
+  after it are queued to be erased by the next steps, instead of a full reclaim
+  of the store.
+
+  @retval TRUE          The free space that is not erased is queued.
+  @retval FALSE         The free space cannot be handled by the incremental reclaim.
+
+**/
+BOOLEAN
+IncrementalReclaimRecover (
+  VOID
+  )
+{
+  UINT8  *Store;
+  UINTN  Offset;
+  UINTN  BlockEnd;
+  UINTN  DirtyEnd;
+
+  if (!IncrementalReclaimEnabled ()) {
+    return FALSE;
+  }
+
+  Store    = (UINT8 *)mNvVariableCache;
+  BlockEnd = IncrementalReclaimBlockEnd (mVariableModuleGlobal->NonVolatileLastVariableOffset);
+  for (Offset = mVariableModuleGlobal->NonVolatileLastVariableOffset; Offset < BlockEnd; Offset++) {
+    if (Store[Offset] != 0xff) {
+      return FALSE;
+    }
+  }
+
+  for (DirtyEnd = mNvVariableCache->Size; DirtyEnd > BlockEnd; DirtyEnd--) {
+    if (Store[DirtyEnd - 1] != 0xff) {
+      break;
+    }
+  }
+
+  mIncrementalReclaim.Active        = FALSE;
+  mIncrementalReclaim.PassEndOffset = mVariableModuleGlobal->NonVolatileLastVariableOffset;
+  if (DirtyEnd > BlockEnd) {
+    mIncrementalReclaim.DirtyOffset = BlockEnd;
+    mIncrementalReclaim.DirtyEnd    = IncrementalReclaimBlockEnd (DirtyEnd - 1);
+    DEBUG ((DEBUG_INFO, "Variable: incremental reclaim erases 0x%x-0x%x\n", BlockEnd, mIncrementalReclaim.DirtyEnd));
+  }
+
+  return TRUE;
+}
+
+/**
+  Forget the incremental reclaim state after a full reclaim of the store.
+
+**/
+VOID
+IncrementalReclaimReset (
+  VOID
+  )
+{
+  mIncrementalReclaim.Active        = FALSE;
+  mIncrementalReclaim.DirtyOffset   = 0;
+  mIncrementalReclaim.DirtyEnd      = 0;
+  mIncrementalReclaim.PassEndOffset = mVariableModuleGlobal->NonVolatileLastVariableOffset;
+}
+
+// MU_CHANGE [END]
@@ -7,12 +7,19 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 **/
 
+#include <time.h>
+
 #include "VariableRuntimeDxeUnitTest.h"
 #include <Library/UnitTestLib.h>
 #include <Library/DebugLib.h>
+#include <Library/PrintLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 
 #include "../Variable.h"
+#include "../VariableParsing.h"
+#include "../VariableIndex.h"
+#include "../VariableNonVolatile.h"
+#include "../VariableRuntimeCache.h"
 #include "BlackBoxTest/VariableServicesBBTestMain.h"
 
 #define UNIT_TEST_NAME     "RuntimeVariableDxe Host-Based Unit Test"
@@ -21,6 +28,78 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 BOOLEAN  mTestAtRuntime = FALSE;
 EFI_TPL  mTestTpl       = TPL_APPLICATION;
 
+//
+// Every lookup benchmark does the same number of lookups, whatever the number
+// of variables in the store.
+//
+#define LOOKUP_BENCHMARK_LOOKUPS    50000
+#define LOOKUP_BENCHMARK_NAME_SIZE  32
+
+//
+// The lookup benchmarks run on a volatile store of their own, large enough for
+// 5000 variables, so the other suites keep the store size of the platform.
+//
+#define LOOKUP_BENCHMARK_STORE_SIZE  0x100000
+
+EFI_GUID  mLookupBenchmarkGuid = {
+  0x6c3a1b4e, 0x2d79, 0x4f6a, { 0x9e, 0x51, 0x0b, 0x7d, 0x43, 0xa2, 0x18, 0xc5 }
+};
+
+VARIABLE_STORE_HEADER  *mLookupBenchmarkStore;
+EFI_PHYSICAL_ADDRESS   mSavedVolatileVariableBase;
+UINTN                  mSavedVolatileLastVariableOffset;
+
+//
+// The incremental reclaim tests run on a flash device of their own, a firmware
+// volume holding the non-volatile variable store. The FTW and FVB mocks only
+// serve this device, and only while the tests run.
+//
+#define INCREMENTAL_RECLAIM_BLOCK_SIZE      0x1000
+#define INCREMENTAL_RECLAIM_BLOCKS          16
+#define INCREMENTAL_RECLAIM_FV_SIZE         (INCREMENTAL_RECLAIM_BLOCK_SIZE * INCREMENTAL_RECLAIM_BLOCKS)
+#define INCREMENTAL_RECLAIM_FV_HEADER_SIZE  (sizeof (EFI_FIRMWARE_VOLUME_HEADER) + sizeof (EFI_FV_BLOCK_MAP_ENTRY))
+#define INCREMENTAL_RECLAIM_MAX_VARIABLES   128
+#define INCREMENTAL_RECLAIM_MAX_STEPS       256
+
+//
+// What is left in the target blocks of the FTW write interrupted by a power loss.
+//
+typedef enum {
+  FtwTargetUntouched,
+  FtwTargetErased,
+  FtwTargetHalfWritten,
+  FtwTargetStateMax
+} FTW_TARGET_STATE;
+
+EFI_GUID  mIncrementalReclaimGuid = {
+  0x3e8d5f21, 0x94b6, 0x4c0e, { 0xa7, 0x2f, 0x5d, 0x18, 0xc3, 0x6b, 0x90, 0x4a }
+};
+
+UINT8                                 *mFlash;
+UINT8                                 *mFlashCopy;
+UINT8                                 *mFtwSpare;
+BOOLEAN                               mMockFlashEnabled;
+UINTN                                 mFtwWriteCount;
+UINTN                                 mFtwInterruptAt;
+FTW_TARGET_STATE                      mFtwTargetState;
+BOOLEAN                               mFtwPowerLost;
+FAULT_TOLERANT_WRITE_LAST_WRITE_DATA  mFtwLastWrite;
+UINTN                                 mIncrementalReclaimVariableCount;
+BOOLEAN                               mIncrementalReclaimLive[INCREMENTAL_RECLAIM_MAX_VARIABLES];
+UINTN                                 mIncrementalReclaimDataSize[INCREMENTAL_RECLAIM_MAX_VARIABLES];
+UINTN                                 mIncrementalReclaimPackedEnd;
+VARIABLE_MODULE_GLOBAL                mSavedModuleGlobal;
+VARIABLE_STORE_HEADER                 *mSavedNvVariableCache;
+EFI_FIRMWARE_VOLUME_HEADER            *mSavedNvFvHeaderCache;
+
+//
+// The runtime cache tests swap the runtime cache context of the driver for
+// one of their own, which they read lock themselves.
+//
+VARIABLE_RUNTIME_CACHE_CONTEXT  mSavedRuntimeCacheContext;
+BOOLEAN                         mTestRuntimeCacheReadLock;
+BOOLEAN                         mTestRuntimeCachePendingUpdate;
+
 //
 // Mock version of the UEFI Boot Services Table
 //
@@ -245,6 +324,127 @@ ReleaseLockOnlyAtBootTime (
   }
 }
 
+/**
+  Mock FVB GetAttributes () of the flash device of the incremental reclaim tests.
+**/
+EFI_STATUS
+EFIAPI
+MockFvbGetAttributes (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  OUT EFI_FVB_ATTRIBUTES_2                     *Attributes
+  )
+{
+  *Attributes = EFI_FVB2_READ_STATUS | EFI_FVB2_WRITE_STATUS;
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock FVB GetPhysicalAddress () of the flash device of the incremental reclaim tests.
+**/
+EFI_STATUS
+EFIAPI
+MockFvbGetPhysicalAddress (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  OUT EFI_PHYSICAL_ADDRESS                     *Address
+  )
+{
+  *Address = (EFI_PHYSICAL_ADDRESS)(UINTN)mFlash;
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock FVB GetBlockSize () of the flash device of the incremental reclaim tests.
+**/
+EFI_STATUS
+EFIAPI
+MockFvbGetBlockSize (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  IN EFI_LBA                                   Lba,
+  OUT UINTN                                    *BlockSize,
+  OUT UINTN                                    *NumberOfBlocks
+  )
+{
+  *BlockSize      = INCREMENTAL_RECLAIM_BLOCK_SIZE;
+  *NumberOfBlocks = INCREMENTAL_RECLAIM_BLOCKS - (UINTN)Lba;
+  return EFI_SUCCESS;
+}
+
+/**
+  Mock FTW Write () to the flash device of the incremental reclaim tests.
+
+  The write given by mFtwInterruptAt is interrupted by a power loss once the
+  spare block holds the new content of the target blocks, as the FTW PEIM then
+  reports it. The target blocks are left as given by mFtwTargetState and every
+  write after it fails.
+**/
+EFI_STATUS
+EFIAPI
+MockFtwWrite (
+  IN EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *This,
+  IN EFI_LBA                            Lba,
+  IN UINTN                              Offset,
+  IN UINTN                              Length,
+  IN VOID                               *PrivateData,
+  IN EFI_HANDLE                         FvBlockHandle,
+  IN VOID                               *Buffer
+  )
+{
+  UINT8  *Target;
+  UINTN  SpareLength;
+
+  if (mFtwPowerLost) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  if ((UINTN)Lba * INCREMENTAL_RECLAIM_BLOCK_SIZE + Offset + Length > INCREMENTAL_RECLAIM_FV_SIZE) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  Target = mFlash + (UINTN)Lba * INCREMENTAL_RECLAIM_BLOCK_SIZE;
+  if (mFtwWriteCount++ != mFtwInterruptAt) {
+    CopyMem (Target + Offset, Buffer, Length);
+    return EFI_SUCCESS;
+  }
+
+  SpareLength = ALIGN_VALUE (Offset + Length, INCREMENTAL_RECLAIM_BLOCK_SIZE);
+  CopyMem (mFtwSpare, Target, SpareLength);
+  CopyMem (mFtwSpare + Offset, Buffer, Length);
+  SetMem (mFtwSpare + SpareLength, INCREMENTAL_RECLAIM_FV_SIZE - SpareLength, 0xff);
+  if (mFtwTargetState != FtwTargetUntouched) {
+    SetMem (Target, SpareLength, 0xff);
+  }
+
+  if (mFtwTargetState == FtwTargetHalfWritten) {
+    CopyMem (Target, mFtwSpare, SpareLength / 2);
+  }
+
+  mFtwLastWrite.TargetAddress = (EFI_PHYSICAL_ADDRESS)(UINTN)Target;
+  mFtwLastWrite.SpareAddress  = (EFI_PHYSICAL_ADDRESS)(UINTN)mFtwSpare;
+  mFtwLastWrite.Length        = Offset + Length;
+  mFtwPowerLost               = TRUE;
+  return EFI_DEVICE_ERROR;
+}
+
+EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  mMockFvb = {
+  MockFvbGetAttributes,
+  NULL,
+  MockFvbGetPhysicalAddress,
+  MockFvbGetBlockSize,
+  NULL,
+  NULL,
+  NULL,
+  NULL
+};
+
+EFI_FAULT_TOLERANT_WRITE_PROTOCOL  mMockFtw = {
+  NULL,
+  NULL,
+  MockFtwWrite,
+  NULL,
+  NULL,
+  NULL
+};
+
 /**
   Retrieve the Fault Tolerent Write protocol interface.
 
@@ -260,7 +460,11 @@ GetFtwProtocol (
   OUT VOID  **FtwProtocol
   )
 {
-  // TODO: Create a mocked version.
+  if (mMockFlashEnabled) {
+    *FtwProtocol = &mMockFtw;
+    return EFI_SUCCESS;
+  }
+
   return EFI_UNSUPPORTED;
 }
 
@@ -285,7 +489,11 @@ GetFvbByHandle (
   //
   // To get the FVB protocol interface on the handle
   //
-  // TODO: Create a mocked version.
+  if (mMockFlashEnabled && (FvBlockHandle == (EFI_HANDLE)&mMockFvb)) {
+    *FvBlock = &mMockFvb;
+    return EFI_SUCCESS;
+  }
+
   return EFI_UNSUPPORTED;
 }
 
@@ -313,8 +521,18 @@ GetFvbCountAndBuffer (
   //
   // Locate all handles of Fvb protocol
   //
-  // TODO: Create a mocked version.
-  return EFI_UNSUPPORTED;
+  if (!mMockFlashEnabled) {
+    return EFI_UNSUPPORTED;
+  }
+
+  *Buffer = AllocatePool (sizeof (EFI_HANDLE));
+  if (*Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  (*Buffer)[0]   = (EFI_HANDLE)&mMockFvb;
+  *NumberHandles = 1;
+  return EFI_SUCCESS;
 }
 
 UNIT_TEST_STATUS
@@ -365,6 +583,805 @@ Cleanup:
   return TestResult;
 }
 
+/**
+  Swaps the volatile store of the variable driver for an empty store of
+  LOOKUP_BENCHMARK_STORE_SIZE bytes.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED                      The benchmark store is in place.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  The store could not be allocated.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+LookupBenchmarkPrerequisite (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  AllocationSize;
+
+  //
+  // Keep the scratch buffer behind the store, as VariableCommonInitialize () does.
+  //
+  AllocationSize        = LOOKUP_BENCHMARK_STORE_SIZE + mVariableModuleGlobal->ScratchBufferSize;
+  mLookupBenchmarkStore = AllocatePool (AllocationSize);
+  if (mLookupBenchmarkStore == NULL) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  SetMem (mLookupBenchmarkStore, AllocationSize, 0xff);
+  CopyGuid (
+    &mLookupBenchmarkStore->Signature,
+    &((VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase)->Signature
+    );
+  mLookupBenchmarkStore->Size      = LOOKUP_BENCHMARK_STORE_SIZE;
+  mLookupBenchmarkStore->Format    = VARIABLE_STORE_FORMATTED;
+  mLookupBenchmarkStore->State     = VARIABLE_STORE_HEALTHY;
+  mLookupBenchmarkStore->Reserved  = 0;
+  mLookupBenchmarkStore->Reserved1 = 0;
+
+  mSavedVolatileVariableBase       = mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+  mSavedVolatileLastVariableOffset = mVariableModuleGlobal->VolatileLastVariableOffset;
+
+  mVariableModuleGlobal->VariableGlobal.VolatileVariableBase = (EFI_PHYSICAL_ADDRESS)(UINTN)mLookupBenchmarkStore;
+  mVariableModuleGlobal->VolatileLastVariableOffset          = (UINTN)GetStartPointer (mLookupBenchmarkStore) - (UINTN)mLookupBenchmarkStore;
+  VariableIndexInvalidate (VariableStoreTypeVolatile);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Puts the volatile store of the variable driver back in place and frees the
+  benchmark store.
+
+  @param[in]  Context  Unused.
+**/
+VOID
+EFIAPI
+LookupBenchmarkCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  mVariableModuleGlobal->VariableGlobal.VolatileVariableBase = mSavedVolatileVariableBase;
+  mVariableModuleGlobal->VolatileLastVariableOffset          = mSavedVolatileLastVariableOffset;
+  VariableIndexInvalidate (VariableStoreTypeVolatile);
+
+  FreePool (mLookupBenchmarkStore);
+  mLookupBenchmarkStore = NULL;
+}
+
+/**
+  Returns the number of lookups done per second.
+
+  @param[in]  Lookups  The number of lookups.
+  @param[in]  Ticks    The clock ticks the lookups took.
+
+  @return Lookups per second.
+**/
+STATIC
+UINT64
+LookupsPerSecond (
+  IN UINTN    Lookups,
+  IN clock_t  Ticks
+  )
+{
+  if (Ticks <= 0) {
+    Ticks = 1;
+  }
+
+  return DivU64x64Remainder (MultU64x32 (Lookups, CLOCKS_PER_SEC), (UINT64)Ticks, NULL);
+}
+
+/**
+  Fills the volatile store with the number of variables given as context and
+  measures the GetVariable () throughput, compared with a linear walk of the
+  store by FindVariableEx ().
+
+  Every indexed lookup must also find the same variable header as the walk.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+VariableLookupBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS        TestResult = UNIT_TEST_PASSED;
+  UINTN                   VariableCount;
+  UINTN                   Rounds;
+  UINTN                   Round;
+  UINTN                   Index;
+  UINTN                   Created;
+  CHAR16                  *Names;
+  UINT32                  Data;
+  UINTN                   DataSize;
+  UINT32                  Attributes;
+  VARIABLE_STORE_HEADER   *VolatileStore;
+  VARIABLE_POINTER_TRACK  Indexed;
+  VARIABLE_POINTER_TRACK  Linear;
+  clock_t                 Start;
+  clock_t                 IndexedTicks;
+  clock_t                 LinearTicks;
+
+  VariableCount = (UINTN)Context;
+  Rounds        = MAX (1, LOOKUP_BENCHMARK_LOOKUPS / VariableCount);
+  Created       = 0;
+
+  Names = AllocatePool (VariableCount * LOOKUP_BENCHMARK_NAME_SIZE * sizeof (CHAR16));
+  UT_ASSERT_NOT_NULL (Names);
+
+  for (Index = 0; Index < VariableCount; Index++) {
+    UnicodeSPrint (&Names[Index * LOOKUP_BENCHMARK_NAME_SIZE], LOOKUP_BENCHMARK_NAME_SIZE * sizeof (CHAR16), L"Bench%04d", (UINT32)Index);
+    Data = (UINT32)Index;
+    UT_CLEANUP_ASSERT_NOT_EFI_ERROR (
+      VariableServiceSetVariable (
+        &Names[Index * LOOKUP_BENCHMARK_NAME_SIZE],
+        &mLookupBenchmarkGuid,
+        EFI_VARIABLE_BOOTSERVICE_ACCESS,
+        sizeof (Data),
+        &Data
+        )
+      );
+    Created++;
+  }
+
+  //
+  // Indexed lookups through GetVariable ().
+  //
+  Start = clock ();
+  for (Round = 0; Round < Rounds; Round++) {
+    for (Index = 0; Index < VariableCount; Index++) {
+      DataSize = sizeof (Data);
+      UT_CLEANUP_ASSERT_NOT_EFI_ERROR (
+        VariableServiceGetVariable (
+          &Names[Index * LOOKUP_BENCHMARK_NAME_SIZE],
+          &mLookupBenchmarkGuid,
+          &Attributes,
+          &DataSize,
+          &Data
+          )
+        );
+      UT_CLEANUP_ASSERT_EQUAL (Data, Index);
+    }
+  }
+
+  IndexedTicks = clock () - Start;
+
+  //
+  // The same lookups with a linear walk of the volatile store.
+  //
+  VolatileStore   = (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+  Linear.StartPtr = GetStartPointer (VolatileStore);
+  Linear.EndPtr   = GetEndPointer (VolatileStore);
+  Linear.Volatile = TRUE;
+  Start           = clock ();
+  for (Round = 0; Round < Rounds; Round++) {
+    for (Index = 0; Index < VariableCount; Index++) {
+      UT_CLEANUP_ASSERT_NOT_EFI_ERROR (
+        FindVariableEx (
+          &Names[Index * LOOKUP_BENCHMARK_NAME_SIZE],
+          &mLookupBenchmarkGuid,
+          FALSE,
+          &Linear,
+          mVariableModuleGlobal->VariableGlobal.AuthFormat
+          )
+        );
+    }
+  }
+
+  LinearTicks = clock () - Start;
+
+  for (Index = 0; Index < VariableCount; Index++) {
+    UT_CLEANUP_ASSERT_NOT_EFI_ERROR (
+      FindVariableEx (
+        &Names[Index * LOOKUP_BENCHMARK_NAME_SIZE],
+        &mLookupBenchmarkGuid,
+        FALSE,
+        &Linear,
+        mVariableModuleGlobal->VariableGlobal.AuthFormat
+        )
+      );
+    UT_CLEANUP_ASSERT_NOT_EFI_ERROR (
+      FindVariable (
+        &Names[Index * LOOKUP_BENCHMARK_NAME_SIZE],
+        &mLookupBenchmarkGuid,
+        &Indexed,
+        &mVariableModuleGlobal->VariableGlobal,
+        FALSE
+        )
+      );
+    UT_CLEANUP_ASSERT_EQUAL ((UINTN)Indexed.CurrPtr, (UINTN)Linear.CurrPtr);
+    UT_CLEANUP_ASSERT_EQUAL ((UINTN)Indexed.InDeletedTransitionPtr, (UINTN)Linear.InDeletedTransitionPtr);
+  }
+
+  UT_LOG_INFO (
+    "%d variables: indexed GetVariable %ld lookups/s, linear walk %ld lookups/s\n",
+    (UINT32)VariableCount,
+    LookupsPerSecond (Rounds * VariableCount, IndexedTicks),
+    LookupsPerSecond (Rounds * VariableCount, LinearTicks)
+    );
+
+Cleanup:
+  //
+  // Delete the variables, which must then no longer be found.
+  //
+  for (Index = 0; Index < Created; Index++) {
+    VariableServiceSetVariable (&Names[Index * LOOKUP_BENCHMARK_NAME_SIZE], &mLookupBenchmarkGuid, 0, 0, NULL);
+    DataSize = sizeof (Data);
+    if (VariableServiceGetVariable (&Names[Index * LOOKUP_BENCHMARK_NAME_SIZE], &mLookupBenchmarkGuid, NULL, &DataSize, &Data) != EFI_NOT_FOUND) {
+      TestResult = UNIT_TEST_ERROR_TEST_FAILED;
+    }
+  }
+
+  FreePool (Names);
+  return TestResult;
+}
+
+/**
+  Formats the flash device of the incremental reclaim tests with a variable
+  store of live variables interleaved with deleted ones, from a few bytes to
+  more than an erase block in size, which fill the store but its last blocks.
+**/
+STATIC
+VOID
+IncrementalReclaimFormatFlash (
+  VOID
+  )
+{
+  EFI_FIRMWARE_VOLUME_HEADER  *FvHeader;
+  VARIABLE_STORE_HEADER       *Store;
+  VARIABLE_HEADER             *Variable;
+  BOOLEAN                     AuthFormat;
+  CHAR16                      Name[16];
+  UINTN                       NameSize;
+  UINTN                       DataSize;
+  UINTN                       VariableSize;
+  UINTN                       Offset;
+  UINTN                       Index;
+
+  AuthFormat = mVariableModuleGlobal->VariableGlobal.AuthFormat;
+  SetMem (mFlash, INCREMENTAL_RECLAIM_FV_SIZE, 0xff);
+
+  FvHeader = (EFI_FIRMWARE_VOLUME_HEADER *)mFlash;
+  ZeroMem (FvHeader, INCREMENTAL_RECLAIM_FV_HEADER_SIZE);
+  CopyGuid (&FvHeader->FileSystemGuid, &gEfiSystemNvDataFvGuid);
+  FvHeader->FvLength              = INCREMENTAL_RECLAIM_FV_SIZE;
+  FvHeader->Signature             = EFI_FVH_SIGNATURE;
+  FvHeader->Attributes            = EFI_FVB2_READ_STATUS | EFI_FVB2_WRITE_STATUS;
+  FvHeader->HeaderLength          = (UINT16)INCREMENTAL_RECLAIM_FV_HEADER_SIZE;
+  FvHeader->Revision              = EFI_FVH_REVISION;
+  FvHeader->BlockMap[0].NumBlocks = INCREMENTAL_RECLAIM_BLOCKS;
+  FvHeader->BlockMap[0].Length    = INCREMENTAL_RECLAIM_BLOCK_SIZE;
+  FvHeader->Checksum              = CalculateCheckSum16 ((UINT16 *)FvHeader, FvHeader->HeaderLength);
+
+  Store = (VARIABLE_STORE_HEADER *)(mFlash + INCREMENTAL_RECLAIM_FV_HEADER_SIZE);
+  ZeroMem (Store, sizeof (VARIABLE_STORE_HEADER));
+  CopyGuid (&Store->Signature, AuthFormat ? &gEfiAuthenticatedVariableGuid : &gEfiVariableGuid);
+  Store->Size   = INCREMENTAL_RECLAIM_FV_SIZE - INCREMENTAL_RECLAIM_FV_HEADER_SIZE;
+  Store->Format = VARIABLE_STORE_FORMATTED;
+  Store->State  = VARIABLE_STORE_HEALTHY;
+
+  Offset                       = (UINTN)GetStartPointer (Store) - (UINTN)Store;
+  mIncrementalReclaimPackedEnd = Offset;
+  for (Index = 0; Index < INCREMENTAL_RECLAIM_MAX_VARIABLES; Index++) {
+    UnicodeSPrint (Name, sizeof (Name), L"Reclaim%03d", (UINT32)Index);
+    NameSize = StrSize (Name);
+    DataSize = ((Index % 11) == 5) ? INCREMENTAL_RECLAIM_BLOCK_SIZE + 0x200 : 0x10 + (Index * 0x97) % 0x600;
+    if (Offset + GetVariableHeaderSize (AuthFormat) + NameSize + DataSize + 2 * ALIGNMENT > Store->Size - 2 * INCREMENTAL_RECLAIM_BLOCK_SIZE) {
+      break;
+    }
+
+    mIncrementalReclaimLive[Index]     = (Index % 3) != 1;
+    mIncrementalReclaimDataSize[Index] = DataSize;
+
+    Variable = (VARIABLE_HEADER *)((UINT8 *)Store + Offset);
+    ZeroMem (Variable, GetVariableHeaderSize (AuthFormat));
+    Variable->StartId    = VARIABLE_DATA;
+    Variable->State      = mIncrementalReclaimLive[Index] ? VAR_ADDED : (VAR_ADDED & VAR_DELETED);
+    Variable->Attributes = EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS;
+    SetNameSizeOfVariable (Variable, NameSize, AuthFormat);
+    SetDataSizeOfVariable (Variable, DataSize, AuthFormat);
+    CopyGuid (GetVendorGuidPtr (Variable, AuthFormat), &mIncrementalReclaimGuid);
+    CopyMem (GetVariableNamePtr (Variable, AuthFormat), Name, NameSize);
+    SetMem (GetVariableDataPtr (Variable, AuthFormat), DataSize, (UINT8)Index);
+
+    VariableSize = (UINTN)GetNextVariablePtr (Variable, AuthFormat) - (UINTN)Variable;
+    if (mIncrementalReclaimLive[Index]) {
+      mIncrementalReclaimPackedEnd += VariableSize;
+    }
+
+    Offset += VariableSize;
+  }
+
+  mIncrementalReclaimVariableCount = Index;
+}
+
+/**
+  Loads the variable store of the flash device into the cache of the driver
+  and finds the end of the variables, as the driver does at boot.
+**/
+STATIC
+VOID
+IncrementalReclaimLoadStore (
+  VOID
+  )
+{
+  VARIABLE_HEADER  *Variable;
+
+  CopyMem (
+    mNvVariableCache,
+    (VOID *)(UINTN)mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase,
+    INCREMENTAL_RECLAIM_FV_SIZE - INCREMENTAL_RECLAIM_FV_HEADER_SIZE
+    );
+  Variable = GetStartPointer (mNvVariableCache);
+  while (IsValidVariableHeader (Variable, GetEndPointer (mNvVariableCache))) {
+    Variable = GetNextVariablePtr (Variable, mVariableModuleGlobal->VariableGlobal.AuthFormat);
+  }
+
+  mVariableModuleGlobal->NonVolatileLastVariableOffset = (UINTN)Variable - (UINTN)mNvVariableCache;
+  VariableIndexInvalidate (VariableStoreTypeNv);
+}
+
+/**
+  Makes all the variables of the store count as written since the last pass,
+  so the next incremental reclaim step starts a new pass.
+**/
+STATIC
+VOID
+IncrementalReclaimRestartPass (
+  VOID
+  )
+{
+  UINTN  LastOffset;
+
+  LastOffset                                           = mVariableModuleGlobal->NonVolatileLastVariableOffset;
+  mVariableModuleGlobal->NonVolatileLastVariableOffset = 0;
+  IncrementalReclaimReset ();
+  mVariableModuleGlobal->NonVolatileLastVariableOffset = LastOffset;
+}
+
+/**
+  Runs incremental reclaim steps until the pass and the erase of the free space
+  it released complete, or until the power is lost.
+**/
+STATIC
+VOID
+IncrementalReclaimRunSteps (
+  VOID
+  )
+{
+  UINTN  Step;
+
+  for (Step = 0; (Step < INCREMENTAL_RECLAIM_MAX_STEPS) && !mFtwPowerLost; Step++) {
+    IncrementalReclaimStep ();
+  }
+}
+
+/**
+  Checks a variable store holds exactly one copy of every live variable, with
+  its data.
+
+  @param[in]  Store     The variable store.
+  @param[in]  Settled   TRUE if the store must also be compacted, with the space
+                        after the variables erased.
+
+  @retval UNIT_TEST_PASSED              The store is as expected.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   The store is not.
+**/
+STATIC
+UNIT_TEST_STATUS
+IncrementalReclaimCheckStore (
+  IN VARIABLE_STORE_HEADER  *Store,
+  IN BOOLEAN                Settled
+  )
+{
+  BOOLEAN          Found[INCREMENTAL_RECLAIM_MAX_VARIABLES];
+  BOOLEAN          AuthFormat;
+  VARIABLE_HEADER  *Variable;
+  UINT8            *Data;
+  UINTN            DataSize;
+  UINTN            Index;
+  UINTN            Offset;
+
+  AuthFormat = mVariableModuleGlobal->VariableGlobal.AuthFormat;
+  ZeroMem (Found, sizeof (Found));
+
+  Variable = GetStartPointer (Store);
+  while (IsValidVariableHeader (Variable, GetEndPointer (Store))) {
+    if (Variable->State == VAR_ADDED) {
+      UT_ASSERT_TRUE (CompareGuid (GetVendorGuidPtr (Variable, AuthFormat), &mIncrementalReclaimGuid));
+      Index = StrDecimalToUintn (GetVariableNamePtr (Variable, AuthFormat) + StrLen (L"Reclaim"));
+      UT_ASSERT_TRUE (Index < mIncrementalReclaimVariableCount);
+      UT_ASSERT_TRUE (mIncrementalReclaimLive[Index]);
+      UT_ASSERT_FALSE (Found[Index]);
+      Found[Index] = TRUE;
+
+      Data     = GetVariableDataPtr (Variable, AuthFormat);
+      DataSize = DataSizeOfVariable (Variable, AuthFormat);
+      UT_ASSERT_EQUAL (DataSize, mIncrementalReclaimDataSize[Index]);
+      for (Offset = 0; (Offset < DataSize) && (Data[Offset] == (UINT8)Index); Offset++) {
+      }
+
+      UT_ASSERT_EQUAL (Offset, DataSize);
+    }
+
+    Variable = GetNextVariablePtr (Variable, AuthFormat);
+  }
+
+  for (Index = 0; Index < mIncrementalReclaimVariableCount; Index++) {
+    UT_ASSERT_EQUAL (Found[Index], mIncrementalReclaimLive[Index]);
+  }
+
+  if (Settled) {
+    UT_ASSERT_EQUAL ((UINTN)Variable - (UINTN)Store, mIncrementalReclaimPackedEnd);
+    for (Offset = mIncrementalReclaimPackedEnd; (Offset < Store->Size) && (((UINT8 *)Store)[Offset] == 0xff); Offset++) {
+    }
+
+    UT_ASSERT_EQUAL (Offset, Store->Size);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Reboots after the power loss. The store read from flash, merged with the
+  spare block as the driver does at boot, must hold all the live variables.
+  The FTW driver then completes the interrupted write and the variable driver
+  takes over the free space left unerased.
+
+  @retval UNIT_TEST_PASSED              The store has been recovered.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   Variables have been lost or duplicated.
+**/
+STATIC
+UNIT_TEST_STATUS
+IncrementalReclaimReboot (
+  VOID
+  )
+{
+  CopyMem (mFlashCopy, mFlash, INCREMENTAL_RECLAIM_FV_SIZE);
+  MergeFtwLastWriteData ((EFI_PHYSICAL_ADDRESS)(UINTN)mFlash, INCREMENTAL_RECLAIM_FV_SIZE, mFlashCopy, &mFtwLastWrite);
+  UT_ASSERT_EQUAL (IncrementalReclaimCheckStore ((VARIABLE_STORE_HEADER *)(mFlashCopy + INCREMENTAL_RECLAIM_FV_HEADER_SIZE), FALSE), UNIT_TEST_PASSED);
+
+  CopyMem (
+    (VOID *)(UINTN)mFtwLastWrite.TargetAddress,
+    mFtwSpare,
+    ALIGN_VALUE ((UINTN)mFtwLastWrite.Length, INCREMENTAL_RECLAIM_BLOCK_SIZE)
+    );
+  UT_ASSERT_MEM_EQUAL (mFlash, mFlashCopy, INCREMENTAL_RECLAIM_FV_SIZE);
+  mFtwPowerLost   = FALSE;
+  mFtwInterruptAt = MAX_UINTN;
+
+  IncrementalReclaimLoadStore ();
+  IncrementalReclaimReset ();
+  UT_ASSERT_TRUE (IncrementalReclaimRecover ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Interrupts every FTW write of an incremental reclaim pass by a power loss,
+  with the target blocks left untouched, erased or half written.
+
+  After the reboot the store must hold exactly the live variables. The steps
+  that follow must erase the free space left over, and a new pass must then
+  compact the store, keeping the flash and the cache of the driver in line.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+IncrementalReclaimPowerLossTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_STORE_HEADER  *FlashStore;
+  UINTN                  WriteCount;
+  UINTN                  InterruptAt;
+  UINTN                  TargetState;
+
+  FlashStore = (VARIABLE_STORE_HEADER *)(mFlash + INCREMENTAL_RECLAIM_FV_HEADER_SIZE);
+
+  //
+  // Without a power loss, one pass compacts the store in several writes.
+  //
+  IncrementalReclaimFormatFlash ();
+  IncrementalReclaimLoadStore ();
+  IncrementalReclaimRestartPass ();
+  mFtwWriteCount  = 0;
+  mFtwInterruptAt = MAX_UINTN;
+  IncrementalReclaimRunSteps ();
+  WriteCount = mFtwWriteCount;
+  UT_ASSERT_TRUE (WriteCount > 2);
+  UT_ASSERT_EQUAL (mVariableModuleGlobal->NonVolatileLastVariableOffset, mIncrementalReclaimPackedEnd);
+  UT_ASSERT_EQUAL (IncrementalReclaimCheckStore (FlashStore, TRUE), UNIT_TEST_PASSED);
+  UT_ASSERT_MEM_EQUAL (mNvVariableCache, FlashStore, FlashStore->Size);
+
+  for (InterruptAt = 0; InterruptAt < WriteCount; InterruptAt++) {
+    for (TargetState = 0; TargetState < FtwTargetStateMax; TargetState++) {
+      IncrementalReclaimFormatFlash ();
+      IncrementalReclaimLoadStore ();
+      IncrementalReclaimRestartPass ();
+      mFtwWriteCount  = 0;
+      mFtwInterruptAt = InterruptAt;
+      mFtwTargetState = (FTW_TARGET_STATE)TargetState;
+      IncrementalReclaimRunSteps ();
+      UT_ASSERT_TRUE (mFtwPowerLost);
+      UT_ASSERT_EQUAL (IncrementalReclaimReboot (), UNIT_TEST_PASSED);
+
+      IncrementalReclaimRunSteps ();
+      IncrementalReclaimRestartPass ();
+      IncrementalReclaimRunSteps ();
+      UT_ASSERT_EQUAL (IncrementalReclaimCheckStore (FlashStore, TRUE), UNIT_TEST_PASSED);
+      UT_ASSERT_MEM_EQUAL (mNvVariableCache, FlashStore, FlashStore->Size);
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Swaps the non-volatile store of the variable driver for the store on the
+  flash device of the incremental reclaim tests, and enables the FTW and FVB
+  mocks.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED                      The flash device is in place.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  The flash device could not be allocated.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+IncrementalReclaimPrerequisite (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_STORE_HEADER  *NvVariableCache;
+
+  mFlash          = AllocatePool (INCREMENTAL_RECLAIM_FV_SIZE);
+  mFlashCopy      = AllocatePool (INCREMENTAL_RECLAIM_FV_SIZE);
+  mFtwSpare       = AllocatePool (INCREMENTAL_RECLAIM_FV_SIZE);
+  NvVariableCache = AllocatePool (INCREMENTAL_RECLAIM_FV_SIZE - INCREMENTAL_RECLAIM_FV_HEADER_SIZE);
+  if ((mFlash == NULL) || (mFlashCopy == NULL) || (mFtwSpare == NULL) || (NvVariableCache == NULL)) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  CopyMem (&mSavedModuleGlobal, mVariableModuleGlobal, sizeof (VARIABLE_MODULE_GLOBAL));
+  mSavedNvVariableCache = mNvVariableCache;
+  mSavedNvFvHeaderCache = mNvFvHeaderCache;
+
+  mNvVariableCache = NvVariableCache;
+  mNvFvHeaderCache = (EFI_FIRMWARE_VOLUME_HEADER *)mFlash;
+
+  mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase                                  = (EFI_PHYSICAL_ADDRESS)(UINTN)mFlash + INCREMENTAL_RECLAIM_FV_HEADER_SIZE;
+  mVariableModuleGlobal->VariableGlobal.EmuNvMode                                                = FALSE;
+  mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeNvCache.Store = NULL;
+  //
+  // Start a pass as soon as variables have been written since the last one.
+  //
+  mVariableModuleGlobal->CommonVariableSpace = 0;
+  mMockFlashEnabled                          = TRUE;
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Puts the non-volatile store of the variable driver back in place, disables
+  the FTW and FVB mocks and frees the flash device.
+
+  @param[in]  Context  Unused.
+**/
+VOID
+EFIAPI
+IncrementalReclaimCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  if (mSavedNvVariableCache != NULL) {
+    FreePool (mNvVariableCache);
+    CopyMem (mVariableModuleGlobal, &mSavedModuleGlobal, sizeof (VARIABLE_MODULE_GLOBAL));
+    mNvVariableCache      = mSavedNvVariableCache;
+    mNvFvHeaderCache      = mSavedNvFvHeaderCache;
+    mSavedNvVariableCache = NULL;
+    VariableIndexInvalidate (VariableStoreTypeNv);
+  }
+
+  mMockFlashEnabled = FALSE;
+  if (mFlash != NULL) {
+    FreePool (mFlash);
+  }
+
+  if (mFlashCopy != NULL) {
+    FreePool (mFlashCopy);
+  }
+
+  if (mFtwSpare != NULL) {
+    FreePool (mFtwSpare);
+  }
+}
+
+/**
+  Checks the pending updates of a runtime variable cache.
+
+  @param[in]  Cache     The runtime variable cache.
+  @param[in]  Expected  The expected pending updates, in order.
+  @param[in]  Count     The number of expected pending updates.
+
+  @retval UNIT_TEST_PASSED              The pending updates are as expected.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   They are not.
+**/
+STATIC
+UNIT_TEST_STATUS
+CheckPendingUpdates (
+  IN VARIABLE_RUNTIME_CACHE               *Cache,
+  IN CONST VARIABLE_RUNTIME_CACHE_UPDATE  *Expected,
+  IN UINT32                               Count
+  )
+{
+  UT_ASSERT_EQUAL (Cache->PendingUpdateCount, Count);
+  UT_ASSERT_MEM_EQUAL (Cache->PendingUpdates, Expected, Count * sizeof (VARIABLE_RUNTIME_CACHE_UPDATE));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Adds updates to the runtime cache of the NV store while it is read locked,
+  and checks how they are merged into the pending updates: overlapping and
+  touching ranges are coalesced, disjoint ones are kept in order, the two
+  closest ones are merged when there are too many, and an update of the whole
+  store leaves a single range. Flushing then copies the whole store.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RuntimeCachePendingUpdatesTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *CacheContext;
+  VARIABLE_RUNTIME_CACHE          *Cache;
+  UINT64                          SyncedBytes;
+  UINT32                          Index;
+
+  STATIC CONST VARIABLE_RUNTIME_CACHE_UPDATE  Overlap[] = {
+    { 0x100, 0x30 }
+  };
+  STATIC CONST VARIABLE_RUNTIME_CACHE_UPDATE  Adjacent[] = {
+    { 0xf0, 0x50 }
+  };
+  STATIC CONST VARIABLE_RUNTIME_CACHE_UPDATE  Disjoint[] = {
+    { 0xf0, 0x50 },
+    { 0x200, 0x08 },
+    { 0x400, 0x08 }
+  };
+  STATIC CONST VARIABLE_RUNTIME_CACHE_UPDATE  Bridged[] = {
+    { 0xf0, 0x118 },
+    { 0x400, 0x08 }
+  };
+  STATIC CONST UINT32                         Offsets[] = {
+    0x800, 0x700, 0x600, 0x480, 0x400, 0x300, 0x200, 0x100, 0x000
+  };
+  STATIC CONST VARIABLE_RUNTIME_CACHE_UPDATE  Overflow[] = {
+    { 0x000, 0x10 },
+    { 0x100, 0x10 },
+    { 0x200, 0x10 },
+    { 0x300, 0x10 },
+    { 0x400, 0x90 },
+    { 0x600, 0x10 },
+    { 0x700, 0x10 },
+    { 0x800, 0x10 }
+  };
+
+  CacheContext = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
+  Cache        = &CacheContext->VariableRuntimeNvCache;
+
+  UT_ASSERT_NOT_EFI_ERROR (SynchronizeRuntimeVariableCache (Cache, 0x100, 0x20));
+  UT_ASSERT_NOT_EFI_ERROR (SynchronizeRuntimeVariableCache (Cache, 0x110, 0x20));
+  UT_ASSERT_EQUAL (CheckPendingUpdates (Cache, Overlap, ARRAY_SIZE (Overlap)), UNIT_TEST_PASSED);
+
+  UT_ASSERT_NOT_EFI_ERROR (SynchronizeRuntimeVariableCache (Cache, 0x130, 0x10));
+  UT_ASSERT_NOT_EFI_ERROR (SynchronizeRuntimeVariableCache (Cache, 0xf0, 0x10));
+  UT_ASSERT_EQUAL (CheckPendingUpdates (Cache, Adjacent, ARRAY_SIZE (Adjacent)), UNIT_TEST_PASSED);
+
+  UT_ASSERT_NOT_EFI_ERROR (SynchronizeRuntimeVariableCache (Cache, 0x400, 0x08));
+  UT_ASSERT_NOT_EFI_ERROR (SynchronizeRuntimeVariableCache (Cache, 0x200, 0x08));
+  UT_ASSERT_EQUAL (CheckPendingUpdates (Cache, Disjoint, ARRAY_SIZE (Disjoint)), UNIT_TEST_PASSED);
+
+  UT_ASSERT_NOT_EFI_ERROR (SynchronizeRuntimeVariableCache (Cache, 0x138, 0xc8));
+  UT_ASSERT_EQUAL (CheckPendingUpdates (Cache, Bridged, ARRAY_SIZE (Bridged)), UNIT_TEST_PASSED);
+
+  //
+  // Nothing is copied while the cache is read locked.
+  //
+  UT_ASSERT_EQUAL (CacheContext->SyncedBytes, 0);
+  UT_ASSERT_TRUE (*CacheContext->PendingUpdate);
+
+  //
+  // One more disjoint range than can be tracked merges the two closest ones.
+  //
+  Cache->PendingUpdateCount = 0;
+  for (Index = 0; Index < ARRAY_SIZE (Offsets); Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (SynchronizeRuntimeVariableCache (Cache, Offsets[Index], 0x10));
+  }
+
+  UT_ASSERT_EQUAL (CheckPendingUpdates (Cache, Overflow, ARRAY_SIZE (Overflow)), UNIT_TEST_PASSED);
+
+  //
+  // An update of the whole store, as a reclaim submits, leaves one range.
+  //
+  UT_ASSERT_NOT_EFI_ERROR (SynchronizeRuntimeVariableCache (Cache, 0, mNvVariableCache->Size));
+  UT_ASSERT_EQUAL (Cache->PendingUpdateCount, 1);
+  UT_ASSERT_EQUAL (Cache->PendingUpdates[0].Offset, 0);
+  UT_ASSERT_EQUAL (Cache->PendingUpdates[0].Length, mNvVariableCache->Size);
+
+  *CacheContext->ReadLock = FALSE;
+  SyncedBytes             = CacheContext->SyncedBytes;
+  UT_ASSERT_NOT_EFI_ERROR (FlushPendingRuntimeVariableCacheUpdates ());
+  UT_ASSERT_FALSE (*CacheContext->PendingUpdate);
+  UT_ASSERT_EQUAL (Cache->PendingUpdateCount, 0);
+  UT_ASSERT_EQUAL (CacheContext->SyncedBytes - SyncedBytes, mNvVariableCache->Size);
+  UT_ASSERT_MEM_EQUAL (Cache->Store, mNvVariableCache, mNvVariableCache->Size);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Swaps the runtime cache context of the variable driver for one with empty
+  caches of the NV and volatile stores, read locked.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED                      The runtime caches are in place.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  The runtime caches could not be allocated.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RuntimeCachePrerequisite (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *CacheContext;
+  VARIABLE_STORE_HEADER           *VolatileStore;
+
+  CacheContext  = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
+  VolatileStore = (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+  CopyMem (&mSavedRuntimeCacheContext, CacheContext, sizeof (VARIABLE_RUNTIME_CACHE_CONTEXT));
+
+  ZeroMem (CacheContext, sizeof (VARIABLE_RUNTIME_CACHE_CONTEXT));
+  CacheContext->VariableRuntimeNvCache.Store       = AllocateZeroPool (mNvVariableCache->Size);
+  CacheContext->VariableRuntimeVolatileCache.Store = AllocateZeroPool (VolatileStore->Size);
+  if ((CacheContext->VariableRuntimeNvCache.Store == NULL) || (CacheContext->VariableRuntimeVolatileCache.Store == NULL)) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  mTestRuntimeCacheReadLock      = TRUE;
+  mTestRuntimeCachePendingUpdate = FALSE;
+  CacheContext->ReadLock         = &mTestRuntimeCacheReadLock;
+  CacheContext->PendingUpdate    = &mTestRuntimeCachePendingUpdate;
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Frees the runtime caches of the test and puts the runtime cache context of
+  the variable driver back in place.
+
+  @param[in]  Context  Unused.
+**/
+VOID
+EFIAPI
+RuntimeCacheCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *CacheContext;
+
+  CacheContext = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
+  if (CacheContext->VariableRuntimeNvCache.Store != NULL) {
+    FreePool (CacheContext->VariableRuntimeNvCache.Store);
+  }
+
+  if (CacheContext->VariableRuntimeVolatileCache.Store != NULL) {
+    FreePool (CacheContext->VariableRuntimeVolatileCache.Store);
+  }
+
+  CopyMem (CacheContext, &mSavedRuntimeCacheContext, sizeof (VARIABLE_RUNTIME_CACHE_CONTEXT));
+}
+
 #define SCT_TEST_WRAPPER_FUNCTION(TestName)    \
   UNIT_TEST_STATUS                              \
   EFIAPI                                        \
@@ -457,6 +1474,9 @@ UefiTestMain (
   UNIT_TEST_SUITE_HANDLE      SctFunctionalTests;
   UNIT_TEST_SUITE_HANDLE      SctHwErrTests;
   UNIT_TEST_SUITE_HANDLE      SctStressTests;
+  UNIT_TEST_SUITE_HANDLE      PerformanceTests;
+  UNIT_TEST_SUITE_HANDLE      IncrementalReclaimTests;
+  UNIT_TEST_SUITE_HANDLE      RuntimeCacheTests;
 
   Framework = NULL;
 
@@ -539,6 +1559,43 @@ UefiTestMain (
   AddTestCase (SctStressTests, "MultipleStress Test", "MultipleStress", MultipleStressTestWrapper, NULL, NULL, NULL);
   AddTestCase (SctStressTests, "OverflowStress Test", "OverflowStress", OverflowStressTestWrapper, NULL, NULL, NULL);
 
+  //
+  // Populate the Variable Lookup Performance Test Suite
+  //
+  Status = CreateUnitTestSuite (&PerformanceTests, Framework, "Variable Lookup Performance Tests Suite", "Performance", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for PerformanceTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (PerformanceTests, "Lookup 500 Variables", "Lookup500", VariableLookupBenchmark, LookupBenchmarkPrerequisite, LookupBenchmarkCleanup, (UNIT_TEST_CONTEXT)(UINTN)500);
+  AddTestCase (PerformanceTests, "Lookup 5000 Variables", "Lookup5000", VariableLookupBenchmark, LookupBenchmarkPrerequisite, LookupBenchmarkCleanup, (UNIT_TEST_CONTEXT)(UINTN)5000);
+
+  //
+  // Populate the Incremental Reclaim Unit Test Suite
+  //
+  Status = CreateUnitTestSuite (&IncrementalReclaimTests, Framework, "Incremental Reclaim Tests Suite", "IncrementalReclaim", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for IncrementalReclaimTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (IncrementalReclaimTests, "Power Loss During Incremental Reclaim", "PowerLoss", IncrementalReclaimPowerLossTest, IncrementalReclaimPrerequisite, IncrementalReclaimCleanup, NULL);
+
+  //
+  // Populate the Runtime Cache Unit Test Suite
+  //
+  Status = CreateUnitTestSuite (&RuntimeCacheTests, Framework, "Runtime Cache Tests Suite", "RuntimeCache", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for RuntimeCacheTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (RuntimeCacheTests, "Pending Update Merge", "PendingUpdates", RuntimeCachePendingUpdatesTest, RuntimeCachePrerequisite, RuntimeCacheCleanup, NULL);
+
   InitVariableDriver ();
 
   Status = RunAllTestSuites (Framework);
@@ -29,6 +29,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "VariableNonVolatile.h"
 #include "VariableParsing.h"
 #include "VariableRuntimeCache.h"
+#include "VariableIndex.h"               // MU_CHANGE - Index variable lookups
 
 #include <Library/VariablePolicyLib.h>  // MU_CHANGE - Enable simple delete when VarPol is disabled
 
@@ -62,6 +63,14 @@ BOOLEAN  mEndOfDxe = FALSE;
 BOOLEAN  mReclaimedAtRuntime = FALSE;
 // END
 
+// MU_CHANGE [BEGIN] - Incremental variable store reclaim
+///
+/// The flag to indicate if the current SetVariable call has written to the
+/// non-volatile variable store on flash.
+///
+BOOLEAN  mNvVariableStoreWritten = FALSE;
+// MU_CHANGE [END]
+
 ///
 /// It indicates the var check request source.
 /// In the implementation, DXE is regarded as untrusted, and SMM is trusted.
@@ -230,6 +239,8 @@ UpdateVariableStore (
   //
   // If we are here we are dealing with Non-Volatile Variables.
   //
+  mNvVariableStoreWritten = TRUE;  // MU_CHANGE - Incremental variable store reclaim
+
   LinearOffset  = (UINTN)FvVolHdr;
   CurrWritePtr  = (UINTN)DataPtr;
   CurrWriteSize = DataSize;
@@ -413,8 +424,8 @@ RecordVarErrorFlag (
       *VarErrFlag = TempFlag;
       Status      =  SynchronizeRuntimeVariableCache (
                        &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeNvCache,
-                       0,
-                       mNvVariableCache->Size
+                       (UINTN)VarErrFlag - (UINTN)mNvVariableCache, // MU_CHANGE - Delta runtime cache synchronization
+                       sizeof (TempFlag)                            // MU_CHANGE - Delta runtime cache synchronization
                        );
       ASSERT_EFI_ERROR (Status);
     }
@@ -867,6 +878,13 @@ Reclaim (
   }
 
 Done:
+  // MU_CHANGE [BEGIN] - Index variable lookups
+  //
+  // The variables of the store have been moved, the index is rebuilt on the next lookup.
+  //
+  VariableIndexInvalidate (IsVolatile ? VariableStoreTypeVolatile : VariableStoreTypeNv);
+  // MU_CHANGE [END]
+
   DoneStatus = EFI_SUCCESS;
   if (IsVolatile || mVariableModuleGlobal->VariableGlobal.EmuNvMode) {
     DoneStatus = SynchronizeRuntimeVariableCache (
@@ -887,6 +905,15 @@ Done:
                    VariableStoreHeader->Size
                    );
     ASSERT_EFI_ERROR (DoneStatus);
+    // MU_CHANGE [BEGIN] - Incremental variable store reclaim
+    if (!EFI_ERROR (Status)) {
+      //
+      // The whole store has been compacted and erased after the last variable.
+      //
+      IncrementalReclaimReset ();
+    }
+
+    // MU_CHANGE [END]
   }
 
   if (!EFI_ERROR (Status) && EFI_ERROR (DoneStatus)) {
@@ -960,13 +987,16 @@ FindVariable (
     PtrTrack->EndPtr   = GetEndPointer (VariableStoreHeader[Type]);
     PtrTrack->Volatile = (BOOLEAN)(Type == VariableStoreTypeVolatile);
 
-    Status =  FindVariableEx (
+    // MU_CHANGE [BEGIN] - Index variable lookups
+    Status =  FindVariableIndexed (
                 VariableName,
                 VendorGuid,
                 IgnoreRtCheck,
+                Type,
                 PtrTrack,
                 mVariableModuleGlobal->VariableGlobal.AuthFormat
                 );
+    // MU_CHANGE [END]
     if (!EFI_ERROR (Status)) {
       return Status;
     }
@@ -1792,6 +1822,11 @@ UpdateVariable (
   BOOLEAN                             IsCommonUserVariable;
   AUTHENTICATED_VARIABLE_HEADER       *AuthVariable;
   BOOLEAN                             AuthFormat;
+  UINTN                               NewVariableOffset;  // MU_CHANGE - Delta runtime cache synchronization
+  UINTN                               NewVariableSize;    // MU_CHANGE - Delta runtime cache synchronization
+
+  NewVariableOffset = 0;  // MU_CHANGE - Delta runtime cache synchronization
+  NewVariableSize   = 0;  // MU_CHANGE - Delta runtime cache synchronization
 
   if ((mVariableModuleGlobal->FvbInstance == NULL) && !mVariableModuleGlobal->VariableGlobal.EmuNvMode) {
     //
@@ -2278,6 +2313,14 @@ UpdateVariable (
     }
 
     if (!mVariableModuleGlobal->VariableGlobal.EmuNvMode) {
+      // MU_CHANGE [BEGIN] - Incremental variable store reclaim
+      Status = IncrementalReclaimPrepareAppend (HEADER_ALIGN (VarSize));
+      if (EFI_ERROR (Status)) {
+        goto Done;
+      }
+
+      // MU_CHANGE [END]
+
       //
       // Four steps
       // 1. Write variable header
@@ -2379,6 +2422,10 @@ UpdateVariable (
       }
     }
 
+    // MU_CHANGE [BEGIN] - Delta runtime cache synchronization
+    NewVariableOffset = mVariableModuleGlobal->NonVolatileLastVariableOffset;
+    NewVariableSize   = HEADER_ALIGN (VarSize);
+    // MU_CHANGE [END]
     mVariableModuleGlobal->NonVolatileLastVariableOffset += HEADER_ALIGN (VarSize);
 
     if ((Attributes & EFI_VARIABLE_HARDWARE_ERROR_RECORD) != 0) {
@@ -2439,6 +2486,10 @@ UpdateVariable (
       goto Done;
     }
 
+    // MU_CHANGE [BEGIN] - Delta runtime cache synchronization
+    NewVariableOffset = mVariableModuleGlobal->VolatileLastVariableOffset;
+    NewVariableSize   = HEADER_ALIGN (VarSize);
+    // MU_CHANGE [END]
     mVariableModuleGlobal->VolatileLastVariableOffset += HEADER_ALIGN (VarSize);
   }
 
@@ -2507,20 +2558,31 @@ UpdateVariable (
 
 Done:
   if (!EFI_ERROR (Status)) {
+    // MU_CHANGE [BEGIN] - Delta runtime cache synchronization
     if (((Variable->CurrPtr != NULL) && !Variable->Volatile) || ((Attributes & EFI_VARIABLE_NON_VOLATILE) != 0)) {
       VolatileCacheInstance = &(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeNvCache);
+      VariableStoreHeader   = mNvVariableCache;
     } else {
       VolatileCacheInstance = &(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeVolatileCache);
+      VariableStoreHeader   = (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
     }
 
     if (VolatileCacheInstance->Store != NULL) {
-      Status =  SynchronizeRuntimeVariableCache (
-                  VolatileCacheInstance,
-                  0,
-                  VolatileCacheInstance->Store->Size
-                  );
+      //
+      // Only the state of the old variable and the new variable have changed
+      // in the store, a reclaim synchronizes the whole store by itself.
+      //
+      Status = SynchronizeRuntimeVariableCacheVariable (
+                 VolatileCacheInstance,
+                 VariableStoreHeader,
+                 CacheVariable,
+                 NewVariableOffset,
+                 NewVariableSize
+                 );
       ASSERT_EFI_ERROR (Status);
     }
+
+    // MU_CHANGE [END]
   }
 
   return Status;
@@ -3006,6 +3068,19 @@ VariableServiceSetVariable (
     mVariableModuleGlobal->NonVolatileLastVariableOffset = (UINTN)NextVariable - (UINTN)Point;
   }
 
+  // MU_CHANGE [BEGIN] - Delta runtime cache synchronization
+  if (mVariableModuleGlobal->VariableGlobal.ReentrantState == 1) {
+    mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.SetVariableSyncedBytes = 0;
+  }
+
+  // MU_CHANGE [END]
+  // MU_CHANGE [BEGIN] - Incremental variable store reclaim
+  if (mVariableModuleGlobal->VariableGlobal.ReentrantState == 1) {
+    mNvVariableStoreWritten = FALSE;
+  }
+
+  // MU_CHANGE [END]
+
   //
   // Check whether the input variable is already existed.
   //
@@ -3049,6 +3124,30 @@ VariableServiceSetVariable (
   }
 
 Done:
+  // MU_CHANGE [BEGIN] - Incremental variable store reclaim
+  //
+  // Reclaim the NV variable store a block at a time, so it does not fill up
+  // and need a full reclaim in the middle of a SetVariable call. Only a
+  // successful update written to flash can bring the store closer to full.
+  //
+  if ((mVariableModuleGlobal->VariableGlobal.ReentrantState == 1) && !EFI_ERROR (Status) && mNvVariableStoreWritten) {
+    IncrementalReclaimStep ();
+  }
+
+  // MU_CHANGE [END]
+  // MU_CHANGE [BEGIN] - Delta runtime cache synchronization
+  if (mVariableModuleGlobal->VariableGlobal.ReentrantState == 1) {
+    DEBUG ((
+      DEBUG_VERBOSE,
+      "Variable: SetVariable %g:%s synchronized %ld bytes to the runtime cache (%ld in total)\n",
+      VendorGuid,
+      VariableName,
+      mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.SetVariableSyncedBytes,
+      mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.SyncedBytes
+      ));
+  }
+
+  // MU_CHANGE [END]
   InterlockedDecrement (&mVariableModuleGlobal->VariableGlobal.ReentrantState);
   ReleaseLockOnlyAtBootTime (&mVariableModuleGlobal->VariableGlobal.VariableServicesLock);
 
@@ -3590,6 +3689,15 @@ VariableWriteServiceInitialize (
   for (Index = mVariableModuleGlobal->NonVolatileLastVariableOffset; Index < mNvVariableCache->Size; Index++) {
     Data = ((UINT8 *)mNvVariableCache)[Index];
     if (Data != 0xff) {
+      // MU_CHANGE [BEGIN] - Incremental variable store reclaim
+      //
+      // An incremental reclaim pass may have left free space to erase, in blocks.
+      //
+      if (IncrementalReclaimRecover ()) {
+        break;
+      }
+
+      // MU_CHANGE [END]
       //
       // There must be something wrong in variable store, do reclaim operation.
       //
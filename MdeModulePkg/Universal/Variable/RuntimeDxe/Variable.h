@@ -61,10 +61,25 @@ typedef enum {
   VariableStoreTypeMax
 } VARIABLE_STORE_TYPE;
 
+// MU_CHANGE [BEGIN] - Delta runtime cache synchronization
+#define VARIABLE_RUNTIME_CACHE_MAX_PENDING_UPDATES  8
+
+typedef struct {
+  UINT32    Offset;
+  UINT32    Length;
+} VARIABLE_RUNTIME_CACHE_UPDATE;
+// MU_CHANGE [END]
+
 typedef struct {
-  UINT32                   PendingUpdateOffset;
-  UINT32                   PendingUpdateLength;
-  VARIABLE_STORE_HEADER    *Store;
+  // MU_CHANGE [BEGIN] - Delta runtime cache synchronization
+  //
+  // Ranges of the store not yet copied to the runtime cache. They are sorted
+  // by offset and neither overlap nor touch each other.
+  //
+  VARIABLE_RUNTIME_CACHE_UPDATE    PendingUpdates[VARIABLE_RUNTIME_CACHE_MAX_PENDING_UPDATES];
+  UINT32                           PendingUpdateCount;
+  // MU_CHANGE [END]
+  VARIABLE_STORE_HEADER            *Store;
 } VARIABLE_RUNTIME_CACHE;
 
 typedef struct {
@@ -74,6 +89,14 @@ typedef struct {
   VARIABLE_RUNTIME_CACHE    VariableRuntimeHobCache;
   VARIABLE_RUNTIME_CACHE    VariableRuntimeNvCache;
   VARIABLE_RUNTIME_CACHE    VariableRuntimeVolatileCache;
+  // MU_CHANGE [BEGIN] - Delta runtime cache synchronization
+  //
+  // Bytes copied to the runtime caches since the driver started, and during
+  // the last SetVariable () call.
+  //
+  UINT64                    SyncedBytes;
+  UINT64                    SetVariableSyncedBytes;
+  // MU_CHANGE [END]
 } VARIABLE_RUNTIME_CACHE_CONTEXT;
 
 typedef struct {
@@ -377,6 +400,80 @@ ReclaimForOS (
   VOID
   );
 
+// MU_CHANGE [BEGIN] - Incremental variable store reclaim
+
+/**
+  Check if a variable is user variable or not.
+
+  @param[in] Variable   Pointer to variable header.
+
+  @retval TRUE          User variable.
+  @retval FALSE         System variable.
+
+**/
+BOOLEAN
+IsUserVariable (
+  IN VARIABLE_HEADER  *Variable
+  );
+
+/**
+  Do one step of the incremental reclaim of the non-volatile variable store.
+
+  A step erases one block of the free space left behind by the previous pass,
+  or compacts the live variables of one erase block, or starts a new pass when
+  the free space falls below twice the spare space. Each step is a single FTW
+  write, so its cost is bounded by one block erase/write.
+
+  @retval EFI_SUCCESS           The step completed or there was nothing to do.
+  @retval Others                The FTW write failed, the pass is abandoned.
+
+**/
+EFI_STATUS
+IncrementalReclaimStep (
+  VOID
+  );
+
+/**
+  Make sure the free space a new variable is appended to has been erased.
+
+  The free space released by an incremental reclaim pass is erased lazily, one
+  block per step. This erases the blocks the append is about to use, if any.
+
+  @param[in] VariableSize       Size of the variable to append.
+
+  @retval EFI_SUCCESS           The space is ready for the append.
+  @retval Others                The space could not be erased.
+
+**/
+EFI_STATUS
+IncrementalReclaimPrepareAppend (
+  IN UINTN  VariableSize
+  );
+
+/**
+  Take over the free space an incremental reclaim pass left unerased before the
+  last reset.
+
+  @retval TRUE          The free space that is not erased is queued.
+  @retval FALSE         The free space cannot be handled by the incremental reclaim.
+
+**/
+BOOLEAN
+IncrementalReclaimRecover (
+  VOID
+  );
+
+/**
+  Forget the incremental reclaim state after a full reclaim of the store.
+
+**/
+VOID
+IncrementalReclaimReset (
+  VOID
+  );
+
+// MU_CHANGE [END]
+
 /**
   Get maximum variable size, covering both non-volatile and volatile variables.
 
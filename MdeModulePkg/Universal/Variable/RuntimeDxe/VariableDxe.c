@@ -11,6 +11,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 **/
 
 #include "Variable.h"
+#include "VariableIndex.h"                     // MU_CHANGE - Index variable lookups
 
 #include <Protocol/VariablePolicy.h>
 #include <Library/VariablePolicyLib.h>
@@ -270,6 +271,14 @@ VariableClassAddressChangeEvent (
   EfiConvertPointer (0x0, (VOID **)&mNvVariableCache);
   EfiConvertPointer (0x0, (VOID **)&mNvFvHeaderCache);
 
+  // MU_CHANGE [BEGIN] - Index variable lookups
+  for (Index = 0; Index < VariableStoreTypeMax; Index++) {
+    EfiConvertPointer (0x0, (VOID **)&mVariableStoreIndex[Index].StartPtr);
+    EfiConvertPointer (0x0, (VOID **)&mVariableStoreIndex[Index].Slots);
+    EfiConvertPointer (0x0, (VOID **)&mVariableStoreIndex[Index].Hashes);
+  }
+  // MU_CHANGE [END]
+
   if (mAuthContextOut.AddressPointer != NULL) {
     for (Index = 0; Index < mAuthContextOut.AddressPointerCount; Index++) {
       EfiConvertPointer (0x0, (VOID **)mAuthContextOut.AddressPointer[Index]);
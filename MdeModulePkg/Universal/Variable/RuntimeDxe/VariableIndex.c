@@ -0,0 +1,372 @@
+/** @file
+  In-memory lookup index over the variable stores, shared by the DXE_RUNTIME
+  variable module and the SMM variable module.
+
+  Without the index every GetVariable () call walks the store from the start
+  and compares the GUID and name of each variable header. The index maps the
+  hash of the name and vendor GUID to the offsets of the variable headers with
+  that hash, so a lookup only has to check the variables that can match.
+
+  The index does not need to be told about every change of a store: a change of
+  variable state keeps the header in place, and new variables are appended
+  after the last indexed header, where the next lookup picks them up. Candidate
+  variables are checked in full on every lookup, so a stale entry is harmless.
+
+  Caution: This module requires additional review when modified.
+  This driver will have external input - variable data. They may be input in SMM mode.
+  This external input must be validated carefully to avoid security issue like
+  buffer overflow, integer overflow.
+
+Copyright (c) Microsoft Corporation.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "VariableIndex.h"
+#include "VariableParsing.h"
+
+//
+// The smallest variable is a header with a one character name, so a slot per
+// 32 bytes of store can never be used up by a valid store. The index stops
+// being used once it is three quarters full to keep probe sequences short.
+//
+#define VARIABLE_INDEX_BYTES_PER_SLOT  32
+#define VARIABLE_INDEX_MIN_SLOTS       64
+
+VARIABLE_STORE_INDEX  mVariableStoreIndex[VariableStoreTypeMax];
+
+/**
+  Hash a variable name and vendor GUID.
+
+  @param[in]  VariableName  Pointer to the variable name.
+  @param[in]  NameSize      Size of the variable name in bytes, including the
+                            terminating null character.
+  @param[in]  VendorGuid    Pointer to the vendor GUID.
+
+  @return The 32-bit hash of the name and GUID.
+
+**/
+STATIC
+UINT32
+VariableIndexHash (
+  IN CONST CHAR16    *VariableName,
+  IN UINTN           NameSize,
+  IN CONST EFI_GUID  *VendorGuid
+  )
+{
+  CONST UINT8  *Byte;
+  UINT32       Hash;
+  UINTN        Index;
+
+  //
+  // FNV-1a over the name, then the GUID folded in a word at a time.
+  //
+  Hash = 0x811C9DC5;
+  Byte = (CONST UINT8 *)VariableName;
+  for (Index = 0; Index < NameSize; Index++) {
+    Hash ^= Byte[Index];
+    Hash *= 0x01000193;
+  }
+
+  for (Index = 0; Index < sizeof (EFI_GUID); Index += sizeof (UINT32)) {
+    Hash ^= ReadUnaligned32 ((CONST UINT32 *)((CONST UINT8 *)VendorGuid + Index));
+    Hash *= 0x01000193;
+  }
+
+  Hash ^= Hash >> 16;
+  Hash *= 0x7FEB352D;
+  Hash ^= Hash >> 15;
+  return Hash;
+}
+
+/**
+  Reset the index of a store and make sure its table can cover the store.
+
+  The table is only allocated or grown before ExitBootServices (), at runtime
+  a store the table is too small for is not indexed.
+
+  @param[in, out]  StoreIndex  The index to reset.
+  @param[in]       StartPtr    Start of the variables of the store.
+  @param[in]       EndPtr      End of the variables of the store.
+
+**/
+STATIC
+VOID
+VariableIndexReset (
+  IN OUT VARIABLE_STORE_INDEX  *StoreIndex,
+  IN     VARIABLE_HEADER       *StartPtr,
+  IN     VARIABLE_HEADER       *EndPtr
+  )
+{
+  UINTN   StoreSize;
+  UINT32  SlotCount;
+
+  StoreIndex->StartPtr      = StartPtr;
+  StoreIndex->IndexedOffset = 0;
+  StoreIndex->UsedCount     = 0;
+  StoreIndex->Overflow      = TRUE;
+
+  if ((UINTN)EndPtr < (UINTN)StartPtr) {
+    return;
+  }
+
+  StoreSize = (UINTN)EndPtr - (UINTN)StartPtr;
+  if ((StoreSize / VARIABLE_INDEX_BYTES_PER_SLOT) > (MAX_UINT32 >> 2)) {
+    return;
+  }
+
+  SlotCount = MAX (VARIABLE_INDEX_MIN_SLOTS, (UINT32)(StoreSize / VARIABLE_INDEX_BYTES_PER_SLOT));
+  if (GetPowerOfTwo32 (SlotCount) != SlotCount) {
+    SlotCount = GetPowerOfTwo32 (SlotCount) << 1;
+  }
+
+  if (StoreIndex->SlotCount < SlotCount) {
+    if (AtRuntime ()) {
+      return;
+    }
+
+    if (StoreIndex->Slots != NULL) {
+      FreePool (StoreIndex->Slots);
+      FreePool (StoreIndex->Hashes);
+    }
+
+    StoreIndex->SlotCount = 0;
+    StoreIndex->Slots     = AllocateRuntimeZeroPool (SlotCount * sizeof (UINT32));
+    StoreIndex->Hashes    = AllocateRuntimeZeroPool (SlotCount * sizeof (UINT32));
+    if ((StoreIndex->Slots == NULL) || (StoreIndex->Hashes == NULL)) {
+      if (StoreIndex->Slots != NULL) {
+        FreePool (StoreIndex->Slots);
+        StoreIndex->Slots = NULL;
+      }
+
+      if (StoreIndex->Hashes != NULL) {
+        FreePool (StoreIndex->Hashes);
+        StoreIndex->Hashes = NULL;
+      }
+
+      return;
+    }
+
+    StoreIndex->SlotCount = SlotCount;
+  } else {
+    ZeroMem (StoreIndex->Slots, StoreIndex->SlotCount * sizeof (UINT32));
+  }
+
+  StoreIndex->Overflow = FALSE;
+}
+
+/**
+  Bring the index of a store up to date with the variables appended to it
+  since the last lookup.
+
+  @param[in]  StoreType   The type of the variable store.
+  @param[in]  StartPtr    Start of the variables of the store.
+  @param[in]  EndPtr      End of the variables of the store.
+  @param[in]  AuthFormat  TRUE indicates authenticated variables are used.
+                          FALSE indicates authenticated variables are not used.
+
+  @return The index of the store, or NULL if the store has to be searched
+          without it.
+
+**/
+STATIC
+VARIABLE_STORE_INDEX *
+VariableIndexUpdate (
+  IN VARIABLE_STORE_TYPE  StoreType,
+  IN VARIABLE_HEADER      *StartPtr,
+  IN VARIABLE_HEADER      *EndPtr,
+  IN BOOLEAN              AuthFormat
+  )
+{
+  VARIABLE_STORE_INDEX  *StoreIndex;
+  VARIABLE_HEADER       *Variable;
+  CHAR16                *Name;
+  UINTN                 NameSize;
+  UINTN                 Offset;
+  UINT32                Hash;
+  UINT32                Slot;
+
+  StoreIndex = &mVariableStoreIndex[StoreType];
+  if (StoreIndex->StartPtr != StartPtr) {
+    VariableIndexReset (StoreIndex, StartPtr, EndPtr);
+  }
+
+  if (StoreIndex->Overflow) {
+    return NULL;
+  }
+
+  for ( Variable = (VARIABLE_HEADER *)((UINTN)StartPtr + StoreIndex->IndexedOffset)
+        ; IsValidVariableHeader (Variable, EndPtr)
+        ; Variable = GetNextVariablePtr (Variable, AuthFormat)
+        )
+  {
+    Name     = GetVariableNamePtr (Variable, AuthFormat);
+    NameSize = NameSizeOfVariable (Variable, AuthFormat);
+    Offset   = (UINTN)Variable - (UINTN)StartPtr;
+    if ((NameSize == 0) ||
+        (NameSize > (UINTN)EndPtr - (UINTN)Name) ||
+        (Offset >= MAX_UINT32) ||
+        (StoreIndex->UsedCount >= StoreIndex->SlotCount - (StoreIndex->SlotCount >> 2)))
+    {
+      StoreIndex->Overflow = TRUE;
+      return NULL;
+    }
+
+    Hash = VariableIndexHash (Name, NameSize, GetVendorGuidPtr (Variable, AuthFormat));
+    for (Slot = Hash & (StoreIndex->SlotCount - 1); StoreIndex->Slots[Slot] != 0; Slot = (Slot + 1) & (StoreIndex->SlotCount - 1)) {
+    }
+
+    StoreIndex->Slots[Slot]  = (UINT32)Offset + 1;
+    StoreIndex->Hashes[Slot] = Hash;
+    StoreIndex->UsedCount++;
+  }
+
+  StoreIndex->IndexedOffset = (UINTN)Variable - (UINTN)StartPtr;
+  return StoreIndex;
+}
+
+/**
+  Find the variable in the specified variable store, using the index of the
+  store when it is available.
+
+  This function behaves as FindVariableEx (): the first variable in VAR_ADDED
+  state is returned and PtrTrack->InDeletedTransitionPtr is set to the
+  matching variable in VAR_IN_DELETED_TRANSITION state found before it, if any.
+
+  @param[in]       VariableName        Name of the variable to be found.
+  @param[in]       VendorGuid          Vendor GUID to be found.
+  @param[in]       IgnoreRtCheck       Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                       check at runtime when searching variable.
+  @param[in]       StoreType           The type of the variable store searched.
+  @param[in, out]  PtrTrack            Variable Track Pointer structure that contains Variable Information.
+                                       StartPtr and EndPtr must describe the store.
+  @param[in]       AuthFormat          TRUE indicates authenticated variables are used.
+                                       FALSE indicates authenticated variables are not used.
+
+  @retval          EFI_SUCCESS         Variable found successfully
+  @retval          EFI_NOT_FOUND       Variable not found
+**/
+EFI_STATUS
+FindVariableIndexed (
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN     VARIABLE_STORE_TYPE     StoreType,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack,
+  IN     BOOLEAN                 AuthFormat
+  )
+{
+  VARIABLE_STORE_INDEX  *StoreIndex;
+  VARIABLE_HEADER       *Variable;
+  VARIABLE_HEADER       *AddedVariable;
+  VARIABLE_HEADER       *InDeletedVariable;
+  UINTN                 NameSize;
+  UINT32                Hash;
+  UINT32                Slot;
+
+  //
+  // An empty name asks for the first variable of the store, which the index
+  // cannot answer.
+  //
+  StoreIndex = NULL;
+  if (VariableName[0] != 0) {
+    StoreIndex = VariableIndexUpdate (StoreType, PtrTrack->StartPtr, PtrTrack->EndPtr, AuthFormat);
+  }
+
+  if (StoreIndex == NULL) {
+    return FindVariableEx (VariableName, VendorGuid, IgnoreRtCheck, PtrTrack, AuthFormat);
+  }
+
+  NameSize = StrSize (VariableName);
+  Hash     = VariableIndexHash (VariableName, NameSize, VendorGuid);
+
+  //
+  // The probe sequence holds the candidates in hash table order, so find the
+  // first added variable in store order, then the last variable in deleted
+  // transition before it, as the linear walk of FindVariableEx () does.
+  //
+  AddedVariable     = NULL;
+  InDeletedVariable = NULL;
+  for (Slot = Hash & (StoreIndex->SlotCount - 1); StoreIndex->Slots[Slot] != 0; Slot = (Slot + 1) & (StoreIndex->SlotCount - 1)) {
+    if (StoreIndex->Hashes[Slot] != Hash) {
+      continue;
+    }
+
+    Variable = (VARIABLE_HEADER *)((UINTN)PtrTrack->StartPtr + StoreIndex->Slots[Slot] - 1);
+    if ((Variable->State != VAR_ADDED) &&
+        (Variable->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED)))
+    {
+      continue;
+    }
+
+    if (!IgnoreRtCheck && AtRuntime () && ((Variable->Attributes & EFI_VARIABLE_RUNTIME_ACCESS) == 0)) {
+      continue;
+    }
+
+    if ((NameSizeOfVariable (Variable, AuthFormat) != NameSize) ||
+        !CompareGuid (VendorGuid, GetVendorGuidPtr (Variable, AuthFormat)) ||
+        (CompareMem (VariableName, GetVariableNamePtr (Variable, AuthFormat), NameSize) != 0))
+    {
+      continue;
+    }
+
+    if (Variable->State == VAR_ADDED) {
+      if ((AddedVariable == NULL) || (Variable < AddedVariable)) {
+        AddedVariable = Variable;
+      }
+    } else if ((AddedVariable == NULL) || (Variable < AddedVariable)) {
+      if ((InDeletedVariable == NULL) || (Variable > InDeletedVariable)) {
+        InDeletedVariable = Variable;
+      }
+    }
+  }
+
+  //
+  // An in deleted transition variable found before the first added variable
+  // was known may come after it in the store.
+  //
+  if ((AddedVariable != NULL) && (InDeletedVariable != NULL) && (InDeletedVariable > AddedVariable)) {
+    InDeletedVariable = NULL;
+    for (Slot = Hash & (StoreIndex->SlotCount - 1); StoreIndex->Slots[Slot] != 0; Slot = (Slot + 1) & (StoreIndex->SlotCount - 1)) {
+      Variable = (VARIABLE_HEADER *)((UINTN)PtrTrack->StartPtr + StoreIndex->Slots[Slot] - 1);
+      if ((StoreIndex->Hashes[Slot] == Hash) &&
+          (Variable < AddedVariable) &&
+          ((InDeletedVariable == NULL) || (Variable > InDeletedVariable)) &&
+          (Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) &&
+          (IgnoreRtCheck || !AtRuntime () || ((Variable->Attributes & EFI_VARIABLE_RUNTIME_ACCESS) != 0)) &&
+          (NameSizeOfVariable (Variable, AuthFormat) == NameSize) &&
+          CompareGuid (VendorGuid, GetVendorGuidPtr (Variable, AuthFormat)) &&
+          (CompareMem (VariableName, GetVariableNamePtr (Variable, AuthFormat), NameSize) == 0))
+      {
+        InDeletedVariable = Variable;
+      }
+    }
+  }
+
+  if (AddedVariable != NULL) {
+    PtrTrack->CurrPtr                = AddedVariable;
+    PtrTrack->InDeletedTransitionPtr = InDeletedVariable;
+    return EFI_SUCCESS;
+  }
+
+  PtrTrack->CurrPtr                = InDeletedVariable;
+  PtrTrack->InDeletedTransitionPtr = NULL;
+  return (PtrTrack->CurrPtr == NULL) ? EFI_NOT_FOUND : EFI_SUCCESS;
+}
+
+/**
+  Discard the content of the index of a variable store.
+
+  Must be called whenever the variables of the store are moved or rewritten
+  in place. The index is rebuilt on the next lookup.
+
+  @param[in]  StoreType  The type of the variable store.
+
+**/
+VOID
+VariableIndexInvalidate (
+  IN VARIABLE_STORE_TYPE  StoreType
+  )
+{
+  mVariableStoreIndex[StoreType].StartPtr = NULL;
+}
@@ -0,0 +1,95 @@
+/** @file
+  In-memory lookup index over the variable stores.
+
+  Each variable store gets an open addressing hash table keyed by the hash of
+  the variable name and vendor GUID, which maps to the offset of every variable
+  header in the store. The index is brought up to date lazily on lookup, so
+  appends done by UpdateVariable () are picked up without extra bookkeeping;
+  anything that rewrites a store in place, such as Reclaim (), must invalidate
+  the index of that store.
+
+Copyright (c) Microsoft Corporation.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _VARIABLE_INDEX_H_
+#define _VARIABLE_INDEX_H_
+
+#include "Variable.h"
+
+typedef struct {
+  //
+  // Start of the variables covered by the index. A different start pointer
+  // means a different store and resets the index.
+  //
+  VARIABLE_HEADER    *StartPtr;
+  //
+  // Offset of each indexed variable header from StartPtr plus one, 0 marks
+  // an empty slot.
+  //
+  UINT32             *Slots;
+  //
+  // Name and GUID hash of the variable in the matching slot.
+  //
+  UINT32             *Hashes;
+  UINT32             SlotCount;
+  UINT32             UsedCount;
+  //
+  // Offset from StartPtr of the first variable header not yet indexed.
+  //
+  UINTN              IndexedOffset;
+  //
+  // TRUE if the index could not cover the store, lookups then walk the store.
+  //
+  BOOLEAN            Overflow;
+} VARIABLE_STORE_INDEX;
+
+extern VARIABLE_STORE_INDEX  mVariableStoreIndex[VariableStoreTypeMax];
+
+/**
+  Find the variable in the specified variable store, using the index of the
+  store when it is available.
+
+  This function behaves as FindVariableEx (): the first variable in VAR_ADDED
+  state is returned and PtrTrack->InDeletedTransitionPtr is set to the
+  matching variable in VAR_IN_DELETED_TRANSITION state found before it, if any.
+
+  @param[in]       VariableName        Name of the variable to be found.
+  @param[in]       VendorGuid          Vendor GUID to be found.
+  @param[in]       IgnoreRtCheck       Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                       check at runtime when searching variable.
+  @param[in]       StoreType           The type of the variable store searched.
+  @param[in, out]  PtrTrack            Variable Track Pointer structure that contains Variable Information.
+                                       StartPtr and EndPtr must describe the store.
+  @param[in]       AuthFormat          TRUE indicates authenticated variables are used.
+                                       FALSE indicates authenticated variables are not used.
+
+  @retval          EFI_SUCCESS         Variable found successfully
+  @retval          EFI_NOT_FOUND       Variable not found
+**/
+EFI_STATUS
+FindVariableIndexed (
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN     VARIABLE_STORE_TYPE     StoreType,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack,
+  IN     BOOLEAN                 AuthFormat
+  );
+
+/**
+  Discard the content of the index of a variable store.
+
+  Must be called whenever the variables of the store are moved or rewritten
+  in place. The index is rebuilt on the next lookup.
+
+  @param[in]  StoreType  The type of the variable store.
+
+**/
+VOID
+VariableIndexInvalidate (
+  IN VARIABLE_STORE_TYPE  StoreType
+  );
+
+#endif
@@ -8,6 +8,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "VariableNonVolatile.h"
 #include "VariableParsing.h"
+#include "VariableIndex.h"               // MU_CHANGE - Index variable lookups
 
 extern VARIABLE_MODULE_GLOBAL  *mVariableModuleGlobal;
 
@@ -120,6 +121,69 @@ InitEmuNonVolatileVariableStore (
   return EFI_SUCCESS;
 }
 
+// MU_CHANGE [BEGIN] - Recover interrupted block-sized FTW writes of the NV storage
+
+/**
+  Copy the NV storage data backed up in the spare block by an interrupted FTW
+  write over a copy of the NV storage read from flash.
+
+  The spare block only holds the target blocks spanned by the last write. The
+  rest of the copy keeps the data read from flash, which the write has not
+  touched.
+
+  @param[in]      NvStorageBase     Base address of the NV storage.
+  @param[in]      NvStorageSize     Size of the NV storage.
+  @param[in, out] NvStorageData     Copy of the NV storage read from flash.
+  @param[in]      FtwLastWriteData  The FTW last write data.
+
+**/
+VOID
+MergeFtwLastWriteData (
+  IN     EFI_PHYSICAL_ADDRESS                  NvStorageBase,
+  IN     UINT32                                NvStorageSize,
+  IN OUT UINT8                                 *NvStorageData,
+  IN     FAULT_TOLERANT_WRITE_LAST_WRITE_DATA  *FtwLastWriteData
+  )
+{
+  EFI_FIRMWARE_VOLUME_HEADER  *FvHeader;
+  UINT32                      BackUpOffset;
+  UINT64                      BackUpSize;
+  UINT64                      BlockSize;
+
+  if ((FtwLastWriteData->TargetAddress < NvStorageBase) ||
+      (FtwLastWriteData->TargetAddress >= (NvStorageBase + NvStorageSize)))
+  {
+    return;
+  }
+
+  BackUpOffset = (UINT32)(FtwLastWriteData->TargetAddress - NvStorageBase);
+
+  //
+  // The last write erased whole target blocks, round its length up to the block
+  // size. The firmware volume header is only valid in the spare block if the
+  // first block of the NV storage was the target.
+  //
+  FvHeader   = (EFI_FIRMWARE_VOLUME_HEADER *)((BackUpOffset == 0) ? (UINT8 *)(UINTN)FtwLastWriteData->SpareAddress : NvStorageData);
+  BackUpSize = FtwLastWriteData->Length;
+  BlockSize  = (FvHeader->Signature == EFI_FVH_SIGNATURE) ? FvHeader->BlockMap[0].Length : 0;
+  if (BlockSize != 0) {
+    BackUpSize = MultU64x64 (DivU64x64Remainder (BackUpSize + BlockSize - 1, BlockSize, NULL), BlockSize);
+  }
+
+  BackUpSize = MIN (BackUpSize, (UINT64)(NvStorageSize - BackUpOffset));
+  DEBUG ((
+    DEBUG_INFO,
+    "Variable: NV storage from offset 0x%x, length 0x%x is backed up in spare block: 0x%x\n",
+    BackUpOffset,
+    (UINTN)BackUpSize,
+    (UINTN)FtwLastWriteData->SpareAddress
+    ));
+
+  CopyMem (NvStorageData + BackUpOffset, (UINT8 *)(UINTN)FtwLastWriteData->SpareAddress, (UINTN)BackUpSize);
+}
+
+// MU_CHANGE [END]
+
 /**
   Init real non-volatile variable store.
 
@@ -144,8 +208,6 @@ InitRealNonVolatileVariableStore (
   UINT32                                NvStorageSize;
   UINT64                                NvStorageSize64;
   FAULT_TOLERANT_WRITE_LAST_WRITE_DATA  *FtwLastWriteData;
-  UINT32                                BackUpOffset;
-  UINT32                                BackUpSize;
   UINT32                                HwErrStorageSize;
   UINT32                                MaxUserNvVariableSpaceSize;
   UINT32                                BoottimeReservedNvVariableSpaceSize;
@@ -188,26 +250,10 @@ InitRealNonVolatileVariableStore (
     GuidHob = GetFirstGuidHob (&gEdkiiFaultTolerantWriteGuid);
     if (GuidHob != NULL) {
       FtwLastWriteData = (FAULT_TOLERANT_WRITE_LAST_WRITE_DATA *)GET_GUID_HOB_DATA (GuidHob);
-      if (FtwLastWriteData->TargetAddress == NvStorageBase) {
-        DEBUG ((DEBUG_INFO, "Variable: NV storage is backed up in spare block: 0x%x\n", (UINTN)FtwLastWriteData->SpareAddress));
-        //
-        // Copy the backed up NV storage data to the memory buffer from spare block.
-        //
-        CopyMem (NvStorageData, (UINT8 *)(UINTN)(FtwLastWriteData->SpareAddress), NvStorageSize);
-      } else if ((FtwLastWriteData->TargetAddress > NvStorageBase) &&
-                 (FtwLastWriteData->TargetAddress < (NvStorageBase + NvStorageSize)))
-      {
-        //
-        // Flash NV storage from the Offset is backed up in spare block.
-        //
-        BackUpOffset = (UINT32)(FtwLastWriteData->TargetAddress - NvStorageBase);
-        BackUpSize   = NvStorageSize - BackUpOffset;
-        DEBUG ((DEBUG_INFO, "Variable: High partial NV storage from offset: %x is backed up in spare block: 0x%x\n", BackUpOffset, (UINTN)FtwLastWriteData->SpareAddress));
-        //
-        // Copy the partial backed up NV storage data to the memory buffer from spare block.
-        //
-        CopyMem (NvStorageData + BackUpOffset, (UINT8 *)(UINTN)FtwLastWriteData->SpareAddress, BackUpSize);
-      }
+      //
+      // Copy the backed up NV storage data to the memory buffer from spare block.
+      //
+      MergeFtwLastWriteData (NvStorageBase, NvStorageSize, NvStorageData, FtwLastWriteData);  // MU_CHANGE
     }
   }
 
@@ -321,6 +367,7 @@ InitNonVolatileVariableStore (
   mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase = VariableStoreBase;
   mNvVariableCache                                              = (VARIABLE_STORE_HEADER *)(UINTN)VariableStoreBase;
   mVariableModuleGlobal->VariableGlobal.AuthFormat              = (BOOLEAN)(CompareGuid (&mNvVariableCache->Signature, &gEfiAuthenticatedVariableGuid));
+  VariableIndexInvalidate (VariableStoreTypeNv);                // MU_CHANGE - Index variable lookups
 
   mVariableModuleGlobal->MaxVariableSize     = PcdGet32 (PcdMaxVariableSize);
   mVariableModuleGlobal->MaxAuthVariableSize = ((PcdGet32 (PcdMaxAuthVariableSize) != 0) ? PcdGet32 (PcdMaxAuthVariableSize) : mVariableModuleGlobal->MaxVariableSize);
@@ -36,6 +36,28 @@ InitEmuNonVolatileVariableStore (
   EFI_PHYSICAL_ADDRESS  *VariableStoreBase
   );
 
+// MU_CHANGE [BEGIN] - Recover interrupted block-sized FTW writes of the NV storage
+
+/**
+  Copy the NV storage data backed up in the spare block by an interrupted FTW
+  write over a copy of the NV storage read from flash.
+
+  @param[in]      NvStorageBase     Base address of the NV storage.
+  @param[in]      NvStorageSize     Size of the NV storage.
+  @param[in, out] NvStorageData     Copy of the NV storage read from flash.
+  @param[in]      FtwLastWriteData  The FTW last write data.
+
+**/
+VOID
+MergeFtwLastWriteData (
+  IN     EFI_PHYSICAL_ADDRESS                  NvStorageBase,
+  IN     UINT32                                NvStorageSize,
+  IN OUT UINT8                                 *NvStorageData,
+  IN     FAULT_TOLERANT_WRITE_LAST_WRITE_DATA  *FtwLastWriteData
+  );
+
+// MU_CHANGE [END]
+
 /**
   Init real non-volatile variable store.
 
@@ -18,6 +18,125 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 extern VARIABLE_MODULE_GLOBAL  *mVariableModuleGlobal;
 extern VARIABLE_STORE_HEADER   *mNvVariableCache;
 
+// MU_CHANGE [BEGIN] - Delta runtime cache synchronization
+
+/**
+  Copies the pending updates of one runtime variable cache from the variable store it mirrors.
+
+  @param[in, out] VariableRuntimeCache  Variable runtime cache structure for the runtime cache being updated.
+  @param[in]      VariableStore         The variable store mirrored by the runtime cache.
+
+**/
+STATIC
+VOID
+FlushRuntimeVariableCache (
+  IN OUT VARIABLE_RUNTIME_CACHE  *VariableRuntimeCache,
+  IN     VARIABLE_STORE_HEADER   *VariableStore
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *VariableRuntimeCacheContext;
+  VARIABLE_RUNTIME_CACHE_UPDATE   *Update;
+  UINT32                          Index;
+
+  VariableRuntimeCacheContext = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
+
+  for (Index = 0; Index < VariableRuntimeCache->PendingUpdateCount; Index++) {
+    Update = &VariableRuntimeCache->PendingUpdates[Index];
+    CopyMem (
+      (UINT8 *)VariableRuntimeCache->Store + Update->Offset,
+      (UINT8 *)VariableStore + Update->Offset,
+      Update->Length
+      );
+    VariableRuntimeCacheContext->SyncedBytes            += Update->Length;
+    VariableRuntimeCacheContext->SetVariableSyncedBytes += Update->Length;
+  }
+
+  VariableRuntimeCache->PendingUpdateCount = 0;
+}
+
+/**
+  Adds a range to the pending updates of a runtime variable cache.
+
+  Ranges that overlap or touch are merged so each byte is copied once. When
+  there are more disjoint ranges than can be tracked, the two neighbouring
+  ranges with the smallest gap between them are merged.
+
+  @param[in, out] VariableRuntimeCache  Variable runtime cache structure for the runtime cache being updated.
+  @param[in]      Offset                Offset in bytes of the update.
+  @param[in]      Length                Length of data in bytes of the update.
+
+**/
+STATIC
+VOID
+AddPendingRuntimeVariableCacheUpdate (
+  IN OUT VARIABLE_RUNTIME_CACHE  *VariableRuntimeCache,
+  IN     UINTN                   Offset,
+  IN     UINTN                   Length
+  )
+{
+  VARIABLE_RUNTIME_CACHE_UPDATE  Updates[VARIABLE_RUNTIME_CACHE_MAX_PENDING_UPDATES + 1];
+  VARIABLE_RUNTIME_CACHE_UPDATE  *Update;
+  UINTN                          End;
+  UINT32                         Index;
+  UINT32                         Count;
+  UINT32                         Slot;
+  UINT32                         Merge;
+  UINT32                         Gap;
+  UINT32                         SmallestGap;
+
+  if (Length == 0) {
+    return;
+  }
+
+  //
+  // Fold the pending ranges that overlap or touch the new one into it. The
+  // others are kept in order, Slot counts the ones before the new range.
+  //
+  End   = Offset + Length;
+  Count = 0;
+  Slot  = 0;
+  for (Index = 0; Index < VariableRuntimeCache->PendingUpdateCount; Index++) {
+    Update = &VariableRuntimeCache->PendingUpdates[Index];
+    if ((Update->Offset <= End) && (Offset <= (UINTN)Update->Offset + Update->Length)) {
+      Offset = MIN (Offset, Update->Offset);
+      End    = MAX (End, (UINTN)Update->Offset + Update->Length);
+      continue;
+    }
+
+    if (Update->Offset < Offset) {
+      Slot = Count + 1;
+    }
+
+    CopyMem (&Updates[Count++], Update, sizeof (*Update));
+  }
+
+  CopyMem (&Updates[Slot + 1], &Updates[Slot], (Count - Slot) * sizeof (Updates[0]));
+  Updates[Slot].Offset = (UINT32)Offset;
+  Updates[Slot].Length = (UINT32)(End - Offset);
+  Count++;
+
+  if (Count > VARIABLE_RUNTIME_CACHE_MAX_PENDING_UPDATES) {
+    Merge       = 0;
+    SmallestGap = MAX_UINT32;
+    for (Index = 0; Index + 1 < Count; Index++) {
+      Gap = Updates[Index + 1].Offset - (Updates[Index].Offset + Updates[Index].Length);
+      if (Gap < SmallestGap) {
+        SmallestGap = Gap;
+        Merge       = Index;
+      }
+    }
+
+    Updates[Merge].Length = Updates[Merge + 1].Offset + Updates[Merge + 1].Length - Updates[Merge].Offset;
+    CopyMem (&Updates[Merge + 1], &Updates[Merge + 2], (Count - Merge - 2) * sizeof (Updates[0]));
+    Count--;
+  }
+
+  CopyMem (VariableRuntimeCache->PendingUpdates, Updates, Count * sizeof (Updates[0]));
+  VariableRuntimeCache->PendingUpdateCount = Count;
+}
+
+// MU_CHANGE [END]
+
 /**
   Copies any pending updates to runtime variable caches.
 
@@ -42,52 +161,26 @@ FlushPendingRuntimeVariableCacheUpdates (
   }
 
   if (*(VariableRuntimeCacheContext->PendingUpdate)) {
+    // MU_CHANGE [BEGIN] - Delta runtime cache synchronization
     if ((VariableRuntimeCacheContext->VariableRuntimeHobCache.Store != NULL) &&
         (mVariableModuleGlobal->VariableGlobal.HobVariableBase > 0))
     {
-      CopyMem (
-        (VOID *)(
-                 ((UINT8 *)(UINTN)VariableRuntimeCacheContext->VariableRuntimeHobCache.Store) +
-                 VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateOffset
-                 ),
-        (VOID *)(
-                 ((UINT8 *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase) +
-                 VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateOffset
-                 ),
-        VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateLength
+      FlushRuntimeVariableCache (
+        &VariableRuntimeCacheContext->VariableRuntimeHobCache,
+        (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase
         );
-      VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateLength = 0;
-      VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateOffset = 0;
     }
 
-    CopyMem (
-      (VOID *)(
-               ((UINT8 *)(UINTN)VariableRuntimeCacheContext->VariableRuntimeNvCache.Store) +
-               VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateOffset
-               ),
-      (VOID *)(
-               ((UINT8 *)(UINTN)mNvVariableCache) +
-               VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateOffset
-               ),
-      VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateLength
+    FlushRuntimeVariableCache (
+      &VariableRuntimeCacheContext->VariableRuntimeNvCache,
+      mNvVariableCache
       );
-    VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateLength = 0;
-    VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateOffset = 0;
-
-    CopyMem (
-      (VOID *)(
-               ((UINT8 *)(UINTN)VariableRuntimeCacheContext->VariableRuntimeVolatileCache.Store) +
-               VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset
-               ),
-      (VOID *)(
-               ((UINT8 *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase) +
-               VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset
-               ),
-      VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateLength
+    FlushRuntimeVariableCache (
+      &VariableRuntimeCacheContext->VariableRuntimeVolatileCache,
+      (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase
       );
-    VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateLength = 0;
-    VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset = 0;
-    *(VariableRuntimeCacheContext->PendingUpdate)                                 = FALSE;
+    // MU_CHANGE [END]
+    *(VariableRuntimeCacheContext->PendingUpdate) = FALSE;
   }
 
   return EFI_SUCCESS;
@@ -131,23 +224,14 @@ SynchronizeRuntimeVariableCache (
     return EFI_UNSUPPORTED;
   }
 
-  if (*(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.PendingUpdate) &&
-      (VariableRuntimeCache->PendingUpdateLength > 0))
-  {
-    VariableRuntimeCache->PendingUpdateLength =
-      (UINT32)(
-               MAX (
-                 (UINTN)(VariableRuntimeCache->PendingUpdateOffset + VariableRuntimeCache->PendingUpdateLength),
-                 Offset + Length
-                 ) - MIN ((UINTN)VariableRuntimeCache->PendingUpdateOffset, Offset)
-               );
-    VariableRuntimeCache->PendingUpdateOffset =
-      (UINT32)MIN ((UINTN)VariableRuntimeCache->PendingUpdateOffset, Offset);
-  } else {
-    VariableRuntimeCache->PendingUpdateLength = (UINT32)Length;
-    VariableRuntimeCache->PendingUpdateOffset = (UINT32)Offset;
+  // MU_CHANGE [BEGIN] - Delta runtime cache synchronization
+  if (!*(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.PendingUpdate)) {
+    VariableRuntimeCache->PendingUpdateCount = 0;
   }
 
+  AddPendingRuntimeVariableCacheUpdate (VariableRuntimeCache, Offset, Length);
+  // MU_CHANGE [END]
+
   *(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.PendingUpdate) = TRUE;
 
   if (*(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.ReadLock) == FALSE) {
@@ -156,3 +240,66 @@ SynchronizeRuntimeVariableCache (
 
   return EFI_SUCCESS;
 }
+
+// MU_CHANGE [BEGIN] - Delta runtime cache synchronization
+
+/**
+  Synchronizes the runtime variable cache with the changes UpdateVariable () made to a variable store.
+
+  Only the state of the previous instances of the variable and the bytes of the new instance are copied,
+  instead of the whole store.
+
+  @param[in] VariableRuntimeCache Variable runtime cache structure for the runtime cache being synchronized.
+  @param[in] VariableStore        The variable store mirrored by the runtime cache.
+  @param[in] UpdatedVariable      Optional. Tracks the previous instances of the variable, whose state may
+                                  have changed. Pointers outside VariableStore are ignored.
+  @param[in] NewVariableOffset    Offset in bytes in the store of the new instance of the variable.
+  @param[in] NewVariableSize      Size in bytes of the new instance of the variable, 0 if none was added.
+
+  @retval EFI_SUCCESS             The updates were added as pending updates successfully. If the variable
+                                  runtime cache ReadLock was available, the runtime cache was updated successfully.
+  @retval EFI_UNSUPPORTED         The volatile store to be updated is not initialized properly.
+
+**/
+EFI_STATUS
+SynchronizeRuntimeVariableCacheVariable (
+  IN  VARIABLE_RUNTIME_CACHE  *VariableRuntimeCache,
+  IN  VARIABLE_STORE_HEADER   *VariableStore,
+  IN  VARIABLE_POINTER_TRACK  *UpdatedVariable OPTIONAL,
+  IN  UINTN                   NewVariableOffset,
+  IN  UINTN                   NewVariableSize
+  )
+{
+  EFI_STATUS       Status;
+  VARIABLE_HEADER  *StateVariables[2];
+  UINTN            Index;
+
+  StateVariables[0] = NULL;
+  StateVariables[1] = NULL;
+  if (UpdatedVariable != NULL) {
+    StateVariables[0] = UpdatedVariable->CurrPtr;
+    StateVariables[1] = UpdatedVariable->InDeletedTransitionPtr;
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (StateVariables); Index++) {
+    if ((StateVariables[Index] == NULL) ||
+        ((UINTN)StateVariables[Index] < (UINTN)GetStartPointer (VariableStore)) ||
+        ((UINTN)StateVariables[Index] >= (UINTN)GetEndPointer (VariableStore)))
+    {
+      continue;
+    }
+
+    Status = SynchronizeRuntimeVariableCache (
+               VariableRuntimeCache,
+               (UINTN)&StateVariables[Index]->State - (UINTN)VariableStore,
+               sizeof (StateVariables[Index]->State)
+               );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return SynchronizeRuntimeVariableCache (VariableRuntimeCache, NewVariableOffset, NewVariableSize);
+}
+
+// MU_CHANGE [END]
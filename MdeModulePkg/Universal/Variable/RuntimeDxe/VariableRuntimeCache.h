@@ -48,4 +48,35 @@ SynchronizeRuntimeVariableCache (
   IN  UINTN                   Length
   );
 
+// MU_CHANGE [BEGIN] - Delta runtime cache synchronization
+
+/**
+  Synchronizes the runtime variable cache with the changes UpdateVariable () made to a variable store.
+
+  Only the state of the previous instances of the variable and the bytes of the new instance are copied,
+  instead of the whole store.
+
+  @param[in] VariableRuntimeCache Variable runtime cache structure for the runtime cache being synchronized.
+  @param[in] VariableStore        The variable store mirrored by the runtime cache.
+  @param[in] UpdatedVariable      Optional. Tracks the previous instances of the variable, whose state may
+                                  have changed. Pointers outside VariableStore are ignored.
+  @param[in] NewVariableOffset    Offset in bytes in the store of the new instance of the variable.
+  @param[in] NewVariableSize      Size in bytes of the new instance of the variable, 0 if none was added.
+
+  @retval EFI_SUCCESS             The updates were added as pending updates successfully. If the variable
+                                  runtime cache ReadLock was available, the runtime cache was updated successfully.
+  @retval EFI_UNSUPPORTED         The volatile store to be updated is not initialized properly.
+
+**/
+EFI_STATUS
+SynchronizeRuntimeVariableCacheVariable (
+  IN  VARIABLE_RUNTIME_CACHE  *VariableRuntimeCache,
+  IN  VARIABLE_STORE_HEADER   *VariableStore,
+  IN  VARIABLE_POINTER_TRACK  *UpdatedVariable OPTIONAL,
+  IN  UINTN                   NewVariableOffset,
+  IN  UINTN                   NewVariableSize
+  );
+
+// MU_CHANGE [END]
+
 #endif
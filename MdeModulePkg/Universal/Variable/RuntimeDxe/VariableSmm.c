@@ -427,6 +427,111 @@ SmmVariableGetStatistics (
   return EFI_SUCCESS;
 }
 
+// MU_CHANGE [BEGIN] - Batched variable access
+
+/**
+  Execute the operations of a SMM_VARIABLE_FUNCTION_BATCH request.
+
+  Caution: This function may receive untrusted input.
+  The batch has been copied to SMRAM by the caller. The sizes of each entry are
+  checked against the size of the batch before the entry is used.
+
+  @param[in, out] Batch         The batch request, in SMRAM.
+  @param[in]      BatchSize     Size of the batch request.
+
+  @retval EFI_SUCCESS           All the operations have been executed, the status
+                                of each one is in its ReturnStatus field.
+  @retval EFI_ACCESS_DENIED     An entry does not fit in the batch. The entries
+                                before it have been executed.
+
+**/
+STATIC
+EFI_STATUS
+SmmVariableBatch (
+  IN OUT SMM_VARIABLE_COMMUNICATE_BATCH  *Batch,
+  IN     UINTN                           BatchSize
+  )
+{
+  SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY      *Entry;
+  SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE  *Access;
+  UINTN                                     Index;
+  UINTN                                     Offset;
+  UINTN                                     Remaining;
+  UINTN                                     EntrySize;
+
+  Offset = sizeof (SMM_VARIABLE_COMMUNICATE_BATCH);
+  for (Index = 0; Index < Batch->EntryCount; Index++) {
+    if (BatchSize - Offset < SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE) {
+      DEBUG ((DEBUG_ERROR, "VariableBatch: Entry %d exceeds communication buffer size limit!\n", Index));
+      return EFI_ACCESS_DENIED;
+    }
+
+    Entry     = (SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY *)((UINT8 *)Batch + Offset);
+    Access    = &Entry->Access;
+    Remaining = BatchSize - Offset - SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE;
+    if ((Access->NameSize > Remaining) || (Access->DataSize > Remaining - Access->NameSize)) {
+      DEBUG ((DEBUG_ERROR, "VariableBatch: Entry %d exceeds communication buffer size limit!\n", Index));
+      return EFI_ACCESS_DENIED;
+    }
+
+    EntrySize = SMM_VARIABLE_BATCH_ENTRY_SIZE (Access->NameSize, Access->DataSize);
+    if (EntrySize > BatchSize - Offset) {
+      EntrySize = BatchSize - Offset;
+    }
+
+    //
+    // The VariableSpeculationBarrier() call here is to ensure the previous
+    // range/content checks for the CommBuffer have been completed before the
+    // subsequent consumption of the CommBuffer content.
+    //
+    VariableSpeculationBarrier ();
+    if ((Access->NameSize < sizeof (CHAR16)) || (Access->Name[Access->NameSize/sizeof (CHAR16) - 1] != L'\0')) {
+      //
+      // Make sure VariableName is A Null-terminated string.
+      //
+      Entry->ReturnStatus = EFI_ACCESS_DENIED;
+    } else if (Entry->Function == SMM_VARIABLE_FUNCTION_GET_VARIABLE) {
+      if (CompareGuid (&Access->Guid, &gAdvLoggerAccessGuid)) {
+        Entry->ReturnStatus = AdvLoggerAccessGetVariable (
+                                Access->Name,
+                                &Access->Guid,
+                                &Access->Attributes,
+                                &Access->DataSize,
+                                (UINT8 *)Access->Name + Access->NameSize
+                                );
+      } else {
+        Entry->ReturnStatus = VariableServiceGetVariable (
+                                Access->Name,
+                                &Access->Guid,
+                                &Access->Attributes,
+                                &Access->DataSize,
+                                (UINT8 *)Access->Name + Access->NameSize
+                                );
+      }
+    } else if (Entry->Function == SMM_VARIABLE_FUNCTION_SET_VARIABLE) {
+      if (CompareGuid (&Access->Guid, &gAdvLoggerAccessGuid)) {
+        Entry->ReturnStatus = EFI_ACCESS_DENIED;
+      } else {
+        Entry->ReturnStatus = VariableServiceSetVariable (
+                                Access->Name,
+                                &Access->Guid,
+                                Access->Attributes,
+                                Access->DataSize,
+                                (UINT8 *)Access->Name + Access->NameSize
+                                );
+      }
+    } else {
+      Entry->ReturnStatus = EFI_UNSUPPORTED;
+    }
+
+    Offset += EntrySize;
+  }
+
+  return EFI_SUCCESS;
+}
+
+// MU_CHANGE [END]
+
 /**
   Communication service SMI Handler entry.
 
@@ -970,25 +1075,30 @@ SmmVariableHandler (
       VariableCacheContext->HobFlushComplete                   = RuntimeVariableCacheContext->HobFlushComplete;
 
       // Set up the intial pending request since the RT cache needs to be in sync with SMM cache
-      VariableCacheContext->VariableRuntimeHobCache.PendingUpdateOffset = 0;
-      VariableCacheContext->VariableRuntimeHobCache.PendingUpdateLength = 0;
+      // MU_CHANGE [BEGIN] - Delta runtime cache synchronization
+      VariableCacheContext->VariableRuntimeHobCache.PendingUpdateCount = 0;
       if ((mVariableModuleGlobal->VariableGlobal.HobVariableBase > 0) &&
           (VariableCacheContext->VariableRuntimeHobCache.Store != NULL))
       {
-        VariableCache                                                     = (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase;
-        VariableCacheContext->VariableRuntimeHobCache.PendingUpdateLength = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
+        VariableCache                                                          = (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase;
+        VariableCacheContext->VariableRuntimeHobCache.PendingUpdateCount       = 1;
+        VariableCacheContext->VariableRuntimeHobCache.PendingUpdates[0].Offset = 0;
+        VariableCacheContext->VariableRuntimeHobCache.PendingUpdates[0].Length = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
         CopyGuid (&(VariableCacheContext->VariableRuntimeHobCache.Store->Signature), &(VariableCache->Signature));
       }
 
-      VariableCache                                                          = (VARIABLE_STORE_HEADER  *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
-      VariableCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset = 0;
-      VariableCacheContext->VariableRuntimeVolatileCache.PendingUpdateLength = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
+      VariableCache                                                               = (VARIABLE_STORE_HEADER  *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+      VariableCacheContext->VariableRuntimeVolatileCache.PendingUpdateCount       = 1;
+      VariableCacheContext->VariableRuntimeVolatileCache.PendingUpdates[0].Offset = 0;
+      VariableCacheContext->VariableRuntimeVolatileCache.PendingUpdates[0].Length = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
       CopyGuid (&(VariableCacheContext->VariableRuntimeVolatileCache.Store->Signature), &(VariableCache->Signature));
 
-      VariableCache                                                    = (VARIABLE_STORE_HEADER  *)(UINTN)mNvVariableCache;
-      VariableCacheContext->VariableRuntimeNvCache.PendingUpdateOffset = 0;
-      VariableCacheContext->VariableRuntimeNvCache.PendingUpdateLength = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
+      VariableCache                                                         = (VARIABLE_STORE_HEADER  *)(UINTN)mNvVariableCache;
+      VariableCacheContext->VariableRuntimeNvCache.PendingUpdateCount       = 1;
+      VariableCacheContext->VariableRuntimeNvCache.PendingUpdates[0].Offset = 0;
+      VariableCacheContext->VariableRuntimeNvCache.PendingUpdates[0].Length = (UINT32)((UINTN)GetEndPointer (VariableCache) - (UINTN)VariableCache);
       CopyGuid (&(VariableCacheContext->VariableRuntimeNvCache.Store->Signature), &(VariableCache->Signature));
+      // MU_CHANGE [END]
 
       *(VariableCacheContext->PendingUpdate)    = TRUE;
       *(VariableCacheContext->ReadLock)         = FALSE;
@@ -1023,6 +1133,22 @@ SmmVariableHandler (
       Status = EFI_SUCCESS;
       break;
 
+    // MU_CHANGE [BEGIN] - Batched variable access
+    case SMM_VARIABLE_FUNCTION_BATCH:
+      if (CommBufferPayloadSize < sizeof (SMM_VARIABLE_COMMUNICATE_BATCH)) {
+        DEBUG ((DEBUG_ERROR, "VariableBatch: SMM communication buffer size invalid!\n"));
+        return EFI_SUCCESS;
+      }
+
+      //
+      // Copy the input communicate buffer payload to pre-allocated SMM variable buffer payload.
+      //
+      CopyMem (mVariableBufferPayload, SmmVariableFunctionHeader->Data, CommBufferPayloadSize);
+      Status = SmmVariableBatch ((SMM_VARIABLE_COMMUNICATE_BATCH *)mVariableBufferPayload, CommBufferPayloadSize);
+      CopyMem (SmmVariableFunctionHeader->Data, mVariableBufferPayload, CommBufferPayloadSize);
+      break;
+    // MU_CHANGE [END]
+
     default:
       Status = EFI_UNSUPPORTED;
   }
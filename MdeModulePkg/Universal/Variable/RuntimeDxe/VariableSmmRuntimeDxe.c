@@ -25,6 +25,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/SmmVariable.h>
 #include <Protocol/VariableLock.h>
 #include <Protocol/VarCheck.h>
+#include <Protocol/VariableBatch.h>  // MU_CHANGE - Batched variable access
 
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
@@ -1271,6 +1272,312 @@ Done:
   return Status;
 }
 
+// MU_CHANGE [BEGIN] - Batched variable access
+
+/**
+  Check one entry of a variable batch and compute the sizes it takes in the
+  communicate buffer.
+
+  The data buffer of a get is trimmed to what fits in the communicate buffer,
+  as FindVariableInSmm () does; a set that does not fit is rejected.
+
+  @param[in]  Entry                  The batch entry.
+  @param[out] NameSize               Size of the variable name of the entry.
+  @param[out] DataSize               Size of the data sent with the entry.
+
+  @retval EFI_SUCCESS                The entry can be executed.
+  @retval EFI_NOT_FOUND              The entry gets a variable with an empty name.
+  @retval EFI_INVALID_PARAMETER      The entry is invalid or too large.
+
+**/
+STATIC
+EFI_STATUS
+VariableBatchCheckEntry (
+  IN  EDKII_VARIABLE_BATCH_ENTRY  *Entry,
+  OUT UINTN                       *NameSize,
+  OUT UINTN                       *DataSize
+  )
+{
+  UINTN  Limit;
+
+  if ((Entry->VariableName == NULL) || (Entry->VendorGuid == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Entry->Operation == EdkiiVariableBatchGetVariable) {
+    if (Entry->VariableName[0] == 0) {
+      return EFI_NOT_FOUND;
+    }
+  } else if (Entry->Operation == EdkiiVariableBatchSetVariable) {
+    if ((Entry->VariableName[0] == 0) || ((Entry->DataSize != 0) && (Entry->Data == NULL))) {
+      return EFI_INVALID_PARAMETER;
+    }
+  } else {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Space left for the name and data of a single entry in the payload.
+  //
+  Limit = (mVariableBufferPayloadSize - sizeof (SMM_VARIABLE_COMMUNICATE_BATCH)) & ~(sizeof (UINTN) - 1);
+  if (Limit <= SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Limit    -= SMM_VARIABLE_BATCH_ENTRY_HEADER_SIZE;
+  *NameSize = StrSize (Entry->VariableName);
+  if (*NameSize > Limit) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *DataSize = Entry->DataSize;
+  if (*DataSize > Limit - *NameSize) {
+    if (Entry->Operation == EdkiiVariableBatchSetVariable) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    *DataSize = Limit - *NameSize;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Check whether a batch entry is served from the runtime variable cache
+  instead of being sent to SMM.
+
+  @param[in]  Entry   A valid batch entry.
+
+  @retval TRUE        The entry is served from the runtime cache.
+  @retval FALSE       The entry is sent to SMM.
+
+**/
+STATIC
+BOOLEAN
+VariableBatchIsCached (
+  IN EDKII_VARIABLE_BATCH_ENTRY  *Entry
+  )
+{
+  return (BOOLEAN)(FeaturePcdGet (PcdEnableVariableRuntimeCache) &&
+                   (Entry->Operation == EdkiiVariableBatchGetVariable) &&
+                   !CompareGuid (Entry->VendorGuid, &gAdvLoggerAccessGuid));
+}
+
+/**
+  Send a range of batch entries to SMM in a single communication and copy
+  the results back.
+
+  Entries of the range that are not valid are skipped, all the others are
+  sent to SMM.
+
+  @param[in, out] Entries       The batch entries to send.
+  @param[in]      EntryCount    Number of entries in Entries.
+  @param[in]      SendCount     Number of entries of the range sent to SMM.
+  @param[in]      PayloadSize   Size of the batch payload.
+
+**/
+STATIC
+VOID
+VariableBatchSend (
+  IN OUT EDKII_VARIABLE_BATCH_ENTRY  *Entries,
+  IN     UINTN                       EntryCount,
+  IN     UINTN                       SendCount,
+  IN     UINTN                       PayloadSize
+  )
+{
+  EFI_STATUS                                Status;
+  SMM_VARIABLE_COMMUNICATE_BATCH            *Batch;
+  SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY      *SmmEntry;
+  SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE  *Access;
+  UINTN                                     Index;
+  UINTN                                     Offset;
+  UINTN                                     NameSize;
+  UINTN                                     DataSize;
+
+  Batch  = NULL;
+  Status = InitCommunicateBuffer ((VOID **)&Batch, PayloadSize, SMM_VARIABLE_FUNCTION_BATCH);
+  if (!EFI_ERROR (Status)) {
+    ASSERT (Batch != NULL);
+
+    Batch->EntryCount = SendCount;
+    Offset            = sizeof (SMM_VARIABLE_COMMUNICATE_BATCH);
+    for (Index = 0; Index < EntryCount; Index++) {
+      if (EFI_ERROR (VariableBatchCheckEntry (&Entries[Index], &NameSize, &DataSize))) {
+        continue;
+      }
+
+      SmmEntry = (SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY *)((UINT8 *)Batch + Offset);
+      Access   = &SmmEntry->Access;
+      CopyGuid (&Access->Guid, Entries[Index].VendorGuid);
+      Access->NameSize = NameSize;
+      Access->DataSize = DataSize;
+      CopyMem (Access->Name, Entries[Index].VariableName, NameSize);
+      if (Entries[Index].Operation == EdkiiVariableBatchSetVariable) {
+        SmmEntry->Function = SMM_VARIABLE_FUNCTION_SET_VARIABLE;
+        Access->Attributes = Entries[Index].Attributes;
+        CopyMem ((UINT8 *)Access->Name + NameSize, Entries[Index].Data, DataSize);
+      } else {
+        SmmEntry->Function = SMM_VARIABLE_FUNCTION_GET_VARIABLE;
+        Access->Attributes = 0;
+      }
+
+      SmmEntry->ReturnStatus = EFI_NOT_READY;
+      Offset                += SMM_VARIABLE_BATCH_ENTRY_SIZE (NameSize, DataSize);
+    }
+
+    ASSERT (Offset == PayloadSize);
+
+    //
+    // Send data to SMM.
+    //
+    Status = SendCommunicateBuffer (PayloadSize);
+  }
+
+  Offset = sizeof (SMM_VARIABLE_COMMUNICATE_BATCH);
+  for (Index = 0; Index < EntryCount; Index++) {
+    if (EFI_ERROR (VariableBatchCheckEntry (&Entries[Index], &NameSize, &DataSize))) {
+      continue;
+    }
+
+    if (EFI_ERROR (Status)) {
+      Entries[Index].Status = Status;
+      continue;
+    }
+
+    SmmEntry = (SMM_VARIABLE_COMMUNICATE_BATCH_ENTRY *)((UINT8 *)Batch + Offset);
+    Access   = &SmmEntry->Access;
+    Offset  += SMM_VARIABLE_BATCH_ENTRY_SIZE (NameSize, DataSize);
+
+    Entries[Index].Status = SmmEntry->ReturnStatus;
+    if (Entries[Index].Operation != EdkiiVariableBatchGetVariable) {
+      continue;
+    }
+
+    if ((SmmEntry->ReturnStatus == EFI_SUCCESS) || (SmmEntry->ReturnStatus == EFI_BUFFER_TOO_SMALL)) {
+      //
+      // Get data from SMM.
+      //
+      Entries[Index].DataSize   = Access->DataSize;
+      Entries[Index].Attributes = Access->Attributes;
+    }
+
+    if (SmmEntry->ReturnStatus == EFI_SUCCESS) {
+      if (Entries[Index].Data != NULL) {
+        CopyMem (Entries[Index].Data, (UINT8 *)Access->Name + NameSize, Access->DataSize);
+      } else {
+        Entries[Index].Status = EFI_INVALID_PARAMETER;
+      }
+    }
+  }
+}
+
+/**
+  Execute a sequence of GetVariable () and SetVariable () operations.
+
+  The operations are packed into as few SMM communications as the
+  communicate buffer allows. Gets served by the runtime variable cache do not
+  enter SMM, but the operations are still executed in order.
+
+  @param[in]      This          The EDKII_VARIABLE_BATCH_PROTOCOL instance.
+  @param[in]      EntryCount    Number of entries in Entries.
+  @param[in, out] Entries       The operations to execute.
+
+  @retval EFI_SUCCESS           All the operations have been executed, the status
+                                of each one is in its Status field.
+  @retval EFI_INVALID_PARAMETER Entries is NULL and EntryCount is not 0.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+VariableBatchExecute (
+  IN     EDKII_VARIABLE_BATCH_PROTOCOL  *This,
+  IN     UINTN                          EntryCount,
+  IN OUT EDKII_VARIABLE_BATCH_ENTRY     *Entries
+  )
+{
+  EFI_STATUS                  Status;
+  EDKII_VARIABLE_BATCH_ENTRY  *Entry;
+  UINTN                       First;
+  UINTN                       Index;
+  UINTN                       SendCount;
+  UINTN                       PayloadSize;
+  UINTN                       NameSize;
+  UINTN                       DataSize;
+  UINTN                       EntrySize;
+
+  if ((Entries == NULL) && (EntryCount != 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  AcquireLockOnlyAtBootTime (&mVariableServicesLock);
+
+  Index = 0;
+  while (Index < EntryCount) {
+    //
+    // Collect the entries that fit in one communication. A cached get ends the
+    // collection so that it runs after the entries queued before it.
+    //
+    First       = Index;
+    SendCount   = 0;
+    PayloadSize = sizeof (SMM_VARIABLE_COMMUNICATE_BATCH);
+    for ( ; Index < EntryCount; Index++) {
+      Entry  = &Entries[Index];
+      Status = VariableBatchCheckEntry (Entry, &NameSize, &DataSize);
+      if (EFI_ERROR (Status)) {
+        Entry->Status = Status;
+        continue;
+      }
+
+      if (VariableBatchIsCached (Entry)) {
+        if (SendCount != 0) {
+          break;
+        }
+
+        Entry->Status = FindVariableInRuntimeCache (
+                          Entry->VariableName,
+                          Entry->VendorGuid,
+                          &Entry->Attributes,
+                          &Entry->DataSize,
+                          Entry->Data
+                          );
+        First = Index + 1;
+        continue;
+      }
+
+      EntrySize = SMM_VARIABLE_BATCH_ENTRY_SIZE (NameSize, DataSize);
+      if (EntrySize > mVariableBufferPayloadSize - PayloadSize) {
+        break;
+      }
+
+      PayloadSize += EntrySize;
+      SendCount++;
+    }
+
+    if (SendCount != 0) {
+      VariableBatchSend (&Entries[First], Index - First, SendCount, PayloadSize);
+    }
+  }
+
+  ReleaseLockOnlyAtBootTime (&mVariableServicesLock);
+
+  if (!EfiAtRuntime ()) {
+    for (Index = 0; Index < EntryCount; Index++) {
+      if ((Entries[Index].Operation == EdkiiVariableBatchSetVariable) && !EFI_ERROR (Entries[Index].Status)) {
+        SecureBootHook (Entries[Index].VariableName, Entries[Index].VendorGuid);
+      }
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+EDKII_VARIABLE_BATCH_PROTOCOL  mVariableBatch = {
+  VariableBatchExecute
+};
+
+// MU_CHANGE [END]
+
 /**
   Exit Boot Services Event notification handler.
 
@@ -1732,6 +2039,16 @@ SmmVariableReady (
                                                      );
   ASSERT_EFI_ERROR (Status);
 
+  // MU_CHANGE [BEGIN] - Batched variable access
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &mHandle,
+                  &gEdkiiVariableBatchProtocolGuid,
+                  &mVariableBatch,
+                  NULL
+                  );
+  ASSERT_EFI_ERROR (Status);
+  // MU_CHANGE [END]
+
   gBS->CloseEvent (Event);
 }
 
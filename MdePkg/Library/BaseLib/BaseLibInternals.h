@@ -850,6 +850,103 @@ InternalX86RdRand64  (
   OUT     UINT64  *Rand
   );
 
+// MU_CHANGE [BEGIN] - Hardware accelerated CRC32
+ #if defined (MDE_CPU_X64)
+
+  #include <Register/Intel/Cpuid.h>
+
+/**
+  Return the ECX value of the CPUID version information leaf, which reports
+  the CPU features used by the CRC32 and CRC32c paths.
+
+  @return The ECX value of CPUID leaf CPUID_VERSION_INFO.
+**/
+CPUID_VERSION_INFO_ECX
+EFIAPI
+InternalX64CrcFeatures (
+  VOID
+  );
+
+/**
+  Update a CRC32 register with the bytes of a buffer, using the PCLMULQDQ
+  instruction when the CPU supports it.
+
+  Only the multiples of 16 bytes at the start of the buffer are processed,
+  Buffer and Length are updated to the bytes left for the caller.
+
+  @param[in]      Crc     The CRC register, without the final XOR.
+  @param[in, out] Buffer  A pointer to the buffer.
+  @param[in, out] Length  The number of bytes in the buffer.
+
+  @return The updated CRC register.
+**/
+UINT32
+EFIAPI
+InternalX64Crc32 (
+  IN     UINT32       Crc,
+  IN OUT CONST UINT8  **Buffer,
+  IN OUT UINTN        *Length
+  );
+
+/**
+  Update a CRC32c register with the bytes of a buffer, using the SSE4.2 CRC32
+  instruction when the CPU supports it.
+
+  Buffer and Length are updated to the bytes left for the caller, none if the
+  CPU supports the instruction.
+
+  @param[in]      Crc     The CRC register, without the final XOR.
+  @param[in, out] Buffer  A pointer to the buffer.
+  @param[in, out] Length  The number of bytes in the buffer.
+
+  @return The updated CRC register.
+**/
+UINT32
+EFIAPI
+InternalX64Crc32c (
+  IN     UINT32       Crc,
+  IN OUT CONST UINT8  **Buffer,
+  IN OUT UINTN        *Length
+  );
+
+/**
+  Update a CRC32 register by folding the buffer with PCLMULQDQ.
+
+  @param[in]  Buffer  A pointer to the buffer.
+  @param[in]  Length  The number of bytes in the buffer, a multiple of 16 of
+                      at least 64.
+  @param[in]  Crc     The CRC register, without the final XOR.
+
+  @return The updated CRC register.
+**/
+UINT32
+EFIAPI
+InternalX64Crc32Pclmul (
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Length,
+  IN UINT32       Crc
+  );
+
+/**
+  Update a CRC32c register with the SSE4.2 CRC32 instruction.
+
+  @param[in]  Buffer  A pointer to the buffer.
+  @param[in]  Length  The number of bytes in the buffer.
+  @param[in]  Crc     The CRC register, without the final XOR.
+
+  @return The updated CRC register.
+**/
+UINT32
+EFIAPI
+InternalX64Crc32cSse42 (
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Length,
+  IN UINT32       Crc
+  );
+
+ #endif
+// MU_CHANGE [END]
+
 #else
 
 #endif
@@ -0,0 +1,97 @@
+/** @file
+  CRC32 and CRC32c computation with the CRC instructions of x64 CPUs.
+
+  These paths are only used when PcdCrcAccelerationEnable is TRUE. The CPU
+  features come from InternalX64CrcFeatures (), buffers shorter than
+  CRC_X64_MIN_LENGTH are left to the table driven implementation.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "BaseLibInternals.h"
+
+#define CRC_X64_MIN_LENGTH  256
+
+/**
+  Update a CRC32 register with the bytes of a buffer, using the PCLMULQDQ
+  instruction when the CPU supports it.
+
+  Only the multiples of 16 bytes at the start of the buffer are processed,
+  Buffer and Length are updated to the bytes left for the caller.
+
+  @param[in]      Crc     The CRC register, without the final XOR.
+  @param[in, out] Buffer  A pointer to the buffer.
+  @param[in, out] Length  The number of bytes in the buffer.
+
+  @return The updated CRC register.
+**/
+UINT32
+EFIAPI
+InternalX64Crc32 (
+  IN     UINT32       Crc,
+  IN OUT CONST UINT8  **Buffer,
+  IN OUT UINTN        *Length
+  )
+{
+  CPUID_VERSION_INFO_ECX  VersionInfoEcx;
+  UINTN                   Size;
+
+  if (*Length < CRC_X64_MIN_LENGTH) {
+    return Crc;
+  }
+
+  VersionInfoEcx = InternalX64CrcFeatures ();
+  if ((VersionInfoEcx.Bits.PCLMULQDQ == 0) || (VersionInfoEcx.Bits.SSE4_1 == 0)) {
+    return Crc;
+  }
+
+  Size     = *Length & ~(UINTN)0xF;
+  Crc      = InternalX64Crc32Pclmul (*Buffer, Size, Crc);
+  *Buffer += Size;
+  *Length -= Size;
+  return Crc;
+}
+
+/**
+  Update a CRC32c register with the bytes of a buffer, using the SSE4.2 CRC32
+  instruction when the CPU supports it.
+
+  Buffer and Length are updated to the bytes left for the caller, none if the
+  CPU supports the instruction.
+
+  @param[in]      Crc     The CRC register, without the final XOR.
+  @param[in, out] Buffer  A pointer to the buffer.
+  @param[in, out] Length  The number of bytes in the buffer.
+
+  @return The updated CRC register.
+**/
+UINT32
+EFIAPI
+InternalX64Crc32c (
+  IN     UINT32       Crc,
+  IN OUT CONST UINT8  **Buffer,
+  IN OUT UINTN        *Length
+  )
+{
+  CPUID_VERSION_INFO_ECX  VersionInfoEcx;
+  UINT32                  Result;
+
+  if (*Length < CRC_X64_MIN_LENGTH) {
+    return Crc;
+  }
+
+  VersionInfoEcx = InternalX64CrcFeatures ();
+  if (VersionInfoEcx.Bits.SSE4_2 == 0) {
+    return Crc;
+  }
+
+  //
+  // The CRC32 instruction also handles the tail of the buffer.
+  //
+  Result   = InternalX64Crc32cSse42 (*Buffer, *Length, Crc);
+  *Buffer += *Length;
+  *Length  = 0;
+  return Result;
+}
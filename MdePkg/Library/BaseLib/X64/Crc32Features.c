@@ -0,0 +1,35 @@
+/** @file
+  CPU features of the CRC32 and CRC32c paths, cached after the first CPUID.
+
+  This requires writable global data, PcdCrcAccelerationEnable must only be
+  enabled for modules that run from memory.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "BaseLibInternals.h"
+
+GLOBAL_REMOVE_IF_UNREFERENCED BOOLEAN                 mCrcX64FeaturesKnown = FALSE;
+GLOBAL_REMOVE_IF_UNREFERENCED CPUID_VERSION_INFO_ECX  mCrcX64Features;
+
+/**
+  Return the ECX value of the CPUID version information leaf, which reports
+  the CPU features used by the CRC32 and CRC32c paths.
+
+  @return The ECX value of CPUID leaf CPUID_VERSION_INFO.
+**/
+CPUID_VERSION_INFO_ECX
+EFIAPI
+InternalX64CrcFeatures (
+  VOID
+  )
+{
+  if (!mCrcX64FeaturesKnown) {
+    AsmCpuid (CPUID_VERSION_INFO, NULL, NULL, &mCrcX64Features.Uint32, NULL);
+    mCrcX64FeaturesKnown = TRUE;
+  }
+
+  return mCrcX64Features;
+}
@@ -0,0 +1,30 @@
+/** @file
+  CPU features of the CRC32 and CRC32c paths for host based unit tests.
+
+  CPUID is executed on every call, so that a test can select the hardware or
+  the table driven paths through the CPUID hook of the host BaseLib.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "BaseLibInternals.h"
+
+/**
+  Return the ECX value of the CPUID version information leaf, which reports
+  the CPU features used by the CRC32 and CRC32c paths.
+
+  @return The ECX value of CPUID leaf CPUID_VERSION_INFO.
+**/
+CPUID_VERSION_INFO_ECX
+EFIAPI
+InternalX64CrcFeatures (
+  VOID
+  )
+{
+  CPUID_VERSION_INFO_ECX  VersionInfoEcx;
+
+  AsmCpuid (CPUID_VERSION_INFO, NULL, NULL, &VersionInfoEcx.Uint32, NULL);
+  return VersionInfoEcx;
+}
@@ -0,0 +1,465 @@
+/** @file
+  Unit tests and benchmark of the CRC32 and CRC32c APIs in BaseLib.
+
+  The results of CalculateCrc32 () and CalculateCrc32c () are compared bit for
+  bit with a bitwise reference implementation, over all the alignments and
+  the lengths around the thresholds of the slice-by-8 and hardware paths.
+  The hardware paths are selected by reporting the CPU features through the
+  CPUID hook of the host BaseLib, they require an x64 host with SSE4.2 and
+  PCLMULQDQ. The DSC enables PcdCrcAccelerationEnable for this test.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <time.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UnitTestLib.h>
+#include <Library/UnitTestHostBaseLib.h>
+
+#include <Register/Intel/Cpuid.h>
+
+#define UNIT_TEST_APP_NAME     "BaseLib CRC Unit Test Application"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define CRC_TEST_BUFFER_SIZE     (SIZE_4KB + 64)
+#define CRC_TEST_MAX_OFFSET      16
+#define CRC_TEST_MAX_LENGTH      640
+#define CRC_BENCHMARK_SIZE       SIZE_1MB
+#define CRC_BENCHMARK_LOOPS      64
+#define CRC32_POLYNOMIAL         0xEDB88320
+#define CRC32C_POLYNOMIAL        0x82F63B78
+#define CRC32_CHECK_VALUE        0xCBF43926
+#define CRC32C_CHECK_VALUE       0xE3069283
+#define CRC_TEST_CHECK_STRING    "123456789"
+
+typedef struct {
+  BOOLEAN    Hardware;
+} CRC_TEST_CONTEXT;
+
+STATIC CRC_TEST_CONTEXT  mTableContext    = { FALSE };
+STATIC CRC_TEST_CONTEXT  mHardwareContext = { TRUE };
+
+STATIC UNIT_TEST_HOST_BASE_LIB_ASM_CPUID  mOriginalAsmCpuid;
+STATIC UINT8                              *mBuffer;
+
+/**
+  CPUID hook reporting SSE4.1, SSE4.2 and PCLMULQDQ.
+
+  @param  Index  The 32-bit value to load into EAX prior to invoking the CPUID
+                 instruction.
+  @param  Eax    The pointer to the 32-bit EAX value returned by the CPUID
+                 instruction. This is an optional parameter that may be NULL.
+  @param  Ebx    The pointer to the 32-bit EBX value returned by the CPUID
+                 instruction. This is an optional parameter that may be NULL.
+  @param  Ecx    The pointer to the 32-bit ECX value returned by the CPUID
+                 instruction. This is an optional parameter that may be NULL.
+  @param  Edx    The pointer to the 32-bit EDX value returned by the CPUID
+                 instruction. This is an optional parameter that may be NULL.
+
+  @return Index.
+**/
+STATIC
+UINT32
+EFIAPI
+CrcTestAsmCpuid (
+  IN      UINT32  Index,
+  OUT     UINT32  *Eax   OPTIONAL,
+  OUT     UINT32  *Ebx   OPTIONAL,
+  OUT     UINT32  *Ecx   OPTIONAL,
+  OUT     UINT32  *Edx   OPTIONAL
+  )
+{
+  CPUID_VERSION_INFO_ECX  VersionInfoEcx;
+
+  mOriginalAsmCpuid (Index, Eax, Ebx, Ecx, Edx);
+  if ((Index == CPUID_VERSION_INFO) && (Ecx != NULL)) {
+    VersionInfoEcx.Uint32         = *Ecx;
+    VersionInfoEcx.Bits.PCLMULQDQ = 1;
+    VersionInfoEcx.Bits.SSE4_1    = 1;
+    VersionInfoEcx.Bits.SSE4_2    = 1;
+    *Ecx                          = VersionInfoEcx.Uint32;
+  }
+
+  return Index;
+}
+
+/**
+  Select the hardware or the table driven paths of BaseLib.
+
+  @param[in]  Hardware  TRUE to report the CPU features of the hardware paths.
+**/
+STATIC
+VOID
+CrcTestSelectPath (
+  IN BOOLEAN  Hardware
+  )
+{
+  if (mOriginalAsmCpuid == NULL) {
+    mOriginalAsmCpuid = gUnitTestHostBaseLib.X86->AsmCpuid;
+  }
+
+  gUnitTestHostBaseLib.X86->AsmCpuid = Hardware ? CrcTestAsmCpuid : mOriginalAsmCpuid;
+}
+
+/**
+  Bitwise reference implementation of a reflected 32-bit CRC.
+
+  @param[in]  Polynomial    The reflected polynomial.
+  @param[in]  Buffer        A pointer to the buffer.
+  @param[in]  Length        The number of bytes in the buffer.
+  @param[in]  InitialValue  The CRC of the preceding data.
+
+  @return The CRC of the preceding data and the buffer.
+**/
+STATIC
+UINT32
+ReferenceCrc (
+  IN UINT32       Polynomial,
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Length,
+  IN UINT32       InitialValue
+  )
+{
+  UINT32  Crc;
+  UINTN   Bit;
+
+  Crc = ~InitialValue;
+  while (Length-- != 0) {
+    Crc ^= *(Buffer++);
+    for (Bit = 0; Bit < 8; Bit++) {
+      Crc = (Crc >> 1) ^ ((Crc & 1) != 0 ? Polynomial : 0);
+    }
+  }
+
+  return ~Crc;
+}
+
+/**
+  Fill the test buffer with pseudo random data.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The buffer is ready.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+CrcTestSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN   Index;
+  UINT32  Seed;
+
+  if (mBuffer == NULL) {
+    mBuffer = AllocatePool (CRC_BENCHMARK_SIZE);
+    UT_ASSERT_NOT_NULL (mBuffer);
+  }
+
+  Seed = 0x12345678;
+  for (Index = 0; Index < CRC_BENCHMARK_SIZE; Index++) {
+    Seed           = Seed * 1103515245 + 12345;
+    mBuffer[Index] = (UINT8)(Seed >> 16);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Restore the table driven paths.
+
+  @param[in]  Context  Unused.
+**/
+STATIC
+VOID
+EFIAPI
+CrcTestCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CrcTestSelectPath (FALSE);
+}
+
+/**
+  Check the CRC32 and CRC32c of the standard check string.
+
+  @param[in]  Context  The CRC_TEST_CONTEXT of the test.
+
+  @retval UNIT_TEST_PASSED  The CRCs are the expected ones.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+CrcCheckValueTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CRC_TEST_CONTEXT  *TestContext;
+  UINTN             Length;
+
+  TestContext = (CRC_TEST_CONTEXT *)Context;
+  CrcTestSelectPath (TestContext->Hardware);
+
+  Length = AsciiStrLen (CRC_TEST_CHECK_STRING);
+  UT_ASSERT_EQUAL (CalculateCrc32 (CRC_TEST_CHECK_STRING, Length), CRC32_CHECK_VALUE);
+  UT_ASSERT_EQUAL (CalculateCrc32c (CRC_TEST_CHECK_STRING, Length, 0), CRC32C_CHECK_VALUE);
+  UT_ASSERT_EQUAL (CalculateCrc32 (mBuffer, 0), 0);
+  UT_ASSERT_EQUAL (CalculateCrc32c (mBuffer, 0, 0), 0);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Compare the CRC32 and CRC32c with the reference implementation, for all the
+  alignments and lengths up to CRC_TEST_MAX_LENGTH, and for page sized
+  buffers.
+
+  @param[in]  Context  The CRC_TEST_CONTEXT of the test.
+
+  @retval UNIT_TEST_PASSED  The CRCs are bit-exact.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+CrcBitExactTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CRC_TEST_CONTEXT  *TestContext;
+  UINTN             Offset;
+  UINTN             Length;
+  UINT32            InitialValue;
+
+  TestContext = (CRC_TEST_CONTEXT *)Context;
+  CrcTestSelectPath (TestContext->Hardware);
+
+  for (Offset = 0; Offset < CRC_TEST_MAX_OFFSET; Offset++) {
+    for (Length = 0; Length <= CRC_TEST_MAX_LENGTH; Length++) {
+      InitialValue = (UINT32)(Length * 0x9E3779B9);
+      UT_ASSERT_EQUAL (
+        CalculateCrc32 (mBuffer + Offset, Length),
+        ReferenceCrc (CRC32_POLYNOMIAL, mBuffer + Offset, Length, 0)
+        );
+      UT_ASSERT_EQUAL (
+        CalculateCrc32c (mBuffer + Offset, Length, InitialValue),
+        ReferenceCrc (CRC32C_POLYNOMIAL, mBuffer + Offset, Length, InitialValue)
+        );
+    }
+
+    for (Length = CRC_TEST_BUFFER_SIZE - 64; Length <= CRC_TEST_BUFFER_SIZE - CRC_TEST_MAX_OFFSET; Length++) {
+      UT_ASSERT_EQUAL (
+        CalculateCrc32 (mBuffer + Offset, Length),
+        ReferenceCrc (CRC32_POLYNOMIAL, mBuffer + Offset, Length, 0)
+        );
+      UT_ASSERT_EQUAL (
+        CalculateCrc32c (mBuffer + Offset, Length, 0),
+        ReferenceCrc (CRC32C_POLYNOMIAL, mBuffer + Offset, Length, 0)
+        );
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Check that a CRC32c computed in pieces, passing the CRC of the previous
+  pieces as the initial value, is the CRC32c of the whole buffer.
+
+  @param[in]  Context  The CRC_TEST_CONTEXT of the test.
+
+  @retval UNIT_TEST_PASSED  The CRCs match.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+Crc32cChainingTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CRC_TEST_CONTEXT  *TestContext;
+  UINT32            Whole;
+  UINT32            Crc;
+  UINTN             Split;
+
+  TestContext = (CRC_TEST_CONTEXT *)Context;
+  CrcTestSelectPath (TestContext->Hardware);
+
+  Whole = CalculateCrc32c (mBuffer, CRC_TEST_BUFFER_SIZE, 0);
+  for (Split = 0; Split <= CRC_TEST_BUFFER_SIZE; Split += 131) {
+    Crc = CalculateCrc32c (mBuffer, Split, 0);
+    Crc = CalculateCrc32c (mBuffer + Split, CRC_TEST_BUFFER_SIZE - Split, Crc);
+    UT_ASSERT_EQUAL (Crc, Whole);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Report the throughput of the CRC32 and CRC32c implementations.
+
+  @param[in]  Name       The name of the implementation.
+  @param[in]  Crc32c     TRUE to measure CRC32c, FALSE for CRC32.
+  @param[in]  Reference  TRUE to measure the bitwise reference implementation.
+
+  @return The CRC of the benchmark buffer.
+**/
+STATIC
+UINT32
+CrcBenchmark (
+  IN CONST CHAR8  *Name,
+  IN BOOLEAN      Crc32c,
+  IN BOOLEAN      Reference
+  )
+{
+  clock_t  Start;
+  double   Seconds;
+  UINTN    Loops;
+  UINTN    Loop;
+  UINT32   Crc;
+
+  Loops = Reference ? 1 : CRC_BENCHMARK_LOOPS;
+  Crc   = 0;
+  Start = clock ();
+  for (Loop = 0; Loop < Loops; Loop++) {
+    if (Reference) {
+      Crc = ReferenceCrc (Crc32c ? CRC32C_POLYNOMIAL : CRC32_POLYNOMIAL, mBuffer, CRC_BENCHMARK_SIZE, 0);
+    } else if (Crc32c) {
+      Crc = CalculateCrc32c (mBuffer, CRC_BENCHMARK_SIZE, 0);
+    } else {
+      Crc = CalculateCrc32 (mBuffer, CRC_BENCHMARK_SIZE);
+    }
+  }
+
+  Seconds = (double)(clock () - Start) / CLOCKS_PER_SEC;
+  if (Seconds > 0) {
+    printf (
+      "  %-8s %-10s %8.1f MB/s\n",
+      Crc32c ? "CRC32c" : "CRC32",
+      Name,
+      (double)Loops * CRC_BENCHMARK_SIZE / Seconds / 1000000
+      );
+  }
+
+  return Crc;
+}
+
+/**
+  Measure the throughput of the bitwise reference, table driven and hardware
+  implementations, and check that they agree.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The implementations agree.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+CrcBenchmarkTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT32   Expected;
+  UINTN    Index;
+  BOOLEAN  Crc32c;
+
+  for (Index = 0; Index < 2; Index++) {
+    Crc32c   = (BOOLEAN)(Index == 1);
+    Expected = CrcBenchmark ("bitwise", Crc32c, TRUE);
+
+    CrcTestSelectPath (FALSE);
+    UT_ASSERT_EQUAL (CrcBenchmark ("table", Crc32c, FALSE), Expected);
+
+    CrcTestSelectPath (TRUE);
+    UT_ASSERT_EQUAL (CrcBenchmark ("hardware", Crc32c, FALSE), Expected);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the CRC APIs
+  of BaseLib and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Fw;
+  UNIT_TEST_SUITE_HANDLE      CrcTests;
+
+  Fw = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Fw, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Populate the CRC Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&CrcTests, Fw, "CRC32 and CRC32c", "BaseLib.Crc", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for CrcTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  // --------------Suite-----Description------------------------------Class Name------------Function-------------Pre-----------Post------------Context-----------
+  AddTestCase (CrcTests, "Check values, table driven", "CheckValueTable", CrcCheckValueTest, CrcTestSetup, CrcTestCleanup, &mTableContext);
+  AddTestCase (CrcTests, "Bit-exact results, table driven", "BitExactTable", CrcBitExactTest, CrcTestSetup, CrcTestCleanup, &mTableContext);
+  AddTestCase (CrcTests, "CRC32c chaining, table driven", "ChainingTable", Crc32cChainingTest, CrcTestSetup, CrcTestCleanup, &mTableContext);
+  AddTestCase (CrcTests, "Check values, hardware", "CheckValueHardware", CrcCheckValueTest, CrcTestSetup, CrcTestCleanup, &mHardwareContext);
+  AddTestCase (CrcTests, "Bit-exact results, hardware", "BitExactHardware", CrcBitExactTest, CrcTestSetup, CrcTestCleanup, &mHardwareContext);
+  AddTestCase (CrcTests, "CRC32c chaining, hardware", "ChainingHardware", Crc32cChainingTest, CrcTestSetup, CrcTestCleanup, &mHardwareContext);
+  AddTestCase (CrcTests, "Throughput", "Benchmark", CrcBenchmarkTest, CrcTestSetup, CrcTestCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Fw);
+
+EXIT:
+  if (Fw) {
+    FreeUnitTestFramework (Fw);
+  }
+
+  if (mBuffer != NULL) {
+    FreePool (mBuffer);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -1074,7 +1074,7 @@ HttpConfigureTcp4 (
   IP4_COPY_ADDRESS (&Tcp4AP->RemoteAddress, &HttpInstance->RemoteAddr);
 
   Tcp4Option                      = Tcp4CfgData->ControlOption;
-  Tcp4Option->ReceiveBufferSize   = HTTP_BUFFER_SIZE_DEAULT;
+  Tcp4Option->ReceiveBufferSize   = 0;  // MU_CHANGE - Use the default receive buffer of the TCP driver
   Tcp4Option->SendBufferSize      = HTTP_BUFFER_SIZE_DEAULT;
   Tcp4Option->MaxSynBackLog       = HTTP_MAX_SYN_BACK_LOG;
   Tcp4Option->ConnectionTimeout   = HTTP_CONNECTION_TIMEOUT;
@@ -1085,6 +1085,7 @@ HttpConfigureTcp4 (
   Tcp4Option->KeepAliveInterval   = HTTP_KEEP_ALIVE_INTERVAL;
   Tcp4Option->EnableNagle         = TRUE;
   Tcp4Option->EnableWindowScaling = TRUE;
+  Tcp4Option->EnableSelectiveAck  = TRUE;  // MU_CHANGE - Recover from losses with selective acknowledgment
   Tcp4CfgData->ControlOption      = Tcp4Option;
 
   if ((HttpInstance->State == HTTP_STATE_TCP_CONNECTED) ||
@@ -1158,7 +1159,7 @@ HttpConfigureTcp6 (
   IP6_COPY_ADDRESS (&Tcp6Ap->RemoteAddress, &HttpInstance->RemoteIpv6Addr);
 
   Tcp6Option                      = Tcp6CfgData->ControlOption;
-  Tcp6Option->ReceiveBufferSize   = HTTP_BUFFER_SIZE_DEAULT;
+  Tcp6Option->ReceiveBufferSize   = 0;  // MU_CHANGE - Use the default receive buffer of the TCP driver
   Tcp6Option->SendBufferSize      = HTTP_BUFFER_SIZE_DEAULT;
   Tcp6Option->MaxSynBackLog       = HTTP_MAX_SYN_BACK_LOG;
   Tcp6Option->ConnectionTimeout   = HTTP_CONNECTION_TIMEOUT;
@@ -1169,6 +1170,7 @@ HttpConfigureTcp6 (
   Tcp6Option->KeepAliveInterval   = HTTP_KEEP_ALIVE_INTERVAL;
   Tcp6Option->EnableNagle         = TRUE;
   Tcp6Option->EnableWindowScaling = TRUE;
+  Tcp6Option->EnableSelectiveAck  = TRUE;  // MU_CHANGE - Recover from losses with selective acknowledgment
 
   if ((HttpInstance->State == HTTP_STATE_TCP_CONNECTED) ||
       (HttpInstance->State == HTTP_STATE_TCP_CLOSED))
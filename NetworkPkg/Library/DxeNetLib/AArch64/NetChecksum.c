@@ -0,0 +1,40 @@
+/** @file
+  Internet checksum computation with the Advanced SIMD instructions of
+  AArch64 CPUs.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Library/BaseLib.h>
+
+#include "../NetChecksum.h"
+
+/**
+  Compute the checksum for a bulk of data with NEON instructions.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The computed checksum.
+
+**/
+UINT16
+EFIAPI
+NetblockChecksumNeon (
+  IN UINT8   *Bulk,
+  IN UINT32  Len
+  )
+{
+  UINT64  Sum;
+  UINT32  Size;
+
+  Sum  = 0;
+  Size = Len & ~(UINT32)(NET_CHECKSUM_BLOCK_SIZE - 1);
+  if (Size != 0) {
+    Sum = InternalNetChecksumNeon (Bulk, Size);
+  }
+
+  return NetChecksumFold (Sum + NetChecksumSum64 (Bulk + Size, Len - Size));
+}
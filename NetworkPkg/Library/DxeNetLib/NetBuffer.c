@@ -14,6 +14,15 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/MemoryAllocationLib.h>
 
+// MU_CHANGE [BEGIN] - Vectorized Internet checksum
+#include "NetChecksum.h"
+
+//
+// The checksum implementation used by NetblockChecksum ().
+//
+NET_BLOCK_CHECKSUM  mNetblockChecksum = NULL;
+// MU_CHANGE [END] - Vectorized Internet checksum
+
 /**
   Allocate and build up the sketch for a NET_BUF.
 
@@ -1624,31 +1633,17 @@ NetblockChecksum (
   IN UINT32  Len
   )
 {
-  register UINT32  Sum;
-
-  Sum = 0;
-
+  // MU_CHANGE [BEGIN] - Vectorized Internet checksum
   //
-  // Add left-over byte, if any
+  // The implementation is selected on the first call, it is the same for
+  // every later one.
   //
-  if (Len % 2 != 0) {
-    Sum += *(Bulk + Len - 1);
-  }
-
-  while (Len > 1) {
-    Sum  += *(UINT16 *)Bulk;
-    Bulk += 2;
-    Len  -= 2;
+  if (mNetblockChecksum == NULL) {
+    mNetblockChecksum = NetblockChecksumSelect ();
   }
 
-  //
-  // Fold 32-bit sum to 16 bits
-  //
-  while ((Sum >> 16) != 0) {
-    Sum = (Sum & 0xffff) + (Sum >> 16);
-  }
-
-  return (UINT16)Sum;
+  return mNetblockChecksum (Bulk, Len);
+  // MU_CHANGE [END] - Vectorized Internet checksum
 }
 
 /**
@@ -0,0 +1,190 @@
+/** @file
+  Portable Internet checksum implementations and the selection of the
+  implementation used by NetblockChecksum ().
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Library/BaseLib.h>
+
+#include "NetChecksum.h"
+
+/**
+  Compute the checksum for a bulk of data, 16 bits at a time.
+
+  This is the reference implementation.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The computed checksum.
+
+**/
+UINT16
+EFIAPI
+NetblockChecksum16 (
+  IN UINT8   *Bulk,
+  IN UINT32  Len
+  )
+{
+  register UINT32  Sum;
+
+  Sum = 0;
+
+  //
+  // Add left-over byte, if any
+  //
+  if (Len % 2 != 0) {
+    Sum += *(Bulk + Len - 1);
+  }
+
+  while (Len > 1) {
+    Sum  += *(UINT16 *)Bulk;
+    Bulk += 2;
+    Len  -= 2;
+  }
+
+  //
+  // Fold 32-bit sum to 16 bits
+  //
+  while ((Sum >> 16) != 0) {
+    Sum = (Sum & 0xffff) + (Sum >> 16);
+  }
+
+  return (UINT16)Sum;
+}
+
+/**
+  Add the 32-bit words of a bulk of data in a 64-bit accumulator.
+
+  A trailing 16-bit word and a trailing byte are added as they are, the sum
+  is only meaningful once folded by NetChecksumFold ().
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The unfolded sum.
+
+**/
+UINT64
+NetChecksumSum64 (
+  IN CONST UINT8  *Bulk,
+  IN UINT32       Len
+  )
+{
+  UINT64  Sum0;
+  UINT64  Sum1;
+
+  //
+  // Two accumulators let consecutive additions proceed in parallel. Even
+  // 4GB of 32-bit words can't overflow them.
+  //
+  Sum0 = 0;
+  Sum1 = 0;
+
+  while (Len >= 16) {
+    Sum0 += *(CONST UINT32 *)Bulk;
+    Sum1 += *(CONST UINT32 *)(Bulk + 4);
+    Sum0 += *(CONST UINT32 *)(Bulk + 8);
+    Sum1 += *(CONST UINT32 *)(Bulk + 12);
+    Bulk += 16;
+    Len  -= 16;
+  }
+
+  while (Len >= 4) {
+    Sum0 += *(CONST UINT32 *)Bulk;
+    Bulk += 4;
+    Len  -= 4;
+  }
+
+  if (Len >= 2) {
+    Sum1 += *(CONST UINT16 *)Bulk;
+    Bulk += 2;
+    Len  -= 2;
+  }
+
+  //
+  // The left-over byte is the low byte of a 16-bit word
+  //
+  if (Len != 0) {
+    Sum0 += *Bulk;
+  }
+
+  return Sum0 + Sum1;
+}
+
+/**
+  Fold a 64-bit sum to a 16-bit one's complement sum.
+
+  @param[in]   Sum                   The sum to fold.
+
+  @return    The folded sum.
+
+**/
+UINT16
+NetChecksumFold (
+  IN UINT64  Sum
+  )
+{
+  UINT32  Sum32;
+
+  while (RShiftU64 (Sum, 32) != 0) {
+    Sum = (Sum & 0xffffffff) + RShiftU64 (Sum, 32);
+  }
+
+  Sum32 = (UINT32)Sum;
+  while ((Sum32 >> 16) != 0) {
+    Sum32 = (Sum32 & 0xffff) + (Sum32 >> 16);
+  }
+
+  return (UINT16)Sum32;
+}
+
+/**
+  Compute the checksum for a bulk of data, 32 bits at a time in a 64-bit
+  accumulator.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The computed checksum.
+
+**/
+UINT16
+EFIAPI
+NetblockChecksum64 (
+  IN UINT8   *Bulk,
+  IN UINT32  Len
+  )
+{
+  return NetChecksumFold (NetChecksumSum64 (Bulk, Len));
+}
+
+/**
+  Select the fastest checksum implementation the CPU supports.
+
+  @return    The selected implementation.
+
+**/
+NET_BLOCK_CHECKSUM
+NetblockChecksumSelect (
+  VOID
+  )
+{
+ #if defined (MDE_CPU_X64)
+  if (NetChecksumAvx2Supported ()) {
+    return NetblockChecksumAvx2;
+  }
+
+  return NetblockChecksumSse2;
+ #elif defined (MDE_CPU_AARCH64)
+  //
+  // Advanced SIMD is always available to UEFI drivers on AArch64.
+  //
+  return NetblockChecksumNeon;
+ #else
+  return NetblockChecksum64;
+ #endif
+}
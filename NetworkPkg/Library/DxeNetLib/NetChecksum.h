@@ -0,0 +1,248 @@
+/** @file
+  Internal definitions of the Internet checksum implementations of DxeNetLib.
+
+  All the implementations compute the same 16-bit one's complement sum as
+  NetblockChecksum (). They differ in the width of the words they add, a
+  sum of 32-bit words folded to 16 bits is equal to the sum of their 16-bit
+  halves, as 2^16 is 1 modulo 2^16 - 1.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef NET_CHECKSUM_H_
+#define NET_CHECKSUM_H_
+
+#include <Uefi.h>
+
+//
+// Buffers are passed to the SIMD implementations in blocks of this size.
+//
+#define NET_CHECKSUM_BLOCK_SIZE  64
+
+/**
+  Compute the checksum for a bulk of data.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The computed checksum.
+
+**/
+typedef
+UINT16
+(EFIAPI *NET_BLOCK_CHECKSUM)(
+  IN UINT8   *Bulk,
+  IN UINT32  Len
+  );
+
+/**
+  Compute the checksum for a bulk of data, 16 bits at a time.
+
+  This is the reference implementation.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The computed checksum.
+
+**/
+UINT16
+EFIAPI
+NetblockChecksum16 (
+  IN UINT8   *Bulk,
+  IN UINT32  Len
+  );
+
+/**
+  Compute the checksum for a bulk of data, 32 bits at a time in a 64-bit
+  accumulator.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The computed checksum.
+
+**/
+UINT16
+EFIAPI
+NetblockChecksum64 (
+  IN UINT8   *Bulk,
+  IN UINT32  Len
+  );
+
+/**
+  Add the 32-bit words of a bulk of data in a 64-bit accumulator.
+
+  A trailing 16-bit word and a trailing byte are added as they are, the sum
+  is only meaningful once folded by NetChecksumFold ().
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The unfolded sum.
+
+**/
+UINT64
+NetChecksumSum64 (
+  IN CONST UINT8  *Bulk,
+  IN UINT32       Len
+  );
+
+/**
+  Fold a 64-bit sum to a 16-bit one's complement sum.
+
+  @param[in]   Sum                   The sum to fold.
+
+  @return    The folded sum.
+
+**/
+UINT16
+NetChecksumFold (
+  IN UINT64  Sum
+  );
+
+/**
+  Select the fastest checksum implementation the CPU supports.
+
+  @return    The selected implementation.
+
+**/
+NET_BLOCK_CHECKSUM
+NetblockChecksumSelect (
+  VOID
+  );
+
+#if defined (MDE_CPU_X64)
+
+/**
+  Compute the checksum for a bulk of data with SSE2 instructions.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The computed checksum.
+
+**/
+UINT16
+EFIAPI
+NetblockChecksumSse2 (
+  IN UINT8   *Bulk,
+  IN UINT32  Len
+  );
+
+/**
+  Compute the checksum for a bulk of data with AVX2 instructions.
+
+  The caller must check NetChecksumAvx2Supported () first.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The computed checksum.
+
+**/
+UINT16
+EFIAPI
+NetblockChecksumAvx2 (
+  IN UINT8   *Bulk,
+  IN UINT32  Len
+  );
+
+/**
+  Check whether the CPU supports AVX2 and the AVX state is enabled.
+
+  @retval TRUE     NetblockChecksumAvx2 () can be used.
+  @retval FALSE    NetblockChecksumAvx2 () can't be used.
+
+**/
+BOOLEAN
+NetChecksumAvx2Supported (
+  VOID
+  );
+
+/**
+  Add the 32-bit words of whole blocks of data with SSE2 instructions.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, a non-zero multiple
+                                     of NET_CHECKSUM_BLOCK_SIZE.
+
+  @return    The unfolded sum.
+
+**/
+UINT64
+EFIAPI
+InternalNetChecksumSse2 (
+  IN CONST UINT8  *Bulk,
+  IN UINTN        Len
+  );
+
+/**
+  Add the 32-bit words of whole blocks of data with AVX2 instructions.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, a non-zero multiple
+                                     of NET_CHECKSUM_BLOCK_SIZE.
+
+  @return    The unfolded sum.
+
+**/
+UINT64
+EFIAPI
+InternalNetChecksumAvx2 (
+  IN CONST UINT8  *Bulk,
+  IN UINTN        Len
+  );
+
+/**
+  Read the XCR0 extended control register.
+
+  @return    The value of XCR0.
+
+**/
+UINT64
+EFIAPI
+InternalNetReadXcr0 (
+  VOID
+  );
+
+#elif defined (MDE_CPU_AARCH64)
+
+/**
+  Compute the checksum for a bulk of data with NEON instructions.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The computed checksum.
+
+**/
+UINT16
+EFIAPI
+NetblockChecksumNeon (
+  IN UINT8   *Bulk,
+  IN UINT32  Len
+  );
+
+/**
+  Add the 32-bit words of whole blocks of data with NEON instructions.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, a non-zero multiple
+                                     of NET_CHECKSUM_BLOCK_SIZE.
+
+  @return    The unfolded sum.
+
+**/
+UINT64
+EFIAPI
+InternalNetChecksumNeon (
+  IN CONST UINT8  *Bulk,
+  IN UINTN        Len
+  );
+
+#endif
+
+#endif
@@ -0,0 +1,122 @@
+/** @file
+  Internet checksum computation with the SSE2 and AVX2 instructions of x64
+  CPUs.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Library/BaseLib.h>
+#include <Register/Intel/Cpuid.h>
+
+#include "../NetChecksum.h"
+
+#define XCR0_SSE_AVX_STATE  (BIT1 | BIT2)
+
+/**
+  Check whether the CPU supports AVX2 and the AVX state is enabled.
+
+  @retval TRUE     NetblockChecksumAvx2 () can be used.
+  @retval FALSE    NetblockChecksumAvx2 () can't be used.
+
+**/
+BOOLEAN
+NetChecksumAvx2Supported (
+  VOID
+  )
+{
+  UINT32                                       MaxLeaf;
+  CPUID_VERSION_INFO_ECX                       VersionInfoEcx;
+  CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS_EBX  ExtendedFeatureEbx;
+
+  AsmCpuid (CPUID_SIGNATURE, &MaxLeaf, NULL, NULL, NULL);
+  if (MaxLeaf < CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS) {
+    return FALSE;
+  }
+
+  AsmCpuid (CPUID_VERSION_INFO, NULL, NULL, &VersionInfoEcx.Uint32, NULL);
+  if ((VersionInfoEcx.Bits.OSXSAVE == 0) || (VersionInfoEcx.Bits.AVX == 0)) {
+    return FALSE;
+  }
+
+  if ((InternalNetReadXcr0 () & XCR0_SSE_AVX_STATE) != XCR0_SSE_AVX_STATE) {
+    return FALSE;
+  }
+
+  AsmCpuidEx (
+    CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS,
+    CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS_SUB_LEAF_INFO,
+    NULL,
+    &ExtendedFeatureEbx.Uint32,
+    NULL,
+    NULL
+    );
+  return (BOOLEAN)(ExtendedFeatureEbx.Bits.AVX2 != 0);
+}
+
+/**
+  Compute the checksum for a bulk of data with SSE2 instructions.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The computed checksum.
+
+**/
+UINT16
+EFIAPI
+NetblockChecksumSse2 (
+  IN UINT8   *Bulk,
+  IN UINT32  Len
+  )
+{
+  UINT64  Sum;
+  UINT32  Size;
+
+  Sum  = 0;
+  Size = Len & ~(UINT32)(NET_CHECKSUM_BLOCK_SIZE - 1);
+  if (Size != 0) {
+    Sum = InternalNetChecksumSse2 (Bulk, Size);
+  }
+
+  return NetChecksumFold (Sum + NetChecksumSum64 (Bulk + Size, Len - Size));
+}
+
+/**
+  Compute the checksum for a bulk of data with AVX2 instructions.
+
+  The caller must check NetChecksumAvx2Supported () first.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The computed checksum.
+
+**/
+UINT16
+EFIAPI
+NetblockChecksumAvx2 (
+  IN UINT8   *Bulk,
+  IN UINT32  Len
+  )
+{
+  UINT64   Sum;
+  UINT32   Size;
+  BOOLEAN  InterruptState;
+
+  Sum  = 0;
+  Size = Len & ~(UINT32)(NET_CHECKSUM_BLOCK_SIZE - 1);
+  if (Size != 0) {
+    //
+    // The exception handlers only save the XMM registers. Keep interrupts
+    // off so that a checksum computed by an event or a timer handler can't
+    // clobber the upper halves of the YMM registers used here.
+    //
+    InterruptState = SaveAndDisableInterrupts ();
+    Sum            = InternalNetChecksumAvx2 (Bulk, Size);
+    SetInterruptState (InterruptState);
+  }
+
+  return NetChecksumFold (Sum + NetChecksumSum64 (Bulk + Size, Len - Size));
+}
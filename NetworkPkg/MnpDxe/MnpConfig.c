@@ -477,6 +477,10 @@ MnpInitializeDeviceData (
   //
   MnpDeviceData->PaddingSize = ((4 - SnpMode->MediaHeaderSize) & 0x3) + NET_VLAN_TAG_LEN;
 
+  // MU_CHANGE [BEGIN] - Burst receive in the MNP system poll
+  MnpDeviceData->RxBurstSize = MAX (PcdGet32 (PcdMnpRxBurstSize), 1);
+  // MU_CHANGE [END] - Burst receive in the MNP system poll
+
   //
   // Initialize MAC string which will be used as VLAN configuration variable name
   //
@@ -623,6 +627,20 @@ MnpDestroyDeviceData (
 
   NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
 
+  // MU_CHANGE [BEGIN] - Burst receive in the MNP system poll
+  DEBUG ((
+    DEBUG_INFO,
+    "MnpDestroyDeviceData: %Ld polls received %Ld frames, at most %d per poll (burst %d). %Ld polls hit the burst limit, %Ld ran out of buffers, %Ld frames dropped.\n",
+    MnpDeviceData->RxPollCount,
+    MnpDeviceData->RxPollFrames,
+    MnpDeviceData->RxPollMaxFrames,
+    MnpDeviceData->RxBurstSize,
+    MnpDeviceData->RxPollFullCount,
+    MnpDeviceData->RxNoBufferCount,
+    MnpDeviceData->RxDropCount
+    ));
+  // MU_CHANGE [END] - Burst receive in the MNP system poll
+
   //
   // Free Vlan Config variable name string
   //
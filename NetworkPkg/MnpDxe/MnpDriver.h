@@ -27,6 +27,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiRuntimeServicesTableLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/PrintLib.h>
+#include <Library/PcdLib.h>             // MU_CHANGE - Burst receive in the MNP system poll
 
 #include "ComponentName.h"
 
@@ -85,6 +86,20 @@ typedef struct {
   UINT32                         BufferLength;
   UINT32                         PaddingSize;
   NET_BUF                        *RxNbufCache;
+
+  // MU_CHANGE [BEGIN] - Burst receive in the MNP system poll
+  //
+  // The most frames the system poll receives per tick, and the receive
+  // statistics used to size it.
+  //
+  UINT32                         RxBurstSize;
+  UINT32                         RxPollMaxFrames;
+  UINT64                         RxPollCount;
+  UINT64                         RxPollFrames;
+  UINT64                         RxPollFullCount;
+  UINT64                         RxNoBufferCount;
+  UINT64                         RxDropCount;
+  // MU_CHANGE [END] - Burst receive in the MNP system poll
 } MNP_DEVICE_DATA;
 
 #define MNP_DEVICE_DATA_FROM_THIS(a) \
@@ -422,6 +422,7 @@ MnpRecycleRxData (
   @retval EFI_SUCCESS           add return value to function comment
   @retval EFI_NOT_STARTED       The simple network protocol is not started.
   @retval EFI_NOT_READY         No packet received.
+  @retval EFI_ABORTED           The packet received is malformed and dropped.
   @retval EFI_DEVICE_ERROR      An unexpected error occurs.
 
 **/
@@ -430,6 +431,31 @@ MnpReceivePacket (
   IN OUT MNP_DEVICE_DATA  *MnpDeviceData
   );
 
+// MU_CHANGE [BEGIN] - Burst receive in the MNP system poll
+
+/**
+  Receive and deliver the packets pending in Snp, up to
+  MnpDeviceData->RxBurstSize of them, so the SNP receive ring is drained
+  instead of being read one packet at a time.
+
+  A malformed packet is dropped and counted, it doesn't end the burst.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+
+  @retval EFI_SUCCESS           At least one packet was delivered.
+  @retval EFI_NOT_STARTED       The simple network protocol is not started.
+  @retval EFI_NOT_READY         No packet received.
+  @retval EFI_DEVICE_ERROR      No packet was delivered and an unexpected error
+                                occurs.
+
+**/
+EFI_STATUS
+MnpReceivePackets (
+  IN OUT MNP_DEVICE_DATA  *MnpDeviceData
+  );
+
+// MU_CHANGE [END] - Burst receive in the MNP system poll
+
 /**
   Allocate a free NET_BUF from MnpDeviceData->FreeNbufQue. If there is none
   in the queue, first try to allocate some and add them into the queue, then
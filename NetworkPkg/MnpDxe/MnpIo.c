@@ -481,6 +481,7 @@ MnpQueueRcvdPacket (
   //
   if (Instance->RcvdPacketQueueSize == MNP_MAX_RCVD_PACKET_QUE_SIZE) {
     DEBUG ((DEBUG_WARN, "MnpQueueRcvdPacket: Drop one packet bcz queue size limit reached.\n"));
+    Instance->MnpServiceData->MnpDeviceData->RxDropCount++;  // MU_CHANGE - Burst receive in the MNP system poll
 
     //
     // Get the oldest packet.
@@ -827,6 +828,7 @@ MnpEnqueuePacket (
   @retval EFI_SUCCESS           add return value to function comment
   @retval EFI_NOT_STARTED       The simple network protocol is not started.
   @retval EFI_NOT_READY         No packet received.
+  @retval EFI_ABORTED           The packet received is malformed and dropped.
   @retval EFI_DEVICE_ERROR      An unexpected error occurs.
 
 **/
@@ -866,6 +868,7 @@ MnpReceivePacket (
       //
       // No available buffer in the buffer pool.
       //
+      MnpDeviceData->RxNoBufferCount++;  // MU_CHANGE - Burst receive in the MNP system poll
       return EFI_DEVICE_ERROR;
     }
 
@@ -912,7 +915,10 @@ MnpReceivePacket (
        HeaderSize,
        BufLen)
       );
-    return EFI_DEVICE_ERROR;
+    // MU_CHANGE [BEGIN] - Burst receive in the MNP system poll
+    MnpDeviceData->RxDropCount++;
+    return EFI_ABORTED;
+    // MU_CHANGE [END] - Burst receive in the MNP system poll
   }
 
   Trimmed = 0;
@@ -966,7 +972,14 @@ MnpReceivePacket (
     MnpDeviceData->RxNbufCache = Nbuf;
     if (Nbuf == NULL) {
       DEBUG ((DEBUG_ERROR, "MnpReceivePacket: Alloc packet for receiving cache failed.\n"));
-      return EFI_DEVICE_ERROR;
+      // MU_CHANGE [BEGIN] - Burst receive in the MNP system poll
+      //
+      // The packet is queued already, deliver it. The next call tries to get
+      // a receive buffer again.
+      //
+      MnpDeliverPacket (MnpServiceData);
+      return EFI_SUCCESS;
+      // MU_CHANGE [END] - Burst receive in the MNP system poll
     }
 
     NetbufAllocSpace (Nbuf, MnpDeviceData->BufferLength, NET_BUF_TAIL);
@@ -1095,10 +1108,95 @@ MnpCheckMediaStatus (
   }
 }
 
+// MU_CHANGE [BEGIN] - Burst receive in the MNP system poll
+
+/**
+  Receive and deliver the packets pending in Snp, up to
+  MnpDeviceData->RxBurstSize of them, so the SNP receive ring is drained
+  instead of being read one packet at a time.
+
+  A malformed packet is dropped and counted, it doesn't end the burst.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+
+  @retval EFI_SUCCESS           At least one packet was delivered.
+  @retval EFI_NOT_STARTED       The simple network protocol is not started.
+  @retval EFI_NOT_READY         No packet received.
+  @retval EFI_DEVICE_ERROR      No packet was delivered and an unexpected error
+                                occurs.
+
+**/
+EFI_STATUS
+MnpReceivePackets (
+  IN OUT MNP_DEVICE_DATA  *MnpDeviceData
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Attempts;
+  UINT32      Frames;
+
+  Status = EFI_NOT_READY;
+  Frames = 0;
+  for (Attempts = 0; Attempts < MnpDeviceData->RxBurstSize; Attempts++) {
+    //
+    // Try to receive packets from Snp, stop once it has no more.
+    //
+    Status = MnpReceivePacket (MnpDeviceData);
+    if (Status == EFI_ABORTED) {
+      continue;
+    }
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Frames++;
+
+    //
+    // Dispatch the DPC queued by the NotifyFunction of rx token's events, so
+    // the upper layers can recycle their tokens before the next packet.
+    //
+    DispatchDpc ();
+  }
+
+  if (Status == EFI_NOT_STARTED) {
+    return Status;
+  }
+
+  MnpDeviceData->RxPollCount++;
+  MnpDeviceData->RxPollFrames += Frames;
+  if (Frames > MnpDeviceData->RxPollMaxFrames) {
+    MnpDeviceData->RxPollMaxFrames = Frames;
+  }
+
+  if (Attempts == MnpDeviceData->RxBurstSize) {
+    //
+    // Packets may still be pending in the SNP receive ring.
+    //
+    MnpDeviceData->RxPollFullCount++;
+  }
+
+  //
+  // Dispatch the DPC queued by the NotifyFunction of rx token's events.
+  //
+  DispatchDpc ();
+
+  if (Frames != 0) {
+    return EFI_SUCCESS;
+  }
+
+  return (Status == EFI_ABORTED) ? EFI_DEVICE_ERROR : Status;
+}
+
+// MU_CHANGE [END] - Burst receive in the MNP system poll
+
 /**
   Poll to receive the packets from Snp. This function is either called by upperlayer
   protocols/applications or the system poll timer notify mechanism.
 
+  Up to MnpDeviceData->RxBurstSize frames are received per call, see
+  MnpReceivePackets ().
+
   @param[in]  Event        The event this notify function registered to.
   @param[in]  Context      Pointer to the context data registered to the event.
 
@@ -1115,13 +1213,7 @@ MnpSystemPoll (
   MnpDeviceData = (MNP_DEVICE_DATA *)Context;
   NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
 
-  //
-  // Try to receive packets from Snp.
-  //
-  MnpReceivePacket (MnpDeviceData);
-
-  //
-  // Dispatch the DPC queued by the NotifyFunction of rx token's events.
-  //
-  DispatchDpc ();
+  // MU_CHANGE [BEGIN] - Burst receive in the MNP system poll
+  MnpReceivePackets (MnpDeviceData);
+  // MU_CHANGE [END] - Burst receive in the MNP system poll
 }
@@ -773,14 +773,10 @@ MnpPoll (
   }
 
   //
-  // Try to receive packets.
+  // Try to receive packets, the DPCs queued by the NotifyFunction of rx
+  // token's events are dispatched.
   //
-  Status = MnpReceivePacket (Instance->MnpServiceData->MnpDeviceData);
-
-  //
-  // Dispatch the DPC queued by the NotifyFunction of rx token's events.
-  //
-  DispatchDpc ();
+  Status = MnpReceivePackets (Instance->MnpServiceData->MnpDeviceData);    // MU_CHANGE - Burst receive in the MNP system poll
 
 ON_EXIT:
   gBS->RestoreTPL (OldTpl);
@@ -0,0 +1,655 @@
+/** @file
+  Tests for the selective acknowledgment support of TcpDxe.
+
+  Two TCP instances are connected back to back through a simulated link
+  that can drop chosen data segments. Every round of the simulation delivers
+  the segments sent in the previous round and is one TCP tick long, so a
+  round trip takes two ticks.
+
+  Copyright (c) Microsoft Corporation
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <gtest/gtest.h>
+
+extern "C" {
+  #include <Uefi.h>
+  #include <Library/BaseLib.h>
+  #include <Library/BaseMemoryLib.h>
+  #include <Library/DebugLib.h>
+  #include <Library/MemoryAllocationLib.h>
+  #include "../TcpMain.h"
+
+  VOID
+  EFIAPI
+  TcpTickingDpc (
+    IN VOID  *Context
+    );
+}
+
+////////////////////////////////////////////////////////////////////////
+// Defines
+////////////////////////////////////////////////////////////////////////
+
+#define TCP_TEST_MAX_PACKET_SIZE  1500
+#define TCP_TEST_TRANSFER_SIZE    (2 * 1024 * 1024)
+#define TCP_TEST_MAX_ROUNDS       2000
+#define TCP_TEST_RCV_WINDOW       (64 * 1024)
+
+//
+// The data segments of the transfer that are dropped the first time they are
+// sent: bursts of losses in one window, with a scattered one in between.
+//
+static const UINT32  mTcpTestDropTrace[] = {
+  100, 103, 106, 109, 112, 400, 402, 404, 406, 408, 600, 800, 803, 806, 809, 1200, 1202, 1204, 1206
+};
+
+typedef struct {
+  SOCKET              Sock;
+  TCP_SERVICE_DATA    Service;
+  IP_IO               IpIo;
+  IP_IO_IP_INFO       IpInfo;
+  EFI_IP4_PROTOCOL    Ip4;
+  TCP_CB              *Tcb;
+  UINT32              Sent;
+  UINT32              Received;
+  BOOLEAN             Corrupted;
+} TCP_TEST_END;
+
+#define TCP_TEST_END_FROM_SOCK(a)  BASE_CR ((a), TCP_TEST_END, Sock)
+
+//
+// The simulated link.
+//
+static NET_BUF_QUEUE  mWire;
+static TCP_TEST_END   *mSender;
+static BOOLEAN        mTracing;
+static TCP_SEQNO      mHighSeq;
+static UINT32         mDataSegments;
+static UINT32         mDroppedBytes;
+static UINT32         mRexmitBytes;
+
+/**
+  Get the byte at some offset of the transferred stream.
+**/
+static UINT8
+TcpTestPattern (
+  IN UINT32  Offset
+  )
+{
+  return (UINT8)(Offset % 251);
+}
+
+////////////////////////////////////////////////////////////////////////
+// Symbol Definitions
+// These functions are not directly under test - but required to compile
+////////////////////////////////////////////////////////////////////////
+
+SOCKET *
+SockClone (
+  IN SOCKET  *Sock
+  )
+{
+  return NULL;
+}
+
+VOID
+SockConnEstablished (
+  IN OUT SOCKET  *Sock
+  )
+{
+  Sock->State = SO_CONNECTED;
+}
+
+VOID
+SockConnClosed (
+  IN OUT SOCKET  *Sock
+  )
+{
+  Sock->State = SO_CLOSED;
+}
+
+VOID
+SockNoMoreData (
+  IN OUT SOCKET  *Sock
+  )
+{
+  Sock->Flag |= SO_NO_MORE_DATA;
+}
+
+UINT32
+SockGetFreeSpace (
+  IN SOCKET  *Sock,
+  IN UINT32  Which
+  )
+{
+  SOCK_BUFFER  *Buffer;
+
+  Buffer = (Which == SOCK_SND_BUF) ? &Sock->SndBuffer : &Sock->RcvBuffer;
+  return Buffer->HighWater - Buffer->DataQueue->BufSize;
+}
+
+//
+// The application has queued the rest of the stream, hand it to TCP.
+//
+UINT32
+SockGetDataToSend (
+  IN  SOCKET  *Sock,
+  IN  UINT32  Offset,
+  IN  UINT32  Len,
+  OUT UINT8   *Dest
+  )
+{
+  TCP_TEST_END  *End;
+  UINT32        Index;
+
+  End = TCP_TEST_END_FROM_SOCK (Sock);
+  Len = MIN (Len, Sock->SndBuffer.DataQueue->BufSize - Offset);
+
+  for (Index = 0; Index < Len; Index++) {
+    Dest[Index] = TcpTestPattern (End->Sent + Offset + Index);
+  }
+
+  return Len;
+}
+
+VOID
+SockDataSent (
+  IN OUT SOCKET  *Sock,
+  IN     UINT32  Count
+  )
+{
+  TCP_TEST_END  *End;
+
+  End        = TCP_TEST_END_FROM_SOCK (Sock);
+  End->Sent += Count;
+
+  Sock->SndBuffer.DataQueue->BufSize -= Count;
+}
+
+//
+// The application consumes the data as soon as it is delivered.
+//
+VOID
+SockDataRcvd (
+  IN OUT SOCKET   *Sock,
+  IN OUT NET_BUF  *NetBuffer,
+  IN     UINT32   UrgLen
+  )
+{
+  TCP_TEST_END  *End;
+  UINT8         *Data;
+  UINT32        Index;
+
+  End  = TCP_TEST_END_FROM_SOCK (Sock);
+  Data = (UINT8 *)AllocatePool (NetBuffer->TotalSize);
+  ASSERT (Data != NULL);
+
+  NetbufCopy (NetBuffer, 0, NetBuffer->TotalSize, Data);
+  for (Index = 0; Index < NetBuffer->TotalSize; Index++) {
+    if (Data[Index] != TcpTestPattern (End->Received + Index)) {
+      End->Corrupted = TRUE;
+    }
+  }
+
+  End->Received += NetBuffer->TotalSize;
+  FreePool (Data);
+}
+
+//
+// Put a copy of the segment on the link, unless the trace drops it.
+//
+INTN
+TcpSendIpPacket (
+  IN TCP_CB          *Tcb,
+  IN NET_BUF         *Nbuf,
+  IN EFI_IP_ADDRESS  *Src,
+  IN EFI_IP_ADDRESS  *Dest,
+  IN UINT8           Version
+  )
+{
+  NET_BUF    *Packet;
+  TCP_HEAD   *Head;
+  TCP_SEQNO  Seq;
+  UINT32     DataLen;
+  UINT32     Index;
+
+  Packet = NetbufAlloc (Nbuf->TotalSize);
+  if (Packet == NULL) {
+    return -1;
+  }
+
+  Head = (TCP_HEAD *)NetbufAllocSpace (Packet, Nbuf->TotalSize, NET_BUF_TAIL);
+  NetbufCopy (Nbuf, 0, Nbuf->TotalSize, (UINT8 *)Head);
+
+  Seq     = NTOHL (Head->Seq);
+  DataLen = Nbuf->TotalSize - (Head->HeadLen << 2);
+
+  if (mTracing && (Tcb == mSender->Tcb) && (DataLen != 0)) {
+    if (TCP_SEQ_LT (Seq, mHighSeq)) {
+      mRexmitBytes += DataLen;
+    } else {
+      mHighSeq = Seq + DataLen;
+
+      for (Index = 0; Index < ARRAY_SIZE (mTcpTestDropTrace); Index++) {
+        if (mTcpTestDropTrace[Index] == mDataSegments) {
+          break;
+        }
+      }
+
+      mDataSegments++;
+      if (Index < ARRAY_SIZE (mTcpTestDropTrace)) {
+        mDroppedBytes += DataLen;
+        NetbufFree (Packet);
+        return 0;
+      }
+    }
+  }
+
+  NetbufQueAppend (&mWire, Packet);
+  return 0;
+}
+
+EFI_STATUS
+Tcp6RefreshNeighbor (
+  IN TCP_CB          *Tcb,
+  IN EFI_IP_ADDRESS  *Neighbor,
+  IN UINT32          Timeout
+  )
+{
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+IpIoGetIcmpErrStatus (
+  IN  UINT8    IcmpError,
+  IN  UINT8    IpVersion,
+  OUT BOOLEAN  *IsHard  OPTIONAL,
+  OUT BOOLEAN  *Notify  OPTIONAL
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+EFI_STATUS
+EFIAPI
+QueueDpc (
+  IN EFI_TPL            DpcTpl,
+  IN EFI_DPC_PROCEDURE  DpcProcedure,
+  IN VOID               *DpcContext    OPTIONAL
+  )
+{
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+TcpTestIp4GetModeData (
+  IN  CONST EFI_IP4_PROTOCOL          *This,
+  OUT EFI_IP4_MODE_DATA               *Ip4ModeData     OPTIONAL,
+  OUT EFI_MANAGED_NETWORK_CONFIG_DATA *MnpConfigData   OPTIONAL,
+  OUT EFI_SIMPLE_NETWORK_MODE         *SnpModeData     OPTIONAL
+  )
+{
+  if (Ip4ModeData != NULL) {
+    Ip4ModeData->MaxPacketSize = TCP_TEST_MAX_PACKET_SIZE - 20;
+  }
+
+  return EFI_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////
+// TcpSack Tests
+////////////////////////////////////////////////////////////////////////
+
+class TcpSackTest : public ::testing::Test {
+protected:
+  TCP_TEST_END End[2];
+
+  virtual void
+  SetUp (
+    )
+  {
+    NetbufQueInit (&mWire);
+    mSender       = &End[0];
+    mTracing      = FALSE;
+    mDataSegments = 0;
+    mDroppedBytes = 0;
+    mRexmitBytes  = 0;
+
+    InitEnd (&End[0], 0xc0a80001, 1000, 0xc0a80002, 2000);
+    InitEnd (&End[1], 0xc0a80002, 2000, 0xc0a80001, 1000);
+  }
+
+  virtual void
+  TearDown (
+    )
+  {
+    UINTN  Index;
+
+    NetbufQueFlush (&mWire);
+
+    for (Index = 0; Index < 2; Index++) {
+      NetbufFreeList (&End[Index].Tcb->SndQue);
+      NetbufFreeList (&End[Index].Tcb->RcvQue);
+      RemoveEntryList (&End[Index].Tcb->List);
+      FreePool (End[Index].Tcb);
+      NetbufQueFree (End[Index].Sock.SndBuffer.DataQueue);
+      NetbufQueFree (End[Index].Sock.RcvBuffer.DataQueue);
+    }
+  }
+
+  //
+  // Configure one instance the way TcpConfigurePcb does.
+  //
+  void
+  InitEnd (
+    TCP_TEST_END  *TestEnd,
+    IP4_ADDR      Local,
+    UINT16        LocalPort,
+    IP4_ADDR      Remote,
+    UINT16        RemotePort
+    )
+  {
+    TCP_PROTO_DATA  *TcpProto;
+    TCP_CB          *Tcb;
+
+    ZeroMem (TestEnd, sizeof (*TestEnd));
+
+    TestEnd->Ip4.GetModeData  = TcpTestIp4GetModeData;
+    TestEnd->IpIo.Ip.Ip4      = &TestEnd->Ip4;
+    TestEnd->IpInfo.IpVersion = IP_VERSION_4;
+    TestEnd->Service.IpIo     = &TestEnd->IpIo;
+
+    TestEnd->Sock.IpVersion           = IP_VERSION_4;
+    TestEnd->Sock.SndBuffer.HighWater = TCP_TEST_TRANSFER_SIZE;
+    TestEnd->Sock.RcvBuffer.HighWater = TCP_RCV_BUF_SIZE_DEFAULT;
+    TestEnd->Sock.SndBuffer.DataQueue = NetbufQueAlloc ();
+    TestEnd->Sock.RcvBuffer.DataQueue = NetbufQueAlloc ();
+    ASSERT_NE (TestEnd->Sock.SndBuffer.DataQueue, nullptr);
+    ASSERT_NE (TestEnd->Sock.RcvBuffer.DataQueue, nullptr);
+
+    Tcb = (TCP_CB *)AllocateZeroPool (sizeof (TCP_CB));
+    ASSERT_NE (Tcb, nullptr);
+
+    InitializeListHead (&Tcb->List);
+    InitializeListHead (&Tcb->SndQue);
+    InitializeListHead (&Tcb->RcvQue);
+
+    Tcb->Sk     = &TestEnd->Sock;
+    Tcb->IpInfo = &TestEnd->IpInfo;
+    TcpProto    = (TCP_PROTO_DATA *)TestEnd->Sock.ProtoReserved;
+
+    TcpProto->TcpService = &TestEnd->Service;
+    TcpProto->TcpPcb     = Tcb;
+
+    TCP_SET_FLG (Tcb->CtrlFlag, TCP_CTRL_NO_KEEPALIVE | TCP_CTRL_NO_TS);
+    Tcb->State           = TCP_CLOSED;
+    Tcb->SndMss          = 536;
+    Tcb->RcvMss          = TcpGetRcvMss (Tcb->Sk);
+    Tcb->Rto             = 3 * TCP_TICK_HZ;
+    Tcb->CWnd            = Tcb->SndMss;
+    Tcb->Ssthresh        = 0xffffffff;
+    Tcb->CongestState    = TCP_CONGEST_OPEN;
+    Tcb->MaxRexmit       = TCP_MAX_LOSS;
+    Tcb->FinWait2Timeout = TCP_FIN_WAIT2_TIME;
+    Tcb->TimeWaitTimeout = TCP_TIME_WAIT_TIME;
+    Tcb->ConnectTimeout  = TCP_CONNECT_TIME;
+
+    Tcb->LocalEnd.Ip.Addr[0]  = HTONL (Local);
+    Tcb->LocalEnd.Port        = HTONS (LocalPort);
+    Tcb->RemoteEnd.Ip.Addr[0] = HTONL (Remote);
+    Tcb->RemoteEnd.Port       = HTONS (RemotePort);
+
+    InsertHeadList (&mTcpRunQue, &Tcb->List);
+    TestEnd->Tcb = Tcb;
+  }
+
+  //
+  // Deliver the segments on the link, then let a tick pass.
+  //
+  void
+  RunRound (
+    )
+  {
+    NET_BUF_QUEUE  Batch;
+    NET_BUF        *Packet;
+    TCP_HEAD       *Head;
+    TCP_CB         *To;
+    TCP_CB         *From;
+
+    NetbufQueInit (&Batch);
+    while ((Packet = NetbufQueRemove (&mWire)) != NULL) {
+      NetbufQueAppend (&Batch, Packet);
+    }
+
+    while ((Packet = NetbufQueRemove (&Batch)) != NULL) {
+      Head = (TCP_HEAD *)NetbufGetByte (Packet, 0, NULL);
+      To   = End[0].Tcb;
+      From = End[1].Tcb;
+      if (Head->DstPort != To->LocalEnd.Port) {
+        To   = End[1].Tcb;
+        From = End[0].Tcb;
+      }
+
+      TcpInput (Packet, &From->LocalEnd.Ip, &To->LocalEnd.Ip, IP_VERSION_4);
+    }
+
+    TcpTickingDpc (NULL);
+  }
+
+  //
+  // Open the connection from both ends at once.
+  //
+  void
+  Connect (
+    BOOLEAN  SenderSack,
+    BOOLEAN  ReceiverSack
+    )
+  {
+    UINTN  Round;
+
+    if (!SenderSack) {
+      TCP_SET_FLG (End[0].Tcb->CtrlFlag, TCP_CTRL_NO_SACK);
+    }
+
+    if (!ReceiverSack) {
+      TCP_SET_FLG (End[1].Tcb->CtrlFlag, TCP_CTRL_NO_SACK);
+    }
+
+    TcpOnAppConnect (End[0].Tcb);
+    TcpOnAppConnect (End[1].Tcb);
+
+    for (Round = 0; Round < 10; Round++) {
+      RunRound ();
+    }
+
+    ASSERT_EQ (End[0].Tcb->State, TCP_ESTABLISHED);
+    ASSERT_EQ (End[1].Tcb->State, TCP_ESTABLISHED);
+  }
+
+  //
+  // Send the stream from End[0] to End[1], return the number of rounds.
+  //
+  UINT32
+  Transfer (
+    )
+  {
+    UINT32  Round;
+
+    mTracing = TRUE;
+    mHighSeq = End[0].Tcb->SndNxt;
+
+    End[0].Sock.SndBuffer.DataQueue->BufSize = TCP_TEST_TRANSFER_SIZE;
+    TcpToSendData (End[0].Tcb, 0);
+
+    for (Round = 0; Round < TCP_TEST_MAX_ROUNDS; Round++) {
+      if ((End[1].Received == TCP_TEST_TRANSFER_SIZE) && (End[0].Tcb->SndUna == End[0].Tcb->SndNxt)) {
+        break;
+      }
+
+      RunRound ();
+    }
+
+    return Round;
+  }
+};
+
+// Test Description:
+// SACK is used only when both ends permit it in their SYN segments.
+TEST_F (TcpSackTest, SackIsNegotiatedByBothEnds) {
+  Connect (TRUE, FALSE);
+
+  EXPECT_FALSE (TCP_FLG_ON (End[0].Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK));
+  EXPECT_FALSE (TCP_FLG_ON (End[1].Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK));
+}
+
+// Test Description:
+// SACK is used by both ends when both permit it.
+TEST_F (TcpSackTest, SackIsUsedWhenPermitted) {
+  Connect (TRUE, TRUE);
+
+  EXPECT_TRUE (TCP_FLG_ON (End[0].Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK));
+  EXPECT_TRUE (TCP_FLG_ON (End[1].Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK));
+}
+
+// Test Description:
+// The receiver reports the block holding the latest segment first, then
+// the other blocks from the highest sequence down, merging adjacent segments.
+TEST_F (TcpSackTest, SackBlocksReportLatestSegmentFirst) {
+  static const TCP_SEQNO  Segments[][2] = {
+    { 2000, 2500 }, { 2500, 3000 }, { 4000, 4500 }, { 5000, 5500 }, { 6000, 6500 }, { 7000, 7500 }
+  };
+  TCP_SACK_BLOCK          Blocks[TCP_OPTION_SACK_MAX_BLOCKS];
+  TCP_CB                  *Tcb;
+  NET_BUF                 *Nbuf;
+  UINTN                   Index;
+
+  Tcb         = End[1].Tcb;
+  Tcb->RcvNxt = 1000;
+
+  for (Index = 0; Index < ARRAY_SIZE (Segments); Index++) {
+    Nbuf = NetbufAlloc (Segments[Index][1] - Segments[Index][0]);
+    ASSERT_NE (Nbuf, nullptr);
+    ZeroMem (TCPSEG_NETBUF (Nbuf), sizeof (TCP_SEG));
+    TCPSEG_NETBUF (Nbuf)->Seq = Segments[Index][0];
+    TCPSEG_NETBUF (Nbuf)->End = Segments[Index][1];
+    InsertTailList (&Tcb->RcvQue, &Nbuf->List);
+  }
+
+  Tcb->SackRecent = 4000;
+  ASSERT_EQ (TcpSackGetBlocks (Tcb, Blocks, 3), (UINTN)3);
+  EXPECT_EQ (Blocks[0].Left, (TCP_SEQNO)4000);
+  EXPECT_EQ (Blocks[0].Right, (TCP_SEQNO)4500);
+  EXPECT_EQ (Blocks[1].Left, (TCP_SEQNO)7000);
+  EXPECT_EQ (Blocks[2].Left, (TCP_SEQNO)6000);
+
+  Tcb->SackRecent = 2500;
+  ASSERT_EQ (TcpSackGetBlocks (Tcb, Blocks, TCP_OPTION_SACK_MAX_BLOCKS), (UINTN)TCP_OPTION_SACK_MAX_BLOCKS);
+  EXPECT_EQ (Blocks[0].Left, (TCP_SEQNO)2000);
+  EXPECT_EQ (Blocks[0].Right, (TCP_SEQNO)3000);
+  EXPECT_EQ (Blocks[1].Left, (TCP_SEQNO)7000);
+  EXPECT_EQ (Blocks[2].Left, (TCP_SEQNO)6000);
+  EXPECT_EQ (Blocks[3].Left, (TCP_SEQNO)5000);
+}
+
+// Test Description:
+// The SACK option built by the receiver is parsed back to the same blocks.
+TEST_F (TcpSackTest, SackOptionRoundTrip) {
+  TCP_OPTION  Option;
+  TCP_HEAD    *Head;
+  TCP_CB      *Tcb;
+  NET_BUF     *Nbuf;
+  NET_BUF     *Segment;
+  UINT16      Len;
+
+  Tcb         = End[1].Tcb;
+  Tcb->RcvNxt = 1000;
+  TCP_SET_FLG (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK);
+
+  Segment = NetbufAlloc (1460);
+  ASSERT_NE (Segment, nullptr);
+  ZeroMem (TCPSEG_NETBUF (Segment), sizeof (TCP_SEG));
+  TCPSEG_NETBUF (Segment)->Seq = 3000;
+  TCPSEG_NETBUF (Segment)->End = 4460;
+  InsertTailList (&Tcb->RcvQue, &Segment->List);
+  Tcb->SackRecent = 3000;
+
+  Nbuf = NetbufAlloc (TCP_MAX_HEAD);
+  ASSERT_NE (Nbuf, nullptr);
+  NetbufReserve (Nbuf, TCP_MAX_HEAD);
+  ZeroMem (TCPSEG_NETBUF (Nbuf), sizeof (TCP_SEG));
+  TCPSEG_NETBUF (Nbuf)->Flag = TCP_FLG_ACK;
+
+  Len = TcpBuildOption (Tcb, Nbuf);
+  EXPECT_EQ (Len, 4 + TCP_OPTION_SACK_BLOCK_LEN);
+
+  Head = (TCP_HEAD *)NetbufAllocSpace (Nbuf, sizeof (TCP_HEAD), NET_BUF_HEAD);
+  ASSERT_NE (Head, nullptr);
+  ZeroMem (Head, sizeof (TCP_HEAD));
+  Head->HeadLen = (UINT8)((sizeof (TCP_HEAD) + Len) >> 2);
+
+  ZeroMem (&Option, sizeof (Option));
+  ASSERT_EQ (TcpParseOption (Head, &Option), 0);
+  EXPECT_TRUE (TCP_FLG_ON (Option.Flag, TCP_OPTION_RCVD_SACK));
+  ASSERT_EQ (Option.SackCount, 1);
+  EXPECT_EQ (Option.Sack[0].Left, (TCP_SEQNO)3000);
+  EXPECT_EQ (Option.Sack[0].Right, (TCP_SEQNO)4460);
+
+  NetbufFree (Nbuf);
+}
+
+// Test Description:
+// A SACK option with a truncated block is rejected.
+TEST_F (TcpSackTest, TruncatedSackOptionIsRejected) {
+  UINT8       Buffer[sizeof (TCP_HEAD) + 12];
+  TCP_HEAD    *Head;
+  TCP_OPTION  Option;
+
+  ZeroMem (Buffer, sizeof (Buffer));
+  Head          = (TCP_HEAD *)Buffer;
+  Head->HeadLen = sizeof (Buffer) >> 2;
+
+  Buffer[sizeof (TCP_HEAD)]     = TCP_OPTION_NOP;
+  Buffer[sizeof (TCP_HEAD) + 1] = TCP_OPTION_NOP;
+  Buffer[sizeof (TCP_HEAD) + 2] = TCP_OPTION_SACK;
+  Buffer[sizeof (TCP_HEAD) + 3] = 6;
+
+  ZeroMem (&Option, sizeof (Option));
+  EXPECT_EQ (TcpParseOption (Head, &Option), -1);
+}
+
+// Test Description:
+// With several losses in one window, SACK retransmits only the lost
+// segments and completes the transfer sooner than NewReno recovery, which
+// repairs one hole per round trip while the receive window is held.
+TEST_F (TcpSackTest, SackRecoversLossesFasterThanNewReno) {
+  UINT32  SackRounds;
+  UINT32  NewRenoRounds;
+  UINT32  NewRenoRexmitBytes;
+
+  End[1].Sock.RcvBuffer.HighWater = TCP_TEST_RCV_WINDOW;
+  Connect (FALSE, FALSE);
+  NewRenoRounds      = Transfer ();
+  NewRenoRexmitBytes = mRexmitBytes;
+
+  EXPECT_EQ (End[1].Received, (UINT32)TCP_TEST_TRANSFER_SIZE);
+  EXPECT_FALSE (End[1].Corrupted);
+  EXPECT_LT (NewRenoRounds, (UINT32)TCP_TEST_MAX_ROUNDS);
+
+  TearDown ();
+  SetUp ();
+
+  End[1].Sock.RcvBuffer.HighWater = TCP_TEST_RCV_WINDOW;
+  Connect (TRUE, TRUE);
+  SackRounds = Transfer ();
+
+  EXPECT_EQ (End[1].Received, (UINT32)TCP_TEST_TRANSFER_SIZE);
+  EXPECT_FALSE (End[1].Corrupted);
+  EXPECT_EQ (mRexmitBytes, mDroppedBytes);
+  EXPECT_LE (mRexmitBytes, NewRenoRexmitBytes);
+  EXPECT_LT (SackRounds, NewRenoRounds);
+
+  RecordProperty ("NewRenoRounds", NewRenoRounds);
+  RecordProperty ("SackRounds", SackRounds);
+}
@@ -118,7 +118,7 @@ Tcp4GetMode (
       Option->EnableTimeStamp     = (BOOLEAN)(!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_TS));
       Option->EnableWindowScaling = (BOOLEAN)(!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_WS));
 
-      Option->EnableSelectiveAck     = FALSE;
+      Option->EnableSelectiveAck     = (BOOLEAN)(!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_SACK));  // MU_CHANGE - Add RFC2018 selective acknowledgment
       Option->EnablePathMtuDiscovery = FALSE;
     }
   }
@@ -195,7 +195,7 @@ Tcp6GetMode (
       Option->EnableTimeStamp     = (BOOLEAN)(!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_TS));
       Option->EnableWindowScaling = (BOOLEAN)(!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_WS));
 
-      Option->EnableSelectiveAck     = FALSE;
+      Option->EnableSelectiveAck     = (BOOLEAN)(!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_SACK));  // MU_CHANGE - Add RFC2018 selective acknowledgment
       Option->EnablePathMtuDiscovery = FALSE;
     }
   }
@@ -606,16 +606,18 @@ TcpConfigurePcb (
   }
 
   if (Option != NULL) {
+    // MU_CHANGE [BEGIN] - Configurable receive buffer
     SET_RCV_BUFFSIZE (
       Sk,
       (UINT32)(TCP_COMP_VAL (
                  TCP_RCV_BUF_SIZE_MIN,
-                 TCP_RCV_BUF_SIZE,
-                 TCP_RCV_BUF_SIZE,
+                 TCP_RCV_BUF_SIZE_MAX,
+                 TCP_RCV_BUF_SIZE_DEFAULT,
                  Option->ReceiveBufferSize
                  )
                )
       );
+    // MU_CHANGE [END] - Configurable receive buffer
     SET_SND_BUFFSIZE (
       Sk,
       (UINT32)(TCP_COMP_VAL (
@@ -703,6 +705,13 @@ TcpConfigurePcb (
     if (!Option->EnableWindowScaling) {
       TCP_SET_FLG (Tcb->CtrlFlag, TCP_CTRL_NO_WS);
     }
+
+    // MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+    if (!Option->EnableSelectiveAck) {
+      TCP_SET_FLG (Tcb->CtrlFlag, TCP_CTRL_NO_SACK);
+    }
+
+    // MU_CHANGE [END] - Add RFC2018 selective acknowledgment
   }
 
   //
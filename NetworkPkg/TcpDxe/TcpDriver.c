@@ -890,6 +890,7 @@ TcpServiceBindingCreateChild (
   mTcpDefaultSockData.DataSize      = sizeof (TCP_PROTO_DATA);
   mTcpDefaultSockData.DriverBinding = TcpServiceData->DriverBindingHandle;
   mTcpDefaultSockData.IpVersion     = TcpServiceData->IpVersion;
+  mTcpDefaultSockData.RcvBufferSize = TCP_RCV_BUF_SIZE_DEFAULT;     // MU_CHANGE - Configurable receive buffer
 
   if (TcpServiceData->IpVersion == IP_VERSION_4) {
     mTcpDefaultSockData.Protocol = &gTcp4ProtocolTemplate;
@@ -359,6 +359,26 @@ TcpRetransmit (
   IN TCP_SEQNO  Seq
   );
 
+// MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+
+/**
+  Retransmit the next range of the retransmission queue that the peer reported
+  missing, as specified in RFC6675.
+
+  @param[in, out]  Tcb     Pointer to the TCP_CB of this TCP instance.
+
+  @retval 1       A missing range was retransmitted.
+  @retval 0       No range is known to be missing.
+  @retval -1      An error condition occurred.
+
+**/
+INTN
+TcpSackRetransmit (
+  IN OUT TCP_CB  *Tcb
+  );
+
+// MU_CHANGE [END] - Add RFC2018 selective acknowledgment
+
 /**
   Check whether to send data/SYN/FIN and piggyback an ACK.
 
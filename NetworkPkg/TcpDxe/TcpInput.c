@@ -63,6 +63,7 @@ TcpFastRecover (
     //
     // Step 2: Entering fast retransmission
     //
+    Tcb->SackRexmit = Tcb->SndUna;    // MU_CHANGE - Add RFC2018 selective acknowledgment
     TcpRetransmit (Tcb, Tcb->SndUna);
     Tcb->CWnd = Tcb->Ssthresh + 3 * Tcb->SndMss;
 
@@ -87,6 +88,17 @@ TcpFastRecover (
     // Step 4 is skipped here only to be executed later
     // by TcpToSendData
     //
+
+    // MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+    //
+    // If the peer has reported a missing range, retransmit it
+    // in place of the segment that has left the network.
+    //
+    if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK) && (TcpSackRetransmit (Tcb) == 1)) {
+      return;
+    }
+
+    // MU_CHANGE [END] - Add RFC2018 selective acknowledgment
     Tcb->CWnd += Tcb->SndMss;
     DEBUG (
       (DEBUG_NET,
@@ -121,7 +133,18 @@ TcpFastRecover (
       // fast retransmit the first unacknowledge field
       // , then deflate the CWnd
       //
-      TcpRetransmit (Tcb, Seg->Ack);
+      // MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+      if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK) && TCP_SEQ_LT (Seg->Ack, Tcb->SackRexmit)) {
+        //
+        // The first unacknowledged range has been retransmitted
+        // already, go on with the next missing range.
+        //
+        TcpSackRetransmit (Tcb);
+      } else {
+        TcpRetransmit (Tcb, Seg->Ack);
+      }
+
+      // MU_CHANGE [END] - Add RFC2018 selective acknowledgment
       Acked = TCP_SUB_SEQ (Seg->Ack, Tcb->SndUna);
 
       //
@@ -192,6 +215,116 @@ TcpFastLossRecover (
   }
 }
 
+// MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+
+/**
+  Update the ranges selectively acknowledged by the peer, as specified in RFC2018.
+
+  The ranges below the acknowledgment number are dropped, and the valid SACK
+  blocks of the segment are merged in. When the scoreboard is full, the
+  highest ranges are forgotten, they will be reported again by the peer.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Ack      The acknowledgment number of the segment.
+  @param[in]       Option   Pointer to the options of the segment.
+
+**/
+VOID
+TcpSackUpdate (
+  IN OUT TCP_CB      *Tcb,
+  IN     TCP_SEQNO   Ack,
+  IN     TCP_OPTION  *Option
+  )
+{
+  TCP_SACK_BLOCK  Merged[TCP_SACK_SCOREBOARD_SIZE + 1];
+  TCP_SACK_BLOCK  Block;
+  TCP_SEQNO       MaxSndNxt;
+  UINTN           Count;
+  UINTN           Index;
+  UINTN           Opt;
+  BOOLEAN         Inserted;
+
+  //
+  // Drop the ranges acknowledged cumulatively.
+  //
+  Count = 0;
+  for (Index = 0; Index < Tcb->SackCount; Index++) {
+    Block = Tcb->SackBlock[Index];
+    if (TCP_SEQ_LEQ (Block.Right, Ack)) {
+      continue;
+    }
+
+    if (TCP_SEQ_LT (Block.Left, Ack)) {
+      Block.Left = Ack;
+    }
+
+    Tcb->SackBlock[Count++] = Block;
+  }
+
+  Tcb->SackCount = (UINT8)Count;
+
+  if (!TCP_FLG_ON (Option->Flag, TCP_OPTION_RCVD_SACK)) {
+    return;
+  }
+
+  MaxSndNxt = TcpGetMaxSndNxt (Tcb);
+
+  for (Opt = 0; Opt < Option->SackCount; Opt++) {
+    Block = Option->Sack[Opt];
+
+    //
+    // Ignore the blocks that are already acknowledged, such as
+    // D-SACK blocks, or that cover data never sent.
+    //
+    if (!TCP_SEQ_LT (Block.Left, Block.Right) ||
+        TCP_SEQ_LEQ (Block.Right, Ack) ||
+        TCP_SEQ_GT (Block.Right, MaxSndNxt))
+    {
+      continue;
+    }
+
+    if (TCP_SEQ_LT (Block.Left, Ack)) {
+      Block.Left = Ack;
+    }
+
+    //
+    // Insert the block in order, merging the ranges it overlaps or touches.
+    //
+    Count    = 0;
+    Inserted = FALSE;
+    for (Index = 0; Index < Tcb->SackCount; Index++) {
+      if (TCP_SEQ_LT (Tcb->SackBlock[Index].Right, Block.Left)) {
+        Merged[Count++] = Tcb->SackBlock[Index];
+      } else if (TCP_SEQ_GT (Tcb->SackBlock[Index].Left, Block.Right)) {
+        if (!Inserted) {
+          Merged[Count++] = Block;
+          Inserted        = TRUE;
+        }
+
+        Merged[Count++] = Tcb->SackBlock[Index];
+      } else {
+        if (TCP_SEQ_LT (Tcb->SackBlock[Index].Left, Block.Left)) {
+          Block.Left = Tcb->SackBlock[Index].Left;
+        }
+
+        if (TCP_SEQ_GT (Tcb->SackBlock[Index].Right, Block.Right)) {
+          Block.Right = Tcb->SackBlock[Index].Right;
+        }
+      }
+    }
+
+    if (!Inserted) {
+      Merged[Count++] = Block;
+    }
+
+    Count = MIN (Count, TCP_SACK_SCOREBOARD_SIZE);
+    CopyMem (Tcb->SackBlock, Merged, Count * sizeof (TCP_SACK_BLOCK));
+    Tcb->SackCount = (UINT8)Count;
+  }
+}
+
+// MU_CHANGE [END] - Add RFC2018 selective acknowledgment
+
 /**
   Compute the RTT as specified in RFC2988.
 
@@ -1214,6 +1347,13 @@ TcpInput (
     TcpSetTimer (Tcb, TCP_TIMER_REXMIT, Tcb->Rto);
   }
 
+  // MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK)) {
+    TcpSackUpdate (Tcb, Seg->Ack, &Option);
+  }
+
+  // MU_CHANGE [END] - Add RFC2018 selective acknowledgment
+
   //
   // Count duplicate acks.
   //
@@ -1478,6 +1618,17 @@ StepSix:
       goto RESET_THEN_DROP;
     }
 
+    // MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+    //
+    // Remember the out-of-order segment, it is reported
+    // first in the SACK option.
+    //
+    if (TCP_SEQ_GT (Seg->Seq, Tcb->RcvNxt)) {
+      Tcb->SackRecent = Seg->Seq;
+    }
+
+    // MU_CHANGE [END] - Add RFC2018 selective acknowledgment
+
     if (TcpQueueData (Tcb, Nbuf) == 0) {
       DEBUG (
         (DEBUG_ERROR,
@@ -163,7 +163,7 @@ Tcp4Configure (
     }
 
     Option = TcpConfigData->ControlOption;
-    if ((NULL != Option) && (Option->EnableSelectiveAck || Option->EnablePathMtuDiscovery)) {
+    if ((NULL != Option) && Option->EnablePathMtuDiscovery) {   // MU_CHANGE - Add RFC2018 selective acknowledgment
       return EFI_UNSUPPORTED;
     }
   }
@@ -698,7 +698,7 @@ Tcp6Configure (
     }
 
     Option = Tcp6ConfigData->ControlOption;
-    if ((NULL != Option) && (Option->EnableSelectiveAck || Option->EnablePathMtuDiscovery)) {
+    if ((NULL != Option) && Option->EnablePathMtuDiscovery) {   // MU_CHANGE - Add RFC2018 selective acknowledgment
       return EFI_UNSUPPORTED;
     }
   }
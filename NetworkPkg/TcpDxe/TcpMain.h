@@ -16,6 +16,7 @@
 #include <Library/IpIoLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/PrintLib.h>
+#include <Library/PcdLib.h>         // MU_CHANGE - Configurable receive buffer
 
 #include "Socket.h"
 #include "TcpProto.h"
@@ -81,6 +81,9 @@ TcpInitTcbLocal (
   Tcb->RcvWndScale   = 0;
   Tcb->RetxmitSeqMax = 0;
 
+  Tcb->SackCount  = 0;          // MU_CHANGE - Add RFC2018 selective acknowledgment
+  Tcb->SackRexmit = Tcb->Iss;   // MU_CHANGE - Add RFC2018 selective acknowledgment
+
   Tcb->ProbeTimerOn = FALSE;
 }
 
@@ -160,6 +163,14 @@ TcpInitTcbPeer (
     //
     Tcb->SndMss -= TCP_OPTION_TS_ALIGNED_LEN;
   }
+
+  // MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+  if (TCP_FLG_ON (Opt->Flag, TCP_OPTION_RCVD_SACK_PERM) && !TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_SACK)) {
+    TCP_SET_FLG (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK);
+  }
+
+  Tcb->SackRecent = Tcb->RcvNxt;
+  // MU_CHANGE [END] - Add RFC2018 selective acknowledgment
 }
 
 /**
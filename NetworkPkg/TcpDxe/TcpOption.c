@@ -172,6 +172,34 @@ TcpSynBuildOption (
     TcpPutUint32 (Data, TCP_OPTION_WS_FAST | TcpComputeScale (Tcb));
   }
 
+  // MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+  //
+  // Build the SACK permitted option, only when configured
+  // to use SACK, and either we are doing active open or we
+  // have received SACK permitted option from peer.
+  //
+  if (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_SACK) &&
+      (!TCP_FLG_ON (TCPSEG_NETBUF (Nbuf)->Flag, TCP_FLG_ACK) ||
+       TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK))
+      )
+  {
+    Data = NetbufAllocSpace (
+             Nbuf,
+             TCP_OPTION_SACK_PERM_ALIGNED_LEN,
+             NET_BUF_HEAD
+             );
+
+    if (Data == NULL) {
+      ASSERT (Data != NULL);
+      return 0;
+    }
+
+    Len += TCP_OPTION_SACK_PERM_ALIGNED_LEN;
+    TcpPutUint32 (Data, TCP_OPTION_SACK_PERM_FAST);
+  }
+
+  // MU_CHANGE [END] - Add RFC2018 selective acknowledgment
+
   //
   // Build the MSS option.
   //
@@ -190,6 +218,109 @@ TcpSynBuildOption (
   return Len;
 }
 
+// MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+
+/**
+  Collect the blocks of out-of-order data held in the reassemble queue.
+
+  As RFC2018 requires, the first block contains the segment received most
+  recently. The other blocks follow from the highest sequence down.
+
+  @param[in]   Tcb       Pointer to the TCP_CB of this TCP instance.
+  @param[out]  Blocks    Pointer to the array to store the blocks.
+  @param[in]   MaxCount  The number of entries of Blocks.
+
+  @return The number of blocks stored in Blocks.
+
+**/
+UINTN
+TcpSackGetBlocks (
+  IN  TCP_CB          *Tcb,
+  OUT TCP_SACK_BLOCK  *Blocks,
+  IN  UINTN           MaxCount
+  )
+{
+  LIST_ENTRY      *Entry;
+  TCP_SEG         *Seg;
+  TCP_SACK_BLOCK  Run;
+  TCP_SACK_BLOCK  Recent;
+  TCP_SACK_BLOCK  Others[TCP_OPTION_SACK_MAX_BLOCKS];
+  UINTN           OtherCount;
+  BOOLEAN         HasRecent;
+  UINTN           Index;
+
+  ASSERT (MaxCount <= TCP_OPTION_SACK_MAX_BLOCKS);
+
+  if ((MaxCount == 0) || IsListEmpty (&Tcb->RcvQue)) {
+    return 0;
+  }
+
+  HasRecent  = FALSE;
+  OtherCount = 0;
+  Run.Left   = 0;
+  Run.Right  = 0;
+  Recent     = Run;
+
+  //
+  // The queue is sorted and its segments don't overlap, merge the
+  // adjacent ones into runs. A sentinel pass flushes the last run.
+  //
+  Entry = Tcb->RcvQue.ForwardLink;
+  do {
+    Seg = NULL;
+    if (Entry != &Tcb->RcvQue) {
+      Seg = TCPSEG_NETBUF (NET_LIST_USER_STRUCT (Entry, NET_BUF, List));
+      if ((Run.Left != Run.Right) && (Seg->Seq == Run.Right)) {
+        Run.Right = Seg->End;
+        Entry     = Entry->ForwardLink;
+        continue;
+      }
+    }
+
+    if ((Run.Left != Run.Right) && TCP_SEQ_GT (Run.Right, Tcb->RcvNxt)) {
+      if (TCP_SEQ_LT (Run.Left, Tcb->RcvNxt)) {
+        Run.Left = Tcb->RcvNxt;
+      }
+
+      if (!HasRecent && TCP_SEQ_BETWEEN (Run.Left, Tcb->SackRecent, Run.Right - 1)) {
+        Recent    = Run;
+        HasRecent = TRUE;
+      } else {
+        //
+        // Keep the highest runs only.
+        //
+        if (OtherCount == MaxCount) {
+          CopyMem (&Others[0], &Others[1], (OtherCount - 1) * sizeof (TCP_SACK_BLOCK));
+          OtherCount--;
+        }
+
+        Others[OtherCount++] = Run;
+      }
+    }
+
+    if (Seg == NULL) {
+      break;
+    }
+
+    Run.Left  = Seg->Seq;
+    Run.Right = Seg->End;
+    Entry     = Entry->ForwardLink;
+  } while (TRUE);
+
+  Index = 0;
+  if (HasRecent) {
+    Blocks[Index++] = Recent;
+  }
+
+  while ((Index < MaxCount) && (OtherCount > 0)) {
+    Blocks[Index++] = Others[--OtherCount];
+  }
+
+  return Index;
+}
+
+// MU_CHANGE [END] - Add RFC2018 selective acknowledgment
+
 /**
   Build the TCP option in synchronized states.
 
@@ -205,11 +336,17 @@ TcpBuildOption (
   IN NET_BUF  *Nbuf
   )
 {
-  UINT8   *Data;
-  UINT16  Len;
+  UINT8           *Data;
+  UINT16          Len;
+  TCP_SACK_BLOCK  Blocks[TCP_OPTION_SACK_MAX_BLOCKS];           // MU_CHANGE - Add RFC2018 selective acknowledgment
+  UINTN           Count;                                        // MU_CHANGE - Add RFC2018 selective acknowledgment
+  UINTN           Room;                                         // MU_CHANGE - Add RFC2018 selective acknowledgment
+  UINTN           Index;                                        // MU_CHANGE - Add RFC2018 selective acknowledgment
+  UINT32          DataLen;                                      // MU_CHANGE - Add RFC2018 selective acknowledgment
 
   ASSERT ((Tcb != NULL) && (Nbuf != NULL) && (Nbuf->Tcp == NULL));
-  Len = 0;
+  Len     = 0;
+  DataLen = Nbuf->TotalSize;                                    // MU_CHANGE - Add RFC2018 selective acknowledgment
 
   //
   // Build the Timestamp option.
@@ -238,6 +375,55 @@ TcpBuildOption (
     TcpPutUint32 (Data + 8, Tcb->TsRecent);
   }
 
+  // MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+  //
+  // Build the SACK option if the peer permits it and there is
+  // out-of-order data. The option has to fit in the option space
+  // left, and in the MSS together with the data of the segment.
+  //
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK) &&
+      !TCP_FLG_ON (TCPSEG_NETBUF (Nbuf)->Flag, TCP_FLG_RST) &&
+      !IsListEmpty (&Tcb->RcvQue)
+      )
+  {
+    Room = TCP_OPTION_MAX_LEN - Len;
+    if (DataLen != 0) {
+      Room = (Tcb->SndMss > DataLen) ? MIN (Room, Tcb->SndMss - DataLen) : 0;
+    }
+
+    Count = 0;
+    if (Room >= 4 + TCP_OPTION_SACK_BLOCK_LEN) {
+      Count = TcpSackGetBlocks (
+                Tcb,
+                Blocks,
+                MIN ((Room - 4) / TCP_OPTION_SACK_BLOCK_LEN, TCP_OPTION_SACK_MAX_BLOCKS)
+                );
+    }
+
+    if (Count != 0) {
+      Data = NetbufAllocSpace (
+               Nbuf,
+               (UINT32)(4 + Count * TCP_OPTION_SACK_BLOCK_LEN),
+               NET_BUF_HEAD
+               );
+
+      if (Data == NULL) {
+        ASSERT (Data != NULL);
+        return Len;
+      }
+
+      Len = (UINT16)(Len + 4 + Count * TCP_OPTION_SACK_BLOCK_LEN);
+
+      TcpPutUint32 (Data, TCP_OPTION_SACK_FAST | (UINT32)(2 + Count * TCP_OPTION_SACK_BLOCK_LEN));
+      for (Index = 0; Index < Count; Index++) {
+        TcpPutUint32 (Data + 4 + Index * TCP_OPTION_SACK_BLOCK_LEN, Blocks[Index].Left);
+        TcpPutUint32 (Data + 8 + Index * TCP_OPTION_SACK_BLOCK_LEN, Blocks[Index].Right);
+      }
+    }
+  }
+
+  // MU_CHANGE [END] - Add RFC2018 selective acknowledgment
+
   return Len;
 }
 
@@ -263,6 +449,7 @@ TcpParseOption (
   UINT8  Cur;
   UINT8  Type;
   UINT8  Len;
+  UINT8  Index;                 // MU_CHANGE - Add RFC2018 selective acknowledgment
 
   ASSERT ((Tcp != NULL) && (Option != NULL));
 
@@ -335,6 +522,41 @@ TcpParseOption (
         Cur += TCP_OPTION_TS_LEN;
         break;
 
+      // MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+      case TCP_OPTION_SACK_PERM:
+        Len = Head[Cur + 1];
+
+        if ((Len != TCP_OPTION_SACK_PERM_LEN) || (TotalLen - Cur < TCP_OPTION_SACK_PERM_LEN)) {
+          return -1;
+        }
+
+        TCP_SET_FLG (Option->Flag, TCP_OPTION_RCVD_SACK_PERM);
+
+        Cur += TCP_OPTION_SACK_PERM_LEN;
+        break;
+
+      case TCP_OPTION_SACK:
+        Len = Head[Cur + 1];
+
+        if ((Len < 2 + TCP_OPTION_SACK_BLOCK_LEN) ||
+            ((Len - 2) % TCP_OPTION_SACK_BLOCK_LEN != 0) ||
+            (TotalLen - Cur < Len))
+        {
+          return -1;
+        }
+
+        Option->SackCount = (UINT8)MIN ((Len - 2) / TCP_OPTION_SACK_BLOCK_LEN, TCP_OPTION_SACK_MAX_BLOCKS);
+        for (Index = 0; Index < Option->SackCount; Index++) {
+          Option->Sack[Index].Left  = TcpGetUint32 (&Head[Cur + 2 + Index * TCP_OPTION_SACK_BLOCK_LEN]);
+          Option->Sack[Index].Right = TcpGetUint32 (&Head[Cur + 6 + Index * TCP_OPTION_SACK_BLOCK_LEN]);
+        }
+
+        TCP_SET_FLG (Option->Flag, TCP_OPTION_RCVD_SACK);
+
+        Cur = (UINT8)(Cur + Len);
+        break;
+
+      // MU_CHANGE [END] - Add RFC2018 selective acknowledgment
       case TCP_OPTION_NOP:
         Cur++;
         break;
@@ -17,12 +17,23 @@
 #define TCP_OPTION_NOP             1  ///< No-Option.
 #define TCP_OPTION_MSS             2  ///< Maximum Segment Size
 #define TCP_OPTION_WS              3  ///< Window scale
+// MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+#define TCP_OPTION_SACK_PERM       4  ///< SACK permitted
+#define TCP_OPTION_SACK            5  ///< Selective acknowledgment
+// MU_CHANGE [END] - Add RFC2018 selective acknowledgment
 #define TCP_OPTION_TS              8  ///< Timestamp
 #define TCP_OPTION_MSS_LEN         4  ///< Length of MSS option
 #define TCP_OPTION_WS_LEN          3  ///< Length of window scale option
 #define TCP_OPTION_TS_LEN          10 ///< Length of timestamp option
 #define TCP_OPTION_WS_ALIGNED_LEN  4  ///< Length of window scale option, aligned
 #define TCP_OPTION_TS_ALIGNED_LEN  12 ///< Length of timestamp option, aligned
+// MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+#define TCP_OPTION_SACK_PERM_LEN          2  ///< Length of SACK permitted option
+#define TCP_OPTION_SACK_PERM_ALIGNED_LEN  4  ///< Length of SACK permitted option, aligned
+#define TCP_OPTION_SACK_BLOCK_LEN         8  ///< Length of each block of SACK option
+#define TCP_OPTION_SACK_MAX_BLOCKS        4  ///< Maximum blocks of SACK option
+#define TCP_OPTION_MAX_LEN                40 ///< Maximum length of the option field
+// MU_CHANGE [END] - Add RFC2018 selective acknowledgment
 
 //
 // recommend format of timestamp window scale
@@ -39,12 +50,31 @@
 
 #define TCP_OPTION_MSS_FAST  ((TCP_OPTION_MSS << 24) | (TCP_OPTION_MSS_LEN << 16))
 
+// MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+#define TCP_OPTION_SACK_PERM_FAST  ((TCP_OPTION_NOP << 24) |       \
+                                    (TCP_OPTION_NOP << 16) |       \
+                                    (TCP_OPTION_SACK_PERM << 8) |  \
+                                    (TCP_OPTION_SACK_PERM_LEN))
+
+//
+// The SACK option is preceded by two NOPs to align the blocks, its length
+// is to be added.
+//
+#define TCP_OPTION_SACK_FAST  ((TCP_OPTION_NOP << 24) |  \
+                               (TCP_OPTION_NOP << 16) |  \
+                               (TCP_OPTION_SACK << 8))
+// MU_CHANGE [END] - Add RFC2018 selective acknowledgment
+
 //
 // Other misc definitions
 //
 #define TCP_OPTION_RCVD_MSS  0x01
 #define TCP_OPTION_RCVD_WS   0x02
 #define TCP_OPTION_RCVD_TS   0x04
+// MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+#define TCP_OPTION_RCVD_SACK_PERM  0x08
+#define TCP_OPTION_RCVD_SACK       0x10
+// MU_CHANGE [END] - Add RFC2018 selective acknowledgment
 #define TCP_OPTION_MAX_WS    14            ///< Maximum window scale value
 #define TCP_OPTION_MAX_WIN   0xffff        ///< Max window size in TCP header
 
@@ -58,6 +88,10 @@ typedef struct _TCP_OPTION {
   UINT16    Mss;      ///< The Mss received
   UINT32    TSVal;    ///< The TSVal field in a timestamp option
   UINT32    TSEcr;    ///< The TSEcr field in a timestamp option
+  // MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+  UINT8             SackCount;                             ///< The number of SACK blocks received
+  TCP_SACK_BLOCK    Sack[TCP_OPTION_SACK_MAX_BLOCKS];      ///< The SACK blocks received
+  // MU_CHANGE [END] - Add RFC2018 selective acknowledgment
 } TCP_OPTION;
 
 /**
@@ -88,6 +122,30 @@ TcpSynBuildOption (
   IN NET_BUF  *Nbuf
   );
 
+// MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+
+/**
+  Collect the blocks of out-of-order data held in the reassemble queue.
+
+  As RFC2018 requires, the first block contains the segment received most
+  recently. The other blocks follow from the highest sequence down.
+
+  @param[in]   Tcb       Pointer to the TCP_CB of this TCP instance.
+  @param[out]  Blocks    Pointer to the array to store the blocks.
+  @param[in]   MaxCount  The number of entries of Blocks.
+
+  @return The number of blocks stored in Blocks.
+
+**/
+UINTN
+TcpSackGetBlocks (
+  IN  TCP_CB          *Tcb,
+  OUT TCP_SACK_BLOCK  *Blocks,
+  IN  UINTN           MaxCount
+  );
+
+// MU_CHANGE [END] - Add RFC2018 selective acknowledgment
+
 /**
   Build the TCP option in synchronized states.
 
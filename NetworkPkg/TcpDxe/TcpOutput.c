@@ -656,8 +656,10 @@ TcpRetransmit (
   IN TCP_SEQNO  Seq
   )
 {
-  NET_BUF  *Nbuf;
-  UINT32   Len;
+  NET_BUF    *Nbuf;
+  UINT32     Len;
+  UINT8      Index;   // MU_CHANGE - Add RFC2018 selective acknowledgment
+  TCP_SEQNO  End;     // MU_CHANGE - Add RFC2018 selective acknowledgment
 
   //
   // Compute the maximum length of retransmission. It is
@@ -697,6 +699,19 @@ TcpRetransmit (
 
   Len = MIN (Len, Tcb->SndMss);
 
+  // MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+  //
+  // Don't resend the data the peer has selectively acknowledged.
+  //
+  for (Index = 0; Index < Tcb->SackCount; Index++) {
+    if (TCP_SEQ_GT (Tcb->SackBlock[Index].Left, Seq)) {
+      Len = MIN (Len, TCP_SUB_SEQ (Tcb->SackBlock[Index].Left, Seq));
+      break;
+    }
+  }
+
+  // MU_CHANGE [END] - Add RFC2018 selective acknowledgment
+
   Nbuf = TcpGetSegmentSndQue (Tcb, Seq, Len);
   if (Nbuf == NULL) {
     return -1;
@@ -706,6 +721,8 @@ TcpRetransmit (
     goto OnError;
   }
 
+  End = TCPSEG_NETBUF (Nbuf)->End;    // MU_CHANGE - Add RFC2018 selective acknowledgment
+
   if (TcpTransmitSegment (Tcb, Nbuf) != 0) {
     goto OnError;
   }
@@ -714,6 +731,13 @@ TcpRetransmit (
     Tcb->RetxmitSeqMax = Seq;
   }
 
+  // MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+  if (TCP_SEQ_GT (End, Tcb->SackRexmit)) {
+    Tcb->SackRexmit = End;
+  }
+
+  // MU_CHANGE [END] - Add RFC2018 selective acknowledgment
+
   //
   // The retransmitted buffer may be on the SndQue,
   // trim TCP head because all the buffers on SndQue
@@ -734,6 +758,58 @@ OnError:
   return -1;
 }
 
+// MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+
+/**
+  Retransmit the next range of the retransmission queue that the peer reported
+  missing, as specified in RFC6675.
+
+  A range is missing when the peer has selectively acknowledged data above it.
+  The ranges are retransmitted in order, starting from the point the current
+  fast recovery has retransmitted to.
+
+  @param[in, out]  Tcb     Pointer to the TCP_CB of this TCP instance.
+
+  @retval 1       A missing range was retransmitted.
+  @retval 0       No range is known to be missing.
+  @retval -1      An error condition occurred.
+
+**/
+INTN
+TcpSackRetransmit (
+  IN OUT TCP_CB  *Tcb
+  )
+{
+  TCP_SEQNO  Seq;
+  UINT8      Index;
+
+  Seq = Tcb->SackRexmit;
+  if (TCP_SEQ_LT (Seq, Tcb->SndUna)) {
+    Seq = Tcb->SndUna;
+  }
+
+  for (Index = 0; Index < Tcb->SackCount; Index++) {
+    if (TCP_SEQ_LT (Seq, Tcb->SackBlock[Index].Left)) {
+      DEBUG (
+        (DEBUG_NET,
+         "TcpSackRetransmit: retransmit the hole at %d for TCB %p\n",
+         Seq,
+         Tcb)
+        );
+
+      return (TcpRetransmit (Tcb, Seq) == 0) ? 1 : -1;
+    }
+
+    if (TCP_SEQ_LT (Seq, Tcb->SackBlock[Index].Right)) {
+      Seq = Tcb->SackBlock[Index].Right;
+    }
+  }
+
+  return 0;
+}
+
+// MU_CHANGE [END] - Add RFC2018 selective acknowledgment
+
 /**
   Verify that all the segments in SndQue are in good shape.
 
@@ -70,6 +70,10 @@
 #define TCP_CTRL_TIMER_ON      0x1000   ///< At least one of the timer is on.
 #define TCP_CTRL_RTT_ON        0x2000   ///< The RTT measurement is on.
 #define TCP_CTRL_ACK_NOW       0x4000   ///< Send the ACK now, don't delay.
+// MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+#define TCP_CTRL_NO_SACK       0x8000   ///< Disable the SACK option.
+#define TCP_CTRL_RCVD_SACK     0x10000  ///< Received a SACK permitted option in syn.
+// MU_CHANGE [END] - Add RFC2018 selective acknowledgment
 
 //
 // Timer related values
@@ -111,6 +115,7 @@
 //
 #define TCP_RCV_BUF_SIZE          (2 * 1024 * 1024)
 #define TCP_RCV_BUF_SIZE_MIN      (8 * 1024)
+#define TCP_RCV_BUF_SIZE_MAX      (64 * 1024 * 1024)    // MU_CHANGE - Configurable receive buffer
 #define TCP_SND_BUF_SIZE          (2 * 1024 * 1024)
 #define TCP_SND_BUF_SIZE_MIN      (8 * 1024)
 #define TCP_BACKLOG               10
@@ -123,6 +128,14 @@
 #define TCP_FIN_WAIT2_TIME_MAX    (4 * TCP_TICK_HZ)
 #define TCP_TIME_WAIT_TIME_MAX    (60 * TCP_TICK_HZ)
 
+// MU_CHANGE [BEGIN] - Configurable receive buffer
+//
+// The receive buffer size used when the configuration doesn't give one.
+//
+#define TCP_RCV_BUF_SIZE_DEFAULT  \
+  ((UINT32)TCP_COMP_VAL (TCP_RCV_BUF_SIZE_MIN, TCP_RCV_BUF_SIZE_MAX, TCP_RCV_BUF_SIZE, PcdGet32 (PcdTcpReceiveBufferSize)))
+// MU_CHANGE [END] - Configurable receive buffer
+
 ///
 /// TCP_CONNECTED: both ends have synchronized their ISN.
 ///
@@ -216,6 +229,22 @@ typedef struct _TCP_SEG {
   UINT32       Wnd;  ///< TCP window size field.
 } TCP_SEG;
 
+// MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+///
+/// A range of sequence space, as carried by the SACK option.
+///
+typedef struct _TCP_SACK_BLOCK {
+  TCP_SEQNO    Left;  ///< The first sequence number of the block.
+  TCP_SEQNO    Right; ///< The sequence number following the last byte of the block.
+} TCP_SACK_BLOCK;
+
+//
+// Number of ranges SACKed by the peer that the sender remembers.
+//
+#define TCP_SACK_SCOREBOARD_SIZE  8
+
+// MU_CHANGE [END] - Add RFC2018 selective acknowledgment
+
 ///
 /// Network endpoint, IP plus Port structure.
 ///
@@ -312,6 +341,16 @@ struct _TCP_CONTROL_BLOCK {
   //
   TCP_SEQNO           RetxmitSeqMax;     ///< Max Seq number in previous retransmission.
 
+  // MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+  //
+  // RFC2018 and RFC6675 variables, about selective acknowledgment.
+  //
+  TCP_SACK_BLOCK      SackBlock[TCP_SACK_SCOREBOARD_SIZE]; ///< Ranges SACKed by the peer, sorted and disjoint.
+  UINT8               SackCount;                           ///< Number of valid entries in SackBlock.
+  TCP_SEQNO           SackRexmit;                          ///< Next sequence to retransmit in fast recovery.
+  TCP_SEQNO           SackRecent;                          ///< Start of the last out-of-order segment received.
+  // MU_CHANGE [END] - Add RFC2018 selective acknowledgment
+
   //
   // configuration parameters, for EFI_TCP4_PROTOCOL specification
   //
@@ -216,6 +216,15 @@ TcpRexmitTimeout (
   }
 
   TcpBackoffRto (Tcb);
+
+  // MU_CHANGE [BEGIN] - Add RFC2018 selective acknowledgment
+  //
+  // The peer may have discarded the data it selectively acknowledged,
+  // forget them as RFC2018 requires after a retransmission timeout.
+  //
+  Tcb->SackCount = 0;
+  // MU_CHANGE [END] - Add RFC2018 selective acknowledgment
+
   TcpRetransmit (Tcb, Tcb->SndUna);
   TcpSetTimer (Tcb, TCP_TIMER_REXMIT, Tcb->Rto);
 
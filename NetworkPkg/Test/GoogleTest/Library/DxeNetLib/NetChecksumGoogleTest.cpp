@@ -0,0 +1,194 @@
+/** @file
+  Tests for the Internet checksum implementations of DxeNetLib.
+
+  Every implementation the CPU supports is compared bit for bit with the
+  16-bit reference implementation, and its throughput is reported.
+
+  Copyright (c) Microsoft Corporation
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <gtest/gtest.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+extern "C" {
+  #include <Uefi.h>
+  #include <Library/BaseLib.h>
+  #include <Library/DebugLib.h>
+  #include <Library/NetLib.h>
+  #include "../../../../Library/DxeNetLib/NetChecksum.h"
+}
+
+////////////////////////////////////////////////////////////////////////
+// Defines
+////////////////////////////////////////////////////////////////////////
+
+#define CHECKSUM_MAX_ALIGNMENT  64
+#define CHECKSUM_MAX_LENGTH     9216
+#define CHECKSUM_RANDOM_RUNS    4000
+#define CHECKSUM_BENCH_TIME_MS  50
+
+typedef struct {
+  const char            *Name;
+  NET_BLOCK_CHECKSUM    Checksum;
+} CHECKSUM_IMPLEMENTATION;
+
+////////////////////////////////////////////////////////////////////////
+// NetChecksum Tests
+////////////////////////////////////////////////////////////////////////
+
+class NetChecksumTest : public ::testing::Test {
+protected:
+  std::vector<CHECKSUM_IMPLEMENTATION> Implementations;
+  std::vector<UINT8> Buffer;
+  std::mt19937 Random;
+
+  virtual void
+  SetUp (
+    )
+  {
+    Implementations.push_back ({ "Checksum64", NetblockChecksum64 });
+ #if defined (MDE_CPU_X64)
+    Implementations.push_back ({ "Sse2", NetblockChecksumSse2 });
+    if (NetChecksumAvx2Supported ()) {
+      Implementations.push_back ({ "Avx2", NetblockChecksumAvx2 });
+    }
+
+ #elif defined (MDE_CPU_AARCH64)
+    Implementations.push_back ({ "Neon", NetblockChecksumNeon });
+ #endif
+    Implementations.push_back ({ "NetblockChecksum", NetblockChecksum });
+
+    Buffer.resize (CHECKSUM_MAX_LENGTH + CHECKSUM_MAX_ALIGNMENT);
+    Random.seed (0x1071);
+    for (auto &Byte : Buffer) {
+      Byte = (UINT8)Random ();
+    }
+  }
+};
+
+// Test Description:
+// Every implementation matches the reference for all the short lengths at
+// every alignment, which covers all the ways a buffer ends inside a block.
+TEST_F (NetChecksumTest, ShortBuffersMatchReference) {
+  UINT32  Offset;
+  UINT32  Len;
+
+  for (auto &Impl : Implementations) {
+    SCOPED_TRACE (Impl.Name);
+    for (Offset = 0; Offset < CHECKSUM_MAX_ALIGNMENT; Offset++) {
+      for (Len = 0; Len <= 4 * NET_CHECKSUM_BLOCK_SIZE; Len++) {
+        ASSERT_EQ (
+          Impl.Checksum (&Buffer[Offset], Len),
+          NetblockChecksum16 (&Buffer[Offset], Len)
+          ) << "Offset " << Offset << " Len " << Len;
+      }
+    }
+  }
+}
+
+// Test Description:
+// Every implementation matches the reference for random lengths up to a
+// jumbo frame at random alignments.
+TEST_F (NetChecksumTest, RandomBuffersMatchReference) {
+  UINT32  Run;
+  UINT32  Offset;
+  UINT32  Len;
+
+  for (Run = 0; Run < CHECKSUM_RANDOM_RUNS; Run++) {
+    Offset = Random () % CHECKSUM_MAX_ALIGNMENT;
+    Len    = Random () % (CHECKSUM_MAX_LENGTH + 1);
+
+    for (auto &Impl : Implementations) {
+      ASSERT_EQ (
+        Impl.Checksum (&Buffer[Offset], Len),
+        NetblockChecksum16 (&Buffer[Offset], Len)
+        ) << Impl.Name << " Offset " << Offset << " Len " << Len;
+    }
+  }
+}
+
+// Test Description:
+// A sum of zero words is zero, and any other sum which is a multiple of
+// 0xffff is 0xffff, in every implementation.
+TEST_F (NetChecksumTest, ZeroAndAllOnesSums) {
+  UINT32  Len;
+
+  for (auto &Impl : Implementations) {
+    SCOPED_TRACE (Impl.Name);
+
+    std::fill (Buffer.begin (), Buffer.end (), 0);
+    for (Len = 0; Len <= CHECKSUM_MAX_LENGTH; Len += 509) {
+      EXPECT_EQ (Impl.Checksum (&Buffer[1], Len), 0);
+    }
+
+    std::fill (Buffer.begin (), Buffer.end (), 0xff);
+    for (Len = 2; Len <= CHECKSUM_MAX_LENGTH; Len += 510) {
+      EXPECT_EQ (Impl.Checksum (&Buffer[1], Len), 0xffff);
+    }
+
+    Buffer[0] = 0x01;
+    Buffer[1] = 0x00;
+    Buffer[2] = 0xfe;
+    Buffer[3] = 0xff;
+    EXPECT_EQ (Impl.Checksum (&Buffer[0], 4), 0xffff);
+  }
+}
+
+// Test Description:
+// Large buffers of all ones don't overflow the accumulators. The 32-bit
+// accumulator of the reference can't be used past 128KB of such data.
+TEST_F (NetChecksumTest, LargeBufferDoesNotOverflow) {
+  std::vector<UINT8>  Large (16 * 1024 * 1024 + 1, 0xff);
+
+  for (auto &Impl : Implementations) {
+    SCOPED_TRACE (Impl.Name);
+    EXPECT_EQ (Impl.Checksum (Large.data (), (UINT32)Large.size () - 1), 0xffff);
+
+    //
+    // The left-over byte is the low byte of a word.
+    //
+    EXPECT_EQ (Impl.Checksum (Large.data (), (UINT32)Large.size ()), 0x00ff);
+  }
+}
+
+// Test Description:
+// Report the throughput of every implementation for a full sized Ethernet
+// packet and for a 64KB buffer.
+TEST_F (NetChecksumTest, Throughput) {
+  static const UINT32  Sizes[] = { 1500, 65536 };
+  std::vector<UINT8>   Data (65536 + 2);
+  UINT32               Size;
+  UINT64               Bytes;
+  UINT32               Sum;
+  double               Seconds;
+
+  Implementations.push_back ({ "Checksum16", NetblockChecksum16 });
+  for (auto &Byte : Data) {
+    Byte = (UINT8)Random ();
+  }
+
+  for (auto &Impl : Implementations) {
+    for (Size = 0; Size < ARRAY_SIZE (Sizes); Size++) {
+      auto  Start = std::chrono::steady_clock::now ();
+      auto  Now   = Start;
+
+      Bytes = 0;
+      Sum   = 0;
+      do {
+        for (UINT32 Index = 0; Index < 64; Index++) {
+          Sum   += Impl.Checksum (&Data[2], Sizes[Size]);
+          Bytes += Sizes[Size];
+        }
+
+        Now = std::chrono::steady_clock::now ();
+      } while (Now - Start < std::chrono::milliseconds (CHECKSUM_BENCH_TIME_MS));
+
+      Seconds = std::chrono::duration<double>(Now - Start).count ();
+      EXPECT_NE (Sum, 0U);
+      std::printf ("%-18s %6u bytes: %7.2f GB/s\n", Impl.Name, Sizes[Size], Bytes / Seconds / 1e9);
+      RecordProperty (std::string (Impl.Name) + "_" + std::to_string (Sizes[Size]), std::to_string (Bytes / Seconds / 1e9));
+    }
+  }
+}